@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <string_view>
+
+#include "types.h"
+
+namespace Common {
+  /// Powers of ten used to move between decimal strings / doubles and scaled integers.
+  constexpr std::array<int64_t, 19> POW10 = {
+      1LL, 10LL, 100LL, 1'000LL, 10'000LL, 100'000LL, 1'000'000LL, 10'000'000LL, 100'000'000LL, 1'000'000'000LL,
+      10'000'000'000LL, 100'000'000'000LL, 1'000'000'000'000LL, 10'000'000'000'000LL, 100'000'000'000'000LL,
+      1'000'000'000'000'000LL, 10'000'000'000'000'000LL, 100'000'000'000'000'000LL, 1'000'000'000'000'000'000LL};
+
+  /// Integer PnL in price units * qty units of the instrument - exact, never rounded.
+  typedef int64_t PnL;
+
+  /// Parse a plain decimal string ("27123.45000000", "-0.05") into an integer with the specified number of decimals.
+  /// Digits beyond the requested precision are truncated and values beyond the int64 range saturate at its limits.
+  /// Malformed strings - empty, without a digit, or with anything but a leading '-', digits and one '.' (e.g. "1e-5")
+  /// - are rejected as the int64 maximum, which is Price_INVALID. Decimals beyond 18 are taken as 18.
+  /// Never allocates and never goes through a double.
+  inline auto parseDecimal(std::string_view str, uint8_t decimals) noexcept -> int64_t {
+    constexpr auto INVALID = std::numeric_limits<int64_t>::max();
+    const auto is_digit = [](char c) { return static_cast<unsigned>(c - '0') < 10; };
+    decimals = std::min<uint8_t>(decimals, POW10.size() - 1);
+
+    const char *p = str.data(), *end = p + str.size();
+    const bool negative = (p != end && *p == '-');
+    p += negative;
+
+    int64_t value = 0;
+    bool overflow = false;
+    int num_digits = 0;
+    for (; p != end && *p != '.'; ++p, ++num_digits) {
+      if (!is_digit(*p))
+        return INVALID;
+      overflow |= __builtin_mul_overflow(value, 10, &value) | __builtin_add_overflow(value, *p - '0', &value);
+    }
+
+    int digits = 0;
+    if (p != end) {
+      for (++p; p != end; ++p, ++num_digits) {
+        if (!is_digit(*p))
+          return INVALID;
+        if (digits < decimals) {
+          overflow |= __builtin_mul_overflow(value, 10, &value) | __builtin_add_overflow(value, *p - '0', &value);
+          ++digits;
+        }
+      }
+    }
+    if (!num_digits)
+      return INVALID;
+    overflow |= __builtin_mul_overflow(value, POW10[decimals - digits], &value);
+
+    if (overflow)
+      return negative ? std::numeric_limits<int64_t>::min() : INVALID;
+    return negative ? -value : value;
+  }
+
+  /// Number of decimals needed to represent an increment such as "0.00100000" exactly, at most 18 - the most POW10 scales by.
+  inline auto decimalsOf(std::string_view increment) noexcept -> uint8_t {
+    const auto dot = increment.find('.');
+    if (dot == std::string_view::npos)
+      return 0;
+    const auto last = increment.find_last_not_of('0');
+    return static_cast<uint8_t>(std::min<size_t>(last > dot ? last - dot : 0, POW10.size() - 1));
+  }
+
+  /// Number of decimals needed to represent an increment such as 0.05 exactly, up to 8.
+  inline auto decimalsOf(double increment) noexcept -> uint8_t {
+    uint8_t decimals = 0;
+    for (; decimals < 8; ++decimals) {
+      const auto scaled = increment * static_cast<double>(POW10[decimals]);
+      if (std::abs(scaled - std::round(scaled)) < 1e-6)
+        break;
+    }
+    return decimals;
+  }
+
+  /// Fixed-point scales of one instrument. Prices are integers in units of 10^-price_decimals_ of the quote currency and
+  /// quantities integers in units of 10^-qty_decimals_ of the instrument. Conversions only happen at the adapter boundary.
+  struct InstrumentScale {
+    uint8_t price_decimals_ = 2;
+    uint8_t qty_decimals_ = 0;
+
+    /// Minimum price increment and order size increment, in the scaled units above.
+    Price tick_size_ = 1;
+    Qty lot_size_ = 1;
+
+    /// Build the scales from the exchange's tick size and lot size, e.g. 0.05 / 1 for NSE equities.
+    static auto fromIncrements(double tick_size, double lot_size) noexcept {
+      InstrumentScale scale;
+      scale.price_decimals_ = decimalsOf(tick_size);
+      scale.qty_decimals_ = decimalsOf(lot_size);
+      scale.tick_size_ = std::max<Price>(scale.toPrice(tick_size), 1);
+      scale.lot_size_ = std::max<Qty>(scale.toQty(lot_size), 1);
+      return scale;
+    }
+
+    /// Same as above from the exchange's decimal strings, e.g. Binance PRICE_FILTER tickSize / LOT_SIZE stepSize.
+    static auto fromIncrements(std::string_view tick_size, std::string_view lot_size) noexcept {
+      InstrumentScale scale;
+      scale.price_decimals_ = decimalsOf(tick_size);
+      scale.qty_decimals_ = decimalsOf(lot_size);
+      scale.tick_size_ = std::max<Price>(scale.parsePrice(tick_size), 1);
+      scale.lot_size_ = std::max<Qty>(scale.parseQty(lot_size), 1);
+      return scale;
+    }
+
+    auto toPrice(double value) const noexcept -> Price {
+      return std::llround(value * static_cast<double>(POW10[price_decimals_]));
+    }
+
+    /// Here and in parseQty() quantities a Qty cannot hold - negative, or at or beyond Qty_INVALID - come back as
+    /// Qty_INVALID instead of wrapping.
+    auto toQty(double value) const noexcept -> Qty {
+      return checkedQty(std::llround(value * static_cast<double>(POW10[qty_decimals_])));
+    }
+
+    auto parsePrice(std::string_view str) const noexcept -> Price {
+      return parseDecimal(str, price_decimals_);
+    }
+
+    auto parseQty(std::string_view str) const noexcept -> Qty {
+      return checkedQty(parseDecimal(str, qty_decimals_));
+    }
+
+    /// For reporting and for venues which take decimal prices on the wire - not used on the hot path.
+    auto priceToDouble(Price price) const noexcept {
+      return static_cast<double>(price) / static_cast<double>(POW10[price_decimals_]);
+    }
+
+    auto qtyToDouble(Qty qty) const noexcept {
+      return static_cast<double>(qty) / static_cast<double>(POW10[qty_decimals_]);
+    }
+
+    /// Round a price onto the tick grid on the passive side - down for buys, up for sells.
+    auto roundToTick(Price price, Side side) const noexcept -> Price {
+      const auto floor = price - (((price % tick_size_) + tick_size_) % tick_size_);
+      return floor + (side == Side::SELL && floor != price) * tick_size_;
+    }
+
+    /// Round a quantity down to a whole number of lots.
+    auto roundToLot(Qty qty) const noexcept -> Qty {
+      return qty - qty % lot_size_;
+    }
+
+    auto toString() const {
+      return "InstrumentScale[px-dec:" + std::to_string(price_decimals_) + " qty-dec:" + std::to_string(qty_decimals_) +
+             " tick:" + priceToString(tick_size_) + " lot:" + qtyToString(lot_size_) + "]";
+    }
+
+  private:
+    static auto checkedQty(int64_t value) noexcept -> Qty {
+      return (value >= 0 && value < static_cast<int64_t>(Qty_INVALID)) ? static_cast<Qty>(value) : Qty_INVALID;
+    }
+  };
+
+  /// Hash map from TickerId -> InstrumentScale.
+  typedef std::array<InstrumentScale, ME_MAX_TICKERS> InstrumentScaleHashMap;
+}
@@ -0,0 +1,123 @@
+#include "journal.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Common {
+  auto journalDate(Nanos time) noexcept -> uint32_t {
+    const time_t secs = time / NANOS_TO_SECS;
+    tm local = {};
+    localtime_r(&secs, &local);
+    return static_cast<uint32_t>((local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday);
+  }
+
+  JournalWriter::JournalWriter(const std::string &dir, const std::string &prefix, size_t file_size)
+      : dir_(dir), prefix_(prefix), file_size_(file_size) {
+    ASSERT(file_size_ > sizeof(JournalFileHeader), "Journal file size too small:" + std::to_string(file_size_));
+  }
+
+  JournalWriter::~JournalWriter() {
+    close();
+  }
+
+  auto JournalWriter::append(JournalRecordType type, uint16_t stream_id, uint64_t seq, Nanos time, const void *data,
+                             uint32_t length) noexcept -> bool {
+    const auto size = journalRecordSize(length);
+    if (UNLIKELY(size > file_size_ - sizeof(JournalFileHeader)))
+      return false;
+
+    // Records written from the new file callback belong to the file just opened.
+    const auto needs_file = (!base_ || write_offset_ + size > file_size_ || (time >= next_date_start_ && !in_on_new_file_));
+    if (UNLIKELY(needs_file) && (in_on_new_file_ || !open(time)))
+      return false;
+
+    auto record = new(base_ + write_offset_) JournalRecordHeader{length, type, stream_id, seq, time};
+    if (length)
+      std::memcpy(record + 1, data, length);
+    write_offset_ += size;
+
+    std::atomic_ref<uint64_t>(header_->data_size_).store(write_offset_ - sizeof(JournalFileHeader), std::memory_order_release);
+    return true;
+  }
+
+  auto JournalWriter::flush() noexcept -> void {
+    if (base_)
+      msync(base_, write_offset_, MS_ASYNC);
+  }
+
+  auto JournalWriter::close() noexcept -> void {
+    if (base_) {
+      munmap(base_, file_size_);
+      base_ = nullptr;
+      header_ = nullptr;
+    }
+    if (fd_ >= 0) {
+      // Give back the space allocated up front but not used.
+      if (ftruncate(fd_, static_cast<off_t>(write_offset_))) {}
+      ::close(fd_);
+      fd_ = -1;
+    }
+    write_offset_ = 0;
+  }
+
+  auto JournalWriter::open(Nanos time) noexcept -> bool {
+    close();
+
+    const auto date = journalDate(time);
+    if (date != date_) {
+      date_ = date;
+      file_index_ = 0;
+    }
+
+    const time_t secs = time / NANOS_TO_SECS;
+    tm next_date = {};
+    localtime_r(&secs, &next_date);
+    ++next_date.tm_mday;
+    next_date.tm_hour = next_date.tm_min = next_date.tm_sec = 0;
+    next_date.tm_isdst = -1;
+    next_date_start_ = static_cast<Nanos>(mktime(&next_date)) * NANOS_TO_SECS;
+
+    // Never overwrite an earlier file of the same date, e.g. after a restart.
+    do {
+      path_ = dir_ + "/" + prefix_ + "_" + std::to_string(date_) + "_" + std::to_string(file_index_++) + ".jnl";
+      fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    } while (fd_ < 0 && errno == EEXIST);
+    if (fd_ < 0)
+      return false;
+
+    if (posix_fallocate(fd_, 0, static_cast<off_t>(file_size_)) && ftruncate(fd_, static_cast<off_t>(file_size_))) {
+      close();
+      return false;
+    }
+
+    auto base = mmap(nullptr, file_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+      close();
+      return false;
+    }
+    base_ = static_cast<char *>(base);
+    madvise(base_, file_size_, MADV_SEQUENTIAL);
+
+    header_ = new(base_) JournalFileHeader();
+    header_->header_size_ = sizeof(JournalFileHeader);
+    header_->file_size_ = file_size_;
+    header_->created_ = getCurrentNanos();
+    header_->date_ = date_;
+    header_->file_index_ = file_index_ - 1;
+    write_offset_ = sizeof(JournalFileHeader);
+    ++num_files_;
+
+    if (on_new_file_) {
+      in_on_new_file_ = true;
+      on_new_file_();
+      in_on_new_file_ = false;
+    }
+    return true;
+  }
+}
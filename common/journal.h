@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "macros.h"
+#include "time_utils.h"
+
+namespace Common {
+  /// Kind of the payload of a journal record.
+  enum class JournalRecordType : uint16_t {
+    INVALID = 0,
+    /// Name of the stream, written for every stream at the start of every file.
+    STREAM_INFO = 1,
+    /// Records lost on the stream before this one, as a uint64_t - also visible as a jump in the stream's sequence numbers.
+    GAP = 2,
+    /// Raw Kite binary tick frame.
+    ZERODHA_BINARY = 3,
+    /// Raw Kite text (JSON) frame.
+    ZERODHA_TEXT = 4,
+    /// "<symbol>@<stream_type>\n" followed by the raw Binance JSON payload.
+    BINANCE_JSON = 5,
+    /// Exchange::MEMarketUpdate.
+    MARKET_UPDATE = 6,
+    /// Exchange::MEClientRequest.
+    CLIENT_REQUEST = 7,
+    /// Exchange::MEClientResponse.
+    CLIENT_RESPONSE = 8,
+    /// Exchange::MDPMarketUpdate from the incremental multicast stream.
+    MDP_INCREMENTAL = 9,
+    /// Exchange::MDPMarketUpdate from the snapshot multicast stream.
+    MDP_SNAPSHOT = 10
+  };
+
+  inline auto journalRecordTypeToString(JournalRecordType type) -> std::string {
+    switch (type) {
+      case JournalRecordType::STREAM_INFO:
+        return "STREAM_INFO";
+      case JournalRecordType::GAP:
+        return "GAP";
+      case JournalRecordType::ZERODHA_BINARY:
+        return "ZERODHA_BINARY";
+      case JournalRecordType::ZERODHA_TEXT:
+        return "ZERODHA_TEXT";
+      case JournalRecordType::BINANCE_JSON:
+        return "BINANCE_JSON";
+      case JournalRecordType::MARKET_UPDATE:
+        return "MARKET_UPDATE";
+      case JournalRecordType::CLIENT_REQUEST:
+        return "CLIENT_REQUEST";
+      case JournalRecordType::CLIENT_RESPONSE:
+        return "CLIENT_RESPONSE";
+      case JournalRecordType::MDP_INCREMENTAL:
+        return "MDP_INCREMENTAL";
+      case JournalRecordType::MDP_SNAPSHOT:
+        return "MDP_SNAPSHOT";
+      case JournalRecordType::INVALID:
+        return "INVALID";
+    }
+    return "UNKNOWN";
+  }
+
+  /// "SQJRNL01" read as a little endian integer.
+  constexpr uint64_t JOURNAL_MAGIC = 0x31304c4e524a5153;
+  constexpr uint32_t JOURNAL_VERSION = 1;
+
+  /// Records start on multiples of this, so headers and fixed size payloads can be read in place.
+  constexpr size_t JOURNAL_ALIGNMENT = 8;
+
+  constexpr size_t JOURNAL_DEFAULT_FILE_SIZE = 1024 * 1024 * 1024;
+
+  /// First bytes of every journal file.
+  struct JournalFileHeader {
+    uint64_t magic_ = JOURNAL_MAGIC;
+    uint32_t version_ = JOURNAL_VERSION;
+    uint32_t header_size_ = 0;
+    uint64_t file_size_ = 0;
+    Nanos created_ = 0;
+
+    /// Local date (yyyymmdd) the records belong to and the index of the file within that date.
+    uint32_t date_ = 0;
+    uint32_t file_index_ = 0;
+
+    /// Bytes of records after the header, published after every record so readers can follow a file being written.
+    /// Files closed cleanly are also truncated to header_size_ + data_size_.
+    uint64_t data_size_ = 0;
+
+    uint8_t reserved_[16] = {};
+  };
+  static_assert(sizeof(JournalFileHeader) == 64);
+
+  /// Header of every record, followed by length_ bytes of payload and padding up to JOURNAL_ALIGNMENT.
+  struct JournalRecordHeader {
+    uint32_t length_ = 0;
+    JournalRecordType type_ = JournalRecordType::INVALID;
+    uint16_t stream_id_ = 0;
+
+    /// Per stream sequence number starting at 1.
+    uint64_t seq_ = 0;
+
+    /// Receive time of the payload.
+    Nanos time_ = 0;
+  };
+  static_assert(sizeof(JournalRecordHeader) == 24);
+
+  /// Bytes a record with the given payload length occupies.
+  constexpr auto journalRecordSize(size_t length) noexcept -> size_t {
+    return (sizeof(JournalRecordHeader) + length + JOURNAL_ALIGNMENT - 1) & ~(JOURNAL_ALIGNMENT - 1);
+  }
+
+  /// Local date (yyyymmdd) of a time.
+  auto journalDate(Nanos time) noexcept -> uint32_t;
+
+  /// Appends records to memory mapped journal files.
+  /// Files are <dir>/<prefix>_<yyyymmdd>_<index>.jnl, created at file_size bytes and allocated on disk up front so
+  /// appending never extends the file. A new file is started when the date of a record changes or the current file
+  /// is full. Not thread safe - meant to be owned by one recorder thread.
+  class JournalWriter final {
+  public:
+    JournalWriter(const std::string &dir, const std::string &prefix, size_t file_size = JOURNAL_DEFAULT_FILE_SIZE);
+
+    ~JournalWriter();
+
+    /// Called after a new file is opened and before the record which caused it is appended, e.g. to write STREAM_INFO.
+    auto setOnNewFile(std::function<void()> on_new_file) noexcept {
+      on_new_file_ = std::move(on_new_file);
+    }
+
+    /// Append one record, returns false if it could not be written (no file could be opened or it is larger than a file).
+    auto append(JournalRecordType type, uint16_t stream_id, uint64_t seq, Nanos time, const void *data, uint32_t length) noexcept -> bool;
+
+    /// Start writing back dirty pages of the current file, does not wait for it.
+    auto flush() noexcept -> void;
+
+    /// Unmap and truncate the current file, the next append opens a new one.
+    auto close() noexcept -> void;
+
+    auto currentPath() const noexcept -> const std::string & {
+      return path_;
+    }
+
+    auto numFiles() const noexcept {
+      return num_files_;
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    JournalWriter() = delete;
+
+    JournalWriter(const JournalWriter &) = delete;
+
+    JournalWriter(const JournalWriter &&) = delete;
+
+    JournalWriter &operator=(const JournalWriter &) = delete;
+
+    JournalWriter &operator=(const JournalWriter &&) = delete;
+
+  private:
+    auto open(Nanos time) noexcept -> bool;
+
+    const std::string dir_;
+    const std::string prefix_;
+    const size_t file_size_;
+
+    std::string path_;
+    int fd_ = -1;
+    char *base_ = nullptr;
+    JournalFileHeader *header_ = nullptr;
+    size_t write_offset_ = 0;
+
+    /// Date of the current file and the time the next date starts at.
+    uint32_t date_ = 0;
+    uint32_t file_index_ = 0;
+    Nanos next_date_start_ = 0;
+
+    size_t num_files_ = 0;
+    bool in_on_new_file_ = false;
+    std::function<void()> on_new_file_;
+  };
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#include "journal_recorder.h"
+
+struct MyStruct {
+  int d_[3];
+};
+
+using namespace Common;
+
+/// Check every file of the journal in order - records chain up to the data size in the header and every stream
+/// counts up from 1, with a GAP record wherever records were lost. Returns the last sequence number per stream id.
+auto scanJournal(const std::string &dir) {
+  std::vector<std::filesystem::path> paths;
+  for (const auto &entry : std::filesystem::directory_iterator(dir))
+    paths.push_back(entry.path());
+  std::sort(paths.begin(), paths.end(), [](const auto &lhs, const auto &rhs) {
+    const auto index = [](const std::filesystem::path &path) { return std::stoul(path.stem().string().substr(path.stem().string().rfind('_') + 1)); };
+    return index(lhs) < index(rhs);
+  });
+
+  std::map<uint16_t, uint64_t> last_seqs;
+  for (const auto &path : paths) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const auto header = reinterpret_cast<const JournalFileHeader *>(data.data());
+    ASSERT(header->magic_ == JOURNAL_MAGIC, "Not a journal:" + path.string());
+
+    for (size_t offset = header->header_size_; offset < header->header_size_ + header->data_size_;) {
+      const auto record = reinterpret_cast<const JournalRecordHeader *>(data.data() + offset);
+      if (record->type_ == JournalRecordType::GAP) {
+        last_seqs[record->stream_id_] = record->seq_;
+      } else if (record->type_ != JournalRecordType::STREAM_INFO) {
+        ASSERT(record->seq_ == last_seqs[record->stream_id_] + 1 || !last_seqs[record->stream_id_],
+               "Unmarked gap in stream " + std::to_string(record->stream_id_));
+        last_seqs[record->stream_id_] = record->seq_;
+      }
+      offset += journalRecordSize(record->length_);
+    }
+  }
+  return last_seqs;
+}
+
+int main(int, char **) {
+  const auto dir = std::filesystem::temp_directory_path() / ("journal_example_" + std::to_string(getpid()));
+  std::filesystem::create_directories(dir);
+
+  constexpr size_t NUM_ELEMENTS = 1'000'000;
+  Logger logger("journal_example.log");
+  LFQueue<MyStruct> lfq(64 * 1024);
+
+  // Small files so the example also goes through rotation.
+  JournalRecorder recorder(dir, "example", 16 * 1024 * 1024, &logger);
+  auto ring = recorder.addRawStream("raw");
+  recorder.tap("lfq", JournalRecordType::MARKET_UPDATE, &lfq);
+  recorder.start();
+
+  // The reader of the queue keeps up, the recorder sees every element regardless.
+  auto ct = createAndStartThread(-1, "", [&]() {
+    for (size_t i = 0; i < NUM_ELEMENTS;) {
+      if (lfq.getNextToRead()) {
+        lfq.updateReadIndex();
+        ++i;
+      }
+    }
+  });
+
+  const char frame[184] = {};
+  Nanos push_time = 0;
+  for (size_t i = 0; i < NUM_ELEMENTS; ++i) {
+    *(lfq.getNextToWriteTo()) = MyStruct{{static_cast<int>(i), 0, 0}};
+    lfq.updateWriteIndex();
+
+    const auto start = getSystemNanos();
+    ring->push(JournalRecordType::ZERODHA_BINARY, start, frame, sizeof(frame));
+    push_time += getSystemNanos() - start;
+
+    // Roughly the pace of a busy feed, so the recorder is not simply lapped.
+    if (i % 1024 == 0)
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+
+  ct->join();
+  recorder.stop();
+
+  const auto seqs = scanJournal(dir);
+  std::cout << "records:" << recorder.numRecords() << " lost:" << recorder.numLost() << " raw-dropped:" << ring->numDropped()
+            << " raw-push:" << push_time / NUM_ELEMENTS << "ns" << std::endl;
+  for (const auto &[stream_id, last_seq] : seqs)
+    std::cout << "stream:" << stream_id << " records:" << last_seq << std::endl;
+
+  std::filesystem::remove_all(dir);
+  return 0;
+}
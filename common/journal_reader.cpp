@@ -0,0 +1,267 @@
+#include "journal_reader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Common {
+  namespace {
+    /// "SQJIDX02" read as a little endian integer.
+    constexpr uint64_t JOURNAL_INDEX_MAGIC = 0x32305844494a5153;
+
+    /// Start of a <path>.idx file, followed by the time index entries and then the sequence number index entries.
+    /// data_size_ is the data size the file's header published when the index was built, valid_size_ the part of it
+    /// which holds whole records - less if the last record was torn.
+    struct JournalIndexFileHeader {
+      uint64_t magic_ = JOURNAL_INDEX_MAGIC;
+      uint64_t data_size_ = 0;
+      uint64_t valid_size_ = 0;
+      uint64_t num_records_ = 0;
+      Nanos max_time_ = 0;
+      uint64_t num_time_entries_ = 0;
+      uint64_t num_seq_entries_ = 0;
+    };
+
+    auto isDataRecord(JournalRecordType type) noexcept {
+      return type != JournalRecordType::INVALID && type != JournalRecordType::STREAM_INFO && type != JournalRecordType::GAP;
+    }
+  }
+
+  JournalFile::JournalFile(const std::string &path) : path_(path) {
+    const auto fd = ::open(path_.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+
+    struct stat st = {};
+    if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(JournalFileHeader)) {
+      ::close(fd);
+      return;
+    }
+
+    mapped_size_ = static_cast<size_t>(st.st_size);
+    auto base = mmap(nullptr, mapped_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+      return;
+    base_ = static_cast<const char *>(base);
+
+    const auto header = reinterpret_cast<const JournalFileHeader *>(base_);
+    if (header->magic_ != JOURNAL_MAGIC || header->version_ != JOURNAL_VERSION || header->header_size_ > mapped_size_) {
+      munmap(const_cast<char *>(base_), mapped_size_);
+      base_ = nullptr;
+      return;
+    }
+    header_ = header;
+
+    const auto data_size = std::atomic_ref<uint64_t>(const_cast<uint64_t &>(header_->data_size_)).load(std::memory_order_acquire);
+    end_offset_ = std::min<size_t>(header_->header_size_ + data_size, mapped_size_);
+
+    const auto published_size = end_offset_ - header_->header_size_;
+    if (!loadIndex(published_size)) {
+      buildIndex();
+      saveIndex(published_size);
+    }
+  }
+
+  JournalFile::~JournalFile() {
+    if (base_)
+      munmap(const_cast<char *>(base_), mapped_size_);
+  }
+
+  auto JournalFile::seek(Nanos time) const noexcept -> size_t {
+    if (time_index_.empty())
+      return end_offset_;
+
+    // The first entry has nothing before it, so there is always one before the partition point.
+    const auto itr = std::partition_point(time_index_.begin(), time_index_.end(), [time](const JournalTimeIndexEntry &entry) {
+      return entry.max_time_before_ < time;
+    });
+    auto offset = static_cast<size_t>(std::prev(itr)->offset_);
+    while (offset < end_offset_ && recordAt(offset)->time_ < time)
+      offset = nextOffset(offset);
+    return offset;
+  }
+
+  auto JournalFile::seekSeq(uint16_t stream_id, uint64_t seq) const noexcept -> size_t {
+    const auto itr = std::partition_point(seq_index_.begin(), seq_index_.end(), [stream_id, seq](const JournalSeqIndexEntry &entry) {
+      return entry.stream_id_ < stream_id || (entry.stream_id_ == stream_id && entry.seq_ <= seq);
+    });
+
+    size_t offset;
+    if (itr != seq_index_.begin() && std::prev(itr)->stream_id_ == stream_id)
+      offset = std::prev(itr)->offset_;
+    else if (itr != seq_index_.end() && itr->stream_id_ == stream_id)
+      offset = itr->offset_;
+    else
+      return end_offset_;
+
+    for (; offset < end_offset_; offset = nextOffset(offset)) {
+      const auto record = recordAt(offset);
+      if (record->stream_id_ == stream_id && record->seq_ >= seq && isDataRecord(record->type_))
+        break;
+    }
+    return offset;
+  }
+
+  auto JournalFile::streamName(uint16_t stream_id) const noexcept -> std::string {
+    for (auto offset = beginOffset(); offset < end_offset_ && recordAt(offset)->type_ == JournalRecordType::STREAM_INFO;
+         offset = nextOffset(offset)) {
+      const auto record = recordAt(offset);
+      if (record->stream_id_ == stream_id)
+        return std::string(reinterpret_cast<const char *>(record + 1), record->length_);
+    }
+    return {};
+  }
+
+  auto JournalFile::loadIndex(size_t published_size) noexcept -> bool {
+    std::ifstream file(path_ + ".idx", std::ios::binary);
+    JournalIndexFileHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic_ != JOURNAL_INDEX_MAGIC ||
+        header.data_size_ != published_size || header.valid_size_ > published_size)
+      return false;
+
+    time_index_.resize(header.num_time_entries_);
+    seq_index_.resize(header.num_seq_entries_);
+    file.read(reinterpret_cast<char *>(time_index_.data()), static_cast<std::streamsize>(time_index_.size() * sizeof(JournalTimeIndexEntry)));
+    file.read(reinterpret_cast<char *>(seq_index_.data()), static_cast<std::streamsize>(seq_index_.size() * sizeof(JournalSeqIndexEntry)));
+    if (!file) {
+      time_index_.clear();
+      seq_index_.clear();
+      return false;
+    }
+
+    num_records_ = header.num_records_;
+    max_time_ = header.max_time_;
+    end_offset_ = header_->header_size_ + header.valid_size_;
+    return true;
+  }
+
+  auto JournalFile::buildIndex() noexcept -> void {
+    std::unordered_map<uint16_t, size_t> stream_counts;
+    auto max_time = std::numeric_limits<Nanos>::min();
+
+    for (auto offset = beginOffset(); offset < end_offset_;) {
+      // A record cut short, e.g. by a crash while it was written, ends the file.
+      if (offset + sizeof(JournalRecordHeader) > end_offset_ || offset + journalRecordSize(recordAt(offset)->length_) > end_offset_) {
+        end_offset_ = offset;
+        break;
+      }
+      const auto record = recordAt(offset);
+      const auto size = journalRecordSize(record->length_);
+
+      if (num_records_ % JOURNAL_INDEX_INTERVAL == 0)
+        time_index_.push_back({offset, max_time});
+      if (isDataRecord(record->type_) && stream_counts[record->stream_id_]++ % JOURNAL_INDEX_INTERVAL == 0)
+        seq_index_.push_back({record->stream_id_, record->seq_, offset});
+
+      max_time = std::max(max_time, record->time_);
+      ++num_records_;
+      offset += size;
+    }
+
+    std::sort(seq_index_.begin(), seq_index_.end(), [](const JournalSeqIndexEntry &lhs, const JournalSeqIndexEntry &rhs) {
+      return lhs.stream_id_ != rhs.stream_id_ ? lhs.stream_id_ < rhs.stream_id_ : lhs.seq_ < rhs.seq_;
+    });
+    max_time_ = (num_records_ ? max_time : 0);
+  }
+
+  auto JournalFile::saveIndex(size_t published_size) const noexcept -> void {
+    // Best effort, e.g. the journal directory can be read only. A torn file is indexed up to its last whole record and
+    // keyed by the size it published, so the next open loads the index instead of rebuilding it.
+    std::ofstream file(path_ + ".idx", std::ios::binary | std::ios::trunc);
+    const JournalIndexFileHeader header{JOURNAL_INDEX_MAGIC, published_size, end_offset_ - header_->header_size_, num_records_, max_time_,
+                                        time_index_.size(), seq_index_.size()};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(time_index_.data()), static_cast<std::streamsize>(time_index_.size() * sizeof(JournalTimeIndexEntry)));
+    file.write(reinterpret_cast<const char *>(seq_index_.data()), static_cast<std::streamsize>(seq_index_.size() * sizeof(JournalSeqIndexEntry)));
+  }
+
+  JournalReader::JournalReader(const std::string &dir, const std::string &prefix) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(dir, error)) {
+      const auto file_name = entry.path().filename().string();
+      if (entry.path().extension() == ".jnl" && (prefix.empty() || file_name.rfind(prefix + "_", 0) == 0))
+        paths.push_back(entry.path().string());
+    }
+    open(paths);
+  }
+
+  JournalReader::JournalReader(const std::vector<std::string> &paths) {
+    open(paths);
+  }
+
+  auto JournalReader::open(const std::vector<std::string> &paths) -> void {
+    for (const auto &path : paths) {
+      auto file = std::make_unique<JournalFile>(path);
+      if (file->valid())
+        files_.push_back(std::move(file));
+    }
+
+    std::sort(files_.begin(), files_.end(), [](const auto &lhs, const auto &rhs) {
+      if (lhs->header()->date_ != rhs->header()->date_)
+        return lhs->header()->date_ < rhs->header()->date_;
+      if (lhs->header()->file_index_ != rhs->header()->file_index_)
+        return lhs->header()->file_index_ < rhs->header()->file_index_;
+      return lhs->path() < rhs->path();
+    });
+  }
+
+  auto JournalReader::seek(Nanos time) const noexcept -> JournalPosition {
+    for (size_t i = 0; i < files_.size(); ++i) {
+      if (files_[i]->maxTime() < time)
+        continue;
+      const auto offset = files_[i]->seek(time);
+      if (offset < files_[i]->endOffset())
+        return {i, offset};
+    }
+    return end();
+  }
+
+  auto JournalReader::chunk(JournalPosition from, JournalPosition to) const -> JournalChunk {
+    JournalChunk chunk;
+    for (auto i = from.file_index_; i < files_.size() && i <= to.file_index_; ++i) {
+      const auto &file = files_[i];
+      const auto begin = (i == from.file_index_ ? from.offset_ : file->beginOffset());
+      const auto end = (i == to.file_index_ ? to.offset_ : file->endOffset());
+      if (begin < end)
+        chunk.ranges_.push_back({file.get(), begin, end});
+    }
+    return chunk;
+  }
+
+  auto JournalReader::partitionByTime(size_t num_chunks) const -> std::vector<JournalChunk> {
+    size_t total_size = 0;
+    for (const auto &file : files_)
+      total_size += file->endOffset() - file->beginOffset();
+    const auto chunk_size = std::max<size_t>(1, total_size / std::max<size_t>(1, num_chunks));
+
+    // Cut at the index entries, which are on record boundaries, closest after every multiple of chunk_size.
+    std::vector<JournalPosition> cuts = {begin()};
+    size_t done = 0;
+    for (size_t i = 0; i < files_.size(); ++i) {
+      const auto &file = files_[i];
+      for (const auto &entry : file->timeIndex()) {
+        if (cuts.size() < num_chunks && done + entry.offset_ - file->beginOffset() >= cuts.size() * chunk_size)
+          cuts.push_back({i, static_cast<size_t>(entry.offset_)});
+      }
+      done += file->endOffset() - file->beginOffset();
+    }
+    cuts.push_back(end());
+
+    std::vector<JournalChunk> chunks;
+    for (size_t i = 0; i + 1 < cuts.size(); ++i) {
+      auto next_chunk = chunk(cuts[i], cuts[i + 1]);
+      if (!next_chunk.ranges_.empty())
+        chunks.push_back(std::move(next_chunk));
+    }
+    return chunks;
+  }
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "macros.h"
+#include "types.h"
+#include "journal.h"
+
+namespace Common {
+  /// Every this many records (overall for times, per stream for sequence numbers) the index has an entry.
+  constexpr size_t JOURNAL_INDEX_INTERVAL = 256;
+
+  /// Zero copy typed view of the payload of a record, nullptr if the payload is too short to be a T.
+  template<typename T>
+  inline auto journalView(const JournalRecordHeader *record) noexcept -> const T * {
+    return (record->length_ >= sizeof(T) ? reinterpret_cast<const T *>(record + 1) : nullptr);
+  }
+
+  /// Sparse index entry of the time index - records before offset_ are all earlier than max_time_before_ or at it.
+  struct JournalTimeIndexEntry {
+    uint64_t offset_ = 0;
+    Nanos max_time_before_ = 0;
+  };
+
+  /// Sparse index entry of the sequence number index, ordered by stream and sequence number.
+  struct JournalSeqIndexEntry {
+    uint64_t stream_id_ = 0;
+    uint64_t seq_ = 0;
+    uint64_t offset_ = 0;
+  };
+
+  /// Read only memory mapping of one journal file with its sparse time and sequence number index.
+  /// The index is kept next to the file as <path>.idx - built by the first open of the file and loaded by later ones
+  /// as long as it matches the data size of the file. A file still being written is read up to where it was on open, a
+  /// torn last record ends the file.
+  class JournalFile final {
+  public:
+    explicit JournalFile(const std::string &path);
+
+    ~JournalFile();
+
+    auto valid() const noexcept {
+      return header_ != nullptr;
+    }
+
+    auto path() const noexcept -> const std::string & {
+      return path_;
+    }
+
+    auto header() const noexcept {
+      return header_;
+    }
+
+    /// Offsets of the first record and one past the last one.
+    auto beginOffset() const noexcept -> size_t {
+      return header_ ? header_->header_size_ : 0;
+    }
+
+    auto endOffset() const noexcept {
+      return end_offset_;
+    }
+
+    auto recordAt(size_t offset) const noexcept {
+      return reinterpret_cast<const JournalRecordHeader *>(base_ + offset);
+    }
+
+    auto nextOffset(size_t offset) const noexcept {
+      return offset + journalRecordSize(recordAt(offset)->length_);
+    }
+
+    /// Offset of the first record at or after time, every record before it is earlier. O(log n) in the index plus a
+    /// scan of at most JOURNAL_INDEX_INTERVAL records.
+    auto seek(Nanos time) const noexcept -> size_t;
+
+    /// Offset of the first record of the stream with at least the sequence number, endOffset() if there is none.
+    auto seekSeq(uint16_t stream_id, uint64_t seq) const noexcept -> size_t;
+
+    auto numRecords() const noexcept {
+      return num_records_;
+    }
+
+    /// Latest record time in the file.
+    auto maxTime() const noexcept {
+      return max_time_;
+    }
+
+    auto timeIndex() const noexcept -> const std::vector<JournalTimeIndexEntry> & {
+      return time_index_;
+    }
+
+    /// Name the stream was recorded under, empty if the file has no STREAM_INFO record for it.
+    auto streamName(uint16_t stream_id) const noexcept -> std::string;
+
+    /// Call f(const JournalRecordHeader *) for every record in [begin, end).
+    template<typename F>
+    auto forEach(size_t begin, size_t end, F &&f) const {
+      for (auto offset = begin; offset < end; offset = nextOffset(offset))
+        f(recordAt(offset));
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    JournalFile() = delete;
+
+    JournalFile(const JournalFile &) = delete;
+
+    JournalFile(const JournalFile &&) = delete;
+
+    JournalFile &operator=(const JournalFile &) = delete;
+
+    JournalFile &operator=(const JournalFile &&) = delete;
+
+  private:
+    auto loadIndex(size_t published_size) noexcept -> bool;
+
+    auto buildIndex() noexcept -> void;
+
+    auto saveIndex(size_t published_size) const noexcept -> void;
+
+    const std::string path_;
+    const char *base_ = nullptr;
+    size_t mapped_size_ = 0;
+    const JournalFileHeader *header_ = nullptr;
+    size_t end_offset_ = 0;
+
+    size_t num_records_ = 0;
+    Nanos max_time_ = 0;
+    std::vector<JournalTimeIndexEntry> time_index_;
+    std::vector<JournalSeqIndexEntry> seq_index_;
+  };
+
+  /// Run of consecutive records of one file, [begin_, end_) in byte offsets on record boundaries.
+  struct JournalRange {
+    const JournalFile *file_ = nullptr;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+  };
+
+  /// Share of a journal for one thread - consecutive runs of records, optionally only for some of the tickers.
+  struct JournalChunk {
+    std::vector<JournalRange> ranges_;
+
+    /// Ticker partitioning - the chunk is for tickers with ticker_id % num_ticker_partitions_ == ticker_partition_.
+    size_t ticker_partition_ = 0;
+    size_t num_ticker_partitions_ = 1;
+
+    auto hasTicker(TickerId ticker_id) const noexcept {
+      return num_ticker_partitions_ <= 1 || ticker_id % num_ticker_partitions_ == ticker_partition_;
+    }
+
+    /// Add the records [begin, end) of the file, extending the last range if they follow on from it.
+    auto append(const JournalFile *file, size_t begin, size_t end) {
+      if (!ranges_.empty() && ranges_.back().file_ == file && ranges_.back().end_ == begin)
+        ranges_.back().end_ = end;
+      else
+        ranges_.push_back({file, begin, end});
+    }
+
+    /// Call f(const JournalRecordHeader *) for every record of the chunk in order.
+    template<typename F>
+    auto forEach(F &&f) const {
+      for (const auto &range : ranges_)
+        range.file_->forEach(range.begin_, range.end_, f);
+    }
+
+    /// Call f(const JournalRecordHeader *, const T &) for every record of the type, viewed in place as a T.
+    template<typename T, typename F>
+    auto forEach(JournalRecordType type, F &&f) const {
+      forEach([&](const JournalRecordHeader *record) {
+        if (record->type_ == type) {
+          if (const auto value = journalView<T>(record))
+            f(record, *value);
+        }
+      });
+    }
+  };
+
+  /// Position of a record in a JournalReader.
+  struct JournalPosition {
+    size_t file_index_ = 0;
+    size_t offset_ = 0;
+  };
+
+  /// All files of a journal in order - by date, then by index within the date.
+  class JournalReader final {
+  public:
+    /// Every *.jnl file in the directory, only the ones named <prefix>_... if a prefix is given.
+    explicit JournalReader(const std::string &dir, const std::string &prefix = "");
+
+    /// Exactly these files, ordered by their headers.
+    explicit JournalReader(const std::vector<std::string> &paths);
+
+    auto files() const noexcept -> const std::vector<std::unique_ptr<JournalFile>> & {
+      return files_;
+    }
+
+    auto numRecords() const noexcept {
+      size_t num_records = 0;
+      for (const auto &file : files_)
+        num_records += file->numRecords();
+      return num_records;
+    }
+
+    /// Position of the first record at or after time.
+    auto seek(Nanos time) const noexcept -> JournalPosition;
+
+    auto begin() const noexcept -> JournalPosition {
+      return {0, files_.empty() ? 0 : files_.front()->beginOffset()};
+    }
+
+    auto end() const noexcept -> JournalPosition {
+      return {files_.size(), 0};
+    }
+
+    /// Everything in [from, to) as one chunk.
+    auto chunk(JournalPosition from, JournalPosition to) const -> JournalChunk;
+
+    auto chunk() const -> JournalChunk {
+      return chunk(begin(), end());
+    }
+
+    /// Split into at most num_chunks runs of consecutive records of about the same size, each starting where the
+    /// previous one ends - for work where records only depend on the earlier records of the same chunk.
+    auto partitionByTime(size_t num_chunks) const -> std::vector<JournalChunk>;
+
+    /// num_partitions chunks over the whole journal, each for its own share of the tickers - every ticker's records
+    /// stay in order on one thread, e.g. to rebuild order books in parallel. One pass over the journal sends every
+    /// record to the chunk of the ticker ticker_of(const JournalRecordHeader *) returns for it, records it returns
+    /// TickerId_INVALID for (e.g. STREAM_INFO, or raw frames only parsed later) go to every chunk - filter those with
+    /// JournalChunk::hasTicker().
+    template<typename F>
+    auto partitionByTicker(size_t num_partitions, F &&ticker_of) const -> std::vector<JournalChunk> {
+      std::vector<JournalChunk> chunks(std::max<size_t>(1, num_partitions));
+      for (size_t i = 0; i < chunks.size(); ++i) {
+        chunks[i].ticker_partition_ = i;
+        chunks[i].num_ticker_partitions_ = chunks.size();
+      }
+
+      for (const auto &file : files_) {
+        for (auto offset = file->beginOffset(); offset < file->endOffset();) {
+          const auto next_offset = file->nextOffset(offset);
+          const TickerId ticker_id = ticker_of(file->recordAt(offset));
+          if (ticker_id == TickerId_INVALID) {
+            for (auto &chunk : chunks)
+              chunk.append(file.get(), offset, next_offset);
+          } else {
+            chunks[ticker_id % chunks.size()].append(file.get(), offset, next_offset);
+          }
+          offset = next_offset;
+        }
+      }
+      return chunks;
+    }
+
+  private:
+    auto open(const std::vector<std::string> &paths) -> void;
+
+    std::vector<std::unique_ptr<JournalFile>> files_;
+  };
+
+  /// Run f(chunk_index, chunk) for every chunk on its own thread and wait for all of them.
+  template<typename F>
+  inline auto scanParallel(const std::vector<JournalChunk> &chunks, F &&f) -> void {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < chunks.size(); ++i)
+      threads.emplace_back([&f, &chunks, i]() { f(i, chunks[i]); });
+    for (auto &thread : threads)
+      thread.join();
+  }
+}
@@ -0,0 +1,99 @@
+#include "journal_recorder.h"
+
+#include <limits>
+
+#include "thread_utils.h"
+
+namespace Common {
+  JournalRecorder::JournalRecorder(const std::string &dir, const std::string &prefix, size_t file_size, Logger *logger)
+      : logger_(logger), writer_(dir, prefix, file_size) {
+    writer_.setOnNewFile([this]() { writeStreamInfo(); });
+  }
+
+  JournalRecorder::~JournalRecorder() {
+    stop();
+  }
+
+  auto JournalRecorder::addRawStream(const std::string &name, size_t capacity) -> JournalByteRing * {
+    auto stream = std::make_unique<RawStream>(name, capacity);
+    auto ring = &stream->ring_;
+    streams_.push_back(std::move(stream));
+    return ring;
+  }
+
+  auto JournalRecorder::start(int core_id) -> void {
+    ASSERT(streams_.size() <= std::numeric_limits<uint16_t>::max(), "Too many journal streams:" + std::to_string(streams_.size()));
+    running_ = true;
+    thread_ = createAndStartThread(core_id, "Common/JournalRecorder", [this]() { run(); });
+    ASSERT(thread_ != nullptr, "Failed to start JournalRecorder thread.");
+  }
+
+  auto JournalRecorder::stop() -> void {
+    if (!thread_)
+      return;
+
+    running_ = false;
+    thread_->join();
+    delete thread_;
+    thread_ = nullptr;
+  }
+
+  auto JournalRecorder::run() noexcept -> void {
+    logger_->log("%:% %() % streams:%\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), streams_.size());
+
+    auto last_flush = getCurrentNanos();
+    while (true) {
+      // Read the flag first so the last pass after stop() still sees everything written before it.
+      const auto running = running_;
+      size_t count = 0;
+      for (size_t i = 0; i < streams_.size(); ++i)
+        count += streams_[i]->drain(this, static_cast<uint16_t>(i + 1));
+
+      if (count)
+        continue;
+      if (!running)
+        break;
+
+      if (getCurrentNanos() - last_flush > NANOS_TO_SECS) {
+        writer_.flush();
+        last_flush = getCurrentNanos();
+      }
+
+      using namespace std::literals::chrono_literals;
+      std::this_thread::sleep_for(1ms);
+    }
+
+    writer_.close();
+    logger_->log("%:% %() % records:% lost:% files:%\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                 numRecords(), numLost(), writer_.numFiles());
+  }
+
+  auto JournalRecorder::record(Stream *stream, uint16_t stream_id, JournalRecordType type, uint64_t seq, Nanos time,
+                               const void *data, size_t length) noexcept -> void {
+    if (UNLIKELY(seq != stream->last_seq_ + 1 && stream->last_seq_)) {
+      const uint64_t lost = seq - stream->last_seq_ - 1;
+      num_lost_.store(numLost() + lost, std::memory_order_relaxed);
+      writer_.append(JournalRecordType::GAP, stream_id, seq - 1, time, &lost, sizeof(lost));
+      logger_->log("%:% %() % % lost:%\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                   stream->name_.c_str(), lost);
+    }
+    stream->last_seq_ = seq;
+
+    if (LIKELY(writer_.append(type, stream_id, seq, time, data, static_cast<uint32_t>(length)))) {
+      num_records_.store(numRecords() + 1, std::memory_order_relaxed);
+    } else {
+      num_lost_.store(numLost() + 1, std::memory_order_relaxed);
+      logger_->log("%:% %() % % could not write % bytes to %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
+                   stream->name_.c_str(), length, writer_.currentPath().c_str());
+    }
+  }
+
+  auto JournalRecorder::writeStreamInfo() noexcept -> void {
+    const auto now = getCurrentNanos();
+    for (size_t i = 0; i < streams_.size(); ++i) {
+      const auto &name = streams_[i]->name_;
+      writer_.append(JournalRecordType::STREAM_INFO, static_cast<uint16_t>(i + 1), 0, now, name.data(),
+                     static_cast<uint32_t>(name.size()));
+    }
+  }
+}
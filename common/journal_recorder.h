@@ -0,0 +1,280 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "macros.h"
+#include "lf_queue.h"
+#include "logging.h"
+#include "journal.h"
+
+namespace Common {
+  /// Default size of the ring raw frames are handed to the recorder through.
+  constexpr size_t JOURNAL_RING_SIZE = 64 * 1024 * 1024;
+
+  /// Single producer single consumer ring of variable length frames, for raw feed frames which never pass through an
+  /// LFQueue. The producer copies a frame in once and never blocks - frames which do not fit are dropped and show up
+  /// as a jump in the sequence numbers of the stream.
+  class JournalByteRing final {
+  public:
+    /// Capacity in bytes, a power of two.
+    explicit JournalByteRing(size_t capacity)
+        : capacity_(capacity), store_(capacity / sizeof(uint64_t)) {
+      ASSERT(capacity_ >= 1024 && !(capacity_ & (capacity_ - 1)), "Journal ring capacity not a power of two:" + std::to_string(capacity_));
+    }
+
+    /// Producer side - copy in a frame made of the parts one after the other, stamped with its receive time.
+    auto push(JournalRecordType type, Nanos time, std::initializer_list<std::string_view> parts) noexcept -> bool {
+      const auto seq = ++next_seq_;
+      size_t payload_length = 0;
+      for (const auto &part : parts)
+        payload_length += part.size();
+      const auto size = journalRecordSize(payload_length);
+
+      auto write_pos = write_pos_.load(std::memory_order_relaxed);
+      const auto read_pos = read_pos_.load(std::memory_order_acquire);
+      const auto offset = write_pos & (capacity_ - 1);
+      const auto to_end = capacity_ - offset;
+      const auto needed = size + (size > to_end ? to_end : 0);
+      if (UNLIKELY(size > capacity_ / 2 || write_pos + needed - read_pos > capacity_)) {
+        num_dropped_.store(num_dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+      }
+
+      // Frames are contiguous - the tail of the ring is skipped if the frame does not fit in it.
+      auto base = reinterpret_cast<char *>(store_.data());
+      if (size > to_end) {
+        if (to_end >= sizeof(JournalRecordHeader))
+          new(base + offset) JournalRecordHeader{};
+        write_pos += to_end;
+      }
+
+      auto header = new(base + (write_pos & (capacity_ - 1))) JournalRecordHeader{static_cast<uint32_t>(payload_length), type, 0, seq, time};
+      auto payload = reinterpret_cast<char *>(header + 1);
+      for (const auto &part : parts) {
+        std::memcpy(payload, part.data(), part.size());
+        payload += part.size();
+      }
+
+      write_pos_.store(write_pos + size, std::memory_order_release);
+      return true;
+    }
+
+    auto push(JournalRecordType type, Nanos time, const char *data, size_t length) noexcept -> bool {
+      return push(type, time, {std::string_view(data, length)});
+    }
+
+    /// Consumer side - next frame or nullptr, the payload follows the header.
+    auto front() noexcept -> const JournalRecordHeader * {
+      auto read_pos = read_pos_.load(std::memory_order_relaxed);
+      const auto write_pos = write_pos_.load(std::memory_order_acquire);
+      const auto base = reinterpret_cast<const char *>(store_.data());
+      while (read_pos != write_pos) {
+        const auto offset = read_pos & (capacity_ - 1);
+        const auto to_end = capacity_ - offset;
+        const auto header = reinterpret_cast<const JournalRecordHeader *>(base + offset);
+        if (to_end < sizeof(JournalRecordHeader) || header->type_ == JournalRecordType::INVALID) {
+          read_pos += to_end;
+          continue;
+        }
+        read_pos_.store(read_pos, std::memory_order_release);
+        return header;
+      }
+      read_pos_.store(read_pos, std::memory_order_release);
+      return nullptr;
+    }
+
+    /// Consumer side - release the frame returned by front().
+    auto pop(const JournalRecordHeader *header) noexcept {
+      read_pos_.store(read_pos_.load(std::memory_order_relaxed) + journalRecordSize(header->length_), std::memory_order_release);
+    }
+
+    auto numDropped() const noexcept {
+      return num_dropped_.load(std::memory_order_relaxed);
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    JournalByteRing() = delete;
+
+    JournalByteRing(const JournalByteRing &) = delete;
+
+    JournalByteRing(const JournalByteRing &&) = delete;
+
+    JournalByteRing &operator=(const JournalByteRing &) = delete;
+
+    JournalByteRing &operator=(const JournalByteRing &&) = delete;
+
+  private:
+    const size_t capacity_;
+    std::vector<uint64_t> store_;
+
+    /// Byte positions, only ever increasing - producer and consumer each own one, on separate cache lines.
+    alignas(64) std::atomic<size_t> write_pos_ = {0};
+    uint64_t next_seq_ = 0;
+    std::atomic<size_t> num_dropped_ = {0};
+    alignas(64) std::atomic<size_t> read_pos_ = {0};
+  };
+
+  /// Observer of an LFQueue which sees every element written without consuming it, so whatever reads the queue is
+  /// unaffected. It has to keep up with the writer - elements overwritten before it copied them are skipped.
+  template<typename T>
+  class LFQueueTap final {
+    static_assert(std::is_trivially_copyable_v<T>, "LFQueueTap requires a trivially copyable type.");
+
+  public:
+    /// Starts with the next element written.
+    explicit LFQueueTap(const LFQueue<T> *queue) noexcept
+        : queue_(queue), next_seq_(queue->numWritten()) {
+    }
+
+    /// Copy out the next element written since the previous call, false if there is none yet.
+    auto next(T *value) noexcept -> bool {
+      const auto capacity = queue_->capacity();
+      while (true) {
+        const auto num_written = queue_->numWritten();
+        if (next_seq_ == num_written)
+          return false;
+        if (UNLIKELY(num_written - next_seq_ >= capacity))
+          next_seq_ = num_written - capacity + 1;
+
+        // Same idea as SeqLock - copy, then check the writer did not get to the slot in the meantime.
+        std::memcpy(static_cast<void *>(value), queue_->elementAt(next_seq_), sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (LIKELY(queue_->numWritten() - next_seq_ < capacity)) {
+          ++next_seq_;
+          return true;
+        }
+      }
+    }
+
+    /// Write sequence number (1 based) of the element last returned by next().
+    auto seq() const noexcept {
+      return static_cast<uint64_t>(next_seq_);
+    }
+
+  private:
+    const LFQueue<T> *queue_ = nullptr;
+    size_t next_seq_ = 0;
+  };
+
+  /// Always-on recorder thread which appends everything passing through the LFQueues it taps and the raw frames
+  /// pushed into its rings to journal files. Record times are receive times for raw frames and the time the
+  /// recorder saw the element for tapped queues. Streams are set up before start().
+  class JournalRecorder final {
+  public:
+    JournalRecorder(const std::string &dir, const std::string &prefix, size_t file_size, Logger *logger);
+
+    ~JournalRecorder();
+
+    /// Record every element written to the queue as records of the given type.
+    template<typename T>
+    auto tap(const std::string &name, JournalRecordType type, const LFQueue<T> *queue) -> void {
+      streams_.push_back(std::make_unique<TapStream<T>>(name, type, queue));
+    }
+
+    /// Ring the thread receiving a raw feed pushes its frames into, owned by the recorder.
+    auto addRawStream(const std::string &name, size_t capacity = JOURNAL_RING_SIZE) -> JournalByteRing *;
+
+    auto start(int core_id = -1) -> void;
+
+    /// Record whatever is still pending and close the current file.
+    auto stop() -> void;
+
+    auto numRecords() const noexcept {
+      return num_records_.load(std::memory_order_relaxed);
+    }
+
+    auto numLost() const noexcept {
+      return num_lost_.load(std::memory_order_relaxed);
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    JournalRecorder() = delete;
+
+    JournalRecorder(const JournalRecorder &) = delete;
+
+    JournalRecorder(const JournalRecorder &&) = delete;
+
+    JournalRecorder &operator=(const JournalRecorder &) = delete;
+
+    JournalRecorder &operator=(const JournalRecorder &&) = delete;
+
+  private:
+    /// Records drained from a stream in one go, so one busy stream does not hold up the others.
+    static constexpr size_t MAX_DRAIN = 1024;
+
+    struct Stream {
+      explicit Stream(const std::string &name) : name_(name) {
+      }
+
+      virtual ~Stream() = default;
+
+      /// Append what is pending to the journal, returns the number of records.
+      virtual auto drain(JournalRecorder *recorder, uint16_t stream_id) noexcept -> size_t = 0;
+
+      std::string name_;
+      uint64_t last_seq_ = 0;
+    };
+
+    template<typename T>
+    struct TapStream final : Stream {
+      TapStream(const std::string &name, JournalRecordType type, const LFQueue<T> *queue)
+          : Stream(name), type_(type), tap_(queue) {
+      }
+
+      auto drain(JournalRecorder *recorder, uint16_t stream_id) noexcept -> size_t override {
+        size_t count = 0;
+        for (T value; count < MAX_DRAIN && tap_.next(&value); ++count)
+          recorder->record(this, stream_id, type_, tap_.seq(), getCurrentNanos(), &value, sizeof(T));
+        return count;
+      }
+
+      JournalRecordType type_;
+      LFQueueTap<T> tap_;
+    };
+
+    struct RawStream final : Stream {
+      RawStream(const std::string &name, size_t capacity) : Stream(name), ring_(capacity) {
+      }
+
+      auto drain(JournalRecorder *recorder, uint16_t stream_id) noexcept -> size_t override {
+        size_t count = 0;
+        for (auto frame = ring_.front(); count < MAX_DRAIN && frame; frame = ring_.front(), ++count) {
+          recorder->record(this, stream_id, frame->type_, frame->seq_, frame->time_, frame + 1, frame->length_);
+          ring_.pop(frame);
+        }
+        return count;
+      }
+
+      JournalByteRing ring_;
+    };
+
+    auto run() noexcept -> void;
+
+    /// Append one record of a stream, preceded by a GAP record if the stream lost records since its last one.
+    auto record(Stream *stream, uint16_t stream_id, JournalRecordType type, uint64_t seq, Nanos time,
+                const void *data, size_t length) noexcept -> void;
+
+    /// STREAM_INFO records at the start of every file, so every file can be read on its own.
+    auto writeStreamInfo() noexcept -> void;
+
+    std::string time_str_;
+    Logger *logger_ = nullptr;
+
+    JournalWriter writer_;
+    std::vector<std::unique_ptr<Stream>> streams_;
+
+    std::thread *thread_ = nullptr;
+    volatile bool running_ = false;
+
+    std::atomic<size_t> num_records_ = {0};
+    std::atomic<size_t> num_lost_ = {0};
+  };
+}
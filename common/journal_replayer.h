@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+
+#include "macros.h"
+#include "time_utils.h"
+#include "journal_reader.h"
+
+namespace Common {
+  /// How fast a JournalReplayer hands out records.
+  enum class ReplayPacing : uint8_t {
+    /// Every record as soon as the previous one is handled.
+    AS_FAST_AS_POSSIBLE = 0,
+    /// Records spaced by their recorded times.
+    REAL_TIME = 1,
+    /// Records spaced by their recorded times divided by the speed factor.
+    SPEED = 2
+  };
+
+  inline auto replayPacingToString(ReplayPacing pacing) -> std::string {
+    switch (pacing) {
+      case ReplayPacing::AS_FAST_AS_POSSIBLE:
+        return "AS_FAST_AS_POSSIBLE";
+      case ReplayPacing::REAL_TIME:
+        return "REAL_TIME";
+      case ReplayPacing::SPEED:
+        return "SPEED";
+    }
+    return "UNKNOWN";
+  }
+
+  /// Outcome of one replay.
+  struct JournalReplayStats {
+    size_t num_records_ = 0;
+
+    /// Wall time the replay took and the recorded time it covered.
+    Nanos wall_time_ = 0;
+    Nanos journal_time_ = 0;
+
+    /// Latest any record was handed out compared to its paced time, 0 when not paced.
+    Nanos max_lag_ = 0;
+  };
+
+  /// Replays the records of a journal chunk, in journal order and on the calling thread, into a handler.
+  /// With simulate_clock the calling thread's getCurrentNanos() returns the time of the record being handled, so
+  /// the timestamps the handler (e.g. an adapter's on-message path) produces are those of the recording and two
+  /// replays of the same journal produce the same output. Latencies should then be measured with getSystemNanos().
+  class JournalReplayer final {
+  public:
+    explicit JournalReplayer(ReplayPacing pacing = ReplayPacing::AS_FAST_AS_POSSIBLE, double speed = 1.0, bool simulate_clock = true)
+        : pacing_(pacing), speed_(pacing == ReplayPacing::REAL_TIME ? 1.0 : speed), simulate_clock_(simulate_clock) {
+      ASSERT(pacing_ == ReplayPacing::AS_FAST_AS_POSSIBLE || speed_ > 0, "Replay speed has to be positive:" + std::to_string(speed_));
+    }
+
+    /// Call f(const JournalRecordHeader *) for every data record of the chunk - STREAM_INFO and GAP records are skipped.
+    /// Stops early, before the next record, once stop() is called from another thread.
+    template<typename F>
+    auto replay(const JournalChunk &chunk, F &&f) -> JournalReplayStats {
+      JournalReplayStats stats;
+      run_ = true;
+      const auto wall_start = getSystemNanos();
+      Nanos first_time = 0, last_time = 0;
+
+      chunk.forEach([&](const JournalRecordHeader *record) {
+        if (!run_ || record->type_ == JournalRecordType::STREAM_INFO || record->type_ == JournalRecordType::GAP)
+          return;
+
+        if (!stats.num_records_)
+          first_time = record->time_;
+        last_time = std::max(last_time, record->time_);
+
+        if (pacing_ != ReplayPacing::AS_FAST_AS_POSSIBLE && record->time_ > first_time) {
+          const auto due = wall_start + static_cast<Nanos>(static_cast<double>(record->time_ - first_time) / speed_);
+          waitUntil(due);
+          stats.max_lag_ = std::max(stats.max_lag_, getSystemNanos() - due);
+        }
+
+        if (simulate_clock_)
+          setSimulatedNanos(record->time_);
+        f(record);
+        ++stats.num_records_;
+      });
+
+      if (simulate_clock_)
+        setSimulatedNanos(0);
+      stats.wall_time_ = getSystemNanos() - wall_start;
+      stats.journal_time_ = (stats.num_records_ ? last_time - first_time : 0);
+      return stats;
+    }
+
+    auto stop() noexcept {
+      run_ = false;
+    }
+
+    auto pacing() const noexcept {
+      return pacing_;
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    JournalReplayer(const JournalReplayer &) = delete;
+
+    JournalReplayer(const JournalReplayer &&) = delete;
+
+    JournalReplayer &operator=(const JournalReplayer &) = delete;
+
+    JournalReplayer &operator=(const JournalReplayer &&) = delete;
+
+  private:
+    /// Sleep while the wait is long, spin for the last stretch so records are handed out close to their due time.
+    static auto waitUntil(Nanos due) noexcept -> void {
+      constexpr Nanos SPIN_NANOS = 200 * NANOS_TO_MICROS;
+      for (auto now = getSystemNanos(); now < due; now = getSystemNanos()) {
+        if (due - now > SPIN_NANOS)
+          std::this_thread::sleep_for(std::chrono::nanoseconds(due - now - SPIN_NANOS));
+      }
+    }
+
+    const ReplayPacing pacing_;
+    const double speed_;
+    const bool simulate_clock_;
+    volatile bool run_ = false;
+  };
+}
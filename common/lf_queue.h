@@ -20,6 +20,7 @@ namespace Common {
 
     auto updateWriteIndex() noexcept {
       next_write_index_ = (next_write_index_ + 1) % store_.size();
+      num_written_.store(num_written_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
       num_elements_++;
     }
 
@@ -29,7 +30,8 @@ namespace Common {
 
     auto updateReadIndex() noexcept {
       next_read_index_ = (next_read_index_ + 1) % store_.size(); // wrap around at the end of container size.
-      ASSERT(num_elements_ != 0, "Read an invalid element in:" + std::to_string(pthread_self()));
+      if (UNLIKELY(num_elements_ == 0)) // Message only built on failure, it would allocate on every read.
+        ASSERT(false, "Read an invalid element in:" + std::to_string(pthread_self()));
       num_elements_--;
     }
 
@@ -37,6 +39,21 @@ namespace Common {
       return num_elements_.load();
     }
 
+    /// Total number of elements ever written, the writer is the only one to update it.
+    auto numWritten() const noexcept {
+      return num_written_.load(std::memory_order_acquire);
+    }
+
+    auto capacity() const noexcept {
+      return store_.size();
+    }
+
+    /// Element with the given write sequence number (0 based), valid until the writer wraps around onto its slot.
+    /// Used by LFQueueTap to observe the elements without consuming them.
+    auto elementAt(size_t seq) const noexcept -> const T * {
+      return &store_[seq % store_.size()];
+    }
+
     /// Deleted default, copy & move constructors and assignment-operators.
     LFQueue() = delete;
 
@@ -57,5 +74,8 @@ namespace Common {
     std::atomic<size_t> next_read_index_ = {0};
 
     std::atomic<size_t> num_elements_ = {0};
+
+    /// Monotonic count of writes, lets observers other than the reader follow the queue.
+    std::atomic<size_t> num_written_ = {0};
   };
 }
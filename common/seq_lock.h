@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+#include "macros.h"
+
+namespace Common {
+  /// Sequence lock around a small trivially copyable value, e.g. a set of limits.
+  /// Writers never block readers - a reader copies the value and retries only if a write overlapped the copy, so a
+  /// latency critical thread can read configuration which another thread updates atomically at any time.
+  template<typename T>
+  class SeqLock final {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock requires a trivially copyable type.");
+
+  public:
+    SeqLock() noexcept {
+      store(T{});
+    }
+
+    explicit SeqLock(const T &value) noexcept {
+      store(value);
+    }
+
+    /// Consistent copy of the last stored value.
+    auto load() const noexcept {
+      std::array<uint64_t, NUM_WORDS> words;
+      size_t seq_begin, seq_end;
+      do {
+        seq_begin = seq_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < NUM_WORDS; ++i)
+          words[i] = std::atomic_ref<uint64_t>(const_cast<uint64_t &>(words_[i])).load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq_end = seq_.load(std::memory_order_relaxed);
+      } while (UNLIKELY((seq_begin & 1) || seq_begin != seq_end));
+
+      T value;
+      std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+      return value;
+    }
+
+    /// Publish a new value, safe to call from any number of threads.
+    auto store(const T &value) noexcept -> void {
+      std::array<uint64_t, NUM_WORDS> words = {};
+      std::memcpy(words.data(), &value, sizeof(T));
+
+      // Writers serialise on the sequence number itself by moving it from even to odd.
+      auto seq = seq_.load(std::memory_order_relaxed);
+      while ((seq & 1) || !seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed))
+        seq = seq_.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      for (size_t i = 0; i < NUM_WORDS; ++i)
+        std::atomic_ref<uint64_t>(words_[i]).store(words[i], std::memory_order_relaxed);
+
+      seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    /// Deleted copy & move constructors and assignment-operators.
+    SeqLock(const SeqLock &) = delete;
+
+    SeqLock(const SeqLock &&) = delete;
+
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    SeqLock &operator=(const SeqLock &&) = delete;
+
+  private:
+    static constexpr size_t NUM_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<size_t> seq_ = {0};
+    alignas(uint64_t) std::array<uint64_t, NUM_WORDS> words_ = {};
+  };
+}
@@ -4,6 +4,8 @@
 #include <chrono>
 #include <ctime>
 
+#include "macros.h"
+
 namespace Common {
   typedef int64_t Nanos;
 
@@ -13,10 +15,26 @@ namespace Common {
   constexpr Nanos NANOS_TO_MILLIS = NANOS_TO_MICROS * MICROS_TO_MILLIS;
   constexpr Nanos NANOS_TO_SECS = NANOS_TO_MILLIS * MILLIS_TO_SECS;
 
-  inline auto getCurrentNanos() noexcept {
+  /// Simulated time of the calling thread, 0 while it runs on the wall clock.
+  /// Set by the backtester so the trading components on its thread see event time instead of wall time.
+  inline thread_local Nanos simulated_nanos = 0;
+
+  /// Wall clock time, regardless of any simulated time.
+  inline auto getSystemNanos() noexcept -> Nanos {
     return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
   }
 
+  inline auto getCurrentNanos() noexcept -> Nanos {
+    if (UNLIKELY(simulated_nanos))
+      return simulated_nanos;
+    return getSystemNanos();
+  }
+
+  /// Drive getCurrentNanos() on the calling thread from a simulated clock, 0 goes back to the wall clock.
+  inline auto setSimulatedNanos(Nanos nanos) noexcept {
+    simulated_nanos = nanos;
+  }
+
   inline auto& getCurrentTimeStr(std::string* time_str) {
     const auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
     time_str->assign(ctime(&time));
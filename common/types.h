@@ -161,18 +161,73 @@ namespace Common {
   }
 
   /// Risk configuration containing limits on risk parameters for the RiskManager.
+  /// max_position_ applies to the worst case position, i.e. the position if every working order on one side filled.
+  /// The rate and price band limits are disabled when 0, the absolute price limits (e.g. exchange circuit limits) when
+  /// left at 0 / Price_INVALID.
   struct RiskCfg {
     Qty max_order_size_ = 0;
     Qty max_position_ = 0;
     double max_loss_ = 0;
 
+    /// Sustained order rate and burst size of this ticker's order rate throttle.
+    uint32_t max_orders_per_sec_ = 0;
+    uint32_t max_order_burst_ = 1;
+
+    /// Maximum distance of an order price from the BBO mid, in basis points.
+    uint32_t price_band_bps_ = 0;
+
+    /// Venue this ticker trades on, for the per venue exposure limits.
+    uint8_t venue_id_ = 0;
+
+    Price min_price_ = 0;
+    Price max_price_ = Price_INVALID;
+
     auto toString() const {
       std::stringstream ss;
 
       ss << "RiskCfg{"
          << "max-order-size:" << qtyToString(max_order_size_) << " "
          << "max-position:" << qtyToString(max_position_) << " "
-         << "max-loss:" << max_loss_
+         << "max-loss:" << max_loss_ << " "
+         << "max-rate:" << max_orders_per_sec_ << "/s burst:" << max_order_burst_ << " "
+         << "band-bps:" << price_band_bps_ << " "
+         << "venue:" << static_cast<int>(venue_id_) << " "
+         << "limits:[" << priceToString(min_price_) << "," << priceToString(max_price_) << "]"
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// Maximum number of quote levels per side of a ticker.
+  constexpr size_t MAX_QUOTE_LEVELS = 16;
+
+  /// Quote ladder configuration of the market making algorithm, prices are in ticks.
+  /// Quotes are centred on an Avellaneda-Stoikov reservation price, which moves away from the current inventory.
+  struct QuoteCfg {
+    /// Number of levels per side, each of quantity clip, and the distance between consecutive levels.
+    size_t num_levels_ = 1;
+    Price level_spacing_ = 1;
+
+    /// Risk aversion (gamma) and order book liquidity (kappa, per tick) of the Avellaneda-Stoikov model.
+    double risk_aversion_ = 0.1;
+    double liquidity_ = 1.5;
+
+    /// Horizon the inventory is held for, in number of mid price changes.
+    double horizon_ = 100;
+
+    /// Working quotes are only moved once the new top level of that side is at least this many ticks away.
+    Price hysteresis_ = 0;
+
+    auto toString() const {
+      std::stringstream ss;
+
+      ss << "QuoteCfg{"
+         << "levels:" << num_levels_ << "x" << priceToString(level_spacing_) << " "
+         << "gamma:" << risk_aversion_ << " "
+         << "kappa:" << liquidity_ << " "
+         << "horizon:" << horizon_ << " "
+         << "hysteresis:" << priceToString(hysteresis_)
          << "}";
 
       return ss.str();
@@ -184,13 +239,15 @@ namespace Common {
     Qty clip_ = 0;
     double threshold_ = 0;
     RiskCfg risk_cfg_;
+    QuoteCfg quote_cfg_;
 
     auto toString() const {
       std::stringstream ss;
       ss << "TradeEngineCfg{"
          << "clip:" << qtyToString(clip_) << " "
          << "thresh:" << threshold_ << " "
-         << "risk:" << risk_cfg_.toString()
+         << "risk:" << risk_cfg_.toString() << " "
+         << "quote:" << quote_cfg_.toString()
          << "}";
 
       return ss.str();
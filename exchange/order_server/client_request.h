@@ -12,7 +12,8 @@ namespace Exchange {
   enum class ClientRequestType : uint8_t {
     INVALID = 0,
     NEW = 1,
-    CANCEL = 2
+    CANCEL = 2,
+    MODIFY = 3 // Cancel/replace of a working order to the new price and quantity, keeping the same order id.
   };
 
   inline std::string clientRequestTypeToString(ClientRequestType type) {
@@ -21,6 +22,8 @@ namespace Exchange {
         return "NEW";
       case ClientRequestType::CANCEL:
         return "CANCEL";
+      case ClientRequestType::MODIFY:
+        return "MODIFY";
       case ClientRequestType::INVALID:
         return "INVALID";
     }
@@ -16,7 +16,8 @@ namespace Exchange {
     CANCELED = 3,
     FILLED = 4,
     CANCEL_REJECTED = 5,
-    PARTIALLY_FILLED = 6
+    PARTIALLY_FILLED = 6,
+    MODIFY_REJECTED = 7 // The order stays working at its previous price and quantity.
   };
 
   inline std::string clientResponseTypeToString(ClientResponseType type) {
@@ -33,6 +34,8 @@ namespace Exchange {
         return "PARTIALLY_FILLED";
       case ClientResponseType::CANCEL_REJECTED:
         return "CANCEL_REJECTED";
+      case ClientResponseType::MODIFY_REJECTED:
+        return "MODIFY_REJECTED";
       case ClientResponseType::INVALID:
         return "INVALID";
     }
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "exchange/order_server/client_request.h"
+#include "exchange/order_server/client_response.h"
+#include "trading/adapters/binance/order_gw/binance_order_gateway_adapter.h"
+#include "trading/adapters/sim/rest_order_entry_simulator.h"
+
+// Round-trip benchmark of the Binance order gateway against the local Binance order entry simulator, no network or
+// credentials needed. Measures NEW -> ACCEPTED, MODIFY -> ACCEPTED (cancelReplace) and CANCEL -> CANCELED latency over
+// the gateway's kept-alive connection, the throughput of a burst of orders, how long a fill takes to show up through
+// the status poll and that a partial fill is reported once, what the order rate limit does to a burst, and that a
+// request signed with the wrong secret is refused.
+// Usage: binance_order_gateway_benchmark [NUM_ORDERS]
+
+namespace {
+    using namespace Adapter::Sim;
+    using Common::Nanos;
+
+    constexpr Common::ClientId CLIENT_ID = 1;
+    constexpr Common::Price START_PRICE = 3'000'000;    // 30000.00 in ticks of 0.01
+    constexpr Common::Price BID_PRICE = 2'990'000;      // Rests, within PERCENT_PRICE_BY_SIDE and away from the market
+    constexpr Nanos TIMEOUT_NANOS = 10 * Common::NANOS_TO_SECS;
+
+    auto simConfig() {
+        RestOrderEntrySimulatorConfig config;
+        config.protocol = SimProtocol::BINANCE;
+        config.instruments.push_back({0, 0, "BTCUSDT", START_PRICE});
+        return config;
+    }
+
+    auto gatewayConfig(uint16_t port, const std::string& api_secret) {
+        Trading::BinanceConfig config;
+        config.api_key = "sim_api_key";
+        config.api_secret = api_secret;
+        config.rest_host_override = "127.0.0.1";
+        config.rest_port_override = std::to_string(port);
+        config.verify_peer = false;
+        return config;
+    }
+
+    auto percentile(std::vector<Nanos> samples, double p) -> Nanos {
+        if (samples.empty())
+            return -1;
+        std::sort(samples.begin(), samples.end());
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))];
+    }
+
+    auto printLatencies(const std::string& label, const std::vector<Nanos>& samples) {
+        std::cout << label << std::string(label.size() < 19 ? 19 - label.size() : 1, ' ') << "p50 "
+                  << percentile(samples, 0.5) / Common::NANOS_TO_MICROS << "us, p99 " << percentile(samples, 0.99) / Common::NANOS_TO_MICROS
+                  << "us over " << samples.size() << " orders" << std::endl;
+    }
+
+    /// A gateway pointed at the simulator, and the responses it has published so far.
+    class Session {
+    public:
+        Session(uint16_t port, const std::string& api_secret)
+            : requests_(Common::ME_MAX_CLIENT_UPDATES), responses_(Common::ME_MAX_CLIENT_UPDATES),
+              gateway_(CLIENT_ID, &requests_, &responses_, gatewayConfig(port, api_secret), {"BTCUSDT"}) {
+            gateway_.start();
+        }
+
+        ~Session() {
+            gateway_.stop();
+        }
+
+        auto send(Exchange::ClientRequestType type, Common::OrderId order_id, Common::Price price, Common::Qty qty) {
+            *requests_.getNextToWriteTo() = {type, CLIENT_ID, 0, order_id, Common::Side::BUY, price, qty};
+            requests_.updateWriteIndex();
+        }
+
+        /// Wait for a response of the given type to the order, the time it took, -1 on timeout.
+        auto waitFor(Exchange::ClientResponseType type, Common::OrderId order_id) -> Nanos {
+            const auto start = Common::getSystemNanos();
+            while (Common::getSystemNanos() - start < TIMEOUT_NANOS) {
+                for (auto response = responses_.getNextToRead(); response; response = responses_.getNextToRead()) {
+                    const auto received = *response;
+                    responses_.updateReadIndex();
+                    ++counts_[static_cast<size_t>(received.type_)];
+                    if (received.type_ == type && received.order_id_ == order_id) {
+                        last_ = received;
+                        return Common::getSystemNanos() - start;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+            return -1;
+        }
+
+        /// Wait until count responses of the given type arrived in total, false on timeout.
+        auto waitForCount(Exchange::ClientResponseType type, size_t count) {
+            const auto start = Common::getSystemNanos();
+            while (counts_[static_cast<size_t>(type)] < count && Common::getSystemNanos() - start < TIMEOUT_NANOS) {
+                for (auto response = responses_.getNextToRead(); response; response = responses_.getNextToRead()) {
+                    ++counts_[static_cast<size_t>(response->type_)];
+                    responses_.updateReadIndex();
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+            return counts_[static_cast<size_t>(type)] >= count;
+        }
+
+        auto count(Exchange::ClientResponseType type) const {
+            return counts_[static_cast<size_t>(type)];
+        }
+
+        Exchange::ClientRequestLFQueue requests_;
+        Exchange::ClientResponseLFQueue responses_;
+        Trading::BinanceOrderGatewayAdapter gateway_;
+        Exchange::MEClientResponse last_;
+        std::array<size_t, 8> counts_{};
+    };
+}
+
+int main(int argc, char **argv) {
+    const size_t num_orders = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200);
+
+    Common::Logger sim_logger("binance_rest_simulator.log");
+    bool ok = true;
+
+    {
+        RestOrderEntrySimulator sim(simConfig(), &sim_logger);
+        sim.start();
+        Session session(sim.port(), "sim_api_secret");
+        Common::OrderId next_order_id = 1;
+
+        // One order at a time - the request's time in the gateway's queue, the signed REST round trip and the response.
+        std::vector<Nanos> new_latencies, modify_latencies, cancel_latencies;
+        for (size_t i = 0; i < num_orders; ++i) {
+            const auto order_id = next_order_id++;
+            session.send(Exchange::ClientRequestType::NEW, order_id, BID_PRICE, 10);
+            new_latencies.push_back(session.waitFor(Exchange::ClientResponseType::ACCEPTED, order_id));
+            session.send(Exchange::ClientRequestType::MODIFY, order_id, BID_PRICE - 100, 10);
+            modify_latencies.push_back(session.waitFor(Exchange::ClientResponseType::ACCEPTED, order_id));
+            session.send(Exchange::ClientRequestType::CANCEL, order_id, BID_PRICE - 100, 10);
+            cancel_latencies.push_back(session.waitFor(Exchange::ClientResponseType::CANCELED, order_id));
+        }
+        for (const auto* latencies : {&new_latencies, &modify_latencies, &cancel_latencies})
+            ok &= (std::count(latencies->begin(), latencies->end(), -1) == 0);
+        printLatencies("NEW -> ACCEPTED:", new_latencies);
+        printLatencies("MODIFY -> ACCEPTED:", modify_latencies);
+        printLatencies("CANCEL -> CANCELED:", cancel_latencies);
+
+        // A burst - every request queued at once, the gateway sends them one after the other.
+        const auto burst_start = Common::getSystemNanos();
+        const auto first_burst_id = next_order_id;
+        const auto accepted = session.count(Exchange::ClientResponseType::ACCEPTED);
+        for (size_t i = 0; i < num_orders; ++i)
+            session.send(Exchange::ClientRequestType::NEW, next_order_id++, BID_PRICE, 10);
+        ok &= session.waitForCount(Exchange::ClientResponseType::ACCEPTED, accepted + num_orders);
+        const auto burst_nanos = Common::getSystemNanos() - burst_start;
+        std::cout << "Burst:             " << num_orders << " orders accepted in " << burst_nanos / Common::NANOS_TO_MILLIS << "ms ("
+                  << static_cast<size_t>(static_cast<double>(num_orders) * Common::NANOS_TO_SECS / static_cast<double>(burst_nanos))
+                  << " orders/s)" << std::endl;
+        const auto canceled = session.count(Exchange::ClientResponseType::CANCELED);
+        for (auto order_id = first_burst_id; order_id < next_order_id; ++order_id)
+            session.send(Exchange::ClientRequestType::CANCEL, order_id, BID_PRICE, 10);
+        ok &= session.waitForCount(Exchange::ClientResponseType::CANCELED, canceled + num_orders);
+
+        // Fills - trades through the resting bid of 4 and then 6, seen by the gateway's status polling thread and
+        // published by its main loop. Each part is reported once, with what is left working, even though the partially
+        // filled order is polled again before the rest fills.
+        const auto fill_order_id = next_order_id++;
+        session.send(Exchange::ClientRequestType::NEW, fill_order_id, BID_PRICE, 10);
+        ok &= (session.waitFor(Exchange::ClientResponseType::ACCEPTED, fill_order_id) > 0);
+        Exchange::MEMarketUpdate trade;
+        trade.type_ = Exchange::MarketUpdateType::TRADE;
+        trade.ticker_id_ = 0;
+        trade.side_ = Common::Side::SELL;
+        trade.price_ = BID_PRICE - 100;
+        trade.qty_ = 4;
+        sim.on_market_update(&trade);
+        const auto fill_latency = session.waitFor(Exchange::ClientResponseType::FILLED, fill_order_id);
+        const auto partial = session.last_;
+        std::this_thread::sleep_for(std::chrono::seconds(6));
+        trade.qty_ = 6;
+        sim.on_market_update(&trade);
+        session.waitFor(Exchange::ClientResponseType::FILLED, fill_order_id);
+        const auto rest = session.last_;
+        const auto num_fills = session.count(Exchange::ClientResponseType::FILLED);
+        ok &= (fill_latency > 0 && partial.exec_qty_ == 4 && partial.leaves_qty_ == 6 && partial.price_ == BID_PRICE &&
+               rest.exec_qty_ == 6 && rest.leaves_qty_ == 0 && rest.price_ == BID_PRICE && num_fills == 2);
+        std::cout << "Fill:              reported " << fill_latency / Common::NANOS_TO_MILLIS << "ms after the trade, "
+                  << partial.exec_qty_ << " then " << rest.exec_qty_ << " in " << num_fills << " fills" << std::endl;
+
+        // Every request above, exchangeInfo and the status polls included, went over the connection opened first.
+        const auto stats = sim.stats();
+        std::cout << "Connections:       " << stats.connections << " for " << stats.requests << " requests" << std::endl;
+        ok &= (stats.connections == 1 && stats.fills == 2);
+    }
+
+    // The order rate limit - a burst beyond it gets the excess rejected with 429 rather than queued.
+    {
+        auto config = simConfig();
+        config.order_rate_limit = 10;
+        RestOrderEntrySimulator sim(config, &sim_logger);
+        sim.start();
+        Session session(sim.port(), "sim_api_secret");
+        constexpr size_t BURST = 30;
+        for (Common::OrderId order_id = 1; order_id <= BURST; ++order_id)
+            session.send(Exchange::ClientRequestType::NEW, order_id, BID_PRICE, 10);
+        session.waitFor(Exchange::ClientResponseType::REJECTED, BURST);
+        const auto stats = sim.stats();
+        std::cout << "Rate limit:        " << session.count(Exchange::ClientResponseType::ACCEPTED) << " of " << BURST << " accepted, "
+                  << stats.rate_limited << " refused with 429" << std::endl;
+        ok &= (session.count(Exchange::ClientResponseType::ACCEPTED) == 10 && stats.rate_limited == BURST - 10);
+    }
+
+    // A request signed with the wrong secret - the order is rejected, nothing reaches the book.
+    {
+        RestOrderEntrySimulator sim(simConfig(), &sim_logger);
+        sim.start();
+        Session session(sim.port(), "wrong_api_secret");
+        session.send(Exchange::ClientRequestType::NEW, 1, BID_PRICE, 10);
+        const bool rejected = (session.waitFor(Exchange::ClientResponseType::REJECTED, 1) > 0);
+        const auto stats = sim.stats();
+        std::cout << "Bad signature:     " << (rejected ? "order rejected" : "order not rejected") << ", " << stats.signature_failures
+                  << " signature failures" << std::endl;
+        ok &= (rejected && stats.signature_failures == 1 && stats.orders_placed == 0);
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
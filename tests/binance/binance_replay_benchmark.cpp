@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/journal.h"
+#include "common/journal_reader.h"
+#include "common/journal_replayer.h"
+#include "trading/adapters/binance/market_data/binance_market_data_consumer.h"
+
+// Replay benchmark of the Binance market data consumer, no network needed. BINANCE_JSON records - the exchangeInfo
+// and depth snapshot REST responses and the depth and trade stream messages, as the consumer journals them - are
+// replayed into BinanceMarketDataConsumer, which parses them, keeps its order books and publishes MEMarketUpdates.
+// Reports throughput and latency per message and checks two replays publish the same updates.
+// Usage: binance_replay_benchmark [JOURNAL_DIR | NUM_MESSAGES]
+
+namespace {
+    using Common::Nanos;
+
+    const std::vector<std::string> SYMBOLS = {"BTCUSDT", "ETHUSDT"};
+    constexpr Nanos MESSAGE_SPACING = 200 * Common::NANOS_TO_MICROS;
+
+    auto price(int64_t ticks) {
+        return std::to_string(ticks / 100) + "." + (ticks % 100 < 10 ? "0" : "") + std::to_string(ticks % 100);
+    }
+
+    /// Journal of a session per symbol: scales, a few depth updates buffered before the snapshot, the snapshot and
+    /// then depth updates and trades around a random walk.
+    auto generateJournal(const std::string &dir, size_t num_messages) {
+        std::mt19937_64 rng(5);
+        std::uniform_int_distribution<int> kind(0, 9);
+        std::uniform_int_distribution<int> move(-1, 1);
+        std::uniform_int_distribution<int> level(1, 10);
+        std::uniform_int_distribution<int> qty(0, 300);
+
+        Common::JournalWriter writer(dir, "binance");
+        Nanos time = 1'700'000'000 * Common::NANOS_TO_SECS;
+        uint64_t seq = 0;
+        auto write = [&](const std::string &symbol, const std::string &stream_type, const std::string &payload) {
+            const auto record = symbol + "@" + stream_type + "\n" + payload;
+            writer.append(Common::JournalRecordType::BINANCE_JSON, 1, ++seq, time, record.data(), static_cast<uint32_t>(record.size()));
+            time += MESSAGE_SPACING;
+        };
+
+        std::vector<int64_t> mids(SYMBOLS.size(), 5'000'000);
+        std::vector<uint64_t> update_ids(SYMBOLS.size(), 98);
+        auto depth = [&](size_t index) {
+            const auto &mid = mids[index];
+            std::string bids, asks;
+            for (int i = 0; i < 2; ++i) {
+                bids += std::string(i ? "," : "") + "[\"" + price(mid - level(rng)) + "\",\"0." + std::to_string(qty(rng)) + "\"]";
+                asks += std::string(i ? "," : "") + "[\"" + price(mid + level(rng)) + "\",\"0." + std::to_string(qty(rng)) + "\"]";
+            }
+            const auto first = ++update_ids[index];
+            write(SYMBOLS[index], "depth", "{\"e\":\"depthUpdate\",\"s\":\"" + SYMBOLS[index] + "\",\"U\":" + std::to_string(first) +
+                                           ",\"u\":" + std::to_string(first) + ",\"b\":[" + bids + "],\"a\":[" + asks + "]}");
+        };
+
+        for (size_t index = 0; index < SYMBOLS.size(); ++index) {
+            write(SYMBOLS[index], "exchangeInfo", "{\"symbols\":[{\"filters\":[{\"filterType\":\"PRICE_FILTER\",\"tickSize\":\"0.01000000\"},"
+                                                  "{\"filterType\":\"LOT_SIZE\",\"stepSize\":\"0.00100000\"}]}]}");
+            for (int i = 0; i < 3; ++i)
+                depth(index);
+
+            std::string bids, asks;
+            for (int i = 1; i <= 10; ++i) {
+                bids += std::string(i > 1 ? "," : "") + "[\"" + price(mids[index] - i) + "\",\"1.000\"]";
+                asks += std::string(i > 1 ? "," : "") + "[\"" + price(mids[index] + i) + "\",\"1.000\"]";
+            }
+            write(SYMBOLS[index], "snapshot", "{\"lastUpdateId\":100,\"bids\":[" + bids + "],\"asks\":[" + asks + "]}");
+        }
+
+        while (seq < num_messages) {
+            const auto index = static_cast<size_t>(rng() % SYMBOLS.size());
+            mids[index] += move(rng);
+            if (kind(rng) < 8)
+                depth(index);
+            else
+                write(SYMBOLS[index], "trade", "{\"e\":\"trade\",\"s\":\"" + SYMBOLS[index] + "\",\"p\":\"" + price(mids[index]) +
+                                               "\",\"q\":\"0." + std::to_string(qty(rng)) + "\",\"m\":" + (rng() % 2 ? "true" : "false") + "}");
+        }
+        writer.close();
+    }
+
+    struct ReplayResult {
+        size_t num_messages_ = 0;
+        size_t num_updates_ = 0;
+        size_t checksum_ = 0;
+        std::vector<Nanos> message_nanos_;
+        Common::JournalReplayStats stats_;
+    };
+
+    auto replay(const Common::JournalReader &journal) {
+        ReplayResult result;
+        Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+        Trading::BinanceMarketDataConsumer consumer(1, &market_updates, SYMBOLS, Trading::BinanceConfig{});
+
+        Common::JournalReplayer replayer;
+        result.stats_ = replayer.replay(journal.chunk(), [&](const Common::JournalRecordHeader *record) {
+            if (record->type_ != Common::JournalRecordType::BINANCE_JSON)
+                return;
+
+            const auto start = Common::getSystemNanos();
+            if (consumer.replayJournalRecord(reinterpret_cast<const char *>(record + 1), record->length_))
+                ++result.num_messages_;
+            result.message_nanos_.push_back(Common::getSystemNanos() - start);
+
+            for (auto update = market_updates.getNextToRead(); update; update = market_updates.getNextToRead()) {
+                result.checksum_ = result.checksum_ * 31 + static_cast<size_t>(update->type_) * 7 + static_cast<size_t>(update->price_) +
+                                   static_cast<size_t>(update->qty_);
+                ++result.num_updates_;
+                market_updates.updateReadIndex();
+            }
+        });
+        return result;
+    }
+}
+
+int main(int argc, char **argv) {
+    const bool recorded = (argc > 1 && std::filesystem::is_directory(argv[1]));
+    const size_t num_messages = (argc > 1 && !recorded ? std::strtoull(argv[1], nullptr, 10) : 50'000);
+
+    auto dir = std::filesystem::temp_directory_path() / ("binance_replay_benchmark_" + std::to_string(getpid()));
+    if (recorded) {
+        dir = argv[1];
+    } else {
+        std::filesystem::create_directories(dir);
+        generateJournal(dir, num_messages);
+    }
+
+    Common::JournalReader journal(dir);
+    auto first = replay(journal);
+    const auto second = replay(journal);
+    const bool deterministic = (first.num_updates_ == second.num_updates_ && first.checksum_ == second.checksum_);
+
+    std::sort(first.message_nanos_.begin(), first.message_nanos_.end());
+    const auto percentile = [&](double fraction) {
+        return first.message_nanos_.empty() ? Nanos{0} : first.message_nanos_[static_cast<size_t>(fraction * static_cast<double>(first.message_nanos_.size() - 1))];
+    };
+    const auto wall = static_cast<double>(std::max<Nanos>(1, first.stats_.wall_time_));
+    std::cout << "Messages:         " << first.num_messages_ << " -> " << first.num_updates_ << " market updates" << std::endl;
+    std::cout << "Per message:      p50 " << percentile(0.5) << "ns p99 " << percentile(0.99) << "ns" << std::endl;
+    std::cout << "Throughput:       " << static_cast<size_t>(static_cast<double>(first.num_messages_) * 1e9 / wall) << " messages/s, "
+              << static_cast<double>(first.stats_.journal_time_) / wall << "x real time" << std::endl;
+    std::cout << "Deterministic:    " << (deterministic ? "yes" : "NO") << std::endl;
+
+    if (!recorded)
+        std::filesystem::remove_all(dir);
+
+    const auto ok = deterministic && first.num_updates_ > 0;
+    std::cout << "Result:           " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
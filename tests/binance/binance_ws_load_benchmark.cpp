@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/time_utils.h"
+#include "trading/adapters/sim/ws_exchange_simulator.h"
+#include "trading/adapters/binance/market_data/binance_market_data_consumer.h"
+
+// Load benchmark of the Binance market data consumer against the local Binance simulator, no network needed - the
+// simulator serves the depth and trade streams and the exchangeInfo and depth snapshot REST endpoints on one port.
+// Measures the consumer's start-up cost, its throughput when the feed saturates it, the highest message rate it keeps
+// up with (rates doubling until its backlog no longer drains), how fast it resynchronises after an update id gap,
+// whether it survives a dropped connection and how long a consumer falling behind lasts before the venue drops it.
+// Usage: binance_ws_load_benchmark [STEP_MILLIS]
+
+namespace {
+    using namespace Adapter::Sim;
+    using Common::Nanos;
+
+    const std::vector<std::string> SYMBOLS = {"BTCUSDT", "ETHUSDT"};
+    constexpr Nanos QUIET_NANOS = 200 * Common::NANOS_TO_MILLIS;
+    constexpr Nanos TIMEOUT_NANOS = 10 * Common::NANOS_TO_SECS;
+
+    auto simConfig(size_t messages_per_second) {
+        WsExchangeSimulatorConfig config;
+        config.protocol = SimProtocol::BINANCE;
+        config.messages_per_second = messages_per_second;
+        for (const auto &symbol : SYMBOLS)
+            config.instruments.push_back({static_cast<Common::TickerId>(config.instruments.size()), 0, symbol, 5'000'000});
+        return config;
+    }
+
+    auto secondsSince(Nanos start) {
+        return static_cast<double>(Common::getSystemNanos() - start) / Common::NANOS_TO_SECS;
+    }
+
+    auto idle() {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    auto consumerConfig(uint16_t port) {
+        Trading::BinanceConfig config;
+        config.ws_host_override = config.rest_host_override = "127.0.0.1";
+        config.ws_port_override = config.rest_port_override = std::to_string(port);
+        config.verify_peer = false;
+        return config;
+    }
+
+    /// A consumer of the simulator and the market updates it has published so far.
+    class Feed {
+    public:
+        Feed(uint16_t port, Common::ClientId client_id)
+            : updates_(Common::ME_MAX_MARKET_UPDATES), consumer_(client_id, &updates_, SYMBOLS, consumerConfig(port)) {
+        }
+
+        /// Start the consumer, the time until the first update arrived, -1 on timeout.
+        auto connect() -> Nanos {
+            const auto start = Common::getSystemNanos();
+            consumer_.start();
+            while (!drain() && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+                idle();
+            return num_updates_ ? Common::getSystemNanos() - start : -1;
+        }
+
+        /// Updates published since the last call, counting the CLEARs which start every order book (re)initialisation.
+        auto drain() -> size_t {
+            size_t count = 0;
+            for (auto update = updates_.getNextToRead(); update; update = updates_.getNextToRead()) {
+                num_clears_ += (update->type_ == Exchange::MarketUpdateType::CLEAR);
+                ++count;
+                updates_.updateReadIndex();
+            }
+            num_updates_ += count;
+            return count;
+        }
+
+        /// Drain until no update arrived for QUIET_NANOS, the time it took to go quiet.
+        auto drainUntilQuiet() -> Nanos {
+            const auto start = Common::getSystemNanos();
+            auto last = start;
+            while (Common::getSystemNanos() - last < QUIET_NANOS) {
+                if (drain())
+                    last = Common::getSystemNanos();
+                idle();
+            }
+            return last - start;
+        }
+
+        auto runFor(Nanos nanos) {
+            const auto start = Common::getSystemNanos();
+            while (Common::getSystemNanos() - start < nanos) {
+                drain();
+                idle();
+            }
+        }
+
+        Exchange::MEMarketUpdateLFQueue updates_;
+        Trading::BinanceMarketDataConsumer consumer_;
+        size_t num_updates_ = 0;
+        size_t num_clears_ = 0;
+    };
+}
+
+int main(int argc, char **argv) {
+    const Nanos step = (argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 1'000) * Common::NANOS_TO_MILLIS;
+
+    Common::Logger sim_logger("binance_ws_simulator.log");
+    Common::ClientId client_id = 1;
+    bool ok = true;
+
+    // Saturation - the simulator keeps a few messages queued per stream, the consumer drains them as fast as it can.
+    double saturated_messages = 0;
+    {
+        WsExchangeSimulator sim(simConfig(0), &sim_logger);
+        sim.start();
+        Feed feed(sim.port(), client_id++);
+        const auto first_update = feed.connect();
+        ok &= (first_update > 0);
+
+        const auto start = Common::getSystemNanos();
+        const auto sent = sim.stats().messages_sent;
+        const auto updates = feed.num_updates_;
+        feed.runFor(2 * step);
+        const auto seconds = secondsSince(start);
+        saturated_messages = static_cast<double>(sim.stats().messages_sent - sent) / seconds;
+        std::cout << "Start:            " << first_update / Common::NANOS_TO_MILLIS << "ms to the first update ("
+                  << SYMBOLS.size() << " symbols)" << std::endl;
+        std::cout << "Saturated:        " << static_cast<size_t>(saturated_messages) << " messages/s, "
+                  << static_cast<size_t>(static_cast<double>(feed.num_updates_ - updates) / seconds) << " updates/s" << std::endl;
+        ok &= (feed.num_updates_ > updates);
+    }
+
+    // Rates doubling until the consumer's backlog takes more than a tenth of the step to drain.
+    {
+        WsExchangeSimulator sim(simConfig(1), &sim_logger);
+        sim.start();
+        Feed feed(sim.port(), client_id++);
+        ok &= (feed.connect() > 0);
+        feed.drainUntilQuiet();
+
+        size_t sustained = 0;
+        for (size_t rate = 250; rate <= 512'000; rate *= 2) {
+            const auto generated = sim.stats().messages_generated;
+            sim.set_messages_per_second(rate);
+            feed.runFor(step);
+            sim.set_messages_per_second(1);
+            const auto lag = feed.drainUntilQuiet();
+            const auto messages = sim.stats().messages_generated - generated;
+            const bool kept_up = (lag < step / 10);
+            const auto label = "Rate " + std::to_string(rate) + "/s:";
+            std::cout << label << std::string(label.size() < 18 ? 18 - label.size() : 1, ' ') << messages << " depth messages, backlog drained in "
+                      << lag / Common::NANOS_TO_MILLIS << "ms" << (kept_up ? "" : " - falling behind") << std::endl;
+            if (!kept_up)
+                break;
+            sustained = rate;
+        }
+        std::cout << "Sustained:        " << sustained << " depth messages/s" << std::endl;
+    }
+
+    // Update id gaps - every one has to bring a depth snapshot request and a fresh book.
+    {
+        auto config = simConfig(500);
+        config.gap_every = 100;
+        WsExchangeSimulator sim(config, &sim_logger);
+        sim.start();
+        Feed feed(sim.port(), client_id++);
+        ok &= (feed.connect() > 0);
+        const auto clears = feed.num_clears_;
+        feed.runFor(3 * step);
+        sim.set_messages_per_second(1);
+        feed.drainUntilQuiet();
+
+        const auto stats = sim.stats();
+        std::cout << "Gaps:             " << stats.gaps << " injected, " << stats.resyncs << " snapshots requested, "
+                  << feed.num_clears_ - clears << " books rebuilt, gap to request avg "
+                  << (stats.resyncs ? stats.resync_time / static_cast<Nanos>(stats.resyncs) / Common::NANOS_TO_MICROS : 0) << "us max "
+                  << stats.max_resync_time / Common::NANOS_TO_MICROS << "us" << std::endl;
+        ok &= (stats.gaps > 0 && stats.resyncs > 0);
+    }
+
+    // A dropped connection - whether the consumer comes back by itself, otherwise what a restart by its owner costs.
+    {
+        auto config = simConfig(500);
+        config.disconnect_every = 200;
+        WsExchangeSimulator sim(config, &sim_logger);
+        sim.start();
+        {
+            Feed feed(sim.port(), client_id++);
+            ok &= (feed.connect() > 0);
+            const auto start = Common::getSystemNanos();
+            while (!sim.stats().disconnects && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+                feed.runFor(Common::NANOS_TO_MILLIS);
+
+            // The consumer's own reconnect, if it has one, gets a few seconds.
+            feed.runFor(3 * Common::NANOS_TO_SECS);
+            const auto stats = sim.stats();
+            std::cout << "Dropped:          " << stats.disconnects << " connections dropped, " << stats.reconnects
+                      << (stats.reconnects ? " reconnected by the consumer" : " - the consumer does not reconnect by itself") << std::endl;
+        }
+
+        Feed feed(sim.port(), client_id++);
+        const auto first_update = feed.connect();
+        ok &= (first_update > 0);
+        std::cout << "Restart:          " << first_update / Common::NANOS_TO_MILLIS << "ms to the first update" << std::endl;
+    }
+
+    // A consumer falling behind - the feed at several times what it sustains until its backlog gets it dropped.
+    {
+        auto config = simConfig(std::max<size_t>(5'000, static_cast<size_t>(4 * saturated_messages)));
+        config.max_backlog = 200;
+        WsExchangeSimulator sim(config, &sim_logger);
+        sim.start();
+        Feed feed(sim.port(), client_id++);
+        ok &= (feed.connect() > 0);
+        const auto start = Common::getSystemNanos();
+        while (!sim.stats().slow_consumer_drops && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+            feed.runFor(Common::NANOS_TO_MILLIS);
+        const auto stats = sim.stats();
+        std::cout << "Slow consumer:    " << (stats.slow_consumer_drops ? "dropped after " : "not dropped in ")
+                  << (Common::getSystemNanos() - start) / Common::NANOS_TO_MILLIS << "ms at " << config.messages_per_second
+                  << " messages/s, backlog " << stats.max_backlog << std::endl;
+    }
+
+    std::cout << "Result:           " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
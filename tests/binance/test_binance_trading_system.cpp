@@ -10,6 +10,7 @@
 #include "common/logging.h"
 #include "common/macros.h"
 #include "common/lf_queue.h"
+#include "common/journal_recorder.h"
 #include "common/types.h"
 
 #include "exchange/order_server/client_request.h"
@@ -39,10 +40,11 @@ int main(int argc, char **argv) {
     signal(SIGINT, signal_handler);
     
     if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <client_id> <symbol> [price_threshold] [order_size]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <client_id> <symbol> [price_threshold] [order_size] [journal_dir]" << std::endl;
         std::cerr << "Example: " << argv[0] << " 1 BTCUSDT 1.0 0.001" << std::endl;
         std::cerr << "  price_threshold: Threshold for market maker algorithm (default: 1.0)" << std::endl;
         std::cerr << "  order_size: Order size in base currency units (default: 0.001)" << std::endl;
+        std::cerr << "  journal_dir: Record raw and normalized market data and order traffic to journal files here (default: off)" << std::endl;
         return 1;
     }
     
@@ -50,6 +52,7 @@ int main(int argc, char **argv) {
     std::string symbol = argv[2];
     double price_threshold = (argc > 3) ? std::stod(argv[3]) : 1.0;
     double order_size = (argc > 4) ? std::stod(argv[4]) : 0.001;
+    std::string journal_dir = (argc > 5) ? argv[5] : "";
 
     std::vector<std::string> symbols = {symbol};
 
@@ -94,6 +97,20 @@ int main(int argc, char **argv) {
         Exchange::ClientRequestLFQueue client_requests(100);
         Exchange::ClientResponseLFQueue client_responses(100);
         Exchange::MEMarketUpdateLFQueue market_updates(100);
+
+        // Optional journal of everything passing through the queues and the raw Binance messages
+        std::unique_ptr<Common::JournalRecorder> journal;
+        Common::JournalByteRing *raw_journal = nullptr;
+        if (!journal_dir.empty()) {
+            std::filesystem::create_directories(journal_dir);
+            journal = std::make_unique<Common::JournalRecorder>(journal_dir, "binance_" + std::to_string(client_id),
+                                                                Common::JOURNAL_DEFAULT_FILE_SIZE, logger);
+            raw_journal = journal->addRawStream("binance_raw");
+            journal->tap("market_updates", Common::JournalRecordType::MARKET_UPDATE, &market_updates);
+            journal->tap("client_requests", Common::JournalRecordType::CLIENT_REQUEST, &client_requests);
+            journal->tap("client_responses", Common::JournalRecordType::CLIENT_RESPONSE, &client_responses);
+            journal->start();
+        }
         
         // Setup ticker configuration
         // For this test, we'll use simple configuration for a single symbol
@@ -107,7 +124,8 @@ int main(int argc, char **argv) {
                 static_cast<Common::Qty>(100), // Max order size - use fixed value
                 static_cast<Common::Qty>(1000), // Larger max position - use fixed value
                 -10000.0                        // Larger max loss allowance
-            }
+            },
+            {}                                 // Default quote ladder
         };
         
         // Log the ticker configuration to verify it's correct
@@ -133,6 +151,7 @@ int main(int argc, char **argv) {
         // Create BinanceMarketDataConsumer
         logger->log("%:% %() % Starting Market Data Consumer...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
         market_data_consumer = new Trading::BinanceMarketDataConsumer(client_id, &market_updates, symbols, config);
+        market_data_consumer->setJournal(raw_journal);
         market_data_consumer->start();
         
         // Wait for initial market data
@@ -232,6 +251,11 @@ int main(int argc, char **argv) {
         
         using namespace std::literals::chrono_literals;
         std::this_thread::sleep_for(10s);
+
+        if (journal) {
+            journal->stop();
+            std::cout << "Journaled " << journal->numRecords() << " records, lost " << journal->numLost() << std::endl;
+        }
         
         delete logger;
         logger = nullptr;
@@ -0,0 +1,171 @@
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/time_utils.h"
+#include "trading/backtest/backtester.h"
+
+// Benchmark of the backtester on a synthetic session as long as an NSE trading day (09:15 - 15:30).
+// Every ticker has a one order touch on each side which moves in a random walk, trades against it and changes size.
+// The same configuration is run twice and has to give the same result, then a sweep of configurations is run over all
+// cores, where the runs of that configuration have to give the same result again.
+// Usage: backtest_benchmark [NUM_EVENTS] [NUM_SWEEP_RUNS]
+
+namespace {
+    using namespace Trading;
+
+    constexpr Common::Nanos SESSION_NANOS = (6 * 3600 + 15 * 60) * Common::NANOS_TO_SECS;
+
+    struct Touch {
+        Common::Price mid_ = 100'000;
+        std::array<Common::OrderId, 2> order_ids_ = {Common::OrderId_INVALID, Common::OrderId_INVALID};
+        std::array<Common::Qty, 2> qtys_ = {};
+    };
+
+    auto generateSession(size_t num_events) {
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<Common::TickerId> ticker(0, Common::ME_MAX_TICKERS - 1);
+        std::uniform_int_distribution<int> action(0, 99);
+        std::uniform_int_distribution<int> move(-1, 1);
+        std::uniform_int_distribution<Common::Qty> qty(1, 200);
+
+        std::vector<BacktestEvent> events;
+        events.reserve(num_events + 2 * Common::ME_MAX_TICKERS);
+        std::vector<Touch> touches(Common::ME_MAX_TICKERS);
+        const auto start_time = Common::getSystemNanos();
+        Common::OrderId next_order_id = 1;
+
+        // New order at the touch, the caller cancels the one it replaces afterwards so the book stays two sided.
+        auto add = [&](Common::Nanos time, Common::TickerId ticker_id, Touch &touch, size_t side_index) {
+            const auto side = (side_index ? Common::Side::SELL : Common::Side::BUY);
+            const auto price = touch.mid_ + (side_index ? 1 : -1);
+            const auto order_id = next_order_id++;
+            touch.qtys_[side_index] = qty(rng);
+            events.emplace_back(time, Exchange::MEMarketUpdate{Exchange::MarketUpdateType::ADD, order_id, ticker_id, side, price,
+                                                               touch.qtys_[side_index], order_id});
+            touch.order_ids_[side_index] = order_id;
+        };
+
+        for (Common::TickerId ticker_id = 0; ticker_id < Common::ME_MAX_TICKERS; ++ticker_id) {
+            add(start_time, ticker_id, touches[ticker_id], 0);
+            add(start_time, ticker_id, touches[ticker_id], 1);
+        }
+
+        for (size_t i = 0; events.size() < num_events; ++i) {
+            const auto time = start_time + static_cast<Common::Nanos>(i * (SESSION_NANOS / num_events));
+            const auto ticker_id = ticker(rng);
+            auto &touch = touches[ticker_id];
+            const auto kind = action(rng);
+
+            if (kind < 40) {
+                // Touch moves by up to a tick.
+                const auto old_mid = touch.mid_;
+                touch.mid_ += move(rng);
+                for (size_t side_index = 0; side_index < 2; ++side_index) {
+                    const auto old_order_id = touch.order_ids_[side_index];
+                    add(time, ticker_id, touch, side_index);
+                    events.emplace_back(time, Exchange::MEMarketUpdate{Exchange::MarketUpdateType::CANCEL, old_order_id, ticker_id,
+                                                                       side_index ? Common::Side::SELL : Common::Side::BUY,
+                                                                       old_mid + (side_index ? 1 : -1), 0, 0});
+                }
+            } else if (kind < 70) {
+                // Aggressive trade against one side, the passive order is reduced straight after.
+                const size_t side_index = action(rng) % 2;
+                const auto passive_side = (side_index ? Common::Side::SELL : Common::Side::BUY);
+                const auto price = touch.mid_ + (side_index ? 1 : -1);
+                const auto trade_qty = std::min(qty(rng), touch.qtys_[side_index]);
+                events.emplace_back(time, Exchange::MEMarketUpdate{Exchange::MarketUpdateType::TRADE, Common::OrderId_INVALID, ticker_id,
+                                                                   side_index ? Common::Side::BUY : Common::Side::SELL, price, trade_qty, 0});
+                touch.qtys_[side_index] -= trade_qty;
+                if (touch.qtys_[side_index]) {
+                    events.emplace_back(time, Exchange::MEMarketUpdate{Exchange::MarketUpdateType::MODIFY, touch.order_ids_[side_index], ticker_id,
+                                                                       passive_side, price, touch.qtys_[side_index], 0});
+                } else {
+                    const auto old_order_id = touch.order_ids_[side_index];
+                    add(time, ticker_id, touch, side_index);
+                    events.emplace_back(time, Exchange::MEMarketUpdate{Exchange::MarketUpdateType::CANCEL, old_order_id, ticker_id,
+                                                                       passive_side, price, 0, 0});
+                }
+            } else {
+                // Size at the touch changes.
+                const size_t side_index = action(rng) % 2;
+                touch.qtys_[side_index] = qty(rng);
+                events.emplace_back(time, Exchange::MEMarketUpdate{Exchange::MarketUpdateType::MODIFY, touch.order_ids_[side_index], ticker_id,
+                                                                   side_index ? Common::Side::SELL : Common::Side::BUY,
+                                                                   touch.mid_ + (side_index ? 1 : -1), touch.qtys_[side_index], 0});
+            }
+        }
+        return events;
+    }
+
+    auto makeCfg(Common::Qty clip, Common::Price hysteresis) {
+        BacktestCfg cfg;
+        cfg.algo_type_ = Common::AlgoType::MAKER;
+        for (auto &ticker_cfg : cfg.ticker_cfg_) {
+            ticker_cfg.clip_ = clip;
+            ticker_cfg.risk_cfg_.max_order_size_ = 1'000;
+            ticker_cfg.risk_cfg_.max_position_ = clip * 10;
+            ticker_cfg.risk_cfg_.max_loss_ = -1e12;
+            ticker_cfg.quote_cfg_.num_levels_ = 3;
+            ticker_cfg.quote_cfg_.horizon_ = 10;
+            ticker_cfg.quote_cfg_.hysteresis_ = hysteresis;
+        }
+        return cfg;
+    }
+
+    auto sameOutcome(const BacktestResult &lhs, const BacktestResult &rhs) {
+        return lhs.num_requests_ == rhs.num_requests_ && lhs.num_fills_ == rhs.num_fills_ &&
+               lhs.traded_qty_ == rhs.traded_qty_ && lhs.positions_ == rhs.positions_ && lhs.total_pnl_ == rhs.total_pnl_;
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t num_events = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200'000);
+    const size_t num_sweep_runs = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4);
+
+    const auto events = generateSession(num_events);
+    std::cout << "Events:        " << events.size() << " over " << SESSION_NANOS / Common::NANOS_TO_SECS << "s" << std::endl;
+
+    const auto cfg = makeCfg(10, 1);
+    BacktestResult first, second;
+    {
+        Backtester backtester(1, cfg);
+        first = backtester.run(events.data(), events.size());
+    }
+    {
+        Backtester backtester(1, cfg);
+        second = backtester.run(events.data(), events.size());
+    }
+    const auto deterministic = sameOutcome(first, second);
+    const auto wall_secs = static_cast<double>(first.wall_time_) / Common::NANOS_TO_SECS;
+
+    std::cout << "Single run:    " << first.toString() << std::endl;
+    std::cout << "Deterministic: " << (deterministic ? "yes" : "NO") << std::endl;
+    std::cout << "Events/sec:    " << static_cast<size_t>(events.size() / wall_secs) << std::endl;
+    std::cout << "Speed up:      " << static_cast<double>(first.simulated_time_) / first.wall_time_ << "x real time" << std::endl;
+
+    std::vector<BacktestCfg> cfgs;
+    for (size_t i = 0; i < num_sweep_runs; ++i)
+        cfgs.push_back(makeCfg(static_cast<Common::Qty>(10 * (1 + i % 2)), static_cast<Common::Price>(i / 2)));
+
+    const auto sweep_start = Common::getSystemNanos();
+    const auto results = runBacktestSweep(events, cfgs);
+    const auto sweep_time = Common::getSystemNanos() - sweep_start;
+    bool sweep_matches = (results.size() == cfgs.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto &ticker_cfg = cfgs[i].ticker_cfg_[0];
+        if (ticker_cfg.clip_ == cfg.ticker_cfg_[0].clip_ && ticker_cfg.quote_cfg_.hysteresis_ == cfg.ticker_cfg_[0].quote_cfg_.hysteresis_)
+            sweep_matches &= sameOutcome(results[i], first);
+        std::cout << "Sweep run " << i << ":   clip:" << ticker_cfg.clip_ << " hysteresis:"
+                  << ticker_cfg.quote_cfg_.hysteresis_ << " " << results[i].toString() << std::endl;
+    }
+    std::cout << "Sweep:         " << results.size() << " runs on " << std::thread::hardware_concurrency() << " cores in "
+              << sweep_time / Common::NANOS_TO_MILLIS << "ms, " << (sweep_matches ? "matching" : "NOT MATCHING")
+              << " the single runs" << std::endl;
+
+    const auto ok = (deterministic && sweep_matches);
+    std::cout << "Result:        " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
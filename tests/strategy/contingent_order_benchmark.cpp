@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "trading/strategy/contingent_order_manager.h"
+#include "trading/strategy/order_manager.h"
+#include "trading/strategy/trade_engine.h"
+
+// Benchmark of stop trigger evaluation in the ContingentOrderManager on every book update.
+// Keeps a number of brackets (half with trailing stops) working on every ticker while the mid of each ticker follows a
+// random walk. Entries and stop exits fill straight away, targets rest, cancels are acknowledged straight away.
+// After every update no armed stop may be through its level - every stop has to fire on the update which crossed it.
+// Also checks a target which fills while its cancel is in flight is not over-executed by the stop's exit, and a
+// bracket whose exit is cancelled part filled sends its target again for the quantity still open.
+// Usage: contingent_order_benchmark [NUM_BOOK_UPDATES] [BRACKETS_PER_TICKER]
+
+namespace {
+    using namespace Trading;
+
+    struct SimulatedExchange {
+        OrderManager *order_manager_;
+        ContingentOrderManager *contingent_orders_;
+
+        auto respond(const ::Exchange::MEClientRequest *request, ::Exchange::ClientResponseType type, Common::Qty exec_qty,
+                     Common::Qty leaves_qty) {
+            const ::Exchange::MEClientResponse response{type, ::Exchange::ClientResponseRejectReason::INVALID,
+                                                        request->client_id_, request->ticker_id_, request->order_id_,
+                                                        request->side_, request->price_, exec_qty, leaves_qty};
+            order_manager_->onOrderUpdate(&response);
+            contingent_orders_->onOrderUpdate(&response);
+        }
+
+        // Answer requests until the responses stop generating new ones
+        auto drain(::Exchange::ClientRequestLFQueue &client_requests) {
+            size_t num_requests = 0;
+            for (auto request = client_requests.getNextToRead(); request; request = client_requests.getNextToRead()) {
+                const auto copy = *request;
+                client_requests.updateReadIndex();
+                ++num_requests;
+
+                auto parent = contingent_orders_->getOrder(copy.order_id_);
+                switch (copy.type_) {
+                    case ::Exchange::ClientRequestType::NEW:
+                        respond(&copy, ::Exchange::ClientResponseType::ACCEPTED, 0, copy.qty_);
+                        if (!parent || parent->target_order_id_ != copy.order_id_)
+                            respond(&copy, ::Exchange::ClientResponseType::FILLED, copy.qty_, 0);
+                        break;
+                    case ::Exchange::ClientRequestType::CANCEL:
+                        respond(&copy, ::Exchange::ClientResponseType::CANCELED, 0, 0);
+                        break;
+                    case ::Exchange::ClientRequestType::MODIFY:
+                        respond(&copy, ::Exchange::ClientResponseType::ACCEPTED, 0, copy.qty_);
+                        break;
+                    case ::Exchange::ClientRequestType::INVALID:
+                        break;
+                }
+            }
+            return num_requests;
+        }
+    };
+
+    auto crossed(const ContingentOrder *order, const BBO &bbo) {
+        return order->exit_side_ == Common::Side::SELL ? bbo.bid_price_ <= order->stop_price_ : bbo.ask_price_ >= order->stop_price_;
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t num_updates = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200'000);
+    const size_t brackets_per_ticker = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64);
+
+    Common::TradeEngineCfgHashMap ticker_cfg;
+    for (auto& cfg : ticker_cfg) {
+        cfg.risk_cfg_.max_order_size_ = 1'000;
+        cfg.risk_cfg_.max_position_ = 1'000'000'000;
+        cfg.risk_cfg_.max_loss_ = -1e12;
+    }
+
+    ::Exchange::ClientRequestLFQueue client_requests(Common::ME_MAX_CLIENT_UPDATES);
+    ::Exchange::ClientResponseLFQueue client_responses(Common::ME_MAX_CLIENT_UPDATES);
+    ::Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+    auto trade_engine = std::make_unique<TradeEngine>(1, Common::AlgoType::INVALID, ticker_cfg,
+                                                      &client_requests, &client_responses, &market_updates);
+
+    Common::Logger logger("contingent_order_benchmark.log");
+    auto position_keeper = std::make_unique<PositionKeeper>(&logger);
+    auto risk_manager = std::make_unique<RiskManager>(&logger, position_keeper.get(), ticker_cfg);
+    auto order_manager = std::make_unique<OrderManager>(&logger, trade_engine.get(), *risk_manager);
+    auto contingent_orders = std::make_unique<ContingentOrderManager>(&logger, order_manager.get());
+    SimulatedExchange exchange{order_manager.get(), contingent_orders.get()};
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<Common::TickerId> ticker(0, Common::ME_MAX_TICKERS - 1);
+    std::uniform_int_distribution<int> move(-3, 3);
+    std::uniform_int_distribution<int> distance(5, 50);
+
+    std::vector<BBO> bbos(Common::ME_MAX_TICKERS);
+    std::vector<std::vector<ContingentOrder *>> brackets(Common::ME_MAX_TICKERS);
+    for (auto& bbo : bbos) {
+        bbo.bid_price_ = 99'999;
+        bbo.ask_price_ = 100'001;
+    }
+
+    std::vector<Common::Nanos> quiet_times, firing_times;
+    quiet_times.reserve(num_updates);
+    size_t num_fired = 0, num_late = 0, num_requests = 0;
+
+    for (size_t i = 0; i < num_updates; ++i) {
+        const auto ticker_id = ticker(rng);
+        auto& bbo = bbos[ticker_id];
+        auto& ticker_brackets = brackets[ticker_id];
+
+        // Top up the brackets on this ticker, entering at the touch.
+        while (ticker_brackets.size() < brackets_per_ticker) {
+            const auto is_buy = (ticker_brackets.size() % 2 == 0);
+            const auto trail = (ticker_brackets.size() % 4 < 2 ? distance(rng) : 0);
+            const auto entry = is_buy ? bbo.ask_price_ : bbo.bid_price_;
+            const auto stop = is_buy ? entry - distance(rng) : entry + distance(rng);
+            const auto target = is_buy ? entry + 10 * distance(rng) : entry - 10 * distance(rng);
+            auto bracket = contingent_orders->newBracket(ticker_id, is_buy ? Common::Side::BUY : Common::Side::SELL,
+                                                         entry, 1, target, stop, trail);
+            if (!bracket)
+                break;
+            ticker_brackets.push_back(bracket);
+        }
+        num_requests += exchange.drain(client_requests);
+
+        const auto mid_move = move(rng);
+        bbo.bid_price_ += mid_move;
+        bbo.ask_price_ += mid_move;
+
+        const auto armed = contingent_orders->numArmed(ticker_id, Common::Side::SELL) + contingent_orders->numArmed(ticker_id, Common::Side::BUY);
+        const auto start = Common::getCurrentNanos();
+        contingent_orders->onOrderBookUpdate(ticker_id, &bbo);
+        const auto elapsed = Common::getCurrentNanos() - start;
+        const auto fired = armed - contingent_orders->numArmed(ticker_id, Common::Side::SELL) - contingent_orders->numArmed(ticker_id, Common::Side::BUY);
+        (fired ? firing_times : quiet_times).push_back(elapsed);
+        num_fired += fired;
+
+        num_requests += exchange.drain(client_requests);
+
+        // Nothing left armed may be through its level, and finished brackets make room for new ones.
+        std::erase_if(ticker_brackets, [&](ContingentOrder *bracket) {
+            if (bracket->state_ == ContingentState::DONE)
+                return true;
+            num_late += (bracket->armed_ && crossed(bracket, bbo));
+            return false;
+        });
+    }
+
+    std::sort(quiet_times.begin(), quiet_times.end());
+    std::sort(firing_times.begin(), firing_times.end());
+    auto percentile = [](const std::vector<Common::Nanos>& times, size_t per_mille) {
+        return times.empty() ? 0 : times[times.size() * per_mille / 1000];
+    };
+
+    std::cout << "Book updates:          " << num_updates << " (" << brackets_per_ticker << " brackets per ticker)" << std::endl;
+    std::cout << "Stops fired:           " << num_fired << std::endl;
+    std::cout << "Stops late:            " << num_late << std::endl;
+    std::cout << "Requests:              " << num_requests << std::endl;
+    std::cout << "Update without fires:  p50:" << percentile(quiet_times, 500) << " p99:" << percentile(quiet_times, 990) << " ns" << std::endl;
+    std::cout << "Update with fires:     p50:" << percentile(firing_times, 500) << " p99:" << percentile(firing_times, 990) << " ns" << std::endl;
+
+    // Target filling while its cancel is in flight - the exit is held until the target is dead and only sent for what
+    // is still open, so target and exit together never sell more than the 10 long.
+    size_t num_over_executed = 0;
+    for (const Common::Qty target_fill : {4, 10}) {
+        auto keeper = std::make_unique<PositionKeeper>(&logger);
+        auto risk = std::make_unique<RiskManager>(&logger, keeper.get(), ticker_cfg);
+        auto manager = std::make_unique<OrderManager>(&logger, trade_engine.get(), *risk);
+        auto contingent = std::make_unique<ContingentOrderManager>(&logger, manager.get());
+        while (client_requests.getNextToRead())
+            client_requests.updateReadIndex();
+
+        Common::Qty sold = 0;
+        auto respond = [&](const ::Exchange::MEClientRequest &request, ::Exchange::ClientResponseType type,
+                           Common::Qty exec_qty, Common::Qty leaves_qty) {
+            const ::Exchange::MEClientResponse response{type, ::Exchange::ClientResponseRejectReason::INVALID,
+                                                        request.client_id_, request.ticker_id_, request.order_id_,
+                                                        request.side_, request.price_, exec_qty, leaves_qty};
+            manager->onOrderUpdate(&response);
+            contingent->onOrderUpdate(&response);
+            sold += exec_qty;
+        };
+        auto next_request = [&] {
+            ::Exchange::MEClientRequest request;
+            if (auto next = client_requests.getNextToRead()) {
+                request = *next;
+                client_requests.updateReadIndex();
+            }
+            return request;
+        };
+
+        contingent->newOco(0, Common::Side::BUY, 10, 110, 95);
+        const auto target = next_request();
+        respond(target, ::Exchange::ClientResponseType::ACCEPTED, 0, target.qty_);
+
+        BBO bbo;
+        bbo.bid_price_ = 95;
+        bbo.ask_price_ = 96;
+        contingent->onOrderBookUpdate(0, &bbo);
+        const auto cancel = next_request();
+        bool ok = (cancel.type_ == ::Exchange::ClientRequestType::CANCEL && cancel.order_id_ == target.order_id_ &&
+                   !client_requests.getNextToRead());
+
+        // The target fills before the cancel lands, partially (then the cancel goes through) or completely.
+        respond(target, target_fill < 10 ? ::Exchange::ClientResponseType::PARTIALLY_FILLED : ::Exchange::ClientResponseType::FILLED,
+                target_fill, 10 - target_fill);
+        if (target_fill < 10)
+            respond(target, ::Exchange::ClientResponseType::CANCELED, 0, 0);
+
+        const auto exit = next_request();
+        if (target_fill < 10) {
+            ok &= (exit.type_ == ::Exchange::ClientRequestType::NEW && exit.side_ == Common::Side::SELL &&
+                   exit.qty_ == 10 - target_fill && exit.price_ == 95);
+            respond(exit, ::Exchange::ClientResponseType::FILLED, exit.qty_, 0);
+        } else {
+            ok &= (exit.type_ == ::Exchange::ClientRequestType::INVALID);
+        }
+        ok &= (sold == 10 && !contingent->numArmed(0, Common::Side::SELL));
+        std::cout << "Target fill in race:   " << target_fill << " of 10, exit " << (exit.type_ == ::Exchange::ClientRequestType::NEW ? exit.qty_ : 0)
+                  << ", sold " << sold << (ok ? "" : " FAILED") << std::endl;
+        num_over_executed += !ok;
+    }
+
+    // Bracket exit dying with part of the position still open - the market is back above the stop when the exit is
+    // cancelled, so the stop is armed again and the target fire() cancelled is sent again for what is still open.
+    bool target_restored = true;
+    {
+        auto keeper = std::make_unique<PositionKeeper>(&logger);
+        auto risk = std::make_unique<RiskManager>(&logger, keeper.get(), ticker_cfg);
+        auto manager = std::make_unique<OrderManager>(&logger, trade_engine.get(), *risk);
+        auto contingent = std::make_unique<ContingentOrderManager>(&logger, manager.get());
+        while (client_requests.getNextToRead())
+            client_requests.updateReadIndex();
+
+        auto respond = [&](const ::Exchange::MEClientRequest &request, ::Exchange::ClientResponseType type,
+                           Common::Qty exec_qty, Common::Qty leaves_qty) {
+            const ::Exchange::MEClientResponse response{type, ::Exchange::ClientResponseRejectReason::INVALID,
+                                                        request.client_id_, request.ticker_id_, request.order_id_,
+                                                        request.side_, request.price_, exec_qty, leaves_qty};
+            manager->onOrderUpdate(&response);
+            contingent->onOrderUpdate(&response);
+        };
+        auto next_request = [&] {
+            ::Exchange::MEClientRequest request;
+            if (auto next = client_requests.getNextToRead()) {
+                request = *next;
+                client_requests.updateReadIndex();
+            }
+            return request;
+        };
+
+        auto bracket = contingent->newBracket(0, Common::Side::BUY, 100, 10, 110, 95);
+        const auto entry = next_request();
+        respond(entry, ::Exchange::ClientResponseType::ACCEPTED, 0, entry.qty_);
+        respond(entry, ::Exchange::ClientResponseType::FILLED, entry.qty_, 0);
+        const auto target = next_request();
+        respond(target, ::Exchange::ClientResponseType::ACCEPTED, 0, target.qty_);
+
+        BBO bbo;
+        bbo.bid_price_ = 95;
+        bbo.ask_price_ = 96;
+        contingent->onOrderBookUpdate(0, &bbo);
+        const auto cancel = next_request();
+        respond(cancel, ::Exchange::ClientResponseType::CANCELED, 0, 0);
+        const auto exit = next_request();
+
+        bbo.bid_price_ = 100;
+        bbo.ask_price_ = 101;
+        contingent->onOrderBookUpdate(0, &bbo);
+        respond(exit, ::Exchange::ClientResponseType::PARTIALLY_FILLED, 4, exit.qty_ - 4);
+        respond(exit, ::Exchange::ClientResponseType::CANCELED, 0, 0);
+        const auto restored = next_request();
+
+        target_restored = (exit.type_ == ::Exchange::ClientRequestType::NEW && exit.qty_ == 10 &&
+                           restored.type_ == ::Exchange::ClientRequestType::NEW && restored.side_ == Common::Side::SELL &&
+                           restored.qty_ == 6 && restored.price_ == 110 && bracket->target_order_id_ == restored.order_id_ &&
+                           bracket->state_ == ContingentState::ACTIVE && contingent->numArmed(0, Common::Side::SELL) == 1);
+        std::cout << "Exit cancelled:        4 of 10 filled, target " << (restored.type_ == ::Exchange::ClientRequestType::NEW ? restored.qty_ : 0)
+                  << " at " << (restored.type_ == ::Exchange::ClientRequestType::NEW ? restored.price_ : 0)
+                  << (target_restored ? "" : " FAILED") << std::endl;
+    }
+
+    return (num_late || num_over_executed || !target_restored) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+#include "trading/backtest/fill_simulator.h"
+
+// Tests of the backtester's fill simulator: a resting order only fills once the displayed quantity ahead of it has
+// traded, also with several strategy orders queued at one price, cancels at its price move it up in proportion to the
+// quantity ahead of it, quantity which traded and was then removed from the book does not move it twice, and trades
+// or orders through its price fill it outright.
+// Usage: fill_simulator_test
+
+namespace {
+    using namespace Common;
+
+    constexpr TickerId TICKER_ID = 0;
+    constexpr Price PRICE = 10'000;
+
+    struct Section {
+        size_t checks = 0;
+        size_t failed = 0;
+
+        template<typename T>
+        auto expect(const std::string &what, T actual, T expected) {
+            ++checks;
+            if (actual != expected) {
+                ++failed;
+                std::cout << "  " << what << " = " << actual << ", expected " << expected << std::endl;
+            }
+        }
+
+        auto report(const std::string &name) const {
+            std::cout << name << ":" << std::string(19 - name.size() - 1, ' ') << checks << " checks, " << failed << " failed" << std::endl;
+            return failed == 0;
+        }
+    };
+
+    /// Fill simulator with a recorded book on one ticker, counting the quantity filled per strategy order.
+    struct Venue {
+        explicit Venue(Logger *logger)
+            : simulator_(logger) {
+        }
+
+        auto market(Exchange::MarketUpdateType type, OrderId order_id, Side side, Price price, Qty qty) {
+            simulator_.onMarketUpdate({type, order_id, TICKER_ID, side, price, qty, 0});
+        }
+
+        auto add(OrderId order_id, Side side, Price price, Qty qty) {
+            market(Exchange::MarketUpdateType::ADD, order_id, side, price, qty);
+        }
+
+        auto modify(OrderId order_id, Side side, Price price, Qty qty) {
+            market(Exchange::MarketUpdateType::MODIFY, order_id, side, price, qty);
+        }
+
+        auto cancel(OrderId order_id, Side side, Price price) {
+            market(Exchange::MarketUpdateType::CANCEL, order_id, side, price, 0);
+        }
+
+        /// Recorded trade of an aggressor of the specified side.
+        auto trade(Side aggressor_side, Price price, Qty qty) {
+            market(Exchange::MarketUpdateType::TRADE, OrderId_INVALID, aggressor_side, price, qty);
+        }
+
+        auto newOrder(OrderId order_id, Side side, Price price, Qty qty) {
+            simulator_.onClientRequest({Exchange::ClientRequestType::NEW, 1, TICKER_ID, order_id, side, price, qty});
+        }
+
+        /// Quantity filled on the specified strategy order since the last call.
+        auto filled(OrderId order_id) {
+            std::vector<Exchange::MEClientResponse> responses;
+            simulator_.takeResponses(&responses);
+            pending_.insert(pending_.end(), responses.begin(), responses.end());
+
+            Qty qty = 0;
+            std::erase_if(pending_, [&](const Exchange::MEClientResponse &response) {
+                if (response.order_id_ != order_id)
+                    return false;
+                if (response.type_ == Exchange::ClientResponseType::FILLED)
+                    qty += response.exec_qty_;
+                return true;
+            });
+            return qty;
+        }
+
+        Trading::FillSimulator simulator_;
+        std::vector<Exchange::MEClientResponse> pending_;
+    };
+}
+
+int main() {
+    Logger logger("fill_simulator_test.log");
+    bool ok = true;
+
+    {
+        // 100 displayed, A 10, 50 displayed, B 10 - all at one ask.
+        Section s;
+        Venue venue(&logger);
+        venue.add(1, Side::SELL, PRICE, 100);
+        venue.newOrder(101, Side::SELL, PRICE, 10);
+        venue.add(2, Side::SELL, PRICE, 50);
+        venue.newOrder(102, Side::SELL, PRICE, 10);
+
+        venue.trade(Side::BUY, PRICE, 95);
+        s.expect<Qty>("A after 95 traded", venue.filled(101), 0);
+        venue.modify(1, Side::SELL, PRICE, 5);
+        venue.trade(Side::BUY, PRICE, 10);
+        s.expect<Qty>("A after 105 traded", venue.filled(101), 5);
+        s.expect<Qty>("B after 105 traded", venue.filled(102), 0);
+        venue.cancel(1, Side::SELL, PRICE);
+
+        // The 100 ahead of A were ahead of B too and only count once, B fills after the 50 behind A.
+        venue.trade(Side::BUY, PRICE, 60);
+        s.expect<Qty>("A after 165 traded", venue.filled(101), 5);
+        s.expect<Qty>("B after 165 traded", venue.filled(102), 5);
+        ok &= s.report("Queue ahead");
+    }
+
+    {
+        // One sweep through a queue of 100 displayed, A 10, 50 displayed, B 10.
+        Section s;
+        Venue venue(&logger);
+        venue.add(1, Side::BUY, PRICE, 100);
+        venue.newOrder(101, Side::BUY, PRICE, 10);
+        venue.add(2, Side::BUY, PRICE, 50);
+        venue.newOrder(102, Side::BUY, PRICE, 10);
+
+        venue.trade(Side::SELL, PRICE, 165);
+        s.expect<Qty>("A after one trade of 165", venue.filled(101), 10);
+        s.expect<Qty>("B after one trade of 165", venue.filled(102), 5);
+        ok &= s.report("One sweep");
+    }
+
+    {
+        // A 10 behind 100 displayed, with 100 more behind it. Half the cancels at the price come from ahead of it.
+        Section s;
+        Venue venue(&logger);
+        venue.add(1, Side::SELL, PRICE, 40);
+        venue.add(2, Side::SELL, PRICE, 60);
+        venue.newOrder(101, Side::SELL, PRICE, 10);
+        venue.add(3, Side::SELL, PRICE, 100);
+
+        venue.cancel(3, Side::SELL, PRICE);
+        venue.trade(Side::BUY, PRICE, 30);
+        s.expect<Qty>("A after cancel of 100 and 30 traded", venue.filled(101), 0);
+
+        // The 30 traded leaving the book is not a cancel, 20 are still ahead of A.
+        venue.modify(1, Side::SELL, PRICE, 10);
+        venue.trade(Side::BUY, PRICE, 20);
+        s.expect<Qty>("A after 50 traded", venue.filled(101), 0);
+        venue.trade(Side::BUY, PRICE, 4);
+        s.expect<Qty>("A after 54 traded", venue.filled(101), 4);
+        ok &= s.report("Pro-rata cancel");
+    }
+
+    {
+        // A 10 behind 100 displayed at the bid, traded and bid through.
+        Section s;
+        Venue venue(&logger);
+        venue.add(1, Side::BUY, PRICE, 100);
+        venue.newOrder(101, Side::BUY, PRICE, 10);
+
+        venue.trade(Side::SELL, PRICE - 1, 3);
+        s.expect<Qty>("A after trade through", venue.filled(101), 3);
+        venue.add(2, Side::SELL, PRICE - 1, 4);
+        s.expect<Qty>("A after order through", venue.filled(101), 4);
+        venue.add(3, Side::SELL, PRICE + 1, 50);
+        s.expect<Qty>("A after order above", venue.filled(101), 0);
+        ok &= s.report("Trade through");
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
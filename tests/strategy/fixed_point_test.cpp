@@ -0,0 +1,194 @@
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "common/fixed_point.h"
+#include "common/logging.h"
+#include "trading/strategy/position_keeper.h"
+
+// Boundary tests of the fixed-point conversions the adapters and the PnL use: decimal parsing with truncation,
+// negatives, maximum digits, overflow and malformed strings, increments finer than 18 decimals, rounding onto the tick
+// and lot grid, quantities a Qty cannot hold, and the exact integer PnL of the position keeper across partial closes,
+// a flip and notionals beyond the int64 range.
+// Usage: fixed_point_test
+
+namespace {
+    using namespace Common;
+
+    constexpr auto MAX = std::numeric_limits<int64_t>::max();
+    constexpr auto MIN = std::numeric_limits<int64_t>::min();
+
+    struct Section {
+        size_t checks = 0;
+        size_t failed = 0;
+
+        template<typename T>
+        auto expect(const std::string &what, T actual, T expected) {
+            ++checks;
+            if (actual != expected) {
+                ++failed;
+                std::cout << "  " << what << " = " << actual << ", expected " << expected << std::endl;
+            }
+        }
+
+        auto report(const std::string &name) const {
+            std::cout << name << ":" << std::string(19 - name.size() - 1, ' ') << checks << " checks, " << failed << " failed" << std::endl;
+            return failed == 0;
+        }
+    };
+
+    auto fill(Trading::PositionInfo &position, Side side, Price price, Qty qty, Logger &logger) {
+        Exchange::MEClientResponse response;
+        response.type_ = Exchange::ClientResponseType::FILLED;
+        response.ticker_id_ = 0;
+        response.side_ = side;
+        response.price_ = price;
+        response.exec_qty_ = qty;
+        position.addFill(&response, &logger);
+    }
+}
+
+int main() {
+    Logger logger("fixed_point_test.log");
+    bool ok = true;
+
+    {
+        Section s;
+        s.expect<int64_t>("parseDecimal(27123.45000000, 2)", parseDecimal("27123.45000000", 2), 2'712'345);
+        s.expect<int64_t>("parseDecimal(0.05, 2)", parseDecimal("0.05", 2), 5);
+        s.expect<int64_t>("parseDecimal(-0.05, 2)", parseDecimal("-0.05", 2), -5);
+        s.expect<int64_t>("parseDecimal(12, 8)", parseDecimal("12", 8), 1'200'000'000);
+        s.expect<int64_t>("parseDecimal(5., 2)", parseDecimal("5.", 2), 500);
+        s.expect<int64_t>("parseDecimal(.5, 2)", parseDecimal(".5", 2), 50);
+        // Extra digits are truncated towards zero, never rounded
+        s.expect<int64_t>("parseDecimal(1.239, 2)", parseDecimal("1.239", 2), 123);
+        s.expect<int64_t>("parseDecimal(-1.239, 2)", parseDecimal("-1.239", 2), -123);
+        // Maximum digits, the int64 limits themselves still parse exactly
+        s.expect<int64_t>("parseDecimal(0.000000000000000001, 18)", parseDecimal("0.000000000000000001", 18), 1);
+        s.expect<int64_t>("parseDecimal(1, 18)", parseDecimal("1", 18), 1'000'000'000'000'000'000);
+        s.expect<int64_t>("parseDecimal(9223372036854775807, 0)", parseDecimal("9223372036854775807", 0), MAX);
+        s.expect<int64_t>("parseDecimal(-9223372036854775807, 0)", parseDecimal("-9223372036854775807", 0), -MAX);
+        s.expect<int64_t>("parseDecimal(-9223372036854775808, 0)", parseDecimal("-9223372036854775808", 0), MIN);
+        s.expect<int64_t>("parseDecimal(92233720368547758.07, 2)", parseDecimal("92233720368547758.07", 2), MAX);
+        // Overflow saturates, in the integer digits, the fractional digits and the scaling to the requested decimals
+        s.expect<int64_t>("parseDecimal(9223372036854775808, 0)", parseDecimal("9223372036854775808", 0), MAX);
+        s.expect<int64_t>("parseDecimal(92233720368547758.08, 2)", parseDecimal("92233720368547758.08", 2), MAX);
+        s.expect<int64_t>("parseDecimal(99999999999999999999, 0)", parseDecimal("99999999999999999999", 0), MAX);
+        s.expect<int64_t>("parseDecimal(-99999999999999999999, 0)", parseDecimal("-99999999999999999999", 0), MIN);
+        s.expect<int64_t>("parseDecimal(100000000000, 8)", parseDecimal("100000000000", 8), MAX);
+        s.expect<int64_t>("parseDecimal(-100000000000, 8)", parseDecimal("-100000000000", 8), MIN);
+        // Malformed strings are rejected, also when the bad character is in the truncated digits
+        for (const auto str : {"", "-", ".", "-.", "abc", "1e-5", "1.5e3", "12a", "1.2.3", " 1", "1 ", "+1", "--1", "1.23x"})
+            s.expect<int64_t>("parseDecimal(" + std::string(str) + ", 2)", parseDecimal(str, 2), MAX);
+        s.expect<Price>("parsePrice(1e-5)", InstrumentScale{}.parsePrice("1e-5"), Price_INVALID);
+        s.expect<Qty>("parseQty(abc)", InstrumentScale{}.parseQty("abc"), Qty_INVALID);
+        // More than 18 decimals are taken as 18 instead of reading past POW10
+        s.expect<int64_t>("parseDecimal(1, 19)", parseDecimal("1", 19), 1'000'000'000'000'000'000);
+        s.expect<int64_t>("parseDecimal(0.0000000000000000019, 255)", parseDecimal("0.0000000000000000019", 255), 1);
+        ok &= s.report("parseDecimal");
+    }
+
+    {
+        Section s;
+        InstrumentScale scale;
+        scale.tick_size_ = 5;
+        scale.lot_size_ = 100;
+        // Buys round down and sells up onto the grid, below zero too
+        s.expect<Price>("roundToTick(12, BUY)", scale.roundToTick(12, Side::BUY), 10);
+        s.expect<Price>("roundToTick(12, SELL)", scale.roundToTick(12, Side::SELL), 15);
+        s.expect<Price>("roundToTick(10, BUY)", scale.roundToTick(10, Side::BUY), 10);
+        s.expect<Price>("roundToTick(10, SELL)", scale.roundToTick(10, Side::SELL), 10);
+        s.expect<Price>("roundToTick(0, SELL)", scale.roundToTick(0, Side::SELL), 0);
+        s.expect<Price>("roundToTick(-12, BUY)", scale.roundToTick(-12, Side::BUY), -15);
+        s.expect<Price>("roundToTick(-12, SELL)", scale.roundToTick(-12, Side::SELL), -10);
+        s.expect<Price>("roundToTick(-10, BUY)", scale.roundToTick(-10, Side::BUY), -10);
+        s.expect<Price>("roundToTick(-10, SELL)", scale.roundToTick(-10, Side::SELL), -10);
+        s.expect<Qty>("roundToLot(250)", scale.roundToLot(250), 200);
+        s.expect<Qty>("roundToLot(99)", scale.roundToLot(99), 0);
+
+        const auto binance = InstrumentScale::fromIncrements("0.01000000", "0.00001000");
+        s.expect<int>("price_decimals_", binance.price_decimals_, 2);
+        s.expect<int>("qty_decimals_", binance.qty_decimals_, 5);
+        s.expect<Price>("tick_size_", binance.tick_size_, 1);
+        s.expect<Qty>("lot_size_", binance.lot_size_, 1);
+        // An increment with more than 18 decimals is capped at 18, so the scales stay within POW10
+        const auto fine = InstrumentScale::fromIncrements("0.0000000000000000000001", "0.00000000000000000001");
+        s.expect<int>("capped price_decimals_", fine.price_decimals_, 18);
+        s.expect<int>("capped qty_decimals_", fine.qty_decimals_, 18);
+        s.expect<Price>("capped tick_size_", fine.tick_size_, 1);
+        s.expect<double>("capped priceToDouble(10^18)", fine.priceToDouble(1'000'000'000'000'000'000), 1.0);
+        s.expect<int>("decimalsOf(0.0000000000000000000)", decimalsOf("0.0000000000000000000"), 0);
+        const auto nse = InstrumentScale::fromIncrements(0.05, 1.0);
+        s.expect<Price>("roundToTick(250012, BUY)", nse.roundToTick(250'012, Side::BUY), 250'010);
+        s.expect<Price>("roundToTick(250012, SELL)", nse.roundToTick(250'012, Side::SELL), 250'015);
+        ok &= s.report("roundToTick");
+    }
+
+    {
+        Section s;
+        InstrumentScale scale{2, 3};
+        s.expect<Qty>("parseQty(1.5)", scale.parseQty("1.5"), 1'500);
+        s.expect<Qty>("parseQty(1.2345)", scale.parseQty("1.2345"), 1'234);
+        s.expect<Qty>("parseQty(0.00000000)", scale.parseQty("0.00000000"), 0);
+        s.expect<Qty>("parseQty(4294967.294)", scale.parseQty("4294967.294"), Qty_INVALID - 1);
+        // Beyond the largest valid Qty, negative or saturated quantities are rejected instead of wrapping
+        s.expect<Qty>("parseQty(4294967.295)", scale.parseQty("4294967.295"), Qty_INVALID);
+        s.expect<Qty>("parseQty(4294967.296)", scale.parseQty("4294967.296"), Qty_INVALID);
+        s.expect<Qty>("parseQty(8589934.593)", scale.parseQty("8589934.593"), Qty_INVALID);
+        s.expect<Qty>("parseQty(-0.001)", scale.parseQty("-0.001"), Qty_INVALID);
+        s.expect<Qty>("parseQty(99999999999999999999)", scale.parseQty("99999999999999999999"), Qty_INVALID);
+        s.expect<Qty>("toQty(2.5)", scale.toQty(2.5), 2'500);
+        s.expect<Qty>("toQty(4294967.296)", scale.toQty(4'294'967.296), Qty_INVALID);
+        s.expect<Qty>("toQty(-0.001)", scale.toQty(-0.001), Qty_INVALID);
+        s.expect<Price>("parsePrice(-27123.456)", scale.parsePrice("-27123.456"), -2'712'345);
+        ok &= s.report("parseQty");
+    }
+
+    {
+        // Prices in paise, whole shares - cash flows checked against position * mark - cost by hand
+        Section s;
+        Trading::PositionInfo position;
+        fill(position, Side::BUY, 10'005, 10, logger);
+        fill(position, Side::BUY, 10'010, 5, logger);
+        s.expect<PnL>("open buy notional", position.open_notional_.at(sideToIndex(Side::BUY)), 150'100);
+        s.expect<PnL>("unreal after buys", position.unreal_pnl_, 50);
+
+        // Releases 150100 * 4 / 15 = 40026.67, the remainder stays with the open position
+        fill(position, Side::SELL, 10'020, 4, logger);
+        s.expect<PnL>("real after partial close", position.real_pnl_, 54);
+        s.expect<PnL>("unreal after partial close", position.unreal_pnl_, 146);
+        s.expect<PnL>("total after partial close", position.total_pnl_, 200);
+
+        // Mid of 10017.5 - the half paisa is truncated
+        Trading::BBO bbo;
+        bbo.bid_price_ = 10'015;
+        bbo.ask_price_ = 10'020;
+        position.updateBBO(&bbo, &logger);
+        s.expect<PnL>("unreal at mid", position.unreal_pnl_, 118);
+        s.expect<PnL>("total at mid", position.total_pnl_, 172);
+
+        // Flips short at a loss, then buys back flat
+        fill(position, Side::SELL, 9'995, 16, logger);
+        s.expect<int32_t>("position after flip", position.position_, -5);
+        s.expect<PnL>("real after flip", position.real_pnl_, -75);
+        s.expect<PnL>("unreal after flip", position.unreal_pnl_, 0);
+        s.expect<PnL>("open sell notional", position.open_notional_.at(sideToIndex(Side::SELL)), 49'975);
+        fill(position, Side::BUY, 9'990, 5, logger);
+        s.expect<PnL>("real when flat", position.real_pnl_, -50);
+        s.expect<PnL>("total when flat", position.total_pnl_, -50);
+
+        // A 10^18 notional: the share released by a partial close overflows int64 before the division
+        Trading::PositionInfo large;
+        constexpr Price PRICE = 1'000'000'000'000;
+        fill(large, Side::BUY, PRICE, 1'000'000, logger);
+        fill(large, Side::SELL, PRICE + 1, 333'333, logger);
+        s.expect<PnL>("large real", large.real_pnl_, 333'333);
+        s.expect<PnL>("large unreal", large.unreal_pnl_, 666'667);
+        s.expect<PnL>("large total", large.total_pnl_, 1'000'000);
+        ok &= s.report("PnL");
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
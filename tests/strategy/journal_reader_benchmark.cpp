@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/lf_queue.h"
+#include "common/journal.h"
+#include "common/journal_reader.h"
+#include "common/time_utils.h"
+#include "exchange/market_data/market_update.h"
+#include "trading/backtest/backtester.h"
+
+// Benchmark of the journal reader on a synthetic journal of order-by-order market updates across all tickers.
+// Measures opening (index build, then index load), seeking by time and scanning single threaded and partitioned by
+// time and by ticker, and checks the order books rebuilt from the journal against the ones the generator kept and that
+// partitioning by ticker puts every update in exactly one partition. Also checks a file with a torn last record keeps
+// its index across opens, and the backtester loads every market update once from a journal of both the tapped updates
+// and the incremental stream, or of the incremental stream read again after a recovery.
+// Usage: journal_reader_benchmark [NUM_UPDATES] [NUM_THREADS]
+
+namespace {
+    using namespace Common;
+
+    struct BookOrder {
+        Side side_ = Side::INVALID;
+        Price price_ = Price_INVALID;
+        Qty qty_ = 0;
+    };
+
+    /// Order book of one ticker, by order id.
+    using Book = std::unordered_map<OrderId, BookOrder>;
+
+    struct BookSummary {
+        size_t num_orders_ = 0;
+        Price best_bid_ = Price_INVALID;
+        Price best_ask_ = Price_INVALID;
+        int64_t total_qty_ = 0;
+
+        auto operator==(const BookSummary &other) const {
+            return num_orders_ == other.num_orders_ && best_bid_ == other.best_bid_ && best_ask_ == other.best_ask_ &&
+                   total_qty_ == other.total_qty_;
+        }
+    };
+
+    auto applyUpdate(Book &book, const Exchange::MEMarketUpdate &update) {
+        switch (update.type_) {
+            case Exchange::MarketUpdateType::ADD:
+                book[update.order_id_] = {update.side_, update.price_, update.qty_};
+                break;
+            case Exchange::MarketUpdateType::MODIFY:
+                book[update.order_id_].qty_ = update.qty_;
+                break;
+            case Exchange::MarketUpdateType::CANCEL:
+                book.erase(update.order_id_);
+                break;
+            default:
+                break;
+        }
+    }
+
+    auto summarize(const Book &book) {
+        BookSummary summary;
+        summary.num_orders_ = book.size();
+        for (const auto &[order_id, order] : book) {
+            summary.total_qty_ += order.qty_;
+            if (order.side_ == Side::BUY && (summary.best_bid_ == Price_INVALID || order.price_ > summary.best_bid_))
+                summary.best_bid_ = order.price_;
+            if (order.side_ == Side::SELL && (summary.best_ask_ == Price_INVALID || order.price_ < summary.best_ask_))
+                summary.best_ask_ = order.price_;
+        }
+        return summary;
+    }
+
+    using Summaries = std::array<BookSummary, ME_MAX_TICKERS>;
+
+    /// Write the journal and return the books at snapshot_index and at the end.
+    auto generateJournal(const std::string &dir, size_t num_updates, size_t snapshot_index, Nanos start_time,
+                         Summaries *at_snapshot, Summaries *at_end) {
+        std::mt19937_64 rng(7);
+        std::uniform_int_distribution<TickerId> ticker(0, ME_MAX_TICKERS - 1);
+        std::uniform_int_distribution<int> action(0, 99);
+        std::uniform_int_distribution<Price> offset(1, 20);
+        std::uniform_int_distribution<Qty> qty(1, 500);
+
+        JournalWriter writer(dir, "bench", 64 * 1024 * 1024);
+        std::array<Book, ME_MAX_TICKERS> books;
+        std::array<std::vector<OrderId>, ME_MAX_TICKERS> live_orders;
+        OrderId next_order_id = 1;
+
+        for (size_t i = 0; i < num_updates; ++i) {
+            if (i == snapshot_index) {
+                for (TickerId ticker_id = 0; ticker_id < ME_MAX_TICKERS; ++ticker_id)
+                    (*at_snapshot)[ticker_id] = summarize(books[ticker_id]);
+            }
+
+            const auto ticker_id = ticker(rng);
+            auto &orders = live_orders[ticker_id];
+            const auto kind = action(rng);
+            Exchange::MEMarketUpdate update;
+            update.ticker_id_ = ticker_id;
+
+            if (orders.size() < 50 || kind < 40) {
+                const auto side = (kind % 2 ? Side::BUY : Side::SELL);
+                update = {Exchange::MarketUpdateType::ADD, next_order_id++, ticker_id, side,
+                          10'000 + (side == Side::BUY ? -offset(rng) : offset(rng)), qty(rng), 0};
+                orders.push_back(update.order_id_);
+            } else {
+                const auto index = static_cast<size_t>(rng() % orders.size());
+                const auto &order = books[ticker_id][orders[index]];
+                if (kind < 75) {
+                    update = {Exchange::MarketUpdateType::CANCEL, orders[index], ticker_id, order.side_, order.price_, 0, 0};
+                    orders[index] = orders.back();
+                    orders.pop_back();
+                } else {
+                    update = {Exchange::MarketUpdateType::MODIFY, orders[index], ticker_id, order.side_, order.price_, qty(rng), 0};
+                }
+            }
+
+            applyUpdate(books[ticker_id], update);
+            writer.append(JournalRecordType::MARKET_UPDATE, 1, i + 1, start_time + static_cast<Nanos>(i) * 1'000, &update,
+                          sizeof(update));
+        }
+        writer.close();
+
+        for (TickerId ticker_id = 0; ticker_id < ME_MAX_TICKERS; ++ticker_id)
+            (*at_end)[ticker_id] = summarize(books[ticker_id]);
+        return writer.numFiles();
+    }
+
+    auto rebuild(const JournalChunk &chunk) {
+        std::array<Book, ME_MAX_TICKERS> books;
+        chunk.forEach<Exchange::MEMarketUpdate>(JournalRecordType::MARKET_UPDATE,
+                                                [&](const JournalRecordHeader *, const Exchange::MEMarketUpdate &update) {
+            if (update.ticker_id_ < ME_MAX_TICKERS)
+                applyUpdate(books[update.ticker_id_], update);
+        });
+
+        Summaries summaries;
+        for (TickerId ticker_id = 0; ticker_id < ME_MAX_TICKERS; ++ticker_id)
+            summaries[ticker_id] = summarize(books[ticker_id]);
+        return summaries;
+    }
+
+    auto millisSince(Nanos start) {
+        return static_cast<double>(getCurrentNanos() - start) / NANOS_TO_MILLIS;
+    }
+
+    auto journalPath(const std::filesystem::path &dir) {
+        for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+            if (entry.path().extension() == ".jnl")
+                return entry.path();
+        }
+        return std::filesystem::path();
+    }
+
+    /// Cuts the last of num_records records short and opens the file twice - the second open has to load the index the
+    /// first one saved, and both have to end the file at the last whole record.
+    auto checkTornFile(const std::filesystem::path &dir, size_t num_records, Nanos start_time) {
+        std::filesystem::create_directories(dir);
+        {
+            JournalWriter writer(dir, "torn", 1024 * 1024);
+            for (size_t i = 0; i < num_records; ++i) {
+                const Exchange::MEMarketUpdate update{Exchange::MarketUpdateType::ADD, i + 1, 0, Side::BUY, 10'000, 1, 0};
+                writer.append(JournalRecordType::MARKET_UPDATE, 1, i + 1, start_time + static_cast<Nanos>(i), &update, sizeof(update));
+            }
+        }
+        const auto path = journalPath(dir);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+
+        bool ok = true;
+        for (const auto pass : {0, 1}) {
+            const auto saved = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+            if (pass)
+                std::filesystem::last_write_time(path.string() + ".idx", saved);
+            const JournalReader journal(dir);
+            ok &= (journal.files().size() == 1 && journal.numRecords() == num_records - 1);
+            if (pass)
+                ok &= (std::filesystem::last_write_time(path.string() + ".idx") == saved);
+            if (ok) {
+                const auto &file = journal.files().front();
+                size_t seq = 0;
+                file->forEach(file->beginOffset(), file->endOffset(), [&seq](const JournalRecordHeader *record) { seq = record->seq_; });
+                ok &= (seq == num_records - 1 && file->seekSeq(1, num_records) == file->endOffset());
+            }
+        }
+        std::cout << "Torn file:        " << num_records - 1 << " of " << num_records << " records, index "
+                  << (ok ? "kept across opens" : "NOT kept or records wrong") << std::endl;
+        return ok;
+    }
+
+    /// Journals every update as a tapped MARKET_UPDATE and as an MDP_INCREMENTAL, then only as MDP_INCREMENTAL with the
+    /// second half read again - the backtester has to load each update exactly once and in order either way.
+    auto checkBacktestLoad(const std::filesystem::path &dir, size_t num_updates, Nanos start_time) {
+        bool ok = true;
+        for (const auto tapped : {true, false}) {
+            const auto run_dir = dir / (tapped ? "tapped" : "incremental");
+            std::filesystem::create_directories(run_dir);
+            {
+                JournalWriter writer(run_dir, "bt", 1024 * 1024);
+                const auto append = [&](size_t i) {
+                    const Exchange::MDPMarketUpdate mdp_update{i + 1, {Exchange::MarketUpdateType::ADD, i + 1, 0, Side::BUY, 10'000, 1, 0}};
+                    const auto time = start_time + static_cast<Nanos>(i) * 1'000;
+                    if (tapped)
+                        writer.append(JournalRecordType::MARKET_UPDATE, 1, i + 1, time + 500, &mdp_update.me_market_update_,
+                                      sizeof(mdp_update.me_market_update_));
+                    writer.append(JournalRecordType::MDP_INCREMENTAL, 2, i + 1, time, &mdp_update, sizeof(mdp_update));
+                };
+                for (size_t i = 0; i < num_updates; ++i)
+                    append(i);
+                if (!tapped) {
+                    for (size_t i = num_updates / 2; i < num_updates; ++i)
+                        append(i);
+                }
+            }
+
+            const auto events = Trading::loadBacktestEvents(JournalReader(run_dir.string()));
+            bool in_order = (events.size() == num_updates);
+            for (size_t i = 0; in_order && i < events.size(); ++i)
+                in_order = (events[i].type_ == Trading::BacktestEventType::MARKET_UPDATE && events[i].market_update_.order_id_ == i + 1);
+            std::cout << (tapped ? "Backtest, tapped: " : "Backtest, reread: ") << events.size() << " of " << num_updates
+                      << " updates loaded" << (in_order ? "" : ", NOT once each in order") << std::endl;
+            ok &= in_order;
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_updates = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5'000'000);
+    const size_t num_threads = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::max(2u, std::thread::hardware_concurrency()));
+
+    const auto dir = std::filesystem::temp_directory_path() / ("journal_reader_benchmark_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    const Nanos start_time = 1'700'000'000 * NANOS_TO_SECS;
+    const auto snapshot_index = num_updates * 2 / 3;
+    Summaries at_snapshot, at_end;
+    auto start = getCurrentNanos();
+    const auto num_files = generateJournal(dir, num_updates, snapshot_index, start_time, &at_snapshot, &at_end);
+    std::cout << "Write:            " << num_updates << " updates in " << num_files << " files, " << millisSince(start) << "ms" << std::endl;
+
+    bool ok = true;
+    start = getCurrentNanos();
+    {
+        JournalReader journal(dir);
+        std::cout << "Open, index:      " << millisSince(start) << "ms" << std::endl;
+    }
+    start = getCurrentNanos();
+    JournalReader journal(dir);
+    std::cout << "Open, cached:     " << millisSince(start) << "ms" << std::endl;
+    ok &= (journal.numRecords() == num_updates);
+
+    // Random seeks, each has to land on the first record at or after the time.
+    std::mt19937_64 rng(11);
+    constexpr size_t NUM_SEEKS = 100'000;
+    std::vector<Nanos> times(NUM_SEEKS);
+    for (auto &time : times)
+        time = start_time + static_cast<Nanos>(rng() % (num_updates * 1'000));
+    start = getCurrentNanos();
+    size_t checksum = 0;
+    for (const auto time : times)
+        checksum += journal.seek(time).offset_;
+    const auto seek_nanos = (getCurrentNanos() - start) / static_cast<Nanos>(NUM_SEEKS);
+    for (size_t i = 0; i < 1'000; ++i) {
+        const auto position = journal.seek(times[i]);
+        const auto &file = journal.files()[position.file_index_];
+        ok &= (file->recordAt(position.offset_)->time_ >= times[i] && file->recordAt(position.offset_)->time_ - times[i] < 1'000);
+    }
+    std::cout << "Seek:             " << seek_nanos << "ns per seek (" << checksum % 10 << ")" << std::endl;
+
+    // Sequence number seek.
+    const auto seq = num_updates / 2 + 1;
+    for (const auto &file : journal.files()) {
+        const auto offset = file->seekSeq(1, seq);
+        if (offset < file->endOffset()) {
+            ok &= (file->recordAt(offset)->seq_ == seq);
+            break;
+        }
+    }
+
+    // Book at an arbitrary time - everything before the snapshot time, rebuilt from the start of the day.
+    start = getCurrentNanos();
+    const auto snapshot_books = rebuild(journal.chunk(journal.begin(), journal.seek(start_time + static_cast<Nanos>(snapshot_index) * 1'000)));
+    std::cout << "Book at time:     " << millisSince(start) << "ms" << std::endl;
+    ok &= (snapshot_books == at_snapshot);
+
+    start = getCurrentNanos();
+    const auto full_books = rebuild(journal.chunk());
+    const auto scan_millis = millisSince(start);
+    std::cout << "Scan, 1 thread:   " << scan_millis << "ms, " << static_cast<size_t>(num_updates / scan_millis * 1'000) << " updates/s" << std::endl;
+    ok &= (full_books == at_end);
+
+    // Time partitions - every chunk counts its own records.
+    const auto time_chunks = journal.partitionByTime(num_threads);
+    std::vector<size_t> counts(time_chunks.size());
+    start = getCurrentNanos();
+    scanParallel(time_chunks, [&](size_t index, const JournalChunk &chunk) {
+        chunk.forEach<Exchange::MEMarketUpdate>(JournalRecordType::MARKET_UPDATE,
+                                                [&](const JournalRecordHeader *, const Exchange::MEMarketUpdate &) { ++counts[index]; });
+    });
+    const auto time_millis = millisSince(start);
+    size_t total = 0;
+    for (const auto count : counts)
+        total += count;
+    std::cout << "Scan, " << time_chunks.size() << " by time:   " << time_millis << "ms" << std::endl;
+    ok &= (total == num_updates);
+
+    // Ticker partitions - every thread rebuilds the books of its tickers, every update is in exactly one partition.
+    start = getCurrentNanos();
+    const auto ticker_chunks = journal.partitionByTicker(num_threads, [](const JournalRecordHeader *record) {
+        const auto update = journalView<Exchange::MEMarketUpdate>(record);
+        return (record->type_ == JournalRecordType::MARKET_UPDATE && update ? update->ticker_id_ : TickerId_INVALID);
+    });
+    const auto partition_millis = millisSince(start);
+    size_t partitioned = 0;
+    for (const auto &chunk : ticker_chunks)
+        chunk.forEach([&](const JournalRecordHeader *record) { partitioned += (record->type_ == JournalRecordType::MARKET_UPDATE); });
+    ok &= (partitioned == num_updates);
+
+    std::vector<Summaries> partition_books(ticker_chunks.size());
+    start = getCurrentNanos();
+    scanParallel(ticker_chunks, [&](size_t index, const JournalChunk &chunk) {
+        partition_books[index] = rebuild(chunk);
+    });
+    const auto ticker_millis = millisSince(start);
+    for (TickerId ticker_id = 0; ticker_id < ME_MAX_TICKERS; ++ticker_id)
+        ok &= (partition_books[ticker_id % ticker_chunks.size()][ticker_id] == at_end[ticker_id]);
+    std::cout << "Books, " << ticker_chunks.size() << " by ticker: " << ticker_millis << "ms, partitioned in " << partition_millis << "ms, "
+              << partitioned << " of " << num_updates << " updates" << std::endl;
+
+    ok &= checkTornFile(dir / "torn", 1'000, start_time);
+    ok &= checkBacktestLoad(dir / "backtest", 1'000, start_time);
+
+    std::cout << "Result:           " << (ok ? "OK" : "MISMATCH") << std::endl;
+    std::filesystem::remove_all(dir);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
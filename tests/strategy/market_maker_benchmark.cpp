@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "trading/strategy/market_order_book.h"
+#include "trading/strategy/trade_engine.h"
+
+// Simulation benchmark of the market making algorithm quoting 5 level ladders per side on a number of tickers.
+// The market is simulated in process: the touch of every ticker follows a random walk, published as ADD / CANCEL
+// market updates through a MarketOrderBook into a TradeEngine running the MarketMaker, and aggressive orders sweep
+// the strategy's quotes at and through the touch. Requests are answered straight away, as a matching engine would.
+// The same market is run without a hysteresis band and with one, to compare order traffic. Also checks layers the
+// risk checks refused are not taken as quoted, but re-sent on the next decision, that quotes of an instrument
+// with a tick size above one price unit are on its tick grid, that quotes move away from the side of the position,
+// that the spread widens with volatility and, on a tick grid coarser than one price unit, as liquidity falls.
+// Usage: market_maker_benchmark [NUM_MARKET_MOVES] [HYSTERESIS_TICKS] [NUM_TICKERS]
+
+namespace {
+    using namespace Trading;
+
+    constexpr Common::Qty CLIP = 10;
+    constexpr size_t NUM_LEVELS = 5;
+
+    struct RestingOrder {
+        Common::OrderId order_id_;
+        Common::Side side_;
+        Common::Price price_;
+        Common::Qty qty_;
+    };
+
+    struct Result {
+        size_t num_decisions_ = 0;
+        size_t num_requests_ = 0;
+        size_t num_fills_ = 0;
+        Common::Qty traded_qty_ = 0;
+        int64_t max_position_ = 0;
+        std::vector<Common::Nanos> decision_times_;
+    };
+
+    struct SimulatedExchange {
+        TradeEngine *trade_engine_;
+        std::vector<std::vector<RestingOrder>> resting_;
+
+        auto respond(const RestingOrder &order, Common::TickerId ticker_id, ::Exchange::ClientResponseType type,
+                     Common::Qty exec_qty, Common::Qty leaves_qty) {
+            const ::Exchange::MEClientResponse response{type, ::Exchange::ClientResponseRejectReason::INVALID, 1, ticker_id,
+                                                        order.order_id_, order.side_, order.price_, exec_qty, leaves_qty};
+            trade_engine_->onOrderUpdate(&response);
+        }
+
+        auto drain(::Exchange::ClientRequestLFQueue &client_requests) {
+            size_t num_requests = 0;
+            for (auto request = client_requests.getNextToRead(); request; request = client_requests.getNextToRead()) {
+                const auto copy = *request;
+                client_requests.updateReadIndex();
+                ++num_requests;
+
+                auto &orders = resting_[copy.ticker_id_];
+                auto order = std::find_if(orders.begin(), orders.end(), [&](const auto &o) { return o.order_id_ == copy.order_id_; });
+                switch (copy.type_) {
+                    case ::Exchange::ClientRequestType::NEW:
+                        orders.push_back({copy.order_id_, copy.side_, copy.price_, copy.qty_});
+                        respond(orders.back(), copy.ticker_id_, ::Exchange::ClientResponseType::ACCEPTED, 0, copy.qty_);
+                        break;
+                    case ::Exchange::ClientRequestType::MODIFY:
+                        if (order != orders.end()) {
+                            order->price_ = copy.price_;
+                            order->qty_ = copy.qty_;
+                            respond(*order, copy.ticker_id_, ::Exchange::ClientResponseType::ACCEPTED, 0, copy.qty_);
+                        }
+                        break;
+                    case ::Exchange::ClientRequestType::CANCEL:
+                        if (order != orders.end()) {
+                            respond(*order, copy.ticker_id_, ::Exchange::ClientResponseType::CANCELED, 0, 0);
+                            orders.erase(order);
+                        }
+                        break;
+                    case ::Exchange::ClientRequestType::INVALID:
+                        break;
+                }
+            }
+            return num_requests;
+        }
+
+        // Aggressive order of the specified side and quantity, filling resting quotes at limit_price or better, best first.
+        auto sweep(Common::TickerId ticker_id, Common::Side side, Common::Price limit_price, Common::Qty qty, Result &result) {
+            auto &orders = resting_[ticker_id];
+            const auto is_buy = (side == Common::Side::BUY);
+            std::stable_sort(orders.begin(), orders.end(), [&](const auto &lhs, const auto &rhs) {
+                return is_buy ? lhs.price_ < rhs.price_ : lhs.price_ > rhs.price_;
+            });
+            for (auto order = orders.begin(); order != orders.end() && qty;) {
+                const auto matches = (order->side_ != side && (is_buy ? order->price_ <= limit_price : order->price_ >= limit_price));
+                if (!matches) {
+                    ++order;
+                    continue;
+                }
+                const auto exec_qty = std::min(qty, order->qty_);
+                qty -= exec_qty;
+                order->qty_ -= exec_qty;
+                ++result.num_fills_;
+                result.traded_qty_ += exec_qty;
+                respond(*order, ticker_id, ::Exchange::ClientResponseType::FILLED, exec_qty, order->qty_);
+                order = (order->qty_ ? order + 1 : orders.erase(order));
+            }
+        }
+    };
+
+    // Touch of one simulated ticker, one order on each side.
+    struct Touch {
+        Common::Price mid_ = 100'000;
+        Common::OrderId bid_order_id_ = Common::OrderId_INVALID;
+        Common::OrderId ask_order_id_ = Common::OrderId_INVALID;
+    };
+
+    auto run(size_t num_moves, Common::Price hysteresis, Common::TickerId num_tickers) {
+        Common::TradeEngineCfgHashMap ticker_cfg;
+        for (auto &cfg : ticker_cfg) {
+            cfg.clip_ = CLIP;
+            cfg.risk_cfg_.max_order_size_ = 1'000;
+            cfg.risk_cfg_.max_position_ = CLIP * NUM_LEVELS * 2;
+            cfg.risk_cfg_.max_loss_ = -1e12;
+            cfg.quote_cfg_.num_levels_ = NUM_LEVELS;
+            cfg.quote_cfg_.horizon_ = 10;
+            cfg.quote_cfg_.hysteresis_ = hysteresis;
+        }
+
+        ::Exchange::ClientRequestLFQueue client_requests(Common::ME_MAX_CLIENT_UPDATES);
+        ::Exchange::ClientResponseLFQueue client_responses(Common::ME_MAX_CLIENT_UPDATES);
+        ::Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+        auto trade_engine = std::make_unique<TradeEngine>(1, Common::AlgoType::MAKER, ticker_cfg,
+                                                          &client_requests, &client_responses, &market_updates);
+
+        Common::Logger logger("market_maker_benchmark.log");
+        std::vector<std::unique_ptr<MarketOrderBook>> books;
+        for (Common::TickerId ticker_id = 0; ticker_id < num_tickers; ++ticker_id) {
+            books.push_back(std::make_unique<MarketOrderBook>(ticker_id, &logger));
+            books.back()->setTradeEngine(trade_engine.get());
+        }
+
+        SimulatedExchange exchange{trade_engine.get(), std::vector<std::vector<RestingOrder>>(num_tickers)};
+        std::vector<Touch> touches(num_tickers);
+        std::vector<int64_t> positions(num_tickers, 0);
+        Result result;
+        result.decision_times_.reserve(num_moves * 4);
+
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<Common::TickerId> ticker(0, num_tickers - 1);
+        std::uniform_int_distribution<int> move(-1, 1);
+        std::uniform_int_distribution<Common::Qty> touch_qty(1, 100);
+        std::uniform_int_distribution<Common::Qty> aggressor_qty(1, 2 * CLIP);
+        std::uniform_int_distribution<int> depth(0, 2);
+        std::uniform_int_distribution<int> percent(0, 99);
+        Common::OrderId next_market_order_id = 1;
+
+        auto publish = [&](Common::TickerId ticker_id, ::Exchange::MarketUpdateType type, Common::OrderId order_id,
+                           Common::Side side, Common::Price price, Common::Qty qty) {
+            const ::Exchange::MEMarketUpdate market_update{type, order_id, ticker_id, side, price, qty, order_id};
+            const auto start = Common::getCurrentNanos();
+            books[ticker_id]->onMarketUpdate(&market_update);
+            result.decision_times_.push_back(Common::getCurrentNanos() - start);
+            ++result.num_decisions_;
+            result.num_requests_ += exchange.drain(client_requests);
+        };
+
+        // Replace the order on one side of the touch, adding the new one before cancelling the old one so the BBO stays two sided.
+        auto replace = [&](Common::TickerId ticker_id, Common::Side side, Common::OrderId &order_id, Common::Price old_price,
+                           Common::Price new_price) {
+            const auto new_order_id = next_market_order_id++;
+            publish(ticker_id, ::Exchange::MarketUpdateType::ADD, new_order_id, side, new_price, touch_qty(rng));
+            if (order_id != Common::OrderId_INVALID)
+                publish(ticker_id, ::Exchange::MarketUpdateType::CANCEL, order_id, side, old_price, 0);
+            order_id = new_order_id;
+        };
+
+        for (size_t i = 0; i < num_moves; ++i) {
+            const auto ticker_id = ticker(rng);
+            auto &touch = touches[ticker_id];
+
+            const auto old_mid = touch.mid_;
+            touch.mid_ += move(rng);
+            replace(ticker_id, Common::Side::BUY, touch.bid_order_id_, old_mid - 1, touch.mid_ - 1);
+            replace(ticker_id, Common::Side::SELL, touch.ask_order_id_, old_mid + 1, touch.mid_ + 1);
+
+            // Aggressive flow on a third of the moves, sweeping up to two ticks through the touch.
+            if (percent(rng) < 33) {
+                const auto side = (percent(rng) < 50 ? Common::Side::BUY : Common::Side::SELL);
+                const auto limit_price = (side == Common::Side::BUY ? touch.mid_ + 1 + depth(rng) : touch.mid_ - 1 - depth(rng));
+                const auto traded_before = result.traded_qty_;
+                exchange.sweep(ticker_id, side, limit_price, aggressor_qty(rng), result);
+                positions[ticker_id] -= Common::sideToValue(side) * static_cast<int64_t>(result.traded_qty_ - traded_before);
+                result.max_position_ = std::max(result.max_position_, std::abs(positions[ticker_id]));
+            }
+        }
+
+        return result;
+    }
+
+    auto report(const char *name, Result &result) {
+        auto &times = result.decision_times_;
+        std::sort(times.begin(), times.end());
+        auto percentile = [&](size_t per_mille) {
+            return times.empty() ? 0 : times[times.size() * per_mille / 1000];
+        };
+
+        std::cout << name << std::endl;
+        std::cout << "  Decisions:          " << result.num_decisions_ << std::endl;
+        std::cout << "  Requests:           " << result.num_requests_ << std::endl;
+        std::cout << "  Fills:              " << result.num_fills_ << " (" << result.traded_qty_ << " qty)" << std::endl;
+        std::cout << "  Quote to trade:     " << (result.num_fills_ ? static_cast<double>(result.num_requests_) / result.num_fills_ : 0) << std::endl;
+        std::cout << "  Max abs position:   " << result.max_position_ << std::endl;
+        std::cout << "  Latency / decision: p50:" << percentile(500) << " p99:" << percentile(990) << " p99.9:" << percentile(999) << " ns" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t num_moves = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50'000);
+    const Common::Price hysteresis = (argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 2);
+    const Common::TickerId num_tickers = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 2);
+
+    // Latency covers the book update, feature engine, quoting engine, order manager and risk checks, up to the requests being queued.
+    auto baseline = run(num_moves, 0, num_tickers);
+    report("No hysteresis:", baseline);
+    auto banded = run(num_moves, hysteresis, num_tickers);
+    report(("Hysteresis " + std::to_string(hysteresis) + " ticks:").c_str(), banded);
+
+    // Refused layers - with orders over the size limit nothing is sent, the same decision again has to re-quote. Once
+    // the limit allows the orders they are sent, and the same decision after that has nothing left to do.
+    bool ok = true;
+    {
+        Common::TradeEngineCfgHashMap ticker_cfg;
+        for (auto &cfg : ticker_cfg) {
+            cfg.clip_ = CLIP;
+            cfg.risk_cfg_.max_order_size_ = CLIP - 1;
+            cfg.risk_cfg_.max_position_ = CLIP * NUM_LEVELS * 2;
+            cfg.risk_cfg_.max_loss_ = -1e12;
+            cfg.quote_cfg_.num_levels_ = NUM_LEVELS;
+        }
+        ::Exchange::ClientRequestLFQueue client_requests(Common::ME_MAX_CLIENT_UPDATES);
+        ::Exchange::ClientResponseLFQueue client_responses(Common::ME_MAX_CLIENT_UPDATES);
+        ::Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+        auto trade_engine = std::make_unique<TradeEngine>(1, Common::AlgoType::INVALID, ticker_cfg,
+                                                          &client_requests, &client_responses, &market_updates);
+        Common::Logger logger("market_maker_benchmark.log");
+        auto position_keeper = std::make_unique<PositionKeeper>(&logger);
+        auto risk_manager = std::make_unique<RiskManager>(&logger, position_keeper.get(), ticker_cfg);
+        auto order_manager = std::make_unique<OrderManager>(&logger, trade_engine.get(), *risk_manager);
+        auto quoting_engine = std::make_unique<QuotingEngine>(ticker_cfg);
+
+        BBO bbo;
+        bbo.bid_price_ = 99'999;
+        bbo.ask_price_ = 100'001;
+        size_t num_sent = 0;
+        const auto decide = [&]() {
+            const auto requote = quoting_engine->update(0, &bbo, 100'000, 0, 0, Common::InstrumentScale{});
+            if (requote[0]) {
+                const auto &bids = quoting_engine->getLadder(0, Common::Side::BUY);
+                quoting_engine->onLadderSent(0, Common::Side::BUY,
+                                             order_manager->moveLayers(0, Common::Side::BUY, bids.prices_.data(), bids.qtys_.data(), bids.num_levels_));
+            }
+            for (; client_requests.getNextToRead(); client_requests.updateReadIndex())
+                ++num_sent;
+            return requote[0];
+        };
+
+        const auto refused = decide();
+        const auto retried = decide();
+        const auto sent_refused = num_sent;
+        auto risk_cfg = ticker_cfg[0].risk_cfg_;
+        risk_cfg.max_order_size_ = CLIP;
+        risk_manager->setRiskCfg(0, risk_cfg);
+        const auto allowed = decide();
+        const auto again = decide();
+        std::cout << "Refused layers:     re-quoted " << (retried ? "yes" : "no") << ", " << num_sent - sent_refused
+                  << " sent once allowed, re-quoted after " << (again ? "yes" : "no") << std::endl;
+        ok &= (refused && retried && sent_refused == 0 && allowed && num_sent == NUM_LEVELS && !again);
+    }
+
+    // Tick grid - with a tick of 5 price units and a fair price off the grid, every level of both ladders is on the
+    // grid and the levels are one tick apart.
+    {
+        Common::TradeEngineCfgHashMap ticker_cfg;
+        for (auto &cfg : ticker_cfg) {
+            cfg.clip_ = CLIP;
+            cfg.risk_cfg_.max_position_ = CLIP * NUM_LEVELS * 2;
+            cfg.quote_cfg_.num_levels_ = NUM_LEVELS;
+        }
+        auto quoting_engine = std::make_unique<QuotingEngine>(ticker_cfg);
+
+        Common::InstrumentScale scale;
+        scale.tick_size_ = 5;
+        BBO bbo;
+        bbo.bid_price_ = 99'995;
+        bbo.ask_price_ = 100'005;
+        quoting_engine->update(0, &bbo, 100'001, 0, 0, scale);
+
+        bool on_grid = true;
+        for (const auto side : {Common::Side::BUY, Common::Side::SELL}) {
+            const auto &ladder = quoting_engine->getLadder(0, side);
+            on_grid &= (ladder.num_levels_ == NUM_LEVELS);
+            for (size_t i = 0; i < ladder.num_levels_; ++i) {
+                on_grid &= (ladder.prices_[i] % scale.tick_size_ == 0);
+                if (i)
+                    on_grid &= (std::abs(ladder.prices_[i] - ladder.prices_[i - 1]) == scale.tick_size_);
+            }
+        }
+        const auto &bids = quoting_engine->getLadder(0, Common::Side::BUY);
+        const auto &asks = quoting_engine->getLadder(0, Common::Side::SELL);
+        std::cout << "Tick grid:          tick:" << scale.tick_size_ << " bid:" << bids.top() << " ask:" << asks.top()
+                  << (on_grid ? " on grid" : " OFF GRID") << std::endl;
+        ok &= (on_grid && bids.top() < bbo.ask_price_ && asks.top() > bbo.bid_price_);
+    }
+
+    // Inventory skew and volatility - a long position moves both quotes down and a short one up, away from the side
+    // which would add to the position, and the spread widens as volatility rises. The touch is far enough not to bind.
+    {
+        Common::TradeEngineCfgHashMap ticker_cfg;
+        for (auto &cfg : ticker_cfg) {
+            cfg.clip_ = CLIP;
+            cfg.risk_cfg_.max_position_ = CLIP * NUM_LEVELS * 2;
+            cfg.quote_cfg_.num_levels_ = NUM_LEVELS;
+            cfg.quote_cfg_.horizon_ = 10;
+        }
+        auto quoting_engine = std::make_unique<QuotingEngine>(ticker_cfg);
+
+        BBO bbo;
+        bbo.bid_price_ = 99'000;
+        bbo.ask_price_ = 101'000;
+        const auto quote = [&](int64_t position, double volatility) {
+            quoting_engine->update(0, &bbo, 100'000, volatility, position, Common::InstrumentScale{});
+            return std::make_pair(quoting_engine->getLadder(0, Common::Side::BUY).top(),
+                                  quoting_engine->getLadder(0, Common::Side::SELL).top());
+        };
+
+        const auto flat = quote(0, 1e-4);
+        const auto long_position = quote(CLIP, 1e-4);
+        const auto short_position = quote(-static_cast<int64_t>(CLIP), 1e-4);
+        const auto skewed = (long_position.first < flat.first && long_position.second < flat.second &&
+                             short_position.first > flat.first && short_position.second > flat.second);
+        std::cout << "Inventory skew:     flat " << flat.first << "/" << flat.second << ", long " << long_position.first << "/"
+                  << long_position.second << ", short " << short_position.first << "/" << short_position.second << std::endl;
+        ok &= skewed;
+
+        std::vector<Common::Price> spreads;
+        for (const auto volatility : {0.0, 1e-4, 2e-4, 4e-4}) {
+            const auto [bid, ask] = quote(0, volatility);
+            spreads.push_back(ask - bid);
+        }
+        std::cout << "Volatility spread:  ";
+        for (const auto spread : spreads)
+            std::cout << spread << " ";
+        std::cout << "at 0/1e-4/2e-4/4e-4" << std::endl;
+        ok &= (spreads.front() > 0 && std::is_sorted(spreads.begin(), spreads.end()) &&
+               std::adjacent_find(spreads.begin(), spreads.end()) == spreads.end());
+    }
+
+    // Liquidity on a coarse tick grid - kappa is per tick, so with a tick of 5 price units the spread still widens as
+    // the book gets thinner (1 / kappa grows) instead of staying at the touch.
+    {
+        Common::TradeEngineCfgHashMap ticker_cfg;
+        for (auto &cfg : ticker_cfg) {
+            cfg.clip_ = CLIP;
+            cfg.risk_cfg_.max_position_ = CLIP * NUM_LEVELS * 2;
+            cfg.quote_cfg_.num_levels_ = NUM_LEVELS;
+        }
+        auto quoting_engine = std::make_unique<QuotingEngine>(ticker_cfg);
+
+        Common::InstrumentScale scale;
+        scale.tick_size_ = 5;
+        BBO bbo;
+        bbo.bid_price_ = 99'000;
+        bbo.ask_price_ = 101'000;
+        std::vector<Common::Price> spreads;
+        for (const auto liquidity : {1.5, 0.5, 0.1, 0.02}) {
+            auto quote_cfg = ticker_cfg[0].quote_cfg_;
+            quote_cfg.liquidity_ = liquidity;
+            quoting_engine->configure(0, quote_cfg);
+            quoting_engine->update(0, &bbo, 100'000, 0, 0, scale);
+            spreads.push_back(quoting_engine->getLadder(0, Common::Side::SELL).top() - quoting_engine->getLadder(0, Common::Side::BUY).top());
+        }
+        std::cout << "Liquidity spread:   ";
+        for (const auto spread : spreads)
+            std::cout << spread << " ";
+        std::cout << "at kappa 1.5/0.5/0.1/0.02, tick:" << scale.tick_size_ << std::endl;
+        ok &= (spreads.front() >= 2 * scale.tick_size_ && std::is_sorted(spreads.begin(), spreads.end()) &&
+               std::adjacent_find(spreads.begin(), spreads.end()) == spreads.end());
+    }
+
+    std::cout << "Result:             " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
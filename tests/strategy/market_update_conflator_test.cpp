@@ -0,0 +1,192 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/logging.h"
+#include "trading/market_data/market_update_conflator.h"
+#include "trading/strategy/trade_engine.h"
+
+// Two thread test of the market data conflator - a producer hammers one ticker with ADD / MODIFY / CANCEL / CLEAR /
+// TRADE updates while a consumer drains the conflator into a MarketOrderBook. Checks the drained book ends up equal to
+// the last book produced, level for level and at the top of book, that every trade comes through once and in order,
+// that trades and level updates come through in the order they were produced - no level is published after a trade it
+// was last written before, or before a trade it was written after - that no drain pass publishes more book updates
+// than there are levels, and that no level was dropped. A single threaded drain of a fixed sequence checks the same
+// order update for update.
+// Usage: market_update_conflator_test [NUM_UPDATES]
+
+namespace {
+    constexpr Common::TickerId TICKER_ID = 0;
+    constexpr Common::Price MID = 100'000;
+
+    /// Bids at [MID - NUM_PRICES_PER_SIDE, MID - 1], asks at [MID, MID + NUM_PRICES_PER_SIDE - 1] - no two levels
+    /// share a slot of the MarketOrderBook's price index.
+    constexpr Common::Price NUM_PRICES_PER_SIDE = 64;
+    constexpr size_t NUM_LEVELS = 2 * NUM_PRICES_PER_SIDE;
+
+    using Book = std::map<std::pair<Common::Side, Common::Price>, Common::Qty>;
+
+    auto bestPrice(const Book &book, Common::Side side) {
+        auto best = Common::Price_INVALID;
+        Common::Qty qty = Common::Qty_INVALID;
+        for (const auto &[level, level_qty]: book) {
+            if (level.first == side && (best == Common::Price_INVALID ||
+                                        (side == Common::Side::BUY ? level.second > best : level.second < best))) {
+                best = level.second;
+                qty = level_qty;
+            }
+        }
+        return std::make_pair(best, qty);
+    }
+
+    /// Drains A = 10, trade 1, B = 20, trade 2, A = 30 in one pass - B goes between the trades, A after the last.
+    auto checkSequenceOrder(Common::Logger *logger) {
+        Trading::MarketUpdateConflator conflator(logger);
+        const auto add = [&](Exchange::MarketUpdateType type, Common::Price price, Common::Qty qty) {
+            conflator.onMarketUpdate({type, Common::OrderId_INVALID, TICKER_ID, Common::Side::BUY, price, qty, 0});
+        };
+        add(Exchange::MarketUpdateType::ADD, MID - 1, 10);
+        add(Exchange::MarketUpdateType::TRADE, MID - 1, 1);
+        add(Exchange::MarketUpdateType::ADD, MID - 2, 20);
+        add(Exchange::MarketUpdateType::TRADE, MID - 2, 2);
+        add(Exchange::MarketUpdateType::MODIFY, MID - 1, 30);
+
+        std::string order;
+        conflator.drain([&](const Exchange::MEMarketUpdate *market_update) {
+            if (!order.empty())
+                order += ' ';
+            if (market_update->type_ == Exchange::MarketUpdateType::TRADE)
+                order += 'T';
+            else
+                order += (market_update->price_ == MID - 1 ? 'A' : 'B');
+            order += std::to_string(market_update->qty_);
+        });
+        return order;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_updates = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000);
+
+    Common::TradeEngineCfgHashMap ticker_cfg;
+    Exchange::ClientRequestLFQueue client_requests(Common::ME_MAX_CLIENT_UPDATES);
+    Exchange::ClientResponseLFQueue client_responses(Common::ME_MAX_CLIENT_UPDATES);
+    Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+    auto trade_engine = std::make_unique<Trading::TradeEngine>(1, Common::AlgoType::INVALID, ticker_cfg,
+                                                               &client_requests, &client_responses, &market_updates);
+
+    Common::Logger logger("market_update_conflator_test.log");
+    auto conflator = std::make_unique<Trading::MarketUpdateConflator>(&logger);
+    auto order_book = std::make_unique<Trading::MarketOrderBook>(TICKER_ID, &logger);
+    order_book->setTradeEngine(trade_engine.get());
+
+    // Producer - the book it last produced and the trades it sent, each trade's quantity is its sequence number and
+    // each level's quantity the index of the update which last wrote it. trade_index[n] is the index of trade n.
+    Book produced;
+    size_t num_trades_sent = 0;
+    std::vector<size_t> trade_index(num_updates + 1, 0);
+    std::atomic<bool> produced_all = false;
+    std::thread producer([&] {
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<int> action(0, 999);
+        std::uniform_int_distribution<Common::Price> offset(0, NUM_PRICES_PER_SIDE - 1);
+
+        Exchange::MEMarketUpdate update;
+        update.ticker_id_ = TICKER_ID;
+        for (size_t i = 0; i < num_updates; ++i) {
+            const auto side = (rng() & 1 ? Common::Side::BUY : Common::Side::SELL);
+            const auto price = (side == Common::Side::BUY ? MID - 1 - offset(rng) : MID + offset(rng));
+            const auto roll = action(rng);
+            update.side_ = side;
+            update.price_ = price;
+            if (roll < 5) {
+                update.type_ = Exchange::MarketUpdateType::CLEAR;
+                produced.clear();
+            } else if (roll < 15) {
+                update.type_ = Exchange::MarketUpdateType::TRADE;
+                update.qty_ = static_cast<Common::Qty>(++num_trades_sent);
+                trade_index[num_trades_sent] = i + 1;
+            } else if (roll < 300) {
+                update.type_ = Exchange::MarketUpdateType::CANCEL;
+                produced.erase({side, price});
+            } else {
+                update.type_ = (produced.count({side, price}) ? Exchange::MarketUpdateType::MODIFY : Exchange::MarketUpdateType::ADD);
+                update.qty_ = static_cast<Common::Qty>(i + 1);
+                produced[{side, price}] = update.qty_;
+            }
+            conflator->onMarketUpdate(update);
+        }
+        produced_all.store(true, std::memory_order_release);
+    });
+
+    // Consumer - applies every drained update to the order book and keeps the book it was drained, by level.
+    Book drained;
+    size_t num_passes = 0, num_book_updates = 0, max_book_updates_per_pass = 0;
+    size_t num_trades_received = 0, num_trades_out_of_order = 0;
+    size_t last_trade_index = 0, max_level_index_since_trade = 0, num_out_of_sequence = 0;
+    while (true) {
+        const auto finished = produced_all.load(std::memory_order_acquire);
+        size_t book_updates = 0;
+        conflator->drain([&](const Exchange::MEMarketUpdate *market_update) {
+            if (market_update->type_ == Exchange::MarketUpdateType::TRADE) {
+                num_trades_out_of_order += (market_update->qty_ != static_cast<Common::Qty>(num_trades_received + 1));
+                ++num_trades_received;
+                const auto index = trade_index[market_update->qty_];
+                num_out_of_sequence += (max_level_index_since_trade > index);
+                last_trade_index = index;
+                max_level_index_since_trade = 0;
+            } else {
+                if (market_update->type_ == Exchange::MarketUpdateType::CANCEL) {
+                    drained.erase({market_update->side_, market_update->price_});
+                } else {
+                    drained[{market_update->side_, market_update->price_}] = market_update->qty_;
+                    num_out_of_sequence += (market_update->qty_ <= last_trade_index);
+                    max_level_index_since_trade = std::max<size_t>(max_level_index_since_trade, market_update->qty_);
+                }
+                ++book_updates;
+            }
+            order_book->onMarketUpdate(market_update);
+        });
+        ++num_passes;
+        num_book_updates += book_updates;
+        max_book_updates_per_pass = std::max(max_book_updates_per_pass, book_updates);
+        if (finished && !conflator->hasPending())
+            break;
+    }
+    producer.join();
+
+    const auto sequence_order = checkSequenceOrder(&logger);
+    const bool sequence_order_ok = (sequence_order == "T1 B20 T2 A30");
+
+    const auto bbo = order_book->getBBO();
+    const auto [best_bid, best_bid_qty] = bestPrice(produced, Common::Side::BUY);
+    const auto [best_ask, best_ask_qty] = bestPrice(produced, Common::Side::SELL);
+    const bool books_equal = (drained == produced);
+    const bool bbo_equal = (bbo->bid_price_ == best_bid && bbo->bid_qty_ == best_bid_qty &&
+                            bbo->ask_price_ == best_ask && bbo->ask_qty_ == best_ask_qty);
+
+    std::cout << "Updates in:          " << conflator->updatesIn() << std::endl;
+    std::cout << "Book updates out:    " << num_book_updates << " over " << num_passes << " drain passes" << std::endl;
+    std::cout << "Max per pass:        " << max_book_updates_per_pass << " (" << NUM_LEVELS << " levels)" << std::endl;
+    std::cout << "Trades:              " << num_trades_received << " of " << num_trades_sent << " received, "
+              << num_trades_out_of_order << " out of order" << std::endl;
+    std::cout << "Level / trade order: " << num_out_of_sequence << " level updates out of sequence" << std::endl;
+    std::cout << "Sequence order:      " << sequence_order << (sequence_order_ok ? " as expected" : " expected T1 B20 T2 A30") << std::endl;
+    std::cout << "Dropped levels:      " << conflator->droppedLevels() << std::endl;
+    std::cout << "Final book:          " << produced.size() << " levels produced, " << drained.size() << " drained, "
+              << (books_equal ? "equal" : "DIFFERENT") << std::endl;
+    std::cout << "Top of book:         " << bbo->toString() << (bbo_equal ? " equal" : " DIFFERENT") << std::endl;
+
+    const bool ok = (conflator->updatesIn() == num_updates && books_equal && bbo_equal &&
+                     num_trades_received == num_trades_sent && !num_trades_out_of_order &&
+                     !num_out_of_sequence && sequence_order_ok &&
+                     max_book_updates_per_pass <= NUM_LEVELS && !conflator->droppedLevels());
+    std::cout << "Result:              " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
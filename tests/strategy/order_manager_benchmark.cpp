@@ -0,0 +1,159 @@
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "trading/strategy/order_manager.h"
+#include "trading/strategy/trade_engine.h"
+
+// Benchmark of re-quoting a ladder of 10 orders per side through the OrderManager.
+// Every quote update moves both ladders by a random number of ticks and re-sizes the top layer, which turns into
+// MODIFY requests for the layers which changed. The requests are acknowledged straight away, as an exchange would, before the next quote update.
+// Checks the layers stay linked in order, that a modify is risk checked for the quantity it books and that a fill
+// while a modify is in flight is not working again once it is acknowledged.
+// Usage: order_manager_benchmark [NUM_QUOTE_UPDATES]
+
+namespace {
+    constexpr size_t NUM_LAYERS = 10;
+    constexpr Common::TickerId TICKER_ID = 0;
+}
+
+int main(int argc, char** argv) {
+    const size_t num_quote_updates = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000);
+
+    Common::TradeEngineCfgHashMap ticker_cfg;
+    for (auto& cfg : ticker_cfg) {
+        cfg.clip_ = 10;
+        cfg.risk_cfg_.max_order_size_ = 1'000;
+        cfg.risk_cfg_.max_position_ = 1'000'000;
+        cfg.risk_cfg_.max_loss_ = -1e12;
+    }
+
+    Exchange::ClientRequestLFQueue client_requests(Common::ME_MAX_CLIENT_UPDATES);
+    Exchange::ClientResponseLFQueue client_responses(Common::ME_MAX_CLIENT_UPDATES);
+    Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+    auto trade_engine = std::make_unique<Trading::TradeEngine>(1, Common::AlgoType::INVALID, ticker_cfg,
+                                                               &client_requests, &client_responses, &market_updates);
+
+    Common::Logger logger("order_manager_benchmark.log");
+    auto position_keeper = std::make_unique<Trading::PositionKeeper>(&logger);
+    auto risk_manager = std::make_unique<Trading::RiskManager>(&logger, position_keeper.get(), ticker_cfg);
+    auto order_manager = std::make_unique<Trading::OrderManager>(&logger, trade_engine.get(), *risk_manager);
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> move(-2, 2);
+    std::uniform_int_distribution<Common::Qty> qty(1, 3);
+
+    std::array<Common::Price, NUM_LAYERS> bid_prices, ask_prices;
+    std::array<Common::Qty, NUM_LAYERS> bid_qtys, ask_qtys;
+    Common::Price mid = 100'000;
+    size_t num_requests = 0;
+
+    const auto start = Common::getCurrentNanos();
+    for (size_t i = 0; i < num_quote_updates; ++i) {
+        mid += move(rng);
+        for (size_t layer = 0; layer < NUM_LAYERS; ++layer) {
+            bid_prices[layer] = mid - 1 - static_cast<Common::Price>(layer);
+            ask_prices[layer] = mid + 1 + static_cast<Common::Price>(layer);
+            bid_qtys[layer] = ask_qtys[layer] = 10;
+        }
+        bid_qtys[0] = qty(rng) * 10;
+        ask_qtys[0] = qty(rng) * 10;
+        order_manager->moveLayers(TICKER_ID, Common::Side::BUY, bid_prices.data(), bid_qtys.data(), NUM_LAYERS);
+        order_manager->moveLayers(TICKER_ID, Common::Side::SELL, ask_prices.data(), ask_qtys.data(), NUM_LAYERS);
+
+        // Acknowledge every request, the new price and quantity are working from now on
+        for (auto request = client_requests.getNextToRead(); request; request = client_requests.getNextToRead()) {
+            Exchange::MEClientResponse response{Exchange::ClientResponseType::ACCEPTED,
+                                                Exchange::ClientResponseRejectReason::INVALID, request->client_id_,
+                                                request->ticker_id_, request->order_id_, request->side_,
+                                                request->price_, 0, request->qty_};
+            if (request->type_ == Exchange::ClientRequestType::CANCEL) {
+                response.type_ = Exchange::ClientResponseType::CANCELED;
+                response.leaves_qty_ = 0;
+            }
+            order_manager->onOrderUpdate(&response);
+            client_requests.updateReadIndex();
+            ++num_requests;
+        }
+    }
+    const auto elapsed = Common::getCurrentNanos() - start;
+
+    size_t num_working = 0;
+    for (auto side : {Common::Side::BUY, Common::Side::SELL}) {
+        for (auto order = order_manager->getOMOrderSideHashMap(TICKER_ID)->at(Common::sideToIndex(side)); order;
+             order = order->next_order_)
+            ++num_working;
+    }
+
+    std::cout << "Quote updates:      " << num_quote_updates << " (" << NUM_LAYERS << " layers per side)" << std::endl;
+    std::cout << "Requests sent:      " << num_requests << std::endl;
+    std::cout << "Working orders:     " << num_working << std::endl;
+    std::cout << "Quote updates/sec:  " << static_cast<double>(num_quote_updates) * 1e9 / static_cast<double>(elapsed) << std::endl;
+    std::cout << "Requests/sec:       " << static_cast<double>(num_requests) * 1e9 / static_cast<double>(elapsed) << std::endl;
+
+    // Layers - linked both ways, in the order they were created, every one of them still working.
+    bool ok = true;
+    size_t num_linked = 0;
+    for (auto side : {Common::Side::BUY, Common::Side::SELL}) {
+        const Trading::OMOrder *prev_order = nullptr;
+        for (auto order = order_manager->getOMOrderSideHashMap(TICKER_ID)->at(Common::sideToIndex(side)); order;
+             prev_order = order, order = order->next_order_) {
+            ok &= (order->prev_order_ == prev_order && (!prev_order || prev_order->order_id_ < order->order_id_));
+            ++num_linked;
+        }
+    }
+    ok &= (num_linked == 2 * NUM_LAYERS);
+
+    // A modify is checked for what it books - until it is acknowledged the larger of the two quantities may fill.
+    // 10@100 re-priced to 5@250 is 2'500 of notional in flight, over a 1'500 limit even though 5@250 alone is not.
+    {
+        Trading::PortfolioRiskCfg portfolio_cfg;
+        portfolio_cfg.max_gross_notional_ = 1'500;
+        auto keeper = std::make_unique<Trading::PositionKeeper>(&logger);
+        auto risk = std::make_unique<Trading::RiskManager>(&logger, keeper.get(), ticker_cfg);
+        risk->setPortfolioRiskCfg(portfolio_cfg);
+        auto manager = std::make_unique<Trading::OrderManager>(&logger, trade_engine.get(), *risk);
+        auto order = manager->newOrder(TICKER_ID, 100, Common::Side::BUY, 10);
+        const Exchange::MEClientResponse accepted{Exchange::ClientResponseType::ACCEPTED, Exchange::ClientResponseRejectReason::INVALID,
+                                                  1, TICKER_ID, order->order_id_, Common::Side::BUY, 100, 0, 10};
+        manager->onOrderUpdate(&accepted);
+        const bool over_limit = manager->modifyOrder(order, 250, 5);
+        const bool within_limit = manager->modifyOrder(order, 150, 5);
+        std::cout << "Modify risk check:  10@100 -> 5@250 " << (over_limit ? "allowed" : "refused") << ", -> 5@150 "
+                  << (within_limit ? "allowed" : "refused") << std::endl;
+        ok &= (!over_limit && within_limit);
+        while (client_requests.getNextToRead())
+            client_requests.updateReadIndex();
+    }
+
+    // A fill at the old price while a modify is in flight is not working again once the modify is acknowledged.
+    // 10@100 -> 5@101, 3 fill at 100 before the ack, which leaves 2 of the 5 working.
+    {
+        auto keeper = std::make_unique<Trading::PositionKeeper>(&logger);
+        auto risk = std::make_unique<Trading::RiskManager>(&logger, keeper.get(), ticker_cfg);
+        auto manager = std::make_unique<Trading::OrderManager>(&logger, trade_engine.get(), *risk);
+        auto order = manager->newOrder(TICKER_ID, 100, Common::Side::BUY, 10);
+        const Exchange::MEClientResponse accepted{Exchange::ClientResponseType::ACCEPTED, Exchange::ClientResponseRejectReason::INVALID,
+                                                  1, TICKER_ID, order->order_id_, Common::Side::BUY, 100, 0, 10};
+        manager->onOrderUpdate(&accepted);
+        manager->modifyOrder(order, 101, 5);
+        const Exchange::MEClientResponse filled{Exchange::ClientResponseType::PARTIALLY_FILLED, Exchange::ClientResponseRejectReason::INVALID,
+                                                1, TICKER_ID, order->order_id_, Common::Side::BUY, 100, 3, 7};
+        manager->onOrderUpdate(&filled);
+        const Exchange::MEClientResponse modified{Exchange::ClientResponseType::ACCEPTED, Exchange::ClientResponseRejectReason::INVALID,
+                                                  1, TICKER_ID, order->order_id_, Common::Side::BUY, 101, 0, 2};
+        manager->onOrderUpdate(&modified);
+        std::cout << "Fill during modify: working " << order->qty_ << "@" << order->price_ << ", risk qty "
+                  << order->risk_qty_ << std::endl;
+        ok &= (order->order_state_ == Trading::OMOrderState::LIVE && order->price_ == 101 && order->qty_ == 2 &&
+               order->risk_qty_ == 2);
+        while (client_requests.getNextToRead())
+            client_requests.updateReadIndex();
+    }
+
+    std::cout << "Result:             " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
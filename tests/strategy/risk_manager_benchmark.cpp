@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "trading/strategy/position_keeper.h"
+#include "trading/strategy/risk_manager.h"
+
+// Benchmark of the pre-trade risk check with all limits enabled, while another thread keeps replacing the limits.
+// Checks a ticker's exposure is taken back from the venue it was booked to after the ticker moved to another venue.
+// Usage: risk_manager_benchmark [NUM_CHECKS]
+
+namespace {
+    struct Check {
+        Common::TickerId ticker_id;
+        Common::Side side;
+        Common::Price price;
+        Common::Qty qty;
+    };
+
+    // Orders around the BBO mid with the occasional fat finger price and oversized order
+    std::vector<Check> generateChecks(size_t num_checks) {
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<Common::TickerId> ticker(0, Common::ME_MAX_TICKERS - 1);
+        std::uniform_int_distribution<int> offset(-20, 20);
+        std::uniform_int_distribution<int> kind(0, 99);
+        std::uniform_int_distribution<Common::Qty> qty(1, 100);
+
+        std::vector<Check> checks;
+        checks.reserve(num_checks);
+        for (size_t i = 0; i < num_checks; ++i) {
+            const auto side = (kind(rng) < 50 ? Common::Side::BUY : Common::Side::SELL);
+            const auto fat_finger = (kind(rng) == 0 ? 5'000 : 0);
+            checks.push_back({ticker(rng), side, 100'000 + offset(rng) + fat_finger, qty(rng) * (kind(rng) == 0 ? 10 : 1)});
+        }
+        return checks;
+    }
+
+    Common::RiskCfg makeRiskCfg(Common::Qty max_position) {
+        Common::RiskCfg risk_cfg;
+        risk_cfg.max_order_size_ = 500;
+        risk_cfg.max_position_ = max_position;
+        risk_cfg.max_loss_ = -1e12;
+        risk_cfg.max_orders_per_sec_ = 1'000'000;
+        risk_cfg.max_order_burst_ = 100;
+        risk_cfg.price_band_bps_ = 100;
+        return risk_cfg;
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t num_checks = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5'000'000);
+    const auto checks = generateChecks(num_checks);
+
+    Common::Logger logger("risk_manager_benchmark.log");
+    auto position_keeper = std::make_unique<Trading::PositionKeeper>(&logger);
+
+    Common::TradeEngineCfgHashMap ticker_cfg;
+    for (auto& cfg : ticker_cfg)
+        cfg.risk_cfg_ = makeRiskCfg(5'000);
+    auto risk_manager = std::make_unique<Trading::RiskManager>(&logger, position_keeper.get(), ticker_cfg);
+
+    Trading::PortfolioRiskCfg portfolio_cfg;
+    portfolio_cfg.max_gross_notional_ = 1'000'000'000;
+    portfolio_cfg.max_venue_notional_.fill(1'000'000'000);
+    portfolio_cfg.max_orders_per_sec_ = 5'000'000;
+    portfolio_cfg.max_order_burst_ = 1'000;
+    risk_manager->setPortfolioRiskCfg(portfolio_cfg);
+
+    std::vector<Trading::BBO> bbos(Common::ME_MAX_TICKERS);
+    for (Common::TickerId ticker_id = 0; ticker_id < Common::ME_MAX_TICKERS; ++ticker_id) {
+        bbos[ticker_id].bid_price_ = 99'995;
+        bbos[ticker_id].ask_price_ = 100'005;
+        position_keeper->updateBBO(ticker_id, &bbos[ticker_id]);
+    }
+
+    // Limit updater - alternates the position limits of every ticker every 100us
+    std::atomic<bool> run{true};
+    size_t num_updates = 0;
+    std::thread updater([&]() {
+        for (Common::Qty max_position = 1'000; run.load(std::memory_order_relaxed); max_position ^= (1'000 ^ 5'000)) {
+            for (Common::TickerId ticker_id = 0; ticker_id < Common::ME_MAX_TICKERS; ++ticker_id)
+                risk_manager->setRiskCfg(ticker_id, makeRiskCfg(max_position));
+            ++num_updates;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    std::map<Trading::RiskCheckResult, size_t> results;
+    std::vector<Common::Nanos> check_times;
+    check_times.reserve(num_checks);
+    for (const auto& check : checks) {
+        const auto start = Common::getCurrentNanos();
+        const auto result = risk_manager->checkPreTradeRisk(check.ticker_id, check.side, check.price, check.qty, start);
+        check_times.push_back(Common::getCurrentNanos() - start);
+        ++results[result];
+
+        // Work the order until the next check on the same ticker and side would need to cancel it
+        if (result == Trading::RiskCheckResult::ALLOWED) {
+            risk_manager->onOrderSent(check.ticker_id, check.side, check.price, check.qty);
+            risk_manager->onOrderReleased(check.ticker_id, check.side, check.qty);
+        }
+    }
+
+    run = false;
+    updater.join();
+
+    std::cout << "Checks:          " << num_checks << std::endl;
+    // Cost of the timing itself, to report the check on its own
+    std::vector<Common::Nanos> clock_times(num_checks);
+    for (auto& clock_time : clock_times) {
+        const auto start = Common::getCurrentNanos();
+        clock_time = Common::getCurrentNanos() - start;
+    }
+    std::sort(clock_times.begin(), clock_times.end());
+
+    // Percentiles rather than the mean, so preemption by the limit updater and logger threads does not skew the result
+    std::sort(check_times.begin(), check_times.end());
+    std::cout << "Cost per check:  p50:" << check_times[num_checks / 2] << " p99:" << check_times[num_checks * 99 / 100]
+              << " p99.9:" << check_times[num_checks * 999 / 1000] << " ns" << std::endl;
+    std::cout << "Timing overhead: p50:" << clock_times[num_checks / 2] << " ns" << std::endl;
+    std::cout << "Limit updates:   " << num_updates * Common::ME_MAX_TICKERS << " concurrent" << std::endl;
+    for (const auto& [result, count] : results)
+        std::cout << std::setw(30) << std::left << Trading::riskCheckResultToString(result) << count << std::endl;
+    std::cout << "Gross notional:  " << risk_manager->grossNotional() << std::endl;
+
+    // Moving venues - an order worked on venue 0, the ticker moved to venue 1, then the order released. Its exposure
+    // leaves venue 0, where it was booked, and venue 1 never sees it.
+    bool ok = true;
+    {
+        Trading::RiskManager venues(&logger, position_keeper.get(), ticker_cfg);
+        venues.onOrderSent(0, Common::Side::BUY, 100'000, 10);
+        const auto booked = venues.venueNotional(0);
+        auto risk_cfg = makeRiskCfg(5'000);
+        risk_cfg.venue_id_ = 1;
+        venues.setRiskCfg(0, risk_cfg);
+        venues.onOrderReleased(0, Common::Side::BUY, 10);
+        std::cout << "Venue move:      " << booked << " booked on venue 0, then " << venues.venueNotional(0) << " / "
+                  << venues.venueNotional(1) << " on venue 0 / 1" << std::endl;
+        ok &= (booked > 0 && venues.venueNotional(0) == 0 && venues.venueNotional(1) == 0 && venues.grossNotional() == 0);
+    }
+
+    std::cout << "Result:          " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
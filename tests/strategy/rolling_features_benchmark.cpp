@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/time_utils.h"
+#include "trading/strategy/feature_store.h"
+#include "trading/strategy/rolling_features.h"
+
+// Benchmark of the per-ticker rolling feature library with every feature enabled. Also feeds the same randomised top of
+// book updates to the feature store with each of its batch kernels and checks the AVX2 and AVX-512 kernels agree with
+// the scalar one to within PARITY_TOLERANCE relative error, and checks the values of the aggressive trade ratio and
+// the trade size percentile on a known feed.
+// Usage: rolling_features_benchmark [NUM_EVENTS]
+
+namespace {
+    struct Event {
+        bool is_trade;
+        Common::Side side;
+        Common::Price bid_price, ask_price;
+        Common::Qty bid_qty, ask_qty, trade_qty;
+    };
+
+    // Random walk of the top of book with roughly one trade for every four quote updates
+    std::vector<Event> generateEvents(size_t num_events) {
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<int> step(-1, 1);
+        std::uniform_int_distribution<Common::Qty> qty(1, 500);
+        std::uniform_int_distribution<int> kind(0, 3);
+
+        std::vector<Event> events;
+        events.reserve(num_events);
+
+        Common::Price bid = 250000;
+        for (size_t i = 0; i < num_events; ++i) {
+            bid += step(rng);
+            const Common::Price ask = bid + 5 + step(rng) + 1;
+            const auto side = (step(rng) >= 0 ? Common::Side::BUY : Common::Side::SELL);
+            events.push_back({kind(rng) == 0, side, bid, ask, qty(rng), qty(rng), qty(rng)});
+        }
+        return events;
+    }
+
+    constexpr double PARITY_TOLERANCE = 2e-15;
+    constexpr size_t PARITY_ROUNDS = 20'000;
+
+    auto kernelName(Trading::FeatureStore::Kernel kernel) {
+        switch (kernel) {
+            case Trading::FeatureStore::Kernel::SCALAR:
+                return "scalar";
+            case Trading::FeatureStore::Kernel::AVX2:
+                return "AVX2";
+            case Trading::FeatureStore::Kernel::AVX512:
+                return "AVX-512";
+        }
+        return "unknown";
+    }
+
+    /// Largest relative difference of any feature of any ticker between the kernel and the scalar reference over
+    /// rounds of random subsets of tickers updating, including one sided and crossed quantities. Negative if this CPU
+    /// does not support the kernel.
+    double kernelParity(Trading::FeatureStore::Kernel kernel) {
+        auto reference = std::make_unique<Trading::FeatureStore>();
+        auto candidate = std::make_unique<Trading::FeatureStore>();
+        reference->setKernel(Trading::FeatureStore::Kernel::SCALAR);
+        candidate->setKernel(kernel);
+        if (candidate->kernel() != kernel)
+            return -1;
+
+        std::mt19937_64 rng(7);
+        std::uniform_int_distribution<int> step(-3, 3);
+        std::uniform_int_distribution<Common::Qty> qty(0, 5'000);
+        std::uniform_int_distribution<uint64_t> subset(1, (1ULL << Common::ME_MAX_TICKERS) - 1);
+        std::vector<Common::Price> bids(Common::ME_MAX_TICKERS);
+        for (auto& bid : bids)
+            bid = 100 + static_cast<Common::Price>(rng() % 10'000'000);
+
+        double max_error = 0;
+        const auto compare = [&max_error](double expected, double actual) {
+            // Tickers without a book yet are Feature_INVALID in both
+            if (std::isnan(expected) || std::isnan(actual)) {
+                max_error = (std::isnan(expected) == std::isnan(actual) ? max_error : INFINITY);
+                return;
+            }
+            const auto scale = std::max({1.0, std::abs(expected), std::abs(actual)});
+            max_error = std::max(max_error, std::abs(expected - actual) / scale);
+        };
+        for (size_t round = 0; round < PARITY_ROUNDS; ++round) {
+            for (auto dirty = subset(rng); dirty; dirty &= dirty - 1) {
+                const auto ticker_id = static_cast<Common::TickerId>(std::countr_zero(dirty));
+                auto& bid = bids[ticker_id];
+                bid = std::max<Common::Price>(bid + step(rng), 1);
+                const auto ask = bid + 1 + std::abs(step(rng));
+                // Never both quantities zero, the kernels divide by their sum
+                const auto bid_qty = qty(rng), ask_qty = std::max<Common::Qty>(qty(rng), !bid_qty);
+                reference->onBBO(ticker_id, bid, bid_qty, ask, ask_qty);
+                candidate->onBBO(ticker_id, bid, bid_qty, ask, ask_qty);
+            }
+            reference->compute();
+            candidate->compute();
+            for (Common::TickerId i = 0; i < Common::ME_MAX_TICKERS; ++i) {
+                compare(reference->microprice(i), candidate->microprice(i));
+                compare(reference->imbalance(i), candidate->imbalance(i));
+                compare(reference->spread(i), candidate->spread(i));
+                compare(reference->midZScore(i), candidate->midZScore(i));
+                compare(reference->imbalanceZScore(i), candidate->imbalanceZScore(i));
+            }
+        }
+        return max_error;
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t num_events = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5'000'000);
+    const auto events = generateEvents(num_events);
+
+    auto features = std::make_unique<Trading::TickerFeatures>();
+    Trading::FeatureCfg cfg;
+    cfg.vwap_time_window_ = 100 * Common::NANOS_TO_MICROS * 1000; // 100ms of synthetic time
+    features->configure(cfg);
+
+    // Synthetic clock, 1us per event, so the time window keeps evicting
+    Common::Nanos clock = 0;
+    size_t num_trades = 0;
+    double checksum = 0;
+
+    const auto start = Common::getCurrentNanos();
+    for (const auto& event : events) {
+        clock += Common::NANOS_TO_MICROS;
+        if (event.is_trade) {
+            features->onTrade(clock, event.side, event.side == Common::Side::BUY ? event.ask_price : event.bid_price, event.trade_qty);
+            ++num_trades;
+        } else {
+            features->onQuote(clock, event.bid_price, event.bid_qty, event.ask_price, event.ask_qty);
+        }
+        checksum += features->ofi();
+    }
+    const auto elapsed = Common::getCurrentNanos() - start;
+
+    std::cout << "Events:          " << num_events << " (" << num_trades << " trades)" << std::endl;
+    std::cout << "Cost per update: " << std::fixed << std::setprecision(1)
+              << static_cast<double>(elapsed) / static_cast<double>(num_events) << " ns" << std::endl;
+    std::cout << "Footprint:       " << sizeof(Trading::TickerFeatures) << " bytes per ticker" << std::endl;
+    std::cout << std::endl;
+    std::cout << "mkt-price:       " << features->mktPrice() << std::endl;
+    std::cout << "time-vwap:       " << features->timeVwap() << std::endl;
+    std::cout << "volume-vwap:     " << features->volumeVwap() << std::endl;
+    std::cout << "ewma-mid:        " << features->ewmaMid() << std::endl;
+    std::cout << "volatility:      " << std::setprecision(6) << features->volatility() << std::endl;
+    std::cout << "ofi:             " << features->ofi() << " ewma:" << features->ewmaOfi() << std::endl;
+    std::cout << "sign-autocorr:   " << features->tradeSignAutocorrelation() << std::endl;
+    std::cout << "spread:          " << features->spread() << " mean:" << features->spreadMean()
+              << " stddev:" << features->spreadStdDev() << std::endl;
+    std::cout << "trade-size p50:  " << features->volumeQuantiles().quantile(2)
+              << " p90:" << features->volumeQuantiles().quantile(4)
+              << " pct(250):" << features->volumePercentile(250) << std::endl;
+    std::cout << "checksum:        " << checksum << std::endl;
+    std::cout << std::endl;
+
+    // Feature values - the aggressive trade ratio is against the BBO side traded into and invalid if it showed no
+    // quantity, and trade sizes rank against the trade size distribution.
+    bool ok = true;
+    {
+        auto values = std::make_unique<Trading::TickerFeatures>();
+        values->onQuote(1, 100, 50, 101, 200);
+        values->onTrade(2, Common::Side::BUY, 101, 100);
+        const auto buy_ratio = values->aggTradeQtyRatio();
+        values->onTrade(3, Common::Side::SELL, 100, 100);
+        const auto sell_ratio = values->aggTradeQtyRatio();
+        values->onQuote(4, 100, 50, 101, 0);
+        values->onTrade(5, Common::Side::BUY, 101, 100);
+        const auto empty_ratio = values->aggTradeQtyRatio();
+
+        // Sizes 1 to 1000 in random order
+        std::vector<Common::Qty> sizes(1'000);
+        for (size_t i = 0; i < sizes.size(); ++i)
+            sizes[i] = static_cast<Common::Qty>(i + 1);
+        std::shuffle(sizes.begin(), sizes.end(), std::mt19937_64(11));
+        for (const auto size : sizes)
+            values->onTrade(6, Common::Side::BUY, 101, size);
+        const auto p10 = values->volumePercentile(100), p50 = values->volumePercentile(500), p90 = values->volumePercentile(900);
+        const auto above = values->volumePercentile(5'000);
+
+        std::cout << "Feature values:  agg-ratio buy:" << std::setprecision(2) << buy_ratio << " sell:" << sell_ratio
+                  << " empty side:" << empty_ratio << ", pct(100):" << std::setprecision(1) << p10 << " pct(500):" << p50
+                  << " pct(900):" << p90 << " pct(5000):" << above << std::endl;
+        ok &= (buy_ratio == 0.5 && sell_ratio == 2.0 && std::isnan(empty_ratio) && std::abs(p10 - 10) < 3 &&
+               std::abs(p50 - 50) < 3 && std::abs(p90 - 90) < 3 && above == 100);
+    }
+
+    for (const auto kernel : {Trading::FeatureStore::Kernel::AVX2, Trading::FeatureStore::Kernel::AVX512}) {
+        const std::string name = kernelName(kernel);
+        const auto error = kernelParity(kernel);
+        std::cout << name << " parity:" << std::string(16 - name.size() - 7, ' ');
+        if (error < 0)
+            std::cout << "not supported by this CPU, skipped" << std::endl;
+        else
+            std::cout << std::scientific << std::setprecision(2) << error << " max relative error vs scalar over "
+                      << PARITY_ROUNDS << " rounds" << std::endl;
+        ok &= (error <= PARITY_TOLERANCE);
+    }
+
+    std::cout << "Result:          " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "trading/adapters/sim/ws_exchange_simulator.h"
+#include "trading/adapters/zerodha/market_data/instrument_token_manager.h"
+#include "trading/adapters/zerodha/market_data/zerodha_websocket_pool.h"
+
+// Benchmark of bringing up a large universe of Kite instruments. Resolves the symbols to instrument tokens one by one
+// and in a single call of the token manager on a generated dump, then against the local Kite simulator subscribes to
+// them one token per call, as the adapter's per symbol subscribe() did, and all in one call. Reports the time to
+// subscribe, the time until every instrument has ticked and the control messages the simulator received, and checks
+// the bulk subscription stays within MAX_TOKENS_PER_FRAME tokens per message.
+// Usage: zerodha_bulk_subscribe_benchmark [NUM_INSTRUMENTS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using namespace Adapter::Sim;
+    using Common::Nanos;
+
+    // A paced feed, saturating would leave the subscribing thread little of a shared core
+    constexpr size_t MESSAGES_PER_SECOND = 5'000;
+    constexpr size_t PACKETS_PER_FRAME = 16;
+    // The client's reader holds the connection between frames, so a write on an idle connection waits for the next
+    // heartbeat. Kite sends one a second, a short one keeps that wait out of the subscription times
+    constexpr std::chrono::milliseconds HEARTBEAT_INTERVAL{5};
+    constexpr Nanos TIMEOUT_NANOS = 30 * Common::NANOS_TO_SECS;
+
+    auto token(size_t i) {
+        return static_cast<int32_t>(738'561 + i * 256);
+    }
+
+    auto symbol(size_t i) {
+        return "NSE:SYM" + std::to_string(i);
+    }
+
+    /// Equities with the columns of Kite's dump.
+    auto makeDump(size_t count) {
+        std::string csv = "instrument_token,exchange_token,tradingsymbol,name,last_price,expiry,strike,tick_size,lot_size,instrument_type,segment,exchange\n";
+        for (size_t i = 0; i < count; ++i)
+            csv += std::to_string(token(i)) + "," + std::to_string(i + 1) + ",SYM" + std::to_string(i) + ",COMPANY " + std::to_string(i) +
+                   ",0,,0,0.05,1,EQ,NSE,NSE\n";
+        return csv;
+    }
+
+    struct Bringup {
+        Nanos subscribe_nanos = 0;
+        Nanos first_tick_nanos = 0;    // From the start of subscribing until every instrument has ticked
+        size_t seen = 0;
+        WsSimulatorStats stats;
+    };
+
+    auto bringup(const std::vector<int32_t> &tokens, bool bulk, Common::Logger &client_logger, Common::Logger &sim_logger) {
+        WsExchangeSimulatorConfig config;
+        config.protocol = SimProtocol::KITE;
+        config.messages_per_second = MESSAGES_PER_SECOND;
+        config.instruments_per_message = PACKETS_PER_FRAME;
+        config.heartbeat_interval = HEARTBEAT_INTERVAL;
+        for (size_t i = 0; i < tokens.size(); ++i)
+            config.instruments.push_back({static_cast<Common::TickerId>(i), tokens[i], "", 250'000});
+        WsExchangeSimulator sim(config, &sim_logger);
+        sim.start();
+
+        ZerodhaWebSocketPool pool("sim", "sim", 1, 1024 * 1024, &client_logger);
+        pool.set_endpoint("127.0.0.1", std::to_string(sim.port()), false);
+        pool.set_rebalance_interval(std::chrono::milliseconds(0));
+        auto start = Common::getSystemNanos();
+        pool.connect();
+        while (!pool.is_connected() && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        // on_connect() resubscribes to what it finds subscribed once connected, so it does not count towards either run
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        Bringup result;
+        std::set<int32_t> seen;
+        auto &queue = pool.queue(0);
+        const auto drain = [&]() {
+            for (auto tick = queue.front(); tick; tick = queue.front()) {
+                seen.insert(tick->instrument_token);
+                queue.pop();
+            }
+        };
+
+        start = Common::getSystemNanos();
+        if (bulk) {
+            pool.subscribe(tokens, StreamingMode::FULL);
+        } else {
+            for (const auto instrument_token : tokens) {
+                pool.subscribe({instrument_token}, StreamingMode::FULL);
+                drain();
+            }
+        }
+        result.subscribe_nanos = Common::getSystemNanos() - start;
+
+        while (seen.size() < tokens.size() && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+            drain();
+        result.first_tick_nanos = Common::getSystemNanos() - start;
+        result.seen = seen.size();
+
+        pool.disconnect();
+        sim.stop();
+        result.stats = sim.stats();
+        return result;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_instruments = std::min<size_t>(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'500,
+                                                    ZerodhaWebSocketPool::MAX_TOKENS_PER_CONNECTION);
+
+    Common::Logger client_logger("zerodha_bulk_subscribe_benchmark.log");
+    Common::Logger sim_logger("zerodha_ws_simulator.log");
+    bool ok = true;
+
+    // Symbols to tokens, one lock of the token manager per symbol against one for all
+    std::vector<int32_t> tokens;
+    {
+        const auto cache_dir = (std::filesystem::temp_directory_path() / "zerodha_bulk_subscribe_benchmark").string();
+        std::filesystem::remove_all(cache_dir);
+        std::filesystem::create_directories(cache_dir);
+        {
+            std::ofstream file(cache_dir + "/instruments.csv", std::ios::binary);
+            const auto csv = makeDump(num_instruments);
+            file.write(csv.data(), static_cast<std::streamsize>(csv.size()));
+        }
+        InstrumentTokenManager manager(nullptr, &client_logger, cache_dir);
+        ok &= manager.initialize();
+
+        std::vector<std::string> symbols;
+        for (size_t i = 0; i < num_instruments; ++i)
+            symbols.push_back(symbol(i));
+
+        auto start = Common::getSystemNanos();
+        std::vector<int32_t> single;
+        for (const auto &name : symbols)
+            single.push_back(manager.getInstrumentToken(name));
+        const auto single_nanos = Common::getSystemNanos() - start;
+
+        start = Common::getSystemNanos();
+        const auto found = manager.getInstrumentTokens(symbols, tokens);
+        const auto bulk_nanos = Common::getSystemNanos() - start;
+
+        size_t wrong = 0;
+        for (size_t i = 0; i < num_instruments; ++i)
+            wrong += (tokens[i] != token(i) || single[i] != tokens[i]);
+        std::cout << "Resolve:           " << single_nanos / Common::NANOS_TO_MICROS << "us one by one, " << bulk_nanos / Common::NANOS_TO_MICROS
+                  << "us in one call, " << found << " of " << num_instruments << " found, " << wrong << " wrong" << std::endl;
+        ok &= (found == num_instruments && wrong == 0);
+        std::filesystem::remove_all(cache_dir);
+    }
+
+    // Subscribing one token per call sends a subscribe and a mode message per instrument, one call a pair per frame
+    const auto single = bringup(tokens, false, client_logger, sim_logger);
+    const auto bulk = bringup(tokens, true, client_logger, sim_logger);
+    const auto frames = (num_instruments + ZerodhaWebSocketClient::MAX_TOKENS_PER_FRAME - 1) / ZerodhaWebSocketClient::MAX_TOKENS_PER_FRAME;
+    for (const auto &[name, result] : {std::pair{"One by one", &single}, std::pair{"In one call", &bulk}}) {
+        std::cout << name << ":" << std::string(19 - std::string(name).size() - 1, ' ') << result->subscribe_nanos / Common::NANOS_TO_MICROS
+                  << "us to subscribe, " << result->first_tick_nanos / Common::NANOS_TO_MILLIS << "ms until all " << result->seen
+                  << " instruments ticked, " << result->stats.control_messages << " control messages of up to "
+                  << result->stats.max_control_tokens << " tokens" << std::endl;
+        ok &= (result->seen == num_instruments);
+    }
+    ok &= (single.stats.control_messages == 2 * num_instruments && bulk.stats.control_messages == 2 * frames &&
+           bulk.stats.max_control_tokens <= ZerodhaWebSocketClient::MAX_TOKENS_PER_FRAME);
+    ok &= (bulk.subscribe_nanos * 10 < single.subscribe_nanos);
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,223 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "exchange/market_data/market_update.h"
+#include "trading/adapters/zerodha/market_data/orderbook/zerodha_order_book.h"
+#include "trading/adapters/zerodha/market_data/zerodha_market_data_adapter.h"
+#include "trading/adapters/zerodha/market_data/zerodha_tick.h"
+#include "trading/adapters/zerodha/market_data/zerodha_tick_latency.h"
+
+// Benchmark of the handoff of ticks from the Kite WebSocket thread to the order books. A producer thread plays the
+// WebSocket thread, sending binary frames of FULL ticks at a steady pace through ZerodhaMarketDataAdapter::replayFrame(),
+// the adapter's market data thread running as startReplay() sets it up for each execution model: busy polling the tick
+// queue, or idle with the ticks applied inline on the producer thread by the WebSocket client's on_ticks callback. A
+// consumer polling a tick queue every millisecond plays the loop the adapter replaced. Reports the latency from a frame
+// being received to its ticks being applied as the adapter exports it, checks every tick reached the order book and
+// the latency histogram against known values. No credentials or network needed.
+// Usage: zerodha_handoff_benchmark [NUM_FRAMES] [FRAME_INTERVAL_MICROS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Common::Nanos;
+
+    constexpr size_t TICKS_PER_FRAME = 4;
+    constexpr int32_t TICK = 5;    // 0.05 rupees
+    constexpr int32_t INSTRUMENT_TOKEN = 408'065;
+    constexpr size_t FULL_PACKET_SIZE = 184;
+
+    /// FULL ticks of a random walking 5 level book.
+    auto makeTicks(size_t count) {
+        std::mt19937 rng(5);
+        std::vector<KiteTick> ticks(count);
+        int32_t best_bid = 150'000;
+        for (size_t i = 0; i < count; ++i) {
+            auto &tick = ticks[i];
+            tick = {};
+            tick.instrument_token = INSTRUMENT_TOKEN;
+            tick.type = MarketUpdateType::FULL;
+            best_bid += TICK * (static_cast<int32_t>(rng() % 3) - 1);
+            tick.last_price = best_bid;
+            tick.volume = static_cast<int32_t>(i);
+            for (int32_t level = 0; level < 5; ++level) {
+                tick.bids[static_cast<size_t>(level)] = {static_cast<int32_t>(100 + rng() % 8 * 50), best_bid - level * TICK, 1, 0};
+                tick.asks[static_cast<size_t>(level)] = {static_cast<int32_t>(100 + rng() % 8 * 50), best_bid + (level + 1) * TICK, 1, 0};
+            }
+        }
+        return ticks;
+    }
+
+    auto putInt(char *data, int32_t value) {
+        const auto network = static_cast<int32_t>(htonl(static_cast<uint32_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    auto putShort(char *data, int16_t value) {
+        const auto network = static_cast<int16_t>(htons(static_cast<uint16_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    /// The ticks as Kite binary frames of TICKS_PER_FRAME FULL packets each.
+    auto makeFrames(const std::vector<KiteTick> &ticks) {
+        std::vector<std::string> frames;
+        for (size_t first = 0; first + TICKS_PER_FRAME <= ticks.size(); first += TICKS_PER_FRAME) {
+            std::string frame(2 + TICKS_PER_FRAME * (2 + FULL_PACKET_SIZE), '\0');
+            putShort(frame.data(), static_cast<int16_t>(TICKS_PER_FRAME));
+            auto packet = frame.data() + 2;
+            for (size_t i = first; i < first + TICKS_PER_FRAME; ++i, packet += 2 + FULL_PACKET_SIZE) {
+                const auto &tick = ticks[i];
+                putShort(packet, static_cast<int16_t>(FULL_PACKET_SIZE));
+                const auto data = packet + 2;
+                putInt(data, tick.instrument_token);
+                putInt(data + 4, tick.last_price);
+                putInt(data + 16, tick.volume);
+                for (size_t level = 0; level < 5; ++level) {
+                    putInt(data + 64 + level * 12, tick.bids[level].quantity);
+                    putInt(data + 64 + level * 12 + 4, tick.bids[level].price);
+                    putShort(data + 64 + level * 12 + 8, static_cast<int16_t>(tick.bids[level].orders));
+                    putInt(data + 124 + level * 12, tick.asks[level].quantity);
+                    putInt(data + 124 + level * 12 + 4, tick.asks[level].price);
+                    putShort(data + 124 + level * 12 + 8, static_cast<int16_t>(tick.asks[level].orders));
+                }
+            }
+            frames.push_back(std::move(frame));
+        }
+        return frames;
+    }
+
+    /// Push num_frames frames one frame_interval apart and apply them to a book from a queue polled every millisecond.
+    auto runSleep(const std::vector<KiteTick> &ticks, size_t num_frames, Nanos frame_interval, Common::Logger &logger) {
+        ZerodhaTickQueue queue(16 * 1024);
+        ZerodhaOrderBook book(0, &logger);
+        ZerodhaTickLatency latency;
+        size_t num_applied = 0, num_events = 0;
+
+        const auto drain = [&]() {
+            for (auto tick = queue.front(); tick != nullptr; tick = queue.front()) {
+                book.processMarketUpdate(*tick, tick->type == MarketUpdateType::FULL ? queue.frontDepth() : nullptr,
+                                         [&](const Exchange::MEMarketUpdate &) { ++num_events; });
+                latency.record(Common::getSystemNanos() - tick->timestamp);
+                queue.pop();
+                ++num_applied;
+            }
+        };
+
+        std::atomic<bool> run = true;
+        std::thread consumer([&]() {
+            while (run) {
+                drain();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            drain();
+        });
+
+        // Like the WebSocket thread, the producer blocks between frames
+        auto next_frame = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < num_frames; ++frame) {
+            std::this_thread::sleep_until(next_frame);
+            next_frame += std::chrono::nanoseconds(frame_interval);
+
+            // The volume keeps rising as the ticks come round again, the book drops ticks whose volume went down
+            const auto received = Common::getSystemNanos();
+            for (size_t i = 0; i < TICKS_PER_FRAME; ++i) {
+                auto tick = ticks[(frame * TICKS_PER_FRAME + i) % ticks.size()];
+                tick.volume = static_cast<int32_t>(frame * TICKS_PER_FRAME + i);
+                queue.push(tick, received);
+            }
+        }
+        run = false;
+        consumer.join();
+
+        const auto stats = latency.snapshot();
+        std::cout << "Handoff sleep 1ms: " << stats.toString() << ", " << num_events / std::max<size_t>(num_applied, 1) << " events/tick" << std::endl;
+        return stats;
+    }
+
+    /// Replay num_frames frames one frame_interval apart through a market data adapter running with the execution model.
+    auto runAdapter(MarketDataExecution execution, std::vector<std::string> frames, size_t num_frames, Nanos frame_interval,
+                    Common::Logger &logger) {
+        // No configuration, so the adapter neither authenticates nor loads instruments
+        Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+        ZerodhaMarketDataAdapter adapter(&logger, &market_updates, "zerodha_handoff_benchmark_no_config.json");
+        adapter.mapInstrumentToken(INSTRUMENT_TOKEN, 0);
+
+        MarketDataConfig config;
+        config.execution = execution;
+        config.latency_log_interval_s = 0;
+        adapter.startReplay(config);
+
+        // Like the WebSocket thread, the producer blocks between frames
+        auto next_frame = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < num_frames; ++frame) {
+            std::this_thread::sleep_until(next_frame);
+            next_frame += std::chrono::nanoseconds(frame_interval);
+
+            auto &data = frames[frame % frames.size()];
+            for (size_t i = 0; i < TICKS_PER_FRAME; ++i)
+                putInt(data.data() + 2 + i * (2 + FULL_PACKET_SIZE) + 2 + 16, static_cast<int32_t>(frame * TICKS_PER_FRAME + i));
+            adapter.replayFrame(data.data(), data.size(), true);
+        }
+
+        // The busy polling consumer may still be applying the last frames
+        const auto expected = num_frames * TICKS_PER_FRAME;
+        const auto deadline = Common::getSystemNanos() + 10 * Common::NANOS_TO_SECS;
+        while (adapter.getTickLatencyStats().ticks < expected && Common::getSystemNanos() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        adapter.stop();
+
+        const auto stats = adapter.getTickLatencyStats();
+        const std::string name = (execution == MarketDataExecution::INLINE ? "inline" : "busy poll");
+        std::cout << "Handoff " << name << ":" << std::string(10 - name.size(), ' ') << stats.toString() << ", "
+                  << market_updates.numWritten() / std::max<size_t>(stats.ticks, 1) << " events/tick" << std::endl;
+        return std::make_pair(stats, market_updates.numWritten());
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_frames = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20'000);
+    const Nanos frame_interval = (argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 50) * Common::NANOS_TO_MICROS;
+
+    Common::Logger logger("zerodha_handoff_benchmark.log");
+    bool ok = true;
+
+    // The histogram reports percentiles within a quarter of the exact ones.
+    {
+        ZerodhaTickLatency latency;
+        for (Nanos value = 1; value <= 100'000; ++value)
+            latency.record(value);
+        const auto stats = latency.snapshot();
+        const bool close = stats.ticks == 100'000 && stats.mean == 50'000 && stats.max == 100'000 &&
+                           stats.p50 >= 50'000 && stats.p50 <= 62'500 && stats.p99 >= 99'000 && stats.p99 <= 123'750;
+        std::cout << "Histogram:         " << stats.toString() << (close ? "" : " (off)") << std::endl;
+        ok &= close;
+    }
+
+    const auto ticks = makeTicks(4096);
+    const auto frames = makeFrames(ticks);
+    const auto sleep_stats = runSleep(ticks, num_frames, frame_interval, logger);
+    const auto [poll_stats, poll_events] = runAdapter(MarketDataExecution::BUSY_POLL, frames, num_frames, frame_interval, logger);
+    const auto [inline_stats, inline_events] = runAdapter(MarketDataExecution::INLINE, frames, num_frames, frame_interval, logger);
+
+    const auto expected = num_frames * TICKS_PER_FRAME;
+    ok &= (sleep_stats.ticks == expected && poll_stats.ticks == expected && inline_stats.ticks == expected);
+    ok &= (poll_events >= expected && inline_events >= expected);
+    ok &= (inline_stats.p50 < sleep_stats.p50);
+
+    // A busy polling consumer needs a core of its own, with one it picks up ticks far sooner than the old loop
+    if (std::thread::hardware_concurrency() > 1)
+        ok &= (poll_stats.p50 < sleep_stats.p50);
+    else
+        std::cout << "Busy poll:         not compared, it shares the only core with the producer" << std::endl;
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,212 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "trading/adapters/zerodha/market_data/instrument_master.h"
+#include "trading/adapters/zerodha/market_data/instrument_token_manager.h"
+
+// Benchmark of the instrument master cache of InstrumentTokenManager on a generated Kite instruments dump of 100k rows.
+// Times a cold start parsing the CSV and writing the binary cache against a warm start mapping the binary cache, checks
+// every instrument resolves to the same token and fields from the mapping, nearest futures skip expired contracts, and
+// a damaged binary cache is rebuilt from the CSV instead of being used. Also damages each word of a small image in turn
+// and checks every damaged image is either refused or still answers lookups of missing keys.
+// Usage: zerodha_instrument_cache_benchmark [NUM_ROWS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Common::Nanos;
+
+    constexpr size_t NUM_COMPANIES = 1'500;
+    constexpr size_t NUM_UNDERLYINGS = 200;
+    constexpr int FUTURE_EXPIRY_DAYS[] = {-5, 10, 40, 70};
+
+    struct Row {
+        std::string exchange;
+        std::string trading_symbol;
+        std::string name;
+        int32_t instrument_token;
+        bool has_expiry;
+        double strike;
+        int32_t lot_size;
+    };
+
+    /// Local date days from now as YYYY-MM-DD, as the dump has it.
+    auto date(int days) {
+        const auto time = std::time(nullptr) + days * 86'400;
+        char buffer[16];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", std::localtime(&time));
+        return std::string(buffer);
+    }
+
+    /// Equities on NSE and BSE, futures of 200 underlyings on four expiries (one already expired) and options of the
+    /// same underlyings filling the rest, with the columns of Kite's dump.
+    auto makeDump(size_t num_rows, std::vector<Row> &rows) {
+        std::string csv = "instrument_token,exchange_token,tradingsymbol,name,last_price,expiry,strike,tick_size,lot_size,instrument_type,segment,exchange\n";
+        const auto add = [&](const std::string &exchange, const std::string &segment, const std::string &symbol, const std::string &name,
+                             const std::string &expiry, double strike, int32_t lot_size, const std::string &type) {
+            const auto token = static_cast<int32_t>(((rows.size() + 1) << 8) | (exchange == "BSE" ? 4 : exchange == "NFO" ? 2 : 1));
+            const auto quoted = (name.find(',') != std::string::npos ? "\"" + name + "\"" : name);
+            csv += std::to_string(token) + "," + std::to_string(rows.size() + 1) + "," + symbol + "," + quoted + ",0," + expiry + "," +
+                   std::to_string(static_cast<int64_t>(strike)) + ",0.05," + std::to_string(lot_size) + "," + type + "," + segment + "," + exchange + "\n";
+            rows.push_back({exchange, symbol, name, token, !expiry.empty(), strike, lot_size});
+        };
+
+        for (size_t i = 0; i < NUM_COMPANIES && rows.size() + 2 <= num_rows; ++i) {
+            const auto symbol = "SYM" + std::to_string(i);
+            const auto name = "COMPANY " + std::to_string(i) + (i % 100 == 0 ? ", INDIA LTD" : " LTD");
+            add("NSE", "NSE", symbol, name, "", 0, 1, "EQ");
+            add("BSE", "BSE", symbol, name, "", 0, 1, "EQ");
+        }
+
+        std::vector<std::string> underlyings = {"NIFTY", "BANKNIFTY", "FINNIFTY"};
+        while (underlyings.size() < NUM_UNDERLYINGS)
+            underlyings.push_back("UND" + std::to_string(underlyings.size()));
+        for (const auto &underlying : underlyings) {
+            for (size_t e = 0; e < std::size(FUTURE_EXPIRY_DAYS) && rows.size() < num_rows; ++e)
+                add("NFO", "NFO-FUT", underlying + "F" + std::to_string(e) + "FUT", underlying, date(FUTURE_EXPIRY_DAYS[e]), 0, 50, "FUT");
+        }
+        for (size_t strike = 100; rows.size() < num_rows; strike += 50) {
+            for (const auto &underlying : underlyings) {
+                for (size_t e = 1; e < std::size(FUTURE_EXPIRY_DAYS) && rows.size() < num_rows; ++e) {
+                    for (const auto *type : {"CE", "PE"}) {
+                        if (rows.size() < num_rows)
+                            add("NFO", "NFO-OPT", underlying + "O" + std::to_string(e) + "S" + std::to_string(strike) + type, underlying,
+                                date(FUTURE_EXPIRY_DAYS[e]), static_cast<double>(strike), 50, type);
+                    }
+                }
+            }
+        }
+        return csv;
+    }
+
+    /// Initialize a manager on the cache directory, the time it took, -1 if it failed.
+    auto start(InstrumentTokenManager &manager) -> Nanos {
+        const auto begin = Common::getSystemNanos();
+        return manager.initialize() ? Common::getSystemNanos() - begin : -1;
+    }
+
+    /// Rows whose token does not lead back to the row's fields.
+    auto mismatches(InstrumentTokenManager &manager, const std::vector<Row> &rows) {
+        size_t wrong = 0;
+        for (const auto &row : rows) {
+            const auto info = manager.getInstrumentInfo(row.instrument_token);
+            wrong += (!info || info->trading_symbol != row.trading_symbol || info->name != row.name ||
+                      InstrumentTokenManager::exchangeToString(info->exchange) != row.exchange || info->lot_size != row.lot_size ||
+                      info->expiry.has_value() != row.has_expiry || info->strike != row.strike);
+        }
+        return wrong;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_rows = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000);
+
+    Common::Logger logger("zerodha_instrument_cache_benchmark.log");
+    bool ok = true;
+
+    const auto cache_dir = (std::filesystem::temp_directory_path() / "zerodha_instrument_cache_benchmark").string();
+    std::filesystem::remove_all(cache_dir);
+    std::filesystem::create_directories(cache_dir);
+    std::vector<Row> rows;
+    {
+        std::ofstream file(cache_dir + "/instruments.csv", std::ios::binary);
+        const auto csv = makeDump(num_rows, rows);
+        file.write(csv.data(), static_cast<std::streamsize>(csv.size()));
+        std::cout << "Dump:              " << rows.size() << " rows, " << csv.size() / 1024 << "KB of CSV" << std::endl;
+    }
+
+    // Cold start parses the CSV and writes the binary cache, the warm start maps it.
+    InstrumentTokenManager cold(nullptr, &logger, cache_dir);
+    const auto cold_nanos = start(cold);
+    const auto binary_size = std::filesystem::exists(cache_dir + "/instruments.bin") ? std::filesystem::file_size(cache_dir + "/instruments.bin") : 0;
+    InstrumentTokenManager warm(nullptr, &logger, cache_dir);
+    const auto warm_nanos = start(warm);
+
+    const auto cold_wrong = mismatches(cold, rows);
+    const auto warm_wrong = mismatches(warm, rows);
+    std::cout << "Cold start:        " << cold_nanos / Common::NANOS_TO_MICROS << "us parsing the CSV, " << cold.getNumInstruments()
+              << " instruments, " << cold_wrong << " wrong" << std::endl;
+    std::cout << "Warm start:        " << warm_nanos / Common::NANOS_TO_MICROS << "us mapping " << binary_size / 1024 << "KB of binary cache, "
+              << warm.getNumInstruments() << " instruments, " << warm_wrong << " wrong" << std::endl;
+    ok &= (cold_nanos > 0 && warm_nanos > 0 && cold.getNumInstruments() == rows.size() && warm.getNumInstruments() == rows.size() &&
+           cold_wrong == 0 && warm_wrong == 0 && warm_nanos * 10 < cold_nanos);
+
+    // Lookups on the mapping - by symbol, by token, and the nearest future of each underlying.
+    {
+        size_t wrong = 0, lookups = 0;
+        auto begin = Common::getSystemNanos();
+        for (size_t i = 0; i < rows.size(); i += 5, ++lookups)
+            wrong += (warm.getInstrumentToken(rows[i].exchange + ":" + rows[i].trading_symbol) != rows[i].instrument_token);
+        const auto symbol_nanos = (Common::getSystemNanos() - begin) / static_cast<Nanos>(std::max<size_t>(lookups, 1));
+
+        begin = Common::getSystemNanos();
+        for (const auto &row : rows)
+            wrong += (!warm.getInstrumentInfo(row.instrument_token));
+        const auto info_nanos = (Common::getSystemNanos() - begin) / static_cast<Nanos>(std::max<size_t>(rows.size(), 1));
+        wrong += (warm.getInstrumentToken("NSE:NOSUCHSYMBOL") != 0 || warm.getInstrumentInfo(-1).has_value());
+
+        size_t futures = 0;
+        for (const auto &row : rows) {
+            // The second future of each underlying expires in 10 days, the first expired 5 days ago
+            if (row.trading_symbol == row.name + "F1FUT") {
+                wrong += (warm.getNearestFutureToken(row.name) != row.instrument_token);
+                ++futures;
+            }
+        }
+
+        std::cout << "Lookups:           " << symbol_nanos << "ns by symbol, " << info_nanos << "ns info by token, " << futures
+                  << " nearest futures, " << wrong << " wrong" << std::endl;
+        ok &= (wrong == 0 && futures > 0);
+    }
+
+    // A truncated binary cache is not used, the CSV is parsed again and the cache rewritten.
+    {
+        std::filesystem::resize_file(cache_dir + "/instruments.bin", binary_size / 2);
+        InstrumentTokenManager damaged(nullptr, &logger, cache_dir);
+        const auto damaged_nanos = start(damaged);
+        const auto rebuilt = std::filesystem::file_size(cache_dir + "/instruments.bin") == binary_size;
+        const auto wrong = mismatches(damaged, rows);
+        std::cout << "Damaged cache:     " << damaged_nanos / Common::NANOS_TO_MICROS << "us, " << (rebuilt ? "rebuilt" : "not rebuilt") << ", "
+                  << wrong << " wrong" << std::endl;
+        ok &= (damaged_nanos > 0 && rebuilt && wrong == 0);
+    }
+
+    // Setting an empty slot leaves a hash table full, lookups of missing keys must still return rather than probe forever.
+    {
+        const auto expiry = std::chrono::system_clock::now() + std::chrono::hours(24 * 10);
+        const auto image = InstrumentMaster::build(std::vector<InstrumentRecord>{
+            {738'561, 2'885, "RELIANCE", "RELIANCE", 0, std::nullopt, std::nullopt, 0.05, 1, InstrumentType::EQ, "NSE", Exchange::NSE},
+            {12'345'602, 48'225, "RELIANCE25OCTFUT", "RELIANCE", 0, expiry, std::nullopt, 0.05, 250, InstrumentType::FUT, "NFO-FUT", Exchange::NFO}});
+        size_t variants = 0, refused = 0;
+        for (size_t offset = 0; offset + sizeof(uint32_t) <= image.size(); offset += sizeof(uint32_t)) {
+            uint32_t word;
+            std::memcpy(&word, image.data() + offset, sizeof(word));
+            if (word)
+                continue;
+            auto damaged = image;
+            word = 1;
+            std::memcpy(damaged.data() + offset, &word, sizeof(word));
+            const InstrumentMaster master{std::move(damaged)};
+            ++variants;
+            refused += !master.valid();
+            ok &= (master.findToken(-1) == InstrumentMaster::NOT_FOUND && master.findSymbol(Exchange::BSE, "NOSUCHSYMBOL") == InstrumentMaster::NOT_FOUND &&
+                   master.futures("NOSUCHNAME").empty());
+        }
+        std::cout << "Damaged tables:    " << variants << " damaged images, " << refused << " refused, lookups of missing keys returned" << std::endl;
+        ok &= (variants > 0 && refused > 0);
+    }
+
+    std::filesystem::remove_all(cache_dir);
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,241 @@
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/time_utils.h"
+#include "trading/adapters/zerodha/market_data/instrument_csv_parser.h"
+#include "trading/adapters/zerodha/market_data/instrument_master.h"
+
+// Benchmark of the parallel instruments CSV parser on a generated Kite instruments dump of 100k rows. Times the line
+// by line parser it replaced (std::getline, a std::string per field, std::stoi/std::stod and std::get_time) against
+// InstrumentCsvParser on one thread, on four threads and on every hardware thread, checks each parse gives the same
+// instruments in the same order, and checks quoting, CRLF line ends and malformed lines on a small dump.
+// Usage: zerodha_instrument_csv_benchmark [NUM_ROWS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Common::Nanos;
+
+    constexpr size_t NUM_COMPANIES = 1'500;
+    constexpr size_t NUM_UNDERLYINGS = 200;
+    constexpr int EXPIRY_DAYS[] = {-5, 10, 40, 70};
+
+    /// Local date days from now as YYYY-MM-DD, as the dump has it.
+    auto date(int days) {
+        const auto time = std::time(nullptr) + days * 86'400;
+        char buffer[16];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", std::localtime(&time));
+        return std::string(buffer);
+    }
+
+    /// Equities on NSE and BSE, then futures and options of 200 underlyings, with the columns of Kite's dump.
+    auto makeDump(size_t num_rows) {
+        std::string csv = "instrument_token,exchange_token,tradingsymbol,name,last_price,expiry,strike,tick_size,lot_size,instrument_type,segment,exchange\n";
+        size_t rows = 0;
+        const auto add = [&](const std::string &exchange, const std::string &segment, const std::string &symbol, const std::string &name,
+                             const std::string &expiry, size_t strike, const std::string &type) {
+            ++rows;
+            const auto token = (rows << 8) | (exchange == "BSE" ? 4 : exchange == "NFO" ? 2 : 1);
+            const auto quoted = (name.find(',') != std::string::npos ? "\"" + name + "\"" : name);
+            csv += std::to_string(token) + "," + std::to_string(rows) + "," + symbol + "," + quoted + "," + std::to_string(rows % 5'000) + ".35," +
+                   expiry + "," + std::to_string(strike) + ",0.05," + (expiry.empty() ? "1" : "50") + "," + type + "," + segment + "," + exchange + "\n";
+        };
+
+        for (size_t i = 0; i < NUM_COMPANIES && rows + 2 <= num_rows; ++i) {
+            const auto symbol = "SYM" + std::to_string(i);
+            const auto name = "COMPANY " + std::to_string(i) + (i % 100 == 0 ? ", INDIA LTD" : " LTD");
+            add("NSE", "NSE", symbol, name, "", 0, "EQ");
+            add("BSE", "BSE", symbol, name, "", 0, "EQ");
+        }
+        std::vector<std::string> underlyings = {"NIFTY", "BANKNIFTY", "FINNIFTY"};
+        while (underlyings.size() < NUM_UNDERLYINGS)
+            underlyings.push_back("UND" + std::to_string(underlyings.size()));
+        for (const auto &underlying : underlyings) {
+            for (size_t e = 0; e < std::size(EXPIRY_DAYS) && rows < num_rows; ++e)
+                add("NFO", "NFO-FUT", underlying + "F" + std::to_string(e) + "FUT", underlying, date(EXPIRY_DAYS[e]), 0, "FUT");
+        }
+        for (size_t strike = 100; rows < num_rows; strike += 50) {
+            for (const auto &underlying : underlyings) {
+                for (size_t e = 1; e < std::size(EXPIRY_DAYS) && rows < num_rows; ++e) {
+                    for (const auto *type : {"CE", "PE"}) {
+                        if (rows < num_rows)
+                            add("NFO", "NFO-OPT", underlying + "O" + std::to_string(e) + "S" + std::to_string(strike) + type, underlying,
+                                date(EXPIRY_DAYS[e]), strike, type);
+                    }
+                }
+            }
+        }
+        return csv;
+    }
+
+    /// The parser InstrumentTokenManager used before InstrumentCsvParser, kept as the reference.
+    namespace Baseline {
+        auto trim(const std::string &str) {
+            const auto start = str.find_first_not_of(" \t\r\n\f\v");
+            return start == std::string::npos ? std::string() : str.substr(start, str.find_last_not_of(" \t\r\n\f\v") - start + 1);
+        }
+
+        auto split(const std::string &line) {
+            std::vector<std::string> fields;
+            std::string field;
+            bool in_quotes = false;
+            for (const char c : line) {
+                if (c == '"') {
+                    in_quotes = !in_quotes;
+                } else if (c == ',' && !in_quotes) {
+                    fields.push_back(trim(field));
+                    field.clear();
+                } else {
+                    field += c;
+                }
+            }
+            fields.push_back(trim(field));
+            return fields;
+        }
+
+        auto parseDate(const std::string &date) -> std::optional<std::chrono::system_clock::time_point> {
+            std::tm tm = {};
+            std::istringstream ss(date);
+            ss >> std::get_time(&tm, "%Y-%m-%d");
+            if (ss.fail())
+                return std::nullopt;
+            return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+        }
+
+        auto parse(const std::string &csv) {
+            std::vector<InstrumentInfo> instruments;
+            std::istringstream stream(csv);
+            std::string line;
+            std::getline(stream, line);
+            while (std::getline(stream, line)) {
+                const auto fields = split(line);
+                if (fields.size() < 12)
+                    continue;
+                try {
+                    InstrumentInfo info(std::stoi(fields[0]), std::stoi(fields[1]), fields[2], fields[3],
+                                        InstrumentTokenManager::stringToExchange(fields[11]), InstrumentTokenManager::stringToInstrumentType(fields[9]));
+                    if (!fields[4].empty())
+                        info.last_price = std::stod(fields[4]);
+                    if (!fields[5].empty())
+                        info.expiry = parseDate(fields[5]);
+                    if (!fields[6].empty())
+                        info.strike = std::stod(fields[6]);
+                    if (!fields[7].empty())
+                        info.tick_size = std::stod(fields[7]);
+                    if (!fields[8].empty())
+                        info.lot_size = std::stoi(fields[8]);
+                    info.segment = fields[10];
+                    instruments.push_back(std::move(info));
+                } catch (const std::exception &) {
+                }
+            }
+            return instruments;
+        }
+    }
+
+    /// Records that differ from the reference instruments, and any count mismatch.
+    auto mismatches(const std::vector<InstrumentRecord> &records, const std::vector<InstrumentInfo> &instruments) {
+        size_t wrong = (records.size() > instruments.size() ? records.size() - instruments.size() : instruments.size() - records.size());
+        for (size_t i = 0; i < std::min(records.size(), instruments.size()); ++i) {
+            const auto &record = records[i];
+            const auto &info = instruments[i];
+            wrong += (record.instrument_token != info.instrument_token || record.exchange_token != info.exchange_token ||
+                      record.trading_symbol != info.trading_symbol || record.name != info.name || record.last_price != info.last_price ||
+                      record.expiry != info.expiry || record.strike != info.strike || record.tick_size != info.tick_size ||
+                      record.lot_size != info.lot_size || record.instrument_type != info.instrument_type || record.segment != info.segment ||
+                      record.exchange != info.exchange);
+        }
+        return wrong;
+    }
+
+    /// Best of a few parses, the parser keeps the records of the last one.
+    auto timeParse(InstrumentCsvParser &parser, const std::string &csv) {
+        Nanos best = 0;
+        for (int i = 0; i < 3; ++i) {
+            const auto start = Common::getSystemNanos();
+            parser.parse(csv);
+            const auto elapsed = Common::getSystemNanos() - start;
+            best = (i == 0 ? elapsed : std::min(best, elapsed));
+        }
+        return best;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_rows = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000);
+    bool ok = true;
+
+    const auto csv = makeDump(num_rows);
+    std::cout << "Dump:              " << num_rows << " rows, " << csv.size() / 1024 << "KB of CSV" << std::endl;
+
+    const auto baseline_start = Common::getSystemNanos();
+    const auto instruments = Baseline::parse(csv);
+    const auto baseline_nanos = Common::getSystemNanos() - baseline_start;
+    std::cout << "Line by line:      " << baseline_nanos / Common::NANOS_TO_MICROS << "us, " << instruments.size() << " instruments" << std::endl;
+    ok &= (instruments.size() == num_rows);
+
+    // One thread, four threads whether or not there are cores for them, and one per hardware thread
+    for (const size_t threads : {size_t{1}, size_t{4}, size_t{0}}) {
+        InstrumentCsvParser parser(threads);
+        const auto nanos = timeParse(parser, csv);
+        const auto wrong = mismatches(parser.records(), instruments);
+        std::cout << std::left << std::setw(19) << "Threads " + std::to_string(parser.numThreads()) + ":" << nanos / Common::NANOS_TO_MICROS << "us, " << parser.records().size() << " instruments, " << parser.numRejected()
+                  << " skipped, " << wrong << " wrong, " << static_cast<double>(baseline_nanos) / static_cast<double>(std::max<Nanos>(nanos, 1))
+                  << "x line by line" << std::endl;
+        ok &= (wrong == 0 && parser.numRejected() == 0 && parser.numLines() == num_rows);
+    }
+
+    // The records feed the instrument master without a copy of their strings
+    {
+        InstrumentCsvParser parser;
+        parser.parse(csv);
+        const auto start = Common::getSystemNanos();
+        const auto image = InstrumentMaster::build(parser.records());
+        const auto build_nanos = Common::getSystemNanos() - start;
+        InstrumentMaster master{std::vector<char>(image)};
+        size_t wrong = (master.size() != instruments.size());
+        for (uint32_t row = 0; row < std::min<size_t>(master.size(), instruments.size()); ++row)
+            wrong += (master.tradingSymbol(row) != instruments[row].trading_symbol || master.name(row) != instruments[row].name ||
+                      master.findToken(instruments[row].instrument_token) != row);
+        std::cout << "Master build:      " << build_nanos / Common::NANOS_TO_MICROS << "us, " << image.size() / 1024 << "KB, " << wrong
+                  << " wrong" << std::endl;
+        ok &= (master.valid() && wrong == 0);
+    }
+
+    // Quoted commas, doubled quotes, CRLF, short lines, bad numbers and bad dates, a last line without a newline
+    {
+        const std::string edge =
+            "instrument_token,exchange_token,tradingsymbol,name,last_price,expiry,strike,tick_size,lot_size,instrument_type,segment,exchange\r\n"
+            "256265,1001,NIFTY 50,\"NIFTY, 50\",0,,0,0,0,INDEX,INDICES,NSE\r\n"
+            "\n"
+            "12345,48,SHORT,LINE\n"
+            "abc,1,BADTOKEN,X,0,,0,0.05,1,EQ,NSE,NSE\n"
+            "2,2,BADPRICE,X,1.2.3,,0,0.05,1,EQ,NSE,NSE\n"
+            "3,3,\"QUO\"\"TED\",\"SAY \"\"HI\"\", LTD\",  12.5 ,2030-13-01,,0.05,1,eq,NSE,nse\n"
+            "4,4,EXTRA,X,0,2030-01-31,100,0.05,25,FUT,NFO-FUT,NFO,trailing,fields\n"
+            "5,5,LAST,X,0,,0,0.05,1,EQ,BSE,BSE";
+        InstrumentCsvParser parser(1);
+        parser.parse(edge);
+        const auto &records = parser.records();
+        const auto expected_expiry = Baseline::parseDate("2030-01-31");
+        const bool edge_ok = records.size() == 4 && parser.numLines() == 8 && parser.numRejected() == 4 &&
+                             records[0].name == "NIFTY, 50" && records[0].exchange == Exchange::NSE && records[0].segment == "INDICES" &&
+                             records[1].trading_symbol == "QUO\"TED" && records[1].name == "SAY \"HI\", LTD" && records[1].last_price == 12.5 &&
+                             !records[1].expiry && !records[1].strike && records[1].instrument_type == InstrumentType::EQ &&
+                             records[1].exchange == Exchange::NSE && records[2].expiry == expected_expiry && records[2].strike == 100.0 &&
+                             records[2].lot_size == 25 && records[2].exchange == Exchange::NFO && records[3].trading_symbol == "LAST" &&
+                             records[3].exchange == Exchange::BSE;
+        std::cout << "Edge cases:        " << records.size() << " of " << parser.numLines() << " lines parsed, " << parser.numRejected()
+                  << " skipped, " << (edge_ok ? "as expected" : "NOT as expected") << std::endl;
+        ok &= edge_ok;
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
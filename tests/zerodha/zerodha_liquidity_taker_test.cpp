@@ -215,9 +215,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
         );
         
         // Set paper trading mode
-        order_gateway_adapter->setPaperTradingMode(true);
-        order_gateway_adapter->setPaperTradingFillProbability(0.9);
-        order_gateway_adapter->setPaperTradingLatencyRange(10.0, 50.0);
+        order_gateway_adapter->setPaperTradingMode(true, market_updates.get());
         
         // Register instruments with order gateway
         for (const auto& symbol_info : env_config->getInstruments()) {
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "trading/adapters/zerodha/market_data/instrument_token_manager.h"
+#include "trading/adapters/zerodha/market_data/zerodha_option_window.h"
+
+// Benchmark of the option chain index of the instrument master on a generated Kite instruments dump of 100k rows.
+// Times an ATM strike window query of the index against scanning every instrument for it and checks both find the
+// same contracts, then walks spot up and down through the strikes moving a ZerodhaOptionWindow and checks each move
+// only changes the contracts entering and leaving, keeps the ticker IDs of the others and never reallocates.
+// Usage: zerodha_option_chain_benchmark [NUM_ROWS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Common::Nanos;
+
+    constexpr size_t NUM_UNDERLYINGS = 200;
+    constexpr int EXPIRY_DAYS[] = {-5, 10, 40, 70};
+    constexpr double WIDTH = 0.05;
+    constexpr size_t MAX_CONTRACTS = 64;
+    constexpr Common::TickerId FIRST_TICKER_ID = 1'000;
+
+    struct Option {
+        std::string name;
+        int32_t instrument_token;
+        int expiry;    // Index into EXPIRY_DAYS
+        double strike;
+        InstrumentType type;
+    };
+
+    /// Local date days from now as YYYY-MM-DD, as the dump has it.
+    auto date(int days) {
+        const auto time = std::time(nullptr) + days * 86'400;
+        char buffer[16];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", std::localtime(&time));
+        return std::string(buffer);
+    }
+
+    /// Equities, then futures and options of 200 underlyings on three live expiries, with the columns of Kite's dump.
+    auto makeDump(size_t num_rows, std::vector<Option> &options) {
+        std::string csv = "instrument_token,exchange_token,tradingsymbol,name,last_price,expiry,strike,tick_size,lot_size,instrument_type,segment,exchange\n";
+        size_t rows = 0;
+        const auto add = [&](const std::string &exchange, const std::string &segment, const std::string &symbol, const std::string &name,
+                             const std::string &expiry, size_t strike, const std::string &type) {
+            ++rows;
+            const auto token = static_cast<int32_t>((rows << 8) | (exchange == "NFO" ? 2 : 1));
+            csv += std::to_string(token) + "," + std::to_string(rows) + "," + symbol + "," + name + ",0," + expiry + "," + std::to_string(strike) +
+                   ",0.05,50," + type + "," + segment + "," + exchange + "\n";
+            return token;
+        };
+
+        for (size_t i = 0; i < 1'500 && rows < num_rows; ++i)
+            add("NSE", "NSE", "SYM" + std::to_string(i), "COMPANY " + std::to_string(i), "", 0, "EQ");
+        std::vector<std::string> underlyings = {"NIFTY", "BANKNIFTY", "FINNIFTY"};
+        while (underlyings.size() < NUM_UNDERLYINGS)
+            underlyings.push_back("UND" + std::to_string(underlyings.size()));
+        for (const auto &underlying : underlyings) {
+            for (size_t e = 0; e < std::size(EXPIRY_DAYS) && rows < num_rows; ++e)
+                add("NFO", "NFO-FUT", underlying + "F" + std::to_string(e) + "FUT", underlying, date(EXPIRY_DAYS[e]), 0, "FUT");
+        }
+        for (size_t strike = 100; rows < num_rows; strike += 50) {
+            for (const auto &underlying : underlyings) {
+                for (size_t e = 1; e < std::size(EXPIRY_DAYS) && rows < num_rows; ++e) {
+                    for (const auto *type : {"CE", "PE"}) {
+                        if (rows >= num_rows)
+                            continue;
+                        const auto token = add("NFO", "NFO-OPT", underlying + "O" + std::to_string(e) + "S" + std::to_string(strike) + type,
+                                               underlying, date(EXPIRY_DAYS[e]), strike, type);
+                        options.push_back({underlying, token, static_cast<int>(e), static_cast<double>(strike),
+                                           type == std::string("CE") ? InstrumentType::CE : InstrumentType::PE});
+                    }
+                }
+            }
+        }
+        return csv;
+    }
+
+    /// The window found by looking at every option, as a strategy had to without the index.
+    auto scan(const std::vector<Option> &options, const std::string &name, int expiry, double spot, double width) {
+        std::set<int32_t> tokens;
+        for (const auto &option : options) {
+            if (option.name == name && option.expiry == expiry && option.strike >= spot * (1.0 - width) && option.strike <= spot * (1.0 + width))
+                tokens.insert(option.instrument_token);
+        }
+        return tokens;
+    }
+
+    auto tokensOf(const std::vector<OptionContract> &contracts) {
+        std::set<int32_t> tokens;
+        for (const auto &contract : contracts)
+            tokens.insert(contract.instrument_token);
+        return tokens;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_rows = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000);
+
+    Common::Logger logger("zerodha_option_chain_benchmark.log");
+    bool ok = true;
+
+    const auto cache_dir = (std::filesystem::temp_directory_path() / "zerodha_option_chain_benchmark").string();
+    std::filesystem::remove_all(cache_dir);
+    std::filesystem::create_directories(cache_dir);
+    std::vector<Option> options;
+    {
+        std::ofstream file(cache_dir + "/instruments.csv", std::ios::binary);
+        const auto csv = makeDump(num_rows, options);
+        file.write(csv.data(), static_cast<std::streamsize>(csv.size()));
+    }
+    InstrumentTokenManager manager(nullptr, &logger, cache_dir);
+    ok &= manager.initialize();
+    std::cout << "Dump:              " << manager.getNumInstruments() << " instruments, " << options.size() << " options" << std::endl;
+
+    // The weekly expiry is the one in 10 days, the one 5 days ago has expired
+    const auto expiry = manager.getNearestOptionExpiry("NIFTY");
+    const auto expected_expiry = manager.getInstrumentInfo(options[0].instrument_token)->expiry;
+    ok &= (expiry.has_value() && expiry == expected_expiry && !manager.getNearestOptionExpiry("NOSUCHINDEX"));
+
+    // Index against scan, for each underlying at a spot in the middle of its strikes
+    {
+        const double spot = 1'975.0;
+        std::vector<OptionContract> contracts;
+        contracts.reserve(MAX_CONTRACTS);
+        size_t wrong = 0, found = 0, queries = 0;
+        Nanos index_nanos = 0, scan_nanos = 0;
+        for (size_t u = 0; u < NUM_UNDERLYINGS; u += 10, ++queries) {
+            const auto name = (u == 0 ? std::string("NIFTY") : "UND" + std::to_string(u));
+            auto start = Common::getSystemNanos();
+            manager.getOptionWindow(name, *expiry, spot, WIDTH, contracts);
+            index_nanos += Common::getSystemNanos() - start;
+
+            start = Common::getSystemNanos();
+            const auto expected = scan(options, name, 1, spot, WIDTH);
+            scan_nanos += Common::getSystemNanos() - start;
+
+            found += contracts.size();
+            wrong += (tokensOf(contracts) != expected || expected.empty());
+            wrong += !std::is_sorted(contracts.begin(), contracts.end(), [](const OptionContract &a, const OptionContract &b) {
+                return std::tie(a.type, a.strike) < std::tie(b.type, b.strike);
+            });
+        }
+        std::cout << "Window query:      " << index_nanos / static_cast<Nanos>(queries) << "ns by the index, " << scan_nanos / static_cast<Nanos>(queries)
+                  << "ns by a scan, " << found / queries << " contracts each, " << wrong << " wrong" << std::endl;
+        ok &= (wrong == 0 && index_nanos * 10 < scan_nanos);
+    }
+
+    // Spot walks up through the strikes and back, the window follows it
+    {
+        ZerodhaOptionWindow window("NIFTY", *expiry, WIDTH, FIRST_TICKER_ID, MAX_CONTRACTS);
+        const std::set<const OptionContract *> buffers = {window.contracts().data(), window.next().data()};
+        std::map<int32_t, Common::TickerId> ticker_ids;
+        size_t moves = 0, changes = 0, wrong = 0, reallocations = 0;
+        Nanos move_nanos = 0;
+
+        std::vector<double> spots;
+        for (double spot = 1'000.0; spot <= 3'000.0; spot += 7.5)
+            spots.push_back(spot);
+        for (double spot = 3'000.0; spot >= 1'000.0; spot -= 12.5)
+            spots.push_back(spot);
+        for (const auto spot : spots) {
+            const auto start = Common::getSystemNanos();
+            manager.getOptionWindow("NIFTY", *expiry, spot, WIDTH, window.next());
+            const auto changed = window.move(spot);
+            move_nanos += Common::getSystemNanos() - start;
+            ++moves;
+            changes += changed;
+
+            const auto expected = scan(options, "NIFTY", 1, spot, WIDTH);
+            wrong += (tokensOf(window.contracts()) != expected);
+
+            // Every contract that stayed kept its ticker ID, the IDs are distinct and in range
+            std::map<int32_t, Common::TickerId> current;
+            std::set<Common::TickerId> ids;
+            for (size_t i = 0; i < window.contracts().size(); ++i) {
+                const auto token = window.contracts()[i].instrument_token;
+                const auto id = window.tickerIds()[i];
+                current[token] = id;
+                ids.insert(id);
+                wrong += (id < FIRST_TICKER_ID || id >= FIRST_TICKER_ID + MAX_CONTRACTS);
+                wrong += (ticker_ids.count(token) && ticker_ids[token] != id);
+            }
+            wrong += (ids.size() != window.contracts().size());
+
+            // The changes are exactly the contracts that entered and left
+            size_t entered = 0, left = 0;
+            for (const auto &[token, id] : current)
+                entered += !ticker_ids.count(token);
+            for (const auto &[token, id] : ticker_ids)
+                left += !current.count(token);
+            wrong += (entered != window.entered().size() || left != window.left().size() || changed != entered + left ||
+                      window.enteredTokens().size() != entered || window.leftTokens().size() != left);
+            ticker_ids = std::move(current);
+
+            reallocations += !buffers.count(window.contracts().data()) + !buffers.count(window.next().data());
+        }
+        std::cout << "Window moves:      " << moves << " moves, " << move_nanos / static_cast<Nanos>(moves) << "ns each, " << changes
+                  << " contracts changed, " << wrong << " wrong, " << reallocations << " reallocations" << std::endl;
+        ok &= (wrong == 0 && reallocations == 0 && changes > 0);
+    }
+
+    // A window wider than MAX_CONTRACTS keeps the contracts nearest spot, queried into its buffer without growing it
+    {
+        constexpr size_t max_contracts = 16;
+        ZerodhaOptionWindow window("NIFTY", *expiry, 0.5, FIRST_TICKER_ID, max_contracts);
+        const double spot = 2'000.0;
+        const auto capacity = window.next().capacity();
+        const auto queried = manager.getOptionWindow("NIFTY", *expiry, spot, 0.5, window.next(), window.maxContracts());
+        const bool in_place = window.next().capacity() == capacity;
+        std::vector<OptionContract> all;
+        const auto available = manager.getOptionWindow("NIFTY", *expiry, spot, 0.5, all);
+        window.move(spot);
+        double farthest = 0.0;
+        for (const auto &contract : window.contracts())
+            farthest = std::max(farthest, std::abs(contract.strike - spot));
+        const bool kept_nearest = window.contracts().size() == max_contracts && farthest <= 200.0;
+        std::cout << "Capped window:     " << window.contracts().size() << " of " << available << " contracts kept, " << queried
+                  << " queried, farthest strike " << farthest << " from spot" << std::endl;
+        ok &= (available > max_contracts && queried == max_contracts && in_place && kept_nearest);
+    }
+
+    std::filesystem::remove_all(cache_dir);
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "common/lf_queue.h"
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "exchange/market_data/market_update.h"
+#include "trading/adapters/zerodha/market_data/orderbook/zerodha_order_book.h"
+
+// Benchmark of ZerodhaOrderBook depth diffing on one core - synthetic Kite FULL packets of a random walking 5 level
+// book go through the order book, the generated events straight into the slots of the trade engine's queue. Reports
+// ticks/s, events per tick and latency per tick, checks no heap allocation happens per tick, that replaying the
+// events rebuilds exactly the depth of every packet and that ticks older than the last one applied are dropped.
+// Usage: zerodha_order_book_benchmark [NUM_TICKS]
+
+namespace {
+    std::atomic<size_t> num_allocations = 0;
+}
+
+// Counts every heap allocation of the process, to show the tick path makes none. GCC inlines these replacements into
+// new/delete pairs it can see and then flags the free() of memory from operator new, which is exactly what they do.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void *operator new(std::size_t size) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+#pragma GCC diagnostic pop
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Common::Nanos;
+
+    constexpr size_t NUM_PACKETS = 64 * 1024;
+    constexpr int32_t TICK = 5;    // 0.05 rupees
+
+    /// A FULL tick as it comes off the tick queue.
+    struct Packet {
+        ZerodhaTick tick;
+        ZerodhaTickDepth depth;
+    };
+
+    /// A random walk of the top 5 levels, with quantity changes, levels appearing and disappearing and trades.
+    auto makePackets(size_t count) {
+        std::mt19937 rng(42);
+        std::vector<Packet> packets(count);
+        int32_t best_bid = 150'000;
+        int32_t volume = 100'000;
+        for (auto &[tick, depth] : packets) {
+            tick = {};
+            depth = {};
+            tick.instrument_token = 408'065;
+            tick.type = MarketUpdateType::FULL;
+            const auto move = static_cast<int32_t>(rng() % 7) - 3;
+            best_bid += (move == -3 ? -TICK : move == 3 ? TICK : 0);
+            if (rng() % 3 == 0) {
+                volume += static_cast<int32_t>(1 + rng() % 500);
+                tick.last_price = best_bid + static_cast<int32_t>(rng() % 2) * TICK;
+            } else {
+                tick.last_price = best_bid;
+            }
+            tick.last_quantity = 1;
+            tick.volume = volume;
+            for (size_t level = 0; level < 5; ++level) {
+                depth.bid_orders[level] = static_cast<int16_t>(1 + rng() % 20);
+                depth.ask_orders[level] = static_cast<int16_t>(1 + rng() % 20);
+            }
+            for (int32_t level = 0, price = best_bid; level < 5; ++level, price -= TICK * static_cast<int32_t>(1 + (rng() % 4 == 0))) {
+                depth.bids[level] = {price, static_cast<int32_t>(100 + rng() % 8 * 50)};
+            }
+            for (int32_t level = 0, price = best_bid + TICK; level < 5; ++level, price += TICK * static_cast<int32_t>(1 + (rng() % 4 == 0))) {
+                depth.asks[level] = {price, static_cast<int32_t>(100 + rng() % 8 * 50)};
+            }
+            // Now and then a thin book with empty levels at the end
+            if (rng() % 16 == 0)
+                depth.asks[4] = {};
+        }
+        return packets;
+    }
+
+    /// The i-th tick of the packets played over and over after a first pass, each pass a second later and on top of
+    /// the volume of the previous ones, so a pass is not dropped as older than the one before.
+    auto replay(const std::vector<Packet> &packets, size_t i) {
+        const auto pass = static_cast<int32_t>(i / NUM_PACKETS + 1);
+        auto tick = packets[i % NUM_PACKETS].tick;
+        tick.exchange_timestamp = 1'000'000 + pass;
+        tick.volume += pass * packets.back().tick.volume;
+        return tick;
+    }
+
+    auto percentile(std::vector<Nanos> samples, double p) -> Nanos {
+        if (samples.empty())
+            return -1;
+        std::sort(samples.begin(), samples.end());
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))];
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_ticks = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000);
+
+    Common::Logger logger("zerodha_order_book_benchmark.log");
+    const auto packets = makePackets(NUM_PACKETS);
+    Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+    bool ok = true;
+
+    // Correctness - the events, applied by level order id, rebuild the depth of every packet.
+    {
+        ZerodhaOrderBook book(0, &logger);
+        std::map<Common::OrderId, Exchange::MEMarketUpdate> levels;
+        size_t mismatches = 0;
+        for (const auto &packet : packets) {
+            book.processMarketUpdate(packet.tick, &packet.depth, [&](const Exchange::MEMarketUpdate &event) {
+                if (event.type_ == Exchange::MarketUpdateType::ADD || event.type_ == Exchange::MarketUpdateType::MODIFY)
+                    levels[event.order_id_] = event;
+                else if (event.type_ == Exchange::MarketUpdateType::CANCEL)
+                    levels.erase(event.order_id_);
+            });
+
+            std::map<Common::OrderId, Common::Qty> expected;
+            for (const auto &entry : packet.depth.bids)
+                if (entry.price > 0 && entry.quantity > 0)
+                    expected[ZerodhaOrderBook::generateOrderId(0, entry.price, Common::Side::BUY)] = entry.quantity;
+            for (const auto &entry : packet.depth.asks)
+                if (entry.price > 0 && entry.quantity > 0)
+                    expected[ZerodhaOrderBook::generateOrderId(0, entry.price, Common::Side::SELL)] = entry.quantity;
+            bool same = (expected.size() == levels.size());
+            for (auto itr = expected.begin(); same && itr != expected.end(); ++itr) {
+                const auto level = levels.find(itr->first);
+                same = (level != levels.end() && level->second.qty_ == itr->second);
+            }
+            mismatches += !same;
+        }
+        std::cout << "Rebuilt depth:     " << packets.size() - mismatches << " of " << packets.size() << " packets match" << std::endl;
+        ok &= (mismatches == 0);
+    }
+
+    // Stale ticks - after a rebalance the old connection can still deliver ticks older than ones already applied,
+    // by exchange time or by volume within a second. They must leave the book and the trades untouched.
+    {
+        ZerodhaOrderBook book(0, &logger);
+        auto fresh = packets[200];
+        auto older = packets[100];
+        auto same_second = packets[150];
+        fresh.tick.exchange_timestamp = 1'000'002;
+        older.tick.exchange_timestamp = 1'000'001;
+        same_second.tick.exchange_timestamp = 1'000'002;
+        size_t events = 0;
+        const auto count = [&](const Exchange::MEMarketUpdate &) { ++events; };
+        book.processMarketUpdate(packets[0].tick, &packets[0].depth, count);
+        book.processMarketUpdate(fresh.tick, &fresh.depth, count);
+        const std::vector<ZerodhaOrderBook::PriceLevel> bids(book.getBids().begin(), book.getBids().end());
+        events = 0;
+        book.processMarketUpdate(older.tick, &older.depth, count);
+        book.processMarketUpdate(same_second.tick, &same_second.depth, count);
+        const bool same = std::equal(bids.begin(), bids.end(), book.getBids().begin(), book.getBids().end(),
+                                     [](const auto &a, const auto &b) { return a.price == b.price && a.quantity == b.quantity; });
+        std::cout << "Stale ticks:       " << book.getStaleTicks() << " of 2 dropped, " << events << " events" << std::endl;
+        ok &= (same_second.tick.volume < fresh.tick.volume && book.getStaleTicks() == 2 && events == 0 && same);
+    }
+
+    // Throughput - one core, the events written into the queue and consumed like the trade engine would.
+    ZerodhaOrderBook book(0, &logger);
+    size_t num_events = 0;
+    auto emit = [&](const Exchange::MEMarketUpdate &event) {
+        *market_updates.getNextToWriteTo() = event;
+        market_updates.updateWriteIndex();
+        ++num_events;
+    };
+    auto drain = [&]() {
+        while (market_updates.getNextToRead())
+            market_updates.updateReadIndex();
+    };
+    for (const auto &packet : packets) {
+        book.processMarketUpdate(packet.tick, &packet.depth, emit);
+        drain();
+    }
+
+    num_events = 0;
+    const auto allocations_before = num_allocations.load();
+    const auto start = Common::getSystemNanos();
+    for (size_t i = 0; i < num_ticks; ++i) {
+        book.processMarketUpdate(replay(packets, i), &packets[i % NUM_PACKETS].depth, emit);
+        drain();
+    }
+    const auto elapsed = Common::getSystemNanos() - start;
+    const auto allocations = num_allocations.load() - allocations_before;
+
+    // Per tick latency on a sample, timer overhead included.
+    std::vector<Nanos> latencies;
+    latencies.reserve(NUM_PACKETS);
+    for (size_t i = num_ticks; i < num_ticks + NUM_PACKETS; ++i) {
+        const auto tick = replay(packets, i);
+        const auto tick_start = Common::getSystemNanos();
+        book.processMarketUpdate(tick, &packets[i % NUM_PACKETS].depth, emit);
+        latencies.push_back(Common::getSystemNanos() - tick_start);
+        drain();
+    }
+
+    std::cout << "Throughput:        " << static_cast<size_t>(static_cast<double>(num_ticks) * Common::NANOS_TO_SECS / static_cast<double>(elapsed))
+              << " ticks/s on one core, " << static_cast<double>(num_events) / static_cast<double>(num_ticks) << " events per tick" << std::endl;
+    std::cout << "Per tick:          p50 " << percentile(latencies, 0.5) << "ns, p99 " << percentile(latencies, 0.99) << "ns" << std::endl;
+    std::cout << "Allocations:       " << allocations << " over " << num_ticks << " ticks" << std::endl;
+    ok &= (allocations == 0);
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -35,8 +35,8 @@ void printOrderBook(const Adapter::Zerodha::ZerodhaOrderBook* book, const std::s
     // Print bid side (top 5)
     std::cout << "Bids:" << std::endl;
     int count = 0;
-    for (const auto& [price, level] : book->getBids()) {
-        std::cout << "  " << level.quantity << " @ " << std::fixed << std::setprecision(2) << level.price 
+    for (const auto& level : book->getBids()) {
+        std::cout << "  " << level.quantity << " @ " << std::fixed << std::setprecision(2) << level.price / 100.0 
                   << " (" << level.orders << " orders)" << std::endl;
         if (++count >= 5) break;
     }
@@ -44,8 +44,8 @@ void printOrderBook(const Adapter::Zerodha::ZerodhaOrderBook* book, const std::s
     // Print ask side (top 5)
     std::cout << "Asks:" << std::endl;
     count = 0;
-    for (const auto& [price, level] : book->getAsks()) {
-        std::cout << "  " << level.quantity << " @ " << std::fixed << std::setprecision(2) << level.price 
+    for (const auto& level : book->getAsks()) {
+        std::cout << "  " << level.quantity << " @ " << std::fixed << std::setprecision(2) << level.price / 100.0 
                   << " (" << level.orders << " orders)" << std::endl;
         if (++count >= 5) break;
     }
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "exchange/order_server/client_request.h"
+#include "exchange/order_server/client_response.h"
+#include "trading/adapters/sim/rest_order_entry_simulator.h"
+#include "trading/adapters/zerodha/order_gw/zerodha_order_gateway_adapter.h"
+
+// Round-trip benchmark of the Zerodha order gateway in live mode against the local Kite order entry simulator, no
+// network or credentials needed. Measures NEW -> ACCEPTED and CANCEL -> CANCELED latency over the gateway's kept-alive
+// connection, the throughput of a burst of orders, how long a fill takes to show up through the status poll, that
+// partial fills at two prices are each reported at their own price, that a modify right after a fill keeps the
+// filled quantity in the order's total, what Kite's 10 orders/s limit does to a burst, that an "EXCH:SYMBOL"
+// instrument is placed on its exchange with its symbol URL-encoded, and that a bad access token is refused.
+// Usage: zerodha_order_gateway_benchmark [NUM_ORDERS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using namespace Adapter::Sim;
+    using Common::Nanos;
+
+    constexpr Common::ClientId CLIENT_ID = 1;
+    constexpr Common::Price START_PRICE = 150'000;      // 1500.00 in paise
+    constexpr Common::Price BID_PRICE = 149'000;        // Rests, within the circuit and away from the market
+    constexpr int POLL_INTERVAL_MS = 20;
+    constexpr Nanos TIMEOUT_NANOS = 10 * Common::NANOS_TO_SECS;
+
+    auto simConfig() {
+        RestOrderEntrySimulatorConfig config;
+        config.protocol = SimProtocol::KITE;
+        config.instruments.push_back({0, 408'065, "INFY", START_PRICE});
+        return config;
+    }
+
+    auto percentile(std::vector<Nanos> samples, double p) -> Nanos {
+        if (samples.empty())
+            return -1;
+        std::sort(samples.begin(), samples.end());
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))];
+    }
+
+    auto printLatencies(const std::string& label, const std::vector<Nanos>& samples) {
+        std::cout << label << std::string(label.size() < 19 ? 19 - label.size() : 1, ' ') << "p50 "
+                  << percentile(samples, 0.5) / Common::NANOS_TO_MICROS << "us, p99 " << percentile(samples, 0.99) / Common::NANOS_TO_MICROS
+                  << "us over " << samples.size() << " orders" << std::endl;
+    }
+
+    /// A live gateway pointed at the simulator, and the responses it has published so far.
+    class Session {
+    public:
+        Session(uint16_t port, const std::string& access_token, Common::Logger *logger, int poll_interval_ms = POLL_INTERVAL_MS,
+                const std::string& symbol = "INFY")
+            : requests_(Common::ME_MAX_CLIENT_UPDATES), responses_(Common::ME_MAX_CLIENT_UPDATES),
+              gateway_(logger, CLIENT_ID, &requests_, &responses_, "sim_api_key", "sim_api_secret") {
+            gateway_.registerInstrument(symbol, 0);
+            gateway_.setPaperTradingMode(false);
+            gateway_.setOrderStatusPollInterval(poll_interval_ms);
+            gateway_.setAccessToken(access_token);
+            gateway_.setApiEndpoint("https://127.0.0.1:" + std::to_string(port), false);
+            gateway_.start();
+        }
+
+        ~Session() {
+            gateway_.stop();
+        }
+
+        auto send(Exchange::ClientRequestType type, Common::OrderId order_id, Common::Price price, Common::Qty qty) {
+            *requests_.getNextToWriteTo() = {type, CLIENT_ID, 0, order_id, Common::Side::BUY, price, qty};
+            requests_.updateWriteIndex();
+        }
+
+        /// Wait for a response of the given type to the order, the time it took, -1 on timeout.
+        auto waitFor(Exchange::ClientResponseType type, Common::OrderId order_id) -> Nanos {
+            const auto start = Common::getSystemNanos();
+            while (Common::getSystemNanos() - start < TIMEOUT_NANOS) {
+                for (auto response = responses_.getNextToRead(); response; response = responses_.getNextToRead()) {
+                    const auto received = *response;
+                    responses_.updateReadIndex();
+                    ++counts_[static_cast<size_t>(received.type_)];
+                    if (received.type_ == type && received.order_id_ == order_id) {
+                        last_ = received;
+                        return Common::getSystemNanos() - start;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+            return -1;
+        }
+
+        /// Wait until count responses of the given type arrived in total, false on timeout.
+        auto waitForCount(Exchange::ClientResponseType type, size_t count) {
+            const auto start = Common::getSystemNanos();
+            while (counts_[static_cast<size_t>(type)] < count && Common::getSystemNanos() - start < TIMEOUT_NANOS) {
+                for (auto response = responses_.getNextToRead(); response; response = responses_.getNextToRead()) {
+                    ++counts_[static_cast<size_t>(response->type_)];
+                    responses_.updateReadIndex();
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+            return counts_[static_cast<size_t>(type)] >= count;
+        }
+
+        auto count(Exchange::ClientResponseType type) const {
+            return counts_[static_cast<size_t>(type)];
+        }
+
+        Exchange::ClientRequestLFQueue requests_;
+        Exchange::ClientResponseLFQueue responses_;
+        ZerodhaOrderGatewayAdapter gateway_;
+        Exchange::MEClientResponse last_;
+        std::array<size_t, 8> counts_{};
+    };
+}
+
+int main(int argc, char **argv) {
+    const size_t num_orders = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200);
+
+    Common::Logger gateway_logger("zerodha_order_gateway_benchmark.log");
+    Common::Logger sim_logger("zerodha_rest_simulator.log");
+    bool ok = true;
+
+    {
+        RestOrderEntrySimulator sim(simConfig(), &sim_logger);
+        sim.start();
+        Session session(sim.port(), "sim_access_token", &gateway_logger);
+        Common::OrderId next_order_id = 1;
+
+        // One order at a time - the request's time in the gateway's queue, the REST round trip and the response.
+        std::vector<Nanos> new_latencies, cancel_latencies;
+        for (size_t i = 0; i < num_orders; ++i) {
+            const auto order_id = next_order_id++;
+            session.send(Exchange::ClientRequestType::NEW, order_id, BID_PRICE, 10);
+            new_latencies.push_back(session.waitFor(Exchange::ClientResponseType::ACCEPTED, order_id));
+            session.send(Exchange::ClientRequestType::CANCEL, order_id, BID_PRICE, 10);
+            cancel_latencies.push_back(session.waitFor(Exchange::ClientResponseType::CANCELED, order_id));
+        }
+        ok &= (std::count(new_latencies.begin(), new_latencies.end(), -1) == 0 &&
+               std::count(cancel_latencies.begin(), cancel_latencies.end(), -1) == 0);
+        printLatencies("NEW -> ACCEPTED:", new_latencies);
+        printLatencies("CANCEL -> CANCELED:", cancel_latencies);
+
+        // A burst - every request queued at once, the gateway sends them one after the other.
+        const auto burst_start = Common::getSystemNanos();
+        const auto first_burst_id = next_order_id;
+        const auto accepted = session.count(Exchange::ClientResponseType::ACCEPTED);
+        for (size_t i = 0; i < num_orders; ++i)
+            session.send(Exchange::ClientRequestType::NEW, next_order_id++, BID_PRICE, 10);
+        ok &= session.waitForCount(Exchange::ClientResponseType::ACCEPTED, accepted + num_orders);
+        const auto burst_nanos = Common::getSystemNanos() - burst_start;
+        std::cout << "Burst:             " << num_orders << " orders accepted in " << burst_nanos / Common::NANOS_TO_MILLIS << "ms ("
+                  << static_cast<size_t>(static_cast<double>(num_orders) * Common::NANOS_TO_SECS / static_cast<double>(burst_nanos))
+                  << " orders/s)" << std::endl;
+        const auto canceled = session.count(Exchange::ClientResponseType::CANCELED);
+        for (auto order_id = first_burst_id; order_id < next_order_id; ++order_id)
+            session.send(Exchange::ClientRequestType::CANCEL, order_id, BID_PRICE, 10);
+        ok &= session.waitForCount(Exchange::ClientResponseType::CANCELED, canceled + num_orders);
+
+        // A fill - a trade through the resting bid, seen by the gateway on its next status poll.
+        const auto fill_order_id = next_order_id++;
+        session.send(Exchange::ClientRequestType::NEW, fill_order_id, BID_PRICE, 10);
+        ok &= (session.waitFor(Exchange::ClientResponseType::ACCEPTED, fill_order_id) > 0);
+        Exchange::MEMarketUpdate trade;
+        trade.type_ = Exchange::MarketUpdateType::TRADE;
+        trade.ticker_id_ = 0;
+        trade.side_ = Common::Side::SELL;
+        trade.price_ = BID_PRICE - 100;
+        trade.qty_ = 10;
+        sim.on_market_update(&trade);
+        const auto fill_latency = session.waitFor(Exchange::ClientResponseType::FILLED, fill_order_id);
+        ok &= (fill_latency > 0 && session.last_.exec_qty_ == 10 && session.last_.leaves_qty_ == 0);
+        std::cout << "Fill:              reported " << fill_latency / Common::NANOS_TO_MICROS << "us after the trade, status poll every "
+                  << POLL_INTERVAL_MS << "ms" << std::endl;
+
+        // Fills at two prices - a buy takes the 4 offered below its price, the rest fills on a trade at its price. Kite
+        // only reports the average price, each fill's own price is recovered from how the new executions moved it.
+        Exchange::MEMarketUpdate offer;
+        offer.type_ = Exchange::MarketUpdateType::ADD;
+        offer.order_id_ = 1;
+        offer.ticker_id_ = 0;
+        offer.side_ = Common::Side::SELL;
+        offer.price_ = START_PRICE;
+        offer.qty_ = 4;
+        sim.on_market_update(&offer);
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+        const auto partial_order_id = next_order_id++;
+        session.send(Exchange::ClientRequestType::NEW, partial_order_id, START_PRICE + 10, 10);
+        const bool first_fill = (session.waitFor(Exchange::ClientResponseType::FILLED, partial_order_id) > 0);
+        const auto first = session.last_;
+        trade.side_ = Common::Side::SELL;
+        trade.price_ = START_PRICE + 10;
+        trade.qty_ = 6;
+        sim.on_market_update(&trade);
+        const bool second_fill = (session.waitFor(Exchange::ClientResponseType::FILLED, partial_order_id) > 0);
+        const auto second = session.last_;
+        std::cout << "Partial fills:     " << first.exec_qty_ << "@" << first.price_ << " then " << second.exec_qty_ << "@" << second.price_
+                  << ", leaves " << second.leaves_qty_ << std::endl;
+        ok &= (first_fill && second_fill && first.exec_qty_ == 4 && first.price_ == START_PRICE && first.leaves_qty_ == 6 &&
+               second.exec_qty_ == 6 && second.price_ == START_PRICE + 10 && second.leaves_qty_ == 0);
+
+        // Every request above went over the connection the gateway opened first.
+        const auto stats = sim.stats();
+        std::cout << "Connections:       " << stats.connections << " for " << stats.requests << " requests" << std::endl;
+        ok &= (stats.connections == 1 && stats.fills == 3);
+    }
+
+    // A modify right after a fill no status poll has seen yet - the buy takes the 4 offered on arrival and is
+    // modified to leave 6 open in the same batch of requests. The gateway refreshes the order's status first, so Kite's total quantity counts the 4
+    // and a trade of 3 later still finds 6 open, 3 of them left when it is cancelled.
+    {
+        RestOrderEntrySimulator sim(simConfig(), &sim_logger);
+        sim.start();
+        Session session(sim.port(), "sim_access_token", &gateway_logger, 60'000);
+        Exchange::MEMarketUpdate offer;
+        offer.type_ = Exchange::MarketUpdateType::ADD;
+        offer.order_id_ = 1;
+        offer.ticker_id_ = 0;
+        offer.side_ = Common::Side::SELL;
+        offer.price_ = START_PRICE;
+        offer.qty_ = 4;
+        sim.on_market_update(&offer);
+        session.send(Exchange::ClientRequestType::NEW, 1, START_PRICE + 10, 10);
+        session.send(Exchange::ClientRequestType::MODIFY, 1, BID_PRICE, 6);
+        const bool accepted = (session.waitFor(Exchange::ClientResponseType::ACCEPTED, 1) > 0);
+        const bool modified = (session.waitFor(Exchange::ClientResponseType::ACCEPTED, 1) > 0);
+        const auto modify = session.last_;
+        const auto fills_before = session.count(Exchange::ClientResponseType::FILLED);
+
+        Exchange::MEMarketUpdate trade;
+        trade.type_ = Exchange::MarketUpdateType::TRADE;
+        trade.ticker_id_ = 0;
+        trade.side_ = Common::Side::SELL;
+        trade.price_ = BID_PRICE - 100;
+        trade.qty_ = 3;
+        sim.on_market_update(&trade);
+        session.send(Exchange::ClientRequestType::CANCEL, 1, BID_PRICE, 6);
+        const bool filled = (session.waitFor(Exchange::ClientResponseType::FILLED, 1) > 0);
+        const auto fill = session.last_;
+        const bool canceled = (session.waitFor(Exchange::ClientResponseType::CANCELED, 1) > 0);
+        std::cout << "Modify after fill: " << fills_before << " fill reported first, leaves " << modify.leaves_qty_ << ", then "
+                  << fill.exec_qty_ << " filled leaving " << fill.leaves_qty_ << (canceled ? ", cancelled" : ", not cancelled") << std::endl;
+        ok &= (accepted && modified && fills_before == 1 && modify.leaves_qty_ == 6 && filled && fill.exec_qty_ == 3 &&
+               fill.leaves_qty_ == 3 && canceled);
+    }
+
+    // Kite's order rate limit - a burst beyond it gets the excess rejected rather than queued.
+    {
+        auto config = simConfig();
+        config.order_rate_limit = 10;
+        RestOrderEntrySimulator sim(config, &sim_logger);
+        sim.start();
+        Session session(sim.port(), "sim_access_token", &gateway_logger);
+        constexpr size_t BURST = 30;
+        for (Common::OrderId order_id = 1; order_id <= BURST; ++order_id)
+            session.send(Exchange::ClientRequestType::NEW, order_id, BID_PRICE, 10);
+        session.waitFor(Exchange::ClientResponseType::REJECTED, BURST);
+        const auto stats = sim.stats();
+        std::cout << "Rate limit:        " << session.count(Exchange::ClientResponseType::ACCEPTED) << " of " << BURST << " accepted, "
+                  << stats.rate_limited << " refused with 429" << std::endl;
+        ok &= (session.count(Exchange::ClientResponseType::ACCEPTED) == 10 && stats.rate_limited == BURST - 10);
+    }
+
+    // An "EXCH:SYMBOL" name whose symbol has to be URL-encoded, with another product - the order is placed on the
+    // registered exchange under the bare symbol.
+    {
+        RestOrderEntrySimulatorConfig config;
+        config.protocol = SimProtocol::KITE;
+        config.instruments.push_back({0, 519'937, "M&M", START_PRICE});
+        RestOrderEntrySimulator sim(config, &sim_logger);
+        sim.start();
+        Session session(sim.port(), "sim_access_token", &gateway_logger, POLL_INTERVAL_MS, "NSE:M&M");
+        session.gateway_.setProduct("CNC");
+        session.send(Exchange::ClientRequestType::NEW, 1, BID_PRICE, 10);
+        const bool accepted = (session.waitFor(Exchange::ClientResponseType::ACCEPTED, 1) > 0);
+        const auto stats = sim.stats();
+        std::cout << "Exchange prefix:   NSE:M&M " << (accepted ? "accepted" : "not accepted") << ", " << stats.rejects << " rejects" << std::endl;
+        ok &= (accepted && stats.orders_placed == 1 && stats.rejects == 0);
+    }
+
+    // A stale access token - the order is rejected, nothing reaches the book.
+    {
+        RestOrderEntrySimulator sim(simConfig(), &sim_logger);
+        sim.start();
+        Session session(sim.port(), "expired_access_token", &gateway_logger);
+        session.send(Exchange::ClientRequestType::NEW, 1, BID_PRICE, 10);
+        const bool rejected = (session.waitFor(Exchange::ClientResponseType::REJECTED, 1) > 0);
+        const auto stats = sim.stats();
+        std::cout << "Bad token:         " << (rejected ? "order rejected" : "order not rejected") << ", " << stats.auth_failures
+                  << " auth failures" << std::endl;
+        ok &= (rejected && stats.auth_failures == 1 && stats.orders_placed == 0);
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -156,6 +156,9 @@ int main(int argc, char** argv) {
         ExchangeNS::ClientRequestLFQueue client_requests(ORDER_QUEUE_SIZE);
         ExchangeNS::ClientResponseLFQueue client_responses(ORDER_QUEUE_SIZE);
         
+        // Market updates the paper trading engine fills against - no feed runs in this test, so paper orders rest
+        ExchangeNS::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+        
         // Client ID for this test
         Common::ClientId client_id = 1;
         
@@ -218,13 +221,11 @@ int main(int argc, char** argv) {
         );
         
         // Configure the adapter for paper or live trading
-        order_gateway.setPaperTradingMode(use_paper_trading);
+        order_gateway.setPaperTradingMode(use_paper_trading, &market_updates);
         
         if (use_paper_trading) {
             // Configure paper trading parameters
-            order_gateway.setPaperTradingFillProbability(0.9);  // 90% fill probability
-            order_gateway.setPaperTradingLatencyRange(50, 200); // 50-200ms latency
-            order_gateway.setPaperTradingSlippageFactor(0.001); // 0.1% slippage
+            order_gateway.setPaperTradingLatencySamples({50 * Common::NANOS_TO_MILLIS, 200 * Common::NANOS_TO_MILLIS});
             
             logger.log("%:% %() % Configured paper trading parameters\n", 
                      __FILE__, __LINE__, __FUNCTION__, 
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "exchange/market_data/market_update.h"
+#include "exchange/order_server/client_request.h"
+#include "exchange/order_server/client_response.h"
+#include "trading/adapters/zerodha/market_data/orderbook/zerodha_order_book.h"
+#include "trading/adapters/zerodha/order_gw/zerodha_order_gateway_adapter.h"
+
+// Benchmark of paper trading through the Zerodha order gateway and the paper trading engine, fed Kite FULL packets
+// through ZerodhaOrderBook the way the market data adapter does. Checks a passive order waits for the volume ahead of
+// it to trade before it fills, that a trade through its price fills it outright and that ACCEPTED comes back no sooner
+// than the configured round trip. Then measures the market data path per packet with and without the engine tapping it.
+// Usage: zerodha_paper_trading_benchmark [NUM_ORDERS] [NUM_PACKETS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Common::Nanos;
+
+    constexpr Common::ClientId CLIENT_ID = 1;
+    constexpr Nanos ROUND_TRIP_NANOS = 2 * Common::NANOS_TO_MILLIS;
+    constexpr Nanos TIMEOUT_NANOS = 5 * Common::NANOS_TO_SECS;
+
+    auto percentile(std::vector<Nanos> samples, double p) -> Nanos {
+        if (samples.empty())
+            return -1;
+        std::sort(samples.begin(), samples.end());
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))];
+    }
+
+    /// Depth and day volume of one instrument, as the Kite feed would report it.
+    struct Market {
+        std::map<int32_t, int32_t, std::greater<>> bids;    // paise -> quantity
+        std::map<int32_t, int32_t> asks;
+        int32_t last_price = 150'000;
+        int32_t volume = 10'000;
+
+        auto trade(int32_t price, int32_t qty) {
+            last_price = price;
+            volume += qty;
+        }
+
+        auto packet() const {
+            std::pair<ZerodhaTick, ZerodhaTickDepth> update{};
+            auto &[tick, depth] = update;
+            tick.instrument_token = 408'065;
+            tick.type = MarketUpdateType::FULL;
+            tick.last_price = last_price;
+            tick.last_quantity = 1;
+            tick.volume = volume;
+            size_t level = 0;
+            for (auto itr = bids.begin(); itr != bids.end() && level < 5; ++itr, ++level)
+                depth.bids[level] = {itr->first, itr->second};
+            level = 0;
+            for (auto itr = asks.begin(); itr != asks.end() && level < 5; ++itr, ++level)
+                depth.asks[level] = {itr->first, itr->second};
+            return update;
+        }
+    };
+
+    /// Gateway in paper trading mode, with the engine it starts, and the feed the engine taps.
+    class Session {
+    public:
+        Session()
+            : book_logger_("zerodha_paper_trading_book.log"), gateway_logger_("zerodha_paper_trading_gateway.log"),
+              requests_(Common::ME_MAX_CLIENT_UPDATES), responses_(Common::ME_MAX_CLIENT_UPDATES),
+              market_updates_(Common::ME_MAX_MARKET_UPDATES), book_(0, &book_logger_),
+              gateway_(&gateway_logger_, CLIENT_ID, &requests_, &responses_, "paper_api_key", "paper_api_secret") {
+            gateway_.registerInstrument("INFY", 0);
+            gateway_.setPaperTradingMode(true, &market_updates_);
+            gateway_.setPaperTradingLatencySamples({ROUND_TRIP_NANOS});
+            gateway_.start();
+        }
+
+        ~Session() {
+            gateway_.stop();
+        }
+
+        auto engine() const {
+            return gateway_.paperTradingEngine();
+        }
+
+        /// Publish a packet to the queue the trade engine reads, like the market data adapter, and consume it.
+        auto publish(const std::pair<ZerodhaTick, ZerodhaTickDepth> &update) {
+            book_.processMarketUpdate(update.first, &update.second, [this](const Exchange::MEMarketUpdate &event) {
+                *market_updates_.getNextToWriteTo() = event;
+                market_updates_.updateWriteIndex();
+            });
+            while (market_updates_.getNextToRead())
+                market_updates_.updateReadIndex();
+        }
+
+        auto send(Exchange::ClientRequestType type, Common::OrderId order_id, Common::Side side, Common::Price price, Common::Qty qty) {
+            *requests_.getNextToWriteTo() = {type, CLIENT_ID, 0, order_id, side, price, qty};
+            requests_.updateWriteIndex();
+        }
+
+        /// Wait for a response of the given type to the order, the time it took, -1 on timeout.
+        auto waitFor(Exchange::ClientResponseType type, Common::OrderId order_id, Nanos timeout = TIMEOUT_NANOS) -> Nanos {
+            const auto start = Common::getSystemNanos();
+            while (Common::getSystemNanos() - start < timeout) {
+                for (auto response = responses_.getNextToRead(); response; response = responses_.getNextToRead()) {
+                    const auto received = *response;
+                    responses_.updateReadIndex();
+                    ++counts_[static_cast<size_t>(received.type_)];
+                    if (received.type_ == type && received.order_id_ == order_id) {
+                        last_ = received;
+                        return Common::getSystemNanos() - start;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+            return -1;
+        }
+
+        auto count(Exchange::ClientResponseType type) const {
+            return counts_[static_cast<size_t>(type)];
+        }
+
+        // One logger per thread writing to it - the feed and the gateway, the engine has its own.
+        Common::Logger book_logger_, gateway_logger_;
+        Exchange::ClientRequestLFQueue requests_;
+        Exchange::ClientResponseLFQueue responses_;
+        Exchange::MEMarketUpdateLFQueue market_updates_;
+        ZerodhaOrderBook book_;
+        ZerodhaOrderGatewayAdapter gateway_;
+        Exchange::MEClientResponse last_;
+        std::array<size_t, 8> counts_{};
+    };
+
+    /// Nanoseconds per packet through the order book and onto the trade engine's queue.
+    auto marketDataPath(Session &session, size_t num_packets) {
+        Market market;
+        market.bids = {{149'900, 500}, {149'895, 300}};
+        market.asks = {{149'905, 400}, {149'910, 600}};
+        const auto start = Common::getSystemNanos();
+        for (size_t i = 0; i < num_packets; ++i) {
+            market.bids[149'900] = 500 + static_cast<int32_t>(i % 7) * 10;
+            market.asks[149'905] = 400 + static_cast<int32_t>(i % 5) * 10;
+            if (i % 3 == 0)
+                market.trade(i % 2 ? 149'905 : 149'900, 10);
+            session.publish(market.packet());
+        }
+        return (Common::getSystemNanos() - start) / static_cast<Nanos>(num_packets);
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_orders = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200);
+    const size_t num_packets = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20'000);
+
+    bool ok = true;
+
+    {
+        Session session;
+        Market market;
+        market.bids = {{150'000, 500}, {149'995, 300}};
+        market.asks = {{150'005, 400}, {150'010, 600}};
+        session.publish(market.packet());
+
+        // Queue position - a bid joining 500 behind at the best bid. Trades at its price work through the queue
+        // ahead first, quantity joining behind does not matter.
+        session.send(Exchange::ClientRequestType::NEW, 1, Common::Side::BUY, 150'000, 100);
+        ok &= (session.waitFor(Exchange::ClientResponseType::ACCEPTED, 1) > 0);
+        market.trade(150'000, 300);
+        market.bids[150'000] = 200;
+        session.publish(market.packet());
+        market.bids[150'000] = 350;
+        session.publish(market.packet());
+        const bool early_fill = (session.waitFor(Exchange::ClientResponseType::FILLED, 1, 50 * Common::NANOS_TO_MILLIS) > 0);
+        market.trade(150'000, 250);
+        market.bids[150'000] = 100;
+        session.publish(market.packet());
+        const bool partial = (session.waitFor(Exchange::ClientResponseType::FILLED, 1) > 0 && session.last_.exec_qty_ == 50 &&
+                              session.last_.leaves_qty_ == 50);
+        market.trade(150'000, 100);
+        market.bids.erase(150'000);
+        session.publish(market.packet());
+        const bool filled = (session.waitFor(Exchange::ClientResponseType::FILLED, 1) > 0 && session.last_.exec_qty_ == 50 &&
+                             session.last_.leaves_qty_ == 0);
+        std::cout << "Queue position:    " << (early_fill ? "filled with volume still ahead" : "no fill with 500 ahead after 300 traded")
+                  << ", " << (partial ? "50 filled after 550" : "no partial fill after 550") << ", "
+                  << (filled ? "rest filled after 650" : "rest not filled after 650") << std::endl;
+        ok &= (!early_fill && partial && filled);
+
+        // A trade through - an offer two ticks above the best ask fills outright once buyers lift through its price.
+        session.send(Exchange::ClientRequestType::NEW, 2, Common::Side::SELL, 150'010, 100);
+        ok &= (session.waitFor(Exchange::ClientResponseType::ACCEPTED, 2) > 0);
+        market.trade(150'015, 1'000);
+        market.asks = {{150'015, 200}, {150'020, 600}};
+        session.publish(market.packet());
+        const bool through = (session.waitFor(Exchange::ClientResponseType::FILLED, 2) > 0 && session.last_.exec_qty_ == 100 &&
+                              session.last_.price_ == 150'010);
+        std::cout << "Trade through:     " << (through ? "filled at the order's price" : "not filled") << std::endl;
+        ok &= through;
+
+        // Latency - ACCEPTED and CANCELED take the round trip drawn from the samples, plus the gateway's own loop.
+        std::vector<Nanos> new_latencies, cancel_latencies;
+        for (size_t i = 0; i < num_orders; ++i) {
+            const auto order_id = static_cast<Common::OrderId>(10 + i);
+            session.send(Exchange::ClientRequestType::NEW, order_id, Common::Side::BUY, 149'000, 10);
+            new_latencies.push_back(session.waitFor(Exchange::ClientResponseType::ACCEPTED, order_id));
+            session.send(Exchange::ClientRequestType::CANCEL, order_id, Common::Side::BUY, 149'000, 10);
+            cancel_latencies.push_back(session.waitFor(Exchange::ClientResponseType::CANCELED, order_id));
+        }
+        for (const auto *latencies : {&new_latencies, &cancel_latencies}) {
+            ok &= (std::count(latencies->begin(), latencies->end(), -1) == 0 &&
+                   *std::min_element(latencies->begin(), latencies->end()) >= ROUND_TRIP_NANOS);
+        }
+        std::cout << "NEW -> ACCEPTED:   p50 " << percentile(new_latencies, 0.5) / Common::NANOS_TO_MICROS << "us, p99 "
+                  << percentile(new_latencies, 0.99) / Common::NANOS_TO_MICROS << "us for a " << ROUND_TRIP_NANOS / Common::NANOS_TO_MICROS
+                  << "us round trip" << std::endl;
+        std::cout << "CANCEL -> CANCELED: p50 " << percentile(cancel_latencies, 0.5) / Common::NANOS_TO_MICROS << "us, p99 "
+                  << percentile(cancel_latencies, 0.99) / Common::NANOS_TO_MICROS << "us" << std::endl;
+
+        // Market data path - the engine only reads the queue, the publishing side costs the same with it running.
+        const auto updates_before = session.engine()->numMarketUpdates();
+        const auto with_engine = marketDataPath(session, num_packets);
+        session.engine()->stop();
+        const auto without_engine = marketDataPath(session, num_packets);
+        std::cout << "Market data path:  " << with_engine << "ns/packet with the engine tapping, " << without_engine
+                  << "ns/packet without, " << session.engine()->numMarketUpdates() - updates_before << " updates seen" << std::endl;
+        ok &= (session.engine()->numMarketUpdates() > updates_before);
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/lf_queue.h"
+#include "common/journal.h"
+#include "common/journal_reader.h"
+#include "common/journal_replayer.h"
+#include "exchange/market_data/market_update.h"
+#include "trading/adapters/zerodha/market_data/zerodha_websocket_client.h"
+#include "trading/adapters/zerodha/market_data/orderbook/zerodha_order_book.h"
+
+// Replay benchmark of the Zerodha market data path, no network or credentials needed. Kite binary frames recorded by
+// the journal (or synthetic ones) are replayed through ZerodhaWebSocketClient's on-message path, the decoded ticks
+// through one ZerodhaOrderBook per instrument and the generated MEMarketUpdates into a trade engine queue - what
+// ZerodhaMarketDataAdapter does per frame.
+// Reports the cost of each stage, end to end throughput, that two replays publish the same updates and how closely
+// the real time and N x speed pacing modes keep to the recorded timing.
+// Usage: zerodha_replay_benchmark [JOURNAL_DIR | NUM_FRAMES] [SPEED]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Common::Nanos;
+
+    constexpr size_t NUM_INSTRUMENTS = 32;
+    constexpr Nanos FRAME_SPACING = 500 * Common::NANOS_TO_MICROS;
+
+    auto putInt(char *data, int32_t value) {
+        const auto network = static_cast<int32_t>(htonl(static_cast<uint32_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    auto putShort(char *data, int16_t value) {
+        const auto network = static_cast<int16_t>(htons(static_cast<uint16_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    /// Journal of FULL mode frames, each with the ticks of a few instruments whose 5 level books walk around.
+    auto generateJournal(const std::string &dir, size_t num_frames) {
+        std::mt19937_64 rng(3);
+        std::uniform_int_distribution<size_t> instrument(0, NUM_INSTRUMENTS - 1);
+        std::uniform_int_distribution<int> num_packets(1, 4);
+        std::uniform_int_distribution<int> move(-1, 1);
+        std::uniform_int_distribution<int32_t> qty(1, 2000);
+
+        std::vector<int32_t> mids(NUM_INSTRUMENTS, 250'000);
+        Common::JournalWriter writer(dir, "zerodha");
+        const Nanos start_time = 1'700'000'000 * Common::NANOS_TO_SECS;
+        char frame[2 + 4 * (2 + 184)];
+
+        for (size_t i = 0; i < num_frames; ++i) {
+            const auto count = num_packets(rng);
+            putShort(frame, static_cast<int16_t>(count));
+            auto packet = frame + 2;
+            for (int p = 0; p < count; ++p, packet += 2 + 184) {
+                const auto index = instrument(rng);
+                mids[index] += 5 * move(rng);
+                std::memset(packet, 0, 2 + 184);
+                putShort(packet, 184);
+                const auto data = packet + 2;
+                putInt(data, static_cast<int32_t>(738'561 + index * 256));
+                putInt(data + 4, mids[index]);
+                putInt(data + 60, static_cast<int32_t>((start_time + static_cast<Nanos>(i) * FRAME_SPACING) / Common::NANOS_TO_SECS));
+                for (int level = 0; level < 5; ++level) {
+                    putInt(data + 64 + level * 12, qty(rng));
+                    putInt(data + 64 + level * 12 + 4, mids[index] - 5 * (level + 1));
+                    putShort(data + 64 + level * 12 + 8, 1);
+                    putInt(data + 124 + level * 12, qty(rng));
+                    putInt(data + 124 + level * 12 + 4, mids[index] + 5 * (level + 1));
+                    putShort(data + 124 + level * 12 + 8, 1);
+                }
+            }
+            writer.append(Common::JournalRecordType::ZERODHA_BINARY, 1, i + 1, start_time + static_cast<Nanos>(i) * FRAME_SPACING,
+                          frame, static_cast<uint32_t>(packet - frame));
+        }
+        writer.close();
+    }
+
+    auto isZerodhaFrame(const Common::JournalRecordHeader *record) {
+        return record->type_ == Common::JournalRecordType::ZERODHA_BINARY || record->type_ == Common::JournalRecordType::ZERODHA_TEXT;
+    }
+
+    auto percentile(std::vector<Nanos> samples, double fraction) {
+        if (samples.empty())
+            return Nanos{0};
+        const auto index = static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+        return samples[index];
+    }
+
+    /// Decode -> book -> MEMarketUpdate, the per frame work of ZerodhaMarketDataAdapter, with per stage timing.
+    class ReplayPipeline {
+    public:
+        explicit ReplayPipeline(Common::Logger *logger)
+            : ticks_(64 * 1024), market_updates_(Common::ME_MAX_MARKET_UPDATES), logger_(logger),
+              client_("", "", ticks_, logger) {
+        }
+
+        auto onFrame(const Common::JournalRecordHeader *record) {
+            const auto start = Common::getSystemNanos();
+            client_.replay_message(reinterpret_cast<const char *>(record + 1), record->length_,
+                                   record->type_ == Common::JournalRecordType::ZERODHA_BINARY);
+            const auto decoded = Common::getSystemNanos();
+
+            for (auto tick = ticks_.front(); tick; tick = ticks_.front()) {
+                ++num_ticks_;
+                auto &book = books_[tick->instrument_token];
+                if (!book)
+                    book = std::make_unique<ZerodhaOrderBook>(static_cast<Common::TickerId>(books_.size() - 1), logger_);
+
+                book->processMarketUpdate(*tick, tick->type == MarketUpdateType::FULL ? ticks_.frontDepth() : nullptr,
+                                          [this](const Exchange::MEMarketUpdate &event) {
+                    *market_updates_.getNextToWriteTo() = event;
+                    market_updates_.updateWriteIndex();
+                });
+                ticks_.pop();
+            }
+            const auto done = Common::getSystemNanos();
+
+            // The trade engine's side of the queue.
+            for (auto update = market_updates_.getNextToRead(); update; update = market_updates_.getNextToRead()) {
+                checksum_ = checksum_ * 31 + static_cast<size_t>(update->type_) * 7 + update->order_id_ + static_cast<size_t>(update->qty_);
+                ++num_updates_;
+                market_updates_.updateReadIndex();
+            }
+
+            decode_nanos_.push_back(decoded - start);
+            book_nanos_.push_back(done - decoded);
+            frame_nanos_.push_back(done - start);
+        }
+
+        ZerodhaTickQueue ticks_;
+        Exchange::MEMarketUpdateLFQueue market_updates_;
+        Common::Logger *logger_;
+        ZerodhaWebSocketClient client_;
+        std::map<int32_t, std::unique_ptr<ZerodhaOrderBook>> books_;
+
+        size_t num_ticks_ = 0;
+        size_t num_updates_ = 0;
+        size_t checksum_ = 0;
+        std::vector<Nanos> decode_nanos_, book_nanos_, frame_nanos_;
+    };
+}
+
+int main(int argc, char **argv) {
+    const bool recorded = (argc > 1 && std::filesystem::is_directory(argv[1]));
+    const size_t num_frames = (argc > 1 && !recorded ? std::strtoull(argv[1], nullptr, 10) : 5'000);
+    const double speed = (argc > 2 ? std::strtod(argv[2], nullptr) : 10.0);
+
+    auto dir = std::filesystem::temp_directory_path() / ("zerodha_replay_benchmark_" + std::to_string(getpid()));
+    if (recorded) {
+        dir = argv[1];
+    } else {
+        std::filesystem::create_directories(dir);
+        generateJournal(dir, num_frames);
+    }
+
+    Common::Logger logger("zerodha_replay_benchmark.log");
+    Common::JournalReader journal(dir);
+
+    // Two full speed replays, which have to publish the same updates.
+    ReplayPipeline first(&logger), second(&logger);
+    Common::JournalReplayer replayer;
+    const auto stats = replayer.replay(journal.chunk(), [&](const Common::JournalRecordHeader *record) {
+        if (isZerodhaFrame(record))
+            first.onFrame(record);
+    });
+    replayer.replay(journal.chunk(), [&](const Common::JournalRecordHeader *record) {
+        if (isZerodhaFrame(record))
+            second.onFrame(record);
+    });
+    const auto num_replayed = first.frame_nanos_.size();
+    const bool deterministic = (first.num_updates_ == second.num_updates_ && first.checksum_ == second.checksum_);
+
+    std::cout << "Frames:           " << num_replayed << " (" << first.num_ticks_ << " ticks, " << first.books_.size()
+              << " instruments) -> " << first.num_updates_ << " market updates" << std::endl;
+    std::cout << "Decode:           p50 " << percentile(first.decode_nanos_, 0.5) << "ns p99 " << percentile(first.decode_nanos_, 0.99)
+              << "ns per frame" << std::endl;
+    std::cout << "Book:             p50 " << percentile(first.book_nanos_, 0.5) << "ns p99 " << percentile(first.book_nanos_, 0.99)
+              << "ns per frame" << std::endl;
+    std::cout << "End to end:       p50 " << percentile(first.frame_nanos_, 0.5) << "ns p99 " << percentile(first.frame_nanos_, 0.99)
+              << "ns per frame, " << static_cast<size_t>(static_cast<double>(first.num_ticks_) * 1e9 / static_cast<double>(std::max<Nanos>(1, stats.wall_time_)))
+              << " ticks/s, " << static_cast<double>(stats.journal_time_) / static_cast<double>(std::max<Nanos>(1, stats.wall_time_))
+              << "x real time" << std::endl;
+    std::cout << "Deterministic:    " << (deterministic ? "yes" : "NO") << std::endl;
+
+    // Paced replays of the first second of the journal into a handler which only counts, so what is measured is how
+    // closely the replayer keeps to the recorded timing - never early, and late by no more than the max lag.
+    bool paced_ok = true;
+    const auto begin_time = (num_replayed ? journal.files().front()->recordAt(journal.begin().offset_)->time_ : 0);
+    const auto slice = journal.chunk(journal.begin(), journal.seek(begin_time + Common::NANOS_TO_SECS));
+    for (const auto &[pacing, factor] : {std::pair{Common::ReplayPacing::REAL_TIME, 1.0}, std::pair{Common::ReplayPacing::SPEED, speed}}) {
+        size_t num_frames_seen = 0;
+        Common::JournalReplayer paced(pacing, factor);
+        const auto paced_stats = paced.replay(slice, [&](const Common::JournalRecordHeader *record) {
+            num_frames_seen += isZerodhaFrame(record);
+        });
+        const auto expected = static_cast<double>(paced_stats.journal_time_) / factor;
+        paced_ok &= (static_cast<double>(paced_stats.wall_time_) >= expected && num_frames_seen == paced_stats.num_records_);
+        std::cout << Common::replayPacingToString(pacing) << " x" << factor << ": " << paced_stats.num_records_ << " frames, "
+                  << paced_stats.journal_time_ / Common::NANOS_TO_MICROS << "us recorded in " << paced_stats.wall_time_ / Common::NANOS_TO_MICROS
+                  << "us, max lag " << paced_stats.max_lag_ / Common::NANOS_TO_MICROS << "us" << std::endl;
+    }
+
+    if (!recorded)
+        std::filesystem::remove_all(dir);
+
+    const auto ok = deterministic && paced_ok && num_replayed > 0;
+    std::cout << "Result:           " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
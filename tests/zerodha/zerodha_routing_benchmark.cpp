@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "trading/adapters/zerodha/market_data/orderbook/zerodha_order_book.h"
+#include "trading/adapters/zerodha/market_data/zerodha_routing_table.h"
+
+// Benchmark of the token -> ticker routing of the Zerodha market data adapter. Checks the perfect hash finds every
+// routed token and nothing else for basket sizes up to three full Kite connections, compares a lookup with the
+// mutex + std::map it replaces, then keeps republishing the table while a reader thread routes ticks, checking the
+// reader always finds the permanent instruments and never sees a freed order book.
+// Usage: zerodha_routing_benchmark [NUM_LOOKUPS] [CHURN_MILLIS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Common::Nanos;
+
+    /// Unique tokens spread like Kite's - exchange segment in the low byte, instrument id above.
+    auto randomTokens(std::mt19937 &rng, size_t count) {
+        std::unordered_set<int32_t> seen;
+        std::vector<int32_t> tokens;
+        while (tokens.size() < count) {
+            const auto token = static_cast<int32_t>(((rng() % 100'000) << 8) | (1 + rng() % 9));
+            if (seen.insert(token).second)
+                tokens.push_back(token);
+        }
+        return tokens;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_lookups = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000);
+    const Nanos churn_nanos = (argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 2'000) * Common::NANOS_TO_MILLIS;
+
+    Common::Logger logger("zerodha_routing_benchmark.log");
+    std::mt19937 rng(11);
+    bool ok = true;
+
+    // Correctness - every routed token found with its own route, tokens not routed never.
+    for (const size_t count : {0, 1, 10, 100, 1'000, 3'000, 9'000}) {
+        const auto tokens = randomTokens(rng, count + 100'000);
+        std::vector<ZerodhaRoute> routes;
+        for (size_t i = 0; i < count; ++i)
+            routes.push_back({tokens[i], static_cast<Common::TickerId>(i), reinterpret_cast<ZerodhaOrderBook *>(i + 1), {}});
+
+        const auto start = Common::getSystemNanos();
+        const ZerodhaRoutingTable table(routes);
+        const auto build = Common::getSystemNanos() - start;
+
+        size_t wrong = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const auto route = table.find(tokens[i]);
+            wrong += (!route || route->ticker_id != i);
+        }
+        for (size_t i = count; i < tokens.size(); ++i)
+            wrong += (table.find(tokens[i]) != nullptr);
+
+        std::cout << "Routes " << count << ":" << std::string(11 - std::to_string(count).size(), ' ') << table.numSlots() << " slots, built in "
+                  << build / Common::NANOS_TO_MICROS << "us, " << wrong << " wrong lookups" << std::endl;
+        ok &= (wrong == 0 && table.size() == count);
+    }
+
+    // Lookup cost for a 3000 instrument basket, hits in a random order.
+    {
+        const auto tokens = randomTokens(rng, 3'000);
+        std::vector<ZerodhaRoute> routes;
+        std::map<int32_t, Common::TickerId> token_to_ticker;
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            routes.push_back({tokens[i], static_cast<Common::TickerId>(i), reinterpret_cast<ZerodhaOrderBook *>(i + 1), {}});
+            token_to_ticker[tokens[i]] = static_cast<Common::TickerId>(i);
+        }
+        const ZerodhaRoutingTable table(routes);
+        std::mutex token_mutex;
+        std::vector<int32_t> order(4096);
+        for (auto &token : order)
+            token = tokens[rng() % tokens.size()];
+
+        size_t checksum = 0;
+        auto start = Common::getSystemNanos();
+        for (size_t i = 0; i < num_lookups; ++i)
+            checksum += table.find(order[i & 4095])->ticker_id;
+        const auto table_nanos = Common::getSystemNanos() - start;
+
+        start = Common::getSystemNanos();
+        for (size_t i = 0; i < num_lookups; ++i) {
+            std::lock_guard<std::mutex> lock(token_mutex);
+            checksum -= token_to_ticker.find(order[i & 4095])->second;
+        }
+        const auto map_nanos = Common::getSystemNanos() - start;
+
+        std::cout << "Lookup:            " << static_cast<double>(table_nanos) / static_cast<double>(num_lookups) << "ns perfect hash, "
+                  << static_cast<double>(map_nanos) / static_cast<double>(num_lookups) << "ns mutex + std::map"
+                  << (checksum == 0 ? "" : " (results differ)") << std::endl;
+        ok &= (checksum == 0);
+    }
+
+    // Republishing while the reader routes - permanent instruments stay routed and retired books stay alive until
+    // the reader has moved on.
+    {
+        ZerodhaRouter router;
+        const auto tokens = randomTokens(rng, 200);
+        std::vector<std::unique_ptr<ZerodhaOrderBook>> books;
+        std::vector<ZerodhaRoute> permanent;
+        for (size_t i = 0; i < 100; ++i) {
+            books.push_back(std::make_unique<ZerodhaOrderBook>(static_cast<Common::TickerId>(i), &logger));
+            permanent.push_back({tokens[i], static_cast<Common::TickerId>(i), books.back().get(), {}});
+        }
+        router.publish(permanent);
+
+        std::atomic<bool> run = true;
+        size_t passes = 0, missing = 0, mismatched = 0;
+        std::thread reader([&]() {
+            while (run) {
+                const auto &table = router.beginPass();
+                for (size_t i = 0; i < tokens.size(); ++i) {
+                    const auto route = table.find(tokens[i]);
+                    missing += (i < 100 && !route);
+                    mismatched += (route && route->book->getTickerId() != route->ticker_id);
+                }
+                ++passes;
+            }
+        });
+
+        // The writer adds a few instruments with new books and drops them again, handing their books over
+        size_t publishes = 0;
+        std::vector<ZerodhaRoute> churn;
+        std::vector<std::unique_ptr<ZerodhaOrderBook>> churn_books;
+        const auto start = Common::getSystemNanos();
+        while (Common::getSystemNanos() - start < churn_nanos) {
+            const auto i = 100 + rng() % 100;
+            auto routes = permanent;
+            if (churn_books.size() < 10) {
+                churn_books.push_back(std::make_unique<ZerodhaOrderBook>(static_cast<Common::TickerId>(i), &logger));
+                churn.push_back({tokens[i], static_cast<Common::TickerId>(i), churn_books.back().get(), {}});
+                routes.insert(routes.end(), churn.begin(), churn.end());
+                router.publish(routes);
+            } else {
+                std::vector<std::unique_ptr<ZerodhaOrderBook>> retired;
+                retired.push_back(std::move(churn_books.front()));
+                churn_books.erase(churn_books.begin());
+                churn.erase(churn.begin());
+                routes.insert(routes.end(), churn.begin(), churn.end());
+                router.publish(routes, std::move(retired));
+            }
+            ++publishes;
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        run = false;
+        reader.join();
+
+        const auto pending = router.numRetired();
+        router.beginPass();
+        const auto after_pass = router.numRetired();
+        std::cout << "Republishing:      " << publishes << " tables during " << passes << " reader passes, " << missing
+                  << " permanent lookups missed, " << mismatched << " stale books seen, " << pending << " tables held back, "
+                  << after_pass << " after the reader moved on" << std::endl;
+        ok &= (missing == 0 && mismatched == 0 && passes > 0 && after_pass == 0);
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
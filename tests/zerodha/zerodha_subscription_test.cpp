@@ -0,0 +1,217 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "exchange/market_data/market_update.h"
+#include "trading/adapters/zerodha/market_data/zerodha_market_data_adapter.h"
+
+// Tests of subscribing and unsubscribing on a Zerodha market data adapter that is applying ticks. Two threads keep
+// subscribing and unsubscribing instruments of their own while a producer replays FULL ticks of every instrument, so
+// routes are published from both subscribing threads and from the market data path at once. Checks the instruments
+// never unsubscribed keep their books and ticking, and every published update is for a known ticker. Then checks an
+// adapter without a token manager unsubscribes the tokens mapped to a symbol, so a later tick does not rebuild its
+// book. No credentials or network needed, run under AddressSanitizer to also catch a freed order book being read.
+// Usage: zerodha_subscription_test [CHURN_MILLIS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Common::Nanos;
+
+    constexpr size_t NUM_PERMANENT = 4;
+    constexpr size_t NUM_CHURNED = 12;    // Split between the two subscribing threads
+    constexpr size_t NUM_INSTRUMENTS = NUM_PERMANENT + NUM_CHURNED;
+    constexpr size_t FULL_PACKET_SIZE = 184;
+
+    auto token(size_t i) {
+        return static_cast<int32_t>(738'561 + i * 256);
+    }
+
+    auto symbol(size_t i) {
+        return "NSE:SYM" + std::to_string(i);
+    }
+
+    auto putInt(char *data, int32_t value) {
+        const auto network = static_cast<int32_t>(htonl(static_cast<uint32_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    auto putShort(char *data, int16_t value) {
+        const auto network = static_cast<int16_t>(htons(static_cast<uint16_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    /// A Kite binary frame with a FULL packet of every instrument, the volume keeps the books from dropping it as stale.
+    auto makeFrame(int32_t volume) {
+        std::string frame(2 + NUM_INSTRUMENTS * (2 + FULL_PACKET_SIZE), '\0');
+        putShort(frame.data(), static_cast<int16_t>(NUM_INSTRUMENTS));
+        auto packet = frame.data() + 2;
+        for (size_t i = 0; i < NUM_INSTRUMENTS; ++i, packet += 2 + FULL_PACKET_SIZE) {
+            putShort(packet, static_cast<int16_t>(FULL_PACKET_SIZE));
+            const auto data = packet + 2;
+            const auto mid = 250'000 + 5 * (volume % 7);
+            putInt(data, token(i));
+            putInt(data + 4, mid);
+            putInt(data + 16, volume);
+            for (int level = 0; level < 5; ++level) {
+                putInt(data + 64 + level * 12, 100 + level);
+                putInt(data + 64 + level * 12 + 4, mid - 5 * (level + 1));
+                putShort(data + 64 + level * 12 + 8, 1);
+                putInt(data + 124 + level * 12, 100 + level);
+                putInt(data + 124 + level * 12 + 4, mid + 5 * (level + 1));
+                putShort(data + 124 + level * 12 + 8, 1);
+            }
+        }
+        return frame;
+    }
+
+    /// Replays frames through the adapter, the WebSocket thread of a live adapter.
+    struct Producer {
+        explicit Producer(ZerodhaMarketDataAdapter &adapter)
+            : thread_([this, &adapter]() {
+                  while (run_) {
+                      const auto frame = makeFrame(++volume_);
+                      adapter.replayFrame(frame.data(), frame.size(), true);
+                      std::this_thread::sleep_for(std::chrono::microseconds(20));
+                  }
+              }) {
+        }
+
+        ~Producer() {
+            run_ = false;
+            thread_.join();
+        }
+
+        std::atomic<bool> run_ = true;
+        int32_t volume_ = 0;
+        std::thread thread_;
+    };
+
+    /// Drains the trade engine queue, counting the updates of tickers the adapter was never given.
+    struct Consumer {
+        explicit Consumer(Exchange::MEMarketUpdateLFQueue &queue)
+            : thread_([this, &queue]() {
+                  while (run_ || queue.size()) {
+                      for (auto update = queue.getNextToRead(); update; update = queue.getNextToRead()) {
+                          unknown_ += (update->ticker_id_ >= NUM_INSTRUMENTS);
+                          ++updates_;
+                          queue.updateReadIndex();
+                      }
+                  }
+              }) {
+        }
+
+        auto stop() {
+            run_ = false;
+            thread_.join();
+        }
+
+        std::atomic<bool> run_ = true;
+        size_t updates_ = 0;
+        size_t unknown_ = 0;
+        std::thread thread_;
+    };
+}
+
+int main(int argc, char **argv) {
+    const Nanos churn_nanos = (argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 2'000) * Common::NANOS_TO_MILLIS;
+
+    Common::Logger logger("zerodha_subscription_test.log");
+    bool ok = true;
+
+    // Concurrent subscribing and unsubscribing while ticks are applied
+    {
+        // No configuration, so the adapter neither authenticates nor loads instruments
+        Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+        ZerodhaMarketDataAdapter adapter(&logger, &market_updates, "zerodha_subscription_test_no_config.json");
+        for (size_t i = 0; i < NUM_PERMANENT; ++i)
+            adapter.mapInstrumentToken(token(i), static_cast<Common::TickerId>(i));
+
+        MarketDataConfig config;
+        config.execution = MarketDataExecution::INLINE;
+        config.latency_log_interval_s = 0;
+        adapter.startReplay(config);
+
+        Consumer consumer(market_updates);
+        size_t churns = 0;
+        {
+            Producer producer(adapter);
+            std::atomic<size_t> num_churns = 0;
+            std::vector<std::thread> subscribers;
+            for (size_t thread = 0; thread < 2; ++thread) {
+                subscribers.emplace_back([&, thread]() {
+                    std::mt19937 rng(static_cast<unsigned>(thread + 1));
+                    const auto start = Common::getSystemNanos();
+                    while (Common::getSystemNanos() - start < churn_nanos) {
+                        const auto i = NUM_PERMANENT + thread * (NUM_CHURNED / 2) + rng() % (NUM_CHURNED / 2);
+                        adapter.subscribe({{symbol(i), static_cast<Common::TickerId>(i)}});
+                        adapter.mapInstrumentToken(token(i), static_cast<Common::TickerId>(i));
+                        std::this_thread::sleep_for(std::chrono::microseconds(rng() % 50));
+                        adapter.unsubscribe(std::vector<std::string>{symbol(i)});
+                        ++num_churns;
+                    }
+                });
+            }
+            for (auto &subscriber : subscribers)
+                subscriber.join();
+            churns = num_churns;
+        }
+        adapter.stop();
+        consumer.stop();
+
+        size_t missing = 0;
+        for (size_t i = 0; i < NUM_PERMANENT; ++i)
+            missing += (adapter.getOrderBook(static_cast<Common::TickerId>(i)) == nullptr);
+        const auto ticks = adapter.getTickLatencyStats().ticks;
+        std::cout << "Churn:             " << churns << " subscribe and unsubscribe rounds, " << ticks << " ticks applied, "
+                  << consumer.updates_ << " updates, " << consumer.unknown_ << " of unknown tickers, " << missing
+                  << " permanent books missing" << std::endl;
+        ok &= (churns > 0 && ticks > 0 && consumer.updates_ > 0 && consumer.unknown_ == 0 && missing == 0);
+    }
+
+    // Unsubscribing without a token manager, as when replaying - the token mapped to the symbol's ticker is found in
+    // the adapter's own map, and a later tick of it neither finds a route nor brings the book back
+    {
+        Exchange::MEMarketUpdateLFQueue market_updates(Common::ME_MAX_MARKET_UPDATES);
+        ZerodhaMarketDataAdapter adapter(&logger, &market_updates, "zerodha_subscription_test_no_config.json");
+        for (size_t i = 0; i < NUM_INSTRUMENTS; ++i) {
+            adapter.subscribe({{symbol(i), static_cast<Common::TickerId>(i)}});
+            adapter.mapInstrumentToken(token(i), static_cast<Common::TickerId>(i));
+        }
+        auto frame = makeFrame(1);
+        adapter.replayFrame(frame.data(), frame.size(), true);
+
+        std::vector<std::string> symbols;
+        for (size_t i = NUM_PERMANENT; i < NUM_INSTRUMENTS; ++i)
+            symbols.push_back(symbol(i));
+        const auto unsubscribed = adapter.unsubscribe(symbols);
+        frame = makeFrame(2);
+        adapter.replayFrame(frame.data(), frame.size(), true);
+
+        size_t still_mapped = 0, books = 0, kept = 0;
+        for (size_t i = 0; i < NUM_INSTRUMENTS; ++i) {
+            const auto ticker_id = static_cast<Common::TickerId>(i);
+            const bool mapped = (adapter.mapZerodhaInstrumentToInternal(token(i)) == ticker_id);
+            const bool book = (adapter.getOrderBook(ticker_id) != nullptr);
+            if (i < NUM_PERMANENT) {
+                kept += (mapped && book);
+            } else {
+                still_mapped += mapped;
+                books += book;
+            }
+        }
+        std::cout << "No token manager:  " << unsubscribed << " of " << NUM_CHURNED << " tokens unsubscribed, " << still_mapped
+                  << " still mapped, " << books << " books after a tick, " << kept << " of " << NUM_PERMANENT << " others kept" << std::endl;
+        ok &= (unsubscribed == NUM_CHURNED && still_mapped == 0 && books == 0 && kept == NUM_PERMANENT);
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
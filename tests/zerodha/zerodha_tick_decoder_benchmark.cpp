@@ -0,0 +1,201 @@
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/time_utils.h"
+#include "trading/adapters/zerodha/market_data/kite_tick_decoder.h"
+
+// Benchmark of the Kite binary tick decoder. Fuzzes the SSSE3 and AVX2 kernels against the scalar one with random
+// frames of LTP, QUOTE, FULL, index and unknown packets, some truncated, checks a known FULL packet decodes to its
+// fields, then reports packets/s of each kernel decoding frames of FULL and QUOTE packets.
+// Usage: zerodha_tick_decoder_benchmark [NUM_FUZZ_FRAMES] [NUM_FRAMES]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using Kernel = KiteTickDecoder::Kernel;
+
+    constexpr Kernel KERNELS[] = {Kernel::SCALAR, Kernel::SSSE3, Kernel::AVX2};
+
+    auto kernelName(Kernel kernel) -> std::string {
+        switch (kernel) {
+            case Kernel::SCALAR:
+                return "scalar";
+            case Kernel::SSSE3:
+                return "ssse3";
+            case Kernel::AVX2:
+                return "avx2";
+        }
+        return "?";
+    }
+
+    auto putInt(char *data, int32_t value) {
+        const auto network = static_cast<int32_t>(htonl(static_cast<uint32_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    auto putShort(char *data, int16_t value) {
+        const auto network = static_cast<int16_t>(htons(static_cast<uint16_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    /// Frame of random packets - random bytes behind a token matching the packet type, now and then cut short.
+    auto randomFrame(std::mt19937 &rng) {
+        std::vector<char> frame(2);
+        const auto num_packets = 1 + rng() % 8;
+        putShort(frame.data(), static_cast<int16_t>(num_packets));
+        for (size_t i = 0; i < num_packets; ++i) {
+            size_t length;
+            // Instrument tokens carry their segment in the low byte, 9 is the index segment.
+            int32_t token = static_cast<int32_t>(((1 + rng() % 40'000) << 8) | (1 + rng() % 8));
+            switch (rng() % 6) {
+                case 0:
+                    length = KiteTickDecoder::LTP_PACKET_LENGTH;
+                    break;
+                case 1:
+                    length = KiteTickDecoder::QUOTE_PACKET_LENGTH;
+                    break;
+                case 2:
+                case 3:
+                    length = KiteTickDecoder::FULL_PACKET_LENGTH;
+                    break;
+                case 4:
+                    length = (rng() % 2 ? KiteTickDecoder::INDEX_QUOTE_PACKET_LENGTH : KiteTickDecoder::INDEX_FULL_PACKET_LENGTH);
+                    token = static_cast<int32_t>(((1 + rng() % 40'000) << 8) | KiteTickDecoder::INDICES_SEGMENT);
+                    break;
+                default:
+                    length = 4 + rng() % 200;
+                    break;
+            }
+            const auto offset = frame.size();
+            frame.resize(offset + 2 + length);
+            putShort(frame.data() + offset, static_cast<int16_t>(length));
+            for (size_t byte = 0; byte < length; ++byte)
+                frame[offset + 2 + byte] = static_cast<char>(rng());
+            putInt(frame.data() + offset + 2, token);
+        }
+        if (rng() % 10 == 0)
+            frame.resize(rng() % frame.size());
+        return frame;
+    }
+
+    auto decodeAll(KiteTickDecoder &decoder, const std::vector<char> &frame) {
+        std::vector<KiteTick> ticks;
+        decoder.decodeFrame(frame.data(), frame.size(), [&](const KiteTick &tick) { ticks.push_back(tick); });
+        return ticks;
+    }
+
+    /// FULL packet with every field set to something recognisable.
+    auto knownFullPacket(char *packet) {
+        for (int32_t word = 0; word < 16; ++word)
+            putInt(packet + word * 4, 1'000'000 + word);
+        putInt(packet, 408'065);
+        for (int32_t level = 0; level < 10; ++level) {
+            char *entry = packet + 64 + level * 12;
+            putInt(entry, 100 + level);
+            putInt(entry + 4, 150'000 + level * 5);
+            putShort(entry + 8, static_cast<int16_t>(level + 1));
+            putShort(entry + 10, -1);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t num_fuzz_frames = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000);
+    const size_t num_frames = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200'000);
+
+    bool ok = true;
+
+    // Every kernel decodes exactly what the scalar one does, including which packets it skips.
+    {
+        std::mt19937 rng(7);
+        std::vector<KiteTickDecoder> decoders(std::size(KERNELS));
+        for (size_t k = 0; k < decoders.size(); ++k)
+            decoders[k].setKernel(KERNELS[k]);
+
+        size_t num_ticks = 0;
+        std::vector<size_t> mismatches(decoders.size());
+        for (size_t i = 0; i < num_fuzz_frames; ++i) {
+            const auto frame = randomFrame(rng);
+            const auto expected = decodeAll(decoders[0], frame);
+            num_ticks += expected.size();
+            for (size_t k = 1; k < decoders.size(); ++k) {
+                const auto ticks = decodeAll(decoders[k], frame);
+                mismatches[k] += (ticks.size() != expected.size() ||
+                                  std::memcmp(ticks.data(), expected.data(), ticks.size() * sizeof(KiteTick)) != 0);
+            }
+        }
+        for (size_t k = 1; k < decoders.size(); ++k) {
+            std::cout << "Fuzz " << kernelName(decoders[k].kernel()) << ":" << std::string(13 - kernelName(decoders[k].kernel()).size(), ' ')
+                      << num_fuzz_frames - mismatches[k] << " of " << num_fuzz_frames << " frames (" << num_ticks
+                      << " ticks) match the scalar decoder" << std::endl;
+            ok &= (mismatches[k] == 0);
+        }
+    }
+
+    // A known packet, the fields where they belong and the depth padding cleared.
+    {
+        char packet[KiteTickDecoder::FULL_PACKET_LENGTH];
+        knownFullPacket(packet);
+        bool known = true;
+        for (const auto kernel : KERNELS) {
+            KiteTickDecoder decoder;
+            decoder.setKernel(kernel);
+            KiteTick tick{};
+            known &= decoder.decodePacket(packet, sizeof(packet), &tick);
+            known &= (tick.type == MarketUpdateType::FULL && tick.instrument_token == 408'065 && tick.last_price == 1'000'001 &&
+                      tick.close_price == 1'000'010 && tick.exchange_timestamp == 1'000'015);
+            for (int32_t level = 0; level < 5; ++level) {
+                const auto &bid = tick.bids[static_cast<size_t>(level)];
+                const auto &ask = tick.asks[static_cast<size_t>(level)];
+                known &= (bid.quantity == 100 + level && bid.price == 150'000 + level * 5 && bid.orders == level + 1 && bid.padding == 0);
+                known &= (ask.quantity == 105 + level && ask.price == 150'025 + level * 5 && ask.orders == level + 6 && ask.padding == 0);
+            }
+        }
+        std::cout << "Known packet:      " << (known ? "decoded field for field" : "decoded wrong") << std::endl;
+        ok &= known;
+    }
+
+    // Throughput - frames of 6 FULL and 2 QUOTE packets, as a FULL mode subscription with a few quote mode ones sends.
+    {
+        std::vector<char> frame(2);
+        putShort(frame.data(), 8);
+        for (int32_t i = 0; i < 8; ++i) {
+            const auto length = (i < 6 ? KiteTickDecoder::FULL_PACKET_LENGTH : KiteTickDecoder::QUOTE_PACKET_LENGTH);
+            const auto offset = frame.size();
+            frame.resize(offset + 2 + length);
+            putShort(frame.data() + offset, static_cast<int16_t>(length));
+            char full[KiteTickDecoder::FULL_PACKET_LENGTH];
+            knownFullPacket(full);
+            putInt(full, 408'065 + i);
+            std::memcpy(frame.data() + offset + 2, full, length);
+        }
+
+        double scalar_rate = 0;
+        for (const auto kernel : KERNELS) {
+            KiteTickDecoder decoder;
+            decoder.setKernel(kernel);
+            int64_t checksum = 0;
+            size_t num_packets = 0;
+            const auto start = Common::getSystemNanos();
+            for (size_t i = 0; i < num_frames; ++i) {
+                num_packets += decoder.decodeFrame(frame.data(), frame.size(), [&](const KiteTick &tick) {
+                    checksum += tick.last_price + tick.asks[4].price;
+                });
+            }
+            const auto elapsed = Common::getSystemNanos() - start;
+            const auto rate = static_cast<double>(num_packets) * Common::NANOS_TO_SECS / static_cast<double>(elapsed);
+            if (decoder.kernel() == Kernel::SCALAR)
+                scalar_rate = rate;
+            std::cout << "Decode " << kernelName(decoder.kernel()) << ":" << std::string(11 - kernelName(decoder.kernel()).size(), ' ')
+                      << static_cast<size_t>(rate) << " packets/s, " << static_cast<double>(elapsed) / static_cast<double>(num_packets)
+                      << "ns/packet, " << rate / scalar_rate << "x scalar (checksum " << checksum << ")" << std::endl;
+        }
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
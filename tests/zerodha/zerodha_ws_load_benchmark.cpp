@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/lf_queue.h"
+#include "common/time_utils.h"
+#include "trading/adapters/sim/ws_exchange_simulator.h"
+#include "trading/adapters/zerodha/market_data/zerodha_websocket_client.h"
+
+// Load benchmark of the Zerodha WebSocket client against the local Kite simulator, no network or credentials needed.
+// Measures the highest frame rate the client keeps up with (rates doubling until its backlog no longer drains), its
+// throughput when the feed saturates it, what a dropped connection costs until ticks flow again, how lost frames and
+// feed stalls look from the client, and how long a client falling behind lasts before the venue drops it.
+// Usage: zerodha_ws_load_benchmark [STEP_MILLIS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using namespace Adapter::Sim;
+    using Common::Nanos;
+
+    constexpr size_t NUM_INSTRUMENTS = 32;
+    constexpr size_t PACKETS_PER_FRAME = 4;
+    constexpr Nanos QUIET_NANOS = 200 * Common::NANOS_TO_MILLIS;
+    constexpr Nanos TIMEOUT_NANOS = 10 * Common::NANOS_TO_SECS;
+
+    auto tokens() {
+        std::vector<int32_t> tokens;
+        for (size_t i = 0; i < NUM_INSTRUMENTS; ++i)
+            tokens.push_back(static_cast<int32_t>(738'561 + i * 256));
+        return tokens;
+    }
+
+    auto simConfig(size_t messages_per_second) {
+        WsExchangeSimulatorConfig config;
+        config.protocol = SimProtocol::KITE;
+        config.messages_per_second = messages_per_second;
+        config.instruments_per_message = PACKETS_PER_FRAME;
+        for (const auto token : tokens())
+            config.instruments.push_back({static_cast<Common::TickerId>(config.instruments.size()), token, "", 250'000});
+        return config;
+    }
+
+    auto secondsSince(Nanos start) {
+        return static_cast<double>(Common::getSystemNanos() - start) / Common::NANOS_TO_SECS;
+    }
+
+    auto idle() {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    /// A client of the simulator and the ticks it has published so far.
+    class Feed {
+    public:
+        Feed(uint16_t port, Common::Logger *logger) : ticks_(256 * 1024), client_("sim", "sim", ticks_, logger) {
+            client_.set_endpoint("127.0.0.1", std::to_string(port), false);
+        }
+
+        /// Connect and subscribe, the time until the first tick arrived, -1 on timeout.
+        auto connect() -> Nanos {
+            const auto start = Common::getSystemNanos();
+            client_.connect();
+            while (!client_.is_connected() && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+                idle();
+            if (!client_.is_connected() || !client_.subscribe(tokens()))
+                return -1;
+            while (!drain() && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+                idle();
+            return num_ticks_ ? Common::getSystemNanos() - start : -1;
+        }
+
+        /// Ticks published since the last call, and the longest time between two of them.
+        auto drain() -> size_t {
+            size_t count = 0;
+            for (auto tick = ticks_.front(); tick; tick = ticks_.front()) {
+                ++count;
+                ticks_.pop();
+            }
+            const auto now = Common::getSystemNanos();
+            if (count) {
+                if (last_tick_)
+                    max_silence_ = std::max(max_silence_, now - last_tick_);
+                last_tick_ = now;
+            }
+            num_ticks_ += count;
+            return count;
+        }
+
+        /// Drain until no tick arrived for QUIET_NANOS, the time it took to go quiet.
+        auto drainUntilQuiet() -> Nanos {
+            const auto start = Common::getSystemNanos();
+            auto last = start;
+            while (Common::getSystemNanos() - last < QUIET_NANOS) {
+                if (drain())
+                    last = Common::getSystemNanos();
+                idle();
+            }
+            return last - start;
+        }
+
+        auto runFor(Nanos nanos) {
+            const auto start = Common::getSystemNanos();
+            while (Common::getSystemNanos() - start < nanos) {
+                drain();
+                idle();
+            }
+        }
+
+        ZerodhaTickQueue ticks_;
+        ZerodhaWebSocketClient client_;
+        size_t num_ticks_ = 0;
+        Nanos last_tick_ = 0;
+        Nanos max_silence_ = 0;
+    };
+}
+
+int main(int argc, char **argv) {
+    const Nanos step = (argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 1'000) * Common::NANOS_TO_MILLIS;
+
+    Common::Logger client_logger("zerodha_ws_load_benchmark.log");
+    Common::Logger sim_logger("zerodha_ws_simulator.log");
+    bool ok = true;
+
+    // Saturation - the simulator keeps a few frames queued, the client drains them as fast as it can.
+    double saturated_frames = 0;
+    {
+        WsExchangeSimulator sim(simConfig(0), &sim_logger);
+        sim.start();
+        Feed feed(sim.port(), &client_logger);
+        const auto first_tick = feed.connect();
+        ok &= (first_tick > 0);
+
+        const auto start = Common::getSystemNanos();
+        const auto ticks = feed.num_ticks_;
+        feed.runFor(2 * step);
+        const auto ticks_per_second = static_cast<double>(feed.num_ticks_ - ticks) / secondsSince(start);
+        saturated_frames = ticks_per_second / PACKETS_PER_FRAME;
+        std::cout << "Connect:          " << first_tick / Common::NANOS_TO_MICROS << "us to the first tick" << std::endl;
+        std::cout << "Saturated:        " << static_cast<size_t>(ticks_per_second) << " ticks/s (~" << static_cast<size_t>(saturated_frames)
+                  << " frames/s)" << std::endl;
+        ok &= (feed.num_ticks_ > ticks);
+    }
+
+    // Rates doubling until the client's backlog takes more than a tenth of the step to drain.
+    {
+        WsExchangeSimulator sim(simConfig(1), &sim_logger);
+        sim.start();
+        Feed feed(sim.port(), &client_logger);
+        ok &= (feed.connect() > 0);
+        feed.drainUntilQuiet();
+
+        size_t sustained = 0;
+        for (size_t rate = 25; rate <= 102'400; rate *= 2) {
+            const auto generated = sim.stats().messages_generated;
+            sim.set_messages_per_second(rate);
+            feed.runFor(step);
+            sim.set_messages_per_second(1);
+            const auto lag = feed.drainUntilQuiet();
+            const auto frames = sim.stats().messages_generated - generated;
+            const bool kept_up = (lag < step / 10);
+            const auto label = "Rate " + std::to_string(rate) + "/s:";
+            std::cout << label << std::string(label.size() < 18 ? 18 - label.size() : 1, ' ') << frames << " frames, backlog drained in "
+                      << lag / Common::NANOS_TO_MILLIS << "ms" << (kept_up ? "" : " - falling behind") << std::endl;
+            if (!kept_up)
+                break;
+            sustained = rate;
+        }
+        std::cout << "Sustained:        " << sustained << " frames/s (" << sustained * PACKETS_PER_FRAME << " ticks/s)" << std::endl;
+    }
+
+    // A dropped connection - whether the client comes back by itself, otherwise what a reconnect by its owner costs.
+    {
+        auto config = simConfig(200);
+        config.disconnect_every = 100;
+        WsExchangeSimulator sim(config, &sim_logger);
+        sim.start();
+        Feed feed(sim.port(), &client_logger);
+        ok &= (feed.connect() > 0);
+
+        while (!sim.stats().disconnects && feed.client_.is_connected())
+            feed.runFor(Common::NANOS_TO_MILLIS);
+        const auto dropped = Common::getSystemNanos();
+        while (feed.client_.is_connected() && Common::getSystemNanos() - dropped < TIMEOUT_NANOS)
+            idle();
+        const auto detected = Common::getSystemNanos() - dropped;
+
+        // The client's own reconnect, if it has one, gets a few seconds.
+        const auto sessions = sim.stats().sessions;
+        feed.runFor(3 * Common::NANOS_TO_SECS);
+        const bool reconnected = (sim.stats().sessions > sessions && feed.client_.is_connected());
+        std::cout << "Dropped:          detected in " << detected / Common::NANOS_TO_MICROS << "us, "
+                  << (reconnected ? "client reconnected by itself" : "client did not reconnect by itself") << std::endl;
+
+        if (!reconnected) {
+            feed.client_.disconnect();
+            const auto ticks = feed.num_ticks_;
+            feed.num_ticks_ = 0;
+            const auto first_tick = feed.connect();
+            feed.num_ticks_ += ticks;
+            ok &= (first_tick > 0);
+            std::cout << "Reconnect:        " << first_tick / Common::NANOS_TO_MICROS << "us to the first tick, "
+                      << sim.stats().max_reconnect_time / Common::NANOS_TO_MICROS << "us from the drop to the resubscribe" << std::endl;
+        }
+    }
+
+    // Lost frames and stalls - Kite frames carry no sequence numbers, so the client can only see silences.
+    {
+        auto config = simConfig(50);
+        config.gap_every = 20;
+        config.stall_every = 60;
+        config.stall_duration = std::chrono::milliseconds(500);
+        WsExchangeSimulator sim(config, &sim_logger);
+        sim.start();
+        Feed feed(sim.port(), &client_logger);
+        ok &= (feed.connect() > 0);
+        feed.max_silence_ = 0;
+        feed.runFor(3 * step);
+        feed.drainUntilQuiet();
+
+        const auto stats = sim.stats();
+        std::cout << "Gaps, stalls:     " << stats.gaps << " frames lost, " << stats.stalls << " stalls of 500ms, longest silence at the client "
+                  << feed.max_silence_ / Common::NANOS_TO_MILLIS << "ms" << std::endl;
+        ok &= (!stats.stalls || feed.max_silence_ >= 400 * Common::NANOS_TO_MILLIS);
+    }
+
+    // A client falling behind - the feed at several times what it sustains until its backlog gets it dropped.
+    {
+        auto config = simConfig(std::max<size_t>(1'000, static_cast<size_t>(4 * saturated_frames)));
+        config.max_backlog = 200;
+        WsExchangeSimulator sim(config, &sim_logger);
+        sim.start();
+        Feed feed(sim.port(), &client_logger);
+        ok &= (feed.connect() > 0);
+        const auto start = Common::getSystemNanos();
+        while (!sim.stats().slow_consumer_drops && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+            feed.runFor(Common::NANOS_TO_MILLIS);
+        const auto stats = sim.stats();
+        std::cout << "Slow consumer:    dropped after " << (Common::getSystemNanos() - start) / Common::NANOS_TO_MILLIS << "ms at "
+                  << config.messages_per_second << " frames/s, backlog " << stats.max_backlog << std::endl;
+        ok &= (stats.slow_consumer_drops > 0);
+    }
+
+    std::cout << "Result:           " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,211 @@
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "trading/adapters/sim/ws_exchange_simulator.h"
+#include "trading/adapters/zerodha/market_data/kite_tick_decoder.h"
+#include "trading/adapters/zerodha/market_data/zerodha_websocket_pool.h"
+
+// Benchmark of Kite subscriptions sharded over several WebSocket connections. Against the local Kite simulator it
+// reports the saturated tick rate with 1 and 3 connections and checks every instrument streams on the connection it
+// was assigned to and no other, and that neither the interval the connections came up in nor a saturated feed over
+// them is rebalanced. Offline, it replays a feed with a few hot instruments through the connections and
+// checks the rebalancer moves them until the connections see a similar tick rate, then leaves a balanced feed alone.
+// Usage: zerodha_ws_shard_benchmark [STEP_MILLIS]
+
+namespace {
+    using namespace Adapter::Zerodha;
+    using namespace Adapter::Sim;
+    using Common::Nanos;
+
+    constexpr size_t NUM_INSTRUMENTS = 96;
+    constexpr size_t PACKETS_PER_FRAME = 8;
+    constexpr Nanos TIMEOUT_NANOS = 10 * Common::NANOS_TO_SECS;
+
+    auto tokens(size_t count) {
+        std::vector<int32_t> tokens;
+        for (size_t i = 0; i < count; ++i)
+            tokens.push_back(static_cast<int32_t>(738'561 + i * 256));
+        return tokens;
+    }
+
+    auto simConfig() {
+        WsExchangeSimulatorConfig config;
+        config.protocol = SimProtocol::KITE;
+        config.messages_per_second = 0;
+        config.instruments_per_message = PACKETS_PER_FRAME;
+        for (const auto token : tokens(NUM_INSTRUMENTS))
+            config.instruments.push_back({static_cast<Common::TickerId>(config.instruments.size()), token, "", 250'000});
+        return config;
+    }
+
+    auto putInt(char *data, int32_t value) {
+        const auto network = static_cast<int32_t>(htonl(static_cast<uint32_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    auto putShort(char *data, int16_t value) {
+        const auto network = static_cast<int16_t>(htons(static_cast<uint16_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    /// Frame of one LTP packet per token.
+    auto ltpFrame(const std::vector<int32_t> &tokens) {
+        std::vector<char> frame(2);
+        putShort(frame.data(), static_cast<int16_t>(tokens.size()));
+        for (const auto token : tokens) {
+            const auto offset = frame.size();
+            frame.resize(offset + 2 + KiteTickDecoder::LTP_PACKET_LENGTH);
+            putShort(frame.data() + offset, static_cast<int16_t>(KiteTickDecoder::LTP_PACKET_LENGTH));
+            putInt(frame.data() + offset + 2, token);
+            putInt(frame.data() + offset + 6, 250'000);
+        }
+        return frame;
+    }
+
+    /// Ticks drained from every connection, per connection, counting those of tokens assigned to another one.
+    auto drain(ZerodhaWebSocketPool &pool, std::vector<size_t> &ticks, size_t &misrouted, std::set<int32_t> &seen) {
+        size_t count = 0;
+        for (size_t i = 0; i < pool.num_connections(); ++i) {
+            auto &queue = pool.queue(i);
+            for (auto tick = queue.front(); tick; tick = queue.front()) {
+                misrouted += (pool.connection_of(tick->instrument_token) != i);
+                seen.insert(tick->instrument_token);
+                ++ticks[i];
+                ++count;
+                queue.pop();
+            }
+        }
+        return count;
+    }
+
+    /// Replay ticks_per_token ticks of each token through the connection it is on, in frames of up to 32 packets.
+    auto replay(ZerodhaWebSocketPool &pool, const std::vector<int32_t> &tokens, const std::vector<size_t> &ticks_per_token,
+                std::vector<size_t> &ticks, size_t &misrouted) {
+        std::set<int32_t> seen;
+        for (size_t round = 0; round < *std::max_element(ticks_per_token.begin(), ticks_per_token.end()); ++round) {
+            std::vector<std::vector<int32_t>> packets(pool.num_connections());
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                if (round < ticks_per_token[i])
+                    packets[pool.connection_of(tokens[i])].push_back(tokens[i]);
+            }
+            for (size_t i = 0; i < pool.num_connections(); ++i) {
+                for (size_t offset = 0; offset < packets[i].size(); offset += 32) {
+                    const std::vector<int32_t> batch(packets[i].begin() + static_cast<std::ptrdiff_t>(offset),
+                                                     packets[i].begin() + static_cast<std::ptrdiff_t>(std::min(offset + 32, packets[i].size())));
+                    const auto frame = ltpFrame(batch);
+                    pool.client(i).replay_message(frame.data(), frame.size(), true);
+                }
+            }
+            drain(pool, ticks, misrouted, seen);
+        }
+    }
+
+    auto loads(const std::vector<size_t> &ticks) {
+        std::string loads;
+        for (const auto count : ticks) {
+            if (!loads.empty())
+                loads += '/';
+            loads += std::to_string(count);
+        }
+        return loads;
+    }
+
+    auto imbalance(const std::vector<size_t> &ticks) {
+        const auto [quietest, busiest] = std::minmax_element(ticks.begin(), ticks.end());
+        return static_cast<double>(*busiest) / static_cast<double>(std::max<size_t>(*quietest, 1));
+    }
+}
+
+int main(int argc, char **argv) {
+    const Nanos step = (argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 2'000) * Common::NANOS_TO_MILLIS;
+
+    Common::Logger client_logger("zerodha_ws_shard_benchmark.log");
+    Common::Logger sim_logger("zerodha_ws_simulator.log");
+    bool ok = true;
+
+    // Saturation - each connection only streams the instruments assigned to it, and streams every one of them.
+    for (const size_t num_connections : {1, 3}) {
+        WsExchangeSimulator sim(simConfig(), &sim_logger);
+        sim.start();
+        ZerodhaWebSocketPool pool("sim", "sim", num_connections, 256 * 1024, &client_logger);
+        pool.set_endpoint("127.0.0.1", std::to_string(sim.port()), false);
+        pool.set_rebalance_interval(std::chrono::milliseconds(0));
+
+        auto start = Common::getSystemNanos();
+        pool.connect();
+        while (!pool.is_connected() && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        ok &= pool.is_connected() && pool.subscribe(tokens(NUM_INSTRUMENTS));
+
+        std::vector<size_t> ticks(num_connections, 0);
+        size_t misrouted = 0;
+        std::set<int32_t> seen;
+        while (seen.size() < NUM_INSTRUMENTS && Common::getSystemNanos() - start < TIMEOUT_NANOS)
+            drain(pool, ticks, misrouted, seen);
+
+        // The interval the connections came up in is never compared, some streamed alone until the others subscribed
+        const auto moved_connecting = pool.rebalance();
+        std::fill(ticks.begin(), ticks.end(), 0);
+        start = Common::getSystemNanos();
+        size_t total = 0;
+        while (Common::getSystemNanos() - start < step)
+            total += drain(pool, ticks, misrouted, seen);
+        const auto ticks_per_second = static_cast<double>(total) * Common::NANOS_TO_SECS / static_cast<double>(Common::getSystemNanos() - start);
+
+        std::vector<size_t> assigned;
+        for (size_t i = 0; i < num_connections; ++i)
+            assigned.push_back(pool.num_tokens(i));
+        const auto moved = pool.rebalance();
+        pool.disconnect();
+        sim.stop();
+
+        std::cout << "Connections " << num_connections << ":     " << static_cast<size_t>(ticks_per_second) << " ticks/s, instruments "
+                  << loads(assigned) << ", ticks " << loads(ticks) << ", " << seen.size() << " instruments seen, " << misrouted
+                  << " misrouted, " << moved_connecting << "/" << moved << " moved" << std::endl;
+        ok &= (total > 0 && seen.size() == NUM_INSTRUMENTS && misrouted == 0 && moved_connecting == 0 && moved == 0 &&
+               *std::min_element(assigned.begin(), assigned.end()) == NUM_INSTRUMENTS / num_connections);
+    }
+    if (std::thread::hardware_concurrency() <= 3)
+        std::cout << "Throughput:        not compared, the connections share " << std::thread::hardware_concurrency() << " core(s)" << std::endl;
+
+    // Rebalancing - the instruments of the first connection tick a hundred times as often as the others.
+    {
+        ZerodhaWebSocketPool pool("sim", "sim", 3, 64 * 1024, &client_logger);
+        pool.set_rebalance_interval(std::chrono::milliseconds(0));
+        const auto instruments = tokens(30);
+        pool.subscribe(instruments);
+
+        std::vector<size_t> ticks_per_token(instruments.size());
+        for (size_t i = 0; i < instruments.size(); ++i)
+            ticks_per_token[i] = (pool.connection_of(instruments[i]) == 0 ? 1'000 : 10);
+
+        std::vector<size_t> before(3, 0), after(3, 0), balanced(3, 0);
+        size_t misrouted = 0;
+        replay(pool, instruments, ticks_per_token, before, misrouted);
+        const auto moved = pool.rebalance();
+        replay(pool, instruments, ticks_per_token, after, misrouted);
+        const auto moved_again = pool.rebalance();
+        replay(pool, instruments, ticks_per_token, balanced, misrouted);
+
+        size_t assigned = 0;
+        for (size_t i = 0; i < 3; ++i)
+            assigned += pool.num_tokens(i);
+
+        std::cout << "Rebalancing:       ticks " << loads(before) << " -> " << moved << " moved -> " << loads(after) << " -> "
+                  << moved_again << " moved, " << misrouted << " misrouted" << std::endl;
+        ok &= (moved > 0 && imbalance(after) < 1.5 && moved_again == 0 && balanced == after && misrouted == 0 &&
+               assigned == instruments.size());
+    }
+
+    std::cout << "Result:            " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
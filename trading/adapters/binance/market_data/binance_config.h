@@ -10,16 +10,36 @@ struct BinanceConfig {
     std::string api_secret;
     bool use_testnet = false;
     
+    // Endpoint overrides, e.g. a local simulator - empty keeps the venue's hosts and ports
+    std::string ws_host_override;
+    std::string ws_port_override;
+    std::string rest_host_override;
+    std::string rest_port_override;
+    
+    // Turn off to accept a simulator's self-signed certificate
+    bool verify_peer = true;
+    
     // API endpoints
     std::string rest_base_url() const {
-        return use_testnet ? "https://testnet.binance.vision" : "https://api.binance.com";
+        return "https://" + rest_host() + (rest_port_override.empty() ? "" : ":" + rest_port_override);
+    }
+    
+    std::string rest_host() const {
+        if (!rest_host_override.empty()) return rest_host_override;
+        return use_testnet ? "testnet.binance.vision" : "api.binance.com";
+    }
+    
+    std::string rest_port() const {
+        return rest_port_override.empty() ? "443" : rest_port_override;
     }
     
     std::string ws_host() const {
+        if (!ws_host_override.empty()) return ws_host_override;
         return use_testnet ? "stream.testnet.binance.vision" : "stream.binance.com";
     }
     
     std::string ws_port() const {
+        if (!ws_port_override.empty()) return ws_port_override;
         return use_testnet ? "443" : "9443";
     }
     
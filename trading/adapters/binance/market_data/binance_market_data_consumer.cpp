@@ -107,6 +107,10 @@ void OrderBook::initializeWithSnapshot(const Json::Value& snapshot) {
         Common::Price price = stringToPrice(bid[0].asString());
         Common::Qty qty = stringToQty(bid[1].asString());
 
+        // A quantity a Qty cannot hold is skipped, the consumer logs it
+        if (qty == Common::Qty_INVALID) {
+            continue;
+        }
         if (qty > 0) {
             bids_[price] = qty;
         }
@@ -117,6 +121,10 @@ void OrderBook::initializeWithSnapshot(const Json::Value& snapshot) {
         Common::Price price = stringToPrice(ask[0].asString());
         Common::Qty qty = stringToQty(ask[1].asString());
 
+        // A quantity a Qty cannot hold is skipped, the consumer logs it
+        if (qty == Common::Qty_INVALID) {
+            continue;
+        }
         if (qty > 0) {
             asks_[price] = qty;
         }
@@ -167,10 +175,14 @@ bool OrderBook::applyUpdate(const Json::Value& depthUpdate) {
         Common::Price price = stringToPrice(bid[0].asString());
         Common::Qty qty = stringToQty(bid[1].asString());
 
-        if (qty > 0) {
-            bids_[price] = qty;
-        } else {
+        // A quantity a Qty cannot hold leaves the level as it was, the consumer logs it
+        if (qty == Common::Qty_INVALID) {
+            continue;
+        }
+        if (qty == 0) {
             bids_.erase(price);
+        } else {
+            bids_[price] = qty;
         }
     }
 
@@ -179,10 +191,14 @@ bool OrderBook::applyUpdate(const Json::Value& depthUpdate) {
         Common::Price price = stringToPrice(ask[0].asString());
         Common::Qty qty = stringToQty(ask[1].asString());
 
-        if (qty > 0) {
-            asks_[price] = qty;
-        } else {
+        // A quantity a Qty cannot hold leaves the level as it was, the consumer logs it
+        if (qty == Common::Qty_INVALID) {
+            continue;
+        }
+        if (qty == 0) {
             asks_.erase(price);
+        } else {
+            asks_[price] = qty;
         }
     }
 
@@ -440,32 +456,37 @@ bool WebSocketConnection::is_open() const {
     return is_open_;
 }
 
+// Log file of a consumer, creating the log directory first since the logger opens the file on construction
+static std::string consumerLogFile(Common::ClientId client_id) {
+    const std::string log_dir = "/home/praveen/om/siriquantum/ida/logs/binance/";
+    std::filesystem::create_directories(log_dir);
+    return log_dir + "binance_md_consumer_" + std::to_string(client_id) + ".log";
+}
+
 // BinanceMarketDataConsumer implementation
 BinanceMarketDataConsumer::BinanceMarketDataConsumer(Common::ClientId client_id,
                                      Exchange::MEMarketUpdateLFQueue *market_updates,
                                      const std::vector<std::string>& symbols,
                                      const BinanceConfig& config)
     : client_id_(client_id),
-      logger_("/home/praveen/om/siriquantum/ida/logs/binance/binance_md_consumer_" + std::to_string(client_id) + ".log"),
+      logger_(consumerLogFile(client_id)),
       config_(config),
       incoming_md_updates_(market_updates),
       symbols_(symbols) {
-    
-    // Create log directory if it doesn't exist
-    std::filesystem::create_directories("/home/praveen/om/siriquantum/ida/logs/binance/");
 
     // Initialize ticker mapping and order books
     for (size_t i = 0; i < symbols_.size() && i < Common::ME_MAX_TICKERS; ++i) {
         symbol_to_ticker_id_[symbols_[i]] = i;
         // Create order book entry for each symbol (using emplace which doesn't require copy/move assignment)
         order_books_.emplace(symbols_[i], OrderBook());
+        scales_.emplace(symbols_[i], Common::InstrumentScale{2, 2});
         // Initialize buffer for depth updates
         buffered_updates_[symbols_[i]] = std::vector<Json::Value>();
     }
 
     // Set up SSL context
     ctx_.set_default_verify_paths();
-    ctx_.set_verify_mode(ssl::verify_peer);
+    ctx_.set_verify_mode(config_.verify_peer ? ssl::verify_peer : ssl::verify_none);
 }
 
 BinanceMarketDataConsumer::~BinanceMarketDataConsumer() {
@@ -474,6 +495,7 @@ BinanceMarketDataConsumer::~BinanceMarketDataConsumer() {
 
 void BinanceMarketDataConsumer::start() {
     run_ = true;
+    work_guard_.emplace(net::make_work_guard(ioc_));
 
     // Start IO context in a separate thread
     ioc_thread_ = std::thread([this]() {
@@ -502,6 +524,9 @@ void BinanceMarketDataConsumer::start() {
             logger_.log("%:% %() % Initializing streams for symbol %\n", __FILE__, __LINE__, __FUNCTION__,
                       Common::getCurrentTimeStr(&time_str_), symbol);
 
+            // Fixed-point scales need to be known before the first update is converted
+            getInstrumentScale(symbol);
+
             // First connect to depth stream to start buffering
             connectToDepthStream(symbol);
 
@@ -530,22 +555,23 @@ void BinanceMarketDataConsumer::start() {
 void BinanceMarketDataConsumer::stop() {
     run_ = false;
     
-    // Close all connections
-    for (auto& conn : connections_) {
-        if (conn && conn->is_open()) {
-            conn->close();
-        }
-    }
-    
-    connections_.clear();
-    
     // Stop IO context
+    work_guard_.reset();
     ioc_.stop();
     
     // Wait for thread to finish
     if (ioc_thread_.joinable()) {
         ioc_thread_.join();
     }
+    
+    // Close all connections, only once the IO thread no longer reads from them
+    for (auto& conn : connections_) {
+        if (conn && conn->is_open()) {
+            conn->close();
+        }
+    }
+    
+    connections_.clear();
 }
 
 void BinanceMarketDataConsumer::connectToDepthStream(const std::string& symbol) {
@@ -596,6 +622,58 @@ void BinanceMarketDataConsumer::connectToTradeStream(const std::string& symbol)
     }
 }
 
+void BinanceMarketDataConsumer::getInstrumentScale(const std::string& symbol) {
+    try {
+        net::io_context ioc;
+        HttpClient client(ioc, ctx_, config_.rest_host(), config_.rest_port());
+        std::string response_body = client.get("/api/v3/exchangeInfo", {{"symbol", symbol}});
+
+        // Journaled like a stream message so a replay starts from the same scales
+        journalMessage(response_body, symbol, "exchangeInfo");
+        applyInstrumentScale(symbol, response_body);
+    } catch (const std::exception& e) {
+        logger_.log("%:% %() % Error getting exchangeInfo for %, keeping default scales: %\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), symbol, e.what());
+    }
+}
+
+void BinanceMarketDataConsumer::applyInstrumentScale(const std::string& symbol, const std::string& response_body) {
+    try {
+        Json::CharReaderBuilder builder;
+        Json::Value info;
+        std::string errors;
+        std::istringstream iss(response_body);
+        if (!Json::parseFromStream(builder, iss, &info, &errors) || info["symbols"].empty()) {
+            logger_.log("%:% %() % Error parsing exchangeInfo for %: %\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), symbol, errors);
+            return;
+        }
+
+        // Keep the exchange's decimal strings, e.g. "0.01000000", so the scales are exact
+        std::string tick_size, step_size;
+        for (const auto& filter : info["symbols"][0]["filters"]) {
+            if (filter["filterType"].asString() == "PRICE_FILTER") {
+                tick_size = filter["tickSize"].asString();
+            } else if (filter["filterType"].asString() == "LOT_SIZE") {
+                step_size = filter["stepSize"].asString();
+            }
+        }
+        if (tick_size.empty() || step_size.empty()) {
+            return;
+        }
+
+        const auto scale = Common::InstrumentScale::fromIncrements(std::string_view(tick_size), std::string_view(step_size));
+        scales_[symbol] = scale;
+        order_books_[symbol].setInstrumentScale(scale);
+
+        logger_.log("%:% %() % % %\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), symbol, scale.toString());
+    } catch (const std::exception& e) {
+        logger_.log("%:% %() % Error parsing exchangeInfo for %, keeping default scales: %\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), symbol, e.what());
+    }
+}
+
 void BinanceMarketDataConsumer::getOrderBookSnapshot(const std::string& symbol) {
     // Following Binance's documentation:
     // 1. Get a depth snapshot from REST API
@@ -618,14 +696,14 @@ void BinanceMarketDataConsumer::getOrderBookSnapshot(const std::string& symbol)
             std::string params = "?symbol=" + symbol + "&limit=1000"; // Get up to 1000 levels
 
             // Construct full URL
-            std::string host = config_.use_testnet ? "testnet.binance.vision" : "api.binance.com";
-            std::string port = "443";
+            std::string host = config_.rest_host();
+            std::string port = config_.rest_port();
 
             // Open TCP connection
             net::io_context ioc;
             ssl::context ctx(ssl::context::tlsv12_client);
             ctx.set_default_verify_paths();
-            ctx.set_verify_mode(ssl::verify_peer);
+            ctx.set_verify_mode(config_.verify_peer ? ssl::verify_peer : ssl::verify_none);
 
             tcp::resolver resolver(ioc);
             beast::ssl_stream<beast::tcp_stream> stream(ioc, ctx);
@@ -691,6 +769,7 @@ void BinanceMarketDataConsumer::getOrderBookSnapshot(const std::string& symbol)
             if (buffered_updates_[symbol].empty()) {
                 // No updates received yet, use this snapshot
                 lock.unlock();
+                journalMessage(response_body, symbol, "snapshot");
                 initializeOrderBook(symbol, snapshot);
                 return;
             } else {
@@ -700,6 +779,7 @@ void BinanceMarketDataConsumer::getOrderBookSnapshot(const std::string& symbol)
                 if (last_update_id >= first_update_u) {
                     // Snapshot is newer than or equal to first buffered update, use it
                     lock.unlock();
+                    journalMessage(response_body, symbol, "snapshot");
                     initializeOrderBook(symbol, snapshot);
                     return;
                 } else {
@@ -733,6 +813,7 @@ void BinanceMarketDataConsumer::initializeOrderBook(const std::string& symbol, c
         }
 
         Common::TickerId ticker_id = symbol_to_ticker_id_[symbol];
+        const auto& scale = scales_.at(symbol);
 
         // Get the last update ID from the snapshot
         uint64_t last_update_id = snapshot["lastUpdateId"].asUInt64();
@@ -746,9 +827,7 @@ void BinanceMarketDataConsumer::initializeOrderBook(const std::string& symbol, c
         clear_update.type_ = Exchange::MarketUpdateType::CLEAR;
         clear_update.ticker_id_ = ticker_id;
 
-        auto next_write = incoming_md_updates_->getNextToWriteTo();
-        *next_write = clear_update;
-        incoming_md_updates_->updateWriteIndex();
+        publishUpdate(clear_update);
 
         logger_.log("%:% %() % Sent CLEAR update for %\n", __FILE__, __LINE__, __FUNCTION__,
                   Common::getCurrentTimeStr(&time_str_), symbol);
@@ -756,8 +835,13 @@ void BinanceMarketDataConsumer::initializeOrderBook(const std::string& symbol, c
         // Process bids (buy side)
         int bid_count = 0;
         for (const auto& bid : snapshot["bids"]) {
-            Common::Price price = static_cast<Common::Price>(std::stod(bid[0].asString()) * 100.0);
-            Common::Qty qty = static_cast<Common::Qty>(std::stod(bid[1].asString()) * 100.0);
+            Common::Price price = scale.parsePrice(bid[0].asString());
+            Common::Qty qty = scale.parseQty(bid[1].asString());
+            if (qty == Common::Qty_INVALID) {
+                logger_.log("%:% %() % Skipping bid level % of % with a quantity out of range: %\n", __FILE__, __LINE__, __FUNCTION__,
+                          Common::getCurrentTimeStr(&time_str_), bid[0].asString(), symbol, bid[1].asString());
+                continue;
+            }
 
             if (qty > 0) {
                 // Add the price level to the local order book
@@ -773,9 +857,7 @@ void BinanceMarketDataConsumer::initializeOrderBook(const std::string& symbol, c
                 update.side_ = Common::Side::BUY;
                 update.priority_ = 1; // Top priority
 
-                auto next_write = incoming_md_updates_->getNextToWriteTo();
-                *next_write = update;
-                incoming_md_updates_->updateWriteIndex();
+                publishUpdate(update);
 
                 bid_count++;
             }
@@ -784,8 +866,13 @@ void BinanceMarketDataConsumer::initializeOrderBook(const std::string& symbol, c
         // Process asks (sell side)
         int ask_count = 0;
         for (const auto& ask : snapshot["asks"]) {
-            Common::Price price = static_cast<Common::Price>(std::stod(ask[0].asString()) * 100.0);
-            Common::Qty qty = static_cast<Common::Qty>(std::stod(ask[1].asString()) * 100.0);
+            Common::Price price = scale.parsePrice(ask[0].asString());
+            Common::Qty qty = scale.parseQty(ask[1].asString());
+            if (qty == Common::Qty_INVALID) {
+                logger_.log("%:% %() % Skipping ask level % of % with a quantity out of range: %\n", __FILE__, __LINE__, __FUNCTION__,
+                          Common::getCurrentTimeStr(&time_str_), ask[0].asString(), symbol, ask[1].asString());
+                continue;
+            }
 
             if (qty > 0) {
                 // Add the price level to the local order book
@@ -801,9 +888,7 @@ void BinanceMarketDataConsumer::initializeOrderBook(const std::string& symbol, c
                 update.side_ = Common::Side::SELL;
                 update.priority_ = 1; // Top priority
 
-                auto next_write = incoming_md_updates_->getNextToWriteTo();
-                *next_write = update;
-                incoming_md_updates_->updateWriteIndex();
+                publishUpdate(update);
 
                 ask_count++;
             }
@@ -904,7 +989,63 @@ void BinanceMarketDataConsumer::processBufferedUpdates(const std::string& symbol
     }
 }
 
+void BinanceMarketDataConsumer::publishUpdate(const Exchange::MEMarketUpdate& update) {
+    if (conflator_) {
+        conflator_->onMarketUpdate(update);
+        return;
+    }
+
+    auto next_write = incoming_md_updates_->getNextToWriteTo();
+    *next_write = update;
+    incoming_md_updates_->updateWriteIndex();
+}
+
+void BinanceMarketDataConsumer::journalMessage(const std::string& payload, const std::string& symbol, const std::string& stream_type) {
+    // Tagged with the stream it came from so replay() can hand it to the same handler
+    if (journal_) {
+        journal_->push(Common::JournalRecordType::BINANCE_JSON, Common::getCurrentNanos(),
+                       {symbol, "@", stream_type, "\n", payload});
+    }
+}
+
+void BinanceMarketDataConsumer::replay(const std::string& payload, const std::string& symbol, const std::string& stream_type) {
+    if (stream_type == "exchangeInfo") {
+        applyInstrumentScale(symbol, payload);
+    } else if (stream_type == "snapshot") {
+        Json::CharReaderBuilder builder;
+        Json::Value snapshot;
+        std::string errors;
+        std::istringstream iss(payload);
+        if (!Json::parseFromStream(builder, iss, &snapshot, &errors)) {
+            logger_.log("%:% %() % Error parsing snapshot JSON: %\n", __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_), errors);
+            return;
+        }
+
+        // Same sequence as start(): the snapshot, then whatever the depth stream buffered before it
+        initializeOrderBook(symbol, snapshot);
+        processBufferedUpdates(symbol);
+    } else {
+        onMessage(payload, symbol, stream_type);
+    }
+}
+
+auto BinanceMarketDataConsumer::replayJournalRecord(const char* data, size_t length) -> bool {
+    const std::string_view record(data, length);
+    const auto at = record.find('@');
+    const auto newline = record.find('\n');
+    if (at == std::string_view::npos || newline == std::string_view::npos || at > newline) {
+        return false;
+    }
+
+    replay(std::string(record.substr(newline + 1)), std::string(record.substr(0, at)),
+           std::string(record.substr(at + 1, newline - at - 1)));
+    return true;
+}
+
 void BinanceMarketDataConsumer::onMessage(const std::string& payload, const std::string& symbol, const std::string& stream_type) {
+    journalMessage(payload, symbol, stream_type);
+
     try {
         // Parse JSON message
         Json::CharReaderBuilder builder;
@@ -991,6 +1132,7 @@ void BinanceMarketDataConsumer::applyDepthUpdate(const std::string& symbol, cons
         }
 
         Common::TickerId ticker_id = symbol_to_ticker_id_[symbol];
+        const auto& scale = scales_.at(symbol);
 
         // Check the update IDs to ensure we're applying updates in sequence
         uint64_t first_update_id = data["U"].asUInt64();
@@ -1017,23 +1159,30 @@ void BinanceMarketDataConsumer::applyDepthUpdate(const std::string& symbol, cons
             // We need to get a new snapshot and restart
             order_book.reset();
 
-            // Clear buffered updates
-            std::lock_guard<std::mutex> lock(buffer_mutex_);
-            buffered_updates_[symbol].clear();
-
-            // Buffer the current update
-            buffered_updates_[symbol].push_back(data);
+            // Clear buffered updates and buffer the current one - unlocked again before the snapshot, which takes
+            // buffer_mutex_ itself
+            {
+                std::lock_guard<std::mutex> lock(buffer_mutex_);
+                buffered_updates_[symbol].clear();
+                buffered_updates_[symbol].push_back(data);
+            }
 
-            // Get a new snapshot
+            // Get a new snapshot and apply what was buffered on top of it
             getOrderBookSnapshot(symbol);
+            processBufferedUpdates(symbol);
             return;
         }
 
         // 3. Apply the update - process bids (buy side)
         int bid_count = 0;
         for (const auto& bid : data["b"]) {
-            Common::Price price = static_cast<Common::Price>(std::stod(bid[0].asString()) * 100.0);
-            Common::Qty qty = static_cast<Common::Qty>(std::stod(bid[1].asString()) * 100.0);
+            Common::Price price = scale.parsePrice(bid[0].asString());
+            Common::Qty qty = scale.parseQty(bid[1].asString());
+            if (qty == Common::Qty_INVALID) {
+                logger_.log("%:% %() % Skipping bid level % of % with a quantity out of range: %\n", __FILE__, __LINE__, __FUNCTION__,
+                          Common::getCurrentTimeStr(&time_str_), bid[0].asString(), symbol, bid[1].asString());
+                continue;
+            }
 
             Exchange::MEMarketUpdate update;
             if (qty > 0) {
@@ -1058,16 +1207,19 @@ void BinanceMarketDataConsumer::applyDepthUpdate(const std::string& symbol, cons
             }
 
             // Send update to trading engine
-            auto next_write = incoming_md_updates_->getNextToWriteTo();
-            *next_write = update;
-            incoming_md_updates_->updateWriteIndex();
+            publishUpdate(update);
         }
 
         // Process asks (sell side)
         int ask_count = 0;
         for (const auto& ask : data["a"]) {
-            Common::Price price = static_cast<Common::Price>(std::stod(ask[0].asString()) * 100.0);
-            Common::Qty qty = static_cast<Common::Qty>(std::stod(ask[1].asString()) * 100.0);
+            Common::Price price = scale.parsePrice(ask[0].asString());
+            Common::Qty qty = scale.parseQty(ask[1].asString());
+            if (qty == Common::Qty_INVALID) {
+                logger_.log("%:% %() % Skipping ask level % of % with a quantity out of range: %\n", __FILE__, __LINE__, __FUNCTION__,
+                          Common::getCurrentTimeStr(&time_str_), ask[0].asString(), symbol, ask[1].asString());
+                continue;
+            }
 
             Exchange::MEMarketUpdate update;
             if (qty > 0) {
@@ -1092,9 +1244,7 @@ void BinanceMarketDataConsumer::applyDepthUpdate(const std::string& symbol, cons
             }
 
             // Send update to trading engine
-            auto next_write = incoming_md_updates_->getNextToWriteTo();
-            *next_write = update;
-            incoming_md_updates_->updateWriteIndex();
+            publishUpdate(update);
         }
 
         // Update the local order book
@@ -1130,10 +1280,11 @@ void BinanceMarketDataConsumer::onTradeUpdate(const std::string& symbol, const J
         }
 
         Common::TickerId ticker_id = symbol_to_ticker_id_[symbol];
+        const auto& scale = scales_.at(symbol);
 
         // Extract trade information
-        Common::Price price = static_cast<Common::Price>(std::stod(data["p"].asString()) * 100.0);
-        Common::Qty qty = static_cast<Common::Qty>(std::stod(data["q"].asString()) * 100.0);
+        Common::Price price = scale.parsePrice(data["p"].asString());
+        Common::Qty qty = scale.parseQty(data["q"].asString());
         bool is_buyer_maker = data["m"].asBool(); // true if buyer is the maker (SELL trade)
 
         Common::Side side = is_buyer_maker ? Common::Side::SELL : Common::Side::BUY;
@@ -1148,9 +1299,7 @@ void BinanceMarketDataConsumer::onTradeUpdate(const std::string& symbol, const J
         trade_update.side_ = side;
 
         // Send update to trading engine
-        auto next_write = incoming_md_updates_->getNextToWriteTo();
-        *next_write = trade_update;
-        incoming_md_updates_->updateWriteIndex();
+        publishUpdate(trade_update);
 
         logger_.log("%:% %() % Processed trade for %: % % @ %\n",
                    __FILE__, __LINE__, __FUNCTION__,
@@ -1173,15 +1322,16 @@ void BinanceMarketDataConsumer::processBinanceBookUpdate(const Json::Value& data
     }
     
     Common::TickerId ticker_id = symbol_to_ticker_id_[symbol];
+    const auto& scale = scales_.at(symbol);
     
     // In bookTicker stream, the format is:
     // {"u":400900217,"s":"BNBUSDT","b":"240.40000000","B":"6.35796000","a":"240.50000000","A":"5.52504000"}
 
     // Extract bid/ask price and quantity
-    Common::Price bid_price = std::stod(data["b"].asString()) * 100; // Convert to internal price format (x100)
-    Common::Qty bid_qty = std::stod(data["B"].asString()) * 100;     // Convert to internal qty format (x100)
-    Common::Price ask_price = std::stod(data["a"].asString()) * 100;
-    Common::Qty ask_qty = std::stod(data["A"].asString()) * 100;
+    Common::Price bid_price = scale.parsePrice(data["b"].asString());
+    Common::Qty bid_qty = scale.parseQty(data["B"].asString());
+    Common::Price ask_price = scale.parsePrice(data["a"].asString());
+    Common::Qty ask_qty = scale.parseQty(data["A"].asString());
 
     // Sanity check - make sure bid < ask
     if (bid_price >= ask_price) {
@@ -1210,9 +1360,7 @@ void BinanceMarketDataConsumer::processBinanceBookUpdate(const Json::Value& data
             bid_update.priority_ = 1; // Top priority
 
             // Push update to queue
-            auto next_write = incoming_md_updates_->getNextToWriteTo();
-            *next_write = bid_update;
-            incoming_md_updates_->updateWriteIndex();
+            publishUpdate(bid_update);
 
             logger_.log("%:% %() % Sent ADD for BID: price=% qty=%\n",
                       __FILE__, __LINE__, __FUNCTION__,
@@ -1229,9 +1377,7 @@ void BinanceMarketDataConsumer::processBinanceBookUpdate(const Json::Value& data
             bid_update.side_ = Common::Side::BUY;
 
             // Push update to queue
-            auto next_write = incoming_md_updates_->getNextToWriteTo();
-            *next_write = bid_update;
-            incoming_md_updates_->updateWriteIndex();
+            publishUpdate(bid_update);
 
             logger_.log("%:% %() % Sent CANCEL for BID: price=%\n",
                       __FILE__, __LINE__, __FUNCTION__,
@@ -1255,9 +1401,7 @@ void BinanceMarketDataConsumer::processBinanceBookUpdate(const Json::Value& data
             ask_update.priority_ = 1; // Top priority
 
             // Push update to queue
-            auto next_write = incoming_md_updates_->getNextToWriteTo();
-            *next_write = ask_update;
-            incoming_md_updates_->updateWriteIndex();
+            publishUpdate(ask_update);
 
             logger_.log("%:% %() % Sent ADD for ASK: price=% qty=%\n",
                       __FILE__, __LINE__, __FUNCTION__,
@@ -1274,9 +1418,7 @@ void BinanceMarketDataConsumer::processBinanceBookUpdate(const Json::Value& data
             ask_update.side_ = Common::Side::SELL;
 
             // Push update to queue
-            auto next_write = incoming_md_updates_->getNextToWriteTo();
-            *next_write = ask_update;
-            incoming_md_updates_->updateWriteIndex();
+            publishUpdate(ask_update);
 
             logger_.log("%:% %() % Sent CANCEL for ASK: price=%\n",
                       __FILE__, __LINE__, __FUNCTION__,
@@ -1301,13 +1443,14 @@ void BinanceMarketDataConsumer::processBinanceTrade(const Json::Value& data, con
     }
     
     Common::TickerId ticker_id = symbol_to_ticker_id_[symbol];
+    const auto& scale = scales_.at(symbol);
     
     // In trade stream, the format is:
     // {"e":"trade","E":1678741852345,"s":"BNBUSDT","t":12345,"p":"240.50000000","q":"1.23400000","b":12345,"a":12345,"T":1678741852345,"m":true,"M":true}
     
     // Extract trade price, quantity and side
-    Common::Price price = std::stod(data["p"].asString()) * 100; // Convert to internal price format (x100)
-    Common::Qty qty = std::stod(data["q"].asString()) * 100;     // Convert to internal qty format (x100)
+    Common::Price price = scale.parsePrice(data["p"].asString());
+    Common::Qty qty = scale.parseQty(data["q"].asString());
     bool is_buyer_maker = data["m"].asBool();                    // true if buyer is maker (SELL trade)
     
     Common::Side side = is_buyer_maker ? Common::Side::SELL : Common::Side::BUY;
@@ -1322,9 +1465,7 @@ void BinanceMarketDataConsumer::processBinanceTrade(const Json::Value& data, con
     trade_update.qty_ = qty;
     
     // Push update to queue
-    auto next_write = incoming_md_updates_->getNextToWriteTo();
-    *next_write = trade_update;
-    incoming_md_updates_->updateWriteIndex();
+    publishUpdate(trade_update);
     
     logger_.log("%:% %() % Processed trade for %: % % @ %\n", 
                __FILE__, __LINE__, __FUNCTION__,
@@ -7,6 +7,7 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 #include <boost/beast/core.hpp>
 #include <boost/beast/ssl.hpp>
@@ -23,9 +24,12 @@
 #include "common/macros.h"
 #include "common/logging.h"
 #include "common/types.h"
+#include "common/fixed_point.h"
+#include "common/journal_recorder.h"
 
 #include "exchange/market_data/market_update.h"
 #include "trading/adapters/binance/market_data/binance_config.h"
+#include "trading/market_data/market_update_conflator.h"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -107,6 +111,7 @@ public:
         asks_ = std::move(other.asks_);
         last_update_id_ = other.last_update_id_;
         initialized_ = other.initialized_;
+        scale_ = other.scale_;
 
         // Reset source object's state
         other.last_update_id_ = 0;
@@ -127,6 +132,7 @@ public:
             asks_ = std::move(other.asks_);
             last_update_id_ = other.last_update_id_;
             initialized_ = other.initialized_;
+            scale_ = other.scale_;
 
             // Reset source object's state
             other.last_update_id_ = 0;
@@ -153,6 +159,9 @@ public:
     // Get the last update ID
     uint64_t getLastUpdateId() const { return last_update_id_; }
 
+    // Set the fixed-point scales used to parse prices and quantities (before the snapshot is applied)
+    void setInstrumentScale(const Common::InstrumentScale& scale) { scale_ = scale; }
+
     // Set the last update ID and mark the book as initialized
     void setLastUpdateId(uint64_t update_id);
 
@@ -175,13 +184,16 @@ private:
     bool initialized_ = false;
     mutable std::mutex mutex_;
 
+    // Prices and quantities are kept to 2 decimals until the symbol's filters are known
+    Common::InstrumentScale scale_{2, 2};
+
     // Helper to convert string price/qty to internal format
     Common::Price stringToPrice(const std::string& price_str) const {
-        return static_cast<Common::Price>(std::stod(price_str) * 100.0); // Convert to internal price format
+        return scale_.parsePrice(price_str);
     }
 
     Common::Qty stringToQty(const std::string& qty_str) const {
-        return static_cast<Common::Qty>(std::stod(qty_str) * 100.0); // Convert to internal qty format
+        return scale_.parseQty(qty_str);
     }
 };
 
@@ -198,6 +210,20 @@ public:
     auto start() -> void;
     auto stop() -> void;
 
+    // Publish through a conflation stage instead of the market updates queue (set before start())
+    auto setConflator(MarketUpdateConflator* conflator) -> void { conflator_ = conflator; }
+
+    // Copy every raw stream message into a journal recorder ring as it arrives (set before start())
+    auto setJournal(Common::JournalByteRing* journal) -> void { journal_ = journal; }
+
+    // Replay a journaled message on the calling thread instead of start(): stream messages go through onMessage(),
+    // the exchangeInfo and depth snapshot REST responses ("exchangeInfo" / "snapshot" stream types) set the scales
+    // and initialize the order book the way start() does
+    auto replay(const std::string& payload, const std::string& symbol, const std::string& stream_type) -> void;
+
+    // Replay the payload of a BINANCE_JSON journal record, false if it is not tagged "<symbol>@<stream_type>\n"
+    auto replayJournalRecord(const char* data, size_t length) -> bool;
+
     // Deleted default, copy & move constructors and assignment-operators
     BinanceMarketDataConsumer() = delete;
     BinanceMarketDataConsumer(const BinanceMarketDataConsumer &) = delete;
@@ -218,11 +244,20 @@ private:
     // Lock free queue to push market updates to trade engine
     Exchange::MEMarketUpdateLFQueue *incoming_md_updates_ = nullptr;
 
+    // Optional conflation stage used instead of incoming_md_updates_
+    MarketUpdateConflator *conflator_ = nullptr;
+
+    // Optional journal recorder ring for the raw messages
+    Common::JournalByteRing *journal_ = nullptr;
+
     // Asio components
     net::io_context ioc_;
     ssl::context ctx_{ssl::context::tlsv12_client};
     std::thread ioc_thread_;
 
+    // Keeps ioc_.run() going until stop(), the connections are only posted after the IO thread started
+    std::optional<net::executor_work_guard<net::io_context::executor_type>> work_guard_;
+
     // WebSocket connections
     std::vector<std::shared_ptr<WebSocketConnection>> connections_;
     std::vector<std::string> symbols_;
@@ -236,11 +271,24 @@ private:
     std::unordered_map<std::string, std::vector<Json::Value>> buffered_updates_;
     std::mutex buffer_mutex_; // Mutex for thread-safe access to buffered_updates_
 
+    // Fixed-point scales per symbol from the exchange's PRICE_FILTER / LOT_SIZE filters, filled before streaming starts
+    std::unordered_map<std::string, Common::InstrumentScale> scales_;
+
+    // Fetch the tick size and step size of a symbol from the exchangeInfo endpoint
+    void getInstrumentScale(const std::string& symbol);
+    void applyInstrumentScale(const std::string& symbol, const std::string& response_body);
+
     // Initialize order books with snapshots
     void getOrderBookSnapshot(const std::string& symbol);
     void initializeOrderBook(const std::string& symbol, const Json::Value& snapshot);
     void processBufferedUpdates(const std::string& symbol);
 
+    // Publish a market update to the conflator if one is set, otherwise to the trade engine queue
+    void publishUpdate(const Exchange::MEMarketUpdate& update);
+
+    // Copy a message, tagged with its symbol and stream type, into the journal ring if one is set
+    void journalMessage(const std::string& payload, const std::string& symbol, const std::string& stream_type);
+
     // Process market data from Binance
     void onMessage(const std::string& payload, const std::string& symbol, const std::string& stream_type);
     void onDepthUpdate(const std::string& symbol, const Json::Value& data);
@@ -9,6 +9,13 @@
 
 namespace Trading {
 
+// The log directory has to exist before the logger opens its file
+static std::string gatewayLogFile(Common::ClientId client_id) {
+    const std::string log_dir = "/home/praveen/om/siriquantum/ida/logs/binance/";
+    std::filesystem::create_directories(log_dir);
+    return log_dir + "binance_order_gateway_" + std::to_string(client_id) + ".log";
+}
+
 BinanceOrderGatewayAdapter::BinanceOrderGatewayAdapter(Common::ClientId client_id,
                                  Exchange::ClientRequestLFQueue *client_requests,
                                  Exchange::ClientResponseLFQueue *client_responses,
@@ -19,16 +26,16 @@ BinanceOrderGatewayAdapter::BinanceOrderGatewayAdapter(Common::ClientId client_i
       incoming_requests_(client_requests),
       outgoing_responses_(client_responses),
       symbols_(symbols),
-      logger_("/home/praveen/om/siriquantum/ida/logs/binance/binance_order_gateway_" + std::to_string(client_id) + ".log") {
-    
-    // Create log directory if it doesn't exist
-    std::filesystem::create_directories("/home/praveen/om/siriquantum/ida/logs/binance/");
+      logger_(gatewayLogFile(client_id)) {
     
     // Initialize symbol mappings
     for (size_t i = 0; i < symbols_.size() && i < Common::ME_MAX_TICKERS; ++i) {
         symbol_to_ticker_id_[symbols_[i]] = i;
         ticker_id_to_symbol_[i] = symbols_[i];
     }
+    for (size_t i = 0; i < Common::ME_MAX_TICKERS; ++i) {
+        scales_[i] = Common::InstrumentScale{2, 2};
+    }
     
     // Initialize CURL
     curl_global_init(CURL_GLOBAL_ALL);
@@ -54,10 +61,12 @@ BinanceOrderGatewayAdapter::~BinanceOrderGatewayAdapter() {
 
 void BinanceOrderGatewayAdapter::start() {
     run_ = true;
+
+    loadInstrumentScales();
     
     // Start the main thread
-    ASSERT(Common::createAndStartThread(-1, "Trading/BinanceOrderGateway", [this] { run(); }) != nullptr, 
-           "Failed to start BinanceOrderGateway thread.");
+    run_thread_ = Common::createAndStartThread(-1, "Trading/BinanceOrderGateway", [this] { run(); });
+    ASSERT(run_thread_ != nullptr, "Failed to start BinanceOrderGateway thread.");
     
     // Start order status polling thread
     order_status_thread_ = std::thread(&BinanceOrderGatewayAdapter::pollOrderStatuses, this);
@@ -66,7 +75,12 @@ void BinanceOrderGatewayAdapter::start() {
 void BinanceOrderGatewayAdapter::stop() {
     run_ = false;
     
-    // Wait for order status thread to finish
+    // Wait for both threads to finish, the main loop notices run_ within one idle sleep
+    if (run_thread_) {
+        run_thread_->join();
+        delete run_thread_;
+        run_thread_ = nullptr;
+    }
     if (order_status_thread_.joinable()) {
         order_status_thread_.join();
     }
@@ -102,7 +116,7 @@ std::string BinanceOrderGatewayAdapter::createSignature(const std::string& query
     return std::string(signature);
 }
 
-Json::Value BinanceOrderGatewayAdapter::sendRequest(const std::string& endpoint, const std::string& query_string, bool is_post) {
+Json::Value BinanceOrderGatewayAdapter::sendRequest(const std::string& endpoint, const std::string& query_string, bool is_post, bool is_delete) {
     Json::Value result;
 
     try {
@@ -121,7 +135,7 @@ Json::Value BinanceOrderGatewayAdapter::sendRequest(const std::string& endpoint,
         logger_.log("%:% %() % Sending % request to %\n",
                    __FILE__, __LINE__, __FUNCTION__,
                    Common::getCurrentTimeStr(&time_str_),
-                   (is_post ? "POST" : "GET"), request_log_url.c_str());
+                   (is_post ? "POST" : (is_delete ? "DELETE" : "GET")), request_log_url.c_str());
 
         if (is_post) {
             logger_.log("%:% %() % POST data: %\n",
@@ -145,10 +159,18 @@ Json::Value BinanceOrderGatewayAdapter::sendRequest(const std::string& endpoint,
         // Set up timeout
         curl_easy_setopt(curl_, CURLOPT_TIMEOUT, 30L); // 30 seconds timeout
 
+        // A local simulator's certificate is self-signed
+        if (!config_.verify_peer) {
+            curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYPEER, 0L);
+            curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYHOST, 0L);
+        }
+
         // Set up POST data if needed
         if (is_post) {
             curl_easy_setopt(curl_, CURLOPT_POST, 1L);
             curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, query_string.c_str());
+        } else if (is_delete) {
+            curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "DELETE");
         }
 
         // Prepare for response
@@ -247,8 +269,9 @@ Json::Value BinanceOrderGatewayAdapter::sendNewOrder(Common::TickerId ticker_id,
         std::string symbol = ticker_id_to_symbol_[ticker_id];
 
         // Convert internal price/qty to Binance format
-        double binance_price = price / 100.0; // Convert from internal price format (x100)
-        double binance_qty = qty / 100.0;     // Convert from internal qty format (x100)
+        const auto& scale = scales_.at(ticker_id);
+        double binance_price = scale.priceToDouble(price);
+        double binance_qty = scale.qtyToDouble(qty);
 
         // Check for valid price and quantity
         if (binance_price <= 0.0) {
@@ -294,7 +317,7 @@ Json::Value BinanceOrderGatewayAdapter::sendNewOrder(Common::TickerId ticker_id,
 
             // Store mapping from internal to Binance order ID
             std::lock_guard<std::mutex> lock(order_map_mutex_);
-            order_id_to_binance_id_[order_id] = binance_order_id;
+            order_id_to_binance_id_[order_id] = {binance_order_id, ticker_id, side};
 
             logger_.log("%:% %() % New order placed: % -> Binance ID: %\n", __FILE__, __LINE__, __FUNCTION__,
                        Common::getCurrentTimeStr(&time_str_), order_id, binance_order_id);
@@ -338,13 +361,23 @@ Json::Value BinanceOrderGatewayAdapter::cancelOrder(Common::TickerId ticker_id,
     std::string signature = createSignature(query_string);
     query_string += "&signature=" + signature;
 
-    // Send the request
-    Json::Value result = sendRequest("/api/v3/order", query_string, true);
+    // Send the request - Binance cancels with DELETE, a POST would place a new order
+    Json::Value result = sendRequest("/api/v3/order", query_string, false, true);
 
     if (!result.isNull() && result.isMember("orderId")) {
-        // Remove mapping from internal to Binance order ID
-        std::lock_guard<std::mutex> lock(order_map_mutex_);
-        order_id_to_binance_id_.erase(order_id);
+        // Remove mapping from internal to Binance order ID, reporting what executed since the last status poll first
+        Exchange::MEClientResponse fill;
+        bool has_fill = false;
+        {
+            std::lock_guard<std::mutex> lock(order_map_mutex_);
+            auto it = order_id_to_binance_id_.find(order_id);
+            if (it != order_id_to_binance_id_.end()) {
+                has_fill = takeExecution(order_id, it->second, result, &fill);
+                order_id_to_binance_id_.erase(it);
+            }
+        }
+        if (has_fill)
+            publishResponse(fill);
 
         logger_.log("%:% %() % Order canceled: % (Binance ID: %)\n", __FILE__, __LINE__, __FUNCTION__,
                    Common::getCurrentTimeStr(&time_str_), order_id, binance_order_id);
@@ -353,6 +386,70 @@ Json::Value BinanceOrderGatewayAdapter::cancelOrder(Common::TickerId ticker_id,
     return result;
 }
 
+Json::Value BinanceOrderGatewayAdapter::cancelReplaceOrder(Common::TickerId ticker_id, Common::Side side, Common::Price price, Common::Qty qty,
+                                                           Common::OrderId order_id, const std::string& binance_order_id) {
+    if (!ticker_id_to_symbol_.count(ticker_id)) {
+        logger_.log("%:% %() % Unknown ticker ID: %\n", __FILE__, __LINE__, __FUNCTION__,
+                   Common::getCurrentTimeStr(&time_str_), ticker_id);
+        return Json::Value();
+    }
+
+    std::string symbol = ticker_id_to_symbol_[ticker_id];
+    const auto& scale = scales_.at(ticker_id);
+
+    // Create timestamp
+    std::string timestamp = generateTimestamp();
+
+    // Prepare query string - the replacement is only placed if the cancel succeeded
+    std::ostringstream query_ss;
+    query_ss << "symbol=" << symbol
+             << "&side=" << (side == Common::Side::BUY ? "BUY" : "SELL")
+             << "&type=LIMIT"
+             << "&timeInForce=GTC"
+             << "&cancelReplaceMode=STOP_ON_FAILURE"
+             << "&cancelOrderId=" << binance_order_id
+             << "&quantity=" << std::fixed << std::setprecision(8) << scale.qtyToDouble(qty)
+             << "&price=" << std::fixed << std::setprecision(8) << scale.priceToDouble(price)
+             << "&timestamp=" << timestamp;
+
+    std::string query_string = query_ss.str();
+
+    // Create signature
+    std::string signature = createSignature(query_string);
+    query_string += "&signature=" + signature;
+
+    // Send the request
+    Json::Value result = sendRequest("/api/v3/order/cancelReplace", query_string, true);
+
+    // Failures carry the cancel and new order results under "data"
+    const auto& outcome = result.isMember("data") ? result["data"] : result;
+    if (outcome.get("cancelResult", "").asString() == "SUCCESS") {
+        Exchange::MEClientResponse fill;
+        bool has_fill = false;
+        {
+            std::lock_guard<std::mutex> lock(order_map_mutex_);
+            auto it = order_id_to_binance_id_.find(order_id);
+            if (it != order_id_to_binance_id_.end()) {
+                // What the cancelled order executed since the last status poll is reported before the replacement
+                has_fill = takeExecution(order_id, it->second, outcome["cancelResponse"], &fill);
+                if (outcome.get("newOrderResult", "").asString() == "SUCCESS") {
+                    // The same internal order id now refers to the replacement order, which has executed nothing yet
+                    it->second = {outcome["newOrderResponse"]["orderId"].asString(), ticker_id, side};
+
+                    logger_.log("%:% %() % Order replaced: % -> Binance ID: %\n", __FILE__, __LINE__, __FUNCTION__,
+                               Common::getCurrentTimeStr(&time_str_), order_id, it->second.binance_order_id);
+                } else {
+                    order_id_to_binance_id_.erase(it);
+                }
+            }
+        }
+        if (has_fill)
+            publishResponse(fill);
+    }
+
+    return outcome;
+}
+
 Json::Value BinanceOrderGatewayAdapter::getOrderStatus(Common::TickerId ticker_id, const std::string& binance_order_id) {
     if (!ticker_id_to_symbol_.count(ticker_id)) {
         logger_.log("%:% %() % Unknown ticker ID: %\n", __FILE__, __LINE__, __FUNCTION__,
@@ -414,6 +511,30 @@ Json::Value BinanceOrderGatewayAdapter::getExchangeInfo(const std::string& symbo
     return Json::Value();
 }
 
+void BinanceOrderGatewayAdapter::loadInstrumentScales() {
+    for (const auto& [ticker_id, symbol] : ticker_id_to_symbol_) {
+        Json::Value symbol_info = getExchangeInfo(symbol);
+        if (symbol_info.isNull() || !symbol_info.isMember("filters")) {
+            continue;
+        }
+
+        std::string tick_size, step_size;
+        for (const auto& filter : symbol_info["filters"]) {
+            if (filter["filterType"].asString() == "PRICE_FILTER") {
+                tick_size = filter["tickSize"].asString();
+            } else if (filter["filterType"].asString() == "LOT_SIZE") {
+                step_size = filter["stepSize"].asString();
+            }
+        }
+
+        if (!tick_size.empty() && !step_size.empty()) {
+            scales_.at(ticker_id) = Common::InstrumentScale::fromIncrements(std::string_view(tick_size), std::string_view(step_size));
+            logger_.log("%:% %() % % %\n", __FILE__, __LINE__, __FUNCTION__,
+                       Common::getCurrentTimeStr(&time_str_), symbol, scales_.at(ticker_id).toString());
+        }
+    }
+}
+
 bool BinanceOrderGatewayAdapter::checkPercentPriceFilter(const std::string& symbol, Common::Side side, double price) {
     // Get current market price
     double current_price = getCurrentPrice(symbol);
@@ -484,86 +605,93 @@ void BinanceOrderGatewayAdapter::pollOrderStatuses() {
                Common::getCurrentTimeStr(&time_str_));
 
     while (run_) {
-        std::map<Common::OrderId, std::string> order_map_copy;
+        std::map<Common::OrderId, BinanceOrder> order_map_copy;
 
         {
             std::lock_guard<std::mutex> lock(order_map_mutex_);
             order_map_copy = order_id_to_binance_id_;
         }
 
-        for (const auto& [order_id, binance_order_id] : order_map_copy) {
-            // Skip if we can't match to a ticker ID
-            bool found = false;
-            Common::TickerId ticker_id = 0;
-
-            for (const auto& [tid, sym] : ticker_id_to_symbol_) {
-                if (symbol_to_ticker_id_.count(sym)) {
-                    ticker_id = tid;
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found) continue;
-
-            Json::Value order_status = getOrderStatus(ticker_id, binance_order_id);
+        for (const auto& [order_id, order] : order_map_copy) {
+            // The main loop publishes the responses, it is the only writer of the response queue
+            Json::Value order_status = getOrderStatus(order.ticker_id, order.binance_order_id);
             if (!order_status.isNull()) {
-                handleOrderQueryResponse(order_status, order_id, ticker_id);
+                std::lock_guard<std::mutex> lock(polled_statuses_mutex_);
+                polled_statuses_.emplace_back(order_id, std::move(order_status));
             }
 
             // Sleep between requests to avoid rate limiting
             std::this_thread::sleep_for(std::chrono::milliseconds(250));
         }
 
-        // Sleep before next polling cycle
-        std::this_thread::sleep_for(std::chrono::seconds(5));
+        // Sleep before next polling cycle, in steps so stop() does not wait out the whole cycle
+        for (int i = 0; i < 50 && run_; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
     logger_.log("%:% %() % Order status polling thread stopped\n", __FILE__, __LINE__, __FUNCTION__,
                Common::getCurrentTimeStr(&time_str_));
 }
 
-void BinanceOrderGatewayAdapter::handleOrderQueryResponse(const Json::Value& response, Common::OrderId order_id, Common::TickerId /* ticker_id */) {
+void BinanceOrderGatewayAdapter::handleOrderQueryResponse(const Json::Value& response, Common::OrderId order_id) {
     if (!response.isMember("status")) {
         return;
     }
 
-    std::string status = response["status"].asString();
-    std::string binance_order_id = response["orderId"].asString();
-
-    Exchange::ClientResponseType type;
-
-    if (status == "FILLED") {
-        type = Exchange::ClientResponseType::FILLED;
+    const std::string status = response["status"].asString();
+    const auto filled = (status == "FILLED" || status == "PARTIALLY_FILLED");
+    const auto cancelled = (status == "CANCELED" || status == "EXPIRED");
+    const auto rejected = (status == "REJECTED");
+    if (!filled && !cancelled && !rejected) {
+        // Other statuses (NEW, PENDING_CANCEL) - continue tracking
+        return;
+    }
 
-        // Remove from order map as it's completely filled
+    Exchange::MEClientResponse fill, done_response;
+    bool has_fill = false;
+    {
         std::lock_guard<std::mutex> lock(order_map_mutex_);
-        order_id_to_binance_id_.erase(order_id);
+        auto it = order_id_to_binance_id_.find(order_id);
+        // Finished or replaced by a request since the poll, the status is of an order we no longer track
+        if (it == order_id_to_binance_id_.end() || it->second.binance_order_id != response["orderId"].asString())
+            return;
 
-    } else if (status == "PARTIALLY_FILLED") {
-        // For partial fills, we can use FILLED with partial quantity
-        type = Exchange::ClientResponseType::FILLED;
-    } else if (status == "CANCELED") {
-        type = Exchange::ClientResponseType::CANCELED;
+        auto& order = it->second;
+        has_fill = takeExecution(order_id, order, response, &fill);
+        done_response = {cancelled ? Exchange::ClientResponseType::CANCELED : Exchange::ClientResponseType::REJECTED,
+                         Exchange::ClientResponseRejectReason::INVALID, client_id_, order.ticker_id, order_id, order.side,
+                         Common::Price_INVALID, 0, 0};
+        if (status != "PARTIALLY_FILLED")
+            order_id_to_binance_id_.erase(it);
+    }
 
-        // Remove from order map as it's canceled
-        std::lock_guard<std::mutex> lock(order_map_mutex_);
-        order_id_to_binance_id_.erase(order_id);
+    if (has_fill)
+        publishResponse(fill);
+    if (cancelled || rejected)
+        publishResponse(done_response);
+}
 
-    } else if (status == "REJECTED") {
-        // For rejected orders, use CANCEL_REJECTED
-        type = Exchange::ClientResponseType::CANCEL_REJECTED;
+bool BinanceOrderGatewayAdapter::takeExecution(Common::OrderId order_id, BinanceOrder& order, const Json::Value& status,
+                                                Exchange::MEClientResponse* fill) {
+    if (!status.isMember("executedQty") || !status.isMember("cummulativeQuoteQty") || !status.isMember("origQty"))
+        return false;
 
-        // Remove from order map as it's rejected
-        std::lock_guard<std::mutex> lock(order_map_mutex_);
-        order_id_to_binance_id_.erase(order_id);
+    // Binance reports the cumulative execution, only what executed since the last report is a new fill
+    const auto& scale = scales_.at(order.ticker_id);
+    const auto executed_qty = scale.parseQty(status["executedQty"].asString());
+    const auto quote_qty = std::stod(status["cummulativeQuoteQty"].asString());
+    if (executed_qty <= order.reported_qty)
+        return false;
 
-    } else {
-        // Other statuses (NEW, PENDING_CANCEL) - continue tracking
-        return;
-    }
+    const auto exec_qty = executed_qty - order.reported_qty;
+    const auto exec_price = scale.toPrice((quote_qty - order.reported_quote_qty) / scale.qtyToDouble(exec_qty));
+    const auto orig_qty = scale.parseQty(status["origQty"].asString());
+    order.reported_qty = executed_qty;
+    order.reported_quote_qty = quote_qty;
 
-    createClientResponse(response, nullptr, type);
+    *fill = {Exchange::ClientResponseType::FILLED, Exchange::ClientResponseRejectReason::INVALID, client_id_, order.ticker_id,
+             order_id, order.side, exec_price, exec_qty, orig_qty > executed_qty ? orig_qty - executed_qty : 0};
+    return true;
 }
 
 void BinanceOrderGatewayAdapter::processClientRequest(const Exchange::MEClientRequest* request) {
@@ -590,8 +718,9 @@ void BinanceOrderGatewayAdapter::processClientRequest(const Exchange::MEClientRe
         }
 
         std::string symbol = ticker_id_to_symbol_[request->ticker_id_];
-        double binance_price = request->price_ / 100.0; // Convert from internal price format
-        double binance_qty = request->qty_ / 100.0;     // Convert from internal qty format
+        const auto& scale = scales_.at(request->ticker_id_);
+        double binance_price = scale.priceToDouble(request->price_);
+        double binance_qty = scale.qtyToDouble(request->qty_);
 
         logger_.log("%:% %() % Submitting order to Binance: symbol=%, side=%, price=%, qty=%\n",
                    __FILE__, __LINE__, __FUNCTION__,
@@ -658,7 +787,7 @@ void BinanceOrderGatewayAdapter::processClientRequest(const Exchange::MEClientRe
             auto it = order_id_to_binance_id_.find(request->order_id_);
 
             if (it != order_id_to_binance_id_.end()) {
-                binance_order_id = it->second;
+                binance_order_id = it->second.binance_order_id;
                 logger_.log("%:% %() % Found Binance order ID % for order_id=%\n",
                           __FILE__, __LINE__, __FUNCTION__,
                           Common::getCurrentTimeStr(&time_str_),
@@ -711,94 +840,92 @@ void BinanceOrderGatewayAdapter::processClientRequest(const Exchange::MEClientRe
             Json::Value empty;
             createClientResponse(empty, request, Exchange::ClientResponseType::CANCEL_REJECTED);
         }
-    }
-}
-
-void BinanceOrderGatewayAdapter::createClientResponse(const Json::Value& response, const Exchange::MEClientRequest* request, Exchange::ClientResponseType type) {
-    Exchange::MEClientResponse client_response;
+    } else if (request->type_ == Exchange::ClientRequestType::MODIFY) {
+        // Modify request, a single cancel/replace keeping our order id
+        std::string binance_order_id;
 
-    if (request) {
-        // For direct responses to client requests
-        client_response.client_id_ = request->client_id_;
-        client_response.ticker_id_ = request->ticker_id_;
-        client_response.order_id_ = request->order_id_;
-        client_response.price_ = request->price_;
-        client_response.exec_qty_ = 0;                 // Will be set for fills only
-        client_response.side_ = request->side_;
-    } else {
-        // For asynchronous updates (e.g., from order status polling)
-        if (!response.isMember("orderId") || !response.isMember("side")) {
-            return;  // Insufficient data
+        {
+            std::lock_guard<std::mutex> lock(order_map_mutex_);
+            auto it = order_id_to_binance_id_.find(request->order_id_);
+            if (it != order_id_to_binance_id_.end())
+                binance_order_id = it->second.binance_order_id;
         }
 
-        // Extract order details from response
-        std::string binance_order_id = response["orderId"].asString();
-        std::string symbol = response["symbol"].asString();
-
-        // Find internal order ID and ticker ID
-        Common::OrderId order_id = 0;
-        Common::TickerId ticker_id = 0;
-        bool found_order = false, found_ticker = false;
-
-        // Look up order ID
-        for (const auto& [oid, boid] : order_id_to_binance_id_) {
-            if (boid == binance_order_id) {
-                order_id = oid;
-                found_order = true;
-                break;
-            }
-        }
+        if (binance_order_id.empty()) {
+            logger_.log("%:% %() % Cannot modify - no Binance order ID for order_id=%\n",
+                      __FILE__, __LINE__, __FUNCTION__,
+                      Common::getCurrentTimeStr(&time_str_),
+                      request->order_id_);
 
-        // Look up ticker ID
-        for (const auto& [sym, tid] : symbol_to_ticker_id_) {
-            if (sym == symbol) {
-                ticker_id = tid;
-                found_ticker = true;
-                break;
-            }
+            Json::Value empty;
+            createClientResponse(empty, request, Exchange::ClientResponseType::MODIFY_REJECTED);
+            return;
         }
 
-        if (!found_order || !found_ticker) {
-            return;  // Can't match to our internal IDs
+        Json::Value response = cancelReplaceOrder(request->ticker_id_, request->side_, request->price_, request->qty_,
+                                                  request->order_id_, binance_order_id);
+
+        logger_.log("%:% %() % Binance cancelReplace response: %\n",
+                  __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_),
+                  response.toStyledString().c_str());
+
+        const auto cancel_ok = (response.get("cancelResult", "").asString() == "SUCCESS");
+        const auto new_ok = (response.get("newOrderResult", "").asString() == "SUCCESS");
+        if (cancel_ok && new_ok) {
+            createClientResponse(response, request, Exchange::ClientResponseType::ACCEPTED);
+        } else if (cancel_ok) {
+            // The old order is gone but the replacement was not placed
+            createClientResponse(response, request, Exchange::ClientResponseType::CANCELED);
+        } else {
+            // The old order is still working unchanged
+            createClientResponse(response, request, Exchange::ClientResponseType::MODIFY_REJECTED);
         }
-
-        client_response.client_id_ = client_id_;
-        client_response.ticker_id_ = ticker_id;
-        client_response.order_id_ = order_id;
-        client_response.side_ = response["side"].asString() == "BUY" ? Common::Side::BUY : Common::Side::SELL;
     }
+}
 
+void BinanceOrderGatewayAdapter::createClientResponse(const Json::Value& /* response */, const Exchange::MEClientRequest* request, Exchange::ClientResponseType type) {
+    Exchange::MEClientResponse client_response;
     client_response.type_ = type;
+    client_response.client_id_ = request->client_id_;
+    client_response.ticker_id_ = request->ticker_id_;
+    client_response.order_id_ = request->order_id_;
+    client_response.side_ = request->side_;
+    client_response.price_ = request->price_;
+    client_response.exec_qty_ = 0;    // Fills are reported from the order status, see takeExecution()
+    // A new order or a cancelReplace replacement works its full quantity, anything else leaves nothing working
+    client_response.leaves_qty_ = (type == Exchange::ClientResponseType::ACCEPTED ? request->qty_ : 0);
+
+    publishResponse(client_response);
+}
 
-    // For fills, extract executed price and quantity
-    if (type == Exchange::ClientResponseType::FILLED) {
-        if (response.isMember("executedQty") && response.isMember("price")) {
-            double executed_qty = std::stod(response["executedQty"].asString());
-            double price = std::stod(response["price"].asString());
-
-            // Convert to internal format
-            client_response.exec_qty_ = static_cast<Common::Qty>(executed_qty * 100);
-            client_response.price_ = static_cast<Common::Price>(price * 100);
-        }
-    }
-
+void BinanceOrderGatewayAdapter::publishResponse(const Exchange::MEClientResponse& client_response) {
     // Push response to queue (to be read by TradeEngine)
     auto next_write = outgoing_responses_->getNextToWriteTo();
     *next_write = client_response;
     outgoing_responses_->updateWriteIndex();
 
-    logger_.log("%:% %() % Sent client response: type=%, ticker_id=%, order_id=%\n",
+    logger_.log("%:% %() % Sent client response: %\n",
                __FILE__, __LINE__, __FUNCTION__,
                Common::getCurrentTimeStr(&time_str_),
-               Exchange::clientResponseTypeToString(client_response.type_),
-               client_response.ticker_id_, client_response.order_id_);
+               client_response.toString().c_str());
 }
 
 auto BinanceOrderGatewayAdapter::run() noexcept -> void {
     logger_.log("%:% %() % Starting BinanceOrderGatewayAdapter loop\n", __FILE__, __LINE__, __FUNCTION__,
                Common::getCurrentTimeStr(&time_str_));
 
+    std::vector<std::pair<Common::OrderId, Json::Value>> statuses;
     while (run_) {
+        // Publish what the polling thread found, responses only ever come from this thread
+        {
+            std::lock_guard<std::mutex> lock(polled_statuses_mutex_);
+            statuses.swap(polled_statuses_);
+        }
+        for (const auto& [order_id, status] : statuses)
+            handleOrderQueryResponse(status, order_id);
+        statuses.clear();
+
         // Read incoming client requests from the TradeEngine
         auto next_request = incoming_requests_->getNextToRead();
 
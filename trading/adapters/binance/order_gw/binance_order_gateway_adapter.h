@@ -16,6 +16,7 @@
 #include "common/macros.h"
 #include "common/logging.h"
 #include "common/types.h"
+#include "common/fixed_point.h"
 
 #include "exchange/order_server/client_request.h"
 #include "exchange/order_server/client_response.h"
@@ -43,6 +44,9 @@ public:
     // Get exchange info including filters
     Json::Value getExchangeInfo(const std::string& symbol);
 
+    // Load the fixed-point scales of every symbol from the exchange filters
+    void loadInstrumentScales();
+
     // Check if an order price passes the PERCENT_PRICE_BY_SIDE filter
     bool checkPercentPriceFilter(const std::string& symbol, Common::Side side, double price);
 
@@ -92,11 +96,27 @@ private:
     std::vector<std::string> symbols_;
     std::map<Common::TickerId, std::string> ticker_id_to_symbol_;
     std::map<std::string, Common::TickerId> symbol_to_ticker_id_;
+
+    // Fixed-point scales per ticker, same PRICE_FILTER / LOT_SIZE derived scales as the market data consumer
+    Common::InstrumentScaleHashMap scales_;
     
-    // Mapping from OrderId to Binance order ID for cancellations
-    std::map<Common::OrderId, std::string> order_id_to_binance_id_;
+    // Working order at Binance, and how much of its execution has been reported so far
+    struct BinanceOrder {
+        std::string binance_order_id;
+        Common::TickerId ticker_id = Common::TickerId_INVALID;
+        Common::Side side = Common::Side::INVALID;
+        Common::Qty reported_qty = 0;
+        double reported_quote_qty = 0;
+    };
+
+    // Mapping from OrderId to the working Binance order, for cancellations and status polls
+    std::map<Common::OrderId, BinanceOrder> order_id_to_binance_id_;
     std::mutex order_map_mutex_; // Protects order_id_to_binance_id_
 
+    // Order statuses fetched by the polling thread, handed to the main loop which publishes the responses
+    std::vector<std::pair<Common::OrderId, Json::Value>> polled_statuses_;
+    std::mutex polled_statuses_mutex_; // Protects polled_statuses_
+
     volatile bool run_ = false;
     std::string time_str_;
     Common::Logger logger_;
@@ -111,21 +131,31 @@ private:
     std::string generateTimestamp();
     
     // HTTP request helper
-    Json::Value sendRequest(const std::string& endpoint, const std::string& query_string, bool is_post);
+    Json::Value sendRequest(const std::string& endpoint, const std::string& query_string, bool is_post, bool is_delete = false);
     
     // REST API endpoints
     Json::Value sendNewOrder(Common::TickerId ticker_id, Common::Side side, Common::Price price, Common::Qty qty, Common::OrderId order_id);
     Json::Value cancelOrder(Common::TickerId ticker_id, Common::OrderId order_id, const std::string& binance_order_id);
+    Json::Value cancelReplaceOrder(Common::TickerId ticker_id, Common::Side side, Common::Price price, Common::Qty qty,
+                                   Common::OrderId order_id, const std::string& binance_order_id);
     Json::Value getOrderStatus(Common::TickerId ticker_id, const std::string& binance_order_id);
     
     // Process client requests and responses
     void processClientRequest(const Exchange::MEClientRequest* request);
     void createClientResponse(const Json::Value& response, const Exchange::MEClientRequest* request, Exchange::ClientResponseType type);
     
-    // Handle order query responses
-    void handleOrderQueryResponse(const Json::Value& response, Common::OrderId order_id, Common::TickerId ticker_id);
+    // Handle order query responses, on the main loop thread
+    void handleOrderQueryResponse(const Json::Value& response, Common::OrderId order_id);
+
+    // Publish a response to the TradeEngine, only ever from the main loop thread
+    void publishResponse(const Exchange::MEClientResponse& client_response);
+
+    // Fill for what the order executed since it was last reported, from the cumulative executedQty and
+    // cummulativeQuoteQty of an order status, false if nothing new executed. Called with order_map_mutex_ held.
+    bool takeExecution(Common::OrderId order_id, BinanceOrder& order, const Json::Value& status, Exchange::MEClientResponse* fill);
     
-    // Order status polling thread
+    // Main loop and order status polling threads
+    std::thread *run_thread_ = nullptr;
     std::thread order_status_thread_;
     void pollOrderStatuses();
     
@@ -0,0 +1,1077 @@
+#include "trading/adapters/sim/rest_order_entry_simulator.h"
+#include "trading/adapters/sim/sim_common.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <limits>
+#include <sstream>
+
+#include <openssl/hmac.h>
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/beast/http.hpp>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+using tcp = boost::asio::ip::tcp;
+
+namespace Adapter {
+namespace Sim {
+
+namespace {
+    // Limit price a MARKET buy is matched with, it takes every ask
+    constexpr Common::Price MARKET_BUY_PRICE = std::numeric_limits<Common::Price>::max() / 2;
+
+    // Kite rejects limit prices outside the day's circuit band, +-20% of the last price here
+    constexpr Common::Price KITE_CIRCUIT_PERCENT = 20;
+
+    int64_t now_ms() {
+        return Common::getSystemNanos() / Common::NANOS_TO_MILLIS;
+    }
+
+    std::string hmac_sha256_hex(const std::string& key, const std::string& data) {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int length = 0;
+        HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), reinterpret_cast<const unsigned char*>(data.data()),
+             data.size(), digest, &length);
+
+        static constexpr char HEX[] = "0123456789abcdef";
+        std::string hex(length * 2, '0');
+        for (unsigned int i = 0; i < length; ++i) {
+            hex[i * 2] = HEX[digest[i] >> 4];
+            hex[i * 2 + 1] = HEX[digest[i] & 0x0f];
+        }
+        return hex;
+    }
+
+    // Kite timestamps, e.g. "2024-01-15 09:15:00" in local (exchange) time
+    std::string kite_time(int64_t ms) {
+        const std::time_t seconds = static_cast<std::time_t>(ms / 1000);
+        std::tm tm{};
+        localtime_r(&seconds, &tm);
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+        return buffer;
+    }
+
+    // Path segments, e.g. "/orders/regular/151220000000000" -> {"orders", "regular", "151220000000000"}
+    std::vector<std::string> path_segments(const std::string& path) {
+        std::vector<std::string> segments;
+        std::istringstream iss(path);
+        std::string segment;
+        while (std::getline(iss, segment, '/')) {
+            if (!segment.empty()) {
+                segments.push_back(segment);
+            }
+        }
+        return segments;
+    }
+
+    // Order ids, timestamps and windows - digits only
+    bool parse_integer(const std::string& str, uint64_t& value) {
+        if (str.empty() || str.size() > 19 || str.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        value = std::stoull(str);
+        return true;
+    }
+
+    bool parse_qty(const std::string& str, int decimals, Common::Qty& qty) {
+        int64_t value = 0;
+        if (!parse_decimal(str, decimals, value) || value <= 0 || value >= Common::Qty_INVALID) {
+            return false;
+        }
+        qty = static_cast<Common::Qty>(value);
+        return true;
+    }
+
+    bool parse_price(const std::string& str, int decimals, Common::Price& price) {
+        return parse_decimal(str, decimals, price) && price > 0;
+    }
+
+    std::string param(const std::unordered_map<std::string, std::string>& params, const std::string& name) {
+        const auto itr = params.find(name);
+        return itr == params.end() ? std::string() : itr->second;
+    }
+}
+
+std::string RestSimulatorStats::toString() const {
+    std::ostringstream ss;
+    ss << "RestSimulatorStats["
+       << "connections:" << connections << " requests:" << requests
+       << " placed:" << orders_placed << " modified:" << orders_modified << " cancelled:" << orders_cancelled
+       << " fills:" << fills << " rejects:" << rejects
+       << " auth-failures:" << auth_failures << " signature-failures:" << signature_failures
+       << " rate-limited:" << rate_limited
+       << "]";
+    return ss.str();
+}
+
+/**
+ * An accepted TLS connection: reads requests one after the other and answers each, keep-alive included
+ */
+class RestConnection : public std::enable_shared_from_this<RestConnection> {
+public:
+    RestConnection(RestOrderEntrySimulator* simulator, tcp::socket&& socket)
+        : simulator_(simulator), stream_(std::move(socket), simulator->ssl_ctx_), timer_(simulator->ioc_) {}
+
+    void start() {
+        stream_.async_handshake(ssl::stream_base::server,
+                                beast::bind_front_handler(&RestConnection::on_handshake, shared_from_this()));
+    }
+
+    // Drop the connection, for stop()
+    void close() {
+        beast::error_code ec;
+        timer_.cancel();
+        beast::get_lowest_layer(stream_).socket().close(ec);
+    }
+
+private:
+    void on_handshake(beast::error_code ec) {
+        if (ec) {
+            return;
+        }
+        simulator_->on_connection();
+        do_read();
+    }
+
+    void do_read() {
+        request_ = {};
+        http::async_read(stream_, buffer_, request_, beast::bind_front_handler(&RestConnection::on_read, shared_from_this()));
+    }
+
+    void on_read(beast::error_code ec, size_t) {
+        if (ec) {
+            return;
+        }
+
+        RestOrderEntrySimulator::RestRequest request;
+        request.method = std::string(request_.method_string());
+        request.target = std::string(request_.target());
+        request.body = request_.body();
+        for (const auto& field : request_) {
+            auto name = std::string(field.name_string());
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            request.headers[name] = std::string(field.value());
+        }
+
+        const auto result = simulator_->handle(request);
+        response_ = {static_cast<http::status>(result.status), request_.version()};
+        response_.set(http::field::content_type, "application/json");
+        if (result.retry_after) {
+            response_.set(http::field::retry_after, std::to_string(result.retry_after));
+        }
+        response_.keep_alive(request_.keep_alive());
+        response_.body() = result.body;
+        response_.prepare_payload();
+
+        const auto delay = simulator_->config_.response_delay;
+        if (delay.count() > 0) {
+            timer_.expires_after(delay);
+            timer_.async_wait([self = shared_from_this()](beast::error_code wait_ec) {
+                if (!wait_ec) {
+                    self->do_write();
+                }
+            });
+        } else {
+            do_write();
+        }
+    }
+
+    void do_write() {
+        http::async_write(stream_, response_, beast::bind_front_handler(&RestConnection::on_write, shared_from_this()));
+    }
+
+    void on_write(beast::error_code ec, size_t) {
+        if (ec) {
+            return;
+        }
+        if (response_.keep_alive()) {
+            do_read();
+        } else {
+            stream_.async_shutdown([self = shared_from_this()](beast::error_code) {});
+        }
+    }
+
+    RestOrderEntrySimulator* simulator_;
+    beast::ssl_stream<beast::tcp_stream> stream_;
+    net::steady_timer timer_;
+    beast::flat_buffer buffer_;
+    http::request<http::string_body> request_;
+    http::response<http::string_body> response_;
+};
+
+RestOrderEntrySimulator::RestOrderEntrySimulator(const RestOrderEntrySimulatorConfig& config, Common::Logger* logger)
+    : config_(config),
+      logger_(logger),
+      fills_(logger),
+      me_updates_(Common::ME_MAX_MARKET_UPDATES) {
+    for (size_t i = 0; i < config_.instruments.size(); ++i) {
+        ticker_to_instrument_[config_.instruments[i].ticker_id] = i;
+        last_prices_.push_back(config_.instruments[i].start_price);
+    }
+
+    // Venue order ids look like the venue's: 15 digit Kite ids, Binance ids counting up from a large base
+    next_order_id_ = (config_.protocol == SimProtocol::KITE ? 250101000000001ULL : 1000000001ULL);
+
+    use_self_signed_certificate(ssl_ctx_);
+}
+
+RestOrderEntrySimulator::~RestOrderEntrySimulator() {
+    stop();
+}
+
+void RestOrderEntrySimulator::start() {
+    const tcp::endpoint endpoint(net::ip::make_address(config_.address), config_.port);
+    acceptor_.open(endpoint.protocol());
+    acceptor_.set_option(net::socket_base::reuse_address(true));
+    acceptor_.bind(endpoint);
+    acceptor_.listen(net::socket_base::max_listen_connections);
+    port_ = acceptor_.local_endpoint().port();
+
+    logger_->log("%:% %() % % order entry simulator listening on %:%, rate limit % per % ms\n", __FILE__, __LINE__, __FUNCTION__,
+                 Common::getCurrentTimeStr(&time_str_), simProtocolToString(config_.protocol), config_.address, port_,
+                 config_.order_rate_limit, config_.rate_limit_window.count());
+
+    running_ = true;
+    do_accept();
+    thread_ = std::thread([this]() { run(); });
+}
+
+void RestOrderEntrySimulator::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void RestOrderEntrySimulator::on_market_update(const Exchange::MEMarketUpdate* update) {
+    *me_updates_.getNextToWriteTo() = *update;
+    me_updates_.updateWriteIndex();
+}
+
+RestSimulatorStats RestOrderEntrySimulator::stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+void RestOrderEntrySimulator::do_accept() {
+    acceptor_.async_accept([this](beast::error_code ec, tcp::socket socket) {
+        if (!ec) {
+            socket.set_option(tcp::no_delay(true));
+            auto connection = std::make_shared<RestConnection>(this, std::move(socket));
+            connections_.erase(std::remove_if(connections_.begin(), connections_.end(), [](const auto& weak) { return weak.expired(); }),
+                               connections_.end());
+            connections_.push_back(connection);
+            connection->start();
+        }
+        if (running_ && acceptor_.is_open()) {
+            do_accept();
+        }
+    });
+}
+
+void RestOrderEntrySimulator::run() {
+    while (running_) {
+        ioc_.poll();
+        if (!drain_market_updates()) {
+            ioc_.run_one_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Shut down on this thread, the only one touching the connections
+    beast::error_code ec;
+    acceptor_.close(ec);
+    for (const auto& weak : connections_) {
+        if (auto connection = weak.lock()) {
+            connection->close();
+        }
+    }
+    connections_.clear();
+    ioc_.poll();
+    ioc_.stop();
+}
+
+size_t RestOrderEntrySimulator::drain_market_updates() {
+    size_t drained = 0;
+    for (auto update = me_updates_.getNextToRead(); update; update = me_updates_.getNextToRead()) {
+        const auto itr = ticker_to_instrument_.find(update->ticker_id_);
+        if (itr != ticker_to_instrument_.end()) {
+            fills_.onMarketUpdate(*update);
+            if (update->type_ == Exchange::MarketUpdateType::TRADE) {
+                last_prices_[itr->second] = update->price_;
+            }
+        }
+        me_updates_.updateReadIndex();
+        ++drained;
+    }
+    if (drained) {
+        apply_fill_responses();
+    }
+    return drained;
+}
+
+RestOrderEntrySimulator::RestResponse RestOrderEntrySimulator::handle(const RestRequest& request) {
+    on_request();
+    try {
+        return config_.protocol == SimProtocol::KITE ? handle_kite(request) : handle_binance(request);
+    } catch (const std::exception& e) {
+        logger_->log("%:% %() % Failed to serve % %: %\n", __FILE__, __LINE__, __FUNCTION__,
+                     Common::getCurrentTimeStr(&time_str_), request.method, request.target, e.what());
+        return {500, config_.protocol == SimProtocol::KITE
+                     ? R"({"status":"error","message":"Internal server error","data":null,"error_type":"GeneralException"})"
+                     : R"({"code":-1000,"msg":"An unknown error occurred while processing the request."})"};
+    }
+}
+
+RestOrderEntrySimulator::RestResponse RestOrderEntrySimulator::handle_kite(const RestRequest& request) {
+    const auto error = [](unsigned status, const std::string& error_type, const std::string& message) {
+        nlohmann::json body = {{"status", "error"}, {"message", message}, {"data", nullptr}, {"error_type", error_type}};
+        return RestResponse{status, body.dump()};
+    };
+    const auto success = [](const nlohmann::json& data) {
+        nlohmann::json body = {{"status", "success"}, {"data", data}};
+        return RestResponse{200, body.dump()};
+    };
+
+    const auto auth = request.headers.find("authorization");
+    if (auth == request.headers.end() || auth->second != "token " + config_.api_key + ":" + config_.access_token) {
+        update_stats([](RestSimulatorStats& stats) { ++stats.auth_failures; });
+        return error(403, "TokenException", "Incorrect `api_key` or `access_token`.");
+    }
+
+    const auto path = request.target.substr(0, request.target.find('?'));
+    const auto segments = path_segments(path);
+    if (segments.empty() || segments[0] != "orders") {
+        return error(404, "GeneralException", "Route not found");
+    }
+
+    // Order changes: POST /orders/{variety}, PUT and DELETE /orders/{variety}/{order_id}
+    if (request.method == "POST" || request.method == "PUT" || request.method == "DELETE") {
+        if (segments.size() != (request.method == "POST" ? 2u : 3u)) {
+            return error(404, "GeneralException", "Route not found");
+        }
+        unsigned retry_after = 0;
+        if (!take_rate_limit(retry_after)) {
+            update_stats([](RestSimulatorStats& stats) { ++stats.rate_limited; });
+            auto response = error(429, "NetworkException", "Too many requests");
+            response.retry_after = retry_after;
+            return response;
+        }
+        if (segments[1] != "regular") {
+            return error(400, "InputException", "Invalid `variety`.");
+        }
+
+        const auto params = parse_params(request.body);
+        const auto order_type = param(params, "order_type");
+        const auto validity = param(params, "validity");
+        if (!order_type.empty() && order_type != "LIMIT" && order_type != "MARKET") {
+            return error(400, "InputException", "Invalid `order_type`.");
+        }
+        if (!validity.empty() && validity != "DAY" && validity != "IOC") {
+            return error(400, "InputException", "Invalid `validity`.");
+        }
+
+        if (request.method == "POST") {
+            const auto instrument = find_instrument(param(params, "tradingsymbol"));
+            const auto side = param(params, "transaction_type");
+            const auto exchange = param(params, "exchange");
+            const auto product = param(params, "product");
+            const bool market = (order_type == "MARKET");
+            Common::Qty qty = 0;
+            Common::Price price = 0;
+
+            if (instrument < 0 || (exchange != "NSE" && exchange != "BSE")) {
+                update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+                return error(400, "InputException", "Invalid `tradingsymbol` or `exchange`.");
+            }
+            if (side != "BUY" && side != "SELL") {
+                return error(400, "InputException", "Invalid `transaction_type`.");
+            }
+            if (order_type.empty()) {
+                return error(400, "InputException", "Missing `order_type`.");
+            }
+            if (product != "CNC" && product != "MIS" && product != "NRML") {
+                return error(400, "InputException", "Invalid `product`.");
+            }
+            if (!parse_qty(param(params, "quantity"), 0, qty)) {
+                update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+                return error(400, "InputException", "Invalid `quantity`.");
+            }
+            if (!market && !parse_price(param(params, "price"), 2, price)) {
+                update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+                return error(400, "InputException", "Invalid `price`.");
+            }
+
+            auto& order = add_order(static_cast<size_t>(instrument), side == "BUY" ? Common::Side::BUY : Common::Side::SELL, market,
+                                    validity.empty() ? "DAY" : validity, price, qty, param(params, "tag"));
+            order.product = product;
+
+            // The RMS accepts the request and rejects the order afterwards, as Kite does for prices outside the circuit
+            const auto last = last_price(order.instrument);
+            if (!market && std::abs(price - last) * 100 > last * KITE_CIRCUIT_PERCENT) {
+                order.status_message = "RMS:Rule: Check circuit limit including square off order exceeds";
+                set_status(order, OrderStatus::REJECTED);
+                update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+            } else {
+                submit(order);
+            }
+            return success({{"order_id", std::to_string(order.order_id)}});
+        }
+
+        uint64_t order_id = 0;
+        const auto itr = (parse_integer(segments[2], order_id) ? orders_.find(order_id) : orders_.end());
+        if (itr == orders_.end()) {
+            update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+            return error(400, "InputException", "Couldn't find that `order_id`.");
+        }
+        auto& order = itr->second;
+
+        if (request.method == "DELETE") {
+            if (!cancel(order)) {
+                update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+                return error(400, "InputException", "Order cannot be cancelled as it is being processed or is complete.");
+            }
+            return success({{"order_id", std::to_string(order.order_id)}});
+        }
+
+        // Modify - absent parameters keep their current value
+        Common::Qty qty = order.qty;
+        Common::Price price = order.price;
+        if (order_type == "MARKET" || order.market) {
+            return error(400, "InputException", "Only the price and quantity of LIMIT orders can be modified.");
+        }
+        if ((params.count("quantity") && !parse_qty(param(params, "quantity"), 0, qty)) ||
+            (params.count("price") && !parse_price(param(params, "price"), 2, price))) {
+            update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+            return error(400, "InputException", "Invalid `price` or `quantity`.");
+        }
+        if (!modify(order, price, qty)) {
+            update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+            return error(400, "InputException", "Order cannot be modified as it is being processed or is complete.");
+        }
+        return success({{"order_id", std::to_string(order.order_id)}});
+    }
+
+    if (request.method != "GET") {
+        return error(405, "GeneralException", "Method not allowed");
+    }
+
+    // GET /orders lists the day's orders oldest first, GET /orders/{order_id} is the history of one order,
+    // GET /orders/{order_id}/trades its executions
+    if (segments.size() == 1) {
+        std::vector<const RestOrder*> sorted;
+        for (const auto& [id, order] : orders_) {
+            sorted.push_back(&order);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const RestOrder* lhs, const RestOrder* rhs) { return lhs->order_id < rhs->order_id; });
+        auto data = nlohmann::json::array();
+        for (const auto order : sorted) {
+            data.push_back(kite_order(*order));
+        }
+        return success(data);
+    }
+
+    uint64_t order_id = 0;
+    const auto itr = (parse_integer(segments[1], order_id) ? orders_.find(order_id) : orders_.end());
+    if (itr == orders_.end() || segments.size() > 3 || (segments.size() == 3 && segments[2] != "trades")) {
+        return error(400, "InputException", "Couldn't find that `order_id`.");
+    }
+    const auto& order = itr->second;
+    if (segments.size() == 2) {
+        return success(order.history);
+    }
+
+    const auto& instrument = config_.instruments[order.instrument];
+    auto trades = nlohmann::json::array();
+    for (size_t i = 0; i < order.fills.size(); ++i) {
+        trades.push_back({{"trade_id", std::to_string(order.order_id % 100000000 * 100 + i + 1)},
+                          {"order_id", std::to_string(order.order_id)},
+                          {"exchange", "NSE"},
+                          {"tradingsymbol", instrument.symbol},
+                          {"instrument_token", instrument.instrument_token},
+                          {"product", order.product},
+                          {"average_price", static_cast<double>(order.fills[i].first) / 100.0},
+                          {"quantity", order.fills[i].second},
+                          {"transaction_type", order.side == Common::Side::BUY ? "BUY" : "SELL"},
+                          {"fill_timestamp", kite_time(order.updated_ms)}});
+    }
+    return success(trades);
+}
+
+RestOrderEntrySimulator::RestResponse RestOrderEntrySimulator::handle_binance(const RestRequest& request) {
+    const auto error = [](unsigned status, int code, const std::string& message) {
+        nlohmann::json body = {{"code", code}, {"msg", message}};
+        return RestResponse{status, body.dump()};
+    };
+    const auto missing = [&error](const std::string& name) {
+        return error(400, -1102, "Mandatory parameter '" + name + "' was not sent, was empty/null, or malformed.");
+    };
+
+    const auto query_start = request.target.find('?');
+    const auto path = request.target.substr(0, query_start);
+    const auto query = (query_start == std::string::npos ? std::string() : request.target.substr(query_start + 1));
+
+    // Parameters may come in the query string, the form body or both
+    auto params = parse_params(query);
+    for (auto& [name, value] : parse_params(request.body)) {
+        params[name] = value;
+    }
+
+    // Public endpoints
+    if (request.method == "GET" && path == "/api/v3/ping") {
+        return {200, "{}"};
+    }
+    if (request.method == "GET" && path == "/api/v3/time") {
+        return {200, nlohmann::json{{"serverTime", now_ms()}}.dump()};
+    }
+    if (request.method == "GET" && (path == "/api/v3/ticker/price" || path == "/api/v3/exchangeInfo")) {
+        const auto instrument = find_instrument(param(params, "symbol"));
+        if (instrument < 0) {
+            return error(400, -1121, "Invalid symbol.");
+        }
+        if (path == "/api/v3/exchangeInfo") {
+            return {200, binance_exchange_info(param(params, "symbol"))};
+        }
+        return {200, nlohmann::json{{"symbol", param(params, "symbol")},
+                                    {"price", binance_price(last_price(static_cast<size_t>(instrument)))}}.dump()};
+    }
+
+    if (path != "/api/v3/order" && path != "/api/v3/order/cancelReplace" && path != "/api/v3/openOrders") {
+        return error(404, -1, "Unknown endpoint.");
+    }
+
+    // Signed endpoints: API key, HMAC-SHA256 of the query string followed by the body, and a fresh timestamp
+    const auto api_key = request.headers.find("x-mbx-apikey");
+    if (api_key == request.headers.end() || api_key->second.empty()) {
+        update_stats([](RestSimulatorStats& stats) { ++stats.auth_failures; });
+        return error(401, -2014, "API-key format invalid.");
+    }
+    if (api_key->second != config_.api_key) {
+        update_stats([](RestSimulatorStats& stats) { ++stats.auth_failures; });
+        return error(401, -2015, "Invalid API-key, IP, or permissions for action.");
+    }
+
+    const auto signature = param(params, "signature");
+    if (signature.empty()) {
+        update_stats([](RestSimulatorStats& stats) { ++stats.signature_failures; });
+        return missing("signature");
+    }
+    auto total_params = query + request.body;
+    for (const auto& signature_param : {"&signature=" + signature, "signature=" + signature + "&", "signature=" + signature}) {
+        const auto pos = total_params.find(signature_param);
+        if (pos != std::string::npos) {
+            total_params.erase(pos, signature_param.size());
+            break;
+        }
+    }
+    auto signature_lower = signature;
+    std::transform(signature_lower.begin(), signature_lower.end(), signature_lower.begin(), ::tolower);
+    if (hmac_sha256_hex(config_.api_secret, total_params) != signature_lower) {
+        update_stats([](RestSimulatorStats& stats) { ++stats.signature_failures; });
+        return error(400, -1022, "Signature for this request is not valid.");
+    }
+
+    uint64_t timestamp = 0;
+    uint64_t recv_window = static_cast<uint64_t>(config_.recv_window.count());
+    if (!parse_integer(param(params, "timestamp"), timestamp)) {
+        update_stats([](RestSimulatorStats& stats) { ++stats.signature_failures; });
+        return missing("timestamp");
+    }
+    if (params.count("recvWindow") && (!parse_integer(param(params, "recvWindow"), recv_window) || recv_window > 60000)) {
+        return error(400, -1131, "recvWindow must be less than 60000");
+    }
+    const auto now = static_cast<uint64_t>(now_ms());
+    if (timestamp > now + 1000 || (now > timestamp && now - timestamp > recv_window)) {
+        update_stats([](RestSimulatorStats& stats) { ++stats.signature_failures; });
+        return error(400, -1021, "Timestamp for this request is outside of the recvWindow.");
+    }
+
+    const auto symbol = param(params, "symbol");
+    const auto instrument = find_instrument(symbol);
+
+    if (path == "/api/v3/openOrders") {
+        if (request.method != "GET") {
+            return error(405, -1, "Method not allowed.");
+        }
+        if (!symbol.empty() && instrument < 0) {
+            return error(400, -1121, "Invalid symbol.");
+        }
+        std::vector<const RestOrder*> open;
+        for (const auto& [id, order] : orders_) {
+            if ((order.status == OrderStatus::NEW || order.status == OrderStatus::PARTIALLY_FILLED) &&
+                (symbol.empty() || static_cast<int>(order.instrument) == instrument)) {
+                open.push_back(&order);
+            }
+        }
+        std::sort(open.begin(), open.end(), [](const RestOrder* lhs, const RestOrder* rhs) { return lhs->order_id < rhs->order_id; });
+        auto body = nlohmann::json::array();
+        for (const auto order : open) {
+            body.push_back(binance_order(*order, false));
+        }
+        return {200, body.dump()};
+    }
+
+    if (symbol.empty()) {
+        return missing("symbol");
+    }
+    if (instrument < 0) {
+        update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+        return error(400, -1121, "Invalid symbol.");
+    }
+
+    if (request.method == "POST" || request.method == "DELETE") {
+        unsigned retry_after = 0;
+        if (!take_rate_limit(retry_after)) {
+            update_stats([](RestSimulatorStats& stats) { ++stats.rate_limited; });
+            auto response = error(429, -1015, "Too many new orders; current limit is " + std::to_string(config_.order_rate_limit) +
+                                              " orders per " + std::to_string(config_.rate_limit_window.count()) + " ms.");
+            response.retry_after = retry_after;
+            return response;
+        }
+    }
+
+    // New orders are validated against the filters served by exchangeInfo before reaching the matching engine
+    const auto place_order = [&](RestOrder*& placed) -> RestResponse {
+        const auto side = param(params, "side");
+        const auto type = param(params, "type");
+        const auto time_in_force = param(params, "timeInForce");
+        const auto client_order_id = param(params, "newClientOrderId");
+        Common::Qty qty = 0;
+        Common::Price price = 0;
+
+        if (side.empty()) {
+            return missing("side");
+        }
+        if (side != "BUY" && side != "SELL") {
+            return error(400, -1117, "Invalid side.");
+        }
+        if (type.empty()) {
+            return missing("type");
+        }
+        if (type != "LIMIT" && type != "MARKET") {
+            return error(400, -1116, "Invalid orderType.");
+        }
+        const bool market = (type == "MARKET");
+        if (!market && time_in_force.empty()) {
+            return missing("timeInForce");
+        }
+        if (!market && time_in_force != "GTC" && time_in_force != "IOC") {
+            return error(400, -1115, "Invalid timeInForce.");
+        }
+        if (!params.count("quantity")) {
+            return missing("quantity");
+        }
+        if (!parse_qty(param(params, "quantity"), 3, qty)) {
+            update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+            return error(400, -1013, "Filter failure: LOT_SIZE");
+        }
+        if (!market) {
+            if (!params.count("price")) {
+                return missing("price");
+            }
+            if (!parse_price(param(params, "price"), 2, price)) {
+                update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+                return error(400, -1013, "Filter failure: PRICE_FILTER");
+            }
+
+            // PERCENT_PRICE_BY_SIDE of the exchangeInfo served above: within 0.2x to 5x of the last price
+            const auto last = last_price(static_cast<size_t>(instrument));
+            if (price * 5 < last || price > last * 5) {
+                update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+                return error(400, -1013, "Filter failure: PERCENT_PRICE_BY_SIDE");
+            }
+        }
+        if (!client_order_id.empty()) {
+            for (const auto& [id, order] : orders_) {
+                if (order.client_order_id == client_order_id &&
+                    (order.status == OrderStatus::NEW || order.status == OrderStatus::PARTIALLY_FILLED)) {
+                    update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+                    return error(400, -2010, "Duplicate order sent.");
+                }
+            }
+        }
+
+        auto& order = add_order(static_cast<size_t>(instrument), side == "BUY" ? Common::Side::BUY : Common::Side::SELL, market,
+                                market ? "GTC" : time_in_force, price, qty, client_order_id);
+        submit(order);
+        placed = &order;
+        return {200, binance_order(order, true).dump()};
+    };
+
+    // Existing orders are found by orderId or origClientOrderId - cancelReplace prefixes both with "cancel"
+    const auto find_order = [&](const std::string& id_name, const std::string& client_id_name) -> RestOrder* {
+        RestOrder* order = nullptr;
+        uint64_t order_id = 0;
+        if (params.count(id_name)) {
+            const auto itr = (parse_integer(param(params, id_name), order_id) ? orders_.find(order_id) : orders_.end());
+            order = (itr == orders_.end() || static_cast<int>(itr->second.instrument) != instrument ? nullptr : &itr->second);
+        } else {
+            for (auto& [id, candidate] : orders_) {
+                if (candidate.client_order_id == param(params, client_id_name) && static_cast<int>(candidate.instrument) == instrument &&
+                    (!order || candidate.order_id > order->order_id)) {
+                    order = &candidate;
+                }
+            }
+        }
+        return order;
+    };
+    const auto cancel_response = [](const RestOrder& order, nlohmann::json body) {
+        body["origClientOrderId"] = order.client_order_id;
+        body["transactTime"] = order.updated_ms;
+        return body;
+    };
+
+    if (path == "/api/v3/order/cancelReplace") {
+        if (request.method != "POST") {
+            return error(405, -1, "Method not allowed.");
+        }
+        const auto mode = param(params, "cancelReplaceMode");
+        if (mode.empty()) {
+            return missing("cancelReplaceMode");
+        }
+        if (mode != "STOP_ON_FAILURE" && mode != "ALLOW_FAILURE") {
+            return error(400, -1145, "Invalid cancelReplaceMode.");
+        }
+        if (!params.count("cancelOrderId") && !params.count("cancelOrigClientOrderId")) {
+            return error(400, -1102, "Param 'cancelOrigClientOrderId' or 'cancelOrderId' must be sent, but both were empty/null!");
+        }
+
+        // The cancel goes first; STOP_ON_FAILURE only places the replacement if it succeeded
+        auto cancelled = find_order("cancelOrderId", "cancelOrigClientOrderId");
+        nlohmann::json data;
+        if (!cancelled || !cancel(*cancelled)) {
+            update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+            cancelled = nullptr;
+            data["cancelResult"] = "FAILURE";
+            data["cancelResponse"] = {{"code", -2011}, {"msg", "Unknown order sent."}};
+        } else {
+            data["cancelResult"] = "SUCCESS";
+            data["cancelResponse"] = cancel_response(*cancelled, binance_order(*cancelled, false));
+        }
+        if (!cancelled && mode == "STOP_ON_FAILURE") {
+            data["newOrderResult"] = "NOT_ATTEMPTED";
+            data["newOrderResponse"] = nullptr;
+            return {400, nlohmann::json{{"code", -2022}, {"msg", "Order cancel-replace failed."}, {"data", data}}.dump()};
+        }
+
+        RestOrder* placed = nullptr;
+        const auto placement = place_order(placed);
+        data["newOrderResult"] = (placed ? "SUCCESS" : "FAILURE");
+        data["newOrderResponse"] = nlohmann::json::parse(placement.body);
+        if (!cancelled || !placed) {
+            const bool partial = (cancelled || placed);
+            return {partial ? 409u : 400u, nlohmann::json{{"code", partial ? -2021 : -2022},
+                                                          {"msg", partial ? "Order cancel-replace partially failed." : "Order cancel-replace failed."},
+                                                          {"data", data}}.dump()};
+        }
+        return {200, data.dump()};
+    }
+
+    if (request.method == "POST") {
+        RestOrder* placed = nullptr;
+        return place_order(placed);
+    }
+
+    if (!params.count("orderId") && !params.count("origClientOrderId")) {
+        return error(400, -1102, "Param 'origClientOrderId' or 'orderId' must be sent, but both were empty/null!");
+    }
+    auto order = find_order("orderId", "origClientOrderId");
+
+    if (request.method == "GET") {
+        if (!order) {
+            return error(400, -2013, "Order does not exist.");
+        }
+        return {200, binance_order(*order, false).dump()};
+    }
+    if (request.method == "DELETE") {
+        if (!order || !cancel(*order)) {
+            update_stats([](RestSimulatorStats& stats) { ++stats.rejects; });
+            return error(400, -2011, "Unknown order sent.");
+        }
+        return {200, cancel_response(*order, binance_order(*order, false)).dump()};
+    }
+    return error(405, -1, "Method not allowed.");
+}
+
+RestOrderEntrySimulator::RestOrder& RestOrderEntrySimulator::add_order(size_t instrument, Common::Side side, bool market,
+                                                                       const std::string& time_in_force, Common::Price price,
+                                                                       Common::Qty qty, const std::string& client_order_id) {
+    const auto order_id = next_order_id_++;
+    auto& order = orders_[order_id];
+    order.order_id = order_id;
+    order.instrument = instrument;
+    order.client_order_id = (client_order_id.empty() && config_.protocol == SimProtocol::BINANCE
+                             ? "sim" + std::to_string(order_id) : client_order_id);
+    order.side = side;
+    order.market = market;
+    order.time_in_force = time_in_force;
+    order.price = price;
+    order.qty = qty;
+    order.created_ms = order.updated_ms = now_ms();
+
+    // Kite's history starts with the states of the request before it reaches the exchange
+    if (config_.protocol == SimProtocol::KITE) {
+        for (const auto status : {"PUT ORDER REQ RECEIVED", "VALIDATION PENDING", "OPEN PENDING"}) {
+            auto entry = kite_order(order);
+            entry["status"] = status;
+            order.history.push_back(entry);
+        }
+    }
+
+    logger_->log("%:% %() % Order % % % % @ % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 order_id, config_.instruments[instrument].symbol, Common::sideToString(side), qty,
+                 market ? std::string("MARKET") : std::to_string(price), time_in_force);
+    return order;
+}
+
+void RestOrderEntrySimulator::submit(RestOrder& order) {
+    update_stats([](RestSimulatorStats& stats) { ++stats.orders_placed; });
+    set_status(order, OrderStatus::NEW);
+
+    const auto price = (!order.market ? order.price : order.side == Common::Side::BUY ? MARKET_BUY_PRICE : 0);
+    send(order, Exchange::ClientRequestType::NEW, price, order.qty);
+
+    // What a MARKET or IOC order could not take right away expires
+    if ((order.market || order.time_in_force == "IOC") &&
+        (order.status == OrderStatus::NEW || order.status == OrderStatus::PARTIALLY_FILLED)) {
+        send(order, Exchange::ClientRequestType::CANCEL, price, 0);
+        order.status = OrderStatus::EXPIRED;
+    }
+}
+
+bool RestOrderEntrySimulator::cancel(RestOrder& order) {
+    if (order.status != OrderStatus::NEW && order.status != OrderStatus::PARTIALLY_FILLED) {
+        return false;
+    }
+    if (send(order, Exchange::ClientRequestType::CANCEL, order.price, 0) != Exchange::ClientResponseType::CANCELED) {
+        return false;
+    }
+    update_stats([](RestSimulatorStats& stats) { ++stats.orders_cancelled; });
+    return true;
+}
+
+bool RestOrderEntrySimulator::modify(RestOrder& order, Common::Price price, Common::Qty qty) {
+    if ((order.status != OrderStatus::NEW && order.status != OrderStatus::PARTIALLY_FILLED) || qty <= order.executed_qty) {
+        return false;
+    }
+
+    // The new quantity is the order's total, the FillSimulator works the part still open
+    const auto previous_price = order.price;
+    const auto previous_qty = order.qty;
+    order.price = price;
+    order.qty = qty;
+    if (send(order, Exchange::ClientRequestType::MODIFY, price, qty - order.executed_qty) != Exchange::ClientResponseType::ACCEPTED) {
+        order.price = previous_price;
+        order.qty = previous_qty;
+        return false;
+    }
+    if (order.status == OrderStatus::NEW || order.status == OrderStatus::PARTIALLY_FILLED) {
+        set_status(order, order.status);
+    }
+    update_stats([](RestSimulatorStats& stats) { ++stats.orders_modified; });
+    return true;
+}
+
+void RestOrderEntrySimulator::set_status(RestOrder& order, OrderStatus status) {
+    order.status = status;
+    order.updated_ms = now_ms();
+    if (config_.protocol == SimProtocol::KITE) {
+        order.history.push_back(kite_order(order));
+    }
+}
+
+Exchange::ClientResponseType RestOrderEntrySimulator::send(const RestOrder& order, Exchange::ClientRequestType type,
+                                                           Common::Price price, Common::Qty qty) {
+    Exchange::MEClientRequest request;
+    request.type_ = type;
+    request.client_id_ = 0;
+    request.ticker_id_ = config_.instruments[order.instrument].ticker_id;
+    request.order_id_ = order.order_id;
+    request.side_ = order.side;
+    request.price_ = price;
+    request.qty_ = qty;
+    fills_.onClientRequest(request);
+    return apply_fill_responses(order.order_id);
+}
+
+Exchange::ClientResponseType RestOrderEntrySimulator::apply_fill_responses(uint64_t order_id) {
+    auto result = Exchange::ClientResponseType::INVALID;
+    fills_.takeResponses(&fill_responses_);
+    for (const auto& response : fill_responses_) {
+        if (response.order_id_ == order_id && response.type_ != Exchange::ClientResponseType::FILLED &&
+            result == Exchange::ClientResponseType::INVALID) {
+            result = response.type_;
+        }
+
+        const auto itr = orders_.find(response.order_id_);
+        if (itr == orders_.end()) {
+            continue;
+        }
+        auto& order = itr->second;
+        switch (response.type_) {
+            case Exchange::ClientResponseType::FILLED:
+                order.executed_qty += response.exec_qty_;
+                order.cumulative_quote += response.price_ * response.exec_qty_;
+                order.fills.emplace_back(response.price_, response.exec_qty_);
+                set_status(order, response.leaves_qty_ ? OrderStatus::PARTIALLY_FILLED : OrderStatus::FILLED);
+                update_stats([](RestSimulatorStats& stats) { ++stats.fills; });
+                break;
+            case Exchange::ClientResponseType::CANCELED:
+                set_status(order, OrderStatus::CANCELED);
+                break;
+            default:
+                break;
+        }
+    }
+    fill_responses_.clear();
+    return result;
+}
+
+bool RestOrderEntrySimulator::take_rate_limit(unsigned& retry_after) {
+    if (!config_.order_rate_limit) {
+        return true;
+    }
+
+    const auto now = Common::getSystemNanos();
+    const auto window = std::chrono::duration_cast<std::chrono::nanoseconds>(config_.rate_limit_window).count();
+    while (!rate_window_.empty() && now - rate_window_.front() >= window) {
+        rate_window_.pop_front();
+    }
+    if (rate_window_.size() >= config_.order_rate_limit) {
+        const auto wait = rate_window_.front() + window - now;
+        retry_after = static_cast<unsigned>(std::max<Common::Nanos>(1, (wait + Common::NANOS_TO_SECS - 1) / Common::NANOS_TO_SECS));
+        return false;
+    }
+    rate_window_.push_back(now);
+    return true;
+}
+
+std::string RestOrderEntrySimulator::status_name(OrderStatus status) const {
+    if (config_.protocol == SimProtocol::KITE) {
+        switch (status) {
+            case OrderStatus::NEW:
+            case OrderStatus::PARTIALLY_FILLED:
+                return "OPEN";
+            case OrderStatus::FILLED:
+                return "COMPLETE";
+            case OrderStatus::CANCELED:
+            case OrderStatus::EXPIRED:
+                return "CANCELLED";
+            case OrderStatus::REJECTED:
+                return "REJECTED";
+        }
+        return "UNKNOWN";
+    }
+
+    switch (status) {
+        case OrderStatus::NEW:
+            return "NEW";
+        case OrderStatus::PARTIALLY_FILLED:
+            return "PARTIALLY_FILLED";
+        case OrderStatus::FILLED:
+            return "FILLED";
+        case OrderStatus::CANCELED:
+            return "CANCELED";
+        case OrderStatus::REJECTED:
+            return "REJECTED";
+        case OrderStatus::EXPIRED:
+            return "EXPIRED";
+    }
+    return "UNKNOWN";
+}
+
+nlohmann::json RestOrderEntrySimulator::kite_order(const RestOrder& order) const {
+    const auto& instrument = config_.instruments[order.instrument];
+    const bool done = (order.status == OrderStatus::CANCELED || order.status == OrderStatus::EXPIRED ||
+                       order.status == OrderStatus::REJECTED);
+    const auto open_qty = order.qty - order.executed_qty;
+    return {{"order_id", std::to_string(order.order_id)},
+            {"exchange_order_id", order.status == OrderStatus::REJECTED ? nlohmann::json(nullptr)
+                                                                        : nlohmann::json("1" + std::to_string(order.order_id))},
+            {"status", status_name(order.status)},
+            {"status_message", order.status_message.empty() ? nlohmann::json(nullptr) : nlohmann::json(order.status_message)},
+            {"variety", "regular"},
+            {"exchange", "NSE"},
+            {"tradingsymbol", instrument.symbol},
+            {"instrument_token", instrument.instrument_token},
+            {"order_type", order.market ? "MARKET" : "LIMIT"},
+            {"transaction_type", order.side == Common::Side::BUY ? "BUY" : "SELL"},
+            {"validity", order.time_in_force},
+            {"product", order.product},
+            {"quantity", order.qty},
+            {"disclosed_quantity", 0},
+            {"price", static_cast<double>(order.price) / 100.0},
+            {"trigger_price", 0},
+            {"average_price", order.executed_qty ? static_cast<double>(order.cumulative_quote) / order.executed_qty / 100.0 : 0.0},
+            {"filled_quantity", order.executed_qty},
+            {"pending_quantity", done ? 0 : open_qty},
+            {"cancelled_quantity", done ? open_qty : 0},
+            {"order_timestamp", kite_time(order.updated_ms)},
+            {"exchange_timestamp", kite_time(order.updated_ms)},
+            {"tag", order.client_order_id.empty() ? nlohmann::json(nullptr) : nlohmann::json(order.client_order_id)}};
+}
+
+nlohmann::json RestOrderEntrySimulator::binance_order(const RestOrder& order, bool with_fills) const {
+    nlohmann::json json = {{"symbol", config_.instruments[order.instrument].symbol},
+                           {"orderId", order.order_id},
+                           {"orderListId", -1},
+                           {"clientOrderId", order.client_order_id},
+                           {"price", binance_price(order.price)},
+                           {"origQty", binance_qty(order.qty)},
+                           {"executedQty", binance_qty(order.executed_qty)},
+                           // price ticks of 0.01 times quantity steps of 0.001
+                           {"cummulativeQuoteQty", to_decimal(order.cumulative_quote, 5)},
+                           {"status", status_name(order.status)},
+                           {"timeInForce", order.time_in_force},
+                           {"type", order.market ? "MARKET" : "LIMIT"},
+                           {"side", order.side == Common::Side::BUY ? "BUY" : "SELL"},
+                           {"workingTime", order.created_ms},
+                           {"selfTradePreventionMode", "NONE"}};
+    if (with_fills) {
+        json["transactTime"] = order.updated_ms;
+        json["fills"] = nlohmann::json::array();
+        for (size_t i = 0; i < order.fills.size(); ++i) {
+            json["fills"].push_back({{"price", binance_price(order.fills[i].first)},
+                                     {"qty", binance_qty(order.fills[i].second)},
+                                     {"commission", "0.00000000"},
+                                     {"commissionAsset", "BNB"},
+                                     {"tradeId", order.order_id * 100 + i + 1}});
+        }
+    } else {
+        json["stopPrice"] = "0.00";
+        json["icebergQty"] = "0.000";
+        json["time"] = order.created_ms;
+        json["updateTime"] = order.updated_ms;
+        json["isWorking"] = true;
+    }
+    return json;
+}
+
+Common::Price RestOrderEntrySimulator::last_price(size_t instrument) const {
+    return last_prices_[instrument];
+}
+
+int RestOrderEntrySimulator::find_instrument(const std::string& symbol) const {
+    for (size_t i = 0; i < config_.instruments.size(); ++i) {
+        if (config_.instruments[i].symbol == symbol) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void RestOrderEntrySimulator::on_connection() {
+    update_stats([](RestSimulatorStats& stats) { ++stats.connections; });
+}
+
+void RestOrderEntrySimulator::on_request() {
+    update_stats([](RestSimulatorStats& stats) { ++stats.requests; });
+}
+
+} // namespace Sim
+} // namespace Adapter
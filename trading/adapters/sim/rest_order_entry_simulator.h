@@ -0,0 +1,258 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <memory>
+
+// Common utilities
+#include "common/logging.h"
+#include "common/lf_queue.h"
+#include "common/time_utils.h"
+#include "exchange/market_data/market_update.h"
+#include "exchange/order_server/client_request.h"
+#include "exchange/order_server/client_response.h"
+#include "trading/backtest/fill_simulator.h"
+#include "trading/adapters/sim/ws_exchange_simulator.h"
+
+// Boost.Beast includes
+#include <boost/beast/core.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <nlohmann/json.hpp>
+
+namespace Adapter {
+namespace Sim {
+
+/**
+ * Configuration of a RestOrderEntrySimulator
+ */
+struct RestOrderEntrySimulatorConfig {
+    SimProtocol protocol = SimProtocol::KITE;
+
+    // Listening address, port 0 picks a free one (see RestOrderEntrySimulator::port())
+    std::string address = "127.0.0.1";
+    uint16_t port = 0;
+
+    // Tradable instruments - symbol is the Kite tradingsymbol (exchange NSE) or the Binance symbol, start_price the
+    // last price served before any market update arrived
+    std::vector<SimInstrument> instruments;
+
+    // Credentials requests are checked against: Kite's "Authorization: token api_key:access_token" header, Binance's
+    // X-MBX-APIKEY header and the HMAC-SHA256 signature keyed with api_secret
+    std::string api_key = "sim_api_key";
+    std::string api_secret = "sim_api_secret";
+    std::string access_token = "sim_access_token";
+
+    // Order requests (place, modify, cancel) accepted per rate_limit_window, 0 for no limit
+    size_t order_rate_limit = 0;
+    std::chrono::milliseconds rate_limit_window{1000};
+
+    // Binance requests signed longer than this ago are rejected
+    std::chrono::milliseconds recv_window{5000};
+
+    // Venue processing time added before every response
+    std::chrono::microseconds response_delay{0};
+};
+
+/**
+ * Counters of a RestOrderEntrySimulator, all since start()
+ */
+struct RestSimulatorStats {
+    size_t connections = 0;         // TLS connections accepted
+    size_t requests = 0;            // HTTP requests served, keep-alive requests included
+    size_t orders_placed = 0;
+    size_t orders_modified = 0;
+    size_t orders_cancelled = 0;
+    size_t fills = 0;               // Executions, partial ones included
+    size_t rejects = 0;             // Order requests refused for their content - unknown symbol, bad price, unknown order
+    size_t auth_failures = 0;       // Missing or wrong API key / access token
+    size_t signature_failures = 0;  // Binance signature mismatches and stale timestamps
+    size_t rate_limited = 0;        // Order requests refused with 429
+
+    std::string toString() const;
+};
+
+class RestConnection;
+
+/**
+ * RestOrderEntrySimulator - Local HTTPS server impersonating a venue's order entry REST API
+ *
+ * Speaks the Kite Connect order endpoints or the Binance spot order endpoints, checks credentials,
+ * signatures and the order rate limit the way the venue does, and runs the orders through the
+ * backtester's FillSimulator, so lifecycles (NEW, PARTIALLY_FILLED, FILLED, CANCELED, REJECTED) follow
+ * the book built from on_market_update(). Keep-alive connections are served by one thread, so the
+ * venue side is deterministic for a given sequence of requests and market updates.
+ */
+class RestOrderEntrySimulator {
+public:
+    /**
+     * Constructor
+     *
+     * @param config Protocol, instruments, credentials and limits
+     * @param logger Logger for connection and order events
+     */
+    RestOrderEntrySimulator(const RestOrderEntrySimulatorConfig& config, Common::Logger* logger);
+
+    /**
+     * Destructor - Stops the server
+     */
+    ~RestOrderEntrySimulator();
+
+    /**
+     * Listen and start the simulator thread
+     */
+    void start();
+
+    /**
+     * Close every connection and stop the simulator thread
+     */
+    void stop();
+
+    /**
+     * Port the server listens on, known once start() returns
+     */
+    uint16_t port() const { return port_; }
+
+    /**
+     * Feed an update of the market the orders trade against, from a single publishing thread
+     *
+     * @param update Order level update of an instrument's ticker, crossing resting orders fills them
+     */
+    void on_market_update(const Exchange::MEMarketUpdate* update);
+
+    /**
+     * Snapshot of the counters, safe to call from any thread
+     */
+    RestSimulatorStats stats() const;
+
+    // Deleted default, copy & move constructors and assignment-operators
+    RestOrderEntrySimulator() = delete;
+    RestOrderEntrySimulator(const RestOrderEntrySimulator &) = delete;
+    RestOrderEntrySimulator(const RestOrderEntrySimulator &&) = delete;
+    RestOrderEntrySimulator &operator=(const RestOrderEntrySimulator &) = delete;
+    RestOrderEntrySimulator &operator=(const RestOrderEntrySimulator &&) = delete;
+
+private:
+    friend class RestConnection;
+
+    // Venue status of an order, named per protocol by status_name()
+    enum class OrderStatus : uint8_t {
+        NEW = 0,
+        PARTIALLY_FILLED = 1,
+        FILLED = 2,
+        CANCELED = 3,
+        REJECTED = 4,
+        EXPIRED = 5     // Unfilled rest of a MARKET / IOC order
+    };
+
+    // An order as the venue keeps it, identified by its venue order id
+    struct RestOrder {
+        uint64_t order_id = 0;
+        size_t instrument = 0;
+        std::string client_order_id;    // Binance newClientOrderId / Kite tag
+        Common::Side side = Common::Side::INVALID;
+        bool market = false;
+        std::string time_in_force = "GTC";   // Binance timeInForce, Kite validity (DAY / IOC)
+        std::string product = "MIS";        // Kite product, echoed back
+        Common::Price price = 0;
+        Common::Qty qty = 0;
+        Common::Qty executed_qty = 0;
+        int64_t cumulative_quote = 0;   // Sum of price * qty of the executions
+        std::vector<std::pair<Common::Price, Common::Qty>> fills;
+        OrderStatus status = OrderStatus::NEW;
+        std::string status_message;
+        int64_t created_ms = 0;
+        int64_t updated_ms = 0;
+        std::vector<nlohmann::json> history; // Kite order history, one entry per status change
+    };
+
+    // A request as RestConnection hands it over and the response it writes back
+    struct RestRequest {
+        std::string method;
+        std::string target;
+        std::string body;
+        std::unordered_map<std::string, std::string> headers;
+    };
+    struct RestResponse {
+        unsigned status = 200;
+        std::string body;
+        unsigned retry_after = 0;       // Seconds, sent as Retry-After with a 429
+    };
+
+    void run();
+    void do_accept();
+
+    RestResponse handle(const RestRequest& request);
+    RestResponse handle_kite(const RestRequest& request);
+    RestResponse handle_binance(const RestRequest& request);
+
+    // Order operations on the FillSimulator, the order's state follows its responses
+    RestOrder& add_order(size_t instrument, Common::Side side, bool market, const std::string& time_in_force,
+                         Common::Price price, Common::Qty qty, const std::string& client_order_id);
+    void submit(RestOrder& order);
+    bool cancel(RestOrder& order);
+    bool modify(RestOrder& order, Common::Price price, Common::Qty qty);
+    void set_status(RestOrder& order, OrderStatus status);
+
+    // Pass a request to the FillSimulator and apply its responses, returns the answer to it - ACCEPTED, CANCELED or a reject
+    Exchange::ClientResponseType send(const RestOrder& order, Exchange::ClientRequestType type, Common::Price price, Common::Qty qty);
+
+    // Apply the FillSimulator's responses, returns the first one to order_id which is not an execution
+    Exchange::ClientResponseType apply_fill_responses(uint64_t order_id = 0);
+    size_t drain_market_updates();
+
+    // Whether one more order request fits the rate limit, otherwise the seconds until it does
+    bool take_rate_limit(unsigned& retry_after);
+
+    std::string status_name(OrderStatus status) const;
+    nlohmann::json kite_order(const RestOrder& order) const;
+    nlohmann::json binance_order(const RestOrder& order, bool with_fills) const;
+    Common::Price last_price(size_t instrument) const;
+    int find_instrument(const std::string& symbol) const;
+
+    void on_connection();
+    void on_request();
+
+    template<typename F>
+    void update_stats(F&& f) {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        f(stats_);
+    }
+
+    const RestOrderEntrySimulatorConfig config_;
+    Common::Logger* logger_;
+    std::string time_str_;
+
+    boost::asio::io_context ioc_;
+    boost::asio::ssl::context ssl_ctx_{boost::asio::ssl::context::tlsv12_server};
+    boost::asio::ip::tcp::acceptor acceptor_{ioc_};
+    uint16_t port_ = 0;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::vector<std::weak_ptr<RestConnection>> connections_;
+
+    // Venue state, only touched by the simulator thread
+    Trading::FillSimulator fills_;
+    std::vector<Exchange::MEClientResponse> fill_responses_;
+    std::unordered_map<uint64_t, RestOrder> orders_;
+    std::unordered_map<Common::TickerId, size_t> ticker_to_instrument_;
+    std::vector<Common::Price> last_prices_;
+    Common::LFQueue<Exchange::MEMarketUpdate> me_updates_;
+    uint64_t next_order_id_ = 1;
+
+    // Order request times within the current rate limit window
+    std::deque<Common::Nanos> rate_window_;
+
+    mutable std::mutex stats_mutex_;
+    RestSimulatorStats stats_;
+};
+
+} // namespace Sim
+} // namespace Adapter
@@ -0,0 +1,128 @@
+#include "trading/adapters/sim/sim_common.h"
+
+#include <cctype>
+#include <sstream>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <openssl/ec.h>
+#include <openssl/obj_mac.h>
+#include <openssl/ssl.h>
+
+#include "common/macros.h"
+#include "common/fixed_point.h"
+
+namespace Adapter {
+namespace Sim {
+
+void use_self_signed_certificate(boost::asio::ssl::context& ctx) {
+    EVP_PKEY* key = nullptr;
+    auto key_ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    const bool key_ok = key_ctx && EVP_PKEY_keygen_init(key_ctx) > 0 &&
+                        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_ctx, NID_X9_62_prime256v1) > 0 &&
+                        EVP_PKEY_keygen(key_ctx, &key) > 0;
+    EVP_PKEY_CTX_free(key_ctx);
+    ASSERT(key_ok, "Could not generate the simulator's key");
+
+    auto cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 365L * 24 * 3600);
+    X509_set_pubkey(cert, key);
+    auto name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    const bool cert_ok = X509_sign(cert, key, EVP_sha256()) > 0 &&
+                         SSL_CTX_use_certificate(ctx.native_handle(), cert) == 1 &&
+                         SSL_CTX_use_PrivateKey(ctx.native_handle(), key) == 1;
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    ASSERT(cert_ok, "Could not make the simulator's certificate");
+}
+
+std::string to_decimal(int64_t value, int decimals) {
+    const auto magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    const auto digits = std::to_string(magnitude);
+    const auto fraction_digits = static_cast<size_t>(decimals);
+    const auto integer_digits = digits.size() > fraction_digits ? digits.size() - fraction_digits : size_t{0};
+
+    std::string decimal;
+    decimal.reserve(digits.size() + fraction_digits + 3);
+    if (value < 0) {
+        decimal += '-';
+    }
+    if (!integer_digits) {
+        decimal += '0';
+    }
+    decimal.append(digits, 0, integer_digits);
+    if (fraction_digits) {
+        decimal += '.';
+        decimal.append(fraction_digits - (digits.size() - integer_digits), '0');
+        decimal.append(digits, integer_digits, std::string::npos);
+    }
+    return decimal;
+}
+
+std::string binance_exchange_info(const std::string& symbol) {
+    return "{\"timezone\":\"UTC\",\"symbols\":[{\"symbol\":\"" + symbol + "\",\"status\":\"TRADING\","
+           "\"orderTypes\":[\"LIMIT\",\"MARKET\"],\"filters\":["
+           "{\"filterType\":\"PRICE_FILTER\",\"minPrice\":\"0.01000000\",\"maxPrice\":\"1000000.00000000\",\"tickSize\":\"0.01000000\"},"
+           "{\"filterType\":\"LOT_SIZE\",\"minQty\":\"0.00100000\",\"maxQty\":\"9000.00000000\",\"stepSize\":\"0.00100000\"},"
+           "{\"filterType\":\"PERCENT_PRICE_BY_SIDE\",\"bidMultiplierUp\":\"5\",\"bidMultiplierDown\":\"0.2\","
+           "\"askMultiplierUp\":\"5\",\"askMultiplierDown\":\"0.2\",\"avgPriceMins\":5}]}]}";
+}
+
+bool parse_decimal(const std::string& str, int decimals, int64_t& value) {
+    const auto dot = str.find('.');
+    const auto integer_digits = (dot == std::string::npos ? str.size() : dot);
+    if (!integer_digits || integer_digits > 12 || str.find_first_not_of("0123456789.") != std::string::npos ||
+        (dot != std::string::npos && str.find('.', dot + 1) != std::string::npos)) {
+        return false;
+    }
+    if (dot != std::string::npos && str.size() > dot + 1 + static_cast<size_t>(decimals) &&
+        str.find_first_not_of('0', dot + 1 + static_cast<size_t>(decimals)) != std::string::npos) {
+        return false;
+    }
+    value = Common::parseDecimal(str, static_cast<uint8_t>(decimals));
+    return true;
+}
+
+std::unordered_map<std::string, std::string> parse_params(const std::string& params) {
+    const auto decode = [](const std::string& value) {
+        std::string decoded;
+        decoded.reserve(value.size());
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] == '+') {
+                decoded += ' ';
+            } else if (value[i] == '%' && i + 2 < value.size() &&
+                       std::isxdigit(static_cast<unsigned char>(value[i + 1])) &&
+                       std::isxdigit(static_cast<unsigned char>(value[i + 2]))) {
+                decoded += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            } else {
+                decoded += value[i];
+            }
+        }
+        return decoded;
+    };
+
+    std::unordered_map<std::string, std::string> parsed;
+    std::istringstream iss(params);
+    std::string param;
+    while (std::getline(iss, param, '&')) {
+        const auto equals = param.find('=');
+        if (equals != std::string::npos) {
+            parsed[param.substr(0, equals)] = decode(param.substr(equals + 1));
+        }
+    }
+    return parsed;
+}
+
+std::unordered_map<std::string, std::string> query_params(const std::string& target) {
+    const auto query = target.find('?');
+    return query == std::string::npos ? std::unordered_map<std::string, std::string>{} : parse_params(target.substr(query + 1));
+}
+
+} // namespace Sim
+} // namespace Adapter
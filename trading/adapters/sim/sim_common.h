@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "common/types.h"
+
+#include <boost/asio/ssl/context.hpp>
+
+namespace Adapter {
+namespace Sim {
+
+/**
+ * Self-signed certificate for "localhost", made at start so the tree holds no key material
+ *
+ * @param ctx Server context the certificate and its key are installed in
+ */
+void use_self_signed_certificate(boost::asio::ssl::context& ctx);
+
+/**
+ * Fixed-point value as a decimal string, e.g. 123456 with 2 decimals -> "1234.56"
+ */
+std::string to_decimal(int64_t value, int decimals);
+
+/**
+ * Binance prices are in 0.01 ticks, quantities in 0.001 steps - the exchangeInfo filters both simulators serve
+ */
+inline std::string binance_price(Common::Price price) { return to_decimal(price, 2); }
+inline std::string binance_qty(Common::Qty qty) { return to_decimal(qty, 3); }
+
+/**
+ * /api/v3/exchangeInfo response for one symbol, with the PRICE_FILTER, LOT_SIZE and PERCENT_PRICE_BY_SIDE filters
+ * matching the units above
+ */
+std::string binance_exchange_info(const std::string& symbol);
+
+/**
+ * Decimal string to fixed-point, false unless it is a plain non-negative number without digits beyond decimals
+ * other than trailing zeros - "2500.05000000" parses with 2 decimals, "2500.055" does not
+ */
+bool parse_decimal(const std::string& str, int decimals, int64_t& value);
+
+/**
+ * Parameters of a query string or form body, e.g. "symbol=BTCUSDT&limit=1000", values URL decoded
+ */
+std::unordered_map<std::string, std::string> parse_params(const std::string& params);
+
+/**
+ * Query parameters of a request target, e.g. "/api/v3/depth?symbol=BTCUSDT&limit=1000"
+ */
+std::unordered_map<std::string, std::string> query_params(const std::string& target);
+
+} // namespace Sim
+} // namespace Adapter
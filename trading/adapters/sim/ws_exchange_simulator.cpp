@@ -0,0 +1,973 @@
+#include "trading/adapters/sim/ws_exchange_simulator.h"
+#include "trading/adapters/sim/sim_common.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <unordered_set>
+
+#include <arpa/inet.h>
+
+#include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+#include <nlohmann/json.hpp>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+using tcp = boost::asio::ip::tcp;
+
+namespace Adapter {
+namespace Sim {
+
+namespace {
+    // Kite FULL mode packet: 64 bytes of quote fields then 5 bid and 5 ask depth entries of 12 bytes
+    constexpr size_t KITE_FULL_PACKET_SIZE = 184;
+
+    // Messages a saturating source keeps queued for every session
+    constexpr size_t SATURATION_BACKLOG = 16;
+
+    // Most messages produced per loop iteration, so the server side keeps being served
+    constexpr size_t MAX_BURST = 256;
+
+    // Levels kept around the synthetic mid on each side
+    constexpr Common::Price SYNTHETIC_LEVELS = 10;
+
+    void put_int(char* data, int32_t value) {
+        const auto network = static_cast<int32_t>(htonl(static_cast<uint32_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    void put_short(char* data, int16_t value) {
+        const auto network = static_cast<int16_t>(htons(static_cast<uint16_t>(value)));
+        std::memcpy(data, &network, sizeof(network));
+    }
+
+    std::string lower(std::string value) {
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        return value;
+    }
+}
+
+std::string simProtocolToString(SimProtocol protocol) {
+    switch (protocol) {
+        case SimProtocol::KITE:
+            return "KITE";
+        case SimProtocol::BINANCE:
+            return "BINANCE";
+    }
+    return "UNKNOWN";
+}
+
+std::string simSourceToString(SimSource source) {
+    switch (source) {
+        case SimSource::SYNTHETIC:
+            return "SYNTHETIC";
+        case SimSource::MATCHING_ENGINE:
+            return "MATCHING_ENGINE";
+        case SimSource::JOURNAL:
+            return "JOURNAL";
+    }
+    return "UNKNOWN";
+}
+
+std::string WsSimulatorStats::toString() const {
+    std::ostringstream ss;
+    ss << "WsSimulatorStats["
+       << "sessions:" << sessions << " active:" << active_sessions
+       << " generated:" << messages_generated << " sent:" << messages_sent << " bytes:" << bytes_sent
+       << " rest:" << rest_requests << " control:" << control_messages << " control-max-tokens:" << max_control_tokens
+       << " disconnects:" << disconnects << " gaps:" << gaps << " stalls:" << stalls
+       << " slow-drops:" << slow_consumer_drops << " max-backlog:" << max_backlog
+       << " reconnects:" << reconnects << " reconnect-max:" << max_reconnect_time / Common::NANOS_TO_MICROS << "us"
+       << " resyncs:" << resyncs << " resync-max:" << max_resync_time / Common::NANOS_TO_MICROS << "us"
+       << "]";
+    return ss.str();
+}
+
+/**
+ * An upgraded WebSocket connection: its subscriptions, outbound backlog and asynchronous write chain
+ */
+class SimSession : public std::enable_shared_from_this<SimSession> {
+public:
+    SimSession(WsExchangeSimulator* simulator, beast::ssl_stream<beast::tcp_stream>&& stream)
+        : simulator_(simulator), ws_(std::move(stream)) {}
+
+    void accept(http::request<http::string_body>&& request) {
+        request_ = std::move(request);
+        target_ = std::string(request_.target());
+        ws_.async_accept(request_, beast::bind_front_handler(&SimSession::on_accept, shared_from_this()));
+    }
+
+    // Queue a message, dropping the session once its backlog passes the configured limit
+    void send(const std::shared_ptr<const std::string>& message, bool binary, bool heartbeat = false) {
+        if (closed_) {
+            return;
+        }
+        queue_.push_back({message, binary, heartbeat});
+        const auto backlog = queue_.size();
+        simulator_->update_stats([backlog](WsSimulatorStats& stats) { stats.max_backlog = std::max(stats.max_backlog, backlog); });
+        if (backlog > simulator_->config_.max_backlog) {
+            simulator_->update_stats([](WsSimulatorStats& stats) { ++stats.slow_consumer_drops; });
+            kick("slow consumer");
+            return;
+        }
+        if (!writing_) {
+            do_write();
+        }
+    }
+
+    // Drop the connection the way a venue or a network failure would - no close handshake
+    void kick(const char* reason) {
+        if (closed_) {
+            return;
+        }
+        std::string time_str;
+        simulator_->logger_->log("%:% %() % Dropping session % (%)\n", __FILE__, __LINE__, __FUNCTION__,
+                                 Common::getCurrentTimeStr(&time_str), target_, reason);
+        beast::get_lowest_layer(ws_).close();
+        close(true);
+    }
+
+    // A 1 byte binary heartbeat when nothing was written for the interval, as Kite does - subscribed or not
+    void heartbeat(Common::Nanos now, Common::Nanos interval) {
+        static const auto HEARTBEAT = std::make_shared<const std::string>(1, '\0');
+        if (open_ && !closed_ && queue_.empty() && now - last_write_ >= interval) {
+            last_write_ = now;
+            send(HEARTBEAT, true, true);
+        }
+    }
+
+    bool ready() const { return subscribed_ && !closed_; }
+    bool closed() const { return closed_; }
+    size_t backlog() const { return queue_.size(); }
+    const std::string& key() const { return target_; }
+
+    // Binance streams are per symbol and stream type, Kite subscriptions per instrument token
+    int instrument() const { return instrument_; }
+    const std::string& stream_type() const { return stream_type_; }
+    bool subscribed_to(int32_t token) const { return tokens_.count(token) != 0; }
+
+private:
+    struct Outbound {
+        std::shared_ptr<const std::string> message;
+        bool binary = false;
+        bool heartbeat = false;
+    };
+
+    void on_accept(beast::error_code ec) {
+        if (ec) {
+            close(false);
+            return;
+        }
+        open_ = true;
+        last_write_ = Common::getSystemNanos();
+        simulator_->on_session_open(shared_from_this());
+
+        if (simulator_->config_.protocol == SimProtocol::BINANCE) {
+            // The stream is in the target, e.g. /ws/btcusdt@depth, so the session is subscribed once open
+            const auto at = target_.find('@');
+            const auto slash = target_.rfind('/', at);
+            if (at != std::string::npos && slash != std::string::npos) {
+                instrument_ = simulator_->find_instrument(target_.substr(slash + 1, at - slash - 1));
+                stream_type_ = target_.substr(at + 1);
+            }
+            subscribed_ = true;
+            simulator_->on_session_subscribed(target_);
+        }
+        do_read();
+    }
+
+    void do_read() {
+        ws_.async_read(buffer_, beast::bind_front_handler(&SimSession::on_read, shared_from_this()));
+    }
+
+    void on_read(beast::error_code ec, size_t) {
+        if (ec) {
+            close(false);
+            return;
+        }
+
+        // Kite control messages: {"a":"subscribe","v":[tokens]}, {"a":"unsubscribe",...}, {"a":"mode","v":["full",[tokens]]}
+        if (simulator_->config_.protocol == SimProtocol::KITE && ws_.got_text()) {
+            try {
+                const auto message = nlohmann::json::parse(beast::buffers_to_string(buffer_.data()));
+                const auto action = message.value("a", "");
+                const auto values = message.value("v", nlohmann::json::array());
+                const auto num_tokens = (action == "mode" && values.size() == 2 ? values[1].size() : values.size());
+                simulator_->update_stats([num_tokens](WsSimulatorStats& stats) {
+                    ++stats.control_messages;
+                    stats.max_control_tokens = std::max(stats.max_control_tokens, num_tokens);
+                });
+                if (action == "subscribe") {
+                    for (const auto& token : message["v"]) {
+                        tokens_.insert(token.get<int32_t>());
+                    }
+                    if (!subscribed_) {
+                        subscribed_ = true;
+                        simulator_->on_session_subscribed(target_);
+                    }
+                } else if (action == "unsubscribe") {
+                    for (const auto& token : message["v"]) {
+                        tokens_.erase(token.get<int32_t>());
+                    }
+                }
+            } catch (const std::exception&) {
+                // Malformed control messages are ignored, as the venue does
+            }
+        }
+        buffer_.consume(buffer_.size());
+        do_read();
+    }
+
+    void do_write() {
+        writing_ = true;
+        ws_.binary(queue_.front().binary);
+        ws_.async_write(net::buffer(*queue_.front().message),
+                        beast::bind_front_handler(&SimSession::on_write, shared_from_this()));
+    }
+
+    void on_write(beast::error_code ec, size_t bytes) {
+        writing_ = false;
+        if (ec || closed_) {
+            close(false);
+            return;
+        }
+
+        const bool heartbeat = queue_.front().heartbeat;
+        queue_.pop_front();
+        last_write_ = Common::getSystemNanos();
+        if (!heartbeat) {
+            ++sent_;
+            simulator_->update_stats([bytes](WsSimulatorStats& stats) {
+                ++stats.messages_sent;
+                stats.bytes_sent += bytes;
+            });
+
+            const auto disconnect_every = simulator_->config_.disconnect_every;
+            if (disconnect_every && sent_ % disconnect_every == 0) {
+                simulator_->update_stats([](WsSimulatorStats& stats) { ++stats.disconnects; });
+                kick("injected disconnect");
+                return;
+            }
+        }
+        if (!queue_.empty()) {
+            do_write();
+        }
+    }
+
+    void close(bool kicked) {
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        queue_.clear();
+        simulator_->on_session_closed(this, kicked);
+    }
+
+    WsExchangeSimulator* simulator_;
+    websocket::stream<beast::ssl_stream<beast::tcp_stream>> ws_;
+    http::request<http::string_body> request_;
+    beast::flat_buffer buffer_;
+    std::string target_;
+
+    std::deque<Outbound> queue_;
+    bool writing_ = false;
+    bool open_ = false;
+    bool subscribed_ = false;
+    bool closed_ = false;
+    size_t sent_ = 0;
+    Common::Nanos last_write_ = 0;
+
+    int instrument_ = -1;
+    std::string stream_type_;
+    std::unordered_set<int32_t> tokens_;
+};
+
+/**
+ * An accepted TLS connection before it is upgraded: serves REST requests until a WebSocket upgrade arrives
+ */
+class SimConnection : public std::enable_shared_from_this<SimConnection> {
+public:
+    SimConnection(WsExchangeSimulator* simulator, tcp::socket&& socket)
+        : simulator_(simulator), stream_(std::move(socket), simulator->ssl_ctx_) {}
+
+    void start() {
+        stream_.async_handshake(ssl::stream_base::server,
+                                beast::bind_front_handler(&SimConnection::on_handshake, shared_from_this()));
+    }
+
+private:
+    void on_handshake(beast::error_code ec) {
+        if (!ec) {
+            do_read();
+        }
+    }
+
+    void do_read() {
+        request_ = {};
+        http::async_read(stream_, buffer_, request_, beast::bind_front_handler(&SimConnection::on_read, shared_from_this()));
+    }
+
+    void on_read(beast::error_code ec, size_t) {
+        if (ec) {
+            return;
+        }
+
+        if (websocket::is_upgrade(request_)) {
+            std::make_shared<SimSession>(simulator_, std::move(stream_))->accept(std::move(request_));
+            return;
+        }
+
+        simulator_->on_rest_request();
+        unsigned status = 200;
+        const auto body = simulator_->rest_response(std::string(request_.target()), status);
+        response_ = {static_cast<http::status>(status), request_.version()};
+        response_.set(http::field::content_type, "application/json");
+        response_.keep_alive(request_.keep_alive());
+        response_.body() = body;
+        response_.prepare_payload();
+        http::async_write(stream_, response_, beast::bind_front_handler(&SimConnection::on_write, shared_from_this()));
+    }
+
+    void on_write(beast::error_code ec, size_t) {
+        if (ec) {
+            return;
+        }
+        if (response_.keep_alive()) {
+            do_read();
+        } else {
+            stream_.async_shutdown([self = shared_from_this()](beast::error_code) {});
+        }
+    }
+
+    WsExchangeSimulator* simulator_;
+    beast::ssl_stream<beast::tcp_stream> stream_;
+    beast::flat_buffer buffer_;
+    http::request<http::string_body> request_;
+    http::response<http::string_body> response_;
+};
+
+WsExchangeSimulator::WsExchangeSimulator(const WsExchangeSimulatorConfig& config, Common::Logger* logger)
+    : config_(config),
+      logger_(logger),
+      messages_per_second_(config.messages_per_second),
+      me_updates_(Common::ME_MAX_MARKET_UPDATES) {
+    books_.resize(config_.instruments.size());
+    for (size_t i = 0; i < config_.instruments.size(); ++i) {
+        ticker_to_instrument_[config_.instruments[i].ticker_id] = i;
+
+        // Synthetic books start with a full ladder around the start price
+        auto& book = books_[i];
+        book.mid = book.last_price = book.open = book.high = book.low = config_.instruments[i].start_price;
+        if (config_.source == SimSource::SYNTHETIC) {
+            for (Common::Price level = 1; level <= SYNTHETIC_LEVELS; ++level) {
+                book.bids[book.mid - level] = 100 * level;
+                book.asks[book.mid + level] = 100 * level;
+            }
+        }
+    }
+
+    if (config_.source == SimSource::JOURNAL) {
+        config_.journal.forEach([this](const Common::JournalRecordHeader* record) {
+            if (record->type_ == Common::JournalRecordType::ZERODHA_BINARY || record->type_ == Common::JournalRecordType::ZERODHA_TEXT ||
+                record->type_ == Common::JournalRecordType::BINANCE_JSON) {
+                journal_records_.push_back(record);
+            }
+        });
+    }
+
+    use_self_signed_certificate(ssl_ctx_);
+}
+
+WsExchangeSimulator::~WsExchangeSimulator() {
+    stop();
+}
+
+void WsExchangeSimulator::start() {
+    const tcp::endpoint endpoint(net::ip::make_address(config_.address), config_.port);
+    acceptor_.open(endpoint.protocol());
+    acceptor_.set_option(net::socket_base::reuse_address(true));
+    acceptor_.bind(endpoint);
+    acceptor_.listen(net::socket_base::max_listen_connections);
+    port_ = acceptor_.local_endpoint().port();
+
+    logger_->log("%:% %() % % simulator (% source) listening on %:%, % msgs/s\n", __FILE__, __LINE__, __FUNCTION__,
+                 Common::getCurrentTimeStr(&time_str_), simProtocolToString(config_.protocol), simSourceToString(config_.source),
+                 config_.address, port_, messages_per_second_.load());
+
+    running_ = true;
+    do_accept();
+    thread_ = std::thread([this]() { run(); });
+}
+
+void WsExchangeSimulator::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void WsExchangeSimulator::on_market_update(const Exchange::MEMarketUpdate* update) {
+    *me_updates_.getNextToWriteTo() = *update;
+    me_updates_.updateWriteIndex();
+}
+
+WsSimulatorStats WsExchangeSimulator::stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+void WsExchangeSimulator::do_accept() {
+    acceptor_.async_accept([this](beast::error_code ec, tcp::socket socket) {
+        if (!ec) {
+            socket.set_option(tcp::no_delay(true));
+            std::make_shared<SimConnection>(this, std::move(socket))->start();
+        }
+        if (running_ && acceptor_.is_open()) {
+            do_accept();
+        }
+    });
+}
+
+void WsExchangeSimulator::run() {
+    auto rate = messages_per_second_.load();
+    auto rate_start = Common::getSystemNanos();
+    size_t rate_count = 0;
+
+    while (running_) {
+        ioc_.poll();
+        sessions_.erase(std::remove_if(sessions_.begin(), sessions_.end(), [](const auto& session) { return session->closed(); }),
+                        sessions_.end());
+
+        const auto now = Common::getSystemNanos();
+        size_t produced = 0;
+        Common::Nanos wait = Common::NANOS_TO_MILLIS;
+
+        if (config_.source == SimSource::MATCHING_ENGINE) {
+            produced = drain_matching_engine();
+        } else if (now >= stalled_until_) {
+            const auto current_rate = messages_per_second_.load();
+            if (current_rate != rate) {
+                rate = current_rate;
+                rate_start = now;
+                rate_count = 0;
+            }
+
+            const auto generate = [this]() {
+                return config_.source == SimSource::SYNTHETIC ? generate_synthetic() : replay_journal();
+            };
+            if (!rate) {
+                while (produced < MAX_BURST && has_room() && Common::getSystemNanos() >= stalled_until_ && generate()) {
+                    ++produced;
+                }
+            } else {
+                const auto due = static_cast<size_t>(static_cast<double>(now - rate_start) * static_cast<double>(rate) / Common::NANOS_TO_SECS);
+                while (rate_count < due && produced < MAX_BURST && Common::getSystemNanos() >= stalled_until_ && generate()) {
+                    ++rate_count;
+                    ++produced;
+                }
+
+                // More than a second behind, e.g. after a stall: resume at the rate instead of bursting the backlog
+                if (due > rate_count + rate) {
+                    rate_count = due;
+                }
+                wait = std::min<Common::Nanos>(wait, std::max<Common::Nanos>(1, Common::NANOS_TO_SECS / static_cast<Common::Nanos>(rate)));
+            }
+        } else {
+            wait = std::min<Common::Nanos>(wait, stalled_until_ - now);
+        }
+
+        if (config_.protocol == SimProtocol::KITE) {
+            send_heartbeats();
+        }
+        if (!produced) {
+            ioc_.run_one_for(std::chrono::nanoseconds(wait));
+        }
+    }
+
+    // Shut down on this thread, the only one touching the sessions
+    beast::error_code ec;
+    acceptor_.close(ec);
+    for (const auto& session : sessions_) {
+        session->kick("simulator stopped");
+    }
+    sessions_.clear();
+    ioc_.poll();
+    ioc_.stop();
+}
+
+bool WsExchangeSimulator::has_room() const {
+    // Paced by the slowest subscribed session, so saturating never drops a session as a slow consumer
+    bool any_ready = false;
+    for (const auto& session : sessions_) {
+        if (session->ready()) {
+            if (session->backlog() >= SATURATION_BACKLOG) {
+                return false;
+            }
+            any_ready = true;
+        }
+    }
+    return any_ready;
+}
+
+void WsExchangeSimulator::set_level(SimBook& book, Common::Side side, Common::Price price, Common::Qty qty) {
+    if (side == Common::Side::BUY) {
+        if (qty > 0) {
+            book.bids[price] = qty;
+        } else {
+            book.bids.erase(price);
+        }
+    } else {
+        if (qty > 0) {
+            book.asks[price] = qty;
+        } else {
+            book.asks.erase(price);
+        }
+    }
+    book.changed[{side, price}] = qty;
+    book.dirty = true;
+}
+
+void WsExchangeSimulator::add_trade(SimBook& book, Common::Price price, Common::Qty qty) {
+    book.last_price = price;
+    book.last_qty = qty;
+    book.volume += qty;
+    book.high = std::max(book.high, price);
+    book.low = std::min(book.low, price);
+    book.traded = true;
+    book.dirty = true;
+}
+
+size_t WsExchangeSimulator::generate_synthetic() {
+    if (books_.empty()) {
+        return 0;
+    }
+
+    const auto count = std::min(std::max<size_t>(1, config_.instruments_per_message), books_.size());
+    for (size_t i = 0; i < count; ++i) {
+        auto& book = books_[rng_() % books_.size()];
+        book.mid += static_cast<Common::Price>(rng_() % 3) - 1;
+
+        // Levels the mid moved through go, the ones left behind further than the ladder go too
+        while (!book.bids.empty() && book.bids.begin()->first >= book.mid) {
+            set_level(book, Common::Side::BUY, book.bids.begin()->first, 0);
+        }
+        while (!book.asks.empty() && book.asks.begin()->first <= book.mid) {
+            set_level(book, Common::Side::SELL, book.asks.begin()->first, 0);
+        }
+        while (!book.bids.empty() && book.bids.rbegin()->first < book.mid - SYNTHETIC_LEVELS) {
+            set_level(book, Common::Side::BUY, book.bids.rbegin()->first, 0);
+        }
+        while (!book.asks.empty() && book.asks.rbegin()->first > book.mid + SYNTHETIC_LEVELS) {
+            set_level(book, Common::Side::SELL, book.asks.rbegin()->first, 0);
+        }
+
+        // A couple of levels near the top change size
+        set_level(book, Common::Side::BUY, book.mid - 1 - static_cast<Common::Price>(rng_() % 5), 1 + static_cast<Common::Qty>(rng_() % 1000));
+        set_level(book, Common::Side::SELL, book.mid + 1 + static_cast<Common::Price>(rng_() % 5), 1 + static_cast<Common::Qty>(rng_() % 1000));
+
+        if (rng_() % 5 == 0) {
+            add_trade(book, book.mid + (rng_() % 2 ? 1 : -1), 1 + static_cast<Common::Qty>(rng_() % 100));
+        }
+    }
+
+    publish_dirty();
+    return 1;
+}
+
+size_t WsExchangeSimulator::drain_matching_engine() {
+    size_t produced = 0;
+    for (auto update = me_updates_.getNextToRead(); update && produced < MAX_BURST; update = me_updates_.getNextToRead()) {
+        const auto itr = ticker_to_instrument_.find(update->ticker_id_);
+        if (itr != ticker_to_instrument_.end()) {
+            const auto instrument = itr->second;
+            auto& book = books_[instrument];
+            const auto level_qty = [&book](Common::Side side, Common::Price price) -> Common::Qty {
+                if (side == Common::Side::BUY) {
+                    const auto level = book.bids.find(price);
+                    return level == book.bids.end() ? 0 : level->second;
+                }
+                const auto level = book.asks.find(price);
+                return level == book.asks.end() ? 0 : level->second;
+            };
+
+            switch (update->type_) {
+                case Exchange::MarketUpdateType::ADD:
+                    orders_[update->order_id_] = {instrument, update->side_, update->price_, update->qty_};
+                    set_level(book, update->side_, update->price_, level_qty(update->side_, update->price_) + update->qty_);
+                    break;
+                case Exchange::MarketUpdateType::MODIFY: {
+                    auto order = orders_.find(update->order_id_);
+                    if (order != orders_.end()) {
+                        set_level(book, order->second.side, order->second.price,
+                                  level_qty(order->second.side, order->second.price) - order->second.qty + update->qty_);
+                        order->second.qty = update->qty_;
+                    }
+                    break;
+                }
+                case Exchange::MarketUpdateType::CANCEL: {
+                    auto order = orders_.find(update->order_id_);
+                    if (order != orders_.end()) {
+                        set_level(book, order->second.side, order->second.price,
+                                  level_qty(order->second.side, order->second.price) - order->second.qty);
+                        orders_.erase(order);
+                    }
+                    break;
+                }
+                case Exchange::MarketUpdateType::TRADE:
+                    add_trade(book, update->price_, update->qty_);
+                    break;
+                case Exchange::MarketUpdateType::CLEAR:
+                    while (!book.bids.empty()) {
+                        set_level(book, Common::Side::BUY, book.bids.begin()->first, 0);
+                    }
+                    while (!book.asks.empty()) {
+                        set_level(book, Common::Side::SELL, book.asks.begin()->first, 0);
+                    }
+                    std::erase_if(orders_, [instrument](const auto& order) { return order.second.instrument == instrument; });
+                    break;
+                default:
+                    break;
+            }
+
+            if (book.dirty) {
+                publish_dirty();
+            }
+        }
+        me_updates_.updateReadIndex();
+        ++produced;
+    }
+    return produced;
+}
+
+size_t WsExchangeSimulator::replay_journal() {
+    while (running_) {
+        if (journal_index_ >= journal_records_.size()) {
+            if (!config_.loop_journal || journal_records_.empty()) {
+                return 0;
+            }
+            journal_index_ = 0;
+        }
+
+        const auto record = journal_records_[journal_index_++];
+        const auto data = reinterpret_cast<const char*>(record + 1);
+
+        if (config_.protocol == SimProtocol::KITE) {
+            if (record->type_ == Common::JournalRecordType::BINANCE_JSON) {
+                continue;
+            }
+            if (count_message()) {
+                broadcast(std::make_shared<const std::string>(data, record->length_),
+                          record->type_ == Common::JournalRecordType::ZERODHA_BINARY, -1, nullptr);
+            }
+            return 1;
+        }
+
+        // BINANCE_JSON payloads are "<symbol>@<stream_type>\n<message>", the REST responses are kept to be served
+        if (record->type_ != Common::JournalRecordType::BINANCE_JSON) {
+            continue;
+        }
+        const std::string_view payload(data, record->length_);
+        const auto at = payload.find('@');
+        const auto newline = payload.find('\n');
+        if (at == std::string_view::npos || newline == std::string_view::npos || at > newline) {
+            continue;
+        }
+        const std::string symbol(payload.substr(0, at));
+        const std::string stream_type(payload.substr(at + 1, newline - at - 1));
+        auto message = std::make_shared<const std::string>(payload.substr(newline + 1));
+
+        if (stream_type == "exchangeInfo") {
+            recorded_exchange_info_[symbol] = *message;
+            continue;
+        }
+        if (stream_type == "snapshot") {
+            recorded_snapshots_[symbol] = *message;
+            continue;
+        }
+        if (count_message()) {
+            broadcast(message, false, find_instrument(symbol), stream_type.c_str());
+        }
+        return 1;
+    }
+    return 0;
+}
+
+bool WsExchangeSimulator::count_message() {
+    ++message_count_;
+    update_stats([](WsSimulatorStats& stats) { ++stats.messages_generated; });
+
+    if (config_.stall_every && message_count_ % config_.stall_every == 0) {
+        stalled_until_ = Common::getSystemNanos() + std::chrono::duration_cast<std::chrono::nanoseconds>(config_.stall_duration).count();
+        update_stats([](WsSimulatorStats& stats) { ++stats.stalls; });
+    }
+    if (config_.gap_every && message_count_ % config_.gap_every == 0) {
+        update_stats([](WsSimulatorStats& stats) { ++stats.gaps; });
+        return false;
+    }
+    return true;
+}
+
+void WsExchangeSimulator::publish_dirty() {
+    std::vector<size_t> dirty;
+    for (size_t i = 0; i < books_.size(); ++i) {
+        if (books_[i].dirty) {
+            dirty.push_back(i);
+        }
+    }
+    if (dirty.empty()) {
+        return;
+    }
+
+    const bool send = count_message();
+    if (config_.protocol == SimProtocol::KITE) {
+        if (send) {
+            publish_kite(dirty);
+        }
+    } else {
+        for (const auto instrument : dirty) {
+            if (send) {
+                publish_binance(instrument);
+            } else {
+                // The update ids of the lost message are used up, the next depth message's U shows the gap
+                ++books_[instrument].update_id;
+                pending_resyncs_.emplace(instrument, Common::getSystemNanos());
+            }
+        }
+    }
+
+    for (const auto instrument : dirty) {
+        books_[instrument].changed.clear();
+        books_[instrument].traded = false;
+        books_[instrument].dirty = false;
+    }
+}
+
+void WsExchangeSimulator::publish_kite(const std::vector<size_t>& instruments) {
+    // One FULL packet per instrument, then a frame per session of the packets it subscribed to
+    std::vector<std::string> packets(instruments.size(), std::string(2 + KITE_FULL_PACKET_SIZE, '\0'));
+    const auto now_secs = static_cast<int32_t>(Common::getCurrentNanos() / Common::NANOS_TO_SECS);
+    for (size_t i = 0; i < instruments.size(); ++i) {
+        const auto& book = books_[instruments[i]];
+        auto packet = packets[i].data();
+        put_short(packet, static_cast<int16_t>(KITE_FULL_PACKET_SIZE));
+        const auto data = packet + 2;
+
+        int64_t buy_qty = 0, sell_qty = 0;
+        for (const auto& [price, qty] : book.bids) {
+            buy_qty += qty;
+        }
+        for (const auto& [price, qty] : book.asks) {
+            sell_qty += qty;
+        }
+
+        put_int(data, config_.instruments[instruments[i]].instrument_token);
+        put_int(data + 4, static_cast<int32_t>(book.last_price));
+        put_int(data + 8, static_cast<int32_t>(book.last_qty));
+        put_int(data + 12, static_cast<int32_t>(book.last_price));
+        put_int(data + 16, static_cast<int32_t>(book.volume));
+        put_int(data + 20, static_cast<int32_t>(buy_qty));
+        put_int(data + 24, static_cast<int32_t>(sell_qty));
+        put_int(data + 28, static_cast<int32_t>(book.open));
+        put_int(data + 32, static_cast<int32_t>(book.high));
+        put_int(data + 36, static_cast<int32_t>(book.low));
+        put_int(data + 40, static_cast<int32_t>(book.open));
+        put_int(data + 44, now_secs);
+        put_int(data + 60, now_secs);
+
+        auto bid = book.bids.begin();
+        auto ask = book.asks.begin();
+        for (int level = 0; level < 5; ++level) {
+            if (bid != book.bids.end()) {
+                put_int(data + 64 + level * 12, static_cast<int32_t>(bid->second));
+                put_int(data + 64 + level * 12 + 4, static_cast<int32_t>(bid->first));
+                put_short(data + 64 + level * 12 + 8, 1);
+                ++bid;
+            }
+            if (ask != book.asks.end()) {
+                put_int(data + 124 + level * 12, static_cast<int32_t>(ask->second));
+                put_int(data + 124 + level * 12 + 4, static_cast<int32_t>(ask->first));
+                put_short(data + 124 + level * 12 + 8, 1);
+                ++ask;
+            }
+        }
+    }
+
+    for (const auto& session : sessions_) {
+        if (!session->ready()) {
+            continue;
+        }
+        std::string frame(2, '\0');
+        int16_t count = 0;
+        for (size_t i = 0; i < instruments.size(); ++i) {
+            if (session->subscribed_to(config_.instruments[instruments[i]].instrument_token)) {
+                frame += packets[i];
+                ++count;
+            }
+        }
+        if (count) {
+            put_short(frame.data(), count);
+            session->send(std::make_shared<const std::string>(std::move(frame)), true);
+        }
+    }
+}
+
+void WsExchangeSimulator::publish_binance(size_t instrument) {
+    auto& book = books_[instrument];
+    const auto& symbol = config_.instruments[instrument].symbol;
+    const auto event_millis = std::to_string(Common::getCurrentNanos() / Common::NANOS_TO_MILLIS);
+
+    if (!book.changed.empty()) {
+        const auto update_id = std::to_string(++book.update_id);
+        std::string bids, asks;
+        for (const auto& [level, qty] : book.changed) {
+            auto& side = (level.first == Common::Side::BUY ? bids : asks);
+            side += std::string(side.empty() ? "" : ",") + "[\"" + binance_price(level.second) + "\",\"" + binance_qty(qty) + "\"]";
+        }
+        broadcast(std::make_shared<const std::string>(
+                      "{\"e\":\"depthUpdate\",\"E\":" + event_millis + ",\"s\":\"" + symbol + "\",\"U\":" + update_id +
+                      ",\"u\":" + update_id + ",\"b\":[" + bids + "],\"a\":[" + asks + "]}"),
+                  false, static_cast<int>(instrument), "depth");
+    }
+
+    if (book.traded) {
+        broadcast(std::make_shared<const std::string>(
+                      "{\"e\":\"trade\",\"E\":" + event_millis + ",\"s\":\"" + symbol + "\",\"t\":" + std::to_string(book.volume) +
+                      ",\"p\":\"" + binance_price(book.last_price) + "\",\"q\":\"" + binance_qty(book.last_qty) + "\",\"T\":" +
+                      event_millis + ",\"m\":" + (book.last_price < book.mid ? "true" : "false") + "}"),
+                  false, static_cast<int>(instrument), "trade");
+    }
+}
+
+void WsExchangeSimulator::broadcast(const std::shared_ptr<const std::string>& message, bool binary, int instrument, const char* stream_type) {
+    for (const auto& session : sessions_) {
+        if (!session->ready()) {
+            continue;
+        }
+        if (stream_type && (session->instrument() != instrument || session->stream_type() != stream_type)) {
+            continue;
+        }
+        session->send(message, binary);
+    }
+}
+
+void WsExchangeSimulator::send_heartbeats() {
+    const auto now = Common::getSystemNanos();
+    const auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(config_.heartbeat_interval).count();
+    for (const auto& session : sessions_) {
+        session->heartbeat(now, interval);
+    }
+}
+
+std::string WsExchangeSimulator::rest_response(const std::string& target, unsigned& status) {
+    const auto path = target.substr(0, target.find('?'));
+    const auto params = query_params(target);
+    const auto symbol_itr = params.find("symbol");
+    const auto symbol = (symbol_itr == params.end() ? std::string() : symbol_itr->second);
+    const auto instrument = find_instrument(symbol);
+
+    if (path == "/api/v3/ping") {
+        return "{}";
+    }
+    if (instrument < 0) {
+        status = 400;
+        return "{\"code\":-1121,\"msg\":\"Invalid symbol.\"}";
+    }
+
+    if (path == "/api/v3/exchangeInfo") {
+        const auto recorded = recorded_exchange_info_.find(symbol);
+        if (recorded != recorded_exchange_info_.end()) {
+            return recorded->second;
+        }
+        return binance_exchange_info(symbol);
+    }
+
+    if (path == "/api/v3/depth") {
+        const auto resync = pending_resyncs_.find(static_cast<size_t>(instrument));
+        if (resync != pending_resyncs_.end()) {
+            const auto elapsed = Common::getSystemNanos() - resync->second;
+            update_stats([elapsed](WsSimulatorStats& stats) {
+                ++stats.resyncs;
+                stats.resync_time += elapsed;
+                stats.max_resync_time = std::max(stats.max_resync_time, elapsed);
+            });
+            pending_resyncs_.erase(resync);
+        }
+
+        const auto recorded = recorded_snapshots_.find(symbol);
+        if (recorded != recorded_snapshots_.end()) {
+            return recorded->second;
+        }
+
+        const auto limit_itr = params.find("limit");
+        const auto limit = (limit_itr == params.end() ? size_t{100} : std::stoul(limit_itr->second));
+        const auto& book = books_[static_cast<size_t>(instrument)];
+        std::string bids, asks;
+        size_t count = 0;
+        for (auto itr = book.bids.begin(); itr != book.bids.end() && count < limit; ++itr, ++count) {
+            bids += std::string(bids.empty() ? "" : ",") + "[\"" + binance_price(itr->first) + "\",\"" + binance_qty(itr->second) + "\"]";
+        }
+        count = 0;
+        for (auto itr = book.asks.begin(); itr != book.asks.end() && count < limit; ++itr, ++count) {
+            asks += std::string(asks.empty() ? "" : ",") + "[\"" + binance_price(itr->first) + "\",\"" + binance_qty(itr->second) + "\"]";
+        }
+        return "{\"lastUpdateId\":" + std::to_string(book.update_id) + ",\"bids\":[" + bids + "],\"asks\":[" + asks + "]}";
+    }
+
+    status = 404;
+    return "{\"code\":-1,\"msg\":\"Unknown endpoint.\"}";
+}
+
+void WsExchangeSimulator::on_session_open(const std::shared_ptr<SimSession>& session) {
+    sessions_.push_back(session);
+    update_stats([](WsSimulatorStats& stats) {
+        ++stats.sessions;
+        ++stats.active_sessions;
+    });
+    logger_->log("%:% %() % Session opened: %\n", __FILE__, __LINE__, __FUNCTION__,
+                 Common::getCurrentTimeStr(&time_str_), session->key());
+}
+
+void WsExchangeSimulator::on_session_subscribed(const std::string& key) {
+    // A session of a dropped connection is back once it is subscribed again
+    const auto dropped = dropped_sessions_.find(key);
+    if (dropped == dropped_sessions_.end()) {
+        return;
+    }
+    const auto elapsed = Common::getSystemNanos() - dropped->second;
+    dropped_sessions_.erase(dropped);
+    update_stats([elapsed](WsSimulatorStats& stats) {
+        ++stats.reconnects;
+        stats.reconnect_time += elapsed;
+        stats.max_reconnect_time = std::max(stats.max_reconnect_time, elapsed);
+    });
+}
+
+void WsExchangeSimulator::on_session_closed(const SimSession* session, bool kicked) {
+    // The session is removed from sessions_ by the run loop, this can be called while sessions_ is iterated
+    if (kicked && running_) {
+        dropped_sessions_.emplace(session->key(), Common::getSystemNanos());
+    }
+    update_stats([](WsSimulatorStats& stats) { --stats.active_sessions; });
+}
+
+void WsExchangeSimulator::on_rest_request() {
+    update_stats([](WsSimulatorStats& stats) { ++stats.rest_requests; });
+}
+
+int WsExchangeSimulator::find_instrument(const std::string& symbol) const {
+    const auto symbol_lower = lower(symbol);
+    for (size_t i = 0; i < config_.instruments.size(); ++i) {
+        if (lower(config_.instruments[i].symbol) == symbol_lower) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+} // namespace Sim
+} // namespace Adapter
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <random>
+
+// Common utilities
+#include "common/logging.h"
+#include "common/lf_queue.h"
+#include "common/time_utils.h"
+#include "common/journal_reader.h"
+#include "exchange/market_data/market_update.h"
+
+// Boost.Beast includes
+#include <boost/beast/core.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+namespace Adapter {
+namespace Sim {
+
+/**
+ * Venue protocol a WsExchangeSimulator speaks
+ */
+enum class SimProtocol : uint8_t {
+    KITE = 0,       // Kite ticker: binary FULL mode tick frames, JSON subscribe / mode messages, 1 byte heartbeats
+    BINANCE = 1     // /ws/<symbol>@depth and @trade JSON streams, /api/v3/exchangeInfo and /api/v3/depth over HTTPS
+};
+
+/**
+ * Where the simulated feed comes from
+ */
+enum class SimSource : uint8_t {
+    SYNTHETIC = 0,          // Random walk books generated at the configured message rate
+    MATCHING_ENGINE = 1,    // MEMarketUpdates of the local matching engine, passed to on_market_update()
+    JOURNAL = 2             // ZERODHA_BINARY / BINANCE_JSON records of a journal, sent as recorded
+};
+
+std::string simProtocolToString(SimProtocol protocol);
+std::string simSourceToString(SimSource source);
+
+/**
+ * Instrument of the simulated venue
+ */
+struct SimInstrument {
+    Common::TickerId ticker_id = 0;     // Ticker of the matching engine's updates
+    int32_t instrument_token = 0;       // Kite instrument token
+    std::string symbol;                 // Binance symbol, e.g. "BTCUSDT"
+    Common::Price start_price = 100000; // Synthetic starting price in ticks - paise for Kite, 0.01 for Binance
+};
+
+/**
+ * Configuration of a WsExchangeSimulator
+ */
+struct WsExchangeSimulatorConfig {
+    SimProtocol protocol = SimProtocol::KITE;
+    SimSource source = SimSource::SYNTHETIC;
+
+    // Listening address, port 0 picks a free one (see WsExchangeSimulator::port())
+    std::string address = "127.0.0.1";
+    uint16_t port = 0;
+
+    std::vector<SimInstrument> instruments;
+
+    // Feed messages generated per second by the SYNTHETIC and JOURNAL sources, 0 to generate as fast as the
+    // slowest session drains them (saturation)
+    size_t messages_per_second = 1000;
+
+    // Instruments updated per synthetic message - the number of packets of a Kite frame
+    size_t instruments_per_message = 1;
+
+    // Fault injection, 0 disables each
+    size_t disconnect_every = 0;    // Drop a session's connection after every N messages sent to it
+    size_t gap_every = 0;           // Skip every Nth message - a Binance update id jump, a lost Kite frame
+    size_t stall_every = 0;         // Freeze the feed for stall_duration after every N messages
+    std::chrono::milliseconds stall_duration{200};
+
+    // Messages queued for a session before it is dropped as a slow consumer
+    size_t max_backlog = 10000;
+
+    // Kite sends a 1 byte heartbeat on an otherwise idle connection
+    std::chrono::milliseconds heartbeat_interval{1000};
+
+    // Records of the JOURNAL source, replayed in a loop when loop_journal is set
+    Common::JournalChunk journal;
+    bool loop_journal = true;
+};
+
+/**
+ * Counters of a WsExchangeSimulator, all since start()
+ */
+struct WsSimulatorStats {
+    size_t sessions = 0;                // WebSocket sessions accepted
+    size_t active_sessions = 0;
+    size_t messages_generated = 0;      // Feed messages produced by the source
+    size_t messages_sent = 0;           // WebSocket messages written to sessions, heartbeats excluded
+    size_t bytes_sent = 0;
+    size_t rest_requests = 0;
+    size_t control_messages = 0;        // Kite subscribe, unsubscribe and mode messages received
+    size_t max_control_tokens = 0;      // Most tokens in one of them
+
+    size_t disconnects = 0;             // Injected disconnects
+    size_t gaps = 0;
+    size_t stalls = 0;
+    size_t slow_consumer_drops = 0;
+    size_t max_backlog = 0;             // Largest backlog of a session
+
+    // Sessions of a dropped connection re-established and subscribed again, and the time that took
+    size_t reconnects = 0;
+    Common::Nanos reconnect_time = 0;
+    Common::Nanos max_reconnect_time = 0;
+
+    // Binance depth snapshots requested after an injected gap, and the time from the gap to the request
+    size_t resyncs = 0;
+    Common::Nanos resync_time = 0;
+    Common::Nanos max_resync_time = 0;
+
+    std::string toString() const;
+};
+
+class SimSession;
+class SimConnection;
+
+/**
+ * WsExchangeSimulator - Local TLS WebSocket server impersonating a venue's market data feed
+ *
+ * Lets the Kite and Binance clients be load tested offline: point them at port() with certificate
+ * verification off (the server makes a self-signed certificate at start()). One thread runs the server
+ * and the source, writes are asynchronous with a bounded backlog per session, so a slow client is
+ * detected instead of slowing the feed for every other client.
+ */
+class WsExchangeSimulator {
+public:
+    /**
+     * Constructor
+     *
+     * @param config Protocol, source, rate and faults to inject
+     * @param logger Logger for session and fault events
+     */
+    WsExchangeSimulator(const WsExchangeSimulatorConfig& config, Common::Logger* logger);
+
+    /**
+     * Destructor - Stops the server
+     */
+    ~WsExchangeSimulator();
+
+    /**
+     * Listen and start the simulator thread
+     */
+    void start();
+
+    /**
+     * Close every session and stop the simulator thread
+     */
+    void stop();
+
+    /**
+     * Port the server listens on, known once start() returns
+     */
+    uint16_t port() const { return port_; }
+
+    /**
+     * Change the message rate of the SYNTHETIC and JOURNAL sources while running, 0 to saturate
+     */
+    void set_messages_per_second(size_t messages_per_second) { messages_per_second_ = messages_per_second; }
+
+    /**
+     * Feed an update of the matching engine (MATCHING_ENGINE source), from a single publishing thread
+     *
+     * @param update Order level update, aggregated into price levels per instrument
+     */
+    void on_market_update(const Exchange::MEMarketUpdate* update);
+
+    /**
+     * Snapshot of the counters, safe to call from any thread
+     */
+    WsSimulatorStats stats() const;
+
+    // Deleted default, copy & move constructors and assignment-operators
+    WsExchangeSimulator() = delete;
+    WsExchangeSimulator(const WsExchangeSimulator &) = delete;
+    WsExchangeSimulator(const WsExchangeSimulator &&) = delete;
+    WsExchangeSimulator &operator=(const WsExchangeSimulator &) = delete;
+    WsExchangeSimulator &operator=(const WsExchangeSimulator &&) = delete;
+
+private:
+    friend class SimSession;
+    friend class SimConnection;
+
+    // Aggregated book and trade state of an instrument
+    struct SimBook {
+        std::map<Common::Price, Common::Qty, std::greater<Common::Price>> bids;
+        std::map<Common::Price, Common::Qty> asks;
+        Common::Price mid = 0;
+        Common::Price last_price = 0;
+        Common::Qty last_qty = 0;
+        int64_t volume = 0;
+        Common::Price open = 0;
+        Common::Price high = 0;
+        Common::Price low = 0;
+        uint64_t update_id = 100;
+
+        // Levels changed since the last Binance depth message and whether a trade happened
+        std::map<std::pair<Common::Side, Common::Price>, Common::Qty> changed;
+        bool traded = false;
+        bool dirty = false;
+    };
+
+    // Order of the matching engine, to turn order level updates into price level changes
+    struct SimOrder {
+        size_t instrument = 0;
+        Common::Side side = Common::Side::INVALID;
+        Common::Price price = 0;
+        Common::Qty qty = 0;
+    };
+
+    void run();
+    void do_accept();
+
+    // Sources - each produces feed messages and returns how many
+    size_t generate_synthetic();
+    size_t drain_matching_engine();
+    size_t replay_journal();
+    bool has_room() const;
+
+    // Level / trade changes to a book, recorded for the next message
+    void set_level(SimBook& book, Common::Side side, Common::Price price, Common::Qty qty);
+    void add_trade(SimBook& book, Common::Price price, Common::Qty qty);
+
+    // Encode the dirty books into frames / messages and fan them out
+    void publish_dirty();
+    void publish_kite(const std::vector<size_t>& instruments);
+    void publish_binance(size_t instrument);
+    void broadcast(const std::shared_ptr<const std::string>& message, bool binary, int instrument, const char* stream_type);
+
+    // Count a message against the gap / stall faults, false if it is to be skipped as a gap
+    bool count_message();
+
+    void send_heartbeats();
+
+    // REST responses of the Binance protocol
+    std::string rest_response(const std::string& target, unsigned& status);
+
+    // Session bookkeeping, called by the sessions
+    void on_session_open(const std::shared_ptr<SimSession>& session);
+    void on_session_subscribed(const std::string& key);
+    void on_session_closed(const SimSession* session, bool kicked);
+    void on_rest_request();
+    int find_instrument(const std::string& symbol) const;
+
+    template<typename F>
+    void update_stats(F&& f) {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        f(stats_);
+    }
+
+    const WsExchangeSimulatorConfig config_;
+    Common::Logger* logger_;
+    std::string time_str_;
+
+    boost::asio::io_context ioc_;
+    boost::asio::ssl::context ssl_ctx_{boost::asio::ssl::context::tlsv12_server};
+    boost::asio::ip::tcp::acceptor acceptor_{ioc_};
+    uint16_t port_ = 0;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> messages_per_second_{0};
+
+    std::vector<std::shared_ptr<SimSession>> sessions_;
+
+    // Feed state
+    std::vector<SimBook> books_;
+    std::unordered_map<Common::TickerId, size_t> ticker_to_instrument_;
+    std::unordered_map<Common::OrderId, SimOrder> orders_;
+    Common::LFQueue<Exchange::MEMarketUpdate> me_updates_;
+    std::mt19937_64 rng_{42};
+    size_t message_count_ = 0;
+    Common::Nanos stalled_until_ = 0;
+
+    // Records of the JOURNAL source, and the REST responses recorded per symbol for Binance
+    std::vector<const Common::JournalRecordHeader*> journal_records_;
+    size_t journal_index_ = 0;
+    std::unordered_map<std::string, std::string> recorded_exchange_info_;
+    std::unordered_map<std::string, std::string> recorded_snapshots_;
+
+    // Faults in flight: drop time per session key, gap time per instrument
+    std::unordered_map<std::string, Common::Nanos> dropped_sessions_;
+    std::unordered_map<size_t, Common::Nanos> pending_resyncs_;
+
+    mutable std::mutex stats_mutex_;
+    WsSimulatorStats stats_;
+};
+
+} // namespace Sim
+} // namespace Adapter
@@ -56,6 +56,26 @@ void from_json(const nlohmann::json& j, PaperTradingConfig& c) {
     c.slippage_model = j.value("slippage_model", "NORMAL");
 }
 
+void to_json(nlohmann::json& j, const MarketDataConfig& c) {
+    j = nlohmann::json{
+        {"execution", c.execution == MarketDataExecution::INLINE ? "INLINE" : "BUSY_POLL"},
+        {"core_id", c.core_id},
+        {"spin_polls", c.spin_polls},
+        {"latency_log_interval_s", c.latency_log_interval_s},
+        {"connections", c.connections},
+        {"rebalance_interval_s", c.rebalance_interval_s}
+    };
+}
+
+void from_json(const nlohmann::json& j, MarketDataConfig& c) {
+    c.execution = j.value("execution", "BUSY_POLL") == "INLINE" ? MarketDataExecution::INLINE : MarketDataExecution::BUSY_POLL;
+    c.core_id = j.value("core_id", -1);
+    c.spin_polls = j.value("spin_polls", 10000);
+    c.latency_log_interval_s = j.value("latency_log_interval_s", 60);
+    c.connections = j.value("connections", 1);
+    c.rebalance_interval_s = j.value("rebalance_interval_s", 30);
+}
+
 void to_json(nlohmann::json& j, const RiskConfig& c) {
     j = nlohmann::json{
         {"max_daily_loss", c.max_daily_loss},
@@ -400,6 +420,11 @@ bool EnvironmentConfig::loadFromJson(const std::string& config_file) {
             if (zerodha.contains("paper_trading")) {
                 from_json(zerodha["paper_trading"], paper_trading_config_);
             }
+            
+            // Market data threading config
+            if (zerodha.contains("market_data")) {
+                from_json(zerodha["market_data"], market_data_config_);
+            }
         }
         
         // Parse instruments
@@ -470,6 +495,11 @@ bool EnvironmentConfig::saveConfiguration(const std::string& file_path) const {
         to_json(paper_trading_zerodha, paper_trading_config_);
         zerodha["paper_trading"] = paper_trading_zerodha;
         
+        // Add market data threading config
+        nlohmann::json market_data;
+        to_json(market_data, market_data_config_);
+        zerodha["market_data"] = market_data;
+        
         config["zerodha"] = zerodha;
         
         // Add/update instruments
@@ -528,6 +558,10 @@ const PaperTradingConfig& EnvironmentConfig::getPaperTradingConfig() const {
     return paper_trading_config_;
 }
 
+const MarketDataConfig& EnvironmentConfig::getMarketDataConfig() const {
+    return market_data_config_;
+}
+
 const RiskConfig& EnvironmentConfig::getRiskConfig() const {
     return risk_config_;
 }
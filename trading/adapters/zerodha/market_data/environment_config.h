@@ -59,6 +59,26 @@ struct PaperTradingConfig {
     std::string slippage_model = "NORMAL";
 };
 
+/**
+ * Where the market data adapter applies ticks to its order books
+ */
+enum class MarketDataExecution {
+    INLINE,     // On the WebSocket thread, right after each frame is decoded
+    BUSY_POLL   // On a dedicated consumer thread spinning on the tick queue
+};
+
+/**
+ * Market data adapter threading configuration
+ */
+struct MarketDataConfig {
+    MarketDataExecution execution = MarketDataExecution::BUSY_POLL;
+    int core_id = -1;                   // Core the busy poll consumer is pinned to, -1 for none
+    int spin_polls = 10000;             // Idle polls spent pausing before the busy poll consumer starts yielding
+    int latency_log_interval_s = 60;    // Seconds between tick latency log lines, 0 for none
+    int connections = 1;                // WebSocket connections the subscriptions are sharded over, 1 to 3 (INLINE needs 1)
+    int rebalance_interval_s = 30;      // Seconds between moving hot instruments off the busiest connection, 0 for never
+};
+
 /**
  * Instrument configuration structure
  */
@@ -154,6 +174,13 @@ public:
      */
     const PaperTradingConfig& getPaperTradingConfig() const;
     
+    /**
+     * Get market data adapter threading configuration
+     * 
+     * @return Market data configuration
+     */
+    const MarketDataConfig& getMarketDataConfig() const;
+    
     /**
      * Get risk configuration
      * 
@@ -367,6 +394,9 @@ private:
     // Risk configuration
     RiskConfig risk_config_;
     
+    // Market data threading configuration
+    MarketDataConfig market_data_config_;
+    
     // API credentials
     std::string api_key_;
     std::string api_secret_;
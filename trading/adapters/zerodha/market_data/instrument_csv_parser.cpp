@@ -0,0 +1,231 @@
+#include "instrument_csv_parser.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <ctime>
+#include <thread>
+#include <unordered_map>
+
+#include <immintrin.h>
+
+namespace Adapter {
+namespace Zerodha {
+
+namespace {
+    // Columns of the dump: instrument_token, exchange_token, tradingsymbol, name, last_price, expiry, strike,
+    // tick_size, lot_size, instrument_type, segment, exchange
+    constexpr size_t NUM_COLUMNS = 12;
+
+    // Bytes of the dump per record reserved up front, a row of Kite's dump is 60 to 100 bytes
+    constexpr size_t BYTES_PER_RECORD = 64;
+
+    // First ',', '"' or '\n' from begin, end if there is none. SSE2 is part of x86-64, no dispatch needed
+    auto findDelimiter(const char* begin, const char* end) -> const char* {
+        const auto commas = _mm_set1_epi8(',');
+        const auto quotes = _mm_set1_epi8('"');
+        const auto newlines = _mm_set1_epi8('\n');
+        for (; end - begin >= 16; begin += 16) {
+            const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            const auto matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, commas), _mm_cmpeq_epi8(bytes, quotes)),
+                                              _mm_cmpeq_epi8(bytes, newlines));
+            if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(matches))) {
+                return begin + std::countr_zero(mask);
+            }
+        }
+        while (begin != end && *begin != ',' && *begin != '"' && *begin != '\n') {
+            ++begin;
+        }
+        return begin;
+    }
+
+    auto trim(std::string_view field) -> std::string_view {
+        const auto space = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v'; };
+        while (!field.empty() && space(field.front())) {
+            field.remove_prefix(1);
+        }
+        while (!field.empty() && space(field.back())) {
+            field.remove_suffix(1);
+        }
+        return field;
+    }
+
+    // The whole field as a number
+    template<typename T>
+    auto parseNumber(std::string_view field, T& value) -> bool {
+        const auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+        return error == std::errc() && end == field.data() + field.size();
+    }
+
+    // Value of count decimal digits, -1 if one is not a digit
+    auto parseDigits(const char* data, size_t count) -> int {
+        int value = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const auto digit = data[i] - '0';
+            if (digit < 0 || digit > 9) {
+                return -1;
+            }
+            value = value * 10 + digit;
+        }
+        return value;
+    }
+
+    // Expiry dates as YYYY-MM-DD, read by hand. The time point is local midnight as std::mktime gives it, asked once
+    // per distinct date since a dump only has a few hundred
+    class ExpiryParser {
+    public:
+        auto operator()(std::string_view field) -> std::optional<std::chrono::system_clock::time_point> {
+            if (field.size() != 10 || field[4] != '-' || field[7] != '-') {
+                return std::nullopt;
+            }
+            const auto year = parseDigits(field.data(), 4);
+            const auto month = parseDigits(field.data() + 5, 2);
+            const auto day = parseDigits(field.data() + 8, 2);
+            if (year < 1900 || month < 1 || month > 12 || day < 1 || day > 31) {
+                return std::nullopt;
+            }
+
+            const auto [it, inserted] = dates_.try_emplace(year * 10'000 + month * 100 + day);
+            if (inserted) {
+                std::tm tm = {};
+                tm.tm_year = year - 1900;
+                tm.tm_mon = month - 1;
+                tm.tm_mday = day;
+                it->second = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+            }
+            return it->second;
+        }
+
+    private:
+        std::unordered_map<int, std::chrono::system_clock::time_point> dates_;
+    };
+}
+
+InstrumentCsvParser::InstrumentCsvParser(size_t max_threads)
+    : max_threads_(max_threads ? max_threads : std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+}
+
+bool InstrumentCsvParser::parse(std::string_view csv) {
+    chunks_.clear();
+    records_.clear();
+    num_lines_ = 0;
+    num_rejected_ = 0;
+
+    // Skip the header line
+    const auto header_end = csv.find('\n');
+    if (header_end == std::string_view::npos) {
+        return false;
+    }
+    csv.remove_prefix(header_end + 1);
+
+    // Chunks of about the same size, each ending after a newline
+    chunks_.resize(std::clamp<size_t>(csv.size() / MIN_CHUNK_SIZE, 1, max_threads_));
+    size_t begin = 0;
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        auto end = csv.size();
+        if (i + 1 < chunks_.size()) {
+            end = csv.find('\n', std::max(begin, csv.size() * (i + 1) / chunks_.size()));
+            end = (end == std::string_view::npos ? csv.size() : end + 1);
+        }
+        chunks_[i].csv = csv.substr(begin, end - begin);
+        begin = end;
+    }
+
+    // The first chunk is parsed on the calling thread
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < chunks_.size(); ++i) {
+        threads.emplace_back([this, i]() { parseChunk(chunks_[i]); });
+    }
+    parseChunk(chunks_[0]);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Joined in the order of the dump, a later row of a token or symbol is the one the master finds
+    size_t num_records = 0;
+    for (const auto& chunk : chunks_) {
+        num_records += chunk.records.size();
+        num_lines_ += chunk.num_lines;
+        num_rejected_ += chunk.num_rejected;
+    }
+    records_.reserve(num_records);
+    for (auto& chunk : chunks_) {
+        records_.insert(records_.end(), chunk.records.begin(), chunk.records.end());
+        chunk.records = {};
+    }
+
+    return !records_.empty();
+}
+
+void InstrumentCsvParser::parseChunk(Chunk& chunk) {
+    ExpiryParser parseExpiry;
+    std::array<std::string_view, NUM_COLUMNS> fields;
+    chunk.records.reserve(chunk.csv.size() / BYTES_PER_RECORD);
+
+    const char* position = chunk.csv.data();
+    const char* const end = position + chunk.csv.size();
+    while (position != end) {
+        ++chunk.num_lines;
+
+        // Fields up to the end of the line, position is left after its newline
+        size_t num_fields = 0;
+        for (bool line_end = false; !line_end; ++num_fields) {
+            auto delimiter = findDelimiter(position, end);
+            std::string_view field(position, static_cast<size_t>(delimiter - position));
+            if (delimiter != end && *delimiter == '"') {
+                // Quotes toggle quoting and a doubled quote inside quotes is a quote, copied to the arena unquoted
+                auto& value = chunk.arena.emplace_back(field);
+                bool quoted = false;
+                for (; delimiter != end && *delimiter != '\n' && (quoted || *delimiter != ','); ++delimiter) {
+                    if (*delimiter != '"') {
+                        value += *delimiter;
+                    } else if (quoted && delimiter + 1 != end && delimiter[1] == '"') {
+                        value += '"';
+                        ++delimiter;
+                    } else {
+                        quoted = !quoted;
+                    }
+                }
+                field = value;
+            }
+
+            line_end = (delimiter == end || *delimiter == '\n');
+            position = (delimiter == end ? end : delimiter + 1);
+            if (num_fields < NUM_COLUMNS) {
+                fields[num_fields] = trim(field);
+            }
+        }
+
+        InstrumentRecord record;
+        bool valid = (num_fields >= NUM_COLUMNS && parseNumber(fields[0], record.instrument_token) &&
+                      parseNumber(fields[1], record.exchange_token));
+        if (valid) {
+            record.trading_symbol = fields[2];
+            record.name = fields[3];
+            valid &= (fields[4].empty() || parseNumber(fields[4], record.last_price));
+            if (!fields[5].empty()) {
+                record.expiry = parseExpiry(fields[5]);
+            }
+            if (!fields[6].empty()) {
+                double strike = 0.0;
+                valid &= parseNumber(fields[6], strike);
+                record.strike = strike;
+            }
+            valid &= (fields[7].empty() || parseNumber(fields[7], record.tick_size));
+            valid &= (fields[8].empty() || parseNumber(fields[8], record.lot_size));
+            record.instrument_type = InstrumentTokenManager::stringToInstrumentType(fields[9]);
+            record.segment = fields[10];
+            record.exchange = InstrumentTokenManager::stringToExchange(fields[11]);
+        }
+
+        if (valid) {
+            chunk.records.push_back(record);
+        } else {
+            ++chunk.num_rejected;
+        }
+    }
+}
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "trading/adapters/zerodha/market_data/instrument_master.h"
+
+namespace Adapter {
+namespace Zerodha {
+
+/**
+ * InstrumentCsvParser - Parses the Kite instruments dump into the records an InstrumentMaster is built from
+ *
+ * The dump is split at line boundaries into one chunk per thread, each thread parses its chunk into its own records
+ * and the records are joined in the order of the dump. Fields are found with a 16 byte vectorised search for the
+ * delimiters and kept as views of the dump, numbers are read with std::from_chars and expiry dates by hand. Only
+ * fields with quotes in them are copied, unquoted into an arena of the parser. A field cannot span lines, as in the
+ * dump Kite serves.
+ */
+class InstrumentCsvParser final {
+public:
+    // Chunks smaller than this are not worth a thread
+    static constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+    /**
+     * @param max_threads Threads to parse with at most, 0 for one per hardware thread
+     */
+    explicit InstrumentCsvParser(size_t max_threads = 0);
+
+    /**
+     * Parse a dump starting with a header line, lines that are not a valid instrument are skipped and counted
+     *
+     * The records view the dump and the parser, they are valid while both are and until the next parse
+     *
+     * @return true if at least one instrument was parsed
+     */
+    bool parse(std::string_view csv);
+
+    const std::vector<InstrumentRecord>& records() const { return records_; }
+
+    // Lines after the header, lines skipped and threads used by the last parse
+    size_t numLines() const { return num_lines_; }
+    size_t numRejected() const { return num_rejected_; }
+    size_t numThreads() const { return chunks_.size(); }
+
+    // Deleted copy & move constructors and assignment-operators
+    InstrumentCsvParser(const InstrumentCsvParser&) = delete;
+    InstrumentCsvParser(const InstrumentCsvParser&&) = delete;
+    InstrumentCsvParser& operator=(const InstrumentCsvParser&) = delete;
+    InstrumentCsvParser& operator=(const InstrumentCsvParser&&) = delete;
+
+private:
+    // Records of one chunk, parsed by one thread
+    struct Chunk {
+        std::string_view csv;
+        std::vector<InstrumentRecord> records;
+        std::deque<std::string> arena;    // Fields unquoted, a deque so the views of earlier ones stay valid
+        size_t num_lines = 0;
+        size_t num_rejected = 0;
+    };
+
+    static void parseChunk(Chunk& chunk);
+
+    size_t max_threads_;
+    std::vector<Chunk> chunks_;
+    std::vector<InstrumentRecord> records_;
+    size_t num_lines_ = 0;
+    size_t num_rejected_ = 0;
+};
+
+} // namespace Zerodha
+} // namespace Adapter
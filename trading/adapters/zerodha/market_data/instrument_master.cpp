@@ -0,0 +1,522 @@
+#include "instrument_master.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Adapter {
+namespace Zerodha {
+
+namespace {
+    // "KITEIMS1" read as a little endian integer
+    constexpr uint64_t INSTRUMENT_MASTER_MAGIC = 0x31534d494554494b;
+    constexpr uint32_t INSTRUMENT_MASTER_VERSION = 2;
+
+    // Expiry of an instrument without one, strikes without one are NaN
+    constexpr int64_t NO_EXPIRY = std::numeric_limits<int64_t>::min();
+
+    // Start of the file, the sections follow in the order of InstrumentMasterLayout, each 8 byte aligned
+    struct InstrumentMasterHeader {
+        uint64_t magic = INSTRUMENT_MASTER_MAGIC;
+        uint32_t version = INSTRUMENT_MASTER_VERSION;
+        uint32_t num_rows = 0;
+        uint32_t token_slots = 0;
+        uint32_t symbol_slots = 0;
+        uint32_t underlying_slots = 0;
+        uint32_t num_underlyings = 0;
+        uint32_t num_future_rows = 0;
+        uint32_t num_option_rows = 0;
+        uint32_t pool_size = 0;
+        uint32_t reserved = 0;
+        uint64_t file_size = 0;
+    };
+
+    // Offsets of the sections, widest values first
+    struct InstrumentMasterLayout {
+        size_t expiries, last_prices, strikes, tick_sizes;
+        size_t trading_symbols, names, segments, underlyings;
+        size_t instrument_tokens, exchange_tokens, lot_sizes;
+        size_t token_slots, symbol_slots, underlying_slots, future_rows, option_rows;
+        size_t instrument_types, exchanges, pool;
+        size_t file_size;
+    };
+
+    auto layoutOf(const InstrumentMasterHeader& header) -> InstrumentMasterLayout {
+        size_t offset = sizeof(InstrumentMasterHeader);
+        const auto section = [&offset](size_t bytes) {
+            const auto start = offset;
+            offset = (offset + bytes + 7) & ~size_t{7};
+            return start;
+        };
+
+        const size_t rows = header.num_rows;
+        InstrumentMasterLayout layout;
+        layout.expiries = section(rows * sizeof(int64_t));
+        layout.last_prices = section(rows * sizeof(double));
+        layout.strikes = section(rows * sizeof(double));
+        layout.tick_sizes = section(rows * sizeof(double));
+        layout.trading_symbols = section(rows * sizeof(InstrumentMaster::StringRef));
+        layout.names = section(rows * sizeof(InstrumentMaster::StringRef));
+        layout.segments = section(rows * sizeof(InstrumentMaster::StringRef));
+        layout.underlyings = section(header.num_underlyings * sizeof(InstrumentMaster::Underlying));
+        layout.instrument_tokens = section(rows * sizeof(int32_t));
+        layout.exchange_tokens = section(rows * sizeof(int32_t));
+        layout.lot_sizes = section(rows * sizeof(int32_t));
+        layout.token_slots = section(size_t{header.token_slots} * sizeof(uint32_t));
+        layout.symbol_slots = section(size_t{header.symbol_slots} * sizeof(uint32_t));
+        layout.underlying_slots = section(size_t{header.underlying_slots} * sizeof(uint32_t));
+        layout.future_rows = section(header.num_future_rows * sizeof(uint32_t));
+        layout.option_rows = section(header.num_option_rows * sizeof(uint32_t));
+        layout.instrument_types = section(rows);
+        layout.exchanges = section(rows);
+        layout.pool = section(header.pool_size);
+        layout.file_size = offset;
+        return layout;
+    }
+
+    template<typename T>
+    auto column(std::vector<char>& image, size_t offset) -> T* {
+        return reinterpret_cast<T*>(image.data() + offset);
+    }
+
+    template<typename T>
+    auto column(const char* base, size_t offset) -> const T* {
+        return reinterpret_cast<const T*>(base + offset);
+    }
+
+    // Finalizer of MurmurHash3, spreads tokens differing only in their high bits over the low ones
+    auto mix(uint32_t x) -> uint32_t {
+        x ^= x >> 16;
+        x *= 0x85ebca6bU;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35U;
+        x ^= x >> 16;
+        return x;
+    }
+
+    auto hashToken(int32_t instrument_token) -> uint32_t {
+        return mix(static_cast<uint32_t>(instrument_token));
+    }
+
+    // FNV-1a of the string, seeded with the exchange for trading symbols
+    auto hashString(std::string_view value, uint32_t seed) -> uint32_t {
+        uint32_t hash = 2166136261U ^ seed;
+        for (const auto c : value) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619U;
+        }
+        return mix(hash);
+    }
+
+    // Twice the keys rounded up to a power of two, so probing always ends at an empty slot
+    auto tableSize(size_t keys) -> uint32_t {
+        return std::bit_ceil(static_cast<uint32_t>(std::max<size_t>(2 * keys, 2)));
+    }
+}
+
+std::vector<char> InstrumentMaster::build(const std::vector<InstrumentRecord>& instruments) {
+    if (instruments.size() >= std::numeric_limits<uint32_t>::max() / 2) {
+        return {};
+    }
+
+    InstrumentMasterHeader header;
+    header.num_rows = static_cast<uint32_t>(instruments.size());
+
+    // Each distinct string is pooled once, names and segments repeat across thousands of rows
+    std::string pool;
+    std::unordered_map<std::string_view, StringRef> pooled;
+    const auto intern = [&](std::string_view value) {
+        const auto [it, inserted] = pooled.try_emplace(value, StringRef{static_cast<uint32_t>(pool.size()), static_cast<uint32_t>(value.size())});
+        if (inserted) {
+            pool += value;
+        }
+        return it->second;
+    };
+
+    std::vector<StringRef> trading_symbols, names, segments;
+    trading_symbols.reserve(instruments.size());
+    names.reserve(instruments.size());
+    segments.reserve(instruments.size());
+    for (const auto& instrument : instruments) {
+        trading_symbols.push_back(intern(instrument.trading_symbol));
+        names.push_back(intern(instrument.name));
+        segments.push_back(intern(instrument.segment));
+    }
+
+    // NFO futures of each underlying by expiry, those without an expiry last, and its NFO options with an expiry and a
+    // strike by expiry, calls before puts, then strike
+    const auto is_option = [](const InstrumentRecord& instrument) {
+        return (instrument.instrument_type == InstrumentType::CE || instrument.instrument_type == InstrumentType::PE) && instrument.expiry &&
+               instrument.strike && !std::isnan(*instrument.strike);
+    };
+    std::map<std::string_view, std::pair<std::vector<uint32_t>, std::vector<uint32_t>>> derivatives_by_name;
+    for (uint32_t row = 0; row < header.num_rows; ++row) {
+        const auto& instrument = instruments[row];
+        if (instrument.exchange != Exchange::NFO || instrument.name.empty()) {
+            continue;
+        }
+        if (instrument.instrument_type == InstrumentType::FUT) {
+            derivatives_by_name[instrument.name].first.push_back(row);
+        } else if (is_option(instrument)) {
+            derivatives_by_name[instrument.name].second.push_back(row);
+        }
+    }
+    std::vector<Underlying> underlyings;
+    std::vector<uint32_t> future_rows, option_rows;
+    for (auto& [name, rows] : derivatives_by_name) {
+        auto& [futures, options] = rows;
+        std::stable_sort(futures.begin(), futures.end(), [&instruments](uint32_t a, uint32_t b) {
+            const auto& lhs = instruments[a].expiry;
+            const auto& rhs = instruments[b].expiry;
+            return lhs && (!rhs || *lhs < *rhs);
+        });
+        std::stable_sort(options.begin(), options.end(), [&instruments](uint32_t a, uint32_t b) {
+            const auto& lhs = instruments[a];
+            const auto& rhs = instruments[b];
+            return std::tie(*lhs.expiry, lhs.instrument_type, *lhs.strike) < std::tie(*rhs.expiry, rhs.instrument_type, *rhs.strike);
+        });
+        underlyings.push_back({intern(name), static_cast<uint32_t>(future_rows.size()), static_cast<uint32_t>(futures.size()),
+                               static_cast<uint32_t>(option_rows.size()), static_cast<uint32_t>(options.size())});
+        future_rows.insert(future_rows.end(), futures.begin(), futures.end());
+        option_rows.insert(option_rows.end(), options.begin(), options.end());
+    }
+
+    if (pool.size() > std::numeric_limits<uint32_t>::max()) {
+        return {};
+    }
+    header.token_slots = tableSize(instruments.size());
+    header.symbol_slots = tableSize(instruments.size());
+    header.underlying_slots = tableSize(underlyings.size());
+    header.num_underlyings = static_cast<uint32_t>(underlyings.size());
+    header.num_future_rows = static_cast<uint32_t>(future_rows.size());
+    header.num_option_rows = static_cast<uint32_t>(option_rows.size());
+    header.pool_size = static_cast<uint32_t>(pool.size());
+    const auto layout = layoutOf(header);
+    header.file_size = layout.file_size;
+
+    std::vector<char> image(layout.file_size, 0);
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    const auto expiries = column<int64_t>(image, layout.expiries);
+    const auto last_prices = column<double>(image, layout.last_prices);
+    const auto strikes = column<double>(image, layout.strikes);
+    const auto tick_sizes = column<double>(image, layout.tick_sizes);
+    const auto instrument_tokens = column<int32_t>(image, layout.instrument_tokens);
+    const auto exchange_tokens = column<int32_t>(image, layout.exchange_tokens);
+    const auto lot_sizes = column<int32_t>(image, layout.lot_sizes);
+    const auto instrument_types = column<uint8_t>(image, layout.instrument_types);
+    const auto exchanges = column<uint8_t>(image, layout.exchanges);
+    for (uint32_t row = 0; row < header.num_rows; ++row) {
+        const auto& instrument = instruments[row];
+        expiries[row] = instrument.expiry ? std::chrono::duration_cast<std::chrono::seconds>(instrument.expiry->time_since_epoch()).count() : NO_EXPIRY;
+        last_prices[row] = instrument.last_price;
+        strikes[row] = instrument.strike.value_or(std::numeric_limits<double>::quiet_NaN());
+        tick_sizes[row] = instrument.tick_size;
+        instrument_tokens[row] = instrument.instrument_token;
+        exchange_tokens[row] = instrument.exchange_token;
+        lot_sizes[row] = instrument.lot_size;
+        instrument_types[row] = static_cast<uint8_t>(instrument.instrument_type);
+        exchanges[row] = static_cast<uint8_t>(instrument.exchange);
+    }
+    std::memcpy(image.data() + layout.trading_symbols, trading_symbols.data(), trading_symbols.size() * sizeof(StringRef));
+    std::memcpy(image.data() + layout.names, names.data(), names.size() * sizeof(StringRef));
+    std::memcpy(image.data() + layout.segments, segments.data(), segments.size() * sizeof(StringRef));
+    std::memcpy(image.data() + layout.underlyings, underlyings.data(), underlyings.size() * sizeof(Underlying));
+    std::memcpy(image.data() + layout.future_rows, future_rows.data(), future_rows.size() * sizeof(uint32_t));
+    std::memcpy(image.data() + layout.option_rows, option_rows.data(), option_rows.size() * sizeof(uint32_t));
+    std::memcpy(image.data() + layout.pool, pool.data(), pool.size());
+
+    // Linear probing, a later row with the same key takes over the slot
+    const auto token_slots = column<uint32_t>(image, layout.token_slots);
+    const auto symbol_slots = column<uint32_t>(image, layout.symbol_slots);
+    for (uint32_t row = 0; row < header.num_rows; ++row) {
+        const auto& instrument = instruments[row];
+        for (auto slot = hashToken(instrument.instrument_token) & (header.token_slots - 1);; slot = (slot + 1) & (header.token_slots - 1)) {
+            if (!token_slots[slot] || instruments[token_slots[slot] - 1].instrument_token == instrument.instrument_token) {
+                token_slots[slot] = row + 1;
+                break;
+            }
+        }
+        for (auto slot = hashString(instrument.trading_symbol, static_cast<uint32_t>(instrument.exchange)) & (header.symbol_slots - 1);;
+             slot = (slot + 1) & (header.symbol_slots - 1)) {
+            const auto other = symbol_slots[slot];
+            if (!other || (instruments[other - 1].exchange == instrument.exchange && instruments[other - 1].trading_symbol == instrument.trading_symbol)) {
+                symbol_slots[slot] = row + 1;
+                break;
+            }
+        }
+    }
+    const auto underlying_slots = column<uint32_t>(image, layout.underlying_slots);
+    for (uint32_t i = 0; i < header.num_underlyings; ++i) {
+        const auto& underlying = underlyings[i];
+        auto slot = hashString(std::string_view(pool).substr(underlying.name.offset, underlying.name.length), 0) & (header.underlying_slots - 1);
+        while (underlying_slots[slot]) {
+            slot = (slot + 1) & (header.underlying_slots - 1);
+        }
+        underlying_slots[slot] = i + 1;
+    }
+
+    return image;
+}
+
+std::vector<char> InstrumentMaster::build(const std::vector<InstrumentInfo>& instruments) {
+    std::vector<InstrumentRecord> records;
+    records.reserve(instruments.size());
+    for (const auto& instrument : instruments) {
+        records.push_back({instrument.instrument_token, instrument.exchange_token, instrument.trading_symbol, instrument.name,
+                           instrument.last_price, instrument.expiry, instrument.strike, instrument.tick_size, instrument.lot_size,
+                           instrument.instrument_type, instrument.segment, instrument.exchange});
+    }
+    return build(records);
+}
+
+bool InstrumentMaster::write(const std::string& path, const std::vector<char>& image) {
+    if (image.empty()) {
+        return false;
+    }
+
+    const auto temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(image.data(), static_cast<std::streamsize>(image.size()))) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+InstrumentMaster::InstrumentMaster(const std::string& path) {
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st = {};
+    if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(InstrumentMasterHeader)) {
+        ::close(fd);
+        return;
+    }
+
+    const auto size = static_cast<size_t>(st.st_size);
+    auto base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        return;
+    }
+
+    if (attach(static_cast<const char*>(base), size)) {
+        mapped_size_ = size;
+    } else {
+        munmap(base, size);
+    }
+}
+
+InstrumentMaster::InstrumentMaster(std::vector<char> image) : image_(std::move(image)) {
+    if (!attach(image_.data(), image_.size())) {
+        image_.clear();
+    }
+}
+
+InstrumentMaster::~InstrumentMaster() {
+    if (base_ && mapped_size_) {
+        munmap(const_cast<char*>(base_), mapped_size_);
+    }
+}
+
+bool InstrumentMaster::attach(const char* base, size_t size) {
+    if (size < sizeof(InstrumentMasterHeader)) {
+        return false;
+    }
+    InstrumentMasterHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != INSTRUMENT_MASTER_MAGIC || header.version != INSTRUMENT_MASTER_VERSION || header.file_size != size ||
+        !std::has_single_bit(header.token_slots) || header.token_slots <= header.num_rows ||
+        !std::has_single_bit(header.symbol_slots) || header.symbol_slots <= header.num_rows ||
+        !std::has_single_bit(header.underlying_slots) || header.underlying_slots <= header.num_underlyings) {
+        return false;
+    }
+    const auto layout = layoutOf(header);
+    if (layout.file_size != size) {
+        return false;
+    }
+
+    num_rows_ = header.num_rows;
+    instrument_tokens_ = column<int32_t>(base, layout.instrument_tokens);
+    exchange_tokens_ = column<int32_t>(base, layout.exchange_tokens);
+    trading_symbols_ = column<StringRef>(base, layout.trading_symbols);
+    names_ = column<StringRef>(base, layout.names);
+    segments_ = column<StringRef>(base, layout.segments);
+    last_prices_ = column<double>(base, layout.last_prices);
+    expiries_ = column<int64_t>(base, layout.expiries);
+    strikes_ = column<double>(base, layout.strikes);
+    tick_sizes_ = column<double>(base, layout.tick_sizes);
+    lot_sizes_ = column<int32_t>(base, layout.lot_sizes);
+    instrument_types_ = column<uint8_t>(base, layout.instrument_types);
+    exchanges_ = column<uint8_t>(base, layout.exchanges);
+    token_slots_ = column<uint32_t>(base, layout.token_slots);
+    token_mask_ = header.token_slots - 1;
+    symbol_slots_ = column<uint32_t>(base, layout.symbol_slots);
+    symbol_mask_ = header.symbol_slots - 1;
+    underlying_slots_ = column<uint32_t>(base, layout.underlying_slots);
+    underlying_mask_ = header.underlying_slots - 1;
+    underlyings_ = column<Underlying>(base, layout.underlyings);
+    future_rows_ = column<uint32_t>(base, layout.future_rows);
+    option_rows_ = column<uint32_t>(base, layout.option_rows);
+    pool_ = base + layout.pool;
+
+    // Everything the lookups follow must stay inside the image, a damaged cache is rebuilt rather than trusted
+    const auto in_pool = [&header](StringRef ref) { return uint64_t{ref.offset} + ref.length <= header.pool_size; };
+    for (uint32_t row = 0; row < num_rows_; ++row) {
+        if (!in_pool(trading_symbols_[row]) || !in_pool(names_[row]) || !in_pool(segments_[row]) ||
+            instrument_types_[row] > static_cast<uint8_t>(InstrumentType::UNKNOWN) || exchanges_[row] > static_cast<uint8_t>(Exchange::UNKNOWN)) {
+            return false;
+        }
+    }
+    // Probing stops at the first empty slot, a table without one would have the lookup of a missing key spin forever
+    const auto slots_in_range = [](const uint32_t* slots, uint32_t num_slots, uint32_t num_values) {
+        return std::all_of(slots, slots + num_slots, [num_values](uint32_t value) { return value <= num_values; }) &&
+               std::find(slots, slots + num_slots, 0U) != slots + num_slots;
+    };
+    const auto rows_in_range = [this](const uint32_t* rows, uint32_t num_rows) {
+        return std::all_of(rows, rows + num_rows, [this](uint32_t row) { return row < num_rows_; });
+    };
+    if (!slots_in_range(token_slots_, header.token_slots, num_rows_) || !slots_in_range(symbol_slots_, header.symbol_slots, num_rows_) ||
+        !slots_in_range(underlying_slots_, header.underlying_slots, header.num_underlyings) ||
+        !rows_in_range(future_rows_, header.num_future_rows) || !rows_in_range(option_rows_, header.num_option_rows)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < header.num_underlyings; ++i) {
+        const auto& underlying = underlyings_[i];
+        if (!in_pool(underlying.name) || uint64_t{underlying.first} + underlying.count > header.num_future_rows ||
+            uint64_t{underlying.option_first} + underlying.option_count > header.num_option_rows) {
+            return false;
+        }
+    }
+
+    base_ = base;
+    return true;
+}
+
+uint32_t InstrumentMaster::findToken(int32_t instrument_token) const {
+    if (!base_) {
+        return NOT_FOUND;
+    }
+    for (auto slot = hashToken(instrument_token) & token_mask_; token_slots_[slot]; slot = (slot + 1) & token_mask_) {
+        const auto row = token_slots_[slot] - 1;
+        if (instrument_tokens_[row] == instrument_token) {
+            return row;
+        }
+    }
+    return NOT_FOUND;
+}
+
+uint32_t InstrumentMaster::findSymbol(Exchange exchange, std::string_view trading_symbol) const {
+    if (!base_) {
+        return NOT_FOUND;
+    }
+    for (auto slot = hashString(trading_symbol, static_cast<uint32_t>(exchange)) & symbol_mask_; symbol_slots_[slot]; slot = (slot + 1) & symbol_mask_) {
+        const auto row = symbol_slots_[slot] - 1;
+        if (exchanges_[row] == static_cast<uint8_t>(exchange) && tradingSymbol(row) == trading_symbol) {
+            return row;
+        }
+    }
+    return NOT_FOUND;
+}
+
+const InstrumentMaster::Underlying* InstrumentMaster::findUnderlying(std::string_view name) const {
+    if (!base_) {
+        return nullptr;
+    }
+    for (auto slot = hashString(name, 0) & underlying_mask_; underlying_slots_[slot]; slot = (slot + 1) & underlying_mask_) {
+        const auto& underlying = underlyings_[underlying_slots_[slot] - 1];
+        if (string(underlying.name) == name) {
+            return &underlying;
+        }
+    }
+    return nullptr;
+}
+
+std::span<const uint32_t> InstrumentMaster::futures(std::string_view name) const {
+    const auto underlying = findUnderlying(name);
+    return underlying ? std::span<const uint32_t>(future_rows_ + underlying->first, underlying->count) : std::span<const uint32_t>();
+}
+
+std::span<const uint32_t> InstrumentMaster::options(std::string_view name) const {
+    const auto underlying = findUnderlying(name);
+    return underlying ? std::span<const uint32_t>(option_rows_ + underlying->option_first, underlying->option_count) : std::span<const uint32_t>();
+}
+
+std::span<const uint32_t> InstrumentMaster::options(std::string_view name, std::chrono::system_clock::time_point expiry, InstrumentType type,
+                                                    double low_strike, double high_strike) const {
+    const auto rows = options(name);
+    if (rows.empty() || !(low_strike <= high_strike)) {
+        return {};
+    }
+
+    // Two binary searches on the (expiry, type, strike) order of the rows
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(expiry.time_since_epoch()).count();
+    const auto type_value = static_cast<uint8_t>(type);
+    const auto key = [this](uint32_t row) { return std::tie(expiries_[row], instrument_types_[row], strikes_[row]); };
+    const auto first = std::partition_point(rows.begin(), rows.end(), [&](uint32_t row) {
+        return key(row) < std::tie(seconds, type_value, low_strike);
+    });
+    const auto last = std::partition_point(first, rows.end(), [&](uint32_t row) {
+        return key(row) <= std::tie(seconds, type_value, high_strike);
+    });
+    return {first, last};
+}
+
+std::optional<std::chrono::system_clock::time_point> InstrumentMaster::nextOptionExpiry(std::string_view name,
+                                                                                       std::chrono::system_clock::time_point from) const {
+    const auto rows = options(name);
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(from.time_since_epoch()).count();
+    const auto next = std::partition_point(rows.begin(), rows.end(), [&](uint32_t row) { return expiries_[row] < seconds; });
+    return next != rows.end() ? expiry(*next) : std::nullopt;
+}
+
+std::optional<std::chrono::system_clock::time_point> InstrumentMaster::expiry(uint32_t row) const {
+    if (expiries_[row] == NO_EXPIRY) {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::time_point(std::chrono::seconds(expiries_[row]));
+}
+
+std::optional<double> InstrumentMaster::strike(uint32_t row) const {
+    if (std::isnan(strikes_[row])) {
+        return std::nullopt;
+    }
+    return strikes_[row];
+}
+
+InstrumentInfo InstrumentMaster::info(uint32_t row) const {
+    InstrumentInfo info(instrumentToken(row), exchangeToken(row), std::string(tradingSymbol(row)), std::string(name(row)),
+                        exchange(row), instrumentType(row));
+    info.last_price = lastPrice(row);
+    info.expiry = expiry(row);
+    info.strike = strike(row);
+    info.tick_size = tickSize(row);
+    info.lot_size = lotSize(row);
+    info.segment = std::string(segment(row));
+    return info;
+}
+
+} // namespace Zerodha
+} // namespace Adapter
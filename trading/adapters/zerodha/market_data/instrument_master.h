@@ -0,0 +1,199 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "trading/adapters/zerodha/market_data/instrument_token_manager.h"
+
+namespace Adapter {
+namespace Zerodha {
+
+/**
+ * An instrument to build an InstrumentMaster of, the strings view the parsed dump and must outlive the build
+ */
+struct InstrumentRecord {
+    int32_t instrument_token = 0;
+    int32_t exchange_token = 0;
+    std::string_view trading_symbol;
+    std::string_view name;
+    double last_price = 0.0;
+    std::optional<std::chrono::system_clock::time_point> expiry;
+    std::optional<double> strike;
+    double tick_size = 0.05;
+    int32_t lot_size = 1;
+    InstrumentType instrument_type = InstrumentType::UNKNOWN;
+    std::string_view segment;
+    Exchange exchange = Exchange::UNKNOWN;
+};
+
+/**
+ * InstrumentMaster - Read only, memory mapped binary image of the Kite instrument master
+ *
+ * The file holds a header, one column per InstrumentInfo field, a pool of the strings the columns point into and
+ * prebuilt open addressing hash tables by instrument token and by (exchange, trading symbol), plus the rows of the
+ * NFO futures of each underlying sorted by expiry and of its NFO options sorted by (expiry, option type, strike) for
+ * range queries. build() makes the image once per download and write() caches it;
+ * opening the cache maps the file and checks it, after which every lookup reads the mapping in place - no parsing, no
+ * allocation, no index to rebuild.
+ */
+class InstrumentMaster final {
+public:
+    // Row returned by the lookups when nothing matches
+    static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+    /**
+     * Binary image of instruments, the last of several rows with the same token or symbol is the one found
+     */
+    static std::vector<char> build(const std::vector<InstrumentRecord>& records);
+
+    /**
+     * Binary image of instruments held as InstrumentInfo
+     */
+    static std::vector<char> build(const std::vector<InstrumentInfo>& instruments);
+
+    /**
+     * Write an image to path through a temporary file renamed over it, so a process mapping the old file keeps it
+     *
+     * @return true if the file was written
+     */
+    static bool write(const std::string& path, const std::vector<char>& image);
+
+    /**
+     * Map and check the image cached at path, valid() tells whether it could be used
+     */
+    explicit InstrumentMaster(const std::string& path);
+
+    /**
+     * Use an image built in memory, e.g. when it could not be cached
+     */
+    explicit InstrumentMaster(std::vector<char> image);
+
+    ~InstrumentMaster();
+
+    bool valid() const { return base_ != nullptr; }
+
+    uint32_t size() const { return num_rows_; }
+
+    /**
+     * Row of an instrument token, NOT_FOUND if none
+     */
+    uint32_t findToken(int32_t instrument_token) const;
+
+    /**
+     * Row of a trading symbol on an exchange, NOT_FOUND if none
+     */
+    uint32_t findSymbol(Exchange exchange, std::string_view trading_symbol) const;
+
+    /**
+     * Rows of the NFO futures of an underlying (the name column), by expiry
+     */
+    std::span<const uint32_t> futures(std::string_view name) const;
+
+    /**
+     * Rows of the NFO options of an underlying, by expiry, then calls before puts, then strike
+     */
+    std::span<const uint32_t> options(std::string_view name) const;
+
+    /**
+     * Rows of the calls (CE) or puts (PE) of an underlying expiring at expiry with strikes from low_strike to
+     * high_strike, by strike - two binary searches, O(log n)
+     */
+    std::span<const uint32_t> options(std::string_view name, std::chrono::system_clock::time_point expiry, InstrumentType type,
+                                      double low_strike, double high_strike) const;
+
+    /**
+     * First expiry at or after from of the options of an underlying, none if there is none
+     */
+    std::optional<std::chrono::system_clock::time_point> nextOptionExpiry(std::string_view name,
+                                                                          std::chrono::system_clock::time_point from) const;
+
+    // Columns of a row, strings point into the mapping
+    int32_t instrumentToken(uint32_t row) const { return instrument_tokens_[row]; }
+    int32_t exchangeToken(uint32_t row) const { return exchange_tokens_[row]; }
+    std::string_view tradingSymbol(uint32_t row) const { return string(trading_symbols_[row]); }
+    std::string_view name(uint32_t row) const { return string(names_[row]); }
+    std::string_view segment(uint32_t row) const { return string(segments_[row]); }
+    double lastPrice(uint32_t row) const { return last_prices_[row]; }
+    std::optional<std::chrono::system_clock::time_point> expiry(uint32_t row) const;
+    std::optional<double> strike(uint32_t row) const;
+    double tickSize(uint32_t row) const { return tick_sizes_[row]; }
+    int32_t lotSize(uint32_t row) const { return lot_sizes_[row]; }
+    InstrumentType instrumentType(uint32_t row) const { return static_cast<InstrumentType>(instrument_types_[row]); }
+    Exchange exchange(uint32_t row) const { return static_cast<Exchange>(exchanges_[row]); }
+
+    /**
+     * Copy of a row as an InstrumentInfo
+     */
+    InstrumentInfo info(uint32_t row) const;
+
+    // Deleted default, copy & move constructors and assignment-operators
+    InstrumentMaster() = delete;
+    InstrumentMaster(const InstrumentMaster&) = delete;
+    InstrumentMaster(const InstrumentMaster&&) = delete;
+    InstrumentMaster& operator=(const InstrumentMaster&) = delete;
+    InstrumentMaster& operator=(const InstrumentMaster&&) = delete;
+
+    // File format - location of a string in the pool
+    struct StringRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    // The NFO derivatives of one underlying, rows first to first + count of the future rows and option_first to
+    // option_first + option_count of the option rows
+    struct Underlying {
+        StringRef name;
+        uint32_t first;
+        uint32_t count;
+        uint32_t option_first;
+        uint32_t option_count;
+    };
+
+private:
+    std::string_view string(StringRef ref) const { return {pool_ + ref.offset, ref.length}; }
+
+    const Underlying* findUnderlying(std::string_view name) const;
+
+    // Point the columns and tables into an image after checking it, false if it is not a valid image
+    bool attach(const char* base, size_t size);
+
+    const char* base_ = nullptr;
+    size_t mapped_size_ = 0;    // 0 for an image in memory
+    std::vector<char> image_;
+    uint32_t num_rows_ = 0;
+
+    // Columns
+    const int32_t* instrument_tokens_ = nullptr;
+    const int32_t* exchange_tokens_ = nullptr;
+    const StringRef* trading_symbols_ = nullptr;
+    const StringRef* names_ = nullptr;
+    const StringRef* segments_ = nullptr;
+    const double* last_prices_ = nullptr;
+    const int64_t* expiries_ = nullptr;
+    const double* strikes_ = nullptr;
+    const double* tick_sizes_ = nullptr;
+    const int32_t* lot_sizes_ = nullptr;
+    const uint8_t* instrument_types_ = nullptr;
+    const uint8_t* exchanges_ = nullptr;
+
+    // Hash tables of row + 1, 0 for an empty slot, sizes are powers of two
+    const uint32_t* token_slots_ = nullptr;
+    uint32_t token_mask_ = 0;
+    const uint32_t* symbol_slots_ = nullptr;
+    uint32_t symbol_mask_ = 0;
+    const uint32_t* underlying_slots_ = nullptr;
+    uint32_t underlying_mask_ = 0;
+
+    const Underlying* underlyings_ = nullptr;
+    const uint32_t* future_rows_ = nullptr;
+    const uint32_t* option_rows_ = nullptr;
+    const char* pool_ = nullptr;
+};
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -1,10 +1,14 @@
 #include "instrument_token_manager.h"
+#include "instrument_master.h"
+#include "instrument_csv_parser.h"
 
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <iomanip>
+#include <tuple>
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 
@@ -18,15 +22,11 @@ namespace {
         return size * nmemb;
     }
     
-    // Trim whitespace from string
-    std::string trim(const std::string& str) {
-        auto start = std::find_if_not(str.begin(), str.end(), [](unsigned char c) {
-            return std::isspace(c);
+    // ASCII case insensitive comparison with an upper case name
+    bool equalsUpper(std::string_view value, std::string_view upper) {
+        return value.size() == upper.size() && std::equal(value.begin(), value.end(), upper.begin(), [](char a, char b) {
+            return std::toupper(static_cast<unsigned char>(a)) == b;
         });
-        auto end = std::find_if_not(str.rbegin(), str.rend(), [](unsigned char c) {
-            return std::isspace(c);
-        }).base();
-        return (start < end) ? std::string(start, end) : std::string();
     }
     
     // Months for expiry date formatting
@@ -46,8 +46,9 @@ InstrumentTokenManager::InstrumentTokenManager(ZerodhaAuthenticator* authenticat
     // Create cache directory if it doesn't exist
     std::filesystem::create_directories(cache_dir_);
     
-    // Set cache file path
+    // Set cache file paths
     cache_file_ = cache_dir_ + "/instruments.csv";
+    binary_cache_file_ = cache_dir_ + "/instruments.bin";
     
     logger_->log("%:% %() % Initialized InstrumentTokenManager with cache at: %\n",
                 __FILE__, __LINE__, __FUNCTION__, 
@@ -63,7 +64,10 @@ InstrumentTokenManager::~InstrumentTokenManager() {
 
 bool InstrumentTokenManager::initialize() {
     std::lock_guard<std::mutex> lock(mutex_);
-    
+    return loadInstruments();
+}
+
+bool InstrumentTokenManager::loadInstruments() {
     if (initialized_) {
         return true;
     }
@@ -76,6 +80,16 @@ bool InstrumentTokenManager::initialize() {
     bool update_required = shouldRefresh();
     std::string csv_data;
     
+    // A valid cache is mapped as it is, without parsing anything
+    if (!update_required && loadBinaryCache()) {
+        initialized_ = true;
+        logger_->log("%:% %() % Mapped % instruments from binary cache %\n",
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_),
+                    master_->size(), binary_cache_file_.c_str());
+        return true;
+    }
+    
     if (update_required) {
         logger_->log("%:% %() % Cache needs refresh, downloading new instrument data\n",
                     __FILE__, __LINE__, __FUNCTION__, 
@@ -114,14 +128,15 @@ bool InstrumentTokenManager::initialize() {
     }
     
     // Parse CSV data
+    InstrumentCsvParser parser;
     if (!csv_data.empty()) {
-        if (parseCSV(csv_data)) {
-            buildIndices();
+        if (parseCSV(csv_data, parser)) {
+            buildIndices(parser.records());
             initialized_ = true;
             logger_->log("%:% %() % Successfully loaded % instruments\n",
                         __FILE__, __LINE__, __FUNCTION__, 
                         Common::getCurrentTimeStr(&time_str_),
-                        instruments_.size());
+                        parser.records().size());
             return true;
         } else {
             logger_->log("%:% %() % Failed to parse CSV data\n",
@@ -140,13 +155,37 @@ bool InstrumentTokenManager::initialize() {
 int32_t InstrumentTokenManager::getInstrumentToken(const std::string& symbol) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    if (!initialized_ && !initialize()) {
+    if (!initialized_ && !loadInstruments()) {
         logger_->log("%:% %() % Cannot get token, not initialized\n",
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_));
         return 0;
     }
     
+    return findInstrumentToken(symbol);
+}
+
+size_t InstrumentTokenManager::getInstrumentTokens(const std::vector<std::string>& symbols, std::vector<int32_t>& tokens) {
+    tokens.assign(symbols.size(), 0);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!initialized_ && !loadInstruments()) {
+        logger_->log("%:% %() % Cannot get tokens, not initialized\n",
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_));
+        return 0;
+    }
+    
+    size_t found = 0;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        tokens[i] = findInstrumentToken(symbols[i]);
+        found += (tokens[i] != 0);
+    }
+    return found;
+}
+
+int32_t InstrumentTokenManager::findInstrumentToken(const std::string& symbol) {
     // Check if this is an index symbol that needs future lookup
     // Symbols like "NSE:NIFTY 50" or "NSE:BANKNIFTY" would be treated as indices
     auto [exchange, symbol_name] = parseSymbol(symbol);
@@ -179,15 +218,15 @@ int32_t InstrumentTokenManager::getInstrumentToken(const std::string& symbol) {
                             Common::getCurrentTimeStr(&time_str_),
                             index_name.c_str());
                             
-                return getNearestFutureToken(index_name);
+                return findNearestFutureToken(index_name);
             }
         }
     }
     
     // Regular symbol lookup
-    auto it = symbol_index_.find(std::make_pair(exchange, symbol_name));
-    if (it != symbol_index_.end()) {
-        int32_t token = instruments_[it->second].instrument_token;
+    const auto row = master_->findSymbol(exchange, symbol_name);
+    if (row != InstrumentMaster::NOT_FOUND) {
+        int32_t token = master_->instrumentToken(row);
         logger_->log("%:% %() % Found token % for symbol %\n",
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_),
@@ -205,15 +244,19 @@ int32_t InstrumentTokenManager::getInstrumentToken(const std::string& symbol) {
 int32_t InstrumentTokenManager::getNearestFutureToken(const std::string& index_name) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    if (!initialized_ && !initialize()) {
+    if (!initialized_ && !loadInstruments()) {
         logger_->log("%:% %() % Cannot get future token, not initialized\n",
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_));
         return 0;
     }
     
-    auto it = futures_by_index_.find(index_name);
-    if (it == futures_by_index_.end() || it->second.empty()) {
+    return findNearestFutureToken(index_name);
+}
+
+int32_t InstrumentTokenManager::findNearestFutureToken(const std::string& index_name) {
+    const auto futures = master_->futures(index_name);
+    if (futures.empty()) {
         logger_->log("%:% %() % No futures found for index %\n",
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_),
@@ -224,40 +267,20 @@ int32_t InstrumentTokenManager::getNearestFutureToken(const std::string& index_n
     // Get current time
     auto now = std::chrono::system_clock::now();
     
-    // Find the nearest expiry date that's in the future
-    std::optional<size_t> nearest_idx;
-    std::chrono::system_clock::time_point nearest_expiry;
-    
-    for (size_t instrument_idx : it->second) {
-        const auto& instrument = instruments_[instrument_idx];
-        
-        // Skip if no expiry date
-        if (!instrument.expiry.has_value()) {
-            continue;
-        }
-        
-        auto expiry = instrument.expiry.value();
-        
-        // Skip expired contracts
-        if (expiry <= now) {
-            continue;
-        }
-        
-        // If this is the first valid expiry or it's closer than the current nearest
-        if (!nearest_idx.has_value() || expiry < nearest_expiry) {
-            nearest_idx = instrument_idx;
-            nearest_expiry = expiry;
-        }
-    }
+    // The futures are sorted by expiry, the first one not expired yet is the nearest
+    const auto nearest = std::find_if(futures.begin(), futures.end(), [this, now](uint32_t row) {
+        const auto expiry = master_->expiry(row);
+        return expiry && *expiry > now;
+    });
     
-    if (nearest_idx.has_value()) {
-        int32_t token = instruments_[*nearest_idx].instrument_token;
+    if (nearest != futures.end()) {
+        int32_t token = master_->instrumentToken(*nearest);
         
         logger_->log("%:% %() % Found nearest future contract for % with token % (expiry: %)\n",
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_),
                     index_name.c_str(), token,
-                    instruments_[*nearest_idx].trading_symbol.c_str());
+                    std::string(master_->tradingSymbol(*nearest)));
                     
         return token;
     }
@@ -273,9 +296,9 @@ int32_t InstrumentTokenManager::getNearestFutureToken(const std::string& index_n
                 future_symbol.c_str());
     
     // Try to find this constructed symbol
-    auto symbol_it = symbol_index_.find(std::make_pair(Adapter::Zerodha::Exchange::NFO, future_symbol));
-    if (symbol_it != symbol_index_.end()) {
-        int32_t token = instruments_[symbol_it->second].instrument_token;
+    const auto row = master_->findSymbol(Adapter::Zerodha::Exchange::NFO, future_symbol);
+    if (row != InstrumentMaster::NOT_FOUND) {
+        int32_t token = master_->instrumentToken(row);
         logger_->log("%:% %() % Found constructed future symbol % with token %\n",
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_),
@@ -290,6 +313,65 @@ int32_t InstrumentTokenManager::getNearestFutureToken(const std::string& index_n
     return 0;
 }
 
+std::optional<std::chrono::system_clock::time_point> InstrumentTokenManager::getNearestOptionExpiry(const std::string& underlying) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!initialized_ && !loadInstruments()) {
+        return std::nullopt;
+    }
+    
+    // Expiries are the midnight starting the expiry day, options expiring today still trade
+    return master_->nextOptionExpiry(underlying, std::chrono::system_clock::now() - std::chrono::hours(24));
+}
+
+size_t InstrumentTokenManager::getOptionChain(const std::string& underlying, std::chrono::system_clock::time_point expiry,
+                                              double low_strike, double high_strike, std::vector<OptionContract>& contracts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    contracts.clear();
+    
+    if (!initialized_ && !loadInstruments()) {
+        return 0;
+    }
+    
+    for (const auto type : {InstrumentType::CE, InstrumentType::PE}) {
+        for (const auto row : master_->options(underlying, expiry, type, low_strike, high_strike)) {
+            contracts.push_back({master_->instrumentToken(row), master_->strike(row).value_or(0.0), type});
+        }
+    }
+    return contracts.size();
+}
+
+size_t InstrumentTokenManager::getOptionWindow(const std::string& underlying, std::chrono::system_clock::time_point expiry,
+                                               double spot, double width, std::vector<OptionContract>& contracts,
+                                               size_t max_contracts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    contracts.clear();
+    
+    if (!initialized_ && !loadInstruments()) {
+        return 0;
+    }
+    
+    // Once full, a contract nearer spot replaces the farthest one kept, in the same order ZerodhaOptionWindow keeps them
+    const auto distance = [spot](const OptionContract& contract) {
+        return std::make_tuple(std::abs(contract.strike - spot), contract.type, contract.strike);
+    };
+    for (const auto type : {InstrumentType::CE, InstrumentType::PE}) {
+        for (const auto row : master_->options(underlying, expiry, type, spot * (1.0 - width), spot * (1.0 + width))) {
+            const OptionContract contract{master_->instrumentToken(row), master_->strike(row).value_or(0.0), type};
+            if (contracts.size() < max_contracts) {
+                contracts.push_back(contract);
+                continue;
+            }
+            auto farthest = std::max_element(contracts.begin(), contracts.end(),
+                                             [&](const OptionContract& a, const OptionContract& b) { return distance(a) < distance(b); });
+            if (farthest != contracts.end() && distance(contract) < distance(*farthest)) {
+                *farthest = contract;
+            }
+        }
+    }
+    return contracts.size();
+}
+
 bool InstrumentTokenManager::updateInstrumentData() {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -313,28 +395,23 @@ bool InstrumentTokenManager::updateInstrumentData() {
         return false;
     }
     
-    // Parse CSV data
-    instruments_.clear();
-    token_index_.clear();
-    symbol_index_.clear();
-    name_index_.clear();
-    futures_by_index_.clear();
-    
-    if (!parseCSV(csv_data)) {
+    // Parse CSV data, the current instruments stay in use if it fails
+    InstrumentCsvParser parser;
+    if (!parseCSV(csv_data, parser)) {
         logger_->log("%:% %() % Failed to parse CSV data\n",
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_));
         return false;
     }
     
-    buildIndices();
+    buildIndices(parser.records());
     last_update_time_ = std::chrono::system_clock::now();
     initialized_ = true;
     
     logger_->log("%:% %() % Updated instrument data with % instruments\n",
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_),
-                instruments_.size());
+                parser.records().size());
     
     return true;
 }
@@ -352,14 +429,19 @@ bool InstrumentTokenManager::shouldRefresh() const {
 std::optional<InstrumentInfo> InstrumentTokenManager::getInstrumentInfo(int32_t token) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = token_index_.find(token);
-    if (it != token_index_.end()) {
-        return instruments_[it->second];
+    const auto row = master_ ? master_->findToken(token) : InstrumentMaster::NOT_FOUND;
+    if (row != InstrumentMaster::NOT_FOUND) {
+        return master_->info(row);
     }
     
     return std::nullopt;
 }
 
+size_t InstrumentTokenManager::getNumInstruments() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return master_ ? master_->size() : 0;
+}
+
 std::pair<Exchange, std::string> InstrumentTokenManager::parseSymbol(const std::string& full_symbol) {
     // Parse symbol in format "EXCHANGE:SYMBOL"
     auto pos = full_symbol.find(':');
@@ -385,17 +467,13 @@ std::string InstrumentTokenManager::exchangeToString(Exchange exchange) {
     }
 }
 
-Exchange InstrumentTokenManager::stringToExchange(const std::string& exchange_str) {
-    std::string upper_exchange = exchange_str;
-    std::transform(upper_exchange.begin(), upper_exchange.end(), upper_exchange.begin(),
-                  [](unsigned char c) { return std::toupper(c); });
-    
-    if (upper_exchange == "NSE") return Adapter::Zerodha::Exchange::NSE;
-    if (upper_exchange == "BSE") return Adapter::Zerodha::Exchange::BSE;
-    if (upper_exchange == "NFO") return Adapter::Zerodha::Exchange::NFO;
-    if (upper_exchange == "BFO") return Adapter::Zerodha::Exchange::BFO;
-    if (upper_exchange == "CDS") return Adapter::Zerodha::Exchange::CDS;
-    if (upper_exchange == "MCX") return Adapter::Zerodha::Exchange::MCX;
+Exchange InstrumentTokenManager::stringToExchange(std::string_view exchange_str) {
+    if (equalsUpper(exchange_str, "NSE")) return Adapter::Zerodha::Exchange::NSE;
+    if (equalsUpper(exchange_str, "BSE")) return Adapter::Zerodha::Exchange::BSE;
+    if (equalsUpper(exchange_str, "NFO")) return Adapter::Zerodha::Exchange::NFO;
+    if (equalsUpper(exchange_str, "BFO")) return Adapter::Zerodha::Exchange::BFO;
+    if (equalsUpper(exchange_str, "CDS")) return Adapter::Zerodha::Exchange::CDS;
+    if (equalsUpper(exchange_str, "MCX")) return Adapter::Zerodha::Exchange::MCX;
     
     return Adapter::Zerodha::Exchange::UNKNOWN;
 }
@@ -406,157 +484,40 @@ std::string InstrumentTokenManager::instrumentTypeToString(InstrumentType type)
         case InstrumentType::FUT: return "FUT";
         case InstrumentType::OPT: return "OPT";
         case InstrumentType::INDEX: return "INDEX";
+        case InstrumentType::CE: return "CE";
+        case InstrumentType::PE: return "PE";
         default: return "UNKNOWN";
     }
 }
 
-InstrumentType InstrumentTokenManager::stringToInstrumentType(const std::string& type_str) {
-    std::string upper_type = type_str;
-    std::transform(upper_type.begin(), upper_type.end(), upper_type.begin(),
-                  [](unsigned char c) { return std::toupper(c); });
-    
-    if (upper_type == "EQ") return InstrumentType::EQ;
-    if (upper_type == "FUT") return InstrumentType::FUT;
-    if (upper_type == "OPT") return InstrumentType::OPT;
-    if (upper_type == "INDEX") return InstrumentType::INDEX;
+InstrumentType InstrumentTokenManager::stringToInstrumentType(std::string_view type_str) {
+    if (equalsUpper(type_str, "EQ")) return InstrumentType::EQ;
+    if (equalsUpper(type_str, "FUT")) return InstrumentType::FUT;
+    if (equalsUpper(type_str, "OPT")) return InstrumentType::OPT;
+    if (equalsUpper(type_str, "INDEX")) return InstrumentType::INDEX;
+    if (equalsUpper(type_str, "CE")) return InstrumentType::CE;
+    if (equalsUpper(type_str, "PE")) return InstrumentType::PE;
     
     return InstrumentType::UNKNOWN;
 }
 
-bool InstrumentTokenManager::parseCSV(const std::string& csv_data) {
-    std::istringstream stream(csv_data);
-    std::string line;
-    
-    // Skip header line
-    if (!std::getline(stream, line)) {
-        logger_->log("%:% %() % CSV data is empty\n",
+bool InstrumentTokenManager::parseCSV(const std::string& csv_data, InstrumentCsvParser& parser) {
+    const auto start = Common::getSystemNanos();
+    if (!parser.parse(csv_data)) {
+        logger_->log("%:% %() % No instruments in % bytes of CSV data\n",
                     __FILE__, __LINE__, __FUNCTION__, 
-                    Common::getCurrentTimeStr(&time_str_));
+                    Common::getCurrentTimeStr(&time_str_),
+                    csv_data.size());
         return false;
     }
     
-    size_t line_count = 0;
-    size_t valid_count = 0;
-    
-    // Process each line
-    while (std::getline(stream, line)) {
-        line_count++;
-        
-        auto instrument_opt = parseCSVLine(line);
-        if (instrument_opt.has_value()) {
-            instruments_.push_back(std::move(instrument_opt.value()));
-            valid_count++;
-        }
-        
-        // Log progress for large CSVs
-        if (line_count % 10000 == 0) {
-            logger_->log("%:% %() % Processed % CSV lines, % valid instruments\n",
-                        __FILE__, __LINE__, __FUNCTION__, 
-                        Common::getCurrentTimeStr(&time_str_),
-                        line_count, valid_count);
-        }
-    }
-    
-    logger_->log("%:% %() % Finished parsing CSV: % lines, % valid instruments\n",
+    logger_->log("%:% %() % Finished parsing CSV: % lines, % valid instruments, % skipped, % threads, %us\n",
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_),
-                line_count, valid_count);
-    
-    return valid_count > 0;
-}
-
-std::optional<InstrumentInfo> InstrumentTokenManager::parseCSVLine(const std::string& line) {
-    auto fields = splitCSVLine(line);
-    
-    // Zerodha CSV has these columns:
-    // instrument_token, exchange_token, tradingsymbol, name, last_price, expiry, strike, 
-    // tick_size, lot_size, instrument_type, segment, exchange
-    
-    if (fields.size() < 12) {
-        return std::nullopt;
-    }
-    
-    try {
-        InstrumentInfo info;
-        
-        // Parse required fields
-        info.instrument_token = std::stoi(fields[0]);
-        info.exchange_token = std::stoi(fields[1]);
-        info.trading_symbol = fields[2];
-        info.name = fields[3];
-        
-        // Parse optional fields
-        if (!fields[4].empty()) {
-            info.last_price = std::stod(fields[4]);
-        }
-        
-        if (!fields[5].empty()) {
-            info.expiry = parseDate(fields[5]);
-        }
-        
-        if (!fields[6].empty()) {
-            info.strike = std::stod(fields[6]);
-        }
-        
-        if (!fields[7].empty()) {
-            info.tick_size = std::stod(fields[7]);
-        }
-        
-        if (!fields[8].empty()) {
-            info.lot_size = std::stoi(fields[8]);
-        }
-        
-        info.instrument_type = stringToInstrumentType(fields[9]);
-        info.segment = fields[10];
-        info.exchange = stringToExchange(fields[11]);
-        
-        return info;
-    } catch (const std::exception& e) {
-        // Log parsing error but continue with other lines
-        logger_->log("%:% %() % Error parsing CSV line: %\n",
-                    __FILE__, __LINE__, __FUNCTION__, 
-                    Common::getCurrentTimeStr(&time_str_),
-                    e.what());
-        return std::nullopt;
-    }
-}
-
-std::vector<std::string> InstrumentTokenManager::splitCSVLine(const std::string& line) {
-    std::vector<std::string> fields;
-    std::string field;
-    bool in_quotes = false;
-    
-    for (char c : line) {
-        if (c == '"') {
-            in_quotes = !in_quotes;
-        } else if (c == ',' && !in_quotes) {
-            fields.push_back(trim(field));
-            field.clear();
-        } else {
-            field += c;
-        }
-    }
-    
-    // Add the last field
-    fields.push_back(trim(field));
-    
-    return fields;
-}
-
-std::optional<std::chrono::system_clock::time_point> InstrumentTokenManager::parseDate(const std::string& date_str) {
-    // Parse date in format YYYY-MM-DD
-    // Example: 2022-12-29
-    std::tm tm = {};
-    std::istringstream ss(date_str);
-    ss >> std::get_time(&tm, "%Y-%m-%d");
+                parser.numLines(), parser.records().size(), parser.numRejected(), parser.numThreads(),
+                (Common::getSystemNanos() - start) / Common::NANOS_TO_MICROS);
     
-    if (ss.fail()) {
-        return std::nullopt;
-    }
-    
-    // Convert tm to time_point
-    auto time = std::mktime(&tm);
-    return std::chrono::system_clock::from_time_t(time);
+    return true;
 }
 
 std::string InstrumentTokenManager::downloadInstrumentsCSV() {
@@ -715,44 +676,52 @@ bool InstrumentTokenManager::isCacheValid() const {
     }
 }
 
-void InstrumentTokenManager::buildIndices() {
+void InstrumentTokenManager::buildIndices(const std::vector<InstrumentRecord>& instruments) {
     logger_->log("%:% %() % Building lookup indices for % instruments\n",
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_),
-                instruments_.size());
-    
-    token_index_.clear();
-    symbol_index_.clear();
-    name_index_.clear();
-    futures_by_index_.clear();
+                instruments.size());
     
-    for (size_t i = 0; i < instruments_.size(); ++i) {
-        const auto& instrument = instruments_[i];
-        
-        // Index by token
-        token_index_[instrument.instrument_token] = i;
-        
-        // Index by exchange and trading symbol
-        symbol_index_[std::make_pair(instrument.exchange, instrument.trading_symbol)] = i;
-        
-        // Index by name
-        if (!instrument.name.empty()) {
-            name_index_.insert(std::make_pair(instrument.name, i));
-        }
-        
-        // Index futures by underlying index
-        if (instrument.instrument_type == InstrumentType::FUT && 
-            instrument.exchange == Adapter::Zerodha::Exchange::NFO && 
-            !instrument.name.empty()) {
-            futures_by_index_[instrument.name].push_back(i);
-        }
+    // Cached so the next start maps it instead of parsing the CSV, used from memory if that fails
+    auto image = InstrumentMaster::build(instruments);
+    if (InstrumentMaster::write(binary_cache_file_, image)) {
+        logger_->log("%:% %() % Saved % bytes of binary instrument master to %\n",
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_),
+                    image.size(), binary_cache_file_.c_str());
+    } else {
+        logger_->log("%:% %() % Failed to save binary instrument master to %\n",
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_),
+                    binary_cache_file_.c_str());
     }
+    master_ = std::make_unique<InstrumentMaster>(std::move(image));
     
-    logger_->log("%:% %() % Built indices: % tokens, % symbols, % names, % future indices\n",
+    logger_->log("%:% %() % Built indices: % instruments\n",
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_),
-                token_index_.size(), symbol_index_.size(), 
-                name_index_.size(), futures_by_index_.size());
+                master_->size());
+}
+
+bool InstrumentTokenManager::loadBinaryCache() {
+    // A binary cache older than the CSV was not built from it
+    std::error_code error;
+    if (!fileExists(binary_cache_file_) ||
+        std::filesystem::last_write_time(binary_cache_file_, error) < std::filesystem::last_write_time(cache_file_, error)) {
+        return false;
+    }
+    
+    auto master = std::make_unique<InstrumentMaster>(binary_cache_file_);
+    if (!master->valid() || !master->size()) {
+        logger_->log("%:% %() % Binary instrument cache % is not usable, parsing the CSV cache instead\n",
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_),
+                    binary_cache_file_.c_str());
+        return false;
+    }
+    
+    master_ = std::move(master);
+    return true;
 }
 
 bool InstrumentTokenManager::fileExists(const std::string& file_path) const {
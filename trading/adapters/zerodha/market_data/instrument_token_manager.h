@@ -1,6 +1,8 @@
 #pragma once
 
+#include <limits>
 #include <string>
+#include <string_view>
 #include <map>
 #include <set>
 #include <vector>
@@ -19,6 +21,10 @@
 namespace Adapter {
 namespace Zerodha {
 
+class InstrumentMaster;
+class InstrumentCsvParser;
+struct InstrumentRecord;
+
 /**
  * Enumeration of possible exchange types
  */
@@ -40,6 +46,8 @@ enum class InstrumentType {
     FUT,     // Futures
     OPT,     // Options
     INDEX,   // Index
+    CE,      // Call option, as the dump lists options
+    PE,      // Put option
     UNKNOWN  // Unknown instrument type
 };
 
@@ -71,12 +79,21 @@ struct InstrumentInfo {
     InstrumentInfo() = default;
 };
 
+/**
+ * An option of an option chain
+ */
+struct OptionContract {
+    int32_t instrument_token = 0;
+    double strike = 0.0;
+    InstrumentType type = InstrumentType::UNKNOWN;    // CE or PE
+};
+
 /**
  * Class to manage Zerodha instrument tokens
  * 
  * This class handles:
  * - Downloading and parsing the Zerodha instruments CSV
- * - Caching instrument tokens
+ * - Caching the instruments as a binary InstrumentMaster, mapped on later starts instead of parsing the CSV again
  * - Looking up tokens for symbols, including special handling for indices
  * - Refreshing the instrument database daily
  */
@@ -115,6 +132,15 @@ public:
      */
     int32_t getInstrumentToken(const std::string& symbol);
     
+    /**
+     * Get instrument tokens for many symbols at once, under a single lock
+     * 
+     * @param symbols Symbols to look up (format: EXCHANGE:SYMBOL)
+     * @param tokens Filled with the token of each symbol in order, 0 for those not found
+     * @return Number of symbols found
+     */
+    size_t getInstrumentTokens(const std::vector<std::string>& symbols, std::vector<int32_t>& tokens);
+    
     /**
      * Get instrument token for an index future
      * 
@@ -125,6 +151,42 @@ public:
      */
     int32_t getNearestFutureToken(const std::string& index_name);
     
+    /**
+     * Get the nearest expiry of an underlying's options that has not expired yet
+     * 
+     * @param underlying Underlying name (e.g. "NIFTY")
+     * @return Expiry, e.g. the weekly one, or nullopt if there are no live options
+     */
+    std::optional<std::chrono::system_clock::time_point> getNearestOptionExpiry(const std::string& underlying);
+    
+    /**
+     * Get the calls and puts of an underlying's expiry with strikes from low_strike to high_strike
+     * 
+     * Binary searches of the option index, O(log n) plus the contracts found. contracts is cleared
+     * and refilled, its capacity is reused.
+     * 
+     * @param underlying Underlying name (e.g. "NIFTY")
+     * @param expiry Expiry of the options
+     * @param low_strike Lowest strike
+     * @param high_strike Highest strike
+     * @param contracts Calls by strike, then puts by strike
+     * @return Number of contracts
+     */
+    size_t getOptionChain(const std::string& underlying, std::chrono::system_clock::time_point expiry,
+                          double low_strike, double high_strike, std::vector<OptionContract>& contracts);
+    
+    /**
+     * Get the calls and puts of an underlying's expiry with strikes within a fraction of spot
+     * 
+     * @param width Fraction of spot on either side, e.g. 0.05 for strikes within 5% of spot
+     * @param max_contracts Contracts returned at most, those with strikes nearest spot, so a vector reserved for
+     *                      max_contracts never grows
+     * @return Number of contracts, see getOptionChain() - not in calls then puts order once some were left out
+     */
+    size_t getOptionWindow(const std::string& underlying, std::chrono::system_clock::time_point expiry,
+                           double spot, double width, std::vector<OptionContract>& contracts,
+                           size_t max_contracts = std::numeric_limits<size_t>::max());
+    
     /**
      * Update the instrument data
      * 
@@ -149,6 +211,11 @@ public:
      */
     std::optional<InstrumentInfo> getInstrumentInfo(int32_t token) const;
     
+    /**
+     * Number of instruments loaded, 0 before initialize()
+     */
+    size_t getNumInstruments() const;
+    
     /**
      * Parse exchange and symbol from a formatted string
      * 
@@ -171,7 +238,7 @@ public:
      * @param exchange_str Exchange string
      * @return Exchange enum
      */
-    static Exchange stringToExchange(const std::string& exchange_str);
+    static Exchange stringToExchange(std::string_view exchange_str);
     
     /**
      * Convert InstrumentType enum to string
@@ -187,20 +254,20 @@ public:
      * @param type_str InstrumentType string
      * @return InstrumentType enum
      */
-    static InstrumentType stringToInstrumentType(const std::string& type_str);
+    static InstrumentType stringToInstrumentType(std::string_view type_str);
 
 private:
-    // Parse CSV data into instrument list
-    bool parseCSV(const std::string& csv_data);
+    // Load the instruments from the binary cache or else the CSV, mutex_ must be held
+    bool loadInstruments();
     
-    // Parse a single CSV line
-    std::optional<InstrumentInfo> parseCSVLine(const std::string& line);
+    // Token of a symbol, mutex_ must be held
+    int32_t findInstrumentToken(const std::string& symbol);
     
-    // Split a CSV line into fields, handling quoted fields correctly
-    std::vector<std::string> splitCSVLine(const std::string& line);
+    // Nearest future of an index, mutex_ must be held
+    int32_t findNearestFutureToken(const std::string& index_name);
     
-    // Parse date string into time_point
-    std::optional<std::chrono::system_clock::time_point> parseDate(const std::string& date_str);
+    // Parse CSV data into the parser's records, which view csv_data
+    bool parseCSV(const std::string& csv_data, InstrumentCsvParser& parser);
     
     // Download instruments CSV from Zerodha API
     std::string downloadInstrumentsCSV();
@@ -214,8 +281,11 @@ private:
     // Check if cache is valid (not expired)
     bool isCacheValid() const;
     
-    // Build lookup indices
-    void buildIndices();
+    // Build the binary instrument master with its lookup indices, cache it and switch to it
+    void buildIndices(const std::vector<InstrumentRecord>& instruments);
+    
+    // Map the binary cache if it is at least as recent as the CSV cache
+    bool loadBinaryCache();
     
     // Check if a file exists
     bool fileExists(const std::string& file_path) const;
@@ -241,20 +311,13 @@ private:
     // Cache directory
     std::string cache_dir_;
     std::string cache_file_;
+    std::string binary_cache_file_;
     
     // Last update time
     std::chrono::system_clock::time_point last_update_time_;
     
-    // Instrument storage
-    std::vector<InstrumentInfo> instruments_;
-    
-    // Lookup indices for fast access
-    std::unordered_map<int32_t, size_t> token_index_;  // token -> index in instruments_
-    std::map<std::pair<Exchange, std::string>, size_t> symbol_index_;  // (exchange, symbol) -> index
-    std::multimap<std::string, size_t> name_index_;  // index name -> indices of related instruments
-    
-    // Future contract info
-    std::map<std::string, std::vector<size_t>> futures_by_index_;  // index name -> indices of future contracts
+    // Instruments with their token, symbol and futures indices, mapped from the binary cache or built from the CSV
+    std::unique_ptr<InstrumentMaster> master_;
     
     // Thread safety
     mutable std::mutex mutex_;
@@ -0,0 +1,244 @@
+#include "kite_tick_decoder.h"
+
+#include <immintrin.h>
+
+namespace Adapter {
+namespace Zerodha {
+
+namespace {
+    using Mask = std::array<uint8_t, 16>;
+
+    /// Shuffle of 4 big-endian int32s into host order.
+    constexpr Mask BSWAP32 = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+
+    /// Depth entries are 3 words - quantity, price, then orders and padding. Shuffle of 4 words starting at the given
+    /// word of an entry: quantity and price swapped as int32, orders swapped as int16 and the padding cleared (an
+    /// index with the top bit set writes a zero byte).
+    constexpr auto depthMask(size_t phase) {
+        Mask mask{};
+        for (size_t word = 0; word < 4; ++word) {
+            const auto base = static_cast<uint8_t>(word * 4);
+            if ((phase + word) % 3 == 2) {
+                mask[base] = base + 1;
+                mask[base + 1] = base;
+                mask[base + 2] = 0x80;
+                mask[base + 3] = 0x80;
+            } else {
+                for (uint8_t byte = 0; byte < 4; ++byte) {
+                    mask[base + byte] = base + 3 - byte;
+                }
+            }
+        }
+        return mask;
+    }
+
+    constexpr std::array<Mask, 3> DEPTH_MASKS = {depthMask(0), depthMask(1), depthMask(2)};
+
+    /// The same for 8 words, in-lane shuffles so the upper lane starts 4 words further into the entries.
+    constexpr auto depthMask256(size_t phase) {
+        std::array<uint8_t, 32> mask{};
+        const auto low = depthMask(phase);
+        const auto high = depthMask((phase + 1) % 3);
+        for (size_t byte = 0; byte < 16; ++byte) {
+            mask[byte] = low[byte];
+            mask[16 + byte] = high[byte];
+        }
+        return mask;
+    }
+
+    constexpr std::array<std::array<uint8_t, 32>, 3> DEPTH_MASKS_256 = {depthMask256(0), depthMask256(1), depthMask256(2)};
+
+    constexpr size_t DEPTH_OFFSET = 64;
+}
+
+KiteTickDecoder::KiteTickDecoder() noexcept {
+    setKernel(Kernel::AVX2);
+}
+
+void KiteTickDecoder::setKernel(Kernel kernel) noexcept {
+    __builtin_cpu_init();
+    if (kernel == Kernel::AVX2 && !__builtin_cpu_supports("avx2"))
+        kernel = Kernel::SSSE3;
+    if (kernel == Kernel::SSSE3 && !__builtin_cpu_supports("ssse3"))
+        kernel = Kernel::SCALAR;
+    kernel_ = kernel;
+}
+
+bool KiteTickDecoder::decodePacket(const char* data, size_t length, KiteTick* tick) const noexcept {
+    if (length < LTP_PACKET_LENGTH) {
+        return false;
+    }
+
+    if (isIndexToken(load32(data))) {
+        if (length < INDEX_QUOTE_PACKET_LENGTH) {
+            return false;
+        }
+        tick->type = MarketUpdateType::INDEX;
+        decodeIndex(data, length, tick);
+        return true;
+    }
+
+    switch (length) {
+        case LTP_PACKET_LENGTH:
+            tick->type = MarketUpdateType::LTP;
+            tick->instrument_token = load32(data);
+            tick->last_price = load32(data + 4);
+            return true;
+        case QUOTE_PACKET_LENGTH:
+            tick->type = MarketUpdateType::QUOTE;
+            switch (kernel_) {
+                case Kernel::AVX2:
+                    decodeQuoteAvx2(data, tick);
+                    break;
+                case Kernel::SSSE3:
+                    decodeQuoteSsse3(data, tick);
+                    break;
+                case Kernel::SCALAR:
+                    decodeQuoteScalar(data, tick);
+                    break;
+            }
+            return true;
+        case FULL_PACKET_LENGTH:
+            tick->type = MarketUpdateType::FULL;
+            switch (kernel_) {
+                case Kernel::AVX2:
+                    decodeFullAvx2(data, tick);
+                    break;
+                case Kernel::SSSE3:
+                    decodeFullSsse3(data, tick);
+                    break;
+                case Kernel::SCALAR:
+                    decodeFullScalar(data, tick);
+                    break;
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+void KiteTickDecoder::decodeIndex(const char* data, size_t length, KiteTick* tick) noexcept {
+    // Index packet format:
+    // Bytes 0-3: Token
+    // Bytes 4-7: Last traded price
+    // Bytes 8-11: High of the day
+    // Bytes 12-15: Low of the day
+    // Bytes 16-19: Open of the day
+    // Bytes 20-23: Close of the day
+    // Bytes 24-27: Price change (If mode is quote, the packet ends here)
+    // Bytes 28-31: Exchange timestamp (only in full mode)
+    tick->instrument_token = load32(data);
+    tick->last_price = load32(data + 4);
+    tick->high_price = load32(data + 8);
+    tick->low_price = load32(data + 12);
+    tick->open_price = load32(data + 16);
+    tick->close_price = load32(data + 20);
+    if (length >= INDEX_FULL_PACKET_LENGTH) {
+        tick->exchange_timestamp = load32(data + 28);
+    }
+}
+
+void KiteTickDecoder::decodeQuoteScalar(const char* data, KiteTick* tick) noexcept {
+    tick->instrument_token = load32(data);
+    tick->last_price = load32(data + 4);
+    tick->last_quantity = load32(data + 8);
+    tick->average_price = load32(data + 12);
+    tick->volume = load32(data + 16);
+    tick->buy_quantity = load32(data + 20);
+    tick->sell_quantity = load32(data + 24);
+    tick->open_price = load32(data + 28);
+    tick->high_price = load32(data + 32);
+    tick->low_price = load32(data + 36);
+    tick->close_price = load32(data + 40);
+}
+
+void KiteTickDecoder::decodeFullScalar(const char* data, KiteTick* tick) noexcept {
+    decodeQuoteScalar(data, tick);
+    tick->last_trade_time = load32(data + 44);
+    tick->open_interest = load32(data + 48);
+    tick->open_interest_day_high = load32(data + 52);
+    tick->open_interest_day_low = load32(data + 56);
+    tick->exchange_timestamp = load32(data + 60);
+
+    // 5 bid then 5 ask entries of quantity, price, orders and 2 bytes of padding
+    for (size_t i = 0; i < 10; ++i) {
+        const char* entry = data + DEPTH_OFFSET + i * sizeof(MarketDepthEntry);
+        auto& level = (i < 5 ? tick->bids[i] : tick->asks[i - 5]);
+        level.quantity = load32(entry);
+        level.price = load32(entry + 4);
+        level.orders = static_cast<int16_t>(load16(entry + 8));
+        level.padding = 0;
+    }
+}
+
+__attribute__((target("ssse3")))
+void KiteTickDecoder::decodeQuoteSsse3(const char* data, KiteTick* tick) noexcept {
+    const auto bswap = _mm_loadu_si128(reinterpret_cast<const __m128i*>(BSWAP32.data()));
+    auto* out = reinterpret_cast<char*>(tick);
+
+    // Words 0-7, then 7-10 overlapping the block before so nothing past the packet is read
+    for (const size_t offset : {0, 16, 28}) {
+        const auto words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + offset), _mm_shuffle_epi8(words, bswap));
+    }
+}
+
+__attribute__((target("ssse3")))
+void KiteTickDecoder::decodeFullSsse3(const char* data, KiteTick* tick) noexcept {
+    const auto bswap = _mm_loadu_si128(reinterpret_cast<const __m128i*>(BSWAP32.data()));
+    auto* out = reinterpret_cast<char*>(tick);
+
+    for (size_t offset = 0; offset < DEPTH_OFFSET; offset += 16) {
+        const auto words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + offset), _mm_shuffle_epi8(words, bswap));
+    }
+
+    // Depth words 0-27 in blocks of 4, the mask repeating every 3 blocks, then words 26-29
+    const __m128i masks[3] = {
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(DEPTH_MASKS[0].data())),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(DEPTH_MASKS[1].data())),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(DEPTH_MASKS[2].data()))
+    };
+    for (size_t block = 0; block < 7; ++block) {
+        const auto offset = DEPTH_OFFSET + block * 16;
+        const auto words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + offset), _mm_shuffle_epi8(words, masks[block % 3]));
+    }
+    const auto tail = FULL_PACKET_LENGTH - 16;
+    const auto words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + tail));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + tail), _mm_shuffle_epi8(words, masks[2]));
+}
+
+__attribute__((target("avx2")))
+void KiteTickDecoder::decodeQuoteAvx2(const char* data, KiteTick* tick) noexcept {
+    const auto bswap = _mm_loadu_si128(reinterpret_cast<const __m128i*>(BSWAP32.data()));
+    auto* out = reinterpret_cast<char*>(tick);
+
+    // Words 0-7, then 7-10
+    const auto words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_shuffle_epi8(words, _mm256_broadcastsi128_si256(bswap)));
+    const auto tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 28));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 28), _mm_shuffle_epi8(tail, bswap));
+}
+
+__attribute__((target("avx2")))
+void KiteTickDecoder::decodeFullAvx2(const char* data, KiteTick* tick) noexcept {
+    const auto bswap = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(BSWAP32.data())));
+    auto* out = reinterpret_cast<char*>(tick);
+
+    for (size_t offset = 0; offset < DEPTH_OFFSET; offset += 32) {
+        const auto words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + offset), _mm256_shuffle_epi8(words, bswap));
+    }
+
+    // Depth words 0-7, 8-15 and 16-23 start at entry words 0, 2 and 1, then words 22-29 again at entry word 1
+    constexpr std::pair<size_t, size_t> blocks[4] = {{0, 0}, {32, 2}, {64, 1}, {88, 1}};
+    for (const auto& [offset, phase] : blocks) {
+        const auto mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(DEPTH_MASKS_256[phase].data()));
+        const auto words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + DEPTH_OFFSET + offset));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + DEPTH_OFFSET + offset), _mm256_shuffle_epi8(words, mask));
+    }
+}
+
+} // namespace Zerodha
+} // namespace Adapter
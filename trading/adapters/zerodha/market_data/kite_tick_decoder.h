@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace Adapter {
+namespace Zerodha {
+
+// Market data structures
+struct MarketDepthEntry {
+    int32_t quantity;  // Order quantity
+    int32_t price;     // Order price (in paise)
+    int16_t orders;    // Number of orders at this level
+    uint16_t padding;  // 2-byte padding to skip
+};
+
+// Type of market update
+enum class MarketUpdateType {
+    LTP,     // Last trade price update
+    QUOTE,   // Market quote update
+    FULL,    // Full market update
+    INDEX    // Index update
+};
+
+/**
+ * KiteTick - One Kite binary packet decoded to host byte order, integers as sent
+ *
+ * The fields are in the order and at the offsets of a FULL packet, so decoding a packet is a byte shuffle of the
+ * whole packet rather than a conversion per field. Prices are in paise. Only the fields the packet type carries
+ * are written, the others keep whatever the previous packet decoded into this tick left there.
+ */
+struct KiteTick {
+    // Bytes 0-43 - LTP packets stop after last_price
+    int32_t instrument_token;
+    int32_t last_price;
+    int32_t last_quantity;
+    int32_t average_price;
+    int32_t volume;
+    int32_t buy_quantity;
+    int32_t sell_quantity;
+    int32_t open_price;
+    int32_t high_price;
+    int32_t low_price;
+    int32_t close_price;
+
+    // Bytes 44-63 of FULL packets
+    int32_t last_trade_time;
+    int32_t open_interest;
+    int32_t open_interest_day_high;
+    int32_t open_interest_day_low;
+    int32_t exchange_timestamp;
+
+    // Bytes 64-183 of FULL packets
+    std::array<MarketDepthEntry, 5> bids;
+    std::array<MarketDepthEntry, 5> asks;
+
+    MarketUpdateType type;
+};
+
+static_assert(offsetof(KiteTick, last_trade_time) == 44 && offsetof(KiteTick, bids) == 64 &&
+              offsetof(KiteTick, asks) == 124 && offsetof(KiteTick, type) == 184,
+              "KiteTick must mirror the layout of a Kite FULL packet.");
+
+/**
+ * KiteTickDecoder - Decodes Kite binary tick frames into KiteTick
+ *
+ * Kite sends every field big-endian. QUOTE and FULL packets are byte swapped a whole block at a time with SSSE3 or
+ * AVX2 byte shuffles, the shuffle masks of the depth entries also swap the 16-bit order counts and clear the
+ * padding. LTP and index packets are only a few fields and are decoded field by field. The scalar kernel is the
+ * reference the vector kernels are checked against.
+ */
+class KiteTickDecoder {
+public:
+    /// Kernel implementations, the best one supported by the CPU is picked at construction.
+    enum class Kernel : uint8_t {
+        SCALAR = 0,
+        SSSE3 = 1,
+        AVX2 = 2
+    };
+
+    static constexpr size_t LTP_PACKET_LENGTH = 8;
+    static constexpr size_t QUOTE_PACKET_LENGTH = 44;
+    static constexpr size_t FULL_PACKET_LENGTH = 184;
+    static constexpr size_t INDEX_QUOTE_PACKET_LENGTH = 28;
+    static constexpr size_t INDEX_FULL_PACKET_LENGTH = 32;
+
+    KiteTickDecoder() noexcept;
+
+    /**
+     * Decode a binary frame - a 2 byte packet count, then each packet behind its 2 byte length - in one pass
+     *
+     * Decoding stops at the first truncated packet, packets of unknown length are skipped.
+     *
+     * @param data Frame as received on the WebSocket
+     * @param length Length of the frame in bytes
+     * @param emit Sink called with each decoded tick, e.g. copying it into a queue slot
+     * @return Number of packets decoded
+     */
+    template<typename Emit>
+    size_t decodeFrame(const char* data, size_t length, Emit&& emit) {
+        if (length < 2) {
+            return 0;
+        }
+
+        const size_t num_packets = load16(data);
+        size_t offset = 2;
+        size_t decoded = 0;
+        for (size_t i = 0; i < num_packets && offset + 2 <= length; ++i) {
+            const size_t packet_length = load16(data + offset);
+            offset += 2;
+            if (packet_length > length - offset) {
+                break;
+            }
+            if (decodePacket(data + offset, packet_length, &tick_)) {
+                emit(std::as_const(tick_));
+                ++decoded;
+            }
+            offset += packet_length;
+        }
+        return decoded;
+    }
+
+    /**
+     * Decode one packet
+     *
+     * @param data Packet, without its length prefix
+     * @param length Length of the packet in bytes
+     * @param tick Tick to write the fields of the packet into
+     * @return false if the length matches no known packet type, nothing is written then
+     */
+    bool decodePacket(const char* data, size_t length, KiteTick* tick) const noexcept;
+
+    Kernel kernel() const noexcept { return kernel_; }
+
+    /// Force a specific kernel, e.g. to compare implementations. Falls back to what this CPU supports.
+    void setKernel(Kernel kernel) noexcept;
+
+    /// Kite segment of index instruments, kept in the low byte of the instrument token.
+    static constexpr int32_t INDICES_SEGMENT = 9;
+
+    /// Index tokens send their own packet layout
+    static bool isIndexToken(int32_t token) noexcept {
+        return (token & 0xFF) == INDICES_SEGMENT;
+    }
+
+private:
+    static uint16_t load16(const char* data) noexcept {
+        uint16_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return __builtin_bswap16(value);
+    }
+
+    static int32_t load32(const char* data) noexcept {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return static_cast<int32_t>(__builtin_bswap32(value));
+    }
+
+    static void decodeIndex(const char* data, size_t length, KiteTick* tick) noexcept;
+
+    static void decodeQuoteScalar(const char* data, KiteTick* tick) noexcept;
+    static void decodeFullScalar(const char* data, KiteTick* tick) noexcept;
+    static void decodeQuoteSsse3(const char* data, KiteTick* tick) noexcept;
+    static void decodeFullSsse3(const char* data, KiteTick* tick) noexcept;
+    static void decodeQuoteAvx2(const char* data, KiteTick* tick) noexcept;
+    static void decodeFullAvx2(const char* data, KiteTick* tick) noexcept;
+
+    Kernel kernel_ = Kernel::SCALAR;
+
+    // Decoded into by decodeFrame() and handed to the sink
+    KiteTick tick_{};
+};
+
+} // namespace Zerodha
+} // namespace Adapter
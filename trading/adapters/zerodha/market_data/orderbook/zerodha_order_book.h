@@ -1,21 +1,20 @@
 #pragma once
 
 #include <string>
-#include <map>
-#include <vector>
-#include <unordered_map>
+#include <algorithm>
 #include <array>
-#include <memory>
-#include <set>
+#include <span>
+#include <utility>
 #include <limits>
 #include <cstdint>
 
+#include "common/macros.h"
 #include "common/types.h"
+#include "common/fixed_point.h"
 #include "common/logging.h"
 #include "common/time_utils.h"
-#include "common/mem_pool.h"
 #include "exchange/market_data/market_update.h"
-#include "trading/adapters/zerodha/market_data/zerodha_websocket_client.h"
+#include "trading/adapters/zerodha/market_data/zerodha_tick.h"
 
 // Alias to avoid namespace confusion
 namespace ExchangeNS = ::Exchange;
@@ -24,12 +23,13 @@ namespace Adapter {
 namespace Zerodha {
 
 /**
- * ZerodhaOrderBook - Maintains a full limit order book for a Zerodha instrument
- * 
+ * ZerodhaOrderBook - Maintains the 5 level depth of a Zerodha instrument as an order book
+ *
  * This class:
- * - Processes market data updates from Zerodha WebSocket
- * - Builds and maintains a full order book representation
- * - Generates internal exchange market update events
+ * - Keeps the last 5 bid and 5 ask levels of the Kite feed in fixed arrays of integer paise
+ * - Works on the integer ticks as decoded, prices and quantities convert without floating point
+ * - Diffs each FULL packet against them with a merge of the two sorted arrays into ADD/MODIFY/CANCEL events
+ * - Hands every event straight to the caller's sink, no heap allocation per tick
  * - Provides access to current order book state
  */
 class ZerodhaOrderBook {
@@ -38,10 +38,9 @@ public:
      * Price level structure representing aggregated orders at a price
      */
     struct PriceLevel {
-        double price;        // Price in rupees
+        int32_t price;       // Price in paise
         int32_t quantity;    // Quantity at this price
         int16_t orders;      // Number of orders at this price
-        uint64_t last_update_time;  // Timestamp of last update
     };
 
     /**
@@ -52,183 +51,350 @@ public:
         int32_t bid_quantity;
         double ask_price;
         int32_t ask_quantity;
-        
+
         // Default constructor with invalid values
-        BBO() : 
-            bid_price(0.0), 
-            bid_quantity(0), 
-            ask_price(std::numeric_limits<double>::max()), 
+        BBO() :
+            bid_price(0.0),
+            bid_quantity(0),
+            ask_price(std::numeric_limits<double>::max()),
             ask_quantity(0) {}
     };
 
+    static constexpr size_t MAX_DEPTH_LEVELS = 5;  // Maximum depth from Zerodha
+
 public:
     /**
      * Constructor
-     * 
+     *
      * @param ticker_id Internal ticker ID for this instrument
      * @param logger Logger for diagnostic messages
      */
     ZerodhaOrderBook(Common::TickerId ticker_id, Common::Logger* logger);
-    
+
     /**
      * Destructor
      */
     ~ZerodhaOrderBook();
-    
-    /**
-     * Process a Zerodha market update
-     * 
-     * @param update Zerodha market update to process
-     * @return Vector of generated internal market updates
-     */
-    std::vector<ExchangeNS::MEMarketUpdate*> processMarketUpdate(
-        const MarketUpdate& update);
-        
-    /**
-     * Generate market events from price level changes
-     * 
-     * @param current_update Current market update from Zerodha
-     * @return Vector of internal market updates
-     */
-    std::vector<ExchangeNS::MEMarketUpdate*> generateMarketEvents(
-        const MarketUpdate& current_update);
-        
+
     /**
-     * Check for disappeared price levels
-     * 
-     * @param current_update Current market update from Zerodha
-     * @param events Vector to add cancel events to
+     * Process a Zerodha tick
+     *
+     * Only FULL ticks carry depth, other modes just update the last update time. The trade since the
+     * previous tick comes first, then the bid side, then the ask side, each best price first.
+     *
+     * For a moment after the pool rebalances a token, ticks of it still queued on the old connection are
+     * read after fresher ones of the new connection. A FULL tick older by exchange time, or of the same
+     * second with less day volume, than the last one applied is dropped without any event.
+     *
+     * @param tick Zerodha tick to process
+     * @param depth Depth of the tick if it is a FULL tick, nullptr otherwise
+     * @param emit Sink called with each generated internal market update, e.g. copying it into a queue slot
      */
-    void checkForDisappearedLevels(
-        const MarketUpdate& current_update,
-        std::vector<ExchangeNS::MEMarketUpdate*>& events);
-    
+    template<typename Emit>
+    void processMarketUpdate(const ZerodhaTick& tick, const ZerodhaTickDepth* depth, Emit&& emit) {
+        if (tick.type == MarketUpdateType::FULL && depth) {
+            if (UNLIKELY(isStale(tick))) {
+                ++stale_ticks_;
+                return;
+            }
+            if (tick.exchange_timestamp > 0) {
+                last_exchange_timestamp_ = tick.exchange_timestamp;
+            }
+            emitTrade(tick, emit);
+            diffSide<Common::Side::BUY>(depth->bids, depth->bid_orders, bids_, num_bids_, emit);
+            diffSide<Common::Side::SELL>(depth->asks, depth->ask_orders, asks_, num_asks_, emit);
+            updateBBO();
+        }
+
+        last_update_time_ = static_cast<uint64_t>(Common::getCurrentNanos());
+    }
+
     /**
      * Clear the order book
-     * 
-     * @return Vector of cancel events for all orders
+     *
+     * @param emit Sink called with a CANCEL for every level, then a CLEAR for the book
      */
-    std::vector<ExchangeNS::MEMarketUpdate*> clear();
-    
+    template<typename Emit>
+    void clear(Emit&& emit) {
+        for (size_t i = 0; i < num_bids_; ++i) {
+            emitLevel<Common::Side::BUY>(ExchangeNS::MarketUpdateType::CANCEL, bids_[i].price, 0, emit);
+        }
+        for (size_t i = 0; i < num_asks_; ++i) {
+            emitLevel<Common::Side::SELL>(ExchangeNS::MarketUpdateType::CANCEL, asks_[i].price, 0, emit);
+        }
+
+        ExchangeNS::MEMarketUpdate clear_event;
+        clear_event.type_ = ExchangeNS::MarketUpdateType::CLEAR;
+        clear_event.ticker_id_ = ticker_id_;
+        emit(std::as_const(clear_event));
+
+        reset();
+    }
+
     /**
      * Update best bid/offer cache
      */
     void updateBBO();
-    
+
     /**
      * Get best bid price
-     * 
+     *
      * @return Best bid price
      */
     double getBestBidPrice() const;
-    
+
     /**
      * Get best ask price
-     * 
+     *
      * @return Best ask price
      */
     double getBestAskPrice() const;
-    
+
     /**
      * Get best bid quantity
-     * 
+     *
      * @return Best bid quantity
      */
     int32_t getBestBidQuantity() const;
-    
+
     /**
      * Get best ask quantity
-     * 
+     *
      * @return Best ask quantity
      */
     int32_t getBestAskQuantity() const;
-    
+
     /**
      * Get best bid/offer
-     * 
+     *
      * @return BBO structure with top of book
      */
     const BBO& getBBO() const;
-    
+
     /**
      * Get order book depth
-     * 
+     *
      * @return Number of price levels on each side
      */
     std::pair<size_t, size_t> getDepth() const;
-    
+
     /**
      * Get all bid price levels
-     * 
-     * @return Const reference to bid price map
+     *
+     * @return Bid levels, best (highest) first
      */
-    const std::map<double, PriceLevel, std::greater<double>>& getBids() const;
-    
+    std::span<const PriceLevel> getBids() const;
+
     /**
      * Get all ask price levels
-     * 
-     * @return Const reference to ask price map
+     *
+     * @return Ask levels, best (lowest) first
      */
-    const std::map<double, PriceLevel, std::less<double>>& getAsks() const;
-    
+    std::span<const PriceLevel> getAsks() const;
+
     /**
      * Check if order book is empty
-     * 
+     *
      * @return true if both sides are empty
      */
     bool isEmpty() const;
-    
+
     /**
      * Get internal ticker ID
-     * 
+     *
      * @return Internal ticker ID
      */
     Common::TickerId getTickerId() const;
-    
+
+    /**
+     * Get the number of FULL ticks dropped as older than the one already applied
+     *
+     * @return Stale ticks dropped since construction
+     */
+    uint64_t getStaleTicks() const;
+
     /**
      * Get timestamp of last update
-     * 
+     *
      * @return Timestamp of last update
      */
     uint64_t getLastUpdateTime() const;
-    
+
+    /**
+     * Set the fixed-point scales used to convert Zerodha prices into internal prices
+     *
+     * @param scale Price decimals, tick size and lot size of this instrument
+     */
+    void setInstrumentScale(const Common::InstrumentScale& scale);
+
+    /**
+     * Get the fixed-point scales of this instrument
+     *
+     * @return Instrument scales, paise by default
+     */
+    const Common::InstrumentScale& getInstrumentScale() const;
+
     /**
      * Generate consistent order ID for price level
-     * 
+     *
      * @param ticker_id Internal ticker ID
-     * @param price Price level
+     * @param price Price level in paise
      * @param side Side (BUY or SELL)
      * @return Generated order ID
      */
     static Common::OrderId generateOrderId(
-        Common::TickerId ticker_id, 
-        double price, 
-        Common::Side side);
+        Common::TickerId ticker_id,
+        int32_t price,
+        Common::Side side) {
+
+        // Combine ticker_id (high bits), price, and side into a unique 64-bit ID
+        return (static_cast<uint64_t>(ticker_id) << 48) |
+               (static_cast<uint64_t>(price) << 1) |
+               (side == Common::Side::BUY ? 0 : 1);
+    }
 
 private:
-    // Order book data
-    std::map<double, PriceLevel, std::greater<double>> bids_;  // Sorted high to low
-    std::map<double, PriceLevel, std::less<double>> asks_;     // Sorted low to high
-    
-    // Previous state for tracking changes
-    std::set<double> prev_bid_prices_;
-    std::set<double> prev_ask_prices_;
-    
+    using Levels = std::array<PriceLevel, MAX_DEPTH_LEVELS>;
+
+    /**
+     * Whether a FULL tick is older than the last one applied, by exchange time, or by day volume within a second
+     */
+    bool isStale(const ZerodhaTick& tick) const {
+        if (tick.exchange_timestamp > 0 && tick.exchange_timestamp != last_exchange_timestamp_) {
+            return tick.exchange_timestamp < last_exchange_timestamp_;
+        }
+        return tick.volume > 0 && tick.volume < last_volume_;
+    }
+
+    /**
+     * Key sorting the levels of a side best first in ascending order, so both sides share one merge
+     */
+    template<Common::Side SIDE>
+    static int64_t sortKey(int32_t price) {
+        return SIDE == Common::Side::BUY ? -static_cast<int64_t>(price) : static_cast<int64_t>(price);
+    }
+
+    /**
+     * Merge the levels of a packet into the previous ones of that side, emitting the differences
+     *
+     * Kite sends the depth best first, empty levels are dropped without branching. Both arrays are walked
+     * together once: a price only in the packet is an ADD, only in the book a CANCEL, in both with another
+     * quantity a MODIFY.
+     */
+    template<Common::Side SIDE, typename Emit>
+    void diffSide(const std::array<ZerodhaTickDepth::Level, MAX_DEPTH_LEVELS>& depth,
+                  const std::array<int16_t, MAX_DEPTH_LEVELS>& orders,
+                  Levels& levels, size_t& num_levels, Emit& emit) {
+        Levels next;
+        size_t num_next = 0;
+        for (size_t k = 0; k < MAX_DEPTH_LEVELS; ++k) {
+            next[num_next] = {depth[k].price, depth[k].quantity, orders[k]};
+            num_next += static_cast<size_t>(depth[k].price > 0 && depth[k].quantity > 0);
+        }
+
+        size_t i = 0, j = 0;
+        while (i < num_levels || j < num_next) {
+            const auto old_key = (i < num_levels ? sortKey<SIDE>(levels[i].price) : std::numeric_limits<int64_t>::max());
+            const auto new_key = (j < num_next ? sortKey<SIDE>(next[j].price) : std::numeric_limits<int64_t>::max());
+            if (old_key == new_key) {
+                if (levels[i].quantity != next[j].quantity) {
+                    emitLevel<SIDE>(ExchangeNS::MarketUpdateType::MODIFY, next[j].price, next[j].quantity, emit);
+                }
+                ++i;
+                ++j;
+            } else if (new_key < old_key) {
+                emitLevel<SIDE>(ExchangeNS::MarketUpdateType::ADD, next[j].price, next[j].quantity, emit);
+                ++j;
+            } else {
+                emitLevel<SIDE>(ExchangeNS::MarketUpdateType::CANCEL, levels[i].price, 0, emit);
+                ++i;
+            }
+        }
+
+        levels = next;
+        num_levels = num_next;
+    }
+
+    template<Common::Side SIDE, typename Emit>
+    void emitLevel(ExchangeNS::MarketUpdateType type, int32_t price, int32_t quantity, Emit& emit) const {
+        ExchangeNS::MEMarketUpdate event;
+        event.type_ = type;
+        event.order_id_ = generateOrderId(ticker_id_, price, SIDE);
+        event.ticker_id_ = ticker_id_;
+        event.side_ = SIDE;
+        event.price_ = paiseToPrice(price);
+        event.qty_ = static_cast<Common::Qty>(quantity);
+        emit(std::as_const(event));
+    }
+
+    /**
+     * Trades since the previous packet come first, as the venue publishes them ahead of the depth they leave
+     * behind. last_quantity repeats on every packet until the next trade, so the traded quantity is the increase
+     * of the day's volume, the first packet only sets the baseline.
+     */
+    template<typename Emit>
+    void emitTrade(const ZerodhaTick& tick, Emit& emit) {
+        if (tick.volume > last_volume_ && last_volume_ > 0 && tick.last_price > 0) {
+            ExchangeNS::MEMarketUpdate event;
+            event.type_ = ExchangeNS::MarketUpdateType::TRADE;
+            event.ticker_id_ = ticker_id_;
+            event.side_ = tradeAggressorSide(tick.last_price);
+            event.price_ = paiseToPrice(tick.last_price);
+            event.qty_ = static_cast<Common::Qty>(tick.volume - last_volume_);
+            emit(std::as_const(event));
+        }
+        last_volume_ = std::max(last_volume_, tick.volume);
+        if (tick.last_price > 0) {
+            last_trade_price_ = tick.last_price;
+        }
+    }
+
+    /**
+     * Side of the aggressor of a trade at the given price, from the book before this packet
+     *
+     * @param price Trade price in paise
+     * @return BUY if it lifted the offer, SELL if it hit the bid, INVALID if it cannot be told
+     */
+    Common::Side tradeAggressorSide(int32_t price) const;
+
+    /**
+     * Internal price of a price in paise, exact in integers unless the scale has fewer than 2 decimals
+     */
+    Common::Price paiseToPrice(int32_t price) const {
+        return paise_multiplier_ ? price * paise_multiplier_ : scale_.toPrice(price / 100.0);
+    }
+
+    /**
+     * Forget every level and the trade baseline
+     */
+    void reset();
+
+    // Order book data, best first
+    Levels bids_{};
+    Levels asks_{};
+    size_t num_bids_ = 0;
+    size_t num_asks_ = 0;
+
     // BBO cache for quick access
     BBO bbo_;
-    
+
+    // Day volume and last trade price in paise of the previous packet, to turn the cumulative volume into trades
+    int32_t last_volume_ = 0;
+    int32_t last_trade_price_ = 0;
+
+    // Exchange time in seconds of the last FULL tick applied, and the FULL ticks dropped as older than it
+    int32_t last_exchange_timestamp_ = 0;
+    uint64_t stale_ticks_ = 0;
+
     // Book metadata
     Common::TickerId ticker_id_;
     uint64_t last_update_time_;
     Common::Logger* logger_;
-    
-    // Memory pool for MEMarketUpdate objects
-    Common::MemPool<ExchangeNS::MEMarketUpdate> update_pool_;
-    
-    // Constants
-    static constexpr size_t MAX_DEPTH_LEVELS = 5;  // Maximum depth from Zerodha
-    static constexpr size_t UPDATE_POOL_SIZE = 1024;  // Size of memory pool
+
+    // Fixed-point scales for the prices in the generated events, and paise to internal price factor, 0 if inexact
+    Common::InstrumentScale scale_;
+    Common::Price paise_multiplier_ = 1;
 };
 
 } // namespace Zerodha
-} // namespace Adapter
\ No newline at end of file
+} // namespace Adapter
@@ -1,4 +1,5 @@
 #include "trading/adapters/zerodha/market_data/zerodha_market_data_adapter.h"
+#include <set>
 #include <nlohmann/json.hpp>
 
 namespace Adapter {
@@ -8,8 +9,7 @@ ZerodhaMarketDataAdapter::ZerodhaMarketDataAdapter(Common::Logger* logger,
                                                ExchangeNS::MEMarketUpdateLFQueue* market_updates,
                                                const std::string& config_file)
     : logger_(logger),
-      market_updates_(market_updates),
-      zerodha_updates_(ZERODHA_QUEUE_SIZE) {
+      market_updates_(market_updates) {
     
     logger_->log("%:% %() % Initializing Zerodha Market Data Adapter with JSON config file: %\n", 
                 __FILE__, __LINE__, __FUNCTION__, 
@@ -96,12 +96,51 @@ auto ZerodhaMarketDataAdapter::start() -> void {
         return;
     }
     
-    websocket_client_ = std::make_unique<ZerodhaWebSocketClient>(
+    // Ticks of several connections are applied by one consumer, their WebSocket threads cannot apply them inline
+    market_data_config_ = config_->getMarketDataConfig();
+    if (market_data_config_.execution == MarketDataExecution::INLINE && market_data_config_.connections > 1) {
+        logger_->log("%:% %() % Inline execution needs a single connection, busy polling % connections instead\n", 
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_),
+                    market_data_config_.connections);
+        market_data_config_.execution = MarketDataExecution::BUSY_POLL;
+    }
+    
+    websocket_pool_ = std::make_unique<ZerodhaWebSocketPool>(
         api_key,
         authenticator_->get_access_token(),
-        zerodha_updates_,
+        static_cast<size_t>(std::max(market_data_config_.connections, 1)),
+        ZERODHA_QUEUE_SIZE,
         logger_
     );
+    websocket_pool_->set_rebalance_interval(std::chrono::seconds(std::max(market_data_config_.rebalance_interval_s, 0)));
+    for (size_t i = 0; i < websocket_pool_->num_connections(); ++i) {
+        websocket_pool_->set_journal(i, journals_[i]);
+    }
+    
+    startMarketData();
+}
+
+auto ZerodhaMarketDataAdapter::startReplay(const MarketDataConfig& market_data_config) -> void {
+    logger_->log("%:% %() % Starting Zerodha Market Data Adapter over replayed frames\n", 
+                __FILE__, __LINE__, __FUNCTION__, 
+                Common::getCurrentTimeStr(&time_str_));
+    
+    market_data_config_ = market_data_config;
+    market_data_config_.connections = 1;
+    if (!websocket_pool_) {
+        websocket_pool_ = std::make_unique<ZerodhaWebSocketPool>("", "", 1, ZERODHA_QUEUE_SIZE, logger_);
+    }
+    
+    replay_ = true;
+    startMarketData();
+}
+
+auto ZerodhaMarketDataAdapter::startMarketData() -> void {
+    // Inline, the WebSocket thread applies the ticks of each frame as soon as it has decoded them
+    if (market_data_config_.execution == MarketDataExecution::INLINE) {
+        websocket_pool_->set_on_ticks([this]() { processMarketUpdates(); });
+    }
     
     // Start market data thread
     run_ = true;
@@ -116,8 +155,8 @@ auto ZerodhaMarketDataAdapter::stop() -> void {
                 Common::getCurrentTimeStr(&time_str_));
                 
     // Disconnect WebSocket
-    if (websocket_client_) {
-        websocket_client_->disconnect();
+    if (websocket_pool_) {
+        websocket_pool_->disconnect();
     }
     
     // Wait for thread to finish
@@ -127,141 +166,330 @@ auto ZerodhaMarketDataAdapter::stop() -> void {
 }
 
 auto ZerodhaMarketDataAdapter::subscribe(const std::string& zerodha_symbol, Common::TickerId internal_ticker_id) -> void {
-    // Format and resolve symbol based on configuration
-    std::string formatted_symbol = zerodha_symbol;
-    if (config_) {
-        formatted_symbol = config_->formatSymbol(zerodha_symbol);
-        formatted_symbol = config_->resolveSymbol(formatted_symbol);
+    subscribe({{zerodha_symbol, internal_ticker_id}});
+}
+
+auto ZerodhaMarketDataAdapter::subscribe(const std::vector<std::pair<std::string, Common::TickerId>>& symbols) -> size_t {
+    // Format and resolve symbols based on configuration
+    std::vector<std::string> formatted_symbols;
+    formatted_symbols.reserve(symbols.size());
+    for (const auto& [zerodha_symbol, ticker_id] : symbols) {
+        formatted_symbols.push_back(formatSymbol(zerodha_symbol));
     }
     
-    logger_->log("%:% %() % Subscribing to Zerodha symbol: % (internal ID: %)\n", 
+    logger_->log("%:% %() % Subscribing to % Zerodha symbols\n", 
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_),
-                formatted_symbol.c_str(), internal_ticker_id);
+                symbols.size());
+    
+    // Get every instrument token in one pass of the token manager
+    std::vector<int32_t> tokens(symbols.size(), 0);
+    if (token_manager_) {
+        token_manager_->getInstrumentTokens(formatted_symbols, tokens);
+    }
     
     // Thread-safe access to maps
     {
         std::lock_guard<std::mutex> lock(mapping_mutex_);
-        symbol_map_[formatted_symbol] = internal_ticker_id;
-        ticker_to_symbol_map_[internal_ticker_id] = formatted_symbol;
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            symbol_map_[formatted_symbols[i]] = symbols[i].second;
+            ticker_to_symbol_map_[symbols[i].second] = formatted_symbols[i];
+        }
     }
     
-    // Get instrument token using the token manager
-    int32_t token = 0;
-    if (token_manager_) {
-        token = token_manager_->getInstrumentToken(formatted_symbol);
+    // Map tokens to ticker IDs and create the order books, then publish the routes once for all of them
+    std::vector<int32_t> subscribed_tokens;
+    subscribed_tokens.reserve(symbols.size());
+    size_t created_books = 0;
+    {
+        std::scoped_lock lock(token_mutex_, order_book_mutex_);
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            if (tokens[i] == 0) {
+                logger_->log("%:% %() % Could not find instrument token for symbol: %\n", 
+                            __FILE__, __LINE__, __FUNCTION__, 
+                            Common::getCurrentTimeStr(&time_str_),
+                            formatted_symbols[i].c_str());
+                continue;
+            }
+            
+            const auto ticker_id = symbols[i].second;
+            token_to_ticker_map_[tokens[i]] = ticker_id;
+            if (order_books_.find(ticker_id) == order_books_.end()) {
+                createOrderBook(ticker_id, tokens[i]);
+                ++created_books;
+            }
+            subscribed_tokens.push_back(tokens[i]);
+        }
+    }
+    if (!subscribed_tokens.empty()) {
+        publishRoutes();
     }
     
-    if (token == 0) {
-        logger_->log("%:% %() % Could not find instrument token for symbol: %\n", 
+    logger_->log("%:% %() % Found % of % tokens, created % order books\n", 
+                __FILE__, __LINE__, __FUNCTION__, 
+                Common::getCurrentTimeStr(&time_str_),
+                subscribed_tokens.size(), symbols.size(), created_books);
+    
+    // Subscribe to the tokens via WebSocket if connected, in as few subscribe and mode frames as they fit in
+    if (websocket_pool_ && websocket_pool_->is_connected()) {
+        if (!subscribed_tokens.empty()) {
+            websocket_pool_->subscribe(subscribed_tokens, StreamingMode::FULL);
+        }
+    } else {
+        logger_->log("%:% %() % WebSocket not connected, queueing subscription for % tokens\n", 
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_),
-                    formatted_symbol.c_str());
-        return;
+                    subscribed_tokens.size());
     }
+    return subscribed_tokens.size();
+}
+
+auto ZerodhaMarketDataAdapter::unsubscribe(const std::string& zerodha_symbol) -> void {
+    unsubscribe(std::vector<std::string>{zerodha_symbol});
+}
+
+auto ZerodhaMarketDataAdapter::unsubscribe(const std::vector<std::string>& zerodha_symbols) -> size_t {
+    // Format and resolve symbols based on configuration
+    std::vector<std::string> formatted_symbols;
+    formatted_symbols.reserve(zerodha_symbols.size());
+    for (const auto& zerodha_symbol : zerodha_symbols) {
+        formatted_symbols.push_back(formatSymbol(zerodha_symbol));
+    }
+    
+    logger_->log("%:% %() % Unsubscribing from % Zerodha symbols\n", 
+                __FILE__, __LINE__, __FUNCTION__, 
+                Common::getCurrentTimeStr(&time_str_),
+                zerodha_symbols.size());
     
-    // Map token to ticker_id
+    // Find and remove the internal ticker IDs
+    std::set<Common::TickerId> ticker_ids;
     {
-        std::lock_guard<std::mutex> lock(token_mutex_);
-        token_to_ticker_map_[token] = internal_ticker_id;
+        std::lock_guard<std::mutex> lock(mapping_mutex_);
+        for (const auto& formatted_symbol : formatted_symbols) {
+            auto symbol_it = symbol_map_.find(formatted_symbol);
+            if (symbol_it != symbol_map_.end()) {
+                ticker_ids.insert(symbol_it->second);
+                ticker_to_symbol_map_.erase(symbol_it->second);
+                symbol_map_.erase(symbol_it);
+            }
+        }
     }
     
-    // Create order book for this ticker
+    // Remove order books and token mappings, the market data thread may still be using the books until it sees the new
+    // routes. The tokens are the ones mapped to the tickers, also when they were mapped without a token manager
+    std::vector<std::unique_ptr<ZerodhaOrderBook>> retired_books;
+    std::vector<int32_t> unsubscribed_tokens;
+    unsubscribed_tokens.reserve(ticker_ids.size());
     {
-        std::lock_guard<std::mutex> lock(order_book_mutex_);
-        if (order_books_.find(internal_ticker_id) == order_books_.end()) {
-            order_books_[internal_ticker_id] = std::make_unique<ZerodhaOrderBook>(internal_ticker_id, logger_);
-            logger_->log("%:% %() % Created order book for symbol: % (ID: %)\n", 
-                        __FILE__, __LINE__, __FUNCTION__, 
-                        Common::getCurrentTimeStr(&time_str_),
-                        formatted_symbol.c_str(), internal_ticker_id);
+        std::scoped_lock lock(token_mutex_, order_book_mutex_);
+        for (const auto ticker_id : ticker_ids) {
+            auto node = order_books_.extract(ticker_id);
+            if (!node.empty()) {
+                retired_books.push_back(std::move(node.mapped()));
+            }
+        }
+        for (auto it = token_to_ticker_map_.begin(); it != token_to_ticker_map_.end();) {
+            if (ticker_ids.count(it->second)) {
+                unsubscribed_tokens.push_back(it->first);
+                it = token_to_ticker_map_.erase(it);
+            } else {
+                ++it;
+            }
         }
     }
+    publishRoutes(std::move(retired_books));
     
-    logger_->log("%:% %() % Found token % for symbol %\n", 
-                __FILE__, __LINE__, __FUNCTION__, 
-                Common::getCurrentTimeStr(&time_str_),
-                token, formatted_symbol.c_str());
+    // Unsubscribe via WebSocket
+    if (!unsubscribed_tokens.empty() && websocket_pool_ && websocket_pool_->is_connected()) {
+        websocket_pool_->unsubscribe(unsubscribed_tokens);
+    }
+    return unsubscribed_tokens.size();
+}
+
+auto ZerodhaMarketDataAdapter::subscribeOptionWindow(const std::string& underlying, double spot, double width,
+                                                     Common::TickerId first_ticker_id, size_t max_contracts) -> size_t {
+    unsubscribeOptionWindow(underlying);
     
-    // Subscribe to the token via WebSocket if connected
-    if (websocket_client_ && websocket_client_->is_connected()) {
-        websocket_client_->subscribe({token}, StreamingMode::FULL);
-    } else {
-        logger_->log("%:% %() % WebSocket not connected, queueing subscription for %\n", 
+    // Ticker IDs past ME_MAX_TICKERS would trip the trade engine or be dropped by the conflator
+    if (first_ticker_id >= Common::ME_MAX_TICKERS || max_contracts > Common::ME_MAX_TICKERS - first_ticker_id) {
+        logger_->log("%:% %() % Option window of % needs ticker IDs % to %, only % tickers exist, not subscribed\n", 
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_),
-                    formatted_symbol.c_str());
+                    underlying.c_str(), first_ticker_id, first_ticker_id + max_contracts - 1, Common::ME_MAX_TICKERS);
+        return 0;
     }
-}
-
-auto ZerodhaMarketDataAdapter::unsubscribe(const std::string& zerodha_symbol) -> void {
-    // Format and resolve symbol based on configuration
-    std::string formatted_symbol = zerodha_symbol;
-    if (config_) {
-        formatted_symbol = config_->formatSymbol(zerodha_symbol);
-        formatted_symbol = config_->resolveSymbol(formatted_symbol);
+    
+    const auto expiry = token_manager_ ? token_manager_->getNearestOptionExpiry(underlying) : std::nullopt;
+    if (!expiry) {
+        logger_->log("%:% %() % No live options of %, no option window subscribed\n", 
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_),
+                    underlying.c_str());
+        return 0;
     }
     
-    logger_->log("%:% %() % Unsubscribing from Zerodha symbol: %\n", 
+    std::lock_guard<std::mutex> lock(option_window_mutex_);
+    
+    // A window's ticker IDs are its own, a book on one of them would be replaced while the routes still point at it
+    if (tickerIdsInUse(first_ticker_id, max_contracts)) {
+        logger_->log("%:% %() % Option window of % needs ticker IDs % to %, some are already in use, not subscribed\n", 
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_),
+                    underlying.c_str(), first_ticker_id, first_ticker_id + max_contracts - 1);
+        return 0;
+    }
+    
+    auto& window = option_windows_[underlying];
+    window = std::make_unique<ZerodhaOptionWindow>(underlying, *expiry, width, first_ticker_id, max_contracts);
+    token_manager_->getOptionWindow(underlying, *expiry, spot, width, window->next(), max_contracts);
+    window->move(spot);
+    applyOptionWindow(*window);
+    
+    logger_->log("%:% %() % Subscribed to % options of % within % of spot %, ticker IDs from %\n", 
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_),
-                formatted_symbol.c_str());
+                window->contracts().size(), underlying.c_str(), width, spot, first_ticker_id);
+    return window->contracts().size();
+}
+
+auto ZerodhaMarketDataAdapter::moveOptionWindow(const std::string& underlying, double spot) -> size_t {
+    std::lock_guard<std::mutex> lock(option_window_mutex_);
+    auto it = option_windows_.find(underlying);
+    if (it == option_windows_.end() || !token_manager_) {
+        return 0;
+    }
     
-    // Get the instrument token
-    int32_t token = 0;
-    if (token_manager_) {
-        token = token_manager_->getInstrumentToken(formatted_symbol);
+    // A range query of the option index, then a merge against the current window
+    auto& window = *it->second;
+    token_manager_->getOptionWindow(underlying, window.expiry(), spot, window.width(), window.next(), window.maxContracts());
+    const auto changed = window.move(spot);
+    if (changed > 0) {
+        applyOptionWindow(window);
+    }
+    return changed;
+}
+
+auto ZerodhaMarketDataAdapter::unsubscribeOptionWindow(const std::string& underlying) -> void {
+    std::lock_guard<std::mutex> lock(option_window_mutex_);
+    auto node = option_windows_.extract(underlying);
+    if (node.empty()) {
+        return;
     }
     
-    // Find internal ticker ID
-    Common::TickerId ticker_id = Common::TickerId_INVALID;
+    // Moving to an empty window makes every contract leave it
+    auto& window = *node.mapped();
+    window.next().clear();
+    window.move(0.0);
+    applyOptionWindow(window);
+}
+
+auto ZerodhaMarketDataAdapter::tickerIdsInUse(Common::TickerId first_ticker_id, size_t count) -> bool {
+    const auto in_range = [&](Common::TickerId ticker_id) {
+        return ticker_id >= first_ticker_id && ticker_id - first_ticker_id < count;
+    };
+    for (const auto& [underlying, window] : option_windows_) {
+        if (first_ticker_id < window->firstTickerId() + window->maxContracts() && window->firstTickerId() < first_ticker_id + count) {
+            return true;
+        }
+    }
     {
         std::lock_guard<std::mutex> lock(mapping_mutex_);
-        auto symbol_it = symbol_map_.find(formatted_symbol);
-        if (symbol_it != symbol_map_.end()) {
-            ticker_id = symbol_it->second;
+        for (const auto& [symbol, ticker_id] : symbol_map_) {
+            if (in_range(ticker_id)) {
+                return true;
+            }
         }
     }
-    
-    // Remove order book
-    if (ticker_id != Common::TickerId_INVALID) {
-        std::lock_guard<std::mutex> lock(order_book_mutex_);
-        order_books_.erase(ticker_id);
+    std::lock_guard<std::mutex> lock(order_book_mutex_);
+    for (const auto& [ticker_id, book] : order_books_) {
+        if (in_range(ticker_id)) {
+            return true;
+        }
     }
+    return false;
+}
+
+auto ZerodhaMarketDataAdapter::applyOptionWindow(const ZerodhaOptionWindow& window) -> void {
+    {
+        std::scoped_lock lock(token_mutex_, order_book_mutex_);
+        
+        // The books of leaving contracts go to the market data thread, which clears their levels downstream before
+        // any tick of a contract entering with the same ticker ID
+        {
+            std::lock_guard<std::mutex> left_lock(left_books_mutex_);
+            for (const auto& change : window.left()) {
+                token_to_ticker_map_.erase(change.contract.instrument_token);
+                auto book = order_books_.extract(change.ticker_id);
+                if (!book.empty()) {
+                    left_books_.emplace_back(change.contract.instrument_token, std::move(book.mapped()));
+                }
+            }
+            if (!left_books_.empty()) {
+                has_left_books_.store(true);
+            }
+        }
+        for (const auto& change : window.entered()) {
+            token_to_ticker_map_[change.contract.instrument_token] = change.ticker_id;
+            createOrderBook(change.ticker_id, change.contract.instrument_token);
+        }
+    }
+    publishRoutes();
     
-    // Remove token mapping
-    if (token != 0) {
-        std::lock_guard<std::mutex> lock(token_mutex_);
-        token_to_ticker_map_.erase(token);
+    if (websocket_pool_ && websocket_pool_->is_connected()) {
+        if (!window.enteredTokens().empty()) {
+            websocket_pool_->subscribe(window.enteredTokens(), StreamingMode::FULL);
+        }
+        if (!window.leftTokens().empty()) {
+            websocket_pool_->unsubscribe(window.leftTokens());
+        }
     }
     
-    // Remove from maps
+    logger_->log("%:% %() % Option window of %: % entered, % left, % contracts\n", 
+                __FILE__, __LINE__, __FUNCTION__, 
+                Common::getCurrentTimeStr(&time_str_),
+                window.underlying().c_str(), window.entered().size(), window.left().size(), window.contracts().size());
+}
+
+auto ZerodhaMarketDataAdapter::appendSymbolTokens(std::vector<int32_t>& tokens) -> void {
+    std::vector<std::string> symbols;
     {
         std::lock_guard<std::mutex> lock(mapping_mutex_);
-        
-        // Find internal ticker ID
-        auto symbol_it = symbol_map_.find(formatted_symbol);
-        if (symbol_it != symbol_map_.end()) {
-            Common::TickerId ticker_id = symbol_it->second;
-            ticker_to_symbol_map_.erase(ticker_id);
+        symbols.reserve(symbol_map_.size());
+        for (const auto& [symbol, ticker_id] : symbol_map_) {
+            symbols.push_back(symbol);
         }
-        
-        symbol_map_.erase(formatted_symbol);
     }
     
-    // Unsubscribe via WebSocket
-    if (token != 0 && websocket_client_ && websocket_client_->is_connected()) {
-        websocket_client_->unsubscribe({token});
+    std::vector<int32_t> symbol_tokens;
+    if (token_manager_ && !symbols.empty()) {
+        token_manager_->getInstrumentTokens(symbols, symbol_tokens);
+    }
+    for (const auto token : symbol_tokens) {
+        if (token != 0) {
+            tokens.push_back(token);
+        }
+    }
+}
+
+auto ZerodhaMarketDataAdapter::appendOptionWindowTokens(std::vector<int32_t>& tokens) -> void {
+    std::lock_guard<std::mutex> lock(option_window_mutex_);
+    for (const auto& [underlying, window] : option_windows_) {
+        for (const auto& contract : window->contracts()) {
+            tokens.push_back(contract.instrument_token);
+        }
     }
 }
 
+auto ZerodhaMarketDataAdapter::formatSymbol(const std::string& zerodha_symbol) const -> std::string {
+    if (!config_) {
+        return zerodha_symbol;
+    }
+    return config_->resolveSymbol(config_->formatSymbol(zerodha_symbol));
+}
+
 auto ZerodhaMarketDataAdapter::mapZerodhaSymbolToInternal(const std::string& zerodha_symbol) -> Common::TickerId {
     // Format and resolve symbol based on configuration
-    std::string formatted_symbol = zerodha_symbol;
-    if (config_) {
-        formatted_symbol = config_->formatSymbol(zerodha_symbol);
-        formatted_symbol = config_->resolveSymbol(formatted_symbol);
-    }
+    const auto formatted_symbol = formatSymbol(zerodha_symbol);
     
     std::lock_guard<std::mutex> lock(mapping_mutex_);
     auto it = symbol_map_.find(formatted_symbol);
@@ -307,8 +535,56 @@ auto ZerodhaMarketDataAdapter::mapZerodhaInstrumentToInternal(int32_t instrument
     return Common::TickerId_INVALID;
 }
 
+auto ZerodhaMarketDataAdapter::replayFrame(const char* data, size_t length, bool is_binary) -> void {
+    // No credentials needed, a single client is only used to decode
+    if (!websocket_pool_) {
+        websocket_pool_ = std::make_unique<ZerodhaWebSocketPool>("", "", 1, ZERODHA_QUEUE_SIZE, logger_);
+    }
+    
+    // Once startReplay() has started the market data thread, the ticks are applied like live ones
+    websocket_pool_->replay_message(data, length, is_binary);
+    if (!market_data_thread_.joinable()) {
+        processMarketUpdates();
+    }
+}
+
+auto ZerodhaMarketDataAdapter::mapInstrumentToken(int32_t instrument_token, Common::TickerId internal_ticker_id) -> void {
+    {
+        std::lock_guard<std::mutex> lock(token_mutex_);
+        token_to_ticker_map_[instrument_token] = internal_ticker_id;
+    }
+    {
+        std::lock_guard<std::mutex> lock(order_book_mutex_);
+        if (order_books_.find(internal_ticker_id) == order_books_.end()) {
+            createOrderBook(internal_ticker_id, instrument_token);
+        }
+    }
+    publishRoutes();
+}
+
+auto ZerodhaMarketDataAdapter::publishRoutes(std::vector<std::unique_ptr<ZerodhaOrderBook>> retired_books) -> void {
+    // Publishers are serialised from the snapshot on, otherwise an older snapshot could be published after a newer
+    // one that retired a book it still routes to, and the book be freed once the newer one's epoch has passed
+    std::lock_guard<std::mutex> publish_lock(publish_mutex_);
+    
+    std::vector<ZerodhaRoute> routes;
+    {
+        std::scoped_lock lock(token_mutex_, order_book_mutex_);
+        routes.reserve(token_to_ticker_map_.size());
+        for (const auto& [token, ticker_id] : token_to_ticker_map_) {
+            auto it = order_books_.find(ticker_id);
+            if (it != order_books_.end()) {
+                routes.push_back({token, ticker_id, it->second.get(), it->second->getInstrumentScale()});
+            }
+        }
+    }
+    
+    // Hashing the tokens happens here, on the subscribing thread
+    router_.publish(std::move(routes), std::move(retired_books));
+}
+
 auto ZerodhaMarketDataAdapter::isConnected() const -> bool {
-    return websocket_client_ && websocket_client_->is_connected();
+    return websocket_pool_ && websocket_pool_->is_connected();
 }
 
 auto ZerodhaMarketDataAdapter::subscribeToTestSymbols() -> void {
@@ -325,11 +601,13 @@ auto ZerodhaMarketDataAdapter::subscribeToTestSymbols() -> void {
                 Common::getCurrentTimeStr(&time_str_),
                 test_symbols.size());
     
+    std::vector<std::pair<std::string, Common::TickerId>> symbols;
+    symbols.reserve(test_symbols.size());
     for (const auto& symbol : test_symbols) {
         // Create a deterministic ticker ID based on symbol hash
-        auto ticker_id = static_cast<Common::TickerId>(std::hash<std::string>{}(symbol) % 10000);
-        subscribe(symbol, ticker_id);
+        symbols.emplace_back(symbol, static_cast<Common::TickerId>(std::hash<std::string>{}(symbol) % 10000));
     }
+    subscribe(symbols);
 }
 
 auto ZerodhaMarketDataAdapter::authenticate() -> bool {
@@ -364,9 +642,9 @@ auto ZerodhaMarketDataAdapter::runMarketData() -> void {
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_));
     
-    // Connect to WebSocket
-    if (websocket_client_) {
-        if (!websocket_client_->connect()) {
+    // Connect to WebSocket, replayed frames need no connection
+    if (websocket_pool_ && !replay_) {
+        if (!websocket_pool_->connect()) {
             logger_->log("%:% %() % Failed to connect to Zerodha WebSocket\n", 
                         __FILE__, __LINE__, __FUNCTION__, 
                         Common::getCurrentTimeStr(&time_str_));
@@ -379,17 +657,8 @@ auto ZerodhaMarketDataAdapter::runMarketData() -> void {
         
         // Re-subscribe to all symbols
         std::vector<int32_t> tokens;
-        {
-            std::lock_guard<std::mutex> lock(mapping_mutex_);
-            for (const auto& [symbol, ticker_id] : symbol_map_) {
-                if (token_manager_) {
-                    int32_t token = token_manager_->getInstrumentToken(symbol);
-                    if (token != 0) {
-                        tokens.push_back(token);
-                    }
-                }
-            }
-        }
+        appendSymbolTokens(tokens);
+        appendOptionWindowTokens(tokens);
         
         // Subscribe to all tokens at once
         if (!tokens.empty()) {
@@ -397,25 +666,40 @@ auto ZerodhaMarketDataAdapter::runMarketData() -> void {
                         __FILE__, __LINE__, __FUNCTION__, 
                         Common::getCurrentTimeStr(&time_str_),
                         tokens.size());
-            websocket_client_->subscribe(tokens, StreamingMode::FULL);
+            websocket_pool_->subscribe(tokens, StreamingMode::FULL);
         }
     }
     
-    // Process market data
-    while (run_) {
-        // Check if token manager needs refresh
-        if (token_manager_ && token_manager_->shouldRefresh()) {
-            logger_->log("%:% %() % Refreshing instrument token data\n", 
+    if (market_data_config_.execution == MarketDataExecution::INLINE) {
+        // The WebSocket thread applies the ticks, this one only keeps house
+        while (run_) {
+            runHousekeeping();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    } else {
+        if (market_data_config_.core_id >= 0 && !Common::setThreadCore(market_data_config_.core_id)) {
+            logger_->log("%:% %() % Failed to pin market data thread to core %\n", 
                         __FILE__, __LINE__, __FUNCTION__, 
-                        Common::getCurrentTimeStr(&time_str_));
-            token_manager_->updateInstrumentData();
+                        Common::getCurrentTimeStr(&time_str_),
+                        market_data_config_.core_id);
         }
         
-        // Process market updates
-        processMarketUpdates();
-        
-        // Small sleep to prevent CPU spinning
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        // Spin on the tick queue, backing off while it is empty and keeping house at most once a second
+        ZerodhaPollBackoff backoff(static_cast<uint32_t>(std::max(market_data_config_.spin_polls, 0)));
+        Common::Nanos next_housekeeping = 0;
+        while (run_) {
+            if (processMarketUpdates()) {
+                backoff.reset();
+                continue;
+            }
+            
+            const auto now = Common::getSystemNanos();
+            if (now >= next_housekeeping) {
+                runHousekeeping();
+                next_housekeeping = now + Common::NANOS_TO_SECS;
+            }
+            backoff.idle();
+        }
     }
     
     logger_->log("%:% %() % Zerodha Market Data thread stopped\n", 
@@ -423,27 +707,94 @@ auto ZerodhaMarketDataAdapter::runMarketData() -> void {
                 Common::getCurrentTimeStr(&time_str_));
 }
 
-auto ZerodhaMarketDataAdapter::processMarketUpdates() -> void {
-    // Process all available updates from the queue
-    for (auto update = zerodha_updates_.getNextToRead(); 
-         zerodha_updates_.size() > 0 && update != nullptr; 
-         update = zerodha_updates_.getNextToRead()) {
-        
-        // Process the update
-        processMarketUpdate(*update);
+auto ZerodhaMarketDataAdapter::runHousekeeping() -> void {
+    // Check if token manager needs refresh
+    if (token_manager_ && token_manager_->shouldRefresh()) {
+        logger_->log("%:% %() % Refreshing instrument token data\n", 
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_));
+        token_manager_->updateInstrumentData();
+    }
+    
+    // Export the tick latencies now and then
+    const auto now = Common::getSystemNanos();
+    if (market_data_config_.latency_log_interval_s > 0 && now >= next_latency_log_) {
+        if (next_latency_log_) {
+            logger_->log("%:% %() % Tick latency %\n", 
+                        __FILE__, __LINE__, __FUNCTION__, 
+                        Common::getCurrentTimeStr(&time_str_),
+                        tick_latency_.snapshot().toString().c_str());
+        }
+        next_latency_log_ = now + market_data_config_.latency_log_interval_s * Common::NANOS_TO_SECS;
+    }
+}
+
+auto ZerodhaMarketDataAdapter::processMarketUpdates() -> size_t {
+    // Routes as of now, the order books they point to stay alive until the next pass
+    const auto& routes = router_.beginPass();
+    clearLeftBooks(routes);
+    
+    // Process all available updates, each connection's queue in turn
+    size_t num_updates = 0;
+    if (!websocket_pool_) {
+        return num_updates;
+    }
+    for (size_t i = 0; i < websocket_pool_->num_connections(); ++i) {
+        auto& queue = websocket_pool_->queue(i);
+        for (auto update = queue.front(); update != nullptr; update = queue.front()) {
+            
+            // Process the update, with its depth if it is a FULL tick
+            processMarketUpdate(routes, *update, update->type == MarketUpdateType::FULL ? queue.frontDepth() : nullptr);
+            
+            // Update the read index
+            queue.pop();
+            ++num_updates;
+        }
+    }
+    return num_updates;
+}
+
+auto ZerodhaMarketDataAdapter::processMarketUpdate(const ZerodhaRoutingTable& routes, const ZerodhaTick& update, const ZerodhaTickDepth* depth) -> void {
+    // One lock free lookup for the instruments subscribed to
+    const auto route = routes.find(update.instrument_token);
+    ZerodhaOrderBook* order_book = LIKELY(route != nullptr) ? route->book : routeUnknownToken(routes, update.instrument_token);
+    if (!order_book) {
+        return;
+    }
+    const auto ticker_id = order_book->getTickerId();
+    
+    // Occasionally log the update (to avoid excessive logging)
+    static int log_counter = 0;
+    if (++log_counter % 100 == 0) {
+        // Convert Zerodha timestamp to std::chrono::time_point
+        auto update_time = std::chrono::system_clock::from_time_t(update.exchange_timestamp);
+        auto current_time = std::chrono::system_clock::now();
+        auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+            current_time - update_time).count();
         
-        // Update the read index
-        zerodha_updates_.updateReadIndex();
+        logger_->log("%:% %() % Received market update for % (ID: %): price=%, latency=%ms\n", 
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_),
+                    mapInternalToZerodhaSymbol(ticker_id).c_str(), ticker_id,
+                    update.last_price / 100.0, latency);
     }
+    
+    // Process update, publishing the generated events as they come
+    order_book->processMarketUpdate(update, depth, [this](const ExchangeNS::MEMarketUpdate& event) {
+        publishMarketUpdate(event);
+    });
+    
+    // From the frame arriving to its market updates being out
+    tick_latency_.record(Common::getCurrentNanos() - update.timestamp);
 }
 
-auto ZerodhaMarketDataAdapter::processMarketUpdate(const MarketUpdate& update) -> void {
+auto ZerodhaMarketDataAdapter::routeUnknownToken(const ZerodhaRoutingTable& routes, int32_t instrument_token) -> ZerodhaOrderBook* {
     // Get ticker ID for this instrument
-    auto ticker_id = mapZerodhaInstrumentToInternal(update.instrument_token);
+    auto ticker_id = mapZerodhaInstrumentToInternal(instrument_token);
     if (ticker_id == Common::TickerId_INVALID) {
         // Try to get instrument info and map from there
         if (token_manager_) {
-            auto instrument_info_opt = token_manager_->getInstrumentInfo(update.instrument_token);
+            auto instrument_info_opt = token_manager_->getInstrumentInfo(instrument_token);
             if (instrument_info_opt.has_value()) {
                 std::string symbol = instrument_info_opt->exchange != Adapter::Zerodha::Exchange::UNKNOWN ?
                     InstrumentTokenManager::exchangeToString(instrument_info_opt->exchange) + ":" + instrument_info_opt->trading_symbol :
@@ -455,7 +806,7 @@ auto ZerodhaMarketDataAdapter::processMarketUpdate(const MarketUpdate& update) -
         
         // Still can't find ticker ID, skip this update
         if (ticker_id == Common::TickerId_INVALID) {
-            return;
+            return nullptr;
         }
     }
     
@@ -466,8 +817,7 @@ auto ZerodhaMarketDataAdapter::processMarketUpdate(const MarketUpdate& update) -
         auto it = order_books_.find(ticker_id);
         if (it == order_books_.end()) {
             // Create new order book
-            order_books_[ticker_id] = std::make_unique<ZerodhaOrderBook>(ticker_id, logger_);
-            order_book = order_books_[ticker_id].get();
+            order_book = createOrderBook(ticker_id, instrument_token);
             
             logger_->log("%:% %() % Created order book for ticker ID: %\n", 
                         __FILE__, __LINE__, __FUNCTION__, 
@@ -478,81 +828,41 @@ auto ZerodhaMarketDataAdapter::processMarketUpdate(const MarketUpdate& update) -
         }
     }
     
-    // Process update through order book
-    if (order_book) {
-        // Convert Zerodha timestamp to std::chrono::time_point
-        auto update_time = std::chrono::system_clock::from_time_t(update.exchange_timestamp);
-        auto current_time = std::chrono::system_clock::now();
-        auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
-            current_time - update_time).count();
-        
-        // Occasionally log the update (to avoid excessive logging)
-        static int log_counter = 0;
-        if (++log_counter % 100 == 0) {
-            logger_->log("%:% %() % Received market update for % (ID: %): price=%, latency=%ms\n", 
-                        __FILE__, __LINE__, __FUNCTION__, 
-                        Common::getCurrentTimeStr(&time_str_),
-                        mapInternalToZerodhaSymbol(ticker_id).c_str(), ticker_id,
-                        update.last_price, latency);
-        }
-        
-        // Process update and get generated events
-        auto events = order_book->processMarketUpdate(update);
-        
-        // Push all generated events to the market updates queue
-        for (auto* event : events) {
-            auto next_write = market_updates_->getNextToWriteTo();
-            *next_write = *event;
-            market_updates_->updateWriteIndex();
-            
-            // Return the event to the memory pool
-            // We don't have direct access to order_book's memory pool,
-            // so we can just let the memory be reclaimed when we get another update
-        }
+    // Route the token directly from the next pass on
+    {
+        std::lock_guard<std::mutex> lock(token_mutex_);
+        token_to_ticker_map_[instrument_token] = ticker_id;
     }
-}
-
-auto ZerodhaMarketDataAdapter::convertToInternalFormat(const MarketUpdate& update) -> std::vector<ExchangeNS::MEMarketUpdate*> {
-    // Get ticker ID for this instrument
-    auto ticker_id = mapZerodhaInstrumentToInternal(update.instrument_token);
+    publishRoutes();
     
-    // If we can't map the token, try to find it through symbol mapping
-    if (ticker_id == Common::TickerId_INVALID && token_manager_) {
-        auto instrument_info_opt = token_manager_->getInstrumentInfo(update.instrument_token);
-        if (instrument_info_opt.has_value()) {
-            std::string symbol = instrument_info_opt->exchange != Adapter::Zerodha::Exchange::UNKNOWN ?
-                InstrumentTokenManager::exchangeToString(instrument_info_opt->exchange) + ":" + instrument_info_opt->trading_symbol :
-                instrument_info_opt->trading_symbol;
-            
-            ticker_id = mapZerodhaSymbolToInternal(symbol);
-        }
+    // The ticker ID may have just been handed over from a contract that left an option window. If that contract's
+    // book is still routed to in this pass its CLEARs cannot go out yet, so neither can this tick
+    if (!clearLeftBooks(routes)) {
+        return nullptr;
     }
     
-    // If still not found, return empty result
-    if (ticker_id == Common::TickerId_INVALID) {
-        return std::vector<ExchangeNS::MEMarketUpdate*>();
+    return order_book;
+}
+
+auto ZerodhaMarketDataAdapter::clearLeftBooks(const ZerodhaRoutingTable& routes) -> bool {
+    if (LIKELY(!has_left_books_.load())) {
+        return true;
     }
     
-    // Get or create order book for this ticker
-    ZerodhaOrderBook* order_book = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(order_book_mutex_);
-        auto it = order_books_.find(ticker_id);
-        if (it == order_books_.end()) {
-            // Create new order book
-            order_books_[ticker_id] = std::make_unique<ZerodhaOrderBook>(ticker_id, logger_);
-            order_book = order_books_[ticker_id].get();
-        } else {
-            order_book = it->second.get();
+    std::lock_guard<std::mutex> lock(left_books_mutex_);
+    std::erase_if(left_books_, [this, &routes](auto& left) {
+        // Still routed to by the table of this pass, its ticks may still be applied until the next one
+        const auto route = routes.find(left.first);
+        if (route && route->book == left.second.get()) {
+            return false;
         }
-    }
-    
-    // Process update through order book
-    if (order_book) {
-        return order_book->processMarketUpdate(update);
-    }
-    
-    return std::vector<ExchangeNS::MEMarketUpdate*>();
+        left.second->clear([this](const ExchangeNS::MEMarketUpdate& event) {
+            publishMarketUpdate(event);
+        });
+        return true;
+    });
+    has_left_books_.store(!left_books_.empty());
+    return left_books_.empty();
 }
 
 auto ZerodhaMarketDataAdapter::convertToInternalFormat(const std::string& zerodha_symbol, 
@@ -563,16 +873,22 @@ auto ZerodhaMarketDataAdapter::convertToInternalFormat(const std::string& zerodh
     ExchangeNS::MEMarketUpdate update;
     
     // Format and resolve symbol based on configuration
-    std::string formatted_symbol = zerodha_symbol;
-    if (config_) {
-        formatted_symbol = config_->formatSymbol(zerodha_symbol);
-        formatted_symbol = config_->resolveSymbol(formatted_symbol);
-    }
+    const auto formatted_symbol = formatSymbol(zerodha_symbol);
     
     // Set basic fields
     update.ticker_id_ = mapZerodhaSymbolToInternal(formatted_symbol);
-    update.price_ = static_cast<Common::Price>(price * 100.0);  // Convert to price ticks (cents)
-    update.qty_ = static_cast<Common::Qty>(qty);
+    
+    // Convert to fixed-point with the instrument's scales, paise if no order book exists yet
+    Common::InstrumentScale scale;
+    {
+        std::lock_guard<std::mutex> lock(order_book_mutex_);
+        auto it = order_books_.find(update.ticker_id_);
+        if (it != order_books_.end()) {
+            scale = it->second->getInstrumentScale();
+        }
+    }
+    update.price_ = scale.toPrice(price);
+    update.qty_ = scale.toQty(qty);
     update.side_ = is_bid ? Common::Side::BUY : Common::Side::SELL;
     
     // Set update type based on whether it's a trade or order book update
@@ -590,7 +906,7 @@ auto ZerodhaMarketDataAdapter::convertToInternalFormat(const std::string& zerodh
     }
     
     update.order_id_ = ZerodhaOrderBook::generateOrderId(
-        update.ticker_id_, price, update.side_);
+        update.ticker_id_, static_cast<int32_t>(std::llround(price * 100.0)), update.side_);
     
     // Set a default priority
     update.priority_ = 1;
@@ -598,6 +914,34 @@ auto ZerodhaMarketDataAdapter::convertToInternalFormat(const std::string& zerodh
     return update;
 }
 
+auto ZerodhaMarketDataAdapter::createOrderBook(Common::TickerId ticker_id, int32_t instrument_token) -> ZerodhaOrderBook* {
+    auto& order_book = order_books_[ticker_id];
+    order_book = std::make_unique<ZerodhaOrderBook>(ticker_id, logger_);
+    
+    // Internal prices are integer multiples of 10^-decimals of the tick size, default to paise if unknown
+    if (token_manager_) {
+        auto instrument_info_opt = token_manager_->getInstrumentInfo(instrument_token);
+        if (instrument_info_opt.has_value()) {
+            order_book->setInstrumentScale(
+                Common::InstrumentScale::fromIncrements(instrument_info_opt->tick_size, 
+                                                        static_cast<double>(instrument_info_opt->lot_size)));
+        }
+    }
+    
+    return order_book.get();
+}
+
+auto ZerodhaMarketDataAdapter::publishMarketUpdate(const ExchangeNS::MEMarketUpdate& update) -> void {
+    if (conflator_) {
+        conflator_->onMarketUpdate(update);
+        return;
+    }
+    
+    auto next_write = market_updates_->getNextToWriteTo();
+    *next_write = update;
+    market_updates_->updateWriteIndex();
+}
+
 auto ZerodhaMarketDataAdapter::onReconnect() -> void {
     logger_->log("%:% %() % WebSocket reconnected. Clearing all order books...\n", 
                 __FILE__, __LINE__, __FUNCTION__, 
@@ -607,40 +951,25 @@ auto ZerodhaMarketDataAdapter::onReconnect() -> void {
     {
         std::lock_guard<std::mutex> lock(order_book_mutex_);
         for (auto& [ticker_id, book] : order_books_) {
-            auto clear_events = book->clear();
-            
             // Push all clear events to the market updates queue
-            for (auto* event : clear_events) {
-                auto next_write = market_updates_->getNextToWriteTo();
-                *next_write = *event;
-                market_updates_->updateWriteIndex();
-                
-                // Memory will be reclaimed on next update
-            }
+            book->clear([this](const ExchangeNS::MEMarketUpdate& event) {
+                publishMarketUpdate(event);
+            });
         }
     }
     
     // Re-subscribe to all instruments
     std::vector<int32_t> tokens;
-    {
-        std::lock_guard<std::mutex> lock(mapping_mutex_);
-        for (const auto& [symbol, ticker_id] : symbol_map_) {
-            if (token_manager_) {
-                int32_t token = token_manager_->getInstrumentToken(symbol);
-                if (token != 0) {
-                    tokens.push_back(token);
-                }
-            }
-        }
-    }
+    appendSymbolTokens(tokens);
+    appendOptionWindowTokens(tokens);
     
     // Re-subscribe in FULL mode
-    if (!tokens.empty() && websocket_client_ && websocket_client_->is_connected()) {
+    if (!tokens.empty() && websocket_pool_ && websocket_pool_->is_connected()) {
         logger_->log("%:% %() % Re-subscribing to % tokens\n", 
                     __FILE__, __LINE__, __FUNCTION__, 
                     Common::getCurrentTimeStr(&time_str_),
                     tokens.size());
-        websocket_client_->subscribe(tokens, StreamingMode::FULL);
+        websocket_pool_->subscribe(tokens, StreamingMode::FULL);
     }
 }
 
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <string>
 #include <functional>
 #include <map>
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 #include "common/thread_utils.h"
 #include "common/lf_queue.h"
@@ -14,14 +18,18 @@
 #include "common/types.h"
 
 #include "exchange/market_data/market_update.h"
+#include "trading/market_data/market_update_conflator.h"
 
 // Alias to avoid namespace confusion
 namespace ExchangeNS = ::Exchange;
 #include "trading/adapters/zerodha/auth/zerodha_authenticator.h"
-#include "trading/adapters/zerodha/market_data/zerodha_websocket_client.h"
+#include "trading/adapters/zerodha/market_data/zerodha_websocket_pool.h"
 #include "trading/adapters/zerodha/market_data/instrument_token_manager.h"
 #include "trading/adapters/zerodha/market_data/environment_config.h"
 #include "trading/adapters/zerodha/market_data/orderbook/zerodha_order_book.h"
+#include "trading/adapters/zerodha/market_data/zerodha_routing_table.h"
+#include "trading/adapters/zerodha/market_data/zerodha_option_window.h"
+#include "trading/adapters/zerodha/market_data/zerodha_tick_latency.h"
 
 namespace Adapter {
 namespace Zerodha {
@@ -37,6 +45,9 @@ namespace Zerodha {
  * - Converts Zerodha market data to internal exchange format
  * - Supports special handling for indices via .env configuration
  * - Maintains full limit order books for all subscribed instruments
+ * 
+ * Ticks are applied to the order books either inline on the WebSocket thread or by a busy polling
+ * consumer thread, see MarketDataConfig.
  */
 class ZerodhaMarketDataAdapter {
 public:
@@ -84,7 +95,64 @@ public:
      * @param zerodha_symbol Symbol to unsubscribe from
      */
     auto unsubscribe(const std::string& zerodha_symbol) -> void;
+    
+    /**
+     * Subscribe to market data for many symbols at once
+     * 
+     * Every token is looked up in a single pass of the token manager, each map is locked once, the routes are
+     * published once and the tokens go out in as few subscribe and mode frames as they fit in.
+     * 
+     * @param symbols Symbols to subscribe to (format: EXCHANGE:SYMBOL) and the internal ticker ID of each
+     * @return Number of symbols whose instrument token was found
+     */
+    auto subscribe(const std::vector<std::pair<std::string, Common::TickerId>>& symbols) -> size_t;
+    
+    /**
+     * Unsubscribe from market data for many symbols at once
+     * 
+     * @param zerodha_symbols Symbols to unsubscribe from
+     * @return Number of instrument tokens that were mapped to the symbols' ticker IDs and are now unsubscribed
+     */
+    auto unsubscribe(const std::vector<std::string>& zerodha_symbols) -> size_t;
 
+    /**
+     * Subscribe to the calls and puts of an underlying's nearest expiry with strikes within a fraction of spot
+     * 
+     * Replaces the underlying's window if it has one. The contracts are looked up with a range query of
+     * the option index and mapped to ticker IDs from first_ticker_id on, see ZerodhaOptionWindow. The
+     * trading engine only knows ME_MAX_TICKERS tickers, a window whose IDs would go past them is refused, as is
+     * one whose IDs are already taken by a subscribed symbol, an order book or another option window.
+     * A contract leaving the window has its levels cleared downstream before its ID is handed to another.
+     * 
+     * @param underlying Underlying name (e.g. "NIFTY")
+     * @param spot Spot price of the underlying
+     * @param width Fraction of spot on either side, e.g. 0.05 for strikes within 5% of spot
+     * @param first_ticker_id First of the max_contracts ticker IDs of the window
+     * @param max_contracts Contracts subscribed at most, those nearest spot
+     * @return Number of contracts subscribed
+     */
+    auto subscribeOptionWindow(const std::string& underlying, double spot, double width,
+                               Common::TickerId first_ticker_id, size_t max_contracts) -> size_t;
+    
+    /**
+     * Move an underlying's option window to a new spot
+     * 
+     * Only the contracts entering the window are subscribed and only those leaving it unsubscribed,
+     * the others keep their ticker ID and order book.
+     * 
+     * @param underlying Underlying name
+     * @param spot Spot price of the underlying
+     * @return Number of contracts subscribed and unsubscribed
+     */
+    auto moveOptionWindow(const std::string& underlying, double spot) -> size_t;
+    
+    /**
+     * Unsubscribe from every contract of an underlying's option window
+     * 
+     * @param underlying Underlying name
+     */
+    auto unsubscribeOptionWindow(const std::string& underlying) -> void;
+    
     /**
      * Map Zerodha symbol to internal ticker ID
      * 
@@ -139,6 +207,64 @@ public:
      */
     auto mapZerodhaInstrumentToInternal(int32_t instrument_token) -> Common::TickerId;
 
+    /**
+     * Publish market updates through a conflation stage instead of the output queue
+     * 
+     * Must be called before start(). Pass nullptr to publish to the output queue again.
+     * 
+     * @param conflator Conflation stage drained by the trade engine
+     */
+    auto setConflator(Trading::MarketUpdateConflator* conflator) -> void { conflator_ = conflator; }
+
+    /**
+     * Journal the raw WebSocket frames of a connection
+     * 
+     * Must be called before start(), once per configured connection to journal them all.
+     * 
+     * @param journal Ring of a JournalRecorder the connection's WebSocket thread copies every frame into
+     * @param connection Connection index, below ZerodhaWebSocketPool::MAX_CONNECTIONS
+     */
+    auto setJournal(Common::JournalByteRing* journal, size_t connection = 0) -> void { journals_.at(connection) = journal; }
+
+    /**
+     * Replay a recorded WebSocket frame through the adapter on the calling thread
+     * 
+     * The frame is decoded by the WebSocket client, applied to the order books and published exactly
+     * like a live one, without authenticating or connecting. Used instead of start(), with the
+     * instruments mapped through subscribe() or mapInstrumentToken().
+     * 
+     * @param data Frame as journaled (ZERODHA_BINARY or ZERODHA_TEXT record payload)
+     * @param length Length of the frame in bytes
+     * @param is_binary true for binary tick frames, false for text frames
+     */
+    auto replayFrame(const char* data, size_t length, bool is_binary) -> void;
+
+    /**
+     * Start the market data thread over frames replayed through replayFrame() instead of a connection
+     * 
+     * The ticks of every replayed frame are then applied with the execution model of the configuration like
+     * live ones: inline on the thread calling replayFrame(), or by the busy polling market data thread. Used
+     * instead of start(), without authenticating or connecting, and stopped by stop().
+     * 
+     * @param market_data_config Execution model, its connections are ignored - replay uses a single one
+     */
+    auto startReplay(const MarketDataConfig& market_data_config) -> void;
+
+    /**
+     * Map an instrument token to an internal ticker ID directly, e.g. to replay without an instrument list
+     * 
+     * @param instrument_token Zerodha instrument token
+     * @param internal_ticker_id Internal ticker ID
+     */
+    auto mapInstrumentToken(int32_t instrument_token, Common::TickerId internal_ticker_id) -> void;
+
+    /**
+     * Latencies from a frame being received to the market updates of its ticks being published
+     * 
+     * @return Snapshot of the latencies since construction, any thread
+     */
+    auto getTickLatencyStats() const -> ZerodhaTickLatencyStats { return tick_latency_.snapshot(); }
+
     // Deleted default, copy & move constructors and assignment-operators
     ZerodhaMarketDataAdapter() = delete;
     ZerodhaMarketDataAdapter(const ZerodhaMarketDataAdapter&) = delete;
@@ -150,26 +276,64 @@ private:
     // Common initialization logic
     auto initialize() -> void;
     
-    // The main processing thread
+    // Hand the ticks to the WebSocket thread if they are applied inline and start the market data thread
+    auto startMarketData() -> void;
+    
+    // The main processing thread, the tick consumer unless ticks are applied inline
     auto runMarketData() -> void;
     
-    // Process market data updates from Zerodha
-    auto processMarketUpdates() -> void;
+    // Instrument refresh and latency logging, off the per tick path
+    auto runHousekeeping() -> void;
+    
+    // Process market data updates from every connection's queue, returns the number of ticks processed
+    auto processMarketUpdates() -> size_t;
+    
+    // Process a single tick, depth is only set for FULL ticks
+    auto processMarketUpdate(const ZerodhaRoutingTable& routes, const ZerodhaTick& update, const ZerodhaTickDepth* depth) -> void;
     
-    // Process a single market update
-    auto processMarketUpdate(const MarketUpdate& update) -> void;
+    // Order book of a token missing from the routing table, looked up through the instrument list, nullptr if none
+    auto routeUnknownToken(const ZerodhaRoutingTable& routes, int32_t instrument_token) -> ZerodhaOrderBook*;
+    
+    // Publish the CLEARs of the order books of contracts that left an option window and free them, once the routes
+    // no longer point to them. Called by the market data thread before it routes ticks with a newer table, false
+    // while some are still routed to
+    auto clearLeftBooks(const ZerodhaRoutingTable& routes) -> bool;
+    
+    // Rebuild the routing table from the token map and the order books and publish it to the market data thread
+    auto publishRoutes(std::vector<std::unique_ptr<ZerodhaOrderBook>> retired_books = {}) -> void;
     
     // Authenticate with Zerodha API
     auto authenticate() -> bool;
     
     // Convert Zerodha market data to internal format
-    auto convertToInternalFormat(const MarketUpdate& update) -> std::vector<ExchangeNS::MEMarketUpdate*>;
     auto convertToInternalFormat(const std::string& zerodha_symbol, 
                                 double price, 
                                 double qty, 
                                 bool is_bid,
                                 bool is_trade) -> ExchangeNS::MEMarketUpdate;
 
+    // Remap the ticker IDs of the contracts an option window's last move changed and resubscribe them, option_window_mutex_ must be held
+    auto applyOptionWindow(const ZerodhaOptionWindow& window) -> void;
+    
+    // Whether any of count ticker IDs from first_ticker_id has a book, a subscribed symbol or belongs to an option window,
+    // option_window_mutex_ must be held
+    auto tickerIdsInUse(Common::TickerId first_ticker_id, size_t count) -> bool;
+    
+    // Format and resolve a symbol based on configuration
+    auto formatSymbol(const std::string& zerodha_symbol) const -> std::string;
+    
+    // Append the tokens of every subscribed symbol, to subscribe to them again on (re)connecting
+    auto appendSymbolTokens(std::vector<int32_t>& tokens) -> void;
+    
+    // Append the tokens of every option window, to subscribe to them again on (re)connecting
+    auto appendOptionWindowTokens(std::vector<int32_t>& tokens) -> void;
+    
+    // Create the order book for a ticker with the fixed-point scales of its instrument, order_book_mutex_ must be held
+    auto createOrderBook(Common::TickerId ticker_id, int32_t instrument_token) -> ZerodhaOrderBook*;
+
+    // Publish a market update to the conflator if one is set, otherwise to the output queue
+    auto publishMarketUpdate(const ExchangeNS::MEMarketUpdate& update) -> void;
+
     // Handle WebSocket reconnection
     auto onReconnect() -> void;
 
@@ -181,8 +345,11 @@ private:
     // Queue for processed market data updates
     ExchangeNS::MEMarketUpdateLFQueue* market_updates_ = nullptr;
     
-    // LF Queue for Zerodha market updates from WebSocket
-    Common::LFQueue<MarketUpdate> zerodha_updates_;
+    // Optional conflation stage used instead of market_updates_
+    Trading::MarketUpdateConflator* conflator_ = nullptr;
+    
+    // Optional journal recorder rings for the raw WebSocket frames, one per connection
+    std::array<Common::JournalByteRing*, ZerodhaWebSocketPool::MAX_CONNECTIONS> journals_{};
     
     // Map of Zerodha symbols to internal ticker IDs
     std::map<std::string, Common::TickerId> symbol_map_;
@@ -193,6 +360,22 @@ private:
     std::map<int32_t, Common::TickerId> token_to_ticker_map_;
     std::mutex token_mutex_;
     
+    // Token -> ticker, order book and scale table the market data thread routes ticks with, no lock per tick
+    ZerodhaRouter router_;
+    
+    // Held by publishRoutes() from reading the maps to publishing, taken before token_mutex_ and order_book_mutex_
+    std::mutex publish_mutex_;
+    
+    // Option windows by underlying
+    std::map<std::string, std::unique_ptr<ZerodhaOptionWindow>> option_windows_;
+    std::mutex option_window_mutex_;
+    
+    // Order books of contracts that left an option window by instrument token, waiting for clearLeftBooks(). Added
+    // under token_mutex_ and order_book_mutex_, so a table routing the ticker ID to another contract comes after them
+    std::vector<std::pair<int32_t, std::unique_ptr<ZerodhaOrderBook>>> left_books_;
+    std::mutex left_books_mutex_;
+    std::atomic<bool> has_left_books_{false};
+    
     // Order books for each subscribed instrument
     std::map<Common::TickerId, std::unique_ptr<ZerodhaOrderBook>> order_books_;
     mutable std::mutex order_book_mutex_;
@@ -201,15 +384,27 @@ private:
     std::unique_ptr<EnvironmentConfig> config_;
     std::unique_ptr<ZerodhaAuthenticator> authenticator_;
     std::unique_ptr<InstrumentTokenManager> token_manager_;
-    std::unique_ptr<ZerodhaWebSocketClient> websocket_client_;
+    
+    // WebSocket connections, each publishing its ticks to a queue of its own
+    std::unique_ptr<ZerodhaWebSocketPool> websocket_pool_;
     
     // Thread for processing market data
     std::thread market_data_thread_;
     
+    // Execution model of market_data_thread_, read at start()
+    MarketDataConfig market_data_config_;
+    
+    // Frames come from replayFrame() rather than a connection, set by startReplay()
+    bool replay_ = false;
+    
+    // Tick latencies, recorded by whichever thread applies the ticks
+    ZerodhaTickLatency tick_latency_;
+    Common::Nanos next_latency_log_ = 0;
+    
     // Run flag for the thread
     volatile bool run_ = false;
     
-    // Queue size constants
+    // Queue size constants, per connection
     static constexpr size_t ZERODHA_QUEUE_SIZE = 10 * 1024;
 };
 
@@ -0,0 +1,88 @@
+#include "zerodha_option_window.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace Adapter {
+namespace Zerodha {
+
+namespace {
+    // Order of the window, calls before puts, then strike, the token tells apart a contract relisted under another
+    auto key(const OptionContract& contract) {
+        return std::tie(contract.type, contract.strike, contract.instrument_token);
+    }
+}
+
+ZerodhaOptionWindow::ZerodhaOptionWindow(std::string underlying, std::chrono::system_clock::time_point expiry, double width,
+                                         Common::TickerId first_ticker_id, size_t max_contracts)
+    : underlying_(std::move(underlying)),
+      expiry_(expiry),
+      width_(width),
+      first_ticker_id_(first_ticker_id),
+      max_contracts_(max_contracts) {
+    contracts_.reserve(max_contracts_);
+    ticker_ids_.reserve(max_contracts_);
+    next_.reserve(max_contracts_);
+    next_ticker_ids_.reserve(max_contracts_);
+    entered_.reserve(max_contracts_);
+    left_.reserve(max_contracts_);
+    entered_tokens_.reserve(max_contracts_);
+    left_tokens_.reserve(max_contracts_);
+
+    // Lowest IDs are handed out first
+    free_ticker_ids_.reserve(max_contracts_);
+    for (size_t i = max_contracts_; i > 0; --i) {
+        free_ticker_ids_.push_back(first_ticker_id + static_cast<Common::TickerId>(i - 1));
+    }
+}
+
+auto ZerodhaOptionWindow::move(double spot) -> size_t {
+    // Beyond max_contracts, keep the strikes nearest spot
+    if (next_.size() > max_contracts_) {
+        std::nth_element(next_.begin(), next_.begin() + static_cast<std::ptrdiff_t>(max_contracts_), next_.end(),
+                         [spot](const OptionContract& a, const OptionContract& b) {
+                             return std::make_tuple(std::abs(a.strike - spot), a.type, a.strike) < std::make_tuple(std::abs(b.strike - spot), b.type, b.strike);
+                         });
+        next_.resize(max_contracts_);
+    }
+    std::sort(next_.begin(), next_.end(), [](const OptionContract& a, const OptionContract& b) { return key(a) < key(b); });
+
+    entered_.clear();
+    left_.clear();
+    entered_tokens_.clear();
+    left_tokens_.clear();
+    next_ticker_ids_.assign(next_.size(), Common::TickerId_INVALID);
+
+    // Both windows are sorted, a contract in the old one only has left, one in the new one only has entered
+    size_t i = 0, j = 0;
+    while (i < contracts_.size() || j < next_.size()) {
+        if (i < contracts_.size() && j < next_.size() && key(contracts_[i]) == key(next_[j])) {
+            next_ticker_ids_[j++] = ticker_ids_[i++];
+        } else if (j == next_.size() || (i < contracts_.size() && key(contracts_[i]) < key(next_[j]))) {
+            left_.push_back({contracts_[i], ticker_ids_[i]});
+            left_tokens_.push_back(contracts_[i].instrument_token);
+            free_ticker_ids_.push_back(ticker_ids_[i++]);
+        } else {
+            ++j;
+        }
+    }
+
+    // Entering contracts take the IDs freed, which are always enough as the window holds max_contracts at most
+    for (j = 0; j < next_.size(); ++j) {
+        if (next_ticker_ids_[j] == Common::TickerId_INVALID) {
+            next_ticker_ids_[j] = free_ticker_ids_.back();
+            free_ticker_ids_.pop_back();
+            entered_.push_back({next_[j], next_ticker_ids_[j]});
+            entered_tokens_.push_back(next_[j].instrument_token);
+        }
+    }
+
+    std::swap(contracts_, next_);
+    std::swap(ticker_ids_, next_ticker_ids_);
+    next_.clear();
+    return entered_.size() + left_.size();
+}
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/types.h"
+
+#include "trading/adapters/zerodha/market_data/instrument_token_manager.h"
+
+namespace Adapter {
+namespace Zerodha {
+
+/**
+ * ZerodhaOptionWindow - The calls and puts of one expiry of an underlying with strikes around spot, a ticker ID each
+ *
+ * The window at a new spot is filled into next() from InstrumentTokenManager::getOptionWindow(), calls then puts and
+ * each by strike, and move() finds the contracts that entered and left with a single merge of the two sorted lists.
+ * Contracts staying in the window keep their ticker ID and order book, entering ones take the IDs leaving ones freed.
+ * Every list is reserved for max_contracts up front, so following spot does not allocate.
+ */
+class ZerodhaOptionWindow final {
+public:
+    // A contract entering or leaving the window
+    struct Change {
+        OptionContract contract;
+        Common::TickerId ticker_id = Common::TickerId_INVALID;
+    };
+
+    /**
+     * @param underlying Underlying name (e.g. "NIFTY")
+     * @param expiry Expiry of the options
+     * @param width Fraction of spot on either side of it
+     * @param first_ticker_id The contracts get ticker IDs first_ticker_id to first_ticker_id + max_contracts - 1
+     * @param max_contracts Contracts in the window at most, those nearest spot are kept
+     */
+    ZerodhaOptionWindow(std::string underlying, std::chrono::system_clock::time_point expiry, double width,
+                        Common::TickerId first_ticker_id, size_t max_contracts);
+
+    /**
+     * Window to move to, to be filled by the caller before move()
+     */
+    auto next() -> std::vector<OptionContract>& { return next_; }
+
+    /**
+     * Move to the contracts in next(), which is emptied
+     *
+     * @param spot Spot the window was taken around, the contracts nearest it are kept beyond max_contracts
+     * @return Number of contracts that entered or left
+     */
+    auto move(double spot) -> size_t;
+
+    auto underlying() const -> const std::string& { return underlying_; }
+    auto expiry() const -> std::chrono::system_clock::time_point { return expiry_; }
+    auto width() const -> double { return width_; }
+
+    // Ticker IDs the window hands out, first_ticker_id to first_ticker_id + max_contracts - 1
+    auto firstTickerId() const -> Common::TickerId { return first_ticker_id_; }
+    auto maxContracts() const -> size_t { return max_contracts_; }
+
+    // Contracts in the window, calls then puts by strike, and their ticker IDs
+    auto contracts() const -> const std::vector<OptionContract>& { return contracts_; }
+    auto tickerIds() const -> const std::vector<Common::TickerId>& { return ticker_ids_; }
+
+    // Changes of the last move, with the instrument tokens to subscribe to and to unsubscribe from
+    auto entered() const -> const std::vector<Change>& { return entered_; }
+    auto left() const -> const std::vector<Change>& { return left_; }
+    auto enteredTokens() const -> const std::vector<int32_t>& { return entered_tokens_; }
+    auto leftTokens() const -> const std::vector<int32_t>& { return left_tokens_; }
+
+    // Deleted default, copy & move constructors and assignment-operators
+    ZerodhaOptionWindow() = delete;
+    ZerodhaOptionWindow(const ZerodhaOptionWindow&) = delete;
+    ZerodhaOptionWindow(const ZerodhaOptionWindow&&) = delete;
+    ZerodhaOptionWindow& operator=(const ZerodhaOptionWindow&) = delete;
+    ZerodhaOptionWindow& operator=(const ZerodhaOptionWindow&&) = delete;
+
+private:
+    const std::string underlying_;
+    const std::chrono::system_clock::time_point expiry_;
+    const double width_;
+    const Common::TickerId first_ticker_id_;
+    const size_t max_contracts_;
+
+    std::vector<OptionContract> contracts_;
+    std::vector<Common::TickerId> ticker_ids_;
+    std::vector<OptionContract> next_;
+    std::vector<Common::TickerId> next_ticker_ids_;
+    std::vector<Common::TickerId> free_ticker_ids_;
+
+    std::vector<Change> entered_;
+    std::vector<Change> left_;
+    std::vector<int32_t> entered_tokens_;
+    std::vector<int32_t> left_tokens_;
+};
+
+} // namespace Zerodha
+} // namespace Adapter
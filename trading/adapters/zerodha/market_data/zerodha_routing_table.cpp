@@ -0,0 +1,113 @@
+#include "zerodha_routing_table.h"
+
+#include <algorithm>
+#include <bit>
+#include <unordered_set>
+
+namespace Adapter {
+namespace Zerodha {
+
+namespace {
+    // Displacements tried per bucket before the table is grown, a bucket of a handful of tokens needs a few at most
+    constexpr uint32_t MAX_DISPLACEMENT = 1 << 16;
+}
+
+ZerodhaRoutingTable::ZerodhaRoutingTable(std::vector<ZerodhaRoute> routes) {
+    std::unordered_set<int32_t> tokens;
+    std::erase_if(routes, [&tokens](const ZerodhaRoute& route) { return !tokens.insert(route.instrument_token).second; });
+    num_routes_ = routes.size();
+
+    // A load factor of at most a half keeps the search short, doubling whenever a bucket cannot be placed
+    auto num_slots = std::bit_ceil(std::max<size_t>(2 * routes.size(), 1));
+    while (!tryBuild(routes, num_slots)) {
+        num_slots *= 2;
+    }
+}
+
+auto ZerodhaRoutingTable::tryBuild(const std::vector<ZerodhaRoute>& routes, size_t num_slots) -> bool {
+    // About 2 tokens per bucket
+    const auto num_buckets = std::bit_ceil(std::max<size_t>(routes.size() / 2, 1));
+    bucket_mask_ = static_cast<uint32_t>(num_buckets - 1);
+    slot_mask_ = static_cast<uint32_t>(num_slots - 1);
+    displacements_.assign(num_buckets, 0);
+    slots_.assign(num_slots, ZerodhaRoute{});
+
+    std::vector<std::vector<uint32_t>> buckets(num_buckets);
+    for (const auto& route : routes) {
+        const auto key = static_cast<uint32_t>(route.instrument_token);
+        buckets[mix(key) & bucket_mask_].push_back(key);
+    }
+    std::vector<size_t> order(num_buckets);
+    for (size_t i = 0; i < num_buckets; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<bool> taken(num_slots, false);
+    std::vector<size_t> placed;
+    for (const auto bucket : order) {
+        const auto& keys = buckets[bucket];
+        if (keys.empty()) {
+            break;
+        }
+
+        bool found = false;
+        for (uint32_t displacement = 0; !found && displacement < MAX_DISPLACEMENT; ++displacement) {
+            placed.clear();
+            found = true;
+            for (const auto key : keys) {
+                const auto slot = slotOf(key, displacement);
+                if (taken[slot] || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+                    found = false;
+                    break;
+                }
+                placed.push_back(slot);
+            }
+            if (found) {
+                displacements_[bucket] = displacement;
+                for (const auto slot : placed) {
+                    taken[slot] = true;
+                }
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+
+    for (const auto& route : routes) {
+        const auto key = static_cast<uint32_t>(route.instrument_token);
+        slots_[slotOf(key, displacements_[mix(key) & bucket_mask_])] = route;
+    }
+    return true;
+}
+
+ZerodhaRouter::ZerodhaRouter() : current_(std::make_unique<const ZerodhaRoutingTable>(std::vector<ZerodhaRoute>{})) {
+    table_ = current_.get();
+}
+
+ZerodhaRouter::~ZerodhaRouter() = default;
+
+auto ZerodhaRouter::publish(std::vector<ZerodhaRoute> routes, std::vector<std::unique_ptr<ZerodhaOrderBook>> retired_books) -> void {
+    auto table = std::make_unique<const ZerodhaRoutingTable>(std::move(routes));
+
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+
+    // Once the reader has begun a pass after the one it may have loaded the old table in, it has let go of it
+    table_ = table.get();
+    const auto epoch = reader_epoch_.load();
+    retired_.push_back({epoch, std::move(current_), std::move(retired_books)});
+    current_ = std::move(table);
+
+    std::erase_if(retired_, [now = epoch](const Retired& retired) { return now > retired.epoch; });
+}
+
+auto ZerodhaRouter::numRetired() -> size_t {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    const auto epoch = reader_epoch_.load();
+    std::erase_if(retired_, [epoch](const Retired& retired) { return epoch > retired.epoch; });
+    return retired_.size();
+}
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/fixed_point.h"
+#include "common/macros.h"
+#include "common/types.h"
+
+#include "trading/adapters/zerodha/market_data/orderbook/zerodha_order_book.h"
+
+namespace Adapter {
+namespace Zerodha {
+
+/**
+ * Where the ticks of one instrument go
+ */
+struct ZerodhaRoute {
+    int32_t instrument_token = 0;
+    Common::TickerId ticker_id = Common::TickerId_INVALID;
+    ZerodhaOrderBook* book = nullptr;
+    Common::InstrumentScale scale;  // Tick and lot size of the instrument
+};
+
+/**
+ * ZerodhaRoutingTable - Immutable instrument token -> route table with a perfect hash over the tokens
+ *
+ * Hash and displace: a token first hashes to a bucket, the displacement stored for that bucket then picks its slot.
+ * Displacements are searched at build time, biggest buckets first, until every token has a slot of its own. A lookup
+ * is two hashes, two loads and a compare, whatever the number of instruments and without any lock.
+ */
+class ZerodhaRoutingTable {
+public:
+    /**
+     * Build the table
+     *
+     * @param routes Routes, only the first of several with the same token is kept
+     */
+    explicit ZerodhaRoutingTable(std::vector<ZerodhaRoute> routes);
+
+    /**
+     * Route of an instrument token
+     *
+     * @param instrument_token Zerodha instrument token
+     * @return Route, nullptr if the token is not routed
+     */
+    auto find(int32_t instrument_token) const noexcept -> const ZerodhaRoute* {
+        const auto key = static_cast<uint32_t>(instrument_token);
+        const auto& route = slots_[slotOf(key, displacements_[mix(key) & bucket_mask_])];
+        return (route.book && route.instrument_token == instrument_token) ? &route : nullptr;
+    }
+
+    auto size() const noexcept { return num_routes_; }
+
+    auto numSlots() const noexcept { return slots_.size(); }
+
+private:
+    // 32-bit integer finaliser, every input bit affects every output bit
+    static auto mix(uint32_t x) noexcept -> uint32_t {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+    }
+
+    auto slotOf(uint32_t key, uint32_t displacement) const noexcept -> size_t {
+        return mix(key ^ (0x9e3779b9U * (displacement + 1))) & slot_mask_;
+    }
+
+    // Search the displacements for this many slots, false if some bucket could not be placed
+    auto tryBuild(const std::vector<ZerodhaRoute>& routes, size_t num_slots) -> bool;
+
+    std::vector<uint32_t> displacements_;
+    std::vector<ZerodhaRoute> slots_;
+    uint32_t bucket_mask_ = 0;
+    uint32_t slot_mask_ = 0;
+    size_t num_routes_ = 0;
+};
+
+/**
+ * ZerodhaRouter - Publishes routing tables to the market data thread read-copy-update style
+ *
+ * Writers build a new table off the market data thread and swap it in. The thread reading the ticks (one at a time)
+ * calls beginPass() before each batch of ticks, which marks that it holds nothing from an earlier pass. A replaced
+ * table, and the order books it was the last to route to, are only freed once the reader has begun a pass after the
+ * swap, so a lookup never takes a lock or touches a reference count.
+ */
+class ZerodhaRouter {
+public:
+    ZerodhaRouter();
+
+    ~ZerodhaRouter();
+
+    /**
+     * Start a pass over the ticks - called by the reading thread only
+     *
+     * @return Current table, valid until the next call
+     */
+    auto beginPass() noexcept -> const ZerodhaRoutingTable& {
+        // Sequentially consistent with the writer's swap and its read of the epoch, see publish()
+        reader_epoch_.fetch_add(1);
+        return *table_.load();
+    }
+
+    /**
+     * Replace the routing table - any thread
+     *
+     * @param routes All routes of the new table
+     * @param retired_books Order books no longer routed to, freed once the reader cannot be using them anymore
+     */
+    auto publish(std::vector<ZerodhaRoute> routes, std::vector<std::unique_ptr<ZerodhaOrderBook>> retired_books = {}) -> void;
+
+    /**
+     * Number of replaced tables waiting for the reader to move on
+     */
+    auto numRetired() -> size_t;
+
+    // Deleted copy & move constructors and assignment-operators
+    ZerodhaRouter(const ZerodhaRouter&) = delete;
+    ZerodhaRouter(const ZerodhaRouter&&) = delete;
+    ZerodhaRouter& operator=(const ZerodhaRouter&) = delete;
+    ZerodhaRouter& operator=(const ZerodhaRouter&&) = delete;
+
+private:
+    struct Retired {
+        uint64_t epoch;   // Reader epoch seen right after the swap
+        std::unique_ptr<const ZerodhaRoutingTable> table;
+        std::vector<std::unique_ptr<ZerodhaOrderBook>> books;
+    };
+
+    // Table the reader loads, owned by current_
+    std::atomic<const ZerodhaRoutingTable*> table_{nullptr};
+    std::atomic<uint64_t> reader_epoch_{0};
+
+    // Writer side
+    std::mutex writer_mutex_;
+    std::unique_ptr<const ZerodhaRoutingTable> current_;
+    std::vector<Retired> retired_;
+};
+
+} // namespace Zerodha
+} // namespace Adapter
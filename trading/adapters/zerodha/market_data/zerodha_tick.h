@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <thread>
+
+#include "common/lf_queue.h"
+#include "common/time_utils.h"
+
+#include "kite_tick_decoder.h"
+
+namespace Adapter {
+namespace Zerodha {
+
+/**
+ * ZerodhaTick - A tick as the market data adapter consumes it, one cache line
+ *
+ * Integers exactly as Kite sent them: prices in paise, quantities in units, times in epoch seconds. LTP ticks only
+ * set instrument_token, last_price and timestamp, index ticks leave the quantities alone. The rest of a FULL tick is
+ * in a ZerodhaTickDepth.
+ */
+struct alignas(64) ZerodhaTick {
+    int32_t instrument_token;
+    MarketUpdateType type;
+    Common::Nanos timestamp;        // Time the frame was received
+    int32_t exchange_timestamp;     // FULL and index FULL ticks only
+
+    int32_t last_price;
+    int32_t last_quantity;
+    int32_t average_price;
+    int32_t volume;
+    int32_t buy_quantity;
+    int32_t sell_quantity;
+    int32_t open_price;
+    int32_t high_price;
+    int32_t low_price;
+    int32_t close_price;
+};
+
+/**
+ * ZerodhaTickDepth - The part of a FULL tick beyond the quote, two cache lines
+ */
+struct alignas(64) ZerodhaTickDepth {
+    struct Level {
+        int32_t price;      // Price in paise
+        int32_t quantity;   // Quantity at this price
+    };
+
+    int32_t last_trade_time;
+    int32_t open_interest;
+    int32_t open_interest_day_high;
+    int32_t open_interest_day_low;
+
+    // Best first, empty levels have a zero price and quantity
+    std::array<Level, 5> bids;
+    std::array<Level, 5> asks;
+    std::array<int16_t, 5> bid_orders;
+    std::array<int16_t, 5> ask_orders;
+};
+
+static_assert(sizeof(ZerodhaTick) == 64 && sizeof(ZerodhaTickDepth) == 128,
+              "LTP and QUOTE ticks must fit a cache line, the depth of FULL ticks two.");
+
+/**
+ * ZerodhaTickQueue - Lock free queue of ticks from the WebSocket client to the market data adapter
+ *
+ * The quote of every tick goes through one queue, the depth of FULL ticks through a second one. LTP and QUOTE ticks
+ * move one cache line instead of a slot sized for the depth, FULL ticks three. One producer and one consumer.
+ */
+class ZerodhaTickQueue final {
+public:
+    explicit ZerodhaTickQueue(size_t num_elements) : ticks_(num_elements), depths_(num_elements) {
+    }
+
+    /**
+     * Publish a decoded tick, the depth of a FULL tick ahead of its quote so the consumer always finds it
+     *
+     * @param tick Tick as decoded
+     * @param timestamp Time the frame was received
+     */
+    auto push(const KiteTick& tick, Common::Nanos timestamp) noexcept -> void {
+        if (tick.type == MarketUpdateType::FULL) {
+            auto depth = depths_.getNextToWriteTo();
+            depth->last_trade_time = tick.last_trade_time;
+            depth->open_interest = tick.open_interest;
+            depth->open_interest_day_high = tick.open_interest_day_high;
+            depth->open_interest_day_low = tick.open_interest_day_low;
+            for (size_t i = 0; i < 5; ++i) {
+                depth->bids[i] = {tick.bids[i].price, tick.bids[i].quantity};
+                depth->asks[i] = {tick.asks[i].price, tick.asks[i].quantity};
+                depth->bid_orders[i] = tick.bids[i].orders;
+                depth->ask_orders[i] = tick.asks[i].orders;
+            }
+            depths_.updateWriteIndex();
+        }
+
+        // KiteTick leaves the fields the packet did not carry as they were, copy them all the same
+        auto next = ticks_.getNextToWriteTo();
+        next->instrument_token = tick.instrument_token;
+        next->type = tick.type;
+        next->timestamp = timestamp;
+        next->exchange_timestamp = tick.exchange_timestamp;
+        next->last_price = tick.last_price;
+        next->last_quantity = tick.last_quantity;
+        next->average_price = tick.average_price;
+        next->volume = tick.volume;
+        next->buy_quantity = tick.buy_quantity;
+        next->sell_quantity = tick.sell_quantity;
+        next->open_price = tick.open_price;
+        next->high_price = tick.high_price;
+        next->low_price = tick.low_price;
+        next->close_price = tick.close_price;
+        ticks_.updateWriteIndex();
+    }
+
+    /// Oldest tick, nullptr if there is none
+    auto front() const noexcept -> const ZerodhaTick* {
+        return ticks_.getNextToRead();
+    }
+
+    /// Depth of the oldest tick, only valid if it is a FULL tick
+    auto frontDepth() const noexcept -> const ZerodhaTickDepth* {
+        return depths_.getNextToRead();
+    }
+
+    /// Consume the oldest tick and its depth
+    auto pop() noexcept -> void {
+        if (ticks_.getNextToRead()->type == MarketUpdateType::FULL) {
+            depths_.updateReadIndex();
+        }
+        ticks_.updateReadIndex();
+    }
+
+    auto size() const noexcept {
+        return ticks_.size();
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators
+    ZerodhaTickQueue() = delete;
+    ZerodhaTickQueue(const ZerodhaTickQueue&) = delete;
+    ZerodhaTickQueue(const ZerodhaTickQueue&&) = delete;
+    ZerodhaTickQueue& operator=(const ZerodhaTickQueue&) = delete;
+    ZerodhaTickQueue& operator=(const ZerodhaTickQueue&&) = delete;
+
+private:
+    Common::LFQueue<ZerodhaTick> ticks_;
+    Common::LFQueue<ZerodhaTickDepth> depths_;
+};
+
+/**
+ * ZerodhaPollBackoff - What a consumer spinning on a ZerodhaTickQueue does when the queue is empty
+ *
+ * The first idle polls pause the core for exponentially longer, up to 64 pause instructions, so a tick arriving
+ * right after is picked up within a few hundred nanoseconds while the sibling hyperthread keeps most of the core.
+ * After spin_polls idle polls in a row the consumer yields its core on every poll until work shows up again.
+ */
+class ZerodhaPollBackoff final {
+public:
+    explicit ZerodhaPollBackoff(uint32_t spin_polls) noexcept : spin_polls_(spin_polls) {
+    }
+
+    /// The last poll found work
+    auto reset() noexcept -> void {
+        idle_polls_ = 0;
+    }
+
+    /// The last poll found nothing, back off before the next one
+    auto idle() noexcept -> void {
+        if (idle_polls_ < spin_polls_) {
+            const auto pauses = 1U << std::min<uint32_t>(idle_polls_, 6);
+            for (uint32_t i = 0; i < pauses; ++i) {
+                __builtin_ia32_pause();
+            }
+            ++idle_polls_;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    auto idlePolls() const noexcept { return idle_polls_; }
+
+private:
+    const uint32_t spin_polls_;
+    uint32_t idle_polls_ = 0;
+};
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <string>
+
+#include "common/time_utils.h"
+
+namespace Adapter {
+namespace Zerodha {
+
+/**
+ * Snapshot of the tick latencies of the market data adapter, from a frame being received to the market updates of
+ * its ticks being published. Percentiles are upper bounds, within a quarter of the true value.
+ */
+struct ZerodhaTickLatencyStats {
+    size_t ticks = 0;
+    Common::Nanos mean = 0;
+    Common::Nanos p50 = 0;
+    Common::Nanos p99 = 0;
+    Common::Nanos p999 = 0;
+    Common::Nanos max = 0;
+
+    auto toString() const -> std::string {
+        return "ticks:" + std::to_string(ticks) + " mean:" + std::to_string(mean) + "ns p50:" + std::to_string(p50) +
+               "ns p99:" + std::to_string(p99) + "ns p99.9:" + std::to_string(p999) + "ns max:" + std::to_string(max) + "ns";
+    }
+};
+
+/**
+ * ZerodhaTickLatency - Histogram of tick latencies, one thread records, any thread reads
+ *
+ * Four buckets per power of two nanoseconds, so recording is a bit scan and a store and percentiles come out within
+ * 25%. The recording thread owns the counters, a reader may see a snapshot a few ticks behind.
+ */
+class ZerodhaTickLatency final {
+public:
+    /// Record the latency of one tick - called by the thread applying the ticks only
+    auto record(Common::Nanos latency) noexcept -> void {
+        const auto value = static_cast<uint64_t>(latency > 0 ? latency : 0);
+        increment(buckets_[bucketOf(value)], 1);
+        increment(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+        increment(count_, 1);
+    }
+
+    auto snapshot() const noexcept -> ZerodhaTickLatencyStats {
+        ZerodhaTickLatencyStats stats;
+        std::array<uint64_t, NUM_BUCKETS> buckets;
+        uint64_t total = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+            buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            total += buckets[i];
+        }
+        if (!total) {
+            return stats;
+        }
+
+        stats.ticks = total;
+        stats.mean = static_cast<Common::Nanos>(sum_.load(std::memory_order_relaxed) / std::max<uint64_t>(count_.load(std::memory_order_relaxed), 1));
+        stats.max = static_cast<Common::Nanos>(max_.load(std::memory_order_relaxed));
+        stats.p50 = percentile(buckets, total, 0.5);
+        stats.p99 = percentile(buckets, total, 0.99);
+        stats.p999 = percentile(buckets, total, 0.999);
+        return stats;
+    }
+
+private:
+    // Values below 4 get a bucket each, then 4 per power of two up to 2^41ns (about 36 minutes)
+    static constexpr size_t NUM_BUCKETS = 4 * 41;
+
+    static auto bucketOf(uint64_t value) noexcept -> size_t {
+        if (value < 4) {
+            return value;
+        }
+        const auto exponent = static_cast<size_t>(std::bit_width(value)) - 1;
+        const auto bucket = 4 * (exponent - 1) + ((value >> (exponent - 2)) & 3);
+        return std::min(bucket, NUM_BUCKETS - 1);
+    }
+
+    // Largest value of a bucket
+    static auto upperBound(size_t bucket) noexcept -> Common::Nanos {
+        if (bucket < 4) {
+            return static_cast<Common::Nanos>(bucket);
+        }
+        const auto exponent = bucket / 4 + 1;
+        const auto lower = (4 + bucket % 4) << (exponent - 2);
+        return static_cast<Common::Nanos>(lower + (uint64_t{1} << (exponent - 2)) - 1);
+    }
+
+    static auto percentile(const std::array<uint64_t, NUM_BUCKETS>& buckets, uint64_t total, double fraction) noexcept -> Common::Nanos {
+        const auto rank = static_cast<uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return upperBound(i);
+            }
+        }
+        return upperBound(NUM_BUCKETS - 1);
+    }
+
+    // Single writer, so a plain load and store instead of a locked add
+    static auto increment(std::atomic<uint64_t>& counter, uint64_t value) noexcept -> void {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets_{};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -20,7 +20,7 @@ namespace Zerodha {
 ZerodhaWebSocketClient::ZerodhaWebSocketClient(
     const std::string& api_key,
     const std::string& access_token,
-    Common::LFQueue<MarketUpdate>& update_queue,
+    ZerodhaTickQueue& update_queue,
     Common::Logger* logger)
     : api_key_(api_key),
       access_token_(access_token),
@@ -28,7 +28,7 @@ ZerodhaWebSocketClient::ZerodhaWebSocketClient(
       logger_(logger)
 {
     // Generate WebSocket URL with authentication parameters
-    ws_url_ = "wss://ws.kite.trade/?api_key=" + api_key_ + "&access_token=" + access_token_;
+    ws_url_ = "wss://" + ws_host_ + "/?api_key=" + api_key_ + "&access_token=" + access_token_;
     
     // Initialize Boost.Beast components
     std::string init_str;
@@ -119,6 +119,18 @@ ZerodhaWebSocketClient::~ZerodhaWebSocketClient() {
     }
 }
 
+void ZerodhaWebSocketClient::set_endpoint(const std::string& host, const std::string& port, bool verify_peer) {
+    ws_host_ = host;
+    ws_port_ = port;
+    ws_url_ = "wss://" + ws_host_ + "/?api_key=" + api_key_ + "&access_token=" + access_token_;
+    ssl_ctx_->set_verify_mode(verify_peer ? ssl::verify_peer : ssl::verify_none);
+    
+    std::string time_str;
+    logger_->log("%:% %() % WebSocket endpoint set to %:% (verify_peer=%)\n",
+                __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str),
+                ws_host_.c_str(), ws_port_.c_str(), verify_peer);
+}
+
 bool ZerodhaWebSocketClient::connect() {
     if (connected_) {
         // Already connected
@@ -155,9 +167,9 @@ bool ZerodhaWebSocketClient::connect() {
     
     // Log connection details
     std::string conn_str;
-    logger_->log("%:% %() % Connection details: host='%', path='%', port=443, secure=true\n", 
+    logger_->log("%:% %() % Connection details: host='%', path='%', port=%, secure=true\n", 
               __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&conn_str),
-              host.c_str(), path.c_str());
+              host.c_str(), path.c_str(), ws_port_.c_str());
     
     // Start a thread for the WebSocket connection
     ws_thread_ = std::thread([this, host, path]() {
@@ -170,7 +182,7 @@ bool ZerodhaWebSocketClient::connect() {
             auto socket = std::make_unique<tcp::socket>(net::make_strand(*ioc_));
             
             // Resolve the host name and port
-            std::string port_str = "443"; // Always use 443 for wss://
+            std::string port_str = ws_port_; // 443 unless set_endpoint() moved it
             auto const results = resolver_->resolve(host, port_str);
             
             // Create the WebSocket SSL stream
@@ -212,6 +224,7 @@ bool ZerodhaWebSocketClient::connect() {
             // Connection established successfully
             ws_open_ = true;
             connected_ = true;
+            token_load_.restart();
             
             std::string success_str;
             logger_->log("%:% %() % WebSocket connection established\n", 
@@ -284,9 +297,10 @@ bool ZerodhaWebSocketClient::connect() {
                         }
                     }
                     
-                    // Add a short sleep to avoid spinning CPU if reads are very fast
-                    if (running_) {
-                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    // The read blocks until a frame arrives or times out, there is no spinning to avoid. A waiting
+                    // subscribe, unsubscribe or mode message gets the connection before the next read
+                    while (pending_writes_.load(std::memory_order_acquire) > 0 && running_) {
+                        std::this_thread::yield();
                     }
                 } catch (const beast::system_error& e) {
                     if (e.code() == beast::websocket::error::closed) {
@@ -464,8 +478,16 @@ bool ZerodhaWebSocketClient::subscribe(const std::vector<int32_t>& instrument_to
                          StreamingMode mode) {
     if (!connected_) {
         std::string time_str;
-        logger_->log("%:% %() % Cannot subscribe, not connected\n", 
-                    __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
+        logger_->log("%:% %() % Not connected, % tokens subscribed to once connected\n", 
+                    __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str),
+                    instrument_tokens.size());
+        
+        // on_connect() subscribes to them
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        for (auto token : instrument_tokens) {
+            subscribed_tokens_.insert(token);
+            token_modes_[token] = mode;
+        }
         return false;
     }
     
@@ -496,6 +518,13 @@ bool ZerodhaWebSocketClient::unsubscribe(const std::vector<int32_t>& instrument_
         std::string time_str;
         logger_->log("%:% %() % Cannot unsubscribe, not connected\n", 
                     __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
+        
+        // Not subscribed to again once connected
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        for (auto token : instrument_tokens) {
+            subscribed_tokens_.erase(token);
+            token_modes_.erase(token);
+        }
         return false;
     }
     
@@ -521,6 +550,14 @@ bool ZerodhaWebSocketClient::set_mode(const std::vector<int32_t>& instrument_tok
         std::string time_str;
         logger_->log("%:% %() % Cannot set mode, not connected\n", 
                     __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));
+        
+        // Subscribed to in this mode once connected
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        for (auto token : instrument_tokens) {
+            if (subscribed_tokens_.count(token) > 0) {
+                token_modes_[token] = mode;
+            }
+        }
         return false;
     }
     
@@ -587,6 +624,12 @@ void ZerodhaWebSocketClient::on_disconnect(int code, const std::string& message)
 void ZerodhaWebSocketClient::on_message(const char* data, size_t length, bool is_binary) {
     std::string time_str;
     
+    // Journal the frame as received, before any parsing
+    if (journal_) {
+        journal_->push(is_binary ? Common::JournalRecordType::ZERODHA_BINARY : Common::JournalRecordType::ZERODHA_TEXT,
+                       Common::getCurrentNanos(), data, length);
+    }
+    
     // Log information about the received message
     if (is_binary) {
         logger_->log("%:% %() % Received binary message of length %\n", 
@@ -636,226 +679,26 @@ void ZerodhaWebSocketClient::parse_binary_message(const char* data, size_t lengt
     }
     
     // Read number of packets (first 2 bytes)
-    int16_t num_packets = ntohs_manual(*reinterpret_cast<const int16_t*>(data));
+    int16_t num_packets = ntohs(*reinterpret_cast<const int16_t*>(data));
     
     logger_->log("%:% %() % Processing % packets from binary message\n", 
                __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), 
                num_packets);
     
-    // Process each packet
-    size_t offset = 2; // Start after num_packets
-    int processed_packets = 0;
-    
-    for (int i = 0; i < num_packets && offset + 2 < length; i++) {
-        // Read packet length (2 bytes)
-        int16_t packet_length = ntohs_manual(*reinterpret_cast<const int16_t*>(data + offset));
-        offset += 2;
-        
-        // Ensure we have enough bytes
-        if (offset + packet_length > length) {
-            logger_->log("%:% %() % Packet % truncated, need % bytes but only % remaining\n", 
-                       __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), 
-                       i, packet_length, length - offset);
-            break;
-        }
-        
-        // Get next slot in queue
-        MarketUpdate* update = update_queue_.getNextToWriteTo();
-        if (update) {
-            const char* packet_data = data + offset;
-            
-            // Set timestamp
-            update->timestamp = Common::getCurrentNanos();
-            
-            // Parse packet into update
-            parse_packet(packet_data, packet_length, update);
-            
-            // Commit the update
-            update_queue_.updateWriteIndex();
-            processed_packets++;
-        } else {
-            logger_->log("%:% %() % Queue full, cannot process packet %\n", 
-                       __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), 
-                       i);
-        }
-        
-        // Move to next packet
-        offset += packet_length;
-    }
+    // Decode all packets in one pass, each straight into the next slot in the queue
+    const auto timestamp = Common::getCurrentNanos();
+    const auto processed_packets = decoder_.decodeFrame(data, length, [&](const KiteTick& tick) {
+        update_queue_.push(tick, timestamp);
+        token_load_.record(tick.instrument_token);
+    });
     
     logger_->log("%:% %() % Successfully processed % of % packets\n", 
                __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), 
                processed_packets, num_packets);
-}
-
-void ZerodhaWebSocketClient::parse_packet(const char* data, size_t packet_length, MarketUpdate* update) {
-    // Read instrument token (first 4 bytes)
-    int32_t token = ntohl_manual(*reinterpret_cast<const int32_t*>(data));
-    update->instrument_token = token;
-    
-    // Determine packet type based on length and token
-    if (is_index_token(token)) {
-        // Index packet
-        update->type = MarketUpdateType::INDEX;
-        parse_index_packet(data, packet_length, update);
-    } else if (packet_length == 8) {
-        // LTP packet (mode = "ltp")
-        update->type = MarketUpdateType::LTP;
-        parse_ltp_packet(data, update);
-    } else if (packet_length == 44) {
-        // Quote packet (mode = "quote")
-        update->type = MarketUpdateType::QUOTE;
-        parse_quote_packet(data, update);
-    } else if (packet_length == 184) {
-        // Full packet (mode = "full")
-        update->type = MarketUpdateType::FULL;
-        parse_full_packet(data, update);
-    } else {
-        // Unknown packet type
-        std::string time_str;
-        logger_->log("%:% %() % Unknown packet type: token=%, length=%\n", 
-                    __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str), 
-                    token, packet_length);
-    }
-}
-
-void ZerodhaWebSocketClient::parse_ltp_packet(const char* data, MarketUpdate* update) {
-    // LTP packet format:
-    // Bytes 0-3: Instrument token (already read)
-    // Bytes 4-7: Last traded price
-    
-    // Read last traded price (bytes 4-7)
-    int32_t last_price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 4));
-    
-    // Convert price from paise to rupees (divide by 100)
-    update->last_price = last_price / 100.0;
-}
-
-void ZerodhaWebSocketClient::parse_quote_packet(const char* data, MarketUpdate* update) {
-    // Quote packet format:
-    // Bytes 0-3: Instrument token (already read)
-    // Bytes 4-7: Last traded price
-    // Bytes 8-11: Last traded quantity
-    // Bytes 12-15: Average traded price
-    // Bytes 16-19: Volume traded for the day
-    // Bytes 20-23: Total buy quantity
-    // Bytes 24-27: Total sell quantity
-    // Bytes 28-31: Open price of the day
-    // Bytes 32-35: High price of the day
-    // Bytes 36-39: Low price of the day
-    // Bytes 40-43: Close price
-    
-    // Parse all fields
-    int32_t last_price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 4));
-    int32_t last_quantity = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 8));
-    int32_t average_price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 12));
-    int32_t volume = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 16));
-    int32_t buy_quantity = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 20));
-    int32_t sell_quantity = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 24));
-    int32_t open_price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 28));
-    int32_t high_price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 32));
-    int32_t low_price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 36));
-    int32_t close_price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 40));
-    
-    // Convert all prices from paise to rupees (divide by 100)
-    update->last_price = last_price / 100.0;
-    update->last_quantity = last_quantity;
-    update->average_price = average_price / 100.0;
-    update->volume = volume;
-    update->buy_quantity = buy_quantity;
-    update->sell_quantity = sell_quantity;
-    update->open_price = open_price / 100.0;
-    update->high_price = high_price / 100.0;
-    update->low_price = low_price / 100.0;
-    update->close_price = close_price / 100.0;
-}
-
-void ZerodhaWebSocketClient::parse_full_packet(const char* data, MarketUpdate* update) {
-    // First parse all the quote fields (first 44 bytes)
-    parse_quote_packet(data, update);
     
-    // Full packet format (additional fields):
-    // Bytes 44-47: Last traded timestamp
-    // Bytes 48-51: Open Interest
-    // Bytes 52-55: Open Interest Day High
-    // Bytes 56-59: Open Interest Day Low
-    // Bytes 60-63: Exchange timestamp
-    // Bytes 64-183: Market depth entries (10 entries, 12 bytes each)
-    
-    // Parse additional fields
-    int32_t last_trade_time = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 44));
-    int32_t open_interest = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 48));
-    int32_t oi_day_high = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 52));
-    int32_t oi_day_low = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 56));
-    int32_t exchange_timestamp = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 60));
-    
-    update->last_trade_time = last_trade_time;
-    update->open_interest = open_interest;
-    update->open_interest_day_high = oi_day_high;
-    update->open_interest_day_low = oi_day_low;
-    update->exchange_timestamp = exchange_timestamp;
-    
-    // Parse market depth (5 bid and 5 ask levels)
-    for (int i = 0; i < 5; i++) {
-        // Bids (first 5 entries)
-        int offset = 64 + (i * 12); // Each entry is 12 bytes
-        
-        // Each entry has: quantity (4 bytes), price (4 bytes), orders (2 bytes), padding (2 bytes)
-        int32_t quantity = ntohl_manual(*reinterpret_cast<const int32_t*>(data + offset));
-        int32_t price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + offset + 4));
-        int16_t orders = ntohs_manual(*reinterpret_cast<const int16_t*>(data + offset + 8));
-        
-        update->bids[i].quantity = quantity;
-        update->bids[i].price = price;
-        update->bids[i].orders = orders;
-        update->bids[i].padding = 0; // Skip padding
-    }
-    
-    for (int i = 0; i < 5; i++) {
-        // Asks (next 5 entries)
-        int offset = 124 + (i * 12); // 64 + (5 * 12) = 124 (start of asks)
-        
-        int32_t quantity = ntohl_manual(*reinterpret_cast<const int32_t*>(data + offset));
-        int32_t price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + offset + 4));
-        int16_t orders = ntohs_manual(*reinterpret_cast<const int16_t*>(data + offset + 8));
-        
-        update->asks[i].quantity = quantity;
-        update->asks[i].price = price;
-        update->asks[i].orders = orders;
-        update->asks[i].padding = 0; // Skip padding
-    }
-}
-
-void ZerodhaWebSocketClient::parse_index_packet(const char* data, size_t length, MarketUpdate* update) {
-    // Index packet format:
-    // Bytes 0-3: Token (already read)
-    // Bytes 4-7: Last traded price
-    // Bytes 8-11: High of the day
-    // Bytes 12-15: Low of the day
-    // Bytes 16-19: Open of the day
-    // Bytes 20-23: Close of the day
-    // Bytes 24-27: Price change (If mode is quote, the packet ends here)
-    // Bytes 28-31: Exchange timestamp (only in full mode)
-    
-    // Parse fields
-    int32_t last_price = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 4));
-    int32_t high = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 8));
-    int32_t low = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 12));
-    int32_t open = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 16));
-    int32_t close = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 20));
-    
-    // Convert all prices from paise to rupees (divide by 100)
-    update->last_price = last_price / 100.0;
-    update->high_price = high / 100.0;
-    update->low_price = low / 100.0;
-    update->open_price = open / 100.0;
-    update->close_price = close / 100.0;
-    
-    // Check if we have the extended fields
-    if (length >= 32) {
-        // Full mode includes exchange timestamp
-        int32_t exchange_timestamp = ntohl_manual(*reinterpret_cast<const int32_t*>(data + 28));
-        update->exchange_timestamp = exchange_timestamp;
+    // Apply the ticks right here when the consumer runs inline
+    if (on_ticks_ && processed_packets > 0) {
+        on_ticks_();
     }
 }
 
@@ -904,6 +747,18 @@ bool ZerodhaWebSocketClient::send_subscription(const std::vector<int32_t>& token
         return false;
     }
     
+    // A batch larger than a frame holds goes out in consecutive frames
+    if (tokens.size() > MAX_TOKENS_PER_FRAME) {
+        for (size_t offset = 0; offset < tokens.size(); offset += MAX_TOKENS_PER_FRAME) {
+            const std::vector<int32_t> frame(tokens.begin() + static_cast<std::ptrdiff_t>(offset),
+                                             tokens.begin() + static_cast<std::ptrdiff_t>(std::min(offset + MAX_TOKENS_PER_FRAME, tokens.size())));
+            if (!send_subscription(frame, action)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
     // Create subscription message
     nlohmann::json message = {
         {"a", action},
@@ -920,7 +775,9 @@ bool ZerodhaWebSocketClient::send_subscription(const std::vector<int32_t>& token
     try {
         // Send the message using Boost.Beast with thread safety
         {
+            pending_writes_.fetch_add(1, std::memory_order_release);
             std::lock_guard<std::mutex> lock(ws_mutex_);
+            pending_writes_.fetch_sub(1, std::memory_order_release);
             if (ws_ && ws_->is_open()) {
                 beast::error_code ec;
                 ws_->write(net::buffer(json_str), ec);
@@ -952,6 +809,18 @@ bool ZerodhaWebSocketClient::send_mode_change(const std::vector<int32_t>& tokens
         return false;
     }
     
+    // A batch larger than a frame holds goes out in consecutive frames
+    if (tokens.size() > MAX_TOKENS_PER_FRAME) {
+        for (size_t offset = 0; offset < tokens.size(); offset += MAX_TOKENS_PER_FRAME) {
+            const std::vector<int32_t> frame(tokens.begin() + static_cast<std::ptrdiff_t>(offset),
+                                             tokens.begin() + static_cast<std::ptrdiff_t>(std::min(offset + MAX_TOKENS_PER_FRAME, tokens.size())));
+            if (!send_mode_change(frame, mode)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
     // Convert mode enum to string
     std::string mode_str = mode_to_string(mode);
     
@@ -971,7 +840,9 @@ bool ZerodhaWebSocketClient::send_mode_change(const std::vector<int32_t>& tokens
     try {
         // Send the message using Boost.Beast with thread safety
         {
+            pending_writes_.fetch_add(1, std::memory_order_release);
             std::lock_guard<std::mutex> lock(ws_mutex_);
+            pending_writes_.fetch_sub(1, std::memory_order_release);
             if (ws_ && ws_->is_open()) {
                 beast::error_code ec;
                 ws_->write(net::buffer(json_str), ec);
@@ -1009,9 +880,8 @@ std::string ZerodhaWebSocketClient::mode_to_string(StreamingMode mode) const {
 
 
 void ZerodhaWebSocketClient::reconnect() {
-    // Use a mutex to prevent concurrent reconnection attempts
-    static std::mutex reconnect_mutex;
-    std::unique_lock<std::mutex> lock(reconnect_mutex, std::try_to_lock);
+    // Use a mutex to prevent concurrent reconnection attempts of this connection
+    std::unique_lock<std::mutex> lock(reconnect_mutex_, std::try_to_lock);
     
     // If we can't acquire the lock, another reconnection is in progress
     if (!lock.owns_lock() || reconnecting_) {
@@ -1106,19 +976,5 @@ void ZerodhaWebSocketClient::reconnect() {
     reconnecting_ = false;
 }
 
-bool ZerodhaWebSocketClient::is_index_token(int32_t token) const {
-    // Zerodha uses specific ranges for index tokens
-    // This is a simplified check - adjust based on actual token ranges
-    return token >= 100000 && token <= 300000;
-}
-
-int32_t ZerodhaWebSocketClient::ntohl_manual(int32_t value) const {
-    return ntohl(value);
-}
-
-int16_t ZerodhaWebSocketClient::ntohs_manual(int16_t value) const {
-    return ntohs(value);
-}
-
 } // namespace Zerodha
 } // namespace Adapter
\ No newline at end of file
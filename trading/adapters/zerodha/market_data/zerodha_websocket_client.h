@@ -12,11 +12,16 @@
 #include <algorithm>
 #include <memory>
 #include <future>
+#include <functional>
 
 // Common utilities
 #include "common/logging.h"
 #include "common/lf_queue.h"
 #include "common/time_utils.h"
+#include "common/journal_recorder.h"
+
+#include "kite_tick_decoder.h"
+#include "zerodha_tick.h"
 
 // Boost.Beast includes
 #include <boost/beast/core.hpp>
@@ -37,14 +42,6 @@ using tcp = boost::asio::ip::tcp;
 namespace Adapter {
 namespace Zerodha {
 
-// Market data structures
-struct MarketDepthEntry {
-    int32_t quantity;  // Order quantity
-    int32_t price;     // Order price (in paise)
-    int16_t orders;    // Number of orders at this level
-    uint16_t padding;  // 2-byte padding to skip
-};
-
 // Supported streaming modes
 enum class StreamingMode {
     LTP,    // Last trade price only
@@ -52,42 +49,85 @@ enum class StreamingMode {
     FULL    // Full market quotes with depth
 };
 
-// Type of market update
-enum class MarketUpdateType {
-    LTP,     // Last trade price update
-    QUOTE,   // Market quote update
-    FULL,    // Full market update
-    INDEX    // Index update
-};
+/**
+ * ZerodhaTokenLoad - Ticks received per instrument token on one connection
+ *
+ * Open addressing over a fixed number of slots, well above the instruments Kite allows on a connection, so counting
+ * a tick never allocates. The receiving thread counts, any thread may read the counters or start counting from zero.
+ * Each slot is tagged with the epoch it was counted in and a reset only moves to the next epoch, the receiving thread
+ * takes over slots of older epochs as it meets them instead of clearing the table.
+ */
+class ZerodhaTokenLoad final {
+public:
+    static constexpr size_t SLOT_BITS = 13;
+    static constexpr size_t NUM_SLOTS = size_t{1} << SLOT_BITS;
+
+    /// Count a tick of a token - receiving thread only
+    auto record(int32_t instrument_token) noexcept -> void {
+        const auto epoch = epoch_.load(std::memory_order_relaxed);
+        const auto key = keyOf(epoch, instrument_token);
+        
+        // Kite tokens differ in their high bits, the top bits of the Fibonacci product mix them all
+        auto index = static_cast<size_t>((static_cast<uint32_t>(instrument_token) * 0x9e3779b9U) >> (32 - SLOT_BITS));
+        for (size_t probes = 0; probes < NUM_SLOTS; ++probes, index = (index + 1) & (NUM_SLOTS - 1)) {
+            auto& slot = slots_[index];
+            const auto slot_key = slot.key.load(std::memory_order_relaxed);
+            if (slot_key == key) {
+                slot.ticks.store(slot.ticks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            
+            // Slots of this epoch are only ever taken in probe order, the token has none past a slot of an older one
+            if ((slot_key >> 32) != epoch) {
+                slot.ticks.store(1, std::memory_order_relaxed);
+                slot.key.store(key, std::memory_order_release);
+                return;
+            }
+        }
+    }
+
+    /// Call f(token, ticks) for every token counted since the last reset - any thread
+    template<typename F>
+    auto forEach(F&& f) const -> void {
+        const auto epoch = epoch_.load(std::memory_order_relaxed);
+        for (const auto& slot : slots_) {
+            const auto key = slot.key.load(std::memory_order_acquire);
+            if ((key >> 32) == epoch) {
+                f(static_cast<int32_t>(static_cast<uint32_t>(key)), slot.ticks.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    /// Start counting from zero again - any thread
+    auto reset() noexcept -> void {
+        epoch_.fetch_add(1, std::memory_order_relaxed);
+    }
 
-// Market update structure that will be published via LFQueue
-struct MarketUpdate {
-    int32_t instrument_token;      // Instrument identifier
-    uint64_t timestamp;            // Update timestamp (microseconds)
-    MarketUpdateType type;         // LTP, QUOTE, or FULL
-    double last_price;             // Last traded price
-    
-    // Fields for QUOTE and FULL modes
-    double last_quantity;          // Last traded quantity
-    double average_price;          // Average traded price
-    double volume;                 // Volume traded for the day
-    double buy_quantity;           // Total buy quantity
-    double sell_quantity;          // Total sell quantity
-    double open_price;             // Open price
-    double high_price;             // High price
-    double low_price;              // Low price
-    double close_price;            // Close price
-    
-    // Additional fields for FULL mode
-    uint64_t last_trade_time;      // Last trade timestamp
-    double open_interest;          // Open interest
-    double open_interest_day_high; // Open interest day high
-    double open_interest_day_low;  // Open interest day low
-    uint64_t exchange_timestamp;   // Exchange timestamp
-    
-    // Market depth (only for FULL mode)
-    std::array<MarketDepthEntry, 5> bids;  // Bid depth levels
-    std::array<MarketDepthEntry, 5> asks;  // Ask depth levels
+    /// Start counting from zero on a connection which just came up, the next interval only covers part of it - any thread
+    auto restart() noexcept -> void {
+        restarted_.store(true, std::memory_order_relaxed);
+        reset();
+    }
+
+    /// Whether the connection came up since the last call - any thread
+    auto takeRestarted() noexcept -> bool {
+        return restarted_.exchange(false, std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> key{0};
+        std::atomic<uint64_t> ticks{0};
+    };
+
+    // Epoch in the high half, token in the low half, an empty slot is of epoch 0 which is never counted in
+    static constexpr auto keyOf(uint32_t epoch, int32_t instrument_token) noexcept -> uint64_t {
+        return (uint64_t{epoch} << 32) | static_cast<uint32_t>(instrument_token);
+    }
+
+    std::array<Slot, NUM_SLOTS> slots_;
+    std::atomic<uint32_t> epoch_{1};
+    std::atomic<bool> restarted_{false};
 };
 
 /**
@@ -105,18 +145,21 @@ struct WebSocketUserData;
 
 class ZerodhaWebSocketClient {
 public:
+    // Tokens in one subscribe, unsubscribe or mode message, larger batches are split over several
+    static constexpr size_t MAX_TOKENS_PER_FRAME = 1000;
+    
     /**
      * Constructor
      * 
      * @param api_key Zerodha API key
      * @param access_token Authentication token from ZerodhaAuthenticator
-     * @param update_queue Lock-free queue for publishing market updates
+     * @param update_queue Lock-free queue for publishing the decoded ticks
      * @param logger Logger for diagnostic messages
      */
     ZerodhaWebSocketClient(
         const std::string& api_key,
         const std::string& access_token,
-        Common::LFQueue<MarketUpdate>& update_queue,
+        ZerodhaTickQueue& update_queue,
         Common::Logger* logger
     );
 
@@ -125,6 +168,15 @@ public:
      */
     ~ZerodhaWebSocketClient();
     
+    /**
+     * Point the client at another Kite compatible endpoint, e.g. a local simulator, before connect()
+     * 
+     * @param host Host name or address
+     * @param port Port
+     * @param verify_peer false to accept a self-signed certificate
+     */
+    void set_endpoint(const std::string& host, const std::string& port, bool verify_peer);
+    
     /**
      * Connect to the Kite WebSocket API
      * 
@@ -149,7 +201,8 @@ public:
      * 
      * @param instrument_tokens Vector of instrument tokens to subscribe to
      * @param mode Streaming mode (LTP, QUOTE, or FULL)
-     * @return true if subscription message was sent successfully
+     * @return true if subscription message was sent successfully, false if not connected the tokens are
+     *         subscribed to once the connection is up
      */
     bool subscribe(const std::vector<int32_t>& instrument_tokens, 
                    StreamingMode mode = StreamingMode::FULL);
@@ -172,6 +225,36 @@ public:
     bool set_mode(const std::vector<int32_t>& instrument_tokens, 
                   StreamingMode mode);
 
+    /**
+     * Copy every raw frame into a journal recorder ring as it arrives
+     * 
+     * @param journal Ring of a JournalRecorder, nullptr to stop journaling
+     */
+    void set_journal(Common::JournalByteRing* journal) { journal_ = journal; }
+
+    /**
+     * Call back after the ticks of each binary frame are queued, on the thread that received the frame, so the
+     * consumer of the queue can run on that thread instead of polling it from another one. Set before connect().
+     * 
+     * @param on_ticks Callback, empty to leave the queue to its consumer thread
+     */
+    void set_on_ticks(std::function<void()> on_ticks) { on_ticks_ = std::move(on_ticks); }
+
+    /**
+     * Ticks received per instrument token since the counters were last reset
+     */
+    ZerodhaTokenLoad& token_load() { return token_load_; }
+
+    /**
+     * Feed a recorded frame through the same path as a frame received on the WebSocket,
+     * no connection is needed
+     * 
+     * @param data Frame as journaled (ZERODHA_BINARY or ZERODHA_TEXT record payload)
+     * @param length Length of the frame in bytes
+     * @param is_binary true for binary tick frames, false for text frames
+     */
+    void replay_message(const char* data, size_t length, bool is_binary) { on_message(data, length, is_binary); }
+
 private:
     // WebSocket event handlers
     void on_connect();
@@ -181,16 +264,11 @@ private:
     
     // Binary message parsing methods
     void parse_binary_message(const char* data, size_t length);
-    void parse_packet(const char* data, size_t packet_length, MarketUpdate* update);
-    void parse_ltp_packet(const char* data, MarketUpdate* update);
-    void parse_quote_packet(const char* data, MarketUpdate* update);
-    void parse_full_packet(const char* data, MarketUpdate* update);
-    void parse_index_packet(const char* data, size_t length, MarketUpdate* update);
     
     // JSON message handling
     void handle_text_message(const std::string& message);
     
-    // Subscription helpers
+    // Subscription helpers, each sends as many messages of up to MAX_TOKENS_PER_FRAME tokens as needed
     bool send_subscription(const std::vector<int32_t>& tokens, const std::string& action);
     bool send_mode_change(const std::vector<int32_t>& tokens, StreamingMode mode);
     
@@ -200,22 +278,29 @@ private:
     // WebSocket loop and reconnection
     void reconnect();
     
-    // Helper to check if a token is an index
-    bool is_index_token(int32_t token) const;
-    
-    // Convert network-byte-order (big endian) to host byte order
-    int32_t ntohl_manual(int32_t value) const;
-    int16_t ntohs_manual(int16_t value) const;
-    
     // Connection details
     std::string api_key_;
     std::string access_token_;
     std::string ws_url_;
+    std::string ws_host_ = "ws.kite.trade";
+    std::string ws_port_ = "443";
+    
+    // Binary frame decoder
+    KiteTickDecoder decoder_;
     
     // Output queue and logger
-    Common::LFQueue<MarketUpdate>& update_queue_;
+    ZerodhaTickQueue& update_queue_;
     Common::Logger* logger_;
     
+    // Optional journal recorder ring for the raw frames
+    Common::JournalByteRing* journal_ = nullptr;
+    
+    // Optional consumer of the queue run inline after each frame
+    std::function<void()> on_ticks_;
+    
+    // Ticks per token, for the rebalancing of a ZerodhaWebSocketPool
+    ZerodhaTokenLoad token_load_;
+    
     // Boost.Beast WebSocket client components
     std::unique_ptr<net::io_context> ioc_;
     std::unique_ptr<ssl::context> ssl_ctx_;
@@ -230,6 +315,7 @@ private:
     
     // Synchronization
     std::mutex ws_mutex_; // Protects WebSocket access
+    std::atomic<int> pending_writes_{0}; // Writers waiting for ws_mutex_, the reader lets them in before its next read
     
     // Subscription state
     std::unordered_set<int32_t> subscribed_tokens_;
@@ -240,6 +326,7 @@ private:
     std::thread ws_thread_;
     
     // Reconnection parameters
+    std::mutex reconnect_mutex_;
     uint32_t reconnect_attempt_{0};
     std::chrono::milliseconds reconnect_delay_{1000};
     const std::chrono::milliseconds max_reconnect_delay_{30000};
@@ -0,0 +1,284 @@
+#include "zerodha_websocket_pool.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+namespace Adapter {
+namespace Zerodha {
+
+namespace {
+    // A connection is rebalanced once it received this many times the ticks of the quietest one, and at least
+    // MIN_TICKS_TO_REBALANCE more, so a quiet feed is left alone
+    constexpr double IMBALANCE = 1.5;
+    constexpr uint64_t MIN_TICKS_TO_REBALANCE = 1000;
+
+    // Tokens moved per rebalance at most, each move is a subscribe and an unsubscribe message
+    constexpr size_t MAX_MOVES_PER_REBALANCE = 32;
+}
+
+ZerodhaWebSocketPool::ZerodhaWebSocketPool(const std::string& api_key,
+                                           const std::string& access_token,
+                                           size_t num_connections,
+                                           size_t queue_size,
+                                           Common::Logger* logger)
+    : logger_(logger) {
+    num_connections = std::clamp<size_t>(num_connections, 1, MAX_CONNECTIONS);
+    for (size_t i = 0; i < num_connections; ++i) {
+        connections_.push_back(std::make_unique<Connection>(api_key, access_token, queue_size, logger_));
+    }
+
+    std::string time_str;
+    logger_->log("%:% %() % WebSocket pool of % connections\n",
+                __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str),
+                connections_.size());
+}
+
+ZerodhaWebSocketPool::~ZerodhaWebSocketPool() {
+    stopRebalancer();
+}
+
+void ZerodhaWebSocketPool::set_endpoint(const std::string& host, const std::string& port, bool verify_peer) {
+    for (auto& connection : connections_) {
+        connection->client.set_endpoint(host, port, verify_peer);
+    }
+}
+
+void ZerodhaWebSocketPool::set_journal(size_t connection, Common::JournalByteRing* journal) {
+    if (connection < connections_.size()) {
+        connections_[connection]->client.set_journal(journal);
+    }
+}
+
+void ZerodhaWebSocketPool::set_on_ticks(std::function<void()> on_ticks) {
+    for (auto& connection : connections_) {
+        connection->client.set_on_ticks(on_ticks);
+    }
+}
+
+bool ZerodhaWebSocketPool::connect() {
+    bool connected = true;
+    for (auto& connection : connections_) {
+        connected &= connection->client.connect();
+    }
+
+    // Nothing to move between with a single connection
+    std::lock_guard<std::mutex> lock(rebalancer_mutex_);
+    if (connections_.size() > 1 && rebalance_interval_.count() > 0 && !rebalancer_running_) {
+        rebalancer_running_ = true;
+        rebalancer_thread_ = std::thread([this]() { runRebalancer(); });
+    }
+    return connected;
+}
+
+void ZerodhaWebSocketPool::disconnect() {
+    stopRebalancer();
+    for (auto& connection : connections_) {
+        connection->client.disconnect();
+    }
+}
+
+bool ZerodhaWebSocketPool::is_connected() const {
+    return std::all_of(connections_.begin(), connections_.end(), [](const auto& connection) { return connection->client.is_connected(); });
+}
+
+bool ZerodhaWebSocketPool::subscribe(const std::vector<int32_t>& instrument_tokens, StreamingMode mode) {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+
+    bool sent = true;
+    std::vector<std::vector<int32_t>> tokens(connections_.size());
+    for (const auto token : instrument_tokens) {
+        auto it = subscriptions_.find(token);
+        if (it != subscriptions_.end()) {
+            it->second.mode = mode;
+            tokens[it->second.connection].push_back(token);
+            continue;
+        }
+
+        // A new token goes to the connection with the fewest
+        const auto connection = static_cast<size_t>(std::min_element(connections_.begin(), connections_.end(), [](const auto& a, const auto& b) {
+            return a->num_tokens < b->num_tokens;
+        }) - connections_.begin());
+        if (connections_[connection]->num_tokens >= MAX_TOKENS_PER_CONNECTION) {
+            std::string time_str;
+            logger_->log("%:% %() % Every connection holds % instruments, cannot subscribe to %\n",
+                        __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str),
+                        MAX_TOKENS_PER_CONNECTION, token);
+            sent = false;
+            continue;
+        }
+        subscriptions_[token] = {connection, mode};
+        ++connections_[connection]->num_tokens;
+        tokens[connection].push_back(token);
+    }
+
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        if (!tokens[i].empty()) {
+            sent &= connections_[i]->client.subscribe(tokens[i], mode);
+        }
+    }
+    return sent;
+}
+
+bool ZerodhaWebSocketPool::unsubscribe(const std::vector<int32_t>& instrument_tokens) {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+
+    std::vector<std::vector<int32_t>> tokens(connections_.size());
+    for (const auto token : instrument_tokens) {
+        auto it = subscriptions_.find(token);
+        if (it != subscriptions_.end()) {
+            tokens[it->second.connection].push_back(token);
+            --connections_[it->second.connection]->num_tokens;
+            subscriptions_.erase(it);
+        }
+    }
+
+    bool sent = true;
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        if (!tokens[i].empty()) {
+            sent &= connections_[i]->client.unsubscribe(tokens[i]);
+        }
+    }
+    return sent;
+}
+
+bool ZerodhaWebSocketPool::set_mode(const std::vector<int32_t>& instrument_tokens, StreamingMode mode) {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+
+    std::vector<std::vector<int32_t>> tokens(connections_.size());
+    for (const auto token : instrument_tokens) {
+        auto it = subscriptions_.find(token);
+        if (it != subscriptions_.end()) {
+            it->second.mode = mode;
+            tokens[it->second.connection].push_back(token);
+        }
+    }
+
+    bool sent = true;
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        if (!tokens[i].empty()) {
+            sent &= connections_[i]->client.set_mode(tokens[i], mode);
+        }
+    }
+    return sent;
+}
+
+size_t ZerodhaWebSocketPool::rebalance() {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    const auto num_connections = connections_.size();
+    if (num_connections < 2) {
+        return 0;
+    }
+
+    // Ticks since the last call of every token, on the connection it is subscribed on, busiest first
+    std::vector<uint64_t> load(num_connections, 0);
+    std::vector<std::vector<std::pair<uint64_t, int32_t>>> tokens(num_connections);
+    bool restarted = false;
+    for (size_t i = 0; i < num_connections; ++i) {
+        auto& token_load = connections_[i]->client.token_load();
+        restarted |= token_load.takeRestarted();
+        token_load.forEach([&](int32_t token, uint64_t ticks) {
+            auto it = subscriptions_.find(token);
+            if (it != subscriptions_.end() && it->second.connection == i && ticks > 0) {
+                load[i] += ticks;
+                tokens[i].emplace_back(ticks, token);
+            }
+        });
+        token_load.reset();
+        std::sort(tokens[i].begin(), tokens[i].end(), std::greater<>());
+    }
+    
+    // A connection which came up since the last call streamed for part of the interval only, and the others may have
+    // streamed alone until it subscribed, the interval is not compared
+    if (restarted) {
+        return 0;
+    }
+
+    // Move the busiest token which at most halves the gap from the busiest to the quietest connection with room
+    std::vector<std::tuple<int32_t, size_t, size_t>> moves;
+    while (moves.size() < MAX_MOVES_PER_REBALANCE) {
+        size_t busiest = 0, quietest = num_connections;
+        for (size_t i = 0; i < num_connections; ++i) {
+            busiest = (load[i] > load[busiest] ? i : busiest);
+            if (connections_[i]->num_tokens < MAX_TOKENS_PER_CONNECTION && (quietest == num_connections || load[i] < load[quietest])) {
+                quietest = i;
+            }
+        }
+        if (quietest == num_connections || busiest == quietest) {
+            break;
+        }
+        const auto gap = load[busiest] - load[quietest];
+        if (gap < MIN_TICKS_TO_REBALANCE || static_cast<double>(load[busiest]) < IMBALANCE * static_cast<double>(load[quietest])) {
+            break;
+        }
+
+        auto& candidates = tokens[busiest];
+        auto it = std::find_if(candidates.begin(), candidates.end(), [gap](const auto& candidate) { return candidate.first <= gap / 2; });
+        if (it == candidates.end()) {
+            break;
+        }
+        load[busiest] -= it->first;
+        load[quietest] += it->first;
+        tokens[quietest].insert(std::lower_bound(tokens[quietest].begin(), tokens[quietest].end(), *it, std::greater<>()), *it);
+        moves.emplace_back(it->second, busiest, quietest);
+        --connections_[busiest]->num_tokens;
+        ++connections_[quietest]->num_tokens;
+        candidates.erase(it);
+    }
+    if (moves.empty()) {
+        return 0;
+    }
+
+    // Subscribe on the new connection first so no tick is missed, then drop the token from the old one
+    std::map<std::tuple<size_t, size_t, StreamingMode>, std::vector<int32_t>> batches;
+    for (const auto& [token, from, to] : moves) {
+        auto& subscription = subscriptions_[token];
+        subscription.connection = to;
+        batches[{from, to, subscription.mode}].push_back(token);
+    }
+    for (const auto& [key, batch] : batches) {
+        const auto& [from, to, mode] = key;
+        connections_[to]->client.subscribe(batch, mode);
+        connections_[from]->client.unsubscribe(batch);
+    }
+
+    std::string time_str;
+    logger_->log("%:% %() % Moved % tokens between connections, ticks per connection before %/%/%\n",
+                __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str),
+                moves.size(), load[0], load[1], num_connections > 2 ? load[2] : 0);
+    return moves.size();
+}
+
+size_t ZerodhaWebSocketPool::connection_of(int32_t instrument_token) const {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    auto it = subscriptions_.find(instrument_token);
+    return it != subscriptions_.end() ? it->second.connection : connections_.size();
+}
+
+size_t ZerodhaWebSocketPool::num_tokens(size_t connection) const {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    return connections_[connection]->num_tokens;
+}
+
+void ZerodhaWebSocketPool::runRebalancer() {
+    std::unique_lock<std::mutex> lock(rebalancer_mutex_);
+    while (!rebalancer_cv_.wait_for(lock, rebalance_interval_, [this]() { return !rebalancer_running_; })) {
+        lock.unlock();
+        rebalance();
+        lock.lock();
+    }
+}
+
+void ZerodhaWebSocketPool::stopRebalancer() {
+    {
+        std::lock_guard<std::mutex> lock(rebalancer_mutex_);
+        rebalancer_running_ = false;
+    }
+    rebalancer_cv_.notify_all();
+    if (rebalancer_thread_.joinable()) {
+        rebalancer_thread_.join();
+    }
+}
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/journal_recorder.h"
+
+#include "zerodha_tick.h"
+#include "zerodha_websocket_client.h"
+
+namespace Adapter {
+namespace Zerodha {
+
+/**
+ * ZerodhaWebSocketPool - Kite subscriptions sharded over several WebSocket connections
+ *
+ * Kite caps the instruments of a connection and the connections of an API key. Each connection of the pool is a
+ * ZerodhaWebSocketClient with its own thread, decoder and tick queue, so frames of different connections are read
+ * and decoded in parallel. Each queue has a single producer, its connection, and the consumer drains them all in
+ * turn, so merging the shards takes no lock.
+ *
+ * New tokens go to the connection with the fewest. A rebalancer thread moves the busiest tokens off a connection
+ * receiving far more ticks than the quietest one: a token is subscribed on its new connection before it is dropped
+ * from the old one, so for a moment its ticks come from both. The duplicates are dropped by the order book's
+ * staleness check, which skips a FULL snapshot older than the last one applied.
+ */
+class ZerodhaWebSocketPool {
+public:
+    // Kite allows 3 connections per API key and 3000 instruments per connection
+    static constexpr size_t MAX_CONNECTIONS = 3;
+    static constexpr size_t MAX_TOKENS_PER_CONNECTION = 3000;
+
+    /**
+     * Constructor
+     *
+     * @param api_key Zerodha API key
+     * @param access_token Authentication token from ZerodhaAuthenticator
+     * @param num_connections Number of connections, 1 to MAX_CONNECTIONS
+     * @param queue_size Ticks each connection's queue holds
+     * @param logger Logger for diagnostic messages
+     */
+    ZerodhaWebSocketPool(const std::string& api_key,
+                         const std::string& access_token,
+                         size_t num_connections,
+                         size_t queue_size,
+                         Common::Logger* logger);
+
+    /**
+     * Destructor - Stops the rebalancer, each connection closes itself
+     */
+    ~ZerodhaWebSocketPool();
+
+    /**
+     * Point every connection at another Kite compatible endpoint, before connect()
+     */
+    void set_endpoint(const std::string& host, const std::string& port, bool verify_peer);
+
+    /**
+     * Journal the raw frames of a connection
+     *
+     * @param connection Connection index
+     * @param journal Ring of a JournalRecorder, one per connection since each has its own thread
+     */
+    void set_journal(size_t connection, Common::JournalByteRing* journal);
+
+    /**
+     * Call back after the ticks of each frame are queued, on the thread of the connection which received it
+     */
+    void set_on_ticks(std::function<void()> on_ticks);
+
+    /**
+     * Move hot tokens between connections every interval while connected, 0 to never rebalance, before connect()
+     */
+    void set_rebalance_interval(std::chrono::milliseconds interval) { rebalance_interval_ = interval; }
+
+    /**
+     * Connect every connection and start the rebalancer
+     *
+     * @return true if every connection was initiated
+     */
+    bool connect();
+
+    /**
+     * Stop the rebalancer and disconnect every connection
+     */
+    void disconnect();
+
+    /**
+     * Check if every connection is up
+     */
+    bool is_connected() const;
+
+    /**
+     * Subscribe to instruments, new ones on the connections with the fewest instruments
+     *
+     * @param instrument_tokens Instrument tokens, those already subscribed to change to the mode
+     * @param mode Streaming mode
+     * @return true if every subscription was sent, false if some are to be sent once connected or did not fit
+     */
+    bool subscribe(const std::vector<int32_t>& instrument_tokens, StreamingMode mode = StreamingMode::FULL);
+
+    /**
+     * Unsubscribe from instruments on whichever connections they are on
+     */
+    bool unsubscribe(const std::vector<int32_t>& instrument_tokens);
+
+    /**
+     * Change the streaming mode of subscribed instruments
+     */
+    bool set_mode(const std::vector<int32_t>& instrument_tokens, StreamingMode mode);
+
+    /**
+     * Move the busiest tokens off connections receiving far more ticks than the quietest since the last call,
+     * none if a connection came up since then
+     *
+     * @return Number of tokens moved
+     */
+    size_t rebalance();
+
+    /**
+     * Feed a recorded frame through the first connection, no connection needed
+     */
+    void replay_message(const char* data, size_t length, bool is_binary) { connections_[0]->client.replay_message(data, length, is_binary); }
+
+    size_t num_connections() const { return connections_.size(); }
+
+    /**
+     * Queue the ticks of a connection are published to, drained by the consumer
+     */
+    ZerodhaTickQueue& queue(size_t connection) { return connections_[connection]->queue; }
+
+    ZerodhaWebSocketClient& client(size_t connection) { return connections_[connection]->client; }
+
+    /**
+     * Connection a token is subscribed on, num_connections() if none
+     */
+    size_t connection_of(int32_t instrument_token) const;
+
+    /**
+     * Number of instruments subscribed on a connection
+     */
+    size_t num_tokens(size_t connection) const;
+
+    // Deleted default, copy & move constructors and assignment-operators
+    ZerodhaWebSocketPool() = delete;
+    ZerodhaWebSocketPool(const ZerodhaWebSocketPool&) = delete;
+    ZerodhaWebSocketPool(const ZerodhaWebSocketPool&&) = delete;
+    ZerodhaWebSocketPool& operator=(const ZerodhaWebSocketPool&) = delete;
+    ZerodhaWebSocketPool& operator=(const ZerodhaWebSocketPool&&) = delete;
+
+private:
+    struct Connection {
+        Connection(const std::string& api_key, const std::string& access_token, size_t queue_size, Common::Logger* logger)
+            : queue(queue_size), client(api_key, access_token, queue, logger) {
+        }
+
+        ZerodhaTickQueue queue;
+        ZerodhaWebSocketClient client;
+        size_t num_tokens = 0;
+    };
+
+    struct Subscription {
+        size_t connection;
+        StreamingMode mode;
+    };
+
+    // Rebalance every rebalance_interval_ until stopRebalancer()
+    void runRebalancer();
+    void stopRebalancer();
+
+    Common::Logger* logger_;
+
+    std::vector<std::unique_ptr<Connection>> connections_;
+
+    // Which connection each token is on, subscription changes and rebalancing take turns
+    std::unordered_map<int32_t, Subscription> subscriptions_;
+    mutable std::mutex subscription_mutex_;
+
+    // Rebalancer
+    std::chrono::milliseconds rebalance_interval_{30000};
+    std::thread rebalancer_thread_;
+    std::mutex rebalancer_mutex_;
+    std::condition_variable rebalancer_cv_;
+    bool rebalancer_running_ = false;
+};
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -1,11 +1,39 @@
 #include "zerodha_order_gateway_adapter.h"
 #include <chrono>
 #include <thread>
-#include <sstream>
+#include <cctype>
+#include <cstdio>
+
+#include <nlohmann/json.hpp>
 
 namespace Adapter {
 namespace Zerodha {
 
+namespace {
+    // Exchange of a registered name without an "EXCH:" prefix
+    constexpr const char* DEFAULT_EXCHANGE = "NSE";
+
+    // Append name=value to a form body, the value percent-encoded as application/x-www-form-urlencoded wants it
+    auto appendFormField(std::string& form, const char* name, const std::string& value) -> void {
+        static constexpr char HEX[] = "0123456789ABCDEF";
+        if (!form.empty()) {
+            form += '&';
+        }
+        form += name;
+        form += '=';
+        for (const auto c : value) {
+            const auto byte = static_cast<unsigned char>(c);
+            if (std::isalnum(byte) || c == '-' || c == '_' || c == '.' || c == '~') {
+                form += c;
+            } else {
+                form += '%';
+                form += HEX[byte >> 4];
+                form += HEX[byte & 0x0F];
+            }
+        }
+    }
+}
+
 // Constructor for the order gateway adapter
 ZerodhaOrderGatewayAdapter::ZerodhaOrderGatewayAdapter(
     Common::Logger* logger,
@@ -21,6 +49,8 @@ ZerodhaOrderGatewayAdapter::ZerodhaOrderGatewayAdapter(
       outgoing_requests_(client_requests),
       incoming_responses_(client_responses) {
     
+    curl_ = curl_easy_init();
+    
     logger_->log("%:% %() % Initialized ZerodhaOrderGatewayAdapter with client_id:%\n", 
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_), client_id_);
@@ -29,6 +59,11 @@ ZerodhaOrderGatewayAdapter::ZerodhaOrderGatewayAdapter(
 // Destructor for the order gateway adapter
 ZerodhaOrderGatewayAdapter::~ZerodhaOrderGatewayAdapter() {
     stop();
+    
+    if (curl_) {
+        curl_easy_cleanup(curl_);
+        curl_ = nullptr;
+    }
 }
 
 // Start the order gateway
@@ -40,6 +75,15 @@ auto ZerodhaOrderGatewayAdapter::start() -> void {
         return;
     }
     
+    // Paper orders are answered by the engine, which needs to be running before the first request reaches it
+    if (paper_trading_mode_) {
+        paper_trading_logger_ = std::make_unique<Common::Logger>("zerodha_paper_trading_" + std::to_string(client_id_) + ".log");
+        paper_trading_engine_ = std::make_unique<ZerodhaPaperTradingEngine>(paper_trading_logger_.get(),
+                                                                            paper_trading_market_updates_, incoming_responses_);
+        paper_trading_engine_->setLatencySamples(paper_trading_latency_samples_, paper_trading_latency_seed_);
+        paper_trading_engine_->start();
+    }
+    
     run_ = true;
     
     // Start the main processing thread
@@ -66,22 +110,30 @@ auto ZerodhaOrderGatewayAdapter::stop() -> void {
     if (processing_thread_.joinable()) {
         processing_thread_.join();
     }
+    
+    if (paper_trading_engine_) {
+        paper_trading_engine_->stop();
+        paper_trading_engine_.reset();
+        paper_trading_logger_.reset();
+    }
 }
 
 // Register a tradable instrument
 auto ZerodhaOrderGatewayAdapter::registerInstrument(
     const std::string& zerodha_symbol, 
-    Common::TickerId internal_ticker_id) -> void {
+    Common::TickerId internal_ticker_id,
+    const Common::InstrumentScale& scale) -> void {
     
     std::lock_guard<std::mutex> lock(symbols_mutex_);
     
     ticker_to_symbol_map_[internal_ticker_id] = zerodha_symbol;
     symbol_to_ticker_map_[zerodha_symbol] = internal_ticker_id;
+    scales_.at(internal_ticker_id) = scale;
     
-    logger_->log("%:% %() % Registered instrument %s (id: %) for client_id:%\n", 
+    logger_->log("%:% %() % Registered instrument %s (id: %) % for client_id:%\n", 
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_), 
-                zerodha_symbol.c_str(), internal_ticker_id, client_id_);
+                zerodha_symbol.c_str(), internal_ticker_id, scale.toString(), client_id_);
 }
 
 // Map Zerodha symbol to internal ticker ID
@@ -138,6 +190,13 @@ auto ZerodhaOrderGatewayAdapter::runOrderGateway() -> void {
             outgoing_requests_->updateReadIndex();
         }
         
+        // Fills and cancels of live orders are found by polling the order book
+        if (isLiveTrading() && !live_orders_.empty() &&
+            std::chrono::steady_clock::now() - last_status_poll_ >= std::chrono::milliseconds(order_status_poll_interval_ms_)) {
+            pollOrderStatus();
+            last_status_poll_ = std::chrono::steady_clock::now();
+        }
+        
         // Small sleep to avoid busy-waiting
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
@@ -161,6 +220,12 @@ auto ZerodhaOrderGatewayAdapter::processOrderRequest(
         return;
     }
     
+    // Paper orders are answered by the paper trading engine from here on
+    if (paper_trading_mode_) {
+        paper_trading_engine_->onClientRequest(request);
+        return;
+    }
+    
     // Process based on request type
     switch (request.type_) {
         case Exchange::ClientRequestType::NEW:
@@ -171,6 +236,10 @@ auto ZerodhaOrderGatewayAdapter::processOrderRequest(
             sendCancelOrder(request);
             break;
             
+        case Exchange::ClientRequestType::MODIFY:
+            sendModifyOrder(request);
+            break;
+            
         default:
             logger_->log("%:% %() % ERROR: Unknown request type: % for client_id:%\n", 
                         __FILE__, __LINE__, __FUNCTION__, 
@@ -191,6 +260,11 @@ auto ZerodhaOrderGatewayAdapter::sendNewOrder(
                 Common::getCurrentTimeStr(&time_str_), 
                 client_id_, symbol.c_str(), request.price_, request.qty_);
     
+    if (isLiveTrading()) {
+        handleLiveTradeNewOrder(request, symbol);
+        return;
+    }
+    
     // Create a simulated acceptance response
     Exchange::MEClientResponse response;
     response.type_ = Exchange::ClientResponseType::ACCEPTED;
@@ -206,36 +280,6 @@ auto ZerodhaOrderGatewayAdapter::sendNewOrder(
     auto next_write = incoming_responses_->getNextToWriteTo();
     *next_write = response;
     incoming_responses_->updateWriteIndex();
-    
-    // In paper trading, we'll simulate a fill after a delay
-    if (paper_trading_mode_) {
-        // Simulate a fill in a separate thread
-        std::thread([this, request, symbol]() {
-            // Simulate execution latency (50-200ms)
-            std::this_thread::sleep_for(std::chrono::milliseconds(50 + rand() % 150));
-            
-            // Create a simulated fill response
-            Exchange::MEClientResponse fill_response;
-            fill_response.type_ = Exchange::ClientResponseType::FILLED;
-            fill_response.client_id_ = request.client_id_;
-            fill_response.ticker_id_ = request.ticker_id_;
-            fill_response.order_id_ = request.order_id_;
-            fill_response.side_ = request.side_;
-            fill_response.price_ = request.price_;
-            fill_response.exec_qty_ = request.qty_; // Full fill for simplicity
-            fill_response.leaves_qty_ = 0;
-            
-            logger_->log("%:% %() % Simulated fill for client_id:% order_id:% symbol:% price:% qty:%\n", 
-                        __FILE__, __LINE__, __FUNCTION__, 
-                        Common::getCurrentTimeStr(&time_str_), 
-                        client_id_, request.order_id_, symbol.c_str(), request.price_, request.qty_);
-            
-            // Send the fill
-            auto next_write = incoming_responses_->getNextToWriteTo();
-            *next_write = fill_response;
-            incoming_responses_->updateWriteIndex();
-        }).detach();
-    }
 }
 
 // Send a cancel order
@@ -249,6 +293,23 @@ auto ZerodhaOrderGatewayAdapter::sendCancelOrder(
                 Common::getCurrentTimeStr(&time_str_), 
                 client_id_, request.order_id_, symbol.c_str());
     
+    if (isLiveTrading()) {
+        std::string zerodha_order_id;
+        {
+            std::lock_guard<std::mutex> lock(orders_mutex_);
+            auto it = order_id_map_.find(request.order_id_);
+            if (it != order_id_map_.end()) {
+                zerodha_order_id = it->second;
+            }
+        }
+        if (zerodha_order_id.empty()) {
+            sendResponse(request, Exchange::ClientResponseType::CANCEL_REJECTED, request.price_, 0, 0);
+            return;
+        }
+        handleLiveTradeCancelOrder(request, zerodha_order_id);
+        return;
+    }
+    
     // Create a simulated cancel response
     Exchange::MEClientResponse response;
     response.type_ = Exchange::ClientResponseType::CANCELED;
@@ -266,15 +327,357 @@ auto ZerodhaOrderGatewayAdapter::sendCancelOrder(
     incoming_responses_->updateWriteIndex();
 }
 
+// Send a modify (cancel/replace) keeping the order id
+auto ZerodhaOrderGatewayAdapter::sendModifyOrder(
+    const Exchange::MEClientRequest& request) -> void {
+    
+    std::string symbol = mapInternalToZerodhaSymbol(request.ticker_id_);
+    
+    logger_->log("%:% %() % Sending modify for client_id:% order_id:% symbol:% price:% qty:%\n", 
+                __FILE__, __LINE__, __FUNCTION__, 
+                Common::getCurrentTimeStr(&time_str_), 
+                client_id_, request.order_id_, symbol.c_str(), request.price_, request.qty_);
+    
+    if (isLiveTrading()) {
+        std::string zerodha_order_id;
+        {
+            std::lock_guard<std::mutex> lock(orders_mutex_);
+            auto it = order_id_map_.find(request.order_id_);
+            if (it != order_id_map_.end()) {
+                zerodha_order_id = it->second;
+            }
+        }
+        if (zerodha_order_id.empty()) {
+            sendResponse(request, Exchange::ClientResponseType::MODIFY_REJECTED, request.price_, 0, 0);
+            return;
+        }
+        
+        // The request's quantity is what is left open, Kite takes the order's total including what has filled. The
+        // status is refreshed first, reporting any fills since the last poll, and an order whose status could not be
+        // read or which is no longer open is not modified.
+        const auto refreshed = pollOrderStatus(zerodha_order_id);
+        auto live_order = live_orders_.find(request.order_id_);
+        bool status_known = false;
+        Common::Qty filled_qty = 0;
+        {
+            std::lock_guard<std::mutex> lock(last_order_status_mutex_);
+            auto it = last_order_status_.find(request.order_id_);
+            if (it != last_order_status_.end()) {
+                status_known = true;
+                filled_qty = it->second.filled_qty;
+            }
+        }
+        if (!refreshed || !status_known || live_order == live_orders_.end()) {
+            sendResponse(request, Exchange::ClientResponseType::MODIFY_REJECTED, request.price_, 0, 0);
+            return;
+        }
+        std::string params;
+        appendFormField(params, "order_type", "LIMIT");
+        appendFormField(params, "quantity", std::to_string(filled_qty + request.qty_));
+        appendFormField(params, "price", formatPrice(request.ticker_id_, request.price_));
+        
+        std::string response;
+        if (sendOrderRequest("PUT", "/orders/regular/" + zerodha_order_id, params, response)) {
+            live_order->second.price_ = request.price_;
+            live_order->second.qty_ = filled_qty + request.qty_;
+            sendResponse(request, Exchange::ClientResponseType::ACCEPTED, request.price_, 0, request.qty_);
+        } else {
+            sendResponse(request, Exchange::ClientResponseType::MODIFY_REJECTED, request.price_, 0, 0);
+        }
+        return;
+    }
+    
+    // Create a simulated acceptance of the new price and quantity
+    Exchange::MEClientResponse response;
+    response.type_ = Exchange::ClientResponseType::ACCEPTED;
+    response.client_id_ = request.client_id_;
+    response.ticker_id_ = request.ticker_id_;
+    response.order_id_ = request.order_id_;
+    response.side_ = request.side_;
+    response.price_ = request.price_;
+    response.exec_qty_ = 0;
+    response.leaves_qty_ = request.qty_;
+    
+    // Send the acceptance
+    auto next_write = incoming_responses_->getNextToWriteTo();
+    *next_write = response;
+    incoming_responses_->updateWriteIndex();
+}
+
+// Place a live order - the response to the POST carries the Kite order id, fills come from the status poll
+auto ZerodhaOrderGatewayAdapter::handleLiveTradeNewOrder(
+    const Exchange::MEClientRequest& request, const std::string& zerodha_symbol) -> void {
+    
+    // Registered names are "EXCH:SYMBOL" like the market data adapter's, e.g. "NFO:NIFTY24JAN21500CE", or a bare NSE symbol
+    const auto colon = zerodha_symbol.find(':');
+    const auto exchange = (colon == std::string::npos) ? std::string(DEFAULT_EXCHANGE) : zerodha_symbol.substr(0, colon);
+    const auto trading_symbol = (colon == std::string::npos) ? zerodha_symbol : zerodha_symbol.substr(colon + 1);
+    
+    std::string params;
+    appendFormField(params, "tradingsymbol", trading_symbol);
+    appendFormField(params, "exchange", exchange);
+    appendFormField(params, "transaction_type", request.side_ == Common::Side::BUY ? "BUY" : "SELL");
+    appendFormField(params, "order_type", "LIMIT");
+    appendFormField(params, "quantity", std::to_string(request.qty_));
+    appendFormField(params, "price", formatPrice(request.ticker_id_, request.price_));
+    appendFormField(params, "product", product_);
+    appendFormField(params, "validity", "DAY");
+    appendFormField(params, "tag", std::to_string(request.order_id_));
+    
+    std::string response;
+    std::string zerodha_order_id;
+    if (sendOrderRequest("POST", "/orders/regular", params, response)) {
+        auto json = nlohmann::json::parse(response, nullptr, false);
+        if (!json.is_discarded() && json.contains("data") && json["data"].is_object() && json["data"].contains("order_id")) {
+            zerodha_order_id = json["data"]["order_id"].get<std::string>();
+        }
+    }
+    
+    if (zerodha_order_id.empty()) {
+        logger_->log("%:% %() % ERROR: Order placement failed for order_id:% response:%\n", 
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_), request.order_id_, response);
+        sendResponse(request, Exchange::ClientResponseType::REJECTED, request.price_, 0, 0);
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(orders_mutex_);
+        order_id_map_[request.order_id_] = zerodha_order_id;
+    }
+    live_orders_[request.order_id_] = request;
+    updateLastKnownOrderStatus(request.order_id_, Exchange::ClientResponseType::ACCEPTED, 0);
+    sendResponse(request, Exchange::ClientResponseType::ACCEPTED, request.price_, 0, request.qty_);
+}
+
+// Cancel a live order - CANCELED once Kite takes the cancel, fills before it still come from the status poll
+auto ZerodhaOrderGatewayAdapter::handleLiveTradeCancelOrder(
+    const Exchange::MEClientRequest& request, const std::string& zerodha_order_id) -> void {
+    
+    std::string response;
+    if (!sendOrderRequest("DELETE", "/orders/regular/" + zerodha_order_id, "", response)) {
+        logger_->log("%:% %() % ERROR: Cancel failed for order_id:% response:%\n", 
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_), request.order_id_, response);
+        sendResponse(request, Exchange::ClientResponseType::CANCEL_REJECTED, request.price_, 0, 0);
+        return;
+    }
+    
+    // Executions the poll has not seen yet are reported before the cancel
+    pollOrderStatus(zerodha_order_id);
+    if (live_orders_.count(request.order_id_)) {
+        const auto order = live_orders_[request.order_id_];
+        updateLastKnownOrderStatus(request.order_id_, Exchange::ClientResponseType::CANCELED, 0);
+        sendResponse(order, Exchange::ClientResponseType::CANCELED, order.price_, 0, 0);
+        live_orders_.erase(request.order_id_);
+        std::lock_guard<std::mutex> lock(orders_mutex_);
+        order_id_map_.erase(request.order_id_);
+    }
+}
+
+// Poll the day's orders, or the history of one order, and report the executions and terminal states not reported yet
+auto ZerodhaOrderGatewayAdapter::pollOrderStatus(const std::string& zerodha_order_id) -> bool {
+    std::string response;
+    if (!sendOrderRequest("GET", zerodha_order_id.empty() ? "/orders" : "/orders/" + zerodha_order_id, "", response)) {
+        return false;
+    }
+    auto json = nlohmann::json::parse(response, nullptr, false);
+    if (json.is_discarded() || !json.contains("data") || !json["data"].is_array()) {
+        return false;
+    }
+    if (json["data"].empty()) {
+        return zerodha_order_id.empty();
+    }
+    
+    // An order's history lists every state it went through, the last one is the current one
+    if (!zerodha_order_id.empty()) {
+        json["data"] = nlohmann::json::array({json["data"].back()});
+    }
+    
+    std::map<std::string, Common::OrderId> zerodha_to_internal;
+    {
+        std::lock_guard<std::mutex> lock(orders_mutex_);
+        for (const auto& [order_id, zerodha_order_id] : order_id_map_) {
+            zerodha_to_internal[zerodha_order_id] = order_id;
+        }
+    }
+    
+    for (const auto& order : json["data"]) {
+        auto it = zerodha_to_internal.find(order.value("order_id", ""));
+        if (it == zerodha_to_internal.end() || !live_orders_.count(it->second)) {
+            continue;
+        }
+        const auto order_id = it->second;
+        const auto& request = live_orders_[order_id];
+        const auto status = convertZerodhaStatusToInternal(order.value("status", ""));
+        const auto filled_qty = order.value("filled_quantity", Common::Qty{0});
+        const auto average_price = order.value("average_price", 0.0);
+        
+        Common::Qty last_filled_qty = 0;
+        double last_average_price = 0.0;
+        {
+            std::lock_guard<std::mutex> lock(last_order_status_mutex_);
+            auto last = last_order_status_.find(order_id);
+            if (last != last_order_status_.end()) {
+                last_filled_qty = last->second.filled_qty;
+                last_average_price = last->second.average_price;
+            }
+        }
+        if (!shouldPropagateOrderUpdate(order_id, status, filled_qty)) {
+            continue;
+        }
+        
+        // Kite's order book only has the average price of all executions, the new ones are what moved it
+        if (filled_qty > last_filled_qty) {
+            const auto exec_qty = filled_qty - last_filled_qty;
+            const auto exec_value = average_price * filled_qty - last_average_price * last_filled_qty;
+            const auto price = scales_.at(request.ticker_id_).toPrice(exec_value / exec_qty);
+            const auto leaves_qty = (status == Exchange::ClientResponseType::FILLED ? 0 : request.qty_ - filled_qty);
+            sendResponse(request, Exchange::ClientResponseType::FILLED, price, exec_qty, leaves_qty);
+        }
+        if (status == Exchange::ClientResponseType::CANCELED || status == Exchange::ClientResponseType::REJECTED) {
+            sendResponse(request, status, request.price_, 0, 0);
+        }
+        updateLastKnownOrderStatus(order_id, status, filled_qty, average_price);
+        
+        if (status == Exchange::ClientResponseType::FILLED || status == Exchange::ClientResponseType::CANCELED ||
+            status == Exchange::ClientResponseType::REJECTED) {
+            live_orders_.erase(order_id);
+            std::lock_guard<std::mutex> lock(orders_mutex_);
+            order_id_map_.erase(order_id);
+        }
+    }
+    return true;
+}
+
+auto ZerodhaOrderGatewayAdapter::sendOrderRequest(
+    const std::string& method, const std::string& endpoint, const std::string& params,
+    std::string& response) -> bool {
+    
+    if (!curl_) {
+        return false;
+    }
+    
+    // The handle keeps its connection between requests, only the options are reset
+    curl_easy_reset(curl_);
+    std::string url = api_base_url_ + endpoint;
+    if (method == "GET" && !params.empty()) {
+        url += "?" + params;
+    }
+    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl_, CURLOPT_TIMEOUT, 10L);
+    if (!verify_peer_) {
+        curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYHOST, 0L);
+    }
+    
+    struct curl_slist* headers = nullptr;
+    headers = curl_slist_append(headers, "X-Kite-Version: 3");
+    headers = curl_slist_append(headers, ("Authorization: token " + api_key_ + ":" + access_token_).c_str());
+    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
+    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
+    
+    if (method != "GET") {
+        curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, method.c_str());
+        curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, params.c_str());
+    }
+    
+    response.clear();
+    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, +[](char* ptr, size_t size, size_t nmemb, std::string* data) {
+        data->append(ptr, size * nmemb);
+        return size * nmemb;
+    });
+    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
+    
+    const CURLcode res = curl_easy_perform(curl_);
+    long http_code = 0;
+    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_slist_free_all(headers);
+    
+    if (res != CURLE_OK) {
+        logger_->log("%:% %() % ERROR: % % failed: %\n", 
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_), method, endpoint, curl_easy_strerror(res));
+        return false;
+    }
+    if (http_code < 200 || http_code >= 300) {
+        logger_->log("%:% %() % ERROR: % % returned HTTP %: %\n", 
+                    __FILE__, __LINE__, __FUNCTION__, 
+                    Common::getCurrentTimeStr(&time_str_), method, endpoint, http_code, response);
+        return false;
+    }
+    return true;
+}
+
+auto ZerodhaOrderGatewayAdapter::sendResponse(
+    const Exchange::MEClientRequest& request, Exchange::ClientResponseType type,
+    Common::Price price, Common::Qty exec_qty, Common::Qty leaves_qty) -> void {
+    
+    Exchange::MEClientResponse response;
+    response.type_ = type;
+    response.client_id_ = request.client_id_;
+    response.ticker_id_ = request.ticker_id_;
+    response.order_id_ = request.order_id_;
+    response.side_ = request.side_;
+    response.price_ = price;
+    response.exec_qty_ = exec_qty;
+    response.leaves_qty_ = leaves_qty;
+    
+    auto next_write = incoming_responses_->getNextToWriteTo();
+    *next_write = response;
+    incoming_responses_->updateWriteIndex();
+}
+
+// Kite order statuses: OPEN (partially filled ones included), COMPLETE, CANCELLED, REJECTED, and the pending
+// states an order passes through on its way to the exchange
+auto ZerodhaOrderGatewayAdapter::convertZerodhaStatusToInternal(
+    const std::string& zerodha_status) -> Exchange::ClientResponseType {
+    if (zerodha_status == "COMPLETE") {
+        return Exchange::ClientResponseType::FILLED;
+    }
+    if (zerodha_status == "CANCELLED") {
+        return Exchange::ClientResponseType::CANCELED;
+    }
+    if (zerodha_status == "REJECTED") {
+        return Exchange::ClientResponseType::REJECTED;
+    }
+    return Exchange::ClientResponseType::ACCEPTED;
+}
+
+auto ZerodhaOrderGatewayAdapter::shouldPropagateOrderUpdate(
+    Common::OrderId order_id, Exchange::ClientResponseType new_status, Common::Qty new_filled_qty) -> bool {
+    std::lock_guard<std::mutex> lock(last_order_status_mutex_);
+    auto it = last_order_status_.find(order_id);
+    return it == last_order_status_.end() || it->second.status != new_status || it->second.filled_qty != new_filled_qty;
+}
+
+auto ZerodhaOrderGatewayAdapter::updateLastKnownOrderStatus(
+    Common::OrderId order_id, Exchange::ClientResponseType status, Common::Qty filled_qty, double average_price) -> void {
+    std::lock_guard<std::mutex> lock(last_order_status_mutex_);
+    if (status == Exchange::ClientResponseType::FILLED || status == Exchange::ClientResponseType::CANCELED ||
+        status == Exchange::ClientResponseType::REJECTED) {
+        last_order_status_.erase(order_id);
+    } else {
+        last_order_status_[order_id] = {status, filled_qty, average_price};
+    }
+}
+
+auto ZerodhaOrderGatewayAdapter::formatPrice(Common::TickerId ticker_id, Common::Price price) const -> std::string {
+    const auto& scale = scales_.at(ticker_id);
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", static_cast<int>(scale.price_decimals_), scale.priceToDouble(price));
+    return buffer;
+}
+
 // Add logging when using the setters
 void ZerodhaOrderGatewayAdapter::logSettings() {
-    logger_->log("%:% %() % Current settings: paper_mode=%, fill_prob=%, latency=%-% ms, slippage=%\n", 
+    logger_->log("%:% %() % Current settings: paper_mode=%, latency_samples=%, status_poll=% ms, product=%\n", 
                 __FILE__, __LINE__, __FUNCTION__, 
                 Common::getCurrentTimeStr(&time_str_), 
                 paper_trading_mode_ ? "enabled" : "disabled",
-                paper_trading_fill_probability_,
-                paper_trading_min_latency_ms_, paper_trading_max_latency_ms_,
-                paper_trading_slippage_factor_);
+                paper_trading_latency_samples_.size(),
+                order_status_poll_interval_ms_,
+                product_);
 }
 
 } // namespace Zerodha
@@ -3,20 +3,26 @@
 #include <string>
 #include <functional>
 #include <map>
-#include <queue>
+#include <memory>
 #include <mutex>
 #include <thread>
-#include <random>
+#include <vector>
+#include <chrono>
+
+#include <curl/curl.h>
 
 #include "common/thread_utils.h"
 #include "common/lf_queue.h"
 #include "common/macros.h"
 #include "common/logging.h"
 #include "common/types.h"
+#include "common/fixed_point.h"
 
 #include "exchange/order_server/client_request.h"
 #include "exchange/order_server/client_response.h"
 
+#include "trading/adapters/zerodha/order_gw/zerodha_paper_trading_engine.h"
+
 namespace Adapter {
 namespace Zerodha {
 
@@ -25,8 +31,10 @@ namespace Zerodha {
  * and translates responses back to the internal format.
  *
  * Supports both paper trading and live trading modes:
- * - Paper trading: Simulates order execution with realistic latency and fill models
- * - Live trading: Connects to Zerodha Kite API for real order placement
+ * - Paper trading: Orders go to a ZerodhaPaperTradingEngine started with the gateway (see setPaperTradingMode()),
+ *   which fills them by their queue position against the live market
+ * - Live trading: Connects to Zerodha Kite API for real order placement, once an access token is set
+ *   (see setAccessToken()). setApiEndpoint() points it at another server, e.g. the local order entry simulator.
  */
 class ZerodhaOrderGatewayAdapter {
 public:
@@ -47,19 +55,39 @@ public:
     auto mapZerodhaSymbolToInternal(const std::string& zerodha_symbol) -> Common::TickerId;
     auto mapInternalToZerodhaSymbol(Common::TickerId ticker_id) -> std::string;
 
-    // Register trading instruments
-    auto registerInstrument(const std::string& zerodha_symbol, Common::TickerId internal_ticker_id) -> void;
+    // Register trading instruments, with the fixed-point scales of their prices, paise by default. The name is
+    // "EXCH:SYMBOL" (e.g. "NFO:NIFTY24JAN21500CE"), live orders go to that exchange; a bare symbol trades on NSE
+    auto registerInstrument(const std::string& zerodha_symbol, Common::TickerId internal_ticker_id,
+                            const Common::InstrumentScale& scale = {}) -> void;
     
     // Configuration
-    void setPaperTradingMode(bool enable) { paper_trading_mode_ = enable; logSettings(); }
-    void setPaperTradingFillProbability(double probability) { paper_trading_fill_probability_ = probability; logSettings(); }
-    void setPaperTradingLatencyRange(double min_ms, double max_ms) {
-        paper_trading_min_latency_ms_ = min_ms;
-        paper_trading_max_latency_ms_ = max_ms;
+    // Paper trading fills orders against the market updates the market data adapter publishes, which the paper
+    // trading engine taps. Must be called before start(), the engine is created and started with the gateway
+    void setPaperTradingMode(bool enable, const ::Exchange::MEMarketUpdateLFQueue* market_updates = nullptr) {
+        ASSERT(!enable || market_updates, "Paper trading needs the market updates to fill orders against");
+        paper_trading_mode_ = enable;
+        paper_trading_market_updates_ = market_updates;
+        logSettings();
+    }
+    // Round trips the paper trading engine delays requests and responses by, e.g. NEW -> ACCEPTED times measured live
+    void setPaperTradingLatencySamples(const std::vector<Common::Nanos>& round_trip_nanos, uint32_t seed = 1) {
+        paper_trading_latency_samples_ = round_trip_nanos;
+        paper_trading_latency_seed_ = seed;
         logSettings();
     }
-    void setPaperTradingSlippageFactor(double factor) { paper_trading_slippage_factor_ = factor; logSettings(); }
     void setOrderStatusPollInterval(int interval_ms) { order_status_poll_interval_ms_ = interval_ms; logSettings(); }
+    // Kite product of live orders - MIS (intraday, the default), NRML (F&O carried overnight) or CNC (equity delivery)
+    void setProduct(const std::string& product) { product_ = product; logSettings(); }
+
+    // The paper trading engine while the gateway runs in paper trading mode, nullptr otherwise
+    auto paperTradingEngine() const -> ZerodhaPaperTradingEngine* { return paper_trading_engine_.get(); }
+
+    // Live trading - orders go to the Kite REST API once an access token is set, outside paper trading mode
+    void setAccessToken(const std::string& access_token) { access_token_ = access_token; }
+    void setApiEndpoint(const std::string& base_url, bool verify_peer = true) {
+        api_base_url_ = base_url;
+        verify_peer_ = verify_peer;
+    }
     
     // Helper for logging settings
     void logSettings();
@@ -94,13 +122,21 @@ private:
     std::map<Common::TickerId, std::string> ticker_to_symbol_map_;
     std::map<std::string, Common::TickerId> symbol_to_ticker_map_;
     std::mutex symbols_mutex_;
+
+    // Fixed-point scales per ticker, prices go to and come from Kite in rupees through them
+    Common::InstrumentScaleHashMap scales_{};
     
     // Map of internal order IDs to Zerodha order IDs
     std::map<Common::OrderId, std::string> order_id_map_;
     std::mutex orders_mutex_;
     
-    // Last known status for each order (for detecting changes)
-    std::map<Common::OrderId, std::pair<::Exchange::ClientResponseType, Common::Qty>> last_order_status_;
+    // Last known status, filled quantity and Kite's average price of each order (for detecting changes)
+    struct OrderStatus {
+        ::Exchange::ClientResponseType status;
+        Common::Qty filled_qty;
+        double average_price;
+    };
+    std::map<Common::OrderId, OrderStatus> last_order_status_;
     std::mutex last_order_status_mutex_;
     
     // Threads
@@ -109,29 +145,27 @@ private:
     
     // Paper trading settings
     bool paper_trading_mode_ = false;
-    double paper_trading_fill_probability_ = 0.9;
-    double paper_trading_min_latency_ms_ = 10.0;
-    double paper_trading_max_latency_ms_ = 100.0;
-    double paper_trading_slippage_factor_ = 0.0005; // 0.05%
-    
-    // Paper trading data structures
-    struct PaperTradingOrder {
-        ::Exchange::MEClientRequest internal_order;
-        std::string zerodha_symbol;
-        std::string zerodha_order_id;
-        uint64_t execution_time;       // When the order will execute
-        double fill_probability;       // Probability of order being filled
-        double execution_price;        // Price including slippage
-    };
+    const ::Exchange::MEMarketUpdateLFQueue* paper_trading_market_updates_ = nullptr;
+    std::vector<Common::Nanos> paper_trading_latency_samples_;
+    uint32_t paper_trading_latency_seed_ = 1;
     
-    std::queue<PaperTradingOrder> pending_paper_orders_;
-    std::mutex paper_orders_mutex_;
-    std::mt19937 paper_trading_rng_;
-    uint64_t next_paper_order_id_ = 1;
+    // Paper trading engine and its own logger, as it logs from its own thread. Exist while running in paper trading mode
+    std::unique_ptr<Common::Logger> paper_trading_logger_;
+    std::unique_ptr<ZerodhaPaperTradingEngine> paper_trading_engine_;
     
     // Live trading settings
     int order_status_poll_interval_ms_ = 2000;
-    uint64_t next_zerodha_order_id_ = 100000; // For simulated responses
+    std::string product_ = "MIS";
+    std::string access_token_;
+    std::string api_base_url_ = "https://api.kite.trade";
+    bool verify_peer_ = true;
+
+    // One handle for every REST call, so the connection to the API is reused. Only used by the processing thread
+    CURL* curl_ = nullptr;
+    std::chrono::steady_clock::time_point last_status_poll_;
+
+    // Requests of the live orders by internal order id, to fill in the responses the status poll finds
+    std::map<Common::OrderId, ::Exchange::MEClientRequest> live_orders_;
     
     // The main processing thread
     auto runOrderGateway() -> void;
@@ -142,32 +176,28 @@ private:
     // Convert internal order request to Zerodha format and send
     auto sendNewOrder(const ::Exchange::MEClientRequest& request) -> void;
     auto sendCancelOrder(const ::Exchange::MEClientRequest& request) -> void;
-    
-    // Handle paper trading orders
-    auto handlePaperTradeNewOrder(const ::Exchange::MEClientRequest& request, const std::string& zerodha_symbol) -> void;
-    auto handlePaperTradeCancelOrder(const ::Exchange::MEClientRequest& request, const std::string& zerodha_order_id) -> void;
-    auto processPaperOrders() -> void;
+    auto sendModifyOrder(const ::Exchange::MEClientRequest& request) -> void;
     
     // Handle live trading orders
     auto handleLiveTradeNewOrder(const ::Exchange::MEClientRequest& request, const std::string& zerodha_symbol) -> void;
     auto handleLiveTradeCancelOrder(const ::Exchange::MEClientRequest& request, const std::string& zerodha_order_id) -> void;
-    auto pollOrderStatus() -> void;
-    
-    // Helper functions for paper trading
-    auto simulateOrderLatency() -> uint64_t;
-    auto shouldFillPaperOrder(double probability) -> bool;
-    auto simulateSlippage() -> double;
-    auto simulateNetworkLatency() -> int;
-    auto simulateRandomFailure(double probability) -> bool;
-    
-    // HTTP API helpers
-    auto sendOrderRequest(const std::string& endpoint, const std::string& params, 
-                         std::string& response, bool is_delete = false) -> bool;
+    // Report executions and terminal states the last poll did not see, false if Kite's order book could not be read
+    auto pollOrderStatus(const std::string& zerodha_order_id = "") -> bool;
+    
+    // HTTP API helpers - method is POST, PUT, DELETE or GET, true on a 2xx response
+    auto sendOrderRequest(const std::string& method, const std::string& endpoint, const std::string& params,
+                         std::string& response) -> bool;
+    auto isLiveTrading() const -> bool { return !paper_trading_mode_ && !access_token_.empty(); }
+    // Kite's decimal price of an internal price, e.g. "1500.05"
+    auto formatPrice(Common::TickerId ticker_id, Common::Price price) const -> std::string;
+    auto sendResponse(const ::Exchange::MEClientRequest& request, ::Exchange::ClientResponseType type,
+                      Common::Price price, Common::Qty exec_qty, Common::Qty leaves_qty) -> void;
     
     // Status conversion
     auto convertZerodhaStatusToInternal(const std::string& zerodha_status) -> ::Exchange::ClientResponseType;
     auto shouldPropagateOrderUpdate(Common::OrderId order_id, ::Exchange::ClientResponseType new_status, Common::Qty new_filled_qty) -> bool;
-    auto updateLastKnownOrderStatus(Common::OrderId order_id, ::Exchange::ClientResponseType status, Common::Qty filled_qty) -> void;
+    auto updateLastKnownOrderStatus(Common::OrderId order_id, ::Exchange::ClientResponseType status, Common::Qty filled_qty,
+                                    double average_price = 0.0) -> void;
     
     // Convert responses
     auto convertResponseToInternal(const std::string& zerodha_resp, 
@@ -0,0 +1,129 @@
+#include "zerodha_paper_trading_engine.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Adapter {
+namespace Zerodha {
+
+ZerodhaPaperTradingEngine::ZerodhaPaperTradingEngine(
+    Common::Logger* logger,
+    const ::Exchange::MEMarketUpdateLFQueue* market_updates,
+    ::Exchange::ClientResponseLFQueue* client_responses)
+    : logger_(logger),
+      market_updates_(market_updates),
+      requests_(Common::ME_MAX_CLIENT_UPDATES),
+      client_responses_(client_responses),
+      fill_simulator_(logger) {
+
+    logger_->log("%:% %() % Initialized ZerodhaPaperTradingEngine\n",
+                __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_));
+}
+
+ZerodhaPaperTradingEngine::~ZerodhaPaperTradingEngine() {
+    stop();
+}
+
+auto ZerodhaPaperTradingEngine::start() -> void {
+    if (run_) {
+        return;
+    }
+
+    logger_->log("%:% %() % Starting paper trading engine with % latency samples\n",
+                __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), latency_samples_.size());
+
+    run_ = true;
+    engine_thread_ = std::thread(&ZerodhaPaperTradingEngine::run, this);
+}
+
+auto ZerodhaPaperTradingEngine::stop() -> void {
+    if (!run_) {
+        return;
+    }
+
+    run_ = false;
+    if (engine_thread_.joinable()) {
+        engine_thread_.join();
+    }
+
+    logger_->log("%:% %() % Stopped paper trading engine, requests:% fills:% market updates:%\n",
+                __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), numRequests(), numFills(), numMarketUpdates());
+}
+
+auto ZerodhaPaperTradingEngine::setLatencySamples(const std::vector<Common::Nanos>& round_trip_nanos, uint32_t seed) -> void {
+    latency_samples_.clear();
+    std::copy_if(round_trip_nanos.begin(), round_trip_nanos.end(), std::back_inserter(latency_samples_),
+                 [](Common::Nanos nanos) { return nanos >= 0; });
+    latency_rng_.seed(seed);
+}
+
+auto ZerodhaPaperTradingEngine::run() -> void {
+    // Spins like the trade engine, the delays it applies are well below what a sleep could resolve
+    while (run_) {
+        if (!poll(Common::getCurrentNanos())) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+auto ZerodhaPaperTradingEngine::poll(Common::Nanos now) -> bool {
+    bool busy = false;
+
+    // Requests leave the gateway now and reach the venue half a round trip later
+    for (auto request = requests_.getNextToRead(); request; request = requests_.getNextToRead()) {
+        pending_requests_.push_back({oneWayDue(now, &last_request_due_), *request});
+        requests_.updateReadIndex();
+        busy = true;
+    }
+
+    // Requests which got there go into the book ahead of the market data received after them
+    while (!pending_requests_.empty() && pending_requests_.front().due <= now) {
+        fill_simulator_.onClientRequest(pending_requests_.front().message);
+        pending_requests_.pop_front();
+        num_requests_.fetch_add(1, std::memory_order_relaxed);
+        busy = true;
+    }
+
+    // The market as the trade engine sees it. A print the feed could not assign an aggressor to fills nothing
+    ::Exchange::MEMarketUpdate market_update;
+    while (market_updates_.next(&market_update)) {
+        if (market_update.type_ != ::Exchange::MarketUpdateType::TRADE || market_update.side_ != Common::Side::INVALID) {
+            fill_simulator_.onMarketUpdate(market_update);
+        }
+        num_market_updates_.fetch_add(1, std::memory_order_relaxed);
+        busy = true;
+    }
+
+    // Responses from the venue are on their way back for another half round trip
+    fill_simulator_.takeResponses(&responses_);
+    for (const auto& response : responses_) {
+        if (response.type_ == ::Exchange::ClientResponseType::FILLED) {
+            num_fills_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pending_responses_.push_back({oneWayDue(now, &last_response_due_), response});
+    }
+
+    while (!pending_responses_.empty() && pending_responses_.front().due <= now) {
+        *client_responses_->getNextToWriteTo() = pending_responses_.front().message;
+        client_responses_->updateWriteIndex();
+        pending_responses_.pop_front();
+        busy = true;
+    }
+
+    return busy;
+}
+
+auto ZerodhaPaperTradingEngine::oneWayDue(Common::Nanos now, Common::Nanos* last_due) -> Common::Nanos {
+    Common::Nanos latency = 0;
+    if (!latency_samples_.empty()) {
+        latency = latency_samples_[std::uniform_int_distribution<size_t>(0, latency_samples_.size() - 1)(latency_rng_)] / 2;
+    }
+    *last_due = std::max(*last_due, now + latency);
+    return *last_due;
+}
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/journal_recorder.h"
+#include "common/lf_queue.h"
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "common/types.h"
+
+#include "exchange/market_data/market_update.h"
+#include "exchange/order_server/client_request.h"
+#include "exchange/order_server/client_response.h"
+
+#include "trading/backtest/fill_simulator.h"
+
+namespace Adapter {
+namespace Zerodha {
+
+/**
+ * ZerodhaPaperTradingEngine fills paper orders against the live Zerodha market instead of a coin flip.
+ *
+ * Runs on its own thread next to the live pipeline:
+ * - Market data: taps the queue the ZerodhaMarketDataAdapter publishes to, without consuming it or adding any
+ *   work or locks to the market data thread
+ * - Orders: requests come from the order gateway thread through a lock free queue (see onClientRequest())
+ * - Fills: a Trading::FillSimulator keeps each paper order's place in the queue at its price level. It only fills
+ *   once the traded volume at that price has worked through the quantity ahead of it, or the market trades through
+ * - Latency: every request and every response is delayed by half a round trip drawn from measured samples
+ *   (see setLatencySamples()), in the order they were sent
+ *
+ * The engine is the only writer of the responses queue it is given, so the gateway must not publish to it in
+ * paper trading mode.
+ */
+class ZerodhaPaperTradingEngine {
+public:
+    ZerodhaPaperTradingEngine(Common::Logger* logger,
+                              const ::Exchange::MEMarketUpdateLFQueue* market_updates,
+                              ::Exchange::ClientResponseLFQueue* client_responses);
+
+    ~ZerodhaPaperTradingEngine();
+
+    // Start and stop the engine thread
+    auto start() -> void;
+    auto stop() -> void;
+
+    /**
+     * Round trip latencies to draw from, e.g. NEW -> ACCEPTED times measured against Kite
+     *
+     * Must be called before start(). Without samples requests reach the simulated book immediately.
+     *
+     * @param round_trip_nanos Measured round trips in nanoseconds
+     * @param seed Seed of the draws, for repeatable runs
+     */
+    auto setLatencySamples(const std::vector<Common::Nanos>& round_trip_nanos, uint32_t seed = 1) -> void;
+
+    /**
+     * Hand a request over to the simulated venue - called from the order gateway thread only
+     *
+     * @param request Strategy request as received by the gateway
+     */
+    auto onClientRequest(const ::Exchange::MEClientRequest& request) -> void {
+        *requests_.getNextToWriteTo() = request;
+        requests_.updateWriteIndex();
+    }
+
+    // Statistics, readable from any thread
+    auto numRequests() const noexcept { return num_requests_.load(std::memory_order_relaxed); }
+    auto numFills() const noexcept { return num_fills_.load(std::memory_order_relaxed); }
+    auto numMarketUpdates() const noexcept { return num_market_updates_.load(std::memory_order_relaxed); }
+
+    // Deleted default, copy & move constructors and assignment-operators
+    ZerodhaPaperTradingEngine() = delete;
+    ZerodhaPaperTradingEngine(const ZerodhaPaperTradingEngine&) = delete;
+    ZerodhaPaperTradingEngine(const ZerodhaPaperTradingEngine&&) = delete;
+    ZerodhaPaperTradingEngine& operator=(const ZerodhaPaperTradingEngine&) = delete;
+    ZerodhaPaperTradingEngine& operator=(const ZerodhaPaperTradingEngine&&) = delete;
+
+private:
+    // Request or response on its way, and when it gets to the other side
+    template<typename T>
+    struct InFlight {
+        Common::Nanos due;
+        T message;
+    };
+
+    // The engine thread
+    auto run() -> void;
+
+    // One pass over the requests, market updates and responses, true if there was anything to do
+    auto poll(Common::Nanos now) -> bool;
+
+    // Half of a sampled round trip, no later than the previous message in the same direction so order is kept
+    auto oneWayDue(Common::Nanos now, Common::Nanos* last_due) -> Common::Nanos;
+
+    Common::Logger* logger_ = nullptr;
+    std::string time_str_;
+
+    // Run flag for the thread
+    volatile bool run_ = false;
+    std::thread engine_thread_;
+
+    // Market data as published to the trade engine, and requests from the gateway
+    Common::LFQueueTap<::Exchange::MEMarketUpdate> market_updates_;
+    ::Exchange::ClientRequestLFQueue requests_;
+    ::Exchange::ClientResponseLFQueue* client_responses_ = nullptr;
+
+    // Simulated venue and the messages in flight to and from it
+    Trading::FillSimulator fill_simulator_;
+    std::deque<InFlight<::Exchange::MEClientRequest>> pending_requests_;
+    std::deque<InFlight<::Exchange::MEClientResponse>> pending_responses_;
+    std::vector<::Exchange::MEClientResponse> responses_;
+    Common::Nanos last_request_due_ = 0;
+    Common::Nanos last_response_due_ = 0;
+
+    // Latency model
+    std::vector<Common::Nanos> latency_samples_;
+    std::mt19937 latency_rng_;
+
+    std::atomic<size_t> num_requests_ = {0};
+    std::atomic<size_t> num_fills_ = {0};
+    std::atomic<size_t> num_market_updates_ = {0};
+};
+
+} // namespace Zerodha
+} // namespace Adapter
@@ -23,6 +23,7 @@ ZerodhaLiquidityTaker::ZerodhaLiquidityTaker(
     Common::ClientId client_id)
     : logger_(logger),
       order_manager_(order_manager),
+      contingent_orders_(logger, order_manager),
       feature_engine_(feature_engine),
       ticker_cfg_(ticker_cfg),
       zerodha_config_(zerodha_config),
@@ -89,6 +90,9 @@ auto ZerodhaLiquidityTaker::onOrderBookUpdate(
     // First, delegate to the encapsulated LiquidityTaker
     liquidity_taker_->onOrderBookUpdate(ticker_id, price, side, book);
     
+    // Fire any bracket stop loss crossed by this update
+    contingent_orders_.onOrderBookUpdate(ticker_id, book->getBBO());
+    
     logger_->log("%:% %() % ticker:% price:% side:%\n", 
                 __FILE__, __LINE__, __FUNCTION__,
                 Common::getCurrentTimeStr(&time_str_), ticker_id, 
@@ -97,9 +101,6 @@ auto ZerodhaLiquidityTaker::onOrderBookUpdate(
                 
     // Update VWAP calculation on order book update
     updateVWAP(ticker_id, book);
-    
-    // Update volume percentile on order book update
-    updateVolumePercentile(ticker_id, book);
 }
 
 auto ZerodhaLiquidityTaker::onTradeUpdate(
@@ -111,6 +112,9 @@ auto ZerodhaLiquidityTaker::onTradeUpdate(
                 Common::getCurrentTimeStr(&time_str_),
                 market_update->toString().c_str());
 
+    // Rank this trade's size among the trade sizes seen so far
+    updateVolumePercentile(market_update->ticker_id_, market_update->qty_);
+
     // Check trading hours restriction if enabled
     if (zerodha_config_.enforce_trading_hours && !isWithinTradingHours()) {
         logger_->log("%:% %() % Outside trading hours - not taking action\n", 
@@ -121,11 +125,11 @@ auto ZerodhaLiquidityTaker::onTradeUpdate(
 
     // Get BBO and aggressive trade ratio from base strategy
     const auto bbo = book->getBBO();
-    const auto agg_qty_ratio = feature_engine_->getAggTradeQtyRatio();
+    const auto agg_qty_ratio = feature_engine_->getAggTradeQtyRatio(market_update->ticker_id_);
 
     if (LIKELY(bbo->bid_price_ != Common::Price_INVALID && 
                bbo->ask_price_ != Common::Price_INVALID && 
-               agg_qty_ratio != Trading::Feature_INVALID)) {
+               !std::isnan(agg_qty_ratio))) {
         
         logger_->log("%:% %() % % agg-qty-ratio:%\n", 
                     __FILE__, __LINE__, __FUNCTION__,
@@ -278,11 +282,8 @@ auto ZerodhaLiquidityTaker::onOrderUpdate(
                 Common::getCurrentTimeStr(&time_str_),
                 client_response->toString().c_str());
     
-    // Check if this is a fill for a bracket order
-    if (client_response->type_ == ::Exchange::ClientResponseType::FILLED ||
-        client_response->type_ == ::Exchange::ClientResponseType::PARTIALLY_FILLED) {
-        handleBracketOrderFill(client_response);
-    }
+    // Advance any bracket order this response is for
+    contingent_orders_.onOrderUpdate(client_response);
     
     // Process Zerodha-specific order responses
     // Handle specific rejection reasons from Zerodha
@@ -427,83 +428,41 @@ void ZerodhaLiquidityTaker::updateVWAP(
         return;
     }
     
-    // VWAP calculation requires trade data, but we can approximate using mid prices
-    // This is a simplified calculation; a real implementation would track actual trades
-    
-    double total_value = 0.0;
-    double total_volume = 0.0;
+    // True trade VWAP over the feature engine's rolling time window
+    const auto vwap = feature_engine_->getTickerFeatures(ticker_id).timeVwap();
     
-    // Get BBO
-    const auto bbo = book->getBBO();
-    
-    if (bbo->bid_price_ != Common::Price_INVALID && bbo->ask_price_ != Common::Price_INVALID) {
-        // Calculate mid price
-        double mid_price = (static_cast<double>(bbo->bid_price_) + static_cast<double>(bbo->ask_price_)) / 2.0;
-        
-        // Use current visible volume as weight
-        double volume = static_cast<double>(bbo->bid_qty_ + bbo->ask_qty_);
-        
-        // Update running totals
-        total_value += mid_price * volume;
-        total_volume += volume;
+    if (!std::isnan(vwap)) {
+        // Update cache
+        vwap_cache_[ticker_id] = vwap;
         
-        if (total_volume > 0) {
-            // Calculate VWAP
-            double vwap = total_value / total_volume;
-            
-            // Update cache
-            vwap_cache_[ticker_id] = vwap;
-            
-            logger_->log("%:% %() % Updated VWAP for ticker %: %\n", 
-                       __FILE__, __LINE__, __FUNCTION__,
-                       Common::getCurrentTimeStr(&time_str_),
-                       ticker_id, vwap);
-        }
+        logger_->log("%:% %() % Updated VWAP for ticker %: %\n", 
+                   __FILE__, __LINE__, __FUNCTION__,
+                   Common::getCurrentTimeStr(&time_str_),
+                   ticker_id, vwap);
     }
 }
 
 void ZerodhaLiquidityTaker::updateVolumePercentile(
     Common::TickerId ticker_id, 
-    Trading::MarketOrderBook *book) {
+    Common::Qty trade_qty) {
     
-    if (!book) {
+    // Trade size against the streaming distribution of traded sizes, like against like
+    const auto percentile = feature_engine_->getTickerFeatures(ticker_id).volumePercentile(
+        static_cast<double>(trade_qty));
+    
+    if (std::isnan(percentile)) {
         return;
     }
     
-    // This is a simplified calculation; a real implementation would compare
-    // current volume with historical volume distribution
+    const int estimated_percentile = static_cast<int>(percentile);
     
-    // For now, use a simple heuristic based on visible liquidity
-    const auto bbo = book->getBBO();
+    // Update cache
+    volume_percentile_cache_[ticker_id] = estimated_percentile;
     
-    if (bbo->bid_price_ != Common::Price_INVALID && bbo->ask_price_ != Common::Price_INVALID) {
-        // Total visible volume
-        int total_visible_volume = bbo->bid_qty_ + bbo->ask_qty_;
-        
-        // Use a simple scaling to estimate percentile
-        // In a real system, we would compare with historical distribution
-        int estimated_percentile = 0;
-        
-        if (total_visible_volume > 10000) {
-            estimated_percentile = 90;  // Very high volume
-        } else if (total_visible_volume > 5000) {
-            estimated_percentile = 75;  // High volume
-        } else if (total_visible_volume > 1000) {
-            estimated_percentile = 50;  // Medium volume
-        } else if (total_visible_volume > 500) {
-            estimated_percentile = 25;  // Low volume
-        } else {
-            estimated_percentile = 10;  // Very low volume
-        }
-        
-        // Update cache
-        volume_percentile_cache_[ticker_id] = estimated_percentile;
-        
-        logger_->log("%:% %() % Updated volume percentile for ticker %: %\n", 
-                   __FILE__, __LINE__, __FUNCTION__,
-                   Common::getCurrentTimeStr(&time_str_),
-                   ticker_id, estimated_percentile);
-    }
+    logger_->log("%:% %() % Updated volume percentile for ticker %: %\n", 
+               __FILE__, __LINE__, __FUNCTION__,
+               Common::getCurrentTimeStr(&time_str_),
+               ticker_id, estimated_percentile);
 }
 
 void ZerodhaLiquidityTaker::updateCircuitLimits() {
@@ -598,74 +557,25 @@ Common::OrderId ZerodhaLiquidityTaker::sendBracketOrder(
     Common::Price stop_loss_price,
     Common::Price target_price) {
     
-    // Generate a unique order ID for the entry order
-    Common::OrderId entry_order_id = generateOrderId();
-    
-    // Create the bracket order structure
-    BracketOrder bracket_order = createBracketOrder(
-        ticker_id,
-        side,
-        entry_price,
-        quantity,
-        stop_loss_price,
-        target_price,
-        entry_order_id
-    );
-    
-    // Lock the bracket orders map
-    std::lock_guard<std::mutex> lock(bracket_orders_mutex_);
-    
-    // Store the bracket order
-    active_bracket_orders_[entry_order_id] = bracket_order;
+    // The entry goes out through the order manager, the stop loss and target are armed as it fills
+    auto bracket_order = contingent_orders_.newBracket(
+        ticker_id, side, entry_price, static_cast<Common::Qty>(quantity), target_price, stop_loss_price);
     
-    // Now place the entry order
-    if (outgoing_requests_) {
-        // We have direct queue access, use it
-        ::Exchange::MEClientRequest request;
-        request.client_id_ = client_id_;
-        request.order_id_ = entry_order_id;
-        request.ticker_id_ = ticker_id;
-        request.type_ = ::Exchange::ClientRequestType::NEW;
-        request.side_ = side;
-        request.price_ = entry_price;
-        request.qty_ = quantity;
-        
-        // Get the next request to write to
-        auto next_write = outgoing_requests_->getNextToWriteTo();
-        if (next_write) {
-            *next_write = request;
-            outgoing_requests_->updateWriteIndex();
-            
-            logger_->log("%:% %() % Sent bracket order entry for ticker %: % % @ %\n", 
-                       __FILE__, __LINE__, __FUNCTION__,
-                       Common::getCurrentTimeStr(&time_str_),
-                       ticker_id, 
-                       side == Common::Side::BUY ? "BUY" : "SELL", 
-                       quantity, 
-                       Common::priceToString(entry_price).c_str());
-        } else {
-            logger_->log("%:% %() % Failed to send bracket order entry: queue full\n", 
-                       __FILE__, __LINE__, __FUNCTION__,
-                       Common::getCurrentTimeStr(&time_str_));
-        }
-    } else {
-        // Use the order manager instead
-        if (side == Common::Side::BUY) {
-            order_manager_->moveOrders(ticker_id, entry_price, Common::Price_INVALID, quantity);
-            logger_->log("%:% %() % Sent bracket order entry via order manager for ticker %: BUY % @ %\n", 
-                       __FILE__, __LINE__, __FUNCTION__,
-                       Common::getCurrentTimeStr(&time_str_),
-                       ticker_id, quantity, Common::priceToString(entry_price).c_str());
-        } else {
-            order_manager_->moveOrders(ticker_id, Common::Price_INVALID, entry_price, quantity);
-            logger_->log("%:% %() % Sent bracket order entry via order manager for ticker %: SELL % @ %\n", 
-                       __FILE__, __LINE__, __FUNCTION__,
-                       Common::getCurrentTimeStr(&time_str_),
-                       ticker_id, quantity, Common::priceToString(entry_price).c_str());
-        }
+    if (!bracket_order) {
+        logger_->log("%:% %() % Bracket order entry refused for ticker %: % % @ %\n", 
+                   __FILE__, __LINE__, __FUNCTION__,
+                   Common::getCurrentTimeStr(&time_str_),
+                   ticker_id, Common::sideToString(side).c_str(), quantity,
+                   Common::priceToString(entry_price).c_str());
+        return Common::OrderId_INVALID;
     }
     
-    return entry_order_id;
+    logger_->log("%:% %() % Sent bracket order entry for ticker %: %\n", 
+               __FILE__, __LINE__, __FUNCTION__,
+               Common::getCurrentTimeStr(&time_str_),
+               ticker_id, bracket_order->toString().c_str());
+    
+    return bracket_order->entry_order_id_;
 }
 
 Common::OrderId ZerodhaLiquidityTaker::sendDirectOrder(
@@ -738,265 +648,6 @@ Common::OrderId ZerodhaLiquidityTaker::sendMarketOrder(
     return order_id;
 }
 
-void ZerodhaLiquidityTaker::handleBracketOrderFill(
-    const ::Exchange::MEClientResponse *client_response) {
-    
-    // Check if this is a fill for an entry order of a bracket order
-    std::lock_guard<std::mutex> lock(bracket_orders_mutex_);
-    
-    auto it = active_bracket_orders_.find(client_response->order_id_);
-    if (it != active_bracket_orders_.end()) {
-        // This is a fill for an entry order of a bracket order
-        BracketOrder& bracket_order = it->second;
-        
-        // Check if this is the first fill for this bracket order
-        if (!bracket_order.entry_filled) {
-            // Mark the entry order as filled
-            bracket_order.entry_filled = true;
-            bracket_order.fill_time = Common::getCurrentNanos();
-            
-            logger_->log("%:% %() % Bracket order entry filled: %\n", 
-                       __FILE__, __LINE__, __FUNCTION__,
-                       Common::getCurrentTimeStr(&time_str_),
-                       client_response->order_id_);
-            
-            // Now place the contingent stop loss and target orders
-            // Generate unique order IDs for stop loss and target orders
-            bracket_order.stop_loss_order_id = generateOrderId();
-            bracket_order.target_order_id = generateOrderId();
-            
-            // Direction for the exit orders (opposite of entry)
-            Common::Side exit_side = bracket_order.side == Common::Side::BUY ? Common::Side::SELL : Common::Side::BUY;
-            
-            if (outgoing_requests_) {
-                // Place stop loss order
-                ::Exchange::MEClientRequest sl_request;
-                sl_request.client_id_ = client_id_;
-                sl_request.order_id_ = bracket_order.stop_loss_order_id;
-                sl_request.ticker_id_ = bracket_order.ticker_id;
-                sl_request.type_ = ::Exchange::ClientRequestType::NEW;
-                sl_request.side_ = exit_side;
-                sl_request.price_ = bracket_order.stop_loss_price;
-                sl_request.qty_ = bracket_order.quantity;
-                
-                // Place target order
-                ::Exchange::MEClientRequest target_request;
-                target_request.client_id_ = client_id_;
-                target_request.order_id_ = bracket_order.target_order_id;
-                target_request.ticker_id_ = bracket_order.ticker_id;
-                target_request.type_ = ::Exchange::ClientRequestType::NEW;
-                target_request.side_ = exit_side;
-                target_request.price_ = bracket_order.target_price;
-                target_request.qty_ = bracket_order.quantity;
-                
-                // Get the next request to write to for stop loss
-                auto sl_next_write = outgoing_requests_->getNextToWriteTo();
-                if (sl_next_write) {
-                    *sl_next_write = sl_request;
-                    outgoing_requests_->updateWriteIndex();
-                    
-                    logger_->log("%:% %() % Placed stop loss order % for bracket order %: % % @ %\n", 
-                               __FILE__, __LINE__, __FUNCTION__,
-                               Common::getCurrentTimeStr(&time_str_),
-                               bracket_order.stop_loss_order_id,
-                               bracket_order.entry_order_id,
-                               exit_side == Common::Side::BUY ? "BUY" : "SELL",
-                               bracket_order.quantity,
-                               Common::priceToString(bracket_order.stop_loss_price).c_str());
-                } else {
-                    logger_->log("%:% %() % Failed to place stop loss order for bracket order %: queue full\n", 
-                               __FILE__, __LINE__, __FUNCTION__,
-                               Common::getCurrentTimeStr(&time_str_),
-                               bracket_order.entry_order_id);
-                }
-                
-                // Get the next request to write to for target
-                auto target_next_write = outgoing_requests_->getNextToWriteTo();
-                if (target_next_write) {
-                    *target_next_write = target_request;
-                    outgoing_requests_->updateWriteIndex();
-                    
-                    logger_->log("%:% %() % Placed target order % for bracket order %: % % @ %\n", 
-                               __FILE__, __LINE__, __FUNCTION__,
-                               Common::getCurrentTimeStr(&time_str_),
-                               bracket_order.target_order_id,
-                               bracket_order.entry_order_id,
-                               exit_side == Common::Side::BUY ? "BUY" : "SELL",
-                               bracket_order.quantity,
-                               Common::priceToString(bracket_order.target_price).c_str());
-                } else {
-                    logger_->log("%:% %() % Failed to place target order for bracket order %: queue full\n", 
-                               __FILE__, __LINE__, __FUNCTION__,
-                               Common::getCurrentTimeStr(&time_str_),
-                               bracket_order.entry_order_id);
-                }
-            } else {
-                // Use order manager for both orders
-                
-                // Place stop loss order with order manager
-                if (exit_side == Common::Side::BUY) {
-                    order_manager_->moveOrders(bracket_order.ticker_id, bracket_order.stop_loss_price, Common::Price_INVALID, bracket_order.quantity);
-                } else {
-                    order_manager_->moveOrders(bracket_order.ticker_id, Common::Price_INVALID, bracket_order.stop_loss_price, bracket_order.quantity);
-                }
-                
-                logger_->log("%:% %() % Placed stop loss order via order manager for bracket order %: % % @ %\n", 
-                           __FILE__, __LINE__, __FUNCTION__,
-                           Common::getCurrentTimeStr(&time_str_),
-                           bracket_order.entry_order_id,
-                           exit_side == Common::Side::BUY ? "BUY" : "SELL",
-                           bracket_order.quantity,
-                           Common::priceToString(bracket_order.stop_loss_price).c_str());
-                
-                // Place target order with order manager
-                if (exit_side == Common::Side::BUY) {
-                    order_manager_->moveOrders(bracket_order.ticker_id, bracket_order.target_price, Common::Price_INVALID, bracket_order.quantity);
-                } else {
-                    order_manager_->moveOrders(bracket_order.ticker_id, Common::Price_INVALID, bracket_order.target_price, bracket_order.quantity);
-                }
-                
-                logger_->log("%:% %() % Placed target order via order manager for bracket order %: % % @ %\n", 
-                           __FILE__, __LINE__, __FUNCTION__,
-                           Common::getCurrentTimeStr(&time_str_),
-                           bracket_order.entry_order_id,
-                           exit_side == Common::Side::BUY ? "BUY" : "SELL",
-                           bracket_order.quantity,
-                           Common::priceToString(bracket_order.target_price).c_str());
-            }
-        }
-    } else {
-        // Check if this is a fill for a stop loss or target order
-        for (auto& bracket_entry : active_bracket_orders_) {
-            BracketOrder& bracket_order = bracket_entry.second;
-            
-            if (client_response->order_id_ == bracket_order.stop_loss_order_id) {
-                // This is a fill for a stop loss order
-                bracket_order.stop_loss_triggered = true;
-                bracket_order.exit_time = Common::getCurrentNanos();
-                
-                logger_->log("%:% %() % Bracket order stop loss triggered: %, exiting position\n", 
-                           __FILE__, __LINE__, __FUNCTION__,
-                           Common::getCurrentTimeStr(&time_str_),
-                           bracket_order.entry_order_id);
-                
-                // Cancel the target order
-                if (bracket_order.target_order_id != 0) {
-                    if (outgoing_requests_) {
-                        ::Exchange::MEClientRequest cancel_request;
-                        cancel_request.client_id_ = client_id_;
-                        cancel_request.order_id_ = bracket_order.target_order_id;
-                        cancel_request.ticker_id_ = bracket_order.ticker_id;
-                        cancel_request.type_ = ::Exchange::ClientRequestType::CANCEL;
-                        
-                        // Get the next request to write to
-                        auto next_write = outgoing_requests_->getNextToWriteTo();
-                        if (next_write) {
-                            *next_write = cancel_request;
-                            outgoing_requests_->updateWriteIndex();
-                            
-                            logger_->log("%:% %() % Cancelling target order % for bracket order %\n", 
-                                       __FILE__, __LINE__, __FUNCTION__,
-                                       Common::getCurrentTimeStr(&time_str_),
-                                       bracket_order.target_order_id,
-                                       bracket_order.entry_order_id);
-                        } else {
-                            logger_->log("%:% %() % Failed to cancel target order for bracket order %: queue full\n", 
-                                       __FILE__, __LINE__, __FUNCTION__,
-                                       Common::getCurrentTimeStr(&time_str_),
-                                       bracket_order.entry_order_id);
-                        }
-                    } else {
-                        // Since we don't have direct queue access, we can't cancel directly
-                        // Best approach is to place a new order in the opposite direction to neutralize
-                        logger_->log("%:% %() % Cannot directly cancel target order for bracket order % without queue access\n", 
-                                   __FILE__, __LINE__, __FUNCTION__,
-                                   Common::getCurrentTimeStr(&time_str_),
-                                   bracket_order.entry_order_id);
-                    }
-                }
-                
-                break;
-            } else if (client_response->order_id_ == bracket_order.target_order_id) {
-                // This is a fill for a target order
-                bracket_order.target_triggered = true;
-                bracket_order.exit_time = Common::getCurrentNanos();
-                
-                logger_->log("%:% %() % Bracket order target reached: %, exiting position\n", 
-                           __FILE__, __LINE__, __FUNCTION__,
-                           Common::getCurrentTimeStr(&time_str_),
-                           bracket_order.entry_order_id);
-                
-                // Cancel the stop loss order
-                if (bracket_order.stop_loss_order_id != 0) {
-                    if (outgoing_requests_) {
-                        ::Exchange::MEClientRequest cancel_request;
-                        cancel_request.client_id_ = client_id_;
-                        cancel_request.order_id_ = bracket_order.stop_loss_order_id;
-                        cancel_request.ticker_id_ = bracket_order.ticker_id;
-                        cancel_request.type_ = ::Exchange::ClientRequestType::CANCEL;
-                        
-                        // Get the next request to write to
-                        auto next_write = outgoing_requests_->getNextToWriteTo();
-                        if (next_write) {
-                            *next_write = cancel_request;
-                            outgoing_requests_->updateWriteIndex();
-                            
-                            logger_->log("%:% %() % Cancelling stop loss order % for bracket order %\n", 
-                                       __FILE__, __LINE__, __FUNCTION__,
-                                       Common::getCurrentTimeStr(&time_str_),
-                                       bracket_order.stop_loss_order_id,
-                                       bracket_order.entry_order_id);
-                        } else {
-                            logger_->log("%:% %() % Failed to cancel stop loss order for bracket order %: queue full\n", 
-                                       __FILE__, __LINE__, __FUNCTION__,
-                                       Common::getCurrentTimeStr(&time_str_),
-                                       bracket_order.entry_order_id);
-                        }
-                    } else {
-                        // Since we don't have direct queue access, we can't cancel directly
-                        // Best approach is to place a new order in the opposite direction to neutralize
-                        logger_->log("%:% %() % Cannot directly cancel stop loss order for bracket order % without queue access\n", 
-                                   __FILE__, __LINE__, __FUNCTION__,
-                                   Common::getCurrentTimeStr(&time_str_),
-                                   bracket_order.entry_order_id);
-                    }
-                }
-                
-                break;
-            }
-        }
-    }
-}
-
-ZerodhaLiquidityTaker::BracketOrder ZerodhaLiquidityTaker::createBracketOrder(
-    Common::TickerId ticker_id,
-    Common::Side side,
-    Common::Price entry_price,
-    size_t quantity,
-    Common::Price stop_loss_price,
-    Common::Price target_price,
-    Common::OrderId entry_order_id) {
-    
-    BracketOrder bracket_order;
-    bracket_order.entry_order_id = entry_order_id;
-    bracket_order.stop_loss_order_id = 0;  // Will be set when entry is filled
-    bracket_order.target_order_id = 0;     // Will be set when entry is filled
-    bracket_order.ticker_id = ticker_id;
-    bracket_order.side = side;
-    bracket_order.entry_price = entry_price;
-    bracket_order.stop_loss_price = stop_loss_price;
-    bracket_order.target_price = target_price;
-    bracket_order.quantity = quantity;
-    bracket_order.entry_filled = false;
-    bracket_order.stop_loss_triggered = false;
-    bracket_order.target_triggered = false;
-    bracket_order.creation_time = Common::getCurrentNanos();
-    bracket_order.fill_time = 0;
-    bracket_order.exit_time = 0;
-    
-    return bracket_order;
-}
-
 Common::OrderId ZerodhaLiquidityTaker::generateOrderId() {
     // Generate a unique order ID from the atomic counter
     return next_order_id_++;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "trading/strategy/liquidity_taker.h"
+#include "trading/strategy/contingent_order_manager.h"
 #include "trading/adapters/zerodha/market_data/zerodha_market_data_adapter.h"
 #include "trading/adapters/zerodha/order_gw/zerodha_order_gateway_adapter.h"
 
@@ -9,7 +10,6 @@
 #include <vector>
 #include <string>
 #include <cstdint>
-#include <mutex>
 #include <atomic>
 #include <memory>
 
@@ -55,30 +55,6 @@ public:
         uint64_t last_updated = 0;             // Timestamp of last update
     };
 
-    /**
-     * @brief Bracket order structure for tracking multi-leg orders
-     */
-    struct BracketOrder {
-        Common::OrderId entry_order_id = 0;            // Entry order ID
-        Common::OrderId stop_loss_order_id = 0;        // Stop loss order ID 
-        Common::OrderId target_order_id = 0;           // Target order ID
-        Common::TickerId ticker_id = 0;                // Instrument ticker ID
-        Common::Side side = Common::Side::INVALID;     // Order side
-        Common::Price entry_price = 0;                 // Entry price
-        Common::Price stop_loss_price = 0;             // Stop loss price
-        Common::Price target_price = 0;                // Target price
-        Common::Qty quantity = 0;                      // Order quantity
-        std::string zerodha_order_id;                  // Zerodha entry order ID
-        std::string zerodha_sl_order_id;               // Zerodha stop loss order ID
-        std::string zerodha_target_order_id;           // Zerodha target order ID
-        bool entry_filled = false;                     // Whether entry order is filled
-        bool stop_loss_triggered = false;              // Whether stop loss is triggered
-        bool target_triggered = false;                 // Whether target is triggered
-        uint64_t creation_time = 0;                    // Time when order was created
-        uint64_t fill_time = 0;                        // Time when entry was filled
-        uint64_t exit_time = 0;                        // Time when position was closed
-    };
-
     /**
      * @brief Constructor for Zerodha Liquidity Taker
      * 
@@ -183,12 +159,14 @@ private:
     void updateVWAP(Common::TickerId ticker_id, Trading::MarketOrderBook *book);
     
     /**
-     * @brief Update volume percentile calculation for a ticker
+     * @brief Update the volume percentile of a ticker from a trade
+     * 
+     * Ranks the trade's size against the distribution of trade sizes seen so far.
      * 
      * @param ticker_id Ticker ID
-     * @param book Market order book
+     * @param trade_qty Quantity of the trade
      */
-    void updateVolumePercentile(Common::TickerId ticker_id, Trading::MarketOrderBook *book);
+    void updateVolumePercentile(Common::TickerId ticker_id, Common::Qty trade_qty);
     
     /**
      * @brief Update circuit limits for all tickers
@@ -199,7 +177,7 @@ private:
      * @brief Send a bracket order
      * 
      * Places an entry order with automatic stop loss and target price orders.
-     * The stop loss and target orders are activated only when the entry order is filled.
+     * The target order and the stop loss trigger are armed for whatever quantity the entry fills, as it fills.
      * 
      * @param ticker_id Ticker ID
      * @param side Order side (BUY or SELL)
@@ -245,34 +223,6 @@ private:
         Common::Side side,
         size_t quantity);
     
-    /**
-     * @brief Handle order fill for bracket orders
-     * 
-     * @param client_response Client response with fill details
-     */
-    void handleBracketOrderFill(const ::Exchange::MEClientResponse *client_response);
-    
-    /**
-     * @brief Create a new bracket order
-     * 
-     * @param ticker_id Ticker ID
-     * @param side Order side (BUY or SELL)
-     * @param entry_price Entry price
-     * @param quantity Order quantity
-     * @param stop_loss_price Stop loss price
-     * @param target_price Target price
-     * @param entry_order_id Entry order ID
-     * @return BracketOrder structure
-     */
-    BracketOrder createBracketOrder(
-        Common::TickerId ticker_id,
-        Common::Side side,
-        Common::Price entry_price,
-        size_t quantity,
-        Common::Price stop_loss_price,
-        Common::Price target_price,
-        Common::OrderId entry_order_id);
-    
     /**
      * @brief Generate a unique order ID
      * 
@@ -286,6 +236,9 @@ private:
     // Underlying components
     Common::Logger *logger_ = nullptr;
     Trading::OrderManager *order_manager_ = nullptr;
+    
+    // Bracket orders - entry, stop loss and target - driven from the strategy thread
+    Trading::ContingentOrderManager contingent_orders_;
     const Trading::FeatureEngine *feature_engine_ = nullptr;
     const Common::TradeEngineCfgHashMap &ticker_cfg_;
 
@@ -313,9 +266,6 @@ private:
     // Lot size cache for each ticker
     std::unordered_map<Common::TickerId, size_t> lot_sizes_;
     
-    // Track bracket orders
-    std::unordered_map<Common::OrderId, BracketOrder> active_bracket_orders_;
-    std::mutex bracket_orders_mutex_;
     
     // Order ID generation
     std::atomic<Common::OrderId> next_order_id_{1000000};
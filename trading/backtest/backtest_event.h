@@ -0,0 +1,65 @@
+#pragma once
+
+#include <sstream>
+
+#include "common/types.h"
+#include "common/time_utils.h"
+
+#include "exchange/market_data/market_update.h"
+#include "exchange/order_server/client_response.h"
+
+namespace Trading {
+  /// Kind of message in a recorded feed.
+  enum class BacktestEventType : uint8_t {
+    INVALID = 0,
+    MARKET_UPDATE = 1,
+    CLIENT_RESPONSE = 2
+  };
+
+  inline auto backtestEventTypeToString(BacktestEventType type) -> std::string {
+    switch (type) {
+      case BacktestEventType::MARKET_UPDATE:
+        return "MARKET_UPDATE";
+      case BacktestEventType::CLIENT_RESPONSE:
+        return "CLIENT_RESPONSE";
+      case BacktestEventType::INVALID:
+        return "INVALID";
+    }
+
+    return "UNKNOWN";
+  }
+
+  /// One recorded MEMarketUpdate or MEClientResponse with the time the trade engine received it.
+  /// Fixed size and trivially copyable, so recorded feeds are flat arrays of these.
+  struct BacktestEvent {
+    Common::Nanos time_ = 0;
+    BacktestEventType type_ = BacktestEventType::INVALID;
+
+    union {
+      Exchange::MEMarketUpdate market_update_;
+      Exchange::MEClientResponse client_response_;
+    };
+
+    BacktestEvent() noexcept : market_update_() {
+    }
+
+    BacktestEvent(Common::Nanos time, const Exchange::MEMarketUpdate &market_update) noexcept
+        : time_(time), type_(BacktestEventType::MARKET_UPDATE), market_update_(market_update) {
+    }
+
+    BacktestEvent(Common::Nanos time, const Exchange::MEClientResponse &client_response) noexcept
+        : time_(time), type_(BacktestEventType::CLIENT_RESPONSE), client_response_(client_response) {
+    }
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "BacktestEvent"
+         << " ["
+         << " time:" << time_
+         << " type:" << backtestEventTypeToString(type_)
+         << " " << (type_ == BacktestEventType::CLIENT_RESPONSE ? client_response_.toString() : market_update_.toString())
+         << "]";
+      return ss.str();
+    }
+  };
+}
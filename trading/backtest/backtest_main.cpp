@@ -0,0 +1,49 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <filesystem>
+
+#include "backtester.h"
+
+/// ./backtest_main EVENTS_FILE ALGO_TYPE LATENCY_MICROS [CLIP_1 THRESH_1 MAX_ORDER_SIZE_1 MAX_POS_1 MAX_LOSS_1] [CLIP_2 THRESH_2 MAX_ORDER_SIZE_2 MAX_POS_2 MAX_LOSS_2] ...
+/// Every [CLIP THRESH MAX_ORDER_SIZE MAX_POS MAX_LOSS] group is one backtest run with that configuration on every ticker,
+/// the runs are spread over all cores. EVENTS_FILE is a flat file of BacktestEvent or a directory of journal files.
+int main(int argc, char **argv) {
+    if (argc < 9 || (argc - 4) % 5) {
+        std::cerr << "USAGE backtest_main EVENTS_FILE ALGO_TYPE LATENCY_MICROS [CLIP_1 THRESH_1 MAX_ORDER_SIZE_1 MAX_POS_1 MAX_LOSS_1] ...\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto events = (std::filesystem::is_directory(argv[1]) ? Trading::loadBacktestEvents(Common::JournalReader(argv[1]))
+                                                                : Trading::loadBacktestEvents(argv[1]));
+    if (events.empty()) {
+        std::cerr << "No events in " << argv[1] << "\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto algo_type = Common::stringToAlgoType(argv[2]);
+    const auto latency = std::atoll(argv[3]) * Common::NANOS_TO_MICROS;
+
+    std::vector<Trading::BacktestCfg> cfgs;
+    for (int i = 4; i < argc; i += 5) {
+        Trading::BacktestCfg cfg;
+        cfg.algo_type_ = algo_type;
+        cfg.order_latency_ = cfg.response_latency_ = latency;
+        for (auto &ticker_cfg : cfg.ticker_cfg_) {
+            ticker_cfg.clip_ = static_cast<Common::Qty>(std::atoi(argv[i]));
+            ticker_cfg.threshold_ = std::atof(argv[i + 1]);
+            ticker_cfg.risk_cfg_.max_order_size_ = static_cast<Common::Qty>(std::atoi(argv[i + 2]));
+            ticker_cfg.risk_cfg_.max_position_ = static_cast<Common::Qty>(std::atoi(argv[i + 3]));
+            ticker_cfg.risk_cfg_.max_loss_ = std::atof(argv[i + 4]);
+        }
+        cfgs.push_back(cfg);
+    }
+
+    const auto results = Trading::runBacktestSweep(events, cfgs);
+    for (size_t i = 0; i < results.size(); ++i)
+        std::cout << cfgs[i].ticker_cfg_.at(0).toString() << "\n    " << results[i].toString() << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,223 @@
+#include "backtester.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+
+namespace Trading {
+  Backtester::Backtester(ClientId client_id, const BacktestCfg &cfg)
+      : logger_("backtester_" + std::to_string(client_id) + ".log"), cfg_(cfg),
+        client_requests_(ME_MAX_CLIENT_UPDATES), client_responses_(ME_MAX_CLIENT_UPDATES),
+        market_updates_(ME_MAX_MARKET_UPDATES), fill_simulator_(&logger_) {
+    trade_engine_ = new TradeEngine(client_id, cfg_.algo_type_, cfg_.ticker_cfg_, &client_requests_, &client_responses_,
+                                    &market_updates_);
+  }
+
+  Backtester::~Backtester() {
+    delete trade_engine_;
+    trade_engine_ = nullptr;
+  }
+
+  auto Backtester::run(const BacktestEvent *events, size_t num_events) noexcept -> BacktestResult {
+    logger_.log("%:% %() % events:% algo:% replay-responses:%\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_), num_events, algoTypeToString(cfg_.algo_type_).c_str(),
+                cfg_.replay_responses_);
+
+    result_ = BacktestResult();
+    cash_.fill(0);
+    std::vector<Nanos> decision_times;
+    decision_times.reserve(num_events);
+
+    const auto wall_start = Common::getSystemNanos();
+    constexpr auto NEVER = std::numeric_limits<Nanos>::max();
+    size_t venue_index = 0, engine_index = 0;
+    Nanos now = 0;
+
+    while (true) {
+      const auto venue_time = (venue_index < num_events ? events[venue_index].time_ : NEVER);
+      const auto engine_time = (engine_index < num_events ? events[engine_index].time_ + cfg_.market_data_latency_ : NEVER);
+      const auto pending_time = (pending_.empty() ? NEVER : pending_.top().time_);
+      if (venue_time == NEVER && engine_time == NEVER && pending_time == NEVER)
+        break;
+
+      // On equal times the venue sees its events before they reach the trade engine.
+      now = std::min({venue_time, engine_time, pending_time});
+      Common::setSimulatedNanos(now);
+
+      if (venue_time == now) {
+        const auto &event = events[venue_index++];
+        if (event.type_ == BacktestEventType::MARKET_UPDATE && !cfg_.replay_responses_) {
+          fill_simulator_.onMarketUpdate(event.market_update_);
+          scheduleResponses(now);
+        } else if (event.type_ == BacktestEventType::CLIENT_RESPONSE && cfg_.replay_responses_) {
+          pending_.push({now, next_seq_++, false, {}, event.client_response_});
+        }
+      } else if (pending_time == now) {
+        const auto pending = pending_.top();
+        pending_.pop();
+        if (pending.is_request_) {
+          fill_simulator_.onClientRequest(pending.client_request_);
+          scheduleResponses(now);
+        } else {
+          ++result_.num_responses_;
+          if (pending.client_response_.type_ == Exchange::ClientResponseType::FILLED)
+            onFill(pending.client_response_);
+          *client_responses_.getNextToWriteTo() = pending.client_response_;
+          client_responses_.updateWriteIndex();
+          pollTradeEngine(now);
+        }
+      } else {
+        const auto &event = events[engine_index++];
+        if (event.type_ == BacktestEventType::MARKET_UPDATE) {
+          ++result_.num_market_updates_;
+          *market_updates_.getNextToWriteTo() = event.market_update_;
+          market_updates_.updateWriteIndex();
+
+          const auto start = Common::getSystemNanos();
+          pollTradeEngine(now);
+          decision_times.push_back(Common::getSystemNanos() - start);
+        }
+      }
+    }
+
+    result_.wall_time_ = Common::getSystemNanos() - wall_start;
+    result_.simulated_time_ = (num_events ? now - events[0].time_ : 0);
+    Common::setSimulatedNanos(0);
+
+    for (TickerId ticker_id = 0; ticker_id < ME_MAX_TICKERS; ++ticker_id) {
+      const auto mid = fill_simulator_.getMid(ticker_id);
+      const auto position = result_.positions_[ticker_id];
+      result_.pnls_[ticker_id] = cash_[ticker_id] + (position && !std::isnan(mid) ? position * mid : 0);
+      result_.total_pnl_ += result_.pnls_[ticker_id];
+    }
+
+    std::sort(decision_times.begin(), decision_times.end());
+    if (!decision_times.empty()) {
+      result_.decision_p50_ = decision_times[decision_times.size() / 2];
+      result_.decision_p99_ = decision_times[decision_times.size() * 99 / 100];
+    }
+
+    logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                result_.toString().c_str());
+    return result_;
+  }
+
+  auto Backtester::pollTradeEngine(Nanos now) noexcept -> void {
+    trade_engine_->poll();
+
+    for (auto client_request = client_requests_.getNextToRead(); client_request; client_request = client_requests_.getNextToRead()) {
+      ++result_.num_requests_;
+      // Replayed sessions already have their responses, the requests only get counted.
+      if (!cfg_.replay_responses_)
+        pending_.push({now + cfg_.order_latency_, next_seq_++, true, *client_request, {}});
+      client_requests_.updateReadIndex();
+    }
+  }
+
+  auto Backtester::scheduleResponses(Nanos now) noexcept -> void {
+    fill_simulator_.takeResponses(&responses_);
+    for (const auto &client_response : responses_)
+      pending_.push({now + cfg_.response_latency_, next_seq_++, false, {}, client_response});
+  }
+
+  auto Backtester::onFill(const Exchange::MEClientResponse &client_response) noexcept -> void {
+    if (UNLIKELY(client_response.ticker_id_ >= ME_MAX_TICKERS))
+      return;
+
+    const auto signed_qty = sideToValue(client_response.side_) * static_cast<int64_t>(client_response.exec_qty_);
+    result_.positions_[client_response.ticker_id_] += signed_qty;
+    cash_[client_response.ticker_id_] -= static_cast<double>(signed_qty) * client_response.price_;
+    ++result_.num_fills_;
+    result_.traded_qty_ += client_response.exec_qty_;
+  }
+
+  auto runBacktestSweep(const std::vector<BacktestEvent> &events, const std::vector<BacktestCfg> &cfgs,
+                        size_t num_threads) -> std::vector<BacktestResult> {
+    std::vector<BacktestResult> results(cfgs.size());
+    if (!num_threads)
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = std::min(num_threads, cfgs.size());
+
+    // Every worker takes the next configuration not yet run, on its own simulated clock.
+    std::atomic<size_t> next_cfg{0};
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers.emplace_back([&]() {
+        for (auto cfg_index = next_cfg++; cfg_index < cfgs.size(); cfg_index = next_cfg++) {
+          Backtester backtester(static_cast<ClientId>(cfg_index + 1), cfgs[cfg_index]);
+          results[cfg_index] = backtester.run(events.data(), events.size());
+        }
+      });
+    }
+    for (auto &worker : workers)
+      worker.join();
+
+    return results;
+  }
+
+  auto loadBacktestEvents(const std::string &path) -> std::vector<BacktestEvent> {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+      return {};
+
+    std::vector<BacktestEvent> events(static_cast<size_t>(file.tellg()) / sizeof(BacktestEvent));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(BacktestEvent)));
+    return events;
+  }
+
+  auto saveBacktestEvents(const std::string &path, const std::vector<BacktestEvent> &events) -> bool {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(BacktestEvent)));
+    return static_cast<bool>(file);
+  }
+
+  auto loadBacktestEvents(const Common::JournalReader &journal, Nanos from, Nanos to) -> std::vector<BacktestEvent> {
+    // A recorder tapping the engine's queue and the consumer's incremental stream journals every update twice, so the
+    // tapped MARKET_UPDATE records are used if there are any. Otherwise the MDP_INCREMENTAL records are, once per
+    // sequence number of their stream - the consumer journals what it reads again after a recovery too.
+    std::vector<BacktestEvent> events, incremental;
+    size_t num_market_updates = 0;
+    std::unordered_map<uint16_t, size_t> last_seq;
+    journal.chunk(journal.seek(from), journal.seek(to)).forEach([&](const Common::JournalRecordHeader *record) {
+      if (record->time_ >= to)
+        return;
+
+      switch (record->type_) {
+        case Common::JournalRecordType::MARKET_UPDATE:
+          if (const auto market_update = Common::journalView<Exchange::MEMarketUpdate>(record)) {
+            events.emplace_back(record->time_, *market_update);
+            ++num_market_updates;
+          }
+          break;
+        case Common::JournalRecordType::MDP_INCREMENTAL:
+          if (const auto mdp_update = Common::journalView<Exchange::MDPMarketUpdate>(record)) {
+            auto &seq = last_seq[record->stream_id_];
+            if (mdp_update->seq_num_ > seq) {
+              incremental.emplace_back(record->time_, mdp_update->me_market_update_);
+              seq = mdp_update->seq_num_;
+            }
+          }
+          break;
+        case Common::JournalRecordType::CLIENT_RESPONSE:
+          if (const auto client_response = Common::journalView<Exchange::MEClientResponse>(record))
+            events.emplace_back(record->time_, *client_response);
+          break;
+        default:
+          break;
+      }
+    });
+    if (!num_market_updates)
+      events.insert(events.end(), incremental.begin(), incremental.end());
+
+    // Tapped queues are stamped when the recorder saw them, raw frames when they were received, so they can interleave.
+    std::stable_sort(events.begin(), events.end(), [](const BacktestEvent &lhs, const BacktestEvent &rhs) {
+      return lhs.time_ < rhs.time_;
+    });
+    return events;
+  }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <limits>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "common/types.h"
+#include "common/logging.h"
+#include "common/time_utils.h"
+#include "common/journal_reader.h"
+
+#include "trading/strategy/trade_engine.h"
+
+#include "backtest_event.h"
+#include "fill_simulator.h"
+
+namespace Trading {
+  /// Configuration of one backtest run.
+  struct BacktestCfg {
+    AlgoType algo_type_ = AlgoType::MAKER;
+    TradeEngineCfgHashMap ticker_cfg_;
+
+    /// One way latencies - trade engine to venue for requests, venue to trade engine for responses.
+    Nanos order_latency_ = 100 * NANOS_TO_MICROS;
+    Nanos response_latency_ = 100 * NANOS_TO_MICROS;
+
+    /// Extra delay of market data to the trade engine on top of the recorded receive time, the venue sees it undelayed.
+    Nanos market_data_latency_ = 0;
+
+    /// Deliver the recorded client responses instead of simulating fills - replays a recorded session as it happened.
+    bool replay_responses_ = false;
+  };
+
+  /// Outcome of one backtest run.
+  struct BacktestResult {
+    size_t num_market_updates_ = 0;
+    size_t num_requests_ = 0;
+    size_t num_responses_ = 0;
+    size_t num_fills_ = 0;
+    Qty traded_qty_ = 0;
+
+    /// Position and pnl (in price units) per ticker at the end, open positions marked at the last mid.
+    std::array<int64_t, ME_MAX_TICKERS> positions_ = {};
+    std::array<double, ME_MAX_TICKERS> pnls_ = {};
+    double total_pnl_ = 0;
+
+    /// Simulated time covered and wall time taken.
+    Nanos simulated_time_ = 0;
+    Nanos wall_time_ = 0;
+
+    /// Wall time the trade engine took per market update, including the requests it sent in reaction.
+    Nanos decision_p50_ = 0;
+    Nanos decision_p99_ = 0;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "BacktestResult{"
+         << "md:" << num_market_updates_ << " "
+         << "req:" << num_requests_ << " "
+         << "rsp:" << num_responses_ << " "
+         << "fills:" << num_fills_ << " "
+         << "traded:" << qtyToString(traded_qty_) << " "
+         << "pnl:" << total_pnl_ << " "
+         << "sim:" << simulated_time_ / NANOS_TO_MILLIS << "ms "
+         << "wall:" << wall_time_ / NANOS_TO_MILLIS << "ms "
+         << "decision-p50:" << decision_p50_ << "ns p99:" << decision_p99_ << "ns"
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// Event driven backtest of an unmodified TradeEngine against a recorded feed.
+  /// Events are processed in simulated time order on the calling thread, which runs on the simulated clock for the
+  /// duration of run() so the trading components see event time. Recorded market updates reach the FillSimulator at
+  /// their recorded time and the trade engine market_data_latency_ later. Requests the trade engine sends reach the
+  /// FillSimulator order_latency_ later and its responses come back response_latency_ after that. Nothing sleeps, so
+  /// the run takes as long as the processing does.
+  class Backtester {
+  public:
+    /// The ClientId also names the trade engine's log file, so concurrent runs need different ones.
+    Backtester(ClientId client_id, const BacktestCfg &cfg);
+
+    ~Backtester();
+
+    /// Replay the events, which need to be in time order, and report the outcome.
+    auto run(const BacktestEvent *events, size_t num_events) noexcept -> BacktestResult;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    Backtester() = delete;
+
+    Backtester(const Backtester &) = delete;
+
+    Backtester(const Backtester &&) = delete;
+
+    Backtester &operator=(const Backtester &) = delete;
+
+    Backtester &operator=(const Backtester &&) = delete;
+
+  private:
+    /// Something scheduled to happen at a later simulated time.
+    struct PendingEvent {
+      Nanos time_ = 0;
+      /// Scheduling order, so events due at the same time happen in the order they were scheduled.
+      size_t seq_ = 0;
+      bool is_request_ = false;
+      Exchange::MEClientRequest client_request_;
+      Exchange::MEClientResponse client_response_;
+
+      auto operator>(const PendingEvent &other) const noexcept {
+        return time_ != other.time_ ? time_ > other.time_ : seq_ > other.seq_;
+      }
+    };
+
+    /// Let the trade engine process what is in its queues, then pick up the requests it sent.
+    auto pollTradeEngine(Nanos now) noexcept -> void;
+
+    /// Schedule the responses the FillSimulator generated.
+    auto scheduleResponses(Nanos now) noexcept -> void;
+
+    /// Track position and pnl from the fills delivered to the trade engine.
+    auto onFill(const Exchange::MEClientResponse &client_response) noexcept -> void;
+
+    std::string time_str_;
+    Logger logger_;
+
+    const BacktestCfg cfg_;
+
+    Exchange::ClientRequestLFQueue client_requests_;
+    Exchange::ClientResponseLFQueue client_responses_;
+    Exchange::MEMarketUpdateLFQueue market_updates_;
+
+    TradeEngine *trade_engine_ = nullptr;
+    FillSimulator fill_simulator_;
+
+    std::priority_queue<PendingEvent, std::vector<PendingEvent>, std::greater<>> pending_;
+    size_t next_seq_ = 0;
+    std::vector<Exchange::MEClientResponse> responses_;
+
+    BacktestResult result_;
+    std::array<double, ME_MAX_TICKERS> cash_ = {};
+  };
+
+  /// Run every configuration over the same events, spread over num_threads threads (all cores if 0).
+  /// Each run holds a full TradeEngine, so num_threads also bounds the memory used.
+  auto runBacktestSweep(const std::vector<BacktestEvent> &events, const std::vector<BacktestCfg> &cfgs,
+                        size_t num_threads = 0) -> std::vector<BacktestResult>;
+
+  /// Recorded feeds on disk are flat arrays of BacktestEvent.
+  auto loadBacktestEvents(const std::string &path) -> std::vector<BacktestEvent>;
+
+  auto saveBacktestEvents(const std::string &path, const std::vector<BacktestEvent> &events) -> bool;
+
+  /// Market updates and client responses of a journal recorded in [from, to), stably sorted by record time. Market
+  /// updates come from the MARKET_UPDATE records, or from the MDP_INCREMENTAL records deduplicated by sequence number
+  /// if there are none - never from both.
+  auto loadBacktestEvents(const Common::JournalReader &journal, Nanos from = 0,
+                          Nanos to = std::numeric_limits<Nanos>::max()) -> std::vector<BacktestEvent>;
+}
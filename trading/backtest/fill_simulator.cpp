@@ -0,0 +1,238 @@
+#include "fill_simulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Trading {
+  auto FillSimulator::onMarketUpdate(const Exchange::MEMarketUpdate &market_update) noexcept -> void {
+    if (UNLIKELY(market_update.ticker_id_ >= Common::ME_MAX_TICKERS))
+      return;
+
+    auto &book = books_[market_update.ticker_id_];
+    auto &market_orders = market_orders_[market_update.ticker_id_];
+    switch (market_update.type_) {
+      case Exchange::MarketUpdateType::ADD: {
+        market_orders[market_update.order_id_] = {market_update.side_, market_update.price_, market_update.qty_};
+        level(book, market_update.side_, market_update.price_).qty_ += market_update.qty_;
+        // In the recorded feed nothing traded with it, but it would have traded with the strategy's orders it crosses.
+        sweep(book, market_update.side_, market_update.price_, market_update.qty_, false);
+      }
+        break;
+      case Exchange::MarketUpdateType::MODIFY: {
+        auto itr = market_orders.find(market_update.order_id_);
+        if (itr == market_orders.end())
+          break;
+        auto &order = itr->second;
+        if (market_update.qty_ < order.qty_)
+          removeQty(book, order.side_, order.price_, order.qty_ - market_update.qty_);
+        else
+          level(book, order.side_, order.price_).qty_ += market_update.qty_ - order.qty_;
+        order.qty_ = market_update.qty_;
+      }
+        break;
+      case Exchange::MarketUpdateType::CANCEL: {
+        auto itr = market_orders.find(market_update.order_id_);
+        if (itr == market_orders.end())
+          break;
+        removeQty(book, itr->second.side_, itr->second.price_, itr->second.qty_);
+        market_orders.erase(itr);
+      }
+        break;
+      case Exchange::MarketUpdateType::TRADE:
+        sweep(book, market_update.side_, market_update.price_, market_update.qty_, true);
+        break;
+      case Exchange::MarketUpdateType::CLEAR:
+        book.bids_.clear();
+        book.asks_.clear();
+        market_orders.clear();
+        break;
+      case Exchange::MarketUpdateType::INVALID:
+      case Exchange::MarketUpdateType::SNAPSHOT_START:
+      case Exchange::MarketUpdateType::SNAPSHOT_END:
+        break;
+    }
+
+    compact(book);
+  }
+
+  auto FillSimulator::onClientRequest(const Exchange::MEClientRequest &client_request) noexcept -> void {
+    if (UNLIKELY(client_request.ticker_id_ >= Common::ME_MAX_TICKERS)) {
+      respond(client_request, Exchange::ClientResponseType::REJECTED, client_request.price_, 0, 0);
+      return;
+    }
+
+    auto &book = books_[client_request.ticker_id_];
+    auto order = std::find_if(book.orders_.begin(), book.orders_.end(), [&](const SimOrder &o) {
+      return o.request_.order_id_ == client_request.order_id_;
+    });
+
+    switch (client_request.type_) {
+      case Exchange::ClientRequestType::NEW: {
+        book.orders_.push_back({client_request, client_request.qty_, 0});
+        respond(client_request, Exchange::ClientResponseType::ACCEPTED, client_request.price_, 0, client_request.qty_);
+        match(book, book.orders_.back());
+      }
+        break;
+      case Exchange::ClientRequestType::MODIFY: {
+        if (order == book.orders_.end()) {
+          respond(client_request, Exchange::ClientResponseType::MODIFY_REJECTED, client_request.price_, 0, 0);
+          break;
+        }
+
+        // Only a quantity reduction at the same price keeps the order's place in the queue.
+        const auto keeps_priority = (client_request.price_ == order->request_.price_ && client_request.qty_ <= order->leaves_qty_);
+        auto modified = *order;
+        modified.request_.price_ = client_request.price_;
+        modified.request_.qty_ = client_request.qty_;
+        modified.leaves_qty_ = client_request.qty_;
+        respond(modified.request_, Exchange::ClientResponseType::ACCEPTED, client_request.price_, 0, client_request.qty_);
+        if (keeps_priority) {
+          *order = modified;
+        } else {
+          book.orders_.erase(order);
+          book.orders_.push_back(modified);
+          match(book, book.orders_.back());
+        }
+      }
+        break;
+      case Exchange::ClientRequestType::CANCEL: {
+        if (order == book.orders_.end()) {
+          respond(client_request, Exchange::ClientResponseType::CANCEL_REJECTED, client_request.price_, 0, 0);
+          break;
+        }
+        order->leaves_qty_ = 0;
+        respond(order->request_, Exchange::ClientResponseType::CANCELED, order->request_.price_, 0, 0);
+      }
+        break;
+      case Exchange::ClientRequestType::INVALID:
+        break;
+    }
+
+    compact(book);
+  }
+
+  auto FillSimulator::getMid(Common::TickerId ticker_id) const noexcept -> double {
+    const auto &book = books_.at(ticker_id);
+    if (book.bids_.empty() || book.asks_.empty())
+      return std::numeric_limits<double>::quiet_NaN();
+    return (book.bids_.begin()->first + book.asks_.begin()->first) / 2.0;
+  }
+
+  auto FillSimulator::displayedQty(const TickerBook &book, Common::Side side, Common::Price price) const noexcept -> Common::Qty {
+    if (side == Common::Side::BUY) {
+      const auto itr = book.bids_.find(price);
+      return itr == book.bids_.end() ? 0 : itr->second.qty_;
+    }
+    const auto itr = book.asks_.find(price);
+    return itr == book.asks_.end() ? 0 : itr->second.qty_;
+  }
+
+  auto FillSimulator::removeQty(TickerBook &book, Common::Side side, Common::Price price, Common::Qty qty) noexcept -> void {
+    auto remove = [&](auto &levels) {
+      auto itr = levels.find(price);
+      if (itr == levels.end())
+        return;
+
+      auto &lvl = itr->second;
+      const auto traded = std::min(qty, lvl.traded_qty_);
+      const auto cancelled = std::min<Common::Qty>(qty - traded, lvl.qty_);
+      lvl.traded_qty_ -= traded;
+
+      if (cancelled) {
+        for (auto &order : book.orders_) {
+          if (order.request_.side_ == side && order.request_.price_ == price)
+            order.queue_ahead_ -= static_cast<Common::Qty>(static_cast<uint64_t>(order.queue_ahead_) * cancelled / lvl.qty_);
+        }
+      }
+
+      lvl.qty_ -= std::min(qty, lvl.qty_);
+      if (!lvl.qty_)
+        levels.erase(itr);
+    };
+
+    if (side == Common::Side::BUY)
+      remove(book.bids_);
+    else
+      remove(book.asks_);
+  }
+
+  auto FillSimulator::match(TickerBook &book, SimOrder &order) noexcept -> void {
+    const auto side = order.request_.side_;
+    const auto price = order.request_.price_;
+
+    auto take = [&](auto &levels, auto crosses) {
+      for (auto itr = levels.begin(); itr != levels.end() && order.leaves_qty_ && crosses(itr->first);) {
+        const auto exec_qty = std::min(order.leaves_qty_, itr->second.qty_);
+        fill(order, itr->first, exec_qty);
+        itr->second.qty_ -= exec_qty;
+        itr = (itr->second.qty_ ? std::next(itr) : levels.erase(itr));
+      }
+    };
+
+    if (side == Common::Side::BUY)
+      take(book.asks_, [price](Common::Price ask_price) { return ask_price <= price; });
+    else
+      take(book.bids_, [price](Common::Price bid_price) { return bid_price >= price; });
+
+    order.queue_ahead_ = displayedQty(book, side, price);
+  }
+
+  auto FillSimulator::sweep(TickerBook &book, Common::Side side, Common::Price limit_price, Common::Qty qty, bool trade) noexcept -> void {
+    const auto passive_side = (side == Common::Side::BUY ? Common::Side::SELL : Common::Side::BUY);
+    if (trade) {
+      if (passive_side == Common::Side::BUY) {
+        if (auto itr = book.bids_.find(limit_price); itr != book.bids_.end())
+          itr->second.traded_qty_ += qty;
+      } else if (auto itr = book.asks_.find(limit_price); itr != book.asks_.end()) {
+        itr->second.traded_qty_ += qty;
+      }
+    }
+
+    // Strategy orders the aggressor reaches, best price first and in arrival order within a price.
+    reached_.clear();
+    for (auto &order : book.orders_) {
+      const auto price = order.request_.price_;
+      const auto reaches = (passive_side == Common::Side::BUY ? price >= limit_price : price <= limit_price);
+      if (order.request_.side_ == passive_side && order.leaves_qty_ && reaches)
+        reached_.push_back(&order);
+    }
+    std::stable_sort(reached_.begin(), reached_.end(), [passive_side](const SimOrder *lhs, const SimOrder *rhs) {
+      return passive_side == Common::Side::BUY ? lhs->request_.price_ > rhs->request_.price_ : lhs->request_.price_ < rhs->request_.price_;
+    });
+
+    // Displayed quantity at limit_price the aggressor went through, which was ahead of every order there it reaches.
+    Common::Qty displayed_traded = 0;
+    for (size_t i = 0; i < reached_.size() && qty; ++i) {
+      auto &order = *reached_[i];
+      if (order.request_.price_ == limit_price) {
+        // Displayed quantity ahead of the order at this price and not already traded through trades first.
+        const auto ahead = std::min(qty, order.queue_ahead_ - std::min(order.queue_ahead_, displayed_traded));
+        displayed_traded += ahead;
+        qty -= ahead;
+      }
+      const auto exec_qty = std::min(qty, order.leaves_qty_);
+      fill(order, order.request_.price_, exec_qty);
+      qty -= exec_qty;
+    }
+
+    // The displayed quantity traded is gone from ahead of every order at that price, reached or not.
+    if (displayed_traded) {
+      for (auto *order : reached_) {
+        if (order->request_.price_ == limit_price)
+          order->queue_ahead_ -= std::min(order->queue_ahead_, displayed_traded);
+      }
+    }
+  }
+
+  auto FillSimulator::fill(SimOrder &order, Common::Price price, Common::Qty qty) noexcept -> void {
+    if (!qty)
+      return;
+    order.leaves_qty_ -= qty;
+    respond(order.request_, Exchange::ClientResponseType::FILLED, price, qty, order.leaves_qty_);
+
+    logger_->log("%:% %() % oid:% % %@% leaves:%\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 order.request_.order_id_, Common::sideToString(order.request_.side_).c_str(), qty,
+                 Common::priceToString(price).c_str(), order.leaves_qty_);
+  }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "common/types.h"
+#include "common/logging.h"
+
+#include "exchange/market_data/market_update.h"
+#include "exchange/order_server/client_request.h"
+#include "exchange/order_server/client_response.h"
+
+namespace Trading {
+  /// Venue stand-in for the backtester - keeps the recorded book of every ticker and fills the strategy's orders against it.
+  /// A resting order joins the back of the queue at its price, behind the displayed quantity there. Trades at that price
+  /// work through the queue ahead of it first, cancels at that price are assumed to come evenly from ahead of and behind
+  /// it, and trades or orders through its price fill it outright. The recorded market does not react to the strategy's
+  /// orders. Responses follow the FILLED convention of the trade engine, with leaves_qty_ left on partial fills.
+  class FillSimulator {
+  public:
+    explicit FillSimulator(Common::Logger *logger) noexcept
+        : logger_(logger) {
+    }
+
+    /// Recorded market update, as seen by the venue.
+    auto onMarketUpdate(const Exchange::MEMarketUpdate &market_update) noexcept -> void;
+
+    /// Strategy request arriving at the venue.
+    auto onClientRequest(const Exchange::MEClientRequest &client_request) noexcept -> void;
+
+    /// Responses generated since the last call, for the caller to deliver to the trade engine.
+    auto takeResponses(std::vector<Exchange::MEClientResponse> *responses) noexcept {
+      responses->swap(responses_);
+      responses_.clear();
+    }
+
+    /// Mid of the recorded book, NaN unless both sides are present.
+    auto getMid(Common::TickerId ticker_id) const noexcept -> double;
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    FillSimulator() = delete;
+
+    FillSimulator(const FillSimulator &) = delete;
+
+    FillSimulator(const FillSimulator &&) = delete;
+
+    FillSimulator &operator=(const FillSimulator &) = delete;
+
+    FillSimulator &operator=(const FillSimulator &&) = delete;
+
+  private:
+    /// Displayed quantity at one price, and traded quantity whose removal from the book has not been seen yet.
+    struct Level {
+      Common::Qty qty_ = 0;
+      Common::Qty traded_qty_ = 0;
+    };
+
+    /// Recorded market order, to resolve MODIFY and CANCEL updates to their level.
+    struct MarketOrder {
+      Common::Side side_ = Common::Side::INVALID;
+      Common::Price price_ = Common::Price_INVALID;
+      Common::Qty qty_ = 0;
+    };
+
+    /// Working strategy order.
+    struct SimOrder {
+      Exchange::MEClientRequest request_;
+      Common::Qty leaves_qty_ = 0;
+      Common::Qty queue_ahead_ = 0;
+    };
+
+    /// Bids are kept in descending and asks in ascending price order, best first.
+    struct TickerBook {
+      std::map<Common::Price, Level, std::greater<>> bids_;
+      std::map<Common::Price, Level> asks_;
+      std::vector<SimOrder> orders_;
+    };
+
+    auto level(TickerBook &book, Common::Side side, Common::Price price) noexcept -> Level & {
+      return side == Common::Side::BUY ? book.bids_[price] : book.asks_[price];
+    }
+
+    auto displayedQty(const TickerBook &book, Common::Side side, Common::Price price) const noexcept -> Common::Qty;
+
+    /// Displayed quantity left the level - consumes recorded trades first, then moves the queue of orders there up.
+    auto removeQty(TickerBook &book, Common::Side side, Common::Price price, Common::Qty qty) noexcept -> void;
+
+    /// Take displayed liquidity through the order's price, then rest what is left at the back of its queue.
+    auto match(TickerBook &book, SimOrder &order) noexcept -> void;
+
+    /// Aggressive flow of the specified side and quantity up to limit_price, against the strategy's resting orders.
+    auto sweep(TickerBook &book, Common::Side side, Common::Price limit_price, Common::Qty qty, bool trade) noexcept -> void;
+
+    auto fill(SimOrder &order, Common::Price price, Common::Qty qty) noexcept -> void;
+
+    auto respond(const Exchange::MEClientRequest &request, Exchange::ClientResponseType type, Common::Price price,
+                 Common::Qty exec_qty, Common::Qty leaves_qty) noexcept -> void {
+      responses_.push_back({type, Exchange::ClientResponseRejectReason::INVALID, request.client_id_, request.ticker_id_,
+                            request.order_id_, request.side_, price, exec_qty, leaves_qty});
+    }
+
+    /// Drop orders which are done, keeping the others in arrival order.
+    auto compact(TickerBook &book) noexcept -> void {
+      std::erase_if(book.orders_, [](const SimOrder &order) { return !order.leaves_qty_; });
+    }
+
+    std::string time_str_;
+    Common::Logger *logger_ = nullptr;
+
+    std::array<TickerBook, Common::ME_MAX_TICKERS> books_;
+
+    /// Recorded market orders by ticker and OrderId.
+    std::array<std::unordered_map<Common::OrderId, MarketOrder>, Common::ME_MAX_TICKERS> market_orders_;
+
+    std::vector<Exchange::MEClientResponse> responses_;
+
+    /// Scratch space for the orders an aggressor reaches.
+    std::vector<SimOrder *> reached_;
+  };
+}
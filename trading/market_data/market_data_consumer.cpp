@@ -178,34 +178,51 @@ namespace Trading {
       size_t i = 0;
       for (; i + sizeof(Exchange::MDPMarketUpdate) <= socket->next_rcv_valid_index_; i += sizeof(Exchange::MDPMarketUpdate)) {
         auto request = reinterpret_cast<const Exchange::MDPMarketUpdate *>(socket->inbound_data_.data() + i);
-        logger_.log("%:% %() % Received % socket len:% %\n", __FILE__, __LINE__, __FUNCTION__,
-                    Common::getCurrentTimeStr(&time_str_),
-                    (is_snapshot ? "snapshot" : "incremental"), sizeof(Exchange::MDPMarketUpdate), request->toString());
-
-        const bool already_in_recovery = in_recovery_;
-        in_recovery_ = (already_in_recovery || request->seq_num_ != next_exp_inc_seq_num_);
-
-        if (UNLIKELY(in_recovery_)) {
-          if (UNLIKELY(!already_in_recovery)) { // if we just entered recovery, start the snapshot synchonization process by subscribing to the snapshot multicast stream.
-            logger_.log("%:% %() % Packet drops on % socket. SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
-                        Common::getCurrentTimeStr(&time_str_), (is_snapshot ? "snapshot" : "incremental"), next_exp_inc_seq_num_, request->seq_num_);
-            startSnapshotSync();
-          }
-
-          queueMessage(is_snapshot, request); // queue up the market data update message and check if snapshot recovery / synchronization can be completed successfully.
-        } else if (!is_snapshot) { // not in recovery and received a packet in the correct order and without gaps, process it.
-          logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__,
-                      Common::getCurrentTimeStr(&time_str_), request->toString());
-
-          ++next_exp_inc_seq_num_;
-
-          auto next_write = incoming_md_updates_->getNextToWriteTo();
-          *next_write = std::move(request->me_market_update_);
-          incoming_md_updates_->updateWriteIndex();
-        }
+        if (journal_)
+          journal_->push(is_snapshot ? Common::JournalRecordType::MDP_SNAPSHOT : Common::JournalRecordType::MDP_INCREMENTAL,
+                         Common::getCurrentNanos(), reinterpret_cast<const char *>(request), sizeof(Exchange::MDPMarketUpdate));
+
+        onMarketUpdate(is_snapshot, request);
       }
       memcpy(socket->inbound_data_.data(), socket->inbound_data_.data() + i, socket->next_rcv_valid_index_ - i);
       socket->next_rcv_valid_index_ -= i;
     }
   }
+
+  /// Feed a recorded market data update through the same sequencing and recovery logic as one read from the sockets.
+  auto MarketDataConsumer::replay(bool is_snapshot, const Exchange::MDPMarketUpdate *request) noexcept -> void {
+    if (UNLIKELY(is_snapshot && !in_recovery_))
+      return;
+
+    onMarketUpdate(is_snapshot, request);
+  }
+
+  /// Sequence check, recovery and publishing of one market data update.
+  auto MarketDataConsumer::onMarketUpdate(bool is_snapshot, const Exchange::MDPMarketUpdate *request) noexcept -> void {
+    logger_.log("%:% %() % Received % socket len:% %\n", __FILE__, __LINE__, __FUNCTION__,
+                Common::getCurrentTimeStr(&time_str_),
+                (is_snapshot ? "snapshot" : "incremental"), sizeof(Exchange::MDPMarketUpdate), request->toString());
+
+    const bool already_in_recovery = in_recovery_;
+    in_recovery_ = (already_in_recovery || request->seq_num_ != next_exp_inc_seq_num_);
+
+    if (UNLIKELY(in_recovery_)) {
+      if (UNLIKELY(!already_in_recovery)) { // if we just entered recovery, start the snapshot synchonization process by subscribing to the snapshot multicast stream.
+        logger_.log("%:% %() % Packet drops on % socket. SeqNum expected:% received:%\n", __FILE__, __LINE__, __FUNCTION__,
+                    Common::getCurrentTimeStr(&time_str_), (is_snapshot ? "snapshot" : "incremental"), next_exp_inc_seq_num_, request->seq_num_);
+        startSnapshotSync();
+      }
+
+      queueMessage(is_snapshot, request); // queue up the market data update message and check if snapshot recovery / synchronization can be completed successfully.
+    } else if (!is_snapshot) { // not in recovery and received a packet in the correct order and without gaps, process it.
+      logger_.log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__,
+                  Common::getCurrentTimeStr(&time_str_), request->toString());
+
+      ++next_exp_inc_seq_num_;
+
+      auto next_write = incoming_md_updates_->getNextToWriteTo();
+      *next_write = std::move(request->me_market_update_);
+      incoming_md_updates_->updateWriteIndex();
+    }
+  }
 }
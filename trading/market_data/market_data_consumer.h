@@ -7,6 +7,7 @@
 #include "common/lf_queue.h"
 #include "common/macros.h"
 #include "common/mcast_socket.h"
+#include "common/journal_recorder.h"
 
 #include "exchange/market_data/market_update.h"
 
@@ -34,6 +35,15 @@ namespace Trading {
       run_ = false;
     }
 
+    /// Copy every update read from the sockets into a journal recorder ring, set before start().
+    auto setJournal(Common::JournalByteRing *journal) noexcept {
+      journal_ = journal;
+    }
+
+    /// Process a recorded update as if it was read from the snapshot or incremental socket, e.g. to test recovery
+    /// from a journal. Not to be mixed with start(), which reads the sockets on its own thread.
+    auto replay(bool is_snapshot, const Exchange::MDPMarketUpdate *request) noexcept -> void;
+
     /// Deleted default, copy & move constructors and assignment-operators.
     MarketDataConsumer() = delete;
 
@@ -52,6 +62,9 @@ namespace Trading {
     /// Lock free queue on which decoded market data updates are pushed to, to be consumed by the trade engine.
     Exchange::MEMarketUpdateLFQueue *incoming_md_updates_ = nullptr;
 
+    /// Optional journal recorder ring for the updates read from the sockets.
+    Common::JournalByteRing *journal_ = nullptr;
+
     volatile bool run_ = false;
 
     std::string time_str_;
@@ -78,6 +91,9 @@ namespace Trading {
     /// Process a market data update, the consumer needs to use the socket parameter to figure out whether this came from the snapshot or the incremental stream.
     auto recvCallback(McastSocket *socket) noexcept -> void;
 
+    /// Sequence check, recovery and publishing of one market data update.
+    auto onMarketUpdate(bool is_snapshot, const Exchange::MDPMarketUpdate *request) noexcept -> void;
+
     /// Queue up a message in the *_queued_msgs_ containers, first parameter specifies if this update came from the snapshot or the incremental streams.
     auto queueMessage(bool is_snapshot, const Exchange::MDPMarketUpdate *request);
 
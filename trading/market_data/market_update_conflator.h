@@ -0,0 +1,388 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "common/types.h"
+#include "common/macros.h"
+#include "common/lf_queue.h"
+#include "common/logging.h"
+
+#include "exchange/market_data/market_update.h"
+
+namespace Trading {
+  /// Maximum number of price levels (both sides combined) tracked per ticker by the conflator.
+  constexpr size_t MD_CONFLATOR_MAX_LEVELS = 256;
+
+  /// Capacity of the unconflated pass-through queue used for trade events.
+  constexpr size_t MD_CONFLATOR_MAX_TRADES = 64 * 1024;
+
+  /// Optional stage between a market data adapter (producer thread) and the TradeEngine (consumer thread).
+  /// Book updates are folded into a latest-state slot per ticker / side / price level and flagged in a dirty bitmap,
+  /// the consumer then only sees the net change for each level since it last drained. Trades pass through unconflated.
+  /// Under bursts the engine's backlog is bounded by the number of tracked levels instead of the message rate.
+  ///
+  /// Every update takes the next number of a producer sequence, which a level's state and a trade carry. A drain
+  /// publishes in sequence order: each trade after the levels whose net change was last written before it, and before
+  /// those written after it. A level changed both before and after a trade only exists in its latest state, so the trade
+  /// sees that level as of the previous drain.
+  ///
+  /// Levels are re-published to the engine with compact and stable order-ids (one synthetic order per level), so
+  /// adapters which emit a fresh order-id per level update (Binance) or sparse ones (Zerodha) are normalised as well.
+  class MarketUpdateConflator final {
+  public:
+    explicit MarketUpdateConflator(Common::Logger *logger)
+        : logger_(logger), trades_(MD_CONFLATOR_MAX_TRADES) {
+      drained_levels_.reserve(Common::ME_MAX_TICKERS * MD_CONFLATOR_MAX_LEVELS);
+      for (auto &ticker_levels: levels_) {
+        for (size_t i = 0; i < ticker_levels.free_.size(); ++i)
+          ticker_levels.free_[i] = static_cast<uint16_t>(MD_CONFLATOR_MAX_LEVELS - 1 - i);
+        ticker_levels.num_free_ = MD_CONFLATOR_MAX_LEVELS;
+        ticker_levels.index_.fill(INDEX_EMPTY);
+      }
+    }
+
+    /// Producer side - called from the market data adapter thread for every derived market update.
+    auto onMarketUpdate(const Exchange::MEMarketUpdate &market_update) noexcept -> void {
+      if (UNLIKELY(market_update.ticker_id_ >= Common::ME_MAX_TICKERS))
+        return;
+
+      ++updates_in_;
+      ++seq_;
+      switch (market_update.type_) {
+        case Exchange::MarketUpdateType::ADD:
+        case Exchange::MarketUpdateType::MODIFY:
+          if (market_update.qty_)
+            setLevel(market_update.ticker_id_, market_update.side_, market_update.price_, market_update.qty_);
+          else
+            removeLevel(market_update.ticker_id_, market_update.side_, market_update.price_);
+          break;
+        case Exchange::MarketUpdateType::CANCEL:
+          removeLevel(market_update.ticker_id_, market_update.side_, market_update.price_);
+          break;
+        case Exchange::MarketUpdateType::CLEAR:
+          clearTicker(market_update.ticker_id_);
+          break;
+        case Exchange::MarketUpdateType::TRADE: {
+          auto next_write = trades_.getNextToWriteTo();
+          *next_write = {seq_, market_update};
+          trades_.updateWriteIndex();
+        }
+          break;
+        case Exchange::MarketUpdateType::INVALID:
+        case Exchange::MarketUpdateType::SNAPSHOT_START:
+        case Exchange::MarketUpdateType::SNAPSHOT_END:
+          break;
+      }
+      published_seq_.store(seq_, std::memory_order_release);
+    }
+
+    /// Consumer side - called from the TradeEngine thread. Publishes the net book change for every dirty level and
+    /// all pending trades in sequence order to the callback, which receives a const Exchange::MEMarketUpdate *.
+    /// Updates the producer writes while the drain runs are left for the next one. Returns the number of updates published.
+    template<typename Callback>
+    auto drain(Callback &&callback) noexcept -> size_t {
+      size_t published = 0;
+      const auto drain_seq = published_seq_.load(std::memory_order_acquire);
+
+      drained_levels_.clear();
+      auto dirty_tickers = dirty_tickers_.exchange(0, std::memory_order_acq_rel);
+      while (dirty_tickers) {
+        const auto ticker_id = static_cast<Common::TickerId>(std::countr_zero(dirty_tickers));
+        dirty_tickers &= dirty_tickers - 1;
+
+        auto &ticker_levels = levels_[ticker_id];
+        for (size_t word = 0; word < ticker_levels.dirty_.size(); ++word) {
+          auto dirty_slots = ticker_levels.dirty_[word].exchange(0, std::memory_order_acquire);
+          while (dirty_slots) {
+            const auto slot_index = word * 64 + static_cast<size_t>(std::countr_zero(dirty_slots));
+            dirty_slots &= dirty_slots - 1;
+
+            const auto state = ticker_levels.slots_[slot_index].state_.load(std::memory_order_acquire);
+            if (isBefore(drain_seq & VERSION_MASK, versionOf(state))) {
+              ticker_levels.dirty_[word].fetch_or(1ULL << (slot_index % 64), std::memory_order_release);
+              dirty_tickers_.fetch_or(1ULL << ticker_id, std::memory_order_release);
+              continue;
+            }
+            drained_levels_.push_back({ticker_id, slot_index, state});
+          }
+        }
+      }
+
+      // Levels in the order they were last written, only needed to interleave them with trades.
+      auto trade = trades_.getNextToRead();
+      if (trade && trade->seq_ <= drain_seq) {
+        std::sort(drained_levels_.begin(), drained_levels_.end(), [drain_seq](const auto &lhs, const auto &rhs) {
+          return age(drain_seq & VERSION_MASK, versionOf(lhs.state_)) > age(drain_seq & VERSION_MASK, versionOf(rhs.state_));
+        });
+      }
+
+      size_t next_level = 0;
+      for (; trade && trade->seq_ <= drain_seq; trade = trades_.getNextToRead()) {
+        for (; next_level < drained_levels_.size() && isBefore(versionOf(drained_levels_[next_level].state_), trade->seq_ & VERSION_MASK); ++next_level)
+          published += publishLevel(drained_levels_[next_level], callback);
+        callback(&trade->update_);
+        trades_.updateReadIndex();
+        ++published;
+      }
+      for (; next_level < drained_levels_.size(); ++next_level)
+        published += publishLevel(drained_levels_[next_level], callback);
+
+      return published;
+    }
+
+    /// True if there are level changes or trades the consumer has not drained yet.
+    auto hasPending() const noexcept {
+      return dirty_tickers_.load(std::memory_order_acquire) || trades_.size();
+    }
+
+    /// Number of updates received from the producer - compare against the number published to measure conflation.
+    auto updatesIn() const noexcept {
+      return updates_in_;
+    }
+
+    /// Number of level updates dropped because a ticker ran out of level slots.
+    auto droppedLevels() const noexcept {
+      return dropped_levels_;
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    MarketUpdateConflator() = delete;
+
+    MarketUpdateConflator(const MarketUpdateConflator &) = delete;
+
+    MarketUpdateConflator(const MarketUpdateConflator &&) = delete;
+
+    MarketUpdateConflator &operator=(const MarketUpdateConflator &) = delete;
+
+    MarketUpdateConflator &operator=(const MarketUpdateConflator &&) = delete;
+
+  private:
+    static constexpr uint16_t INDEX_EMPTY = std::numeric_limits<uint16_t>::max();
+    static constexpr size_t INDEX_SIZE = MD_CONFLATOR_MAX_LEVELS * 2;
+
+    /// The published state of a level is packed into one word so it can be read without tearing:
+    /// bits 0-31 quantity, bit 32 live flag, bits 33-63 the low bits of the sequence number of the update which wrote it.
+    static constexpr uint64_t LIVE_BIT = 1ULL << 32;
+    static constexpr int VERSION_SHIFT = 33;
+    static constexpr uint64_t VERSION_MASK = (1ULL << (64 - VERSION_SHIFT)) - 1;
+
+    struct LevelSlot {
+      /// Written by the producer while the slot is not owned by the consumer (see released_version_).
+      Common::Price price_ = Price_INVALID;
+      Common::Side side_ = Common::Side::INVALID;
+
+      std::atomic<uint64_t> state_ = {0};
+
+      /// Version of state_ last seen dead by the consumer - the producer may only recycle the slot once this matches.
+      std::atomic<uint64_t> released_version_ = {0};
+
+      /// Consumer owned - what the engine's book currently holds for this level.
+      bool visible_ = false;
+      Common::Qty visible_qty_ = 0;
+    };
+
+    /// A trade and the sequence number of its update.
+    struct PendingTrade {
+      uint64_t seq_ = 0;
+      Exchange::MEMarketUpdate update_;
+    };
+
+    /// A dirty level and its state as one drain read it.
+    struct DrainedLevel {
+      Common::TickerId ticker_id_;
+      size_t slot_index_;
+      uint64_t state_;
+    };
+
+    struct TickerLevels {
+      std::array<LevelSlot, MD_CONFLATOR_MAX_LEVELS> slots_;
+      std::array<std::atomic<uint64_t>, MD_CONFLATOR_MAX_LEVELS / 64> dirty_ = {};
+
+      /// Producer owned - open addressing index from (side, price) to slot and a stack of free slots.
+      std::array<uint16_t, INDEX_SIZE> index_;
+      std::array<uint16_t, MD_CONFLATOR_MAX_LEVELS> free_;
+      size_t num_free_ = 0;
+    };
+
+    Common::Logger *logger_ = nullptr;
+    std::string time_str_;
+
+    std::array<TickerLevels, Common::ME_MAX_TICKERS> levels_;
+
+    /// One bit per ticker.
+    std::atomic<uint64_t> dirty_tickers_ = {0};
+    static_assert(Common::ME_MAX_TICKERS <= 64, "dirty_tickers_ has one bit per ticker.");
+
+    Common::LFQueue<PendingTrade> trades_;
+
+    /// Producer sequence, and the last sequence number whose update is complete.
+    uint64_t seq_ = 0;
+    std::atomic<uint64_t> published_seq_ = {0};
+
+    /// Consumer owned - the levels of the drain in progress.
+    std::vector<DrainedLevel> drained_levels_;
+
+    /// Producer owned statistics.
+    size_t updates_in_ = 0;
+    size_t dropped_levels_ = 0;
+
+    static auto hashLevel(Common::Side side, Common::Price price) noexcept {
+      return (static_cast<uint64_t>(price) * 2 + (side == Common::Side::BUY)) * 0x9E3779B97F4A7C15ULL >> 55; // 9 bits = INDEX_SIZE.
+    }
+
+    static auto versionOf(uint64_t state) noexcept {
+      return state >> VERSION_SHIFT;
+    }
+
+    /// How many updates before seq the version was written, versions wrap around so only recent ones compare.
+    static auto age(uint64_t seq, uint64_t version) noexcept {
+      return (seq - version) & VERSION_MASK;
+    }
+
+    static auto isBefore(uint64_t version, uint64_t other) noexcept {
+      return version != other && age(other, version) < (VERSION_MASK >> 1);
+    }
+
+    auto findLevel(TickerLevels &ticker_levels, Common::Side side, Common::Price price) const noexcept -> size_t {
+      for (auto pos = hashLevel(side, price) % INDEX_SIZE;; pos = (pos + 1) % INDEX_SIZE) {
+        const auto slot_index = ticker_levels.index_[pos];
+        if (slot_index == INDEX_EMPTY)
+          return pos;
+        const auto &slot = ticker_levels.slots_[slot_index];
+        if (slot.price_ == price && slot.side_ == side)
+          return pos;
+      }
+    }
+
+    /// Backward shift deletion to keep the linear probe chains intact.
+    auto eraseIndex(TickerLevels &ticker_levels, size_t pos) noexcept -> void {
+      ticker_levels.index_[pos] = INDEX_EMPTY;
+      for (auto next = (pos + 1) % INDEX_SIZE; ticker_levels.index_[next] != INDEX_EMPTY; next = (next + 1) % INDEX_SIZE) {
+        const auto &slot = ticker_levels.slots_[ticker_levels.index_[next]];
+        const auto home = hashLevel(slot.side_, slot.price_) % INDEX_SIZE;
+        if ((next > pos && (home <= pos || home > next)) || (next < pos && (home <= pos && home > next))) {
+          ticker_levels.index_[pos] = ticker_levels.index_[next];
+          ticker_levels.index_[next] = INDEX_EMPTY;
+          pos = next;
+        }
+      }
+    }
+
+    /// Recycle dead slots the consumer has already released.
+    auto reclaimLevels(TickerLevels &ticker_levels) noexcept -> void {
+      for (size_t pos = 0; pos < INDEX_SIZE;) {
+        const auto slot_index = ticker_levels.index_[pos];
+        if (slot_index != INDEX_EMPTY) {
+          auto &slot = ticker_levels.slots_[slot_index];
+          const auto state = slot.state_.load(std::memory_order_relaxed);
+          if (!(state & LIVE_BIT) && slot.released_version_.load(std::memory_order_acquire) == versionOf(state)) {
+            eraseIndex(ticker_levels, pos);
+            ticker_levels.free_[ticker_levels.num_free_++] = slot_index;
+            continue; // Re-examine pos, backward shift may have moved another entry into it.
+          }
+        }
+        ++pos;
+      }
+    }
+
+    auto publishState(Common::TickerId ticker_id, size_t slot_index, Common::Qty qty, bool live) noexcept -> void {
+      auto &ticker_levels = levels_[ticker_id];
+      auto &slot = ticker_levels.slots_[slot_index];
+      const auto version = seq_ & VERSION_MASK;
+      slot.state_.store((version << VERSION_SHIFT) | (live ? LIVE_BIT : 0) | qty, std::memory_order_relaxed);
+      ticker_levels.dirty_[slot_index / 64].fetch_or(1ULL << (slot_index % 64), std::memory_order_release);
+      dirty_tickers_.fetch_or(1ULL << ticker_id, std::memory_order_release);
+    }
+
+    auto setLevel(Common::TickerId ticker_id, Common::Side side, Common::Price price, Common::Qty qty) noexcept -> void {
+      auto &ticker_levels = levels_[ticker_id];
+      auto pos = findLevel(ticker_levels, side, price);
+      if (ticker_levels.index_[pos] == INDEX_EMPTY) {
+        if (UNLIKELY(!ticker_levels.num_free_)) {
+          reclaimLevels(ticker_levels);
+          if (UNLIKELY(!ticker_levels.num_free_)) {
+            ++dropped_levels_;
+            logger_->log("%:% %() % ticker:% out of level slots, dropped side:% price:%\n", __FILE__, __LINE__, __FUNCTION__,
+                         Common::getCurrentTimeStr(&time_str_), ticker_id, Common::sideToString(side), Common::priceToString(price));
+            return;
+          }
+          pos = findLevel(ticker_levels, side, price);
+        }
+
+        const auto slot_index = ticker_levels.free_[--ticker_levels.num_free_];
+        auto &slot = ticker_levels.slots_[slot_index];
+        slot.price_ = price;
+        slot.side_ = side;
+        ticker_levels.index_[pos] = slot_index;
+      }
+
+      publishState(ticker_id, ticker_levels.index_[pos], qty, true);
+    }
+
+    auto removeLevel(Common::TickerId ticker_id, Common::Side side, Common::Price price) noexcept -> void {
+      auto &ticker_levels = levels_[ticker_id];
+      const auto pos = findLevel(ticker_levels, side, price);
+      const auto slot_index = ticker_levels.index_[pos];
+      if (slot_index == INDEX_EMPTY || !(ticker_levels.slots_[slot_index].state_.load(std::memory_order_relaxed) & LIVE_BIT))
+        return;
+
+      publishState(ticker_id, slot_index, 0, false);
+    }
+
+    auto clearTicker(Common::TickerId ticker_id) noexcept -> void {
+      auto &ticker_levels = levels_[ticker_id];
+      for (const auto slot_index: ticker_levels.index_) {
+        if (slot_index != INDEX_EMPTY && (ticker_levels.slots_[slot_index].state_.load(std::memory_order_relaxed) & LIVE_BIT))
+          publishState(ticker_id, slot_index, 0, false);
+      }
+    }
+
+    /// Translate the state of a level the drain read into the net ADD / MODIFY / CANCEL the engine's book needs.
+    template<typename Callback>
+    auto publishLevel(const DrainedLevel &level, Callback &callback) noexcept -> size_t {
+      const auto ticker_id = level.ticker_id_;
+      const auto slot_index = level.slot_index_;
+      const auto state = level.state_;
+      auto &slot = levels_[ticker_id].slots_[slot_index];
+      const auto live = static_cast<bool>(state & LIVE_BIT);
+      const auto qty = static_cast<Common::Qty>(state & 0xFFFFFFFFULL);
+
+      Exchange::MEMarketUpdate update;
+      update.ticker_id_ = ticker_id;
+      update.order_id_ = ticker_id * MD_CONFLATOR_MAX_LEVELS + slot_index;
+      update.side_ = slot.side_;
+      update.price_ = slot.price_;
+      update.priority_ = 1;
+
+      size_t published = 0;
+      if (live) {
+        if (!slot.visible_ || slot.visible_qty_ != qty) {
+          update.type_ = (slot.visible_ ? Exchange::MarketUpdateType::MODIFY : Exchange::MarketUpdateType::ADD);
+          update.qty_ = qty;
+          callback(&update);
+          slot.visible_ = true;
+          slot.visible_qty_ = qty;
+          published = 1;
+        }
+      } else {
+        if (slot.visible_) {
+          update.type_ = Exchange::MarketUpdateType::CANCEL;
+          update.qty_ = slot.visible_qty_;
+          callback(&update);
+          slot.visible_ = false;
+          slot.visible_qty_ = 0;
+          published = 1;
+        }
+        slot.released_version_.store(versionOf(state), std::memory_order_release);
+      }
+
+      return published;
+    }
+  };
+}
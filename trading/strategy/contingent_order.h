@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+
+#include "common/types.h"
+
+using namespace Common;
+
+namespace Trading {
+  /// Kinds of parent orders managed by the ContingentOrderManager.
+  enum class ContingentType : int8_t {
+    INVALID = 0,
+    STOP = 1,          // Order sent at the touch once the price crosses the stop level.
+    TRAILING_STOP = 2, // Stop whose level follows favourable price moves at a fixed distance.
+    OCO = 3,           // Exit of an existing position - target limit order and stop, one cancels the other.
+    BRACKET = 4        // Entry limit order which arms an OCO exit for whatever quantity it fills.
+  };
+
+  inline auto contingentTypeToString(ContingentType type) -> std::string {
+    switch (type) {
+      case ContingentType::STOP:
+        return "STOP";
+      case ContingentType::TRAILING_STOP:
+        return "TRAILING_STOP";
+      case ContingentType::OCO:
+        return "OCO";
+      case ContingentType::BRACKET:
+        return "BRACKET";
+      case ContingentType::INVALID:
+        return "INVALID";
+    }
+
+    return "UNKNOWN";
+  }
+
+  /// Life cycle of a parent order.
+  enum class ContingentState : int8_t {
+    INVALID = 0,
+    PENDING_ENTRY = 1, // Bracket entry working, nothing filled yet.
+    ACTIVE = 2,        // Stop armed and / or target working.
+    TRIGGERED = 3,     // Stop fired, exit order working or held until the target and entry are dead.
+    CANCELLING = 4,    // Cancelled by the strategy, waiting for the child orders to die.
+    DONE = 5
+  };
+
+  inline auto contingentStateToString(ContingentState state) -> std::string {
+    switch (state) {
+      case ContingentState::PENDING_ENTRY:
+        return "PENDING_ENTRY";
+      case ContingentState::ACTIVE:
+        return "ACTIVE";
+      case ContingentState::TRIGGERED:
+        return "TRIGGERED";
+      case ContingentState::CANCELLING:
+        return "CANCELLING";
+      case ContingentState::DONE:
+        return "DONE";
+      case ContingentState::INVALID:
+        return "INVALID";
+    }
+
+    return "UNKNOWN";
+  }
+
+  /// Maximum number of parent orders alive at the same time in one ContingentOrderManager.
+  constexpr size_t CONTINGENT_MAX_ORDERS = 1024;
+
+  /// A parent order and the ids of its child orders, which are sent through the OrderManager.
+  struct ContingentOrder {
+    TickerId ticker_id_ = TickerId_INVALID;
+    ContingentType type_ = ContingentType::INVALID;
+    ContingentState state_ = ContingentState::INVALID;
+
+    /// Side of the entry / position for brackets and OCOs, side of the stop order itself for stops.
+    Side side_ = Side::INVALID;
+
+    /// Side of the order sent when the stop fires and of the target order.
+    Side exit_side_ = Side::INVALID;
+
+    Price entry_price_ = Price_INVALID;
+    Price target_price_ = Price_INVALID;
+
+    /// Current stop level, moves with the market for trailing stops.
+    Price stop_price_ = Price_INVALID;
+    Price trail_offset_ = 0;
+
+    /// Quantity of the bracket entry, and quantity still to be exited or to be sent when the stop fires.
+    Qty entry_qty_ = 0;
+    Qty open_qty_ = 0;
+
+    /// Child orders currently working, OrderId_INVALID if none.
+    OrderId entry_order_id_ = OrderId_INVALID;
+    OrderId target_order_id_ = OrderId_INVALID;
+    OrderId exit_order_id_ = OrderId_INVALID;
+
+    /// Whether the stop is in the trigger ladder of its ticker.
+    bool armed_ = false;
+
+    auto hasWorkingOrders() const noexcept {
+      return entry_order_id_ != OrderId_INVALID || target_order_id_ != OrderId_INVALID || exit_order_id_ != OrderId_INVALID;
+    }
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "ContingentOrder" << "["
+         << "tid:" << tickerIdToString(ticker_id_) << " "
+         << "type:" << contingentTypeToString(type_) << " "
+         << "state:" << contingentStateToString(state_) << " "
+         << "side:" << sideToString(side_) << " "
+         << "entry:" << qtyToString(entry_qty_) << "@" << priceToString(entry_price_) << " "
+         << "target:" << priceToString(target_price_) << " "
+         << "stop:" << priceToString(stop_price_) << " "
+         << "trail:" << priceToString(trail_offset_) << " "
+         << "open:" << qtyToString(open_qty_) << " "
+         << "oids:" << orderIdToString(entry_order_id_) << "/" << orderIdToString(target_order_id_) << "/"
+         << orderIdToString(exit_order_id_) << " "
+         << "armed:" << armed_ << "]";
+
+      return ss.str();
+    }
+  };
+
+  /// Stops of one ticker and one stop side, sorted so the next one to fire is always at the back.
+  /// Levels are kept as keys which increase in the direction the stops trail - the price itself for sell stops, which
+  /// fire when the bid falls to the level, and the negated price for buy stops, which fire when the ask rises to it.
+  /// A stop fires once the reference (bid, or negated ask) is at or below its key, so only the back needs checking.
+  struct TriggerLadder {
+    struct Trigger {
+      int64_t key_ = 0;
+      ContingentOrder *order_ = nullptr;
+    };
+
+    std::array<Trigger, CONTINGENT_MAX_ORDERS> triggers_;
+    size_t size_ = 0;
+
+    /// Keys are sign_ * stop level, sign_ is +1 for sell stops and -1 for buy stops.
+    int64_t sign_ = 1;
+
+    /// Number of trailing stops in the ladder and the best reference they have all been trailed to.
+    size_t num_trailing_ = 0;
+    int64_t trail_reference_ = 0;
+
+    auto empty() const noexcept {
+      return !size_;
+    }
+
+    auto back() const noexcept -> const Trigger & {
+      return triggers_[size_ - 1];
+    }
+
+    auto popBack() noexcept {
+      auto order = triggers_[--size_].order_;
+      num_trailing_ -= (order->trail_offset_ != 0);
+      return order;
+    }
+
+    /// Insertion into the sorted array - at most CONTINGENT_MAX_ORDERS moves and never on the trigger path.
+    /// A trailing stop has only been trailed up to the current reference, so the ladder's trail reference is lowered.
+    auto insert(ContingentOrder *order, int64_t reference) noexcept {
+      const auto key = sign_ * order->stop_price_;
+      size_t i = size_++;
+      for (; i && triggers_[i - 1].key_ > key; --i)
+        triggers_[i] = triggers_[i - 1];
+      triggers_[i] = {key, order};
+
+      if (order->trail_offset_) {
+        trail_reference_ = (num_trailing_ ? std::min(trail_reference_, reference) : reference);
+        ++num_trailing_;
+      }
+    }
+
+    auto erase(const ContingentOrder *order) noexcept {
+      for (size_t i = 0; i < size_; ++i) {
+        if (triggers_[i].order_ == order) {
+          num_trailing_ -= (order->trail_offset_ != 0);
+          for (--size_; i < size_; ++i)
+            triggers_[i] = triggers_[i + 1];
+          return;
+        }
+      }
+    }
+
+    /// Trail every trailing stop to the new reference, only needed when the reference improved on all previous ones.
+    /// Keys only ever increase here, so a single insertion sort pass restores the order.
+    auto trail(int64_t reference) noexcept -> bool {
+      if (!num_trailing_ || reference <= trail_reference_)
+        return false;
+
+      trail_reference_ = reference;
+      for (size_t i = 0; i < size_; ++i) {
+        auto &trigger = triggers_[i];
+        if (trigger.order_->trail_offset_) {
+          trigger.key_ = std::max(trigger.key_, reference - trigger.order_->trail_offset_);
+          trigger.order_->stop_price_ = sign_ * trigger.key_;
+        }
+      }
+      for (size_t i = 1; i < size_; ++i) {
+        const auto trigger = triggers_[i];
+        size_t j = i;
+        for (; j && triggers_[j - 1].key_ > trigger.key_; --j)
+          triggers_[j] = triggers_[j - 1];
+        triggers_[j] = trigger;
+      }
+      return true;
+    }
+  };
+}
@@ -0,0 +1,247 @@
+#include "contingent_order_manager.h"
+
+#include <limits>
+
+namespace Trading {
+  ContingentOrderManager::ContingentOrderManager(Common::Logger *logger, OrderManager *order_manager)
+      : logger_(logger), order_manager_(order_manager), order_pool_(CONTINGENT_MAX_ORDERS),
+        order_id_to_order_(new std::array<ContingentOrder *, ME_MAX_ORDER_IDS>()) {
+    order_id_to_order_->fill(nullptr);
+    for (auto &ladders : ticker_ladders_) {
+      ladders[0].sign_ = 1;
+      ladders[1].sign_ = -1;
+    }
+    for (auto &references : last_reference_)
+      references.fill(std::numeric_limits<int64_t>::min());
+  }
+
+  ContingentOrderManager::~ContingentOrderManager() {
+    delete order_id_to_order_;
+    order_id_to_order_ = nullptr;
+  }
+
+  auto ContingentOrderManager::newStop(TickerId ticker_id, Side side, Price stop_price, Qty qty, Price trail_offset) noexcept -> ContingentOrder * {
+    auto order = allocate(ticker_id, trail_offset ? ContingentType::TRAILING_STOP : ContingentType::STOP, side, side);
+    order->stop_price_ = stop_price;
+    order->trail_offset_ = trail_offset;
+    order->open_qty_ = qty;
+    order->state_ = ContingentState::ACTIVE;
+    arm(order);
+    return order;
+  }
+
+  auto ContingentOrderManager::newOco(TickerId ticker_id, Side position_side, Qty qty, Price target_price, Price stop_price,
+                                      Price trail_offset) noexcept -> ContingentOrder * {
+    auto order = allocate(ticker_id, ContingentType::OCO, position_side,
+                          position_side == Side::BUY ? Side::SELL : Side::BUY);
+    order->target_price_ = target_price;
+    order->stop_price_ = stop_price;
+    order->trail_offset_ = trail_offset;
+    order->open_qty_ = qty;
+    order->state_ = ContingentState::ACTIVE;
+    syncTarget(order);
+    arm(order);
+    return order;
+  }
+
+  auto ContingentOrderManager::newBracket(TickerId ticker_id, Side side, Price entry_price, Qty qty, Price target_price,
+                                          Price stop_price, Price trail_offset) noexcept -> ContingentOrder * {
+    auto order = allocate(ticker_id, ContingentType::BRACKET, side, side == Side::BUY ? Side::SELL : Side::BUY);
+    order->entry_price_ = entry_price;
+    order->entry_qty_ = qty;
+    order->target_price_ = target_price;
+    order->stop_price_ = stop_price;
+    order->trail_offset_ = trail_offset;
+    order->state_ = ContingentState::PENDING_ENTRY;
+
+    order->entry_order_id_ = sendChild(order, entry_price, side, qty);
+    if (UNLIKELY(order->entry_order_id_ == OrderId_INVALID)) {
+      order->state_ = ContingentState::DONE;
+      tryRelease(order);
+      return nullptr;
+    }
+    return order;
+  }
+
+  auto ContingentOrderManager::cancel(ContingentOrder *order) noexcept -> void {
+    logger_->log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 order->toString().c_str());
+
+    disarm(order);
+    cancelChild(order->entry_order_id_);
+    cancelChild(order->target_order_id_);
+    order->state_ = ContingentState::CANCELLING;
+    tryRelease(order);
+  }
+
+  auto ContingentOrderManager::onOrderUpdate(const Exchange::MEClientResponse *client_response) noexcept -> void {
+    auto order = getOrder(client_response->order_id_);
+    if (!order)
+      return;
+
+    const auto order_id = client_response->order_id_;
+    const auto is_fill = (client_response->type_ == Exchange::ClientResponseType::FILLED ||
+                          client_response->type_ == Exchange::ClientResponseType::PARTIALLY_FILLED);
+    const auto is_dead = (client_response->type_ == Exchange::ClientResponseType::CANCELED ||
+                          client_response->type_ == Exchange::ClientResponseType::REJECTED ||
+                          (is_fill && !client_response->leaves_qty_));
+
+    if (order_id == order->entry_order_id_) {
+      if (is_fill && order->state_ != ContingentState::CANCELLING) {
+        // Protect whatever has been filled so far.
+        order->open_qty_ += client_response->exec_qty_;
+        if (order->state_ == ContingentState::PENDING_ENTRY)
+          order->state_ = ContingentState::ACTIVE;
+      }
+      if (is_dead)
+        clearChild(order->entry_order_id_);
+      if (is_fill && order->state_ == ContingentState::ACTIVE) {
+        syncTarget(order);
+        if (!order->armed_)
+          arm(order);
+      }
+    } else if (order_id == order->target_order_id_) {
+      if (is_fill)
+        order->open_qty_ -= std::min(client_response->exec_qty_, order->open_qty_);
+      if (is_dead)
+        clearChild(order->target_order_id_);
+      else if (client_response->type_ == Exchange::ClientResponseType::ACCEPTED)
+        syncTarget(order);
+
+      // Target done, the other side of the OCO goes with it.
+      if (!order->open_qty_ && order->entry_order_id_ == OrderId_INVALID && order->state_ == ContingentState::ACTIVE) {
+        disarm(order);
+        order->state_ = ContingentState::DONE;
+      }
+    } else if (order_id == order->exit_order_id_) {
+      if (is_fill)
+        order->open_qty_ -= std::min(client_response->exec_qty_, order->open_qty_);
+      if (is_dead) {
+        clearChild(order->exit_order_id_);
+        // Exit did not go through completely, keep the stop armed so it fires again on the next update, and put back
+        // the target fire() cancelled unless the stop fired again straight away.
+        order->state_ = order->open_qty_ ? ContingentState::ACTIVE : ContingentState::DONE;
+        if (order->open_qty_)
+          arm(order);
+        if (order->state_ == ContingentState::ACTIVE)
+          syncTarget(order);
+      }
+    }
+
+    if (order->state_ == ContingentState::PENDING_ENTRY && order->entry_order_id_ == OrderId_INVALID)
+      order->state_ = ContingentState::DONE;
+
+    if (order->state_ == ContingentState::TRIGGERED && order->open_qty_ && !order->hasWorkingOrders())
+      sendHeldExit(order);
+
+    tryRelease(order);
+  }
+
+  auto ContingentOrderManager::allocate(TickerId ticker_id, ContingentType type, Side side, Side exit_side) noexcept -> ContingentOrder * {
+    auto order = order_pool_.allocate();
+    order->ticker_id_ = ticker_id;
+    order->type_ = type;
+    order->side_ = side;
+    order->exit_side_ = exit_side;
+    return order;
+  }
+
+  auto ContingentOrderManager::sendChild(ContingentOrder *order, Price price, Side side, Qty qty) noexcept -> OrderId {
+    // Not a layer, so moveOrders() / moveLayers() of the strategy on the same ticker leave it alone.
+    auto om_order = order_manager_->newOrder(order->ticker_id_, price, side, qty, false);
+    if (UNLIKELY(!om_order))
+      return OrderId_INVALID;
+    order_id_to_order_->at(om_order->order_id_ % ME_MAX_ORDER_IDS) = order;
+    return om_order->order_id_;
+  }
+
+  auto ContingentOrderManager::cancelChild(OrderId order_id) noexcept -> void {
+    if (order_id == OrderId_INVALID)
+      return;
+    auto om_order = order_manager_->getOrder(order_id);
+    if (om_order && om_order->order_state_ != OMOrderState::PENDING_CANCEL)
+      order_manager_->cancelOrder(om_order);
+  }
+
+  auto ContingentOrderManager::arm(ContingentOrder *order) noexcept -> void {
+    if (order->stop_price_ == Price_INVALID)
+      return;
+
+    auto &ladder = ticker_ladders_.at(order->ticker_id_).at(order->exit_side_ == Side::BUY);
+    const auto reference = last_reference_.at(order->ticker_id_).at(order->exit_side_ == Side::BUY);
+    order->armed_ = true;
+    ladder.insert(order, reference);
+
+    // Already through the level, no need to wait for the next update.
+    if (reference != std::numeric_limits<int64_t>::min() && reference <= ladder.back().key_)
+      checkLadder(order->ticker_id_, ladder, reference);
+  }
+
+  auto ContingentOrderManager::disarm(ContingentOrder *order) noexcept -> void {
+    if (!order->armed_)
+      return;
+    ticker_ladders_.at(order->ticker_id_).at(order->exit_side_ == Side::BUY).erase(order);
+    order->armed_ = false;
+  }
+
+  auto ContingentOrderManager::fire(ContingentOrder *order, Price touch_price) noexcept -> bool {
+    logger_->log("%:% %() % touch:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 priceToString(touch_price), order->toString().c_str());
+
+    // With a target or entry still working the exit waits for them to die, a target fill racing its cancel would
+    // otherwise execute on top of the exit and flip the position.
+    if (!order->hasWorkingOrders()) {
+      order->exit_order_id_ = sendChild(order, touch_price, order->exit_side_, order->open_qty_);
+      if (UNLIKELY(order->exit_order_id_ == OrderId_INVALID))
+        return false;
+    }
+
+    order->armed_ = false;
+    order->state_ = ContingentState::TRIGGERED;
+    cancelChild(order->entry_order_id_);
+    cancelChild(order->target_order_id_);
+    return true;
+  }
+
+  auto ContingentOrderManager::sendHeldExit(ContingentOrder *order) noexcept -> void {
+    const auto stop_side = (order->exit_side_ == Side::BUY);
+    const auto touch_price = ticker_ladders_.at(order->ticker_id_).at(stop_side).sign_ *
+                             last_reference_.at(order->ticker_id_).at(stop_side);
+    logger_->log("%:% %() % touch:% %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 priceToString(touch_price), order->toString().c_str());
+
+    order->exit_order_id_ = sendChild(order, touch_price, order->exit_side_, order->open_qty_);
+    if (UNLIKELY(order->exit_order_id_ == OrderId_INVALID)) {
+      // Refused by the risk checks, back in the ladder to fire again on the next update.
+      order->state_ = ContingentState::ACTIVE;
+      arm(order);
+    }
+  }
+
+  auto ContingentOrderManager::syncTarget(ContingentOrder *order) noexcept -> void {
+    if (order->target_price_ == Price_INVALID || !order->open_qty_)
+      return;
+
+    if (order->target_order_id_ == OrderId_INVALID) {
+      order->target_order_id_ = sendChild(order, order->target_price_, order->exit_side_, order->open_qty_);
+      return;
+    }
+
+    auto om_order = order_manager_->getOrder(order->target_order_id_);
+    if (om_order && om_order->order_state_ == OMOrderState::LIVE && om_order->qty_ != order->open_qty_)
+      order_manager_->modifyOrder(om_order, order->target_price_, order->open_qty_);
+  }
+
+  auto ContingentOrderManager::tryRelease(ContingentOrder *order) noexcept -> void {
+    const auto finished = (order->state_ == ContingentState::DONE || order->state_ == ContingentState::CANCELLING ||
+                           (order->state_ == ContingentState::TRIGGERED && !order->open_qty_));
+    if (!finished || order->hasWorkingOrders())
+      return;
+
+    logger_->log("%:% %() % Done %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                 order->toString().c_str());
+    disarm(order);
+    order->state_ = ContingentState::DONE;
+    order_pool_.deallocate(order);
+  }
+}
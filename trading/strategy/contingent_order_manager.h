@@ -0,0 +1,136 @@
+#pragma once
+
+#include "common/macros.h"
+#include "common/logging.h"
+#include "common/mem_pool.h"
+
+#include "exchange/order_server/client_response.h"
+
+#include "contingent_order.h"
+#include "market_order.h"
+#include "order_manager.h"
+
+using namespace Common;
+
+namespace Trading {
+  /// Parent / child order facility - stops, trailing stops, OCO exits and brackets on top of the OrderManager.
+  /// Stops are held locally in per ticker trigger ladders and evaluated on every book update, checking only the next
+  /// stop to fire on each side, so an exit is sent on the same update that crosses its level. Parent orders come from a
+  /// pool and child orders are found by OrderId, nothing allocates or locks after construction. Driven from the trading
+  /// thread only, through onOrderBookUpdate() and onOrderUpdate().
+  class ContingentOrderManager {
+  public:
+    ContingentOrderManager(Common::Logger *logger, OrderManager *order_manager);
+
+    ~ContingentOrderManager();
+
+    /// Stop order of the specified side which sends qty at the touch once the market trades through stop_price.
+    /// A non zero trail_offset makes it a trailing stop, which keeps its level trail_offset away from the best price seen.
+    auto newStop(TickerId ticker_id, Side side, Price stop_price, Qty qty, Price trail_offset = 0) noexcept -> ContingentOrder *;
+
+    /// Exit of an existing position of position_side - a target limit order and a (trailing) stop, one cancels the other.
+    auto newOco(TickerId ticker_id, Side position_side, Qty qty, Price target_price, Price stop_price,
+                Price trail_offset = 0) noexcept -> ContingentOrder *;
+
+    /// Entry limit order which arms an OCO exit for the quantity it fills, as it fills.
+    auto newBracket(TickerId ticker_id, Side side, Price entry_price, Qty qty, Price target_price, Price stop_price,
+                    Price trail_offset = 0) noexcept -> ContingentOrder *;
+
+    /// Disarm the stop and cancel all child orders, the parent is released once none of them is working any more.
+    auto cancel(ContingentOrder *order) noexcept -> void;
+
+    /// Trail and fire the stops of this ticker against the new top of book.
+    auto onOrderBookUpdate(TickerId ticker_id, const BBO *bbo) noexcept -> void {
+      auto &ladders = ticker_ladders_.at(ticker_id);
+      if (LIKELY(bbo->bid_price_ != Price_INVALID))
+        checkLadder(ticker_id, ladders[0], bbo->bid_price_);
+      if (LIKELY(bbo->ask_price_ != Price_INVALID))
+        checkLadder(ticker_id, ladders[1], -bbo->ask_price_);
+    }
+
+    /// Advance the parent order of the child order this response is for, if any.
+    auto onOrderUpdate(const Exchange::MEClientResponse *client_response) noexcept -> void;
+
+    /// Parent order of the specified child OrderId, nullptr if there is none.
+    auto getOrder(OrderId order_id) const noexcept -> ContingentOrder * {
+      auto order = order_id_to_order_->at(order_id % ME_MAX_ORDER_IDS);
+      return (order && (order->entry_order_id_ == order_id || order->target_order_id_ == order_id ||
+                        order->exit_order_id_ == order_id)) ? order : nullptr;
+    }
+
+    /// Number of stops waiting for their level on the specified ticker and stop side.
+    auto numArmed(TickerId ticker_id, Side stop_side) const noexcept {
+      return ticker_ladders_.at(ticker_id).at(stop_side == Side::BUY).size_;
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    ContingentOrderManager() = delete;
+
+    ContingentOrderManager(const ContingentOrderManager &) = delete;
+
+    ContingentOrderManager(const ContingentOrderManager &&) = delete;
+
+    ContingentOrderManager &operator=(const ContingentOrderManager &) = delete;
+
+    ContingentOrderManager &operator=(const ContingentOrderManager &&) = delete;
+
+  private:
+    /// Fire every stop whose level the reference went through, after trailing the trailing stops to it.
+    auto checkLadder(TickerId ticker_id, TriggerLadder &ladder, int64_t reference) noexcept -> void {
+      last_reference_.at(ticker_id).at(ladder.sign_ < 0) = reference;
+      if (ladder.empty())
+        return;
+      ladder.trail(reference);
+      // A stop refused by the risk checks stays at the back and is retried on the next update.
+      while (!ladder.empty() && reference <= ladder.back().key_ && fire(ladder.back().order_, ladder.sign_ * reference))
+        ladder.popBack();
+    }
+
+    auto allocate(TickerId ticker_id, ContingentType type, Side side, Side exit_side) noexcept -> ContingentOrder *;
+
+    /// Send a child order and index the parent by its OrderId, returns OrderId_INVALID if the OrderManager refused it.
+    auto sendChild(ContingentOrder *order, Price price, Side side, Qty qty) noexcept -> OrderId;
+
+    auto cancelChild(OrderId order_id) noexcept -> void;
+
+    /// Child order is dead, the parent is no longer reachable through its OrderId.
+    auto clearChild(OrderId &order_id) noexcept -> void {
+      order_id_to_order_->at(order_id % ME_MAX_ORDER_IDS) = nullptr;
+      order_id = OrderId_INVALID;
+    }
+
+    auto arm(ContingentOrder *order) noexcept -> void;
+
+    auto disarm(ContingentOrder *order) noexcept -> void;
+
+    /// Stop level was crossed - cancel the target and any remaining entry and send the open quantity at the touch, or
+    /// hold the exit until they are dead if either is working. Returns false if the exit was refused by the risk checks.
+    auto fire(ContingentOrder *order, Price touch_price) noexcept -> bool;
+
+    /// Send the exit held by fire() at the current touch for what is still open once no other child order is working.
+    auto sendHeldExit(ContingentOrder *order) noexcept -> void;
+
+    /// Keep the target order quantity equal to the open quantity.
+    auto syncTarget(ContingentOrder *order) noexcept -> void;
+
+    /// Release the parent once it has nothing left to do and none of its child orders is working.
+    auto tryRelease(ContingentOrder *order) noexcept -> void;
+
+    std::string time_str_;
+    Common::Logger *logger_ = nullptr;
+
+    OrderManager *order_manager_ = nullptr;
+
+    /// Pool of parent orders.
+    MemPool<ContingentOrder> order_pool_;
+
+    /// Hash map container from child OrderId -> parent order.
+    std::array<ContingentOrder *, ME_MAX_ORDER_IDS> *order_id_to_order_ = nullptr;
+
+    /// Hash map container from TickerId -> sell stops, buy stops.
+    std::array<std::array<TriggerLadder, 2>, ME_MAX_TICKERS> ticker_ladders_;
+
+    /// Last reference checked against each ladder, the starting point of newly armed trailing stops.
+    std::array<std::array<int64_t, 2>, ME_MAX_TICKERS> last_reference_ = {};
+  };
+}
@@ -2,49 +2,70 @@
 
 #include "common/macros.h"
 #include "common/logging.h"
+#include "common/time_utils.h"
+
+#include "rolling_features.h"
+#include "feature_store.h"
 
 using namespace Common;
 
 namespace Trading {
-  /// Sentinel value to represent invalid / uninitialized feature value.
-  constexpr auto Feature_INVALID = std::numeric_limits<double>::quiet_NaN();
-
   class FeatureEngine {
   public:
     FeatureEngine(Common::Logger *logger)
         : logger_(logger) {
     }
 
-    /// Process a change in order book and in this case compute the fair market price.
+    /// Process a change in order book and update the top of book driven features for this ticker, including the fair market price.
     auto onOrderBookUpdate(TickerId ticker_id, Price price, Side side, MarketOrderBook* book) noexcept -> void {
       const auto bbo = book->getBBO();
+      auto &features = ticker_features_.at(ticker_id);
       if(LIKELY(bbo->bid_price_ != Price_INVALID && bbo->ask_price_ != Price_INVALID)) {
-        mkt_price_ = (bbo->bid_price_ * bbo->ask_qty_ + bbo->ask_price_ * bbo->bid_qty_) / static_cast<double>(bbo->bid_qty_ + bbo->ask_qty_);
+        features.onQuote(getCurrentNanos(), bbo->bid_price_, bbo->bid_qty_, bbo->ask_price_, bbo->ask_qty_);
+        feature_store_.onBBO(ticker_id, bbo->bid_price_, bbo->bid_qty_, bbo->ask_price_, bbo->ask_qty_);
       }
 
       logger_->log("%:% %() % ticker:% price:% side:% mkt-price:% agg-trade-ratio:%\n", __FILE__, __LINE__, __FUNCTION__,
                    Common::getCurrentTimeStr(&time_str_), ticker_id, Common::priceToString(price).c_str(),
-                   Common::sideToString(side).c_str(), mkt_price_, agg_trade_qty_ratio_);
+                   Common::sideToString(side).c_str(), features.mktPrice(), features.aggTradeQtyRatio());
     }
 
-    /// Process a trade event and in this case compute the feature to capture aggressive trade quantity ratio against the BBO quantity.
-    auto onTradeUpdate(const Exchange::MEMarketUpdate *market_update, MarketOrderBook* book) noexcept -> void {
-      const auto bbo = book->getBBO();
-      if(LIKELY(bbo->bid_price_ != Price_INVALID && bbo->ask_price_ != Price_INVALID)) {
-        agg_trade_qty_ratio_ = static_cast<double>(market_update->qty_) / (market_update->side_ == Side::BUY ? bbo->ask_qty_ : bbo->bid_qty_);
-      }
+    /// Process a trade event and update the trade driven features for this ticker, including the aggressive trade quantity ratio against the BBO quantity.
+    auto onTradeUpdate(const Exchange::MEMarketUpdate *market_update, MarketOrderBook*) noexcept -> void {
+      auto &features = ticker_features_.at(market_update->ticker_id_);
+      features.onTrade(getCurrentNanos(), market_update->side_, market_update->price_, market_update->qty_);
 
       logger_->log("%:% %() % % mkt-price:% agg-trade-ratio:%\n", __FILE__, __LINE__, __FUNCTION__,
                    Common::getCurrentTimeStr(&time_str_),
-                   market_update->toString().c_str(), mkt_price_, agg_trade_qty_ratio_);
+                   market_update->toString().c_str(), features.mktPrice(), features.aggTradeQtyRatio());
+    }
+
+    auto getMktPrice(TickerId ticker_id) const noexcept {
+      return ticker_features_.at(ticker_id).mktPrice();
     }
 
-    auto getMktPrice() const noexcept {
-      return mkt_price_;
+    auto getAggTradeQtyRatio(TickerId ticker_id) const noexcept {
+      return ticker_features_.at(ticker_id).aggTradeQtyRatio();
     }
 
-    auto getAggTradeQtyRatio() const noexcept {
-      return agg_trade_qty_ratio_;
+    /// All the rolling features maintained for this ticker.
+    auto getTickerFeatures(TickerId ticker_id) const noexcept -> const TickerFeatures & {
+      return ticker_features_.at(ticker_id);
+    }
+
+    /// Recompute the batched cross-sectional features for all tickers whose book changed - called once per trade engine loop iteration.
+    auto computeBatchFeatures() noexcept -> void {
+      feature_store_.compute();
+    }
+
+    /// Batched microprice, imbalance and z-scores for the whole ticker universe, as of the last computeBatchFeatures().
+    auto getFeatureStore() const noexcept -> const FeatureStore & {
+      return feature_store_;
+    }
+
+    /// Override the default windows and half lives for a ticker.
+    auto configure(TickerId ticker_id, const FeatureCfg &cfg) noexcept -> void {
+      ticker_features_.at(ticker_id).configure(cfg);
     }
 
     /// Deleted default, copy & move constructors and assignment-operators.
@@ -62,7 +83,10 @@ namespace Trading {
     std::string time_str_;
     Common::Logger *logger_ = nullptr;
 
-    /// The two features we compute in our feature engine.
-    double mkt_price_ = Feature_INVALID, agg_trade_qty_ratio_ = Feature_INVALID;
+    /// Hash map container from TickerId -> rolling features for that ticker.
+    std::array<TickerFeatures, ME_MAX_TICKERS> ticker_features_;
+
+    /// Structure-of-arrays store for the features computed in one pass across all tickers.
+    FeatureStore feature_store_;
   };
 }
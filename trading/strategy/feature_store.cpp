@@ -0,0 +1,153 @@
+#include "feature_store.h"
+
+#include <bit>
+#include <immintrin.h>
+
+namespace Trading {
+  FeatureStore::FeatureStore(double ewma_half_life) noexcept
+      : alpha_(1.0 - std::exp(-std::numbers::ln2 / std::max(ewma_half_life, 1.0))) {
+    setKernel(Kernel::AVX512);
+  }
+
+  auto FeatureStore::setKernel(Kernel kernel) noexcept -> void {
+    __builtin_cpu_init();
+    if (kernel == Kernel::AVX512 && !__builtin_cpu_supports("avx512f"))
+      kernel = Kernel::AVX2;
+    if (kernel == Kernel::AVX2 && !__builtin_cpu_supports("avx2"))
+      kernel = Kernel::SCALAR;
+    kernel_ = kernel;
+  }
+
+  auto FeatureStore::compute() noexcept -> void {
+    if (!dirty_)
+      return;
+
+    switch (kernel_) {
+      case Kernel::AVX512:
+        computeAvx512();
+        break;
+      case Kernel::AVX2:
+        computeAvx2();
+        break;
+      case Kernel::SCALAR:
+        computeScalar();
+        break;
+    }
+    dirty_ = 0;
+
+    // Cross-sectional imbalance statistics over all tickers with a valid book - at most ME_MAX_TICKERS values.
+    size_t n = 0;
+    double sum = 0, sum_squares = 0;
+    for (auto valid = valid_; valid; valid &= valid - 1) {
+      const auto i = std::countr_zero(valid);
+      sum += imbalance_[i];
+      sum_squares += imbalance_[i] * imbalance_[i];
+      ++n;
+    }
+    const auto mean = sum / static_cast<double>(n);
+    const auto std_dev = std::sqrt(std::max(sum_squares / static_cast<double>(n) - mean * mean, 0.0));
+    for (auto valid = valid_; valid; valid &= valid - 1) {
+      const auto i = std::countr_zero(valid);
+      imbalance_zscore_[i] = (std_dev > 0 ? (imbalance_[i] - mean) / std_dev : 0);
+    }
+  }
+
+  auto FeatureStore::computeScalar() noexcept -> void {
+    for (auto dirty = dirty_; dirty; dirty &= dirty - 1) {
+      const auto i = std::countr_zero(dirty);
+      const auto qty = bid_qty_[i] + ask_qty_[i];
+      microprice_[i] = (bid_price_[i] * ask_qty_[i] + ask_price_[i] * bid_qty_[i]) / qty;
+      imbalance_[i] = (bid_qty_[i] - ask_qty_[i]) / qty;
+      spread_[i] = ask_price_[i] - bid_price_[i];
+
+      const auto mid = (bid_price_[i] + ask_price_[i]) * 0.5;
+      const auto delta = mid - mid_mean_[i];
+      mid_mean_[i] += alpha_ * delta;
+      mid_variance_[i] = (1 - alpha_) * (mid_variance_[i] + alpha_ * delta * delta);
+      mid_zscore_[i] = (mid_variance_[i] > 0 ? (microprice_[i] - mid_mean_[i]) / std::sqrt(mid_variance_[i]) : 0);
+    }
+  }
+
+  __attribute__((target("avx2")))
+  auto FeatureStore::computeAvx2() noexcept -> void {
+    const auto lane_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+    const auto half = _mm256_set1_pd(0.5);
+    const auto zero = _mm256_setzero_pd();
+    const auto alpha = _mm256_set1_pd(alpha_);
+    const auto one_minus_alpha = _mm256_set1_pd(1 - alpha_);
+
+    for (size_t b = 0; b < FEATURE_STORE_LANES; b += 4) {
+      const auto bits = static_cast<int64_t>((dirty_ >> b) & 0xF);
+      if (!bits)
+        continue;
+      // Expand the 4 dirty bits into a lane mask to blend the new values with the old ones.
+      const auto mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), lane_bits), lane_bits));
+
+      const auto bid_price = _mm256_load_pd(&bid_price_[b]);
+      const auto ask_price = _mm256_load_pd(&ask_price_[b]);
+      const auto bid_qty = _mm256_load_pd(&bid_qty_[b]);
+      const auto ask_qty = _mm256_load_pd(&ask_qty_[b]);
+      const auto qty = _mm256_add_pd(bid_qty, ask_qty);
+
+      const auto microprice = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(bid_price, ask_qty), _mm256_mul_pd(ask_price, bid_qty)), qty);
+      const auto imbalance = _mm256_div_pd(_mm256_sub_pd(bid_qty, ask_qty), qty);
+      const auto spread = _mm256_sub_pd(ask_price, bid_price);
+
+      const auto old_mean = _mm256_load_pd(&mid_mean_[b]);
+      const auto old_variance = _mm256_load_pd(&mid_variance_[b]);
+      const auto mid = _mm256_mul_pd(_mm256_add_pd(bid_price, ask_price), half);
+      const auto delta = _mm256_sub_pd(mid, old_mean);
+      const auto mean = _mm256_add_pd(old_mean, _mm256_mul_pd(alpha, delta));
+      const auto variance = _mm256_mul_pd(one_minus_alpha, _mm256_add_pd(old_variance, _mm256_mul_pd(alpha, _mm256_mul_pd(delta, delta))));
+      const auto positive = _mm256_cmp_pd(variance, zero, _CMP_GT_OQ);
+      const auto zscore = _mm256_and_pd(positive, _mm256_div_pd(_mm256_sub_pd(microprice, mean), _mm256_sqrt_pd(variance)));
+
+      _mm256_store_pd(&microprice_[b], _mm256_blendv_pd(_mm256_load_pd(&microprice_[b]), microprice, mask));
+      _mm256_store_pd(&imbalance_[b], _mm256_blendv_pd(_mm256_load_pd(&imbalance_[b]), imbalance, mask));
+      _mm256_store_pd(&spread_[b], _mm256_blendv_pd(_mm256_load_pd(&spread_[b]), spread, mask));
+      _mm256_store_pd(&mid_mean_[b], _mm256_blendv_pd(old_mean, mean, mask));
+      _mm256_store_pd(&mid_variance_[b], _mm256_blendv_pd(old_variance, variance, mask));
+      _mm256_store_pd(&mid_zscore_[b], _mm256_blendv_pd(_mm256_load_pd(&mid_zscore_[b]), zscore, mask));
+    }
+  }
+
+  __attribute__((target("avx512f")))
+  auto FeatureStore::computeAvx512() noexcept -> void {
+    const auto half = _mm512_set1_pd(0.5);
+    const auto zero = _mm512_setzero_pd();
+    const auto alpha = _mm512_set1_pd(alpha_);
+    const auto one_minus_alpha = _mm512_set1_pd(1 - alpha_);
+
+    for (size_t b = 0; b < FEATURE_STORE_LANES; b += 8) {
+      const auto mask = static_cast<__mmask8>((dirty_ >> b) & 0xFF);
+      if (!mask)
+        continue;
+
+      const auto bid_price = _mm512_load_pd(&bid_price_[b]);
+      const auto ask_price = _mm512_load_pd(&ask_price_[b]);
+      const auto bid_qty = _mm512_load_pd(&bid_qty_[b]);
+      const auto ask_qty = _mm512_load_pd(&ask_qty_[b]);
+      const auto qty = _mm512_add_pd(bid_qty, ask_qty);
+
+      const auto microprice = _mm512_maskz_div_pd(mask, _mm512_add_pd(_mm512_mul_pd(bid_price, ask_qty), _mm512_mul_pd(ask_price, bid_qty)), qty);
+      const auto imbalance = _mm512_maskz_div_pd(mask, _mm512_sub_pd(bid_qty, ask_qty), qty);
+      const auto spread = _mm512_sub_pd(ask_price, bid_price);
+
+      const auto old_mean = _mm512_load_pd(&mid_mean_[b]);
+      const auto mid = _mm512_mul_pd(_mm512_add_pd(bid_price, ask_price), half);
+      const auto delta = _mm512_sub_pd(mid, old_mean);
+      const auto mean = _mm512_add_pd(old_mean, _mm512_mul_pd(alpha, delta));
+      const auto variance = _mm512_mul_pd(one_minus_alpha,
+                                          _mm512_add_pd(_mm512_load_pd(&mid_variance_[b]), _mm512_mul_pd(alpha, _mm512_mul_pd(delta, delta))));
+      const auto positive = _mm512_mask_cmp_pd_mask(mask, variance, zero, _CMP_GT_OQ);
+      const auto zscore = _mm512_maskz_div_pd(positive, _mm512_sub_pd(microprice, mean), _mm512_maskz_sqrt_pd(positive, variance));
+
+      _mm512_mask_store_pd(&microprice_[b], mask, microprice);
+      _mm512_mask_store_pd(&imbalance_[b], mask, imbalance);
+      _mm512_mask_store_pd(&spread_[b], mask, spread);
+      _mm512_mask_store_pd(&mid_mean_[b], mask, mean);
+      _mm512_mask_store_pd(&mid_variance_[b], mask, variance);
+      _mm512_mask_store_pd(&mid_zscore_[b], mask, zscore);
+    }
+  }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+
+#include "common/macros.h"
+#include "common/types.h"
+
+#include "rolling_features.h"
+
+namespace Trading {
+  /// Number of lanes in the feature store - ME_MAX_TICKERS rounded up to a full AVX-512 register of doubles.
+  constexpr size_t FEATURE_STORE_LANES = (Common::ME_MAX_TICKERS + 7) / 8 * 8;
+
+  static_assert(Common::ME_MAX_TICKERS <= 64, "FeatureStore tracks dirty tickers in a 64-bit mask.");
+
+  /// Structure-of-arrays store of top of book derived features for the whole ticker universe.
+  /// Book updates only scatter the new BBO into the input arrays and flag the ticker dirty, compute() then recalculates
+  /// microprice, imbalance, spread and the z-scores for all dirty tickers in one vectorised pass, so the cost per engine
+  /// loop iteration is fixed no matter how many updates arrived for the basket.
+  class FeatureStore {
+  public:
+    /// Kernel implementations, the best one supported by the CPU is picked at construction.
+    enum class Kernel : uint8_t {
+      SCALAR = 0,
+      AVX2 = 1,
+      AVX512 = 2
+    };
+
+    explicit FeatureStore(double ewma_half_life = 100) noexcept;
+
+    /// Scatter a new top of book for this ticker, both sides need to be valid.
+    auto onBBO(Common::TickerId ticker_id, Common::Price bid_price, Common::Qty bid_qty,
+               Common::Price ask_price, Common::Qty ask_qty) noexcept -> void {
+      const auto mask = 1ULL << ticker_id;
+      bid_price_[ticker_id] = static_cast<double>(bid_price);
+      ask_price_[ticker_id] = static_cast<double>(ask_price);
+      bid_qty_[ticker_id] = static_cast<double>(bid_qty);
+      ask_qty_[ticker_id] = static_cast<double>(ask_qty);
+
+      if (UNLIKELY(!(valid_ & mask))) {
+        // Seed the EWMA so the kernels never need a first-observation branch.
+        mid_mean_[ticker_id] = (bid_price_[ticker_id] + ask_price_[ticker_id]) / 2;
+        mid_variance_[ticker_id] = 0;
+        valid_ |= mask;
+      }
+      dirty_ |= mask;
+    }
+
+    /// Recompute the features of every dirty ticker and the cross-sectional imbalance z-scores.
+    auto compute() noexcept -> void;
+
+    auto dirty() const noexcept {
+      return dirty_;
+    }
+
+    auto kernel() const noexcept {
+      return kernel_;
+    }
+
+    /// Force a specific kernel, e.g. to compare implementations. Falls back to SCALAR if unsupported by this CPU.
+    auto setKernel(Kernel kernel) noexcept -> void;
+
+    auto microprice(Common::TickerId ticker_id) const noexcept {
+      return (valid_ & (1ULL << ticker_id) ? microprice_[ticker_id] : Feature_INVALID);
+    }
+
+    /// (bid_qty - ask_qty) / (bid_qty + ask_qty) in [-1, 1].
+    auto imbalance(Common::TickerId ticker_id) const noexcept {
+      return (valid_ & (1ULL << ticker_id) ? imbalance_[ticker_id] : Feature_INVALID);
+    }
+
+    auto spread(Common::TickerId ticker_id) const noexcept {
+      return (valid_ & (1ULL << ticker_id) ? spread_[ticker_id] : Feature_INVALID);
+    }
+
+    /// Deviation of the microprice from the EWMA mid in units of EWMA mid standard deviation.
+    auto midZScore(Common::TickerId ticker_id) const noexcept {
+      return (valid_ & (1ULL << ticker_id) ? mid_zscore_[ticker_id] : Feature_INVALID);
+    }
+
+    /// Imbalance of this ticker relative to the rest of the universe, in units of cross-sectional standard deviation.
+    auto imbalanceZScore(Common::TickerId ticker_id) const noexcept {
+      return (valid_ & (1ULL << ticker_id) ? imbalance_zscore_[ticker_id] : Feature_INVALID);
+    }
+
+    /// Deleted copy & move constructors and assignment-operators.
+    FeatureStore(const FeatureStore &) = delete;
+
+    FeatureStore(const FeatureStore &&) = delete;
+
+    FeatureStore &operator=(const FeatureStore &) = delete;
+
+    FeatureStore &operator=(const FeatureStore &&) = delete;
+
+  private:
+    typedef std::array<double, FEATURE_STORE_LANES> Lanes;
+
+    auto computeScalar() noexcept -> void;
+    auto computeAvx2() noexcept -> void;
+    auto computeAvx512() noexcept -> void;
+
+    Kernel kernel_ = Kernel::SCALAR;
+    double alpha_ = 0;
+
+    uint64_t valid_ = 0;
+    uint64_t dirty_ = 0;
+
+    /// Inputs.
+    alignas(64) Lanes bid_price_ = {};
+    alignas(64) Lanes ask_price_ = {};
+    alignas(64) Lanes bid_qty_ = {};
+    alignas(64) Lanes ask_qty_ = {};
+
+    /// Per ticker state.
+    alignas(64) Lanes mid_mean_ = {};
+    alignas(64) Lanes mid_variance_ = {};
+
+    /// Outputs.
+    alignas(64) Lanes microprice_ = {};
+    alignas(64) Lanes imbalance_ = {};
+    alignas(64) Lanes spread_ = {};
+    alignas(64) Lanes mid_zscore_ = {};
+    alignas(64) Lanes imbalance_zscore_ = {};
+  };
+}
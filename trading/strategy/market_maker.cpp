@@ -4,9 +4,10 @@
 
 namespace Trading {
   MarketMaker::MarketMaker(Common::Logger *logger, TradeEngine *trade_engine, const FeatureEngine *feature_engine,
-                           OrderManager *order_manager, const TradeEngineCfgHashMap &ticker_cfg)
-      : feature_engine_(feature_engine), order_manager_(order_manager), logger_(logger),
-        ticker_cfg_(ticker_cfg) {
+                           const PositionKeeper *position_keeper, OrderManager *order_manager,
+                           const TradeEngineCfgHashMap &ticker_cfg)
+      : feature_engine_(feature_engine), position_keeper_(position_keeper), order_manager_(order_manager), logger_(logger),
+        quoting_engine_(ticker_cfg) {
     trade_engine->algoOnOrderBookUpdate_ = [this](auto ticker_id, auto price, auto side, auto book) {
       onOrderBookUpdate(ticker_id, price, side, book);
     };
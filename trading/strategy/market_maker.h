@@ -5,6 +5,8 @@
 
 #include "order_manager.h"
 #include "feature_engine.h"
+#include "position_keeper.h"
+#include "quoting_engine.h"
 
 using namespace Common;
 
@@ -12,30 +14,38 @@ namespace Trading {
   class MarketMaker {
   public:
     MarketMaker(Common::Logger *logger, TradeEngine *trade_engine, const FeatureEngine *feature_engine,
-                OrderManager *order_manager,
+                const PositionKeeper *position_keeper, OrderManager *order_manager,
                 const TradeEngineCfgHashMap &ticker_cfg);
 
-    /// Process order book updates, fetch the fair market price from the feature engine, check against the trading threshold and modify the passive orders.
+    /// Process order book updates of a ticker - recompute its quote ladders from the fair market price, volatility and
+    /// position, and send only the sides which moved out of their hysteresis band to the order manager.
     auto onOrderBookUpdate(TickerId ticker_id, Price price, Side side, const MarketOrderBook *book) noexcept -> void {
       logger_->log("%:% %() % ticker:% price:% side:%\n", __FILE__, __LINE__, __FUNCTION__,
                    Common::getCurrentTimeStr(&time_str_), ticker_id, Common::priceToString(price).c_str(),
                    Common::sideToString(side).c_str());
 
       const auto bbo = book->getBBO();
-      const auto fair_price = feature_engine_->getMktPrice();
+      const auto &features = feature_engine_->getTickerFeatures(ticker_id);
+      const auto fair_price = features.mktPrice();
 
-      if (LIKELY(bbo->bid_price_ != Price_INVALID && bbo->ask_price_ != Price_INVALID && fair_price != Feature_INVALID)) {
-        logger_->log("%:% %() % % fair-price:%\n", __FILE__, __LINE__, __FUNCTION__,
-                     Common::getCurrentTimeStr(&time_str_),
-                     bbo->toString().c_str(), fair_price);
-
-        const auto clip = ticker_cfg_.at(ticker_id).clip_;
-        const auto threshold = ticker_cfg_.at(ticker_id).threshold_;
-
-        const auto bid_price = bbo->bid_price_ - (fair_price - bbo->bid_price_ >= threshold ? 0 : 1);
-        const auto ask_price = bbo->ask_price_ + (bbo->ask_price_ - fair_price >= threshold ? 0 : 1);
+      if (LIKELY(bbo->bid_price_ != Price_INVALID && bbo->ask_price_ != Price_INVALID && !std::isnan(fair_price))) {
+        const auto position = position_keeper_->getPositionInfo(ticker_id)->position_;
+        const auto requote = quoting_engine_.update(ticker_id, bbo, fair_price, features.volatility(), position,
+                                                     position_keeper_->getInstrumentScale(ticker_id));
 
-        order_manager_->moveOrders(ticker_id, bid_price, ask_price, clip);
+        const auto &quotes = quoting_engine_.getTickerQuotes(ticker_id);
+        logger_->log("%:% %() % % fair-price:% reservation:% half-spread:% pos:% requote:%/%\n", __FILE__, __LINE__, __FUNCTION__,
+                     Common::getCurrentTimeStr(&time_str_),
+                     bbo->toString().c_str(), fair_price, quotes.reservation_price_, quotes.half_spread_, position,
+                     requote[0], requote[1]);
+
+        for (const auto side : {Side::BUY, Side::SELL}) {
+          if (requote[side == Side::SELL]) {
+            const auto &ladder = quoting_engine_.getLadder(ticker_id, side);
+            const auto unsent = order_manager_->moveLayers(ticker_id, side, ladder.prices_.data(), ladder.qtys_.data(), ladder.num_levels_);
+            quoting_engine_.onLadderSent(ticker_id, side, unsent);
+          }
+        }
       }
     }
 
@@ -68,13 +78,16 @@ namespace Trading {
     /// The feature engine that drives the market making algorithm.
     const FeatureEngine *feature_engine_ = nullptr;
 
+    /// Position keeper for the inventory the quotes are skewed against.
+    const PositionKeeper *position_keeper_ = nullptr;
+
     /// Used by the market making algorithm to manage its passive orders.
     OrderManager *order_manager_ = nullptr;
 
     std::string time_str_;
     Common::Logger *logger_ = nullptr;
 
-    /// Holds the trading configuration for the market making algorithm.
-    const TradeEngineCfgHashMap ticker_cfg_;
+    /// Quote ladders of every ticker, built from the quote configuration of the trading configuration.
+    QuotingEngine quoting_engine_;
   };
 }
@@ -5,6 +5,8 @@
 namespace Trading {
   MarketOrderBook::MarketOrderBook(TickerId ticker_id, Logger *logger)
       : ticker_id_(ticker_id), orders_at_price_pool_(ME_MAX_PRICE_LEVELS), order_pool_(ME_MAX_ORDER_IDS), logger_(logger) {
+    oid_to_order_.fill(nullptr);
+    price_orders_at_price_.fill(nullptr);
   }
 
   MarketOrderBook::~MarketOrderBook() {
@@ -13,7 +13,8 @@ namespace Trading {
     PENDING_NEW = 1,
     LIVE = 2,
     PENDING_CANCEL = 3,
-    DEAD = 4
+    DEAD = 4,
+    PENDING_MODIFY = 5
   };
 
   inline auto OMOrderStateToString(OMOrderState side) -> std::string {
@@ -26,6 +27,8 @@ namespace Trading {
         return "PENDING_CANCEL";
       case OMOrderState::DEAD:
         return "DEAD";
+      case OMOrderState::PENDING_MODIFY:
+        return "PENDING_MODIFY";
       case OMOrderState::INVALID:
         return "INVALID";
     }
@@ -33,6 +36,9 @@ namespace Trading {
     return "UNKNOWN";
   }
 
+  /// Maximum number of working orders across all tickers and sides managed by one order manager.
+  constexpr size_t OM_MAX_ORDERS = 64 * 1024;
+
   /// Internal structure used by the order manager to represent a single strategy order.
   struct OMOrder {
     TickerId ticker_id_ = TickerId_INVALID;
@@ -42,6 +48,23 @@ namespace Trading {
     Qty qty_ = Qty_INVALID;
     OMOrderState order_state_ = OMOrderState::INVALID;
 
+    /// Price and quantity of a modify which has not been acknowledged yet.
+    Price pending_price_ = Price_INVALID;
+    Qty pending_qty_ = Qty_INVALID;
+
+    /// Quantity of this order currently accounted for as working in the RiskManager.
+    Qty risk_qty_ = 0;
+
+    /// Working orders of the same ticker and side are in a doubly linked list, layers in the order they were created.
+    OMOrder *prev_order_ = nullptr;
+    OMOrder *next_order_ = nullptr;
+
+    OMOrder() = default;
+
+    OMOrder(TickerId ticker_id, OrderId order_id, Side side, Price price, Qty qty, OMOrderState order_state) noexcept
+        : ticker_id_(ticker_id), order_id_(order_id), side_(side), price_(price), qty_(qty), order_state_(order_state) {
+    }
+
     auto toString() const {
       std::stringstream ss;
       ss << "OMOrder" << "["
@@ -50,15 +73,21 @@ namespace Trading {
          << "side:" << sideToString(side_) << " "
          << "price:" << priceToString(price_) << " "
          << "qty:" << qtyToString(qty_) << " "
-         << "state:" << OMOrderStateToString(order_state_) << "]";
+         << "state:" << OMOrderStateToString(order_state_);
+      if (order_state_ == OMOrderState::PENDING_MODIFY)
+        ss << " pending:" << qtyToString(pending_qty_) << "@" << priceToString(pending_price_);
+      ss << "]";
 
       return ss.str();
     }
   };
 
-  /// Hash map from Side -> OMOrder.
-  typedef std::array<OMOrder, sideToIndex(Side::MAX) + 1> OMOrderSideHashMap;
+  /// Hash map from OrderId -> OMOrder, order ids index it modulo ME_MAX_ORDER_IDS.
+  typedef std::array<OMOrder *, ME_MAX_ORDER_IDS> OMOrderIdHashMap;
+
+  /// Hash map from Side -> first working OMOrder of that side.
+  typedef std::array<OMOrder *, sideToIndex(Side::MAX) + 1> OMOrderSideHashMap;
 
-  /// Hash map from TickerId -> Side -> OMOrder.
+  /// Hash map from TickerId -> Side -> first working OMOrder.
   typedef std::array<OMOrderSideHashMap, ME_MAX_TICKERS> OMOrderTickerSideHashMap;
 }
@@ -2,21 +2,45 @@
 #include "trade_engine.h"
 
 namespace Trading {
-  /// Send a new order with specified attribute, and update the OMOrder object passed here.
-  auto OrderManager::newOrder(OMOrder *order, TickerId ticker_id, Price price, Side side, Qty qty) noexcept -> void {
+  /// Send a new order with specified attributes after running the pre-trade risk checks.
+  auto OrderManager::newOrder(TickerId ticker_id, Price price, Side side, Qty qty, bool layer) noexcept -> OMOrder * {
+    const auto risk_result = risk_manager_.checkPreTradeRisk(ticker_id, side, price, qty);
+    if (UNLIKELY(risk_result != RiskCheckResult::ALLOWED)) {
+      logger_->log("%:% %() % Ticker:% Side:% Qty:% RiskCheckResult:%\n", __FILE__, __LINE__, __FUNCTION__,
+                   Common::getCurrentTimeStr(&time_str_),
+                   tickerIdToString(ticker_id), sideToString(side), qtyToString(qty),
+                   riskCheckResultToString(risk_result));
+      return nullptr;
+    }
+
     const Exchange::MEClientRequest new_request{Exchange::ClientRequestType::NEW, trade_engine_->clientId(), ticker_id,
                                                 next_order_id_, side, price, qty};
     trade_engine_->sendClientRequest(&new_request);
+    risk_manager_.onOrderSent(ticker_id, side, price, qty);
 
-    *order = {ticker_id, next_order_id_, side, price, qty, OMOrderState::PENDING_NEW};
+    auto order = order_pool_.allocate(ticker_id, next_order_id_, side, price, qty, OMOrderState::PENDING_NEW);
+    order->risk_qty_ = qty;
+    order_id_to_order_->at(next_order_id_ % ME_MAX_ORDER_IDS) = order;
     ++next_order_id_;
 
+    // Append as the last layer of this side.
+    if (layer) {
+      auto &last_order = ticker_side_last_order_.at(ticker_id).at(sideToIndex(side));
+      if (last_order)
+        last_order->next_order_ = order;
+      else
+        ticker_side_order_.at(ticker_id).at(sideToIndex(side)) = order;
+      order->prev_order_ = last_order;
+      last_order = order;
+    }
+
     logger_->log("%:% %() % Sent new order % for %\n", __FILE__, __LINE__, __FUNCTION__,
                  Common::getCurrentTimeStr(&time_str_),
                  new_request.toString().c_str(), order->toString().c_str());
+    return order;
   }
 
-  /// Send a cancel for the specified order, and update the OMOrder object passed here.
+  /// Send a cancel for the specified order, the order is released once the cancel is acknowledged.
   auto OrderManager::cancelOrder(OMOrder *order) noexcept -> void {
     const Exchange::MEClientRequest cancel_request{Exchange::ClientRequestType::CANCEL, trade_engine_->clientId(),
                                                    order->ticker_id_, order->order_id_, order->side_, order->price_,
@@ -29,4 +53,35 @@ namespace Trading {
                  Common::getCurrentTimeStr(&time_str_),
                  cancel_request.toString().c_str(), order->toString().c_str());
   }
+
+  /// Send a cancel/replace for the specified order to move it to the specified price and quantity.
+  auto OrderManager::modifyOrder(OMOrder *order, Price price, Qty qty) noexcept -> bool {
+    // Until the modify is acknowledged the larger of the two quantities may still fill, that is what is checked and
+    // booked in place of the order's current working quantity.
+    const auto risk_qty = std::max(order->qty_, qty);
+    risk_manager_.onOrderReleased(order->ticker_id_, order->side_, order->risk_qty_);
+    const auto risk_result = risk_manager_.checkPreTradeRisk(order->ticker_id_, order->side_, price, risk_qty);
+    if (UNLIKELY(risk_result != RiskCheckResult::ALLOWED)) {
+      risk_manager_.onOrderSent(order->ticker_id_, order->side_, order->price_, order->risk_qty_);
+      logger_->log("%:% %() % % -> %@% RiskCheckResult:%\n", __FILE__, __LINE__, __FUNCTION__,
+                   Common::getCurrentTimeStr(&time_str_), order->toString().c_str(),
+                   qtyToString(qty), priceToString(price), riskCheckResultToString(risk_result));
+      return false;
+    }
+
+    const Exchange::MEClientRequest modify_request{Exchange::ClientRequestType::MODIFY, trade_engine_->clientId(),
+                                                   order->ticker_id_, order->order_id_, order->side_, price, qty};
+    trade_engine_->sendClientRequest(&modify_request);
+
+    order->risk_qty_ = risk_qty;
+    risk_manager_.onOrderSent(order->ticker_id_, order->side_, price, risk_qty);
+    order->pending_price_ = price;
+    order->pending_qty_ = qty;
+    order->order_state_ = OMOrderState::PENDING_MODIFY;
+
+    logger_->log("%:% %() % Sent modify % for %\n", __FILE__, __LINE__, __FUNCTION__,
+                 Common::getCurrentTimeStr(&time_str_),
+                 modify_request.toString().c_str(), order->toString().c_str());
+    return true;
+  }
 }
@@ -2,6 +2,7 @@
 
 #include "common/macros.h"
 #include "common/logging.h"
+#include "common/mem_pool.h"
 
 #include "exchange/order_server/client_response.h"
 
@@ -14,104 +15,150 @@ namespace Trading {
   class TradeEngine;
 
   /// Manages orders for a trading algorithm, hides the complexity of order management to simplify trading strategies.
+  /// Any number of working orders per ticker and side (layers), kept in pooled storage and indexed by OrderId.
+  /// Working orders are re-priced with a single MODIFY (cancel/replace) request instead of a cancel followed by a new.
   class OrderManager {
   public:
     OrderManager(Common::Logger *logger, TradeEngine *trade_engine, RiskManager& risk_manager)
-        : trade_engine_(trade_engine), risk_manager_(risk_manager), logger_(logger) {
+        : trade_engine_(trade_engine), risk_manager_(risk_manager), logger_(logger),
+          order_pool_(OM_MAX_ORDERS), order_id_to_order_(new OMOrderIdHashMap()) {
+      order_id_to_order_->fill(nullptr);
+      for (auto &side_orders : ticker_side_order_)
+        side_orders.fill(nullptr);
+      for (auto &side_orders : ticker_side_last_order_)
+        side_orders.fill(nullptr);
+    }
+
+    ~OrderManager() {
+      delete order_id_to_order_;
+      order_id_to_order_ = nullptr;
     }
 
     /// Process an order update from a client response and update the state of the orders being managed.
     auto onOrderUpdate(const Exchange::MEClientResponse *client_response) noexcept -> void {
       logger_->log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
                    client_response->toString().c_str());
-      auto order = &(ticker_side_order_.at(client_response->ticker_id_).at(sideToIndex(client_response->side_)));
+      auto order = getOrder(client_response->order_id_);
+      if (UNLIKELY(!order)) {
+        logger_->log("%:% %() % Response for unknown order:%\n", __FILE__, __LINE__, __FUNCTION__,
+                     Common::getCurrentTimeStr(&time_str_), orderIdToString(client_response->order_id_));
+        return;
+      }
       logger_->log("%:% %() % %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
                    order->toString().c_str());
 
       switch (client_response->type_) {
         case Exchange::ClientResponseType::ACCEPTED: {
+          if (order->order_state_ == OMOrderState::PENDING_MODIFY) {
+            // Fills at the old price may have arrived while the modify was in flight, the exchange's leaves quantity
+            // already accounts for them.
+            order->price_ = order->pending_price_;
+            order->qty_ = client_response->leaves_qty_;
+            updateRiskQty(order, order->qty_);
+            if (!order->qty_) {
+              removeOrder(order);
+              break;
+            }
+          }
           order->order_state_ = OMOrderState::LIVE;
         }
           break;
-        case Exchange::ClientResponseType::CANCELED: {
-          order->order_state_ = OMOrderState::DEAD;
+        case Exchange::ClientResponseType::CANCELED:
+        case Exchange::ClientResponseType::REJECTED: {
+          removeOrder(order);
         }
           break;
-        case Exchange::ClientResponseType::FILLED: {
+        case Exchange::ClientResponseType::FILLED:
+        case Exchange::ClientResponseType::PARTIALLY_FILLED: {
+          const auto released_qty = std::min(client_response->exec_qty_, order->risk_qty_);
+          risk_manager_.onOrderReleased(order->ticker_id_, order->side_, released_qty);
+          order->risk_qty_ -= released_qty;
           order->qty_ = client_response->leaves_qty_;
-          if(!order->qty_)
-            order->order_state_ = OMOrderState::DEAD;
+          if (!order->qty_)
+            removeOrder(order);
         }
           break;
-        case Exchange::ClientResponseType::PARTIALLY_FILLED: {
-          order->qty_ = client_response->leaves_qty_;
-          // Order stays LIVE since it's only partially filled
+        case Exchange::ClientResponseType::MODIFY_REJECTED: {
+          // Still working at the old price and quantity.
+          updateRiskQty(order, order->qty_);
+          order->order_state_ = OMOrderState::LIVE;
         }
           break;
-        case Exchange::ClientResponseType::REJECTED: {
-          order->order_state_ = OMOrderState::DEAD;
+        case Exchange::ClientResponseType::CANCEL_REJECTED: {
+          if (order->order_state_ == OMOrderState::PENDING_CANCEL)
+            order->order_state_ = OMOrderState::LIVE;
         }
           break;
-        case Exchange::ClientResponseType::CANCEL_REJECTED:
         case Exchange::ClientResponseType::INVALID: {
         }
           break;
       }
     }
 
-    /// Send a new order with specified attribute, and update the OMOrder object passed here.
-    auto newOrder(OMOrder *order, TickerId ticker_id, Price price, Side side, Qty qty) noexcept -> void;
+    /// Send a new order with specified attributes after running the pre-trade risk checks.
+    /// Orders which are not layers are tracked by OrderId only, moveLayers() / moveOrders() never touch them.
+    /// Returns the new working order, or nullptr if it failed the risk checks.
+    auto newOrder(TickerId ticker_id, Price price, Side side, Qty qty, bool layer = true) noexcept -> OMOrder *;
 
-    /// Send a cancel for the specified order, and update the OMOrder object passed here.
+    /// Send a cancel for the specified order, the order is released once the cancel is acknowledged.
     auto cancelOrder(OMOrder *order) noexcept -> void;
 
-    /// Move a single order on the specified side so that it has the specified price and quantity.
-    /// This will perform risk checks prior to sending the order, and update the OMOrder object passed here.
-    auto moveOrder(OMOrder *order, TickerId ticker_id, Price price, Side side, Qty qty) noexcept {
-      switch (order->order_state_) {
-        case OMOrderState::LIVE: {
-          if(order->price_ != price) {
-            cancelOrder(order);
-          }
-        }
-          break;
-        case OMOrderState::INVALID:
-        case OMOrderState::DEAD: {
-          if(LIKELY(price != Price_INVALID)) {
-            const auto risk_result = risk_manager_.checkPreTradeRisk(ticker_id, side, qty);
-            if(LIKELY(risk_result == RiskCheckResult::ALLOWED)) {
-              newOrder(order, ticker_id, price, side, qty);
-            } else
-              logger_->log("%:% %() % Ticker:% Side:% Qty:% RiskCheckResult:%\n", __FILE__, __LINE__, __FUNCTION__,
-                           Common::getCurrentTimeStr(&time_str_),
-                           tickerIdToString(ticker_id), sideToString(side), qtyToString(qty),
-                           riskCheckResultToString(risk_result));
-          }
-        }
-          break;
-        case OMOrderState::PENDING_NEW:
-        case OMOrderState::PENDING_CANCEL:
-          break;
+    /// Send a cancel/replace for the specified order to move it to the specified price and quantity.
+    /// The larger of the current and new quantity is risk checked first, as either may fill until the modify is
+    /// acknowledged, returns false if it failed the risk checks.
+    auto modifyOrder(OMOrder *order, Price price, Qty qty) noexcept -> bool;
+
+    /// Have working orders on the specified side at the specified layers of prices and quantities.
+    /// Orders are matched to layers in the order they were created - LIVE orders at the wrong price or quantity are
+    /// modified, missing layers are sent as new orders, and orders beyond num_layers or at Price_INVALID are cancelled.
+    /// Orders with a request in flight are left alone until it is acknowledged.
+    /// Returns a mask of the layers (bit i for layer i, up to 64) which could not be sent - refused by the risk checks
+    /// or left alone with a request in flight - so are not working at their price and quantity yet.
+    auto moveLayers(TickerId ticker_id, Side side, const Price *prices, const Qty *qtys, size_t num_layers) noexcept -> uint64_t {
+      const auto layerBit = [](size_t layer) { return layer < 64 ? uint64_t{1} << layer : 0; };
+      uint64_t unsent = 0;
+      auto order = ticker_side_order_.at(ticker_id).at(sideToIndex(side));
+      size_t layer = 0;
+      for (; order && layer < num_layers; ++layer) {
+        auto next_order = order->next_order_;
+        if (order->order_state_ != OMOrderState::LIVE)
+          unsent |= layerBit(layer);
+        else if (prices[layer] == Price_INVALID)
+          cancelOrder(order);
+        else if ((order->price_ != prices[layer] || order->qty_ != qtys[layer]) && !modifyOrder(order, prices[layer], qtys[layer]))
+          unsent |= layerBit(layer);
+        order = next_order;
+      }
+
+      for (; order; order = order->next_order_) {
+        if (order->order_state_ == OMOrderState::LIVE)
+          cancelOrder(order);
+      }
+
+      for (; layer < num_layers; ++layer) {
+        if (prices[layer] != Price_INVALID && !newOrder(ticker_id, prices[layer], side, qtys[layer]))
+          unsent |= layerBit(layer);
       }
+      return unsent;
     }
 
     /// Have orders of quantity clip at the specified buy and sell prices.
     /// This can result in new orders being sent if there are none.
-    /// This can result in existing orders being cancelled if they are not at the specified price or of the specified quantity.
+    /// This can result in existing orders being modified if they are not at the specified price or of the specified quantity.
     /// Specifying Price_INVALID for the buy or sell prices indicates that we do not want an order there.
     auto moveOrders(TickerId ticker_id, Price bid_price, Price ask_price, Qty clip) noexcept {
-      {
-        auto bid_order = &(ticker_side_order_.at(ticker_id).at(sideToIndex(Side::BUY)));
-        moveOrder(bid_order, ticker_id, bid_price, Side::BUY, clip);
-      }
+      moveLayers(ticker_id, Side::BUY, &bid_price, &clip, 1);
+      moveLayers(ticker_id, Side::SELL, &ask_price, &clip, 1);
+    }
 
-      {
-        auto ask_order = &(ticker_side_order_.at(ticker_id).at(sideToIndex(Side::SELL)));
-        moveOrder(ask_order, ticker_id, ask_price, Side::SELL, clip);
-      }
+    /// Working order with the specified OrderId, nullptr if there is none.
+    auto getOrder(OrderId order_id) const noexcept -> OMOrder * {
+      auto order = order_id_to_order_->at(order_id % ME_MAX_ORDER_IDS);
+      return (order && order->order_id_ == order_id) ? order : nullptr;
     }
 
-    /// Helper method to fetch the buy and sell OMOrders for the specified TickerId.
+    /// Helper method to fetch the first working buy and sell OMOrders for the specified TickerId.
+    /// The other layers can be walked through OMOrder::next_order_.
     auto getOMOrderSideHashMap(TickerId ticker_id) const {
       return &(ticker_side_order_.at(ticker_id));
     }
@@ -128,18 +175,54 @@ namespace Trading {
     OrderManager &operator=(const OrderManager &&) = delete;
 
   private:
+    /// Change the working quantity accounted for this order in the RiskManager.
+    auto updateRiskQty(OMOrder *order, Qty qty) noexcept -> void {
+      risk_manager_.onOrderReleased(order->ticker_id_, order->side_, order->risk_qty_);
+      risk_manager_.onOrderSent(order->ticker_id_, order->side_, order->price_, qty);
+      order->risk_qty_ = qty;
+    }
+
+    /// Unlink a dead order from its ticker and side, release its working quantity and return it to the pool.
+    auto removeOrder(OMOrder *order) noexcept -> void {
+      risk_manager_.onOrderReleased(order->ticker_id_, order->side_, order->risk_qty_);
+      order->order_state_ = OMOrderState::DEAD;
+
+      auto &first_order = ticker_side_order_.at(order->ticker_id_).at(sideToIndex(order->side_));
+      auto &last_order = ticker_side_last_order_.at(order->ticker_id_).at(sideToIndex(order->side_));
+      if (order->prev_order_)
+        order->prev_order_->next_order_ = order->next_order_;
+      else if (first_order == order)
+        first_order = order->next_order_;
+      if (order->next_order_)
+        order->next_order_->prev_order_ = order->prev_order_;
+      else if (last_order == order)
+        last_order = order->prev_order_;
+
+      order_id_to_order_->at(order->order_id_ % ME_MAX_ORDER_IDS) = nullptr;
+      order_pool_.deallocate(order);
+    }
+
     /// The parent trade engine object, used to send out client requests.
     TradeEngine *trade_engine_ = nullptr;
 
     /// Risk manager to perform pre-trade risk checks.
-    const RiskManager& risk_manager_;
+    RiskManager& risk_manager_;
 
     std::string time_str_;
     Common::Logger *logger_ = nullptr;
 
-    /// Hash map container from TickerId -> Side -> OMOrder.
+    /// Pool of working OMOrder objects.
+    MemPool<OMOrder> order_pool_;
+
+    /// Hash map container from OrderId -> working OMOrder.
+    OMOrderIdHashMap *order_id_to_order_ = nullptr;
+
+    /// Hash map container from TickerId -> Side -> first working OMOrder.
     OMOrderTickerSideHashMap ticker_side_order_;
 
+    /// Hash map container from TickerId -> Side -> last working OMOrder, where new layers are appended.
+    OMOrderTickerSideHashMap ticker_side_last_order_;
+
     /// Used to set OrderIds on outgoing new order requests.
     OrderId next_order_id_ = 1;
   };
@@ -2,6 +2,7 @@
 
 #include "common/macros.h"
 #include "common/types.h"
+#include "common/fixed_point.h"
 #include "common/logging.h"
 
 #include "exchange/order_server/client_response.h"
@@ -12,10 +13,12 @@ using namespace Common;
 
 namespace Trading {
   /// PositionInfo tracks the position, pnl (realized and unrealized) and volume for a single trading instrument.
+  /// PnL is accumulated exactly in integer price units * qty units of the instrument, see Common::InstrumentScale.
   struct PositionInfo {
     int32_t position_ = 0;
-    double real_pnl_ = 0, unreal_pnl_ = 0, total_pnl_ = 0;
-    std::array<double, sideToIndex(Side::MAX) + 1> open_vwap_;
+    PnL real_pnl_ = 0, unreal_pnl_ = 0, total_pnl_ = 0;
+    /// Notional (sum of price * qty) of the open position on each side - the open vwap is open_notional_ / |position_|.
+    std::array<PnL, sideToIndex(Side::MAX) + 1> open_notional_ = {};
     Qty volume_ = 0;
     const BBO *bbo_ = nullptr;
 
@@ -27,8 +30,8 @@ namespace Trading {
          << " r-pnl:" << real_pnl_
          << " t-pnl:" << total_pnl_
          << " vol:" << qtyToString(volume_)
-         << " vwaps:[" << (position_ ? open_vwap_.at(sideToIndex(Side::BUY)) / std::abs(position_) : 0)
-         << "X" << (position_ ? open_vwap_.at(sideToIndex(Side::SELL)) / std::abs(position_) : 0)
+         << " vwaps:[" << (position_ ? static_cast<double>(open_notional_.at(sideToIndex(Side::BUY))) / std::abs(position_) : 0)
+         << "X" << (position_ ? static_cast<double>(open_notional_.at(sideToIndex(Side::SELL))) / std::abs(position_) : 0)
          << "] "
          << (bbo_ ? bbo_->toString() : "") << "}";
 
@@ -41,34 +44,33 @@ namespace Trading {
       const auto side_index = sideToIndex(client_response->side_);
       const auto opp_side_index = sideToIndex(client_response->side_ == Side::BUY ? Side::SELL : Side::BUY);
       const auto side_value = sideToValue(client_response->side_);
+      const auto exec_qty = static_cast<int64_t>(client_response->exec_qty_);
+      const auto price = client_response->price_;
       position_ += client_response->exec_qty_ * side_value;
       volume_ += client_response->exec_qty_;
 
       if (old_position * sideToValue(client_response->side_) >= 0) { // opened / increased position.
-        open_vwap_[side_index] += (client_response->price_ * client_response->exec_qty_);
+        open_notional_[side_index] += price * exec_qty;
       } else { // decreased position.
-        const auto opp_side_vwap = open_vwap_[opp_side_index] / std::abs(old_position);
-        open_vwap_[opp_side_index] = opp_side_vwap * std::abs(position_);
-        real_pnl_ += std::min(static_cast<int32_t>(client_response->exec_qty_), std::abs(old_position)) *
-                     (opp_side_vwap - client_response->price_) * sideToValue(client_response->side_);
+        // Release the closed share of the open notional. The division remainder stays with the open position,
+        // so realized + unrealized pnl is conserved exactly.
+        const auto old_abs_position = static_cast<int64_t>(std::abs(old_position));
+        const auto closed_qty = std::min(exec_qty, old_abs_position);
+        __extension__ typedef __int128 WidePnL;
+        const auto released = static_cast<PnL>(static_cast<WidePnL>(open_notional_[opp_side_index]) * closed_qty / old_abs_position);
+        open_notional_[opp_side_index] -= released;
+        real_pnl_ += (released - price * closed_qty) * side_value;
         if (position_ * old_position < 0) { // flipped position to opposite sign.
-          open_vwap_[side_index] = (client_response->price_ * std::abs(position_));
-          open_vwap_[opp_side_index] = 0;
+          open_notional_[side_index] = price * std::abs(position_);
+          open_notional_[opp_side_index] = 0;
         }
       }
 
       if (!position_) { // flat
-        open_vwap_[sideToIndex(Side::BUY)] = open_vwap_[sideToIndex(Side::SELL)] = 0;
+        open_notional_[sideToIndex(Side::BUY)] = open_notional_[sideToIndex(Side::SELL)] = 0;
         unreal_pnl_ = 0;
       } else {
-        if (position_ > 0)
-          unreal_pnl_ =
-              (client_response->price_ - open_vwap_[sideToIndex(Side::BUY)] / std::abs(position_)) *
-              std::abs(position_);
-        else
-          unreal_pnl_ =
-              (open_vwap_[sideToIndex(Side::SELL)] / std::abs(position_) - client_response->price_) *
-              std::abs(position_);
+        unreal_pnl_ = position_ * price - open_notional_[sideToIndex(Side::BUY)] + open_notional_[sideToIndex(Side::SELL)];
       }
 
       total_pnl_ = unreal_pnl_ + real_pnl_;
@@ -79,20 +81,14 @@ namespace Trading {
     }
 
     /// Process a change in top-of-book prices (BBO), and update unrealized pnl if there is an open position.
+    /// Marks to the mid price, the half price unit of a mid between two ticks is truncated.
     auto updateBBO(const BBO *bbo, Logger *logger) noexcept {
       std::string time_str;
       bbo_ = bbo;
 
       if (position_ && bbo->bid_price_ != Price_INVALID && bbo->ask_price_ != Price_INVALID) {
-        const auto mid_price = (bbo->bid_price_ + bbo->ask_price_) * 0.5;
-        if (position_ > 0)
-          unreal_pnl_ =
-              (mid_price - open_vwap_[sideToIndex(Side::BUY)] / std::abs(position_)) *
-              std::abs(position_);
-        else
-          unreal_pnl_ =
-              (open_vwap_[sideToIndex(Side::SELL)] / std::abs(position_) - mid_price) *
-              std::abs(position_);
+        unreal_pnl_ = (position_ * (bbo->bid_price_ + bbo->ask_price_) -
+                       2 * (open_notional_[sideToIndex(Side::BUY)] - open_notional_[sideToIndex(Side::SELL)])) / 2;
 
         const auto old_total_pnl = total_pnl_;
         total_pnl_ = unreal_pnl_ + real_pnl_;
@@ -129,6 +125,9 @@ namespace Trading {
     /// Hash map container from TickerId -> PositionInfo.
     std::array<PositionInfo, ME_MAX_TICKERS> ticker_position_;
 
+    /// Hash map container from TickerId -> price and quantity scale of the instrument.
+    InstrumentScaleHashMap ticker_scale_{};
+
   public:
     auto addFill(const Exchange::MEClientResponse *client_response) noexcept {
       ticker_position_.at(client_response->ticker_id_).addFill(client_response, logger_);
@@ -142,8 +141,17 @@ namespace Trading {
       return &(ticker_position_.at(ticker_id));
     }
 
+    /// Price and quantity scale the instrument's positions and prices are kept in.
+    auto setInstrumentScale(TickerId ticker_id, const InstrumentScale &scale) noexcept {
+      ticker_scale_.at(ticker_id) = scale;
+    }
+
+    auto getInstrumentScale(TickerId ticker_id) const noexcept -> const InstrumentScale & {
+      return ticker_scale_.at(ticker_id);
+    }
+
     auto toString() const {
-      double total_pnl = 0;
+      PnL total_pnl = 0;
       Qty total_vol = 0;
 
       std::stringstream ss;
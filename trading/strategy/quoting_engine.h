@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "common/macros.h"
+#include "common/types.h"
+#include "common/fixed_point.h"
+
+#include "market_order.h"
+#include "rolling_features.h"
+
+using namespace Common;
+
+namespace Trading {
+  /// Prices and quantities of the quote levels of one side, best level first.
+  struct QuoteLadder {
+    std::array<Price, MAX_QUOTE_LEVELS> prices_;
+    std::array<Qty, MAX_QUOTE_LEVELS> qtys_;
+    size_t num_levels_ = 0;
+
+    QuoteLadder() noexcept {
+      prices_.fill(Price_INVALID);
+      qtys_.fill(0);
+    }
+
+    auto top() const noexcept {
+      return prices_[0];
+    }
+  };
+
+  /// Quoting state of a single ticker.
+  struct TickerQuotes {
+    QuoteCfg cfg_;
+    Qty clip_ = 0;
+    Qty max_position_ = 0;
+
+    /// Reservation price and half spread of the last decision.
+    double reservation_price_ = Feature_INVALID;
+    double half_spread_ = 0;
+
+    /// Ladders of the last decision which re-quoted a side - bids, asks - to be sent.
+    std::array<QuoteLadder, 2> target_;
+
+    /// Ladders as far as they were sent - bids, asks - and the position they were computed for. A side with layers
+    /// which could not be sent keeps their previous levels and is re-quoted on the next decision.
+    std::array<QuoteLadder, 2> quoted_;
+    std::array<bool, 2> unsent_ = {};
+    int64_t quoted_position_ = 0;
+  };
+
+  /// Computes the quote ladders of the market making algorithm from fair value, volatility and inventory.
+  /// Both sides are centred on the Avellaneda-Stoikov reservation price r = s - q * gamma * sigma^2 * T, at the half spread
+  /// (gamma * sigma^2 * T + 2 / gamma * ln(1 + gamma / kappa) * tick) / 2, with inventory q counted in clips and kappa per tick. Each side has as
+  /// many levels as the position limit allows once all of them fill. A side is only handed out to be re-sent when its
+  /// top level moved by at least the hysteresis band, its number of levels changed, the position changed, it would
+  /// cross the market or some of its layers could not be sent last time - so small fair value moves cost no order
+  /// traffic. Quote prices, level spacing and hysteresis are on the tick grid of the instrument's InstrumentScale.
+  /// Every decision is O(MAX_QUOTE_LEVELS).
+  class QuotingEngine {
+  public:
+    explicit QuotingEngine(const TradeEngineCfgHashMap &ticker_cfg) noexcept {
+      for (TickerId ticker_id = 0; ticker_id < ME_MAX_TICKERS; ++ticker_id) {
+        auto &quotes = ticker_quotes_.at(ticker_id);
+        quotes.clip_ = ticker_cfg.at(ticker_id).clip_;
+        quotes.max_position_ = ticker_cfg.at(ticker_id).risk_cfg_.max_position_;
+        configure(ticker_id, ticker_cfg.at(ticker_id).quote_cfg_);
+      }
+    }
+
+    /// Override the quote ladder configuration for a ticker, takes effect on its next decision.
+    auto configure(TickerId ticker_id, const QuoteCfg &cfg) noexcept -> void {
+      auto &quotes = ticker_quotes_.at(ticker_id);
+      quotes.cfg_ = cfg;
+      quotes.cfg_.num_levels_ = std::min(cfg.num_levels_, MAX_QUOTE_LEVELS);
+      quotes.cfg_.level_spacing_ = std::max<Price>(cfg.level_spacing_, 1);
+    }
+
+    /// Recompute the quotes of this ticker against the new top of book, fair price and volatility (per mid change, in
+    /// log return terms) for the specified position, on the tick grid of scale. Returns which of the bid and ask ladders
+    /// need to be sent.
+    auto update(TickerId ticker_id, const BBO *bbo, double fair_price, double volatility, int64_t position,
+                const InstrumentScale &scale) noexcept {
+      auto &quotes = ticker_quotes_.at(ticker_id);
+      const auto &cfg = quotes.cfg_;
+
+      // Price variance over the horizon in price units squared - volatility is a log return per mid change, scaled to
+      // price units by the fair price, and the horizon is a number of mid changes. None until the mid has moved twice.
+      const auto sigma = (std::isnan(volatility) ? 0.0 : volatility * fair_price);
+      const auto variance = sigma * sigma * cfg.horizon_;
+      const auto inventory = (quotes.clip_ ? static_cast<double>(position) / quotes.clip_ : 0.0);
+
+      // Kappa is per tick, so the liquidity term comes out in ticks and is scaled to price units like the spacing, at
+      // least half a tick either side.
+      const auto tick = scale.tick_size_;
+      quotes.reservation_price_ = fair_price - inventory * cfg.risk_aversion_ * variance;
+      quotes.half_spread_ = std::max(0.5 * tick, (cfg.risk_aversion_ * variance +
+                                                  2.0 / cfg.risk_aversion_ * std::log1p(cfg.risk_aversion_ / cfg.liquidity_) * tick) / 2.0);
+
+      // Quotes through the touch would take liquidity instead of providing it.
+      const auto bid_price = std::min(scale.roundToTick(static_cast<Price>(std::floor(quotes.reservation_price_ - quotes.half_spread_)), Side::BUY),
+                                      scale.roundToTick(bbo->ask_price_ - tick, Side::BUY));
+      const auto ask_price = std::max(scale.roundToTick(static_cast<Price>(std::ceil(quotes.reservation_price_ + quotes.half_spread_)), Side::SELL),
+                                      scale.roundToTick(bbo->bid_price_ + tick, Side::SELL));
+
+      // Worst case position once every level of a side filled has to stay within the position limit.
+      const auto max_position = static_cast<int64_t>(quotes.max_position_);
+      const auto bid_levels = (quotes.clip_ ? std::clamp<int64_t>((max_position - position) / quotes.clip_, 0, cfg.num_levels_) : 0);
+      const auto ask_levels = (quotes.clip_ ? std::clamp<int64_t>((max_position + position) / quotes.clip_, 0, cfg.num_levels_) : 0);
+
+      const auto position_changed = (position != quotes.quoted_position_);
+      const auto step = cfg.level_spacing_ * tick;
+      const auto hysteresis = cfg.hysteresis_ * tick;
+      std::array<bool, 2> requote = {
+          requoteSide(quotes, 0, bid_price, -step, hysteresis, bid_levels, position_changed,
+                      quotes.quoted_[0].top() >= bbo->ask_price_),
+          requoteSide(quotes, 1, ask_price, step, hysteresis, ask_levels, position_changed,
+                      quotes.quoted_[1].top() <= bbo->bid_price_)};
+      quotes.quoted_position_ = position;
+
+      return requote;
+    }
+
+    /// Ladder of the specified side of this ticker, as of the last decision which re-quoted it.
+    auto getLadder(TickerId ticker_id, Side side) const noexcept -> const QuoteLadder & {
+      return ticker_quotes_.at(ticker_id).target_.at(side == Side::SELL);
+    }
+
+    /// Record which layers of the ladder of the specified side were sent, unsent has bit i set for each layer i which
+    /// was not (see OrderManager::moveLayers()). Only the layers sent count as quoted.
+    auto onLadderSent(TickerId ticker_id, Side side, uint64_t unsent) noexcept -> void {
+      auto &quotes = ticker_quotes_.at(ticker_id);
+      const auto index = static_cast<size_t>(side == Side::SELL);
+      const auto &target = quotes.target_[index];
+      auto &quoted = quotes.quoted_[index];
+      for (size_t i = 0; i < MAX_QUOTE_LEVELS; ++i) {
+        if (!((unsent >> i) & 1)) {
+          quoted.prices_[i] = target.prices_[i];
+          quoted.qtys_[i] = target.qtys_[i];
+        }
+      }
+      quoted.num_levels_ = target.num_levels_;
+      quotes.unsent_[index] = (unsent != 0);
+    }
+
+    auto getTickerQuotes(TickerId ticker_id) const noexcept -> const TickerQuotes & {
+      return ticker_quotes_.at(ticker_id);
+    }
+
+    /// Deleted default, copy & move constructors and assignment-operators.
+    QuotingEngine() = delete;
+
+    QuotingEngine(const QuotingEngine &) = delete;
+
+    QuotingEngine(const QuotingEngine &&) = delete;
+
+    QuotingEngine &operator=(const QuotingEngine &) = delete;
+
+    QuotingEngine &operator=(const QuotingEngine &&) = delete;
+
+  private:
+    /// Rebuild the target ladder of one side from its new top level if it moved out of the hysteresis band of the
+    /// quoted one. Levels are step apart and the band is hysteresis wide, both in price units.
+    auto requoteSide(TickerQuotes &quotes, size_t index, Price top_price, Price step, Price hysteresis, int64_t num_levels,
+                     bool position_changed, bool crossed) noexcept -> bool {
+      const auto num = static_cast<size_t>(num_levels);
+      const auto moved = std::abs(top_price - quotes.quoted_[index].top());
+      const auto requote = (num != quotes.quoted_[index].num_levels_ || position_changed || quotes.unsent_[index] ||
+                            (num && moved && (moved >= hysteresis || crossed)));
+      if (!requote)
+        return false;
+
+      auto &ladder = quotes.target_[index];
+      ladder.num_levels_ = num;
+      for (size_t i = 0; i < MAX_QUOTE_LEVELS; ++i) {
+        ladder.prices_[i] = (i < num ? top_price + static_cast<Price>(i) * step : Price_INVALID);
+        ladder.qtys_[i] = (i < num ? quotes.clip_ : 0);
+      }
+      return true;
+    }
+
+    /// Hash map container from TickerId -> quoting state.
+    std::array<TickerQuotes, ME_MAX_TICKERS> ticker_quotes_;
+  };
+}
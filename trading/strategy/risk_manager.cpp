@@ -7,7 +7,7 @@ namespace Trading {
       : logger_(logger) {
     for (TickerId i = 0; i < ME_MAX_TICKERS; ++i) {
       ticker_risk_.at(i).position_info_ = position_keeper->getPositionInfo(i);
-      ticker_risk_.at(i).risk_cfg_ = ticker_cfg[i].risk_cfg_;
+      ticker_risk_.at(i).risk_cfg_.store(ticker_cfg[i].risk_cfg_);
     }
   }
 }
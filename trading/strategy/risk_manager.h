@@ -1,7 +1,11 @@
 #pragma once
 
+#include <bit>
+
 #include "common/macros.h"
 #include "common/logging.h"
+#include "common/seq_lock.h"
+#include "common/time_utils.h"
 
 #include "position_keeper.h"
 #include "om_order.h"
@@ -11,13 +15,21 @@ using namespace Common;
 namespace Trading {
   class OrderManager;
 
+  /// Maximum number of venues the risk manager tracks exposure limits for.
+  constexpr size_t RISK_MAX_VENUES = 4;
+
   /// Enumeration that captures the result of a risk check - ALLOWED means it passed all risk checks, the other values represent the failure reason.
+  /// Failure reasons are in order of precedence when an order fails several checks.
   enum class RiskCheckResult : int8_t {
     INVALID = 0,
     ORDER_TOO_LARGE = 1,
     POSITION_TOO_LARGE = 2,
     LOSS_TOO_LARGE = 3,
-    ALLOWED = 4
+    PRICE_OUTSIDE_BAND = 4,
+    ORDER_RATE_TOO_HIGH = 5,
+    VENUE_EXPOSURE_TOO_LARGE = 6,
+    PORTFOLIO_EXPOSURE_TOO_LARGE = 7,
+    ALLOWED = 8
   };
 
   inline auto riskCheckResultToString(RiskCheckResult result) {
@@ -30,6 +42,14 @@ namespace Trading {
         return "POSITION_TOO_LARGE";
       case RiskCheckResult::LOSS_TOO_LARGE:
         return "LOSS_TOO_LARGE";
+      case RiskCheckResult::PRICE_OUTSIDE_BAND:
+        return "PRICE_OUTSIDE_BAND";
+      case RiskCheckResult::ORDER_RATE_TOO_HIGH:
+        return "ORDER_RATE_TOO_HIGH";
+      case RiskCheckResult::VENUE_EXPOSURE_TOO_LARGE:
+        return "VENUE_EXPOSURE_TOO_LARGE";
+      case RiskCheckResult::PORTFOLIO_EXPOSURE_TOO_LARGE:
+        return "PORTFOLIO_EXPOSURE_TOO_LARGE";
       case RiskCheckResult::ALLOWED:
         return "ALLOWED";
     }
@@ -37,31 +57,89 @@ namespace Trading {
     return "";
   }
 
+  /// Portfolio wide limits. Notionals are in price units * qty units, and a limit of 0 disables that check.
+  struct PortfolioRiskCfg {
+    /// Sum of the worst case notional exposure of all tickers, overall and per venue.
+    int64_t max_gross_notional_ = 0;
+    std::array<int64_t, RISK_MAX_VENUES> max_venue_notional_ = {};
+
+    /// Sustained order rate and burst size across all tickers.
+    uint32_t max_orders_per_sec_ = 0;
+    uint32_t max_order_burst_ = 1;
+
+    auto toString() const {
+      std::stringstream ss;
+      ss << "PortfolioRiskCfg{"
+         << "max-gross-notional:" << max_gross_notional_ << " "
+         << "max-venue-notional:[";
+      for (const auto notional : max_venue_notional_)
+        ss << notional << " ";
+      ss << "] "
+         << "max-rate:" << max_orders_per_sec_ << "/s burst:" << max_order_burst_
+         << "}";
+
+      return ss.str();
+    }
+  };
+
+  /// Token bucket order rate throttle, kept as the time at which the bucket will be full again (GCRA).
+  /// Refilling needs no timer and a check is a handful of integer operations. A rate of 0 disables the throttle.
+  struct OrderThrottle {
+    Nanos full_at_ = 0;
+
+    static auto interval(uint32_t orders_per_sec) noexcept -> Nanos {
+      return orders_per_sec ? NANOS_TO_SECS / orders_per_sec : 0;
+    }
+
+    /// True if one more order at time now would exceed the burst size.
+    auto exceeded(Nanos now, Nanos interval, uint32_t burst) const noexcept {
+      return (std::max(full_at_, now) + interval - now) > static_cast<Nanos>(burst) * interval;
+    }
+
+    auto consume(Nanos now, Nanos interval) noexcept {
+      full_at_ = std::max(full_at_, now) + interval;
+    }
+  };
+
   /// Structure that represents the information needed for risk checks for a single trading instrument.
   struct RiskInfo {
     const PositionInfo *position_info_ = nullptr;
 
-    RiskCfg risk_cfg_;
+    /// Limits, which can be replaced from any thread while trading.
+    SeqLock<RiskCfg> risk_cfg_;
 
-    /// Check risk to see if we are allowed to send an order of the specified quantity on the specified side.
-    /// Will return a RiskCheckResult value to convey the output of the risk check.
-    auto checkPreTradeRisk(Side side, Qty qty) const noexcept {
-      // check order-size
-      if (UNLIKELY(qty > risk_cfg_.max_order_size_))
-        return RiskCheckResult::ORDER_TOO_LARGE;
-      if (UNLIKELY(std::abs(position_info_->position_ + sideToValue(side) * static_cast<int32_t>(qty)) > static_cast<int32_t>(risk_cfg_.max_position_)))
-        return RiskCheckResult::POSITION_TOO_LARGE;
-      if (UNLIKELY(position_info_->total_pnl_ < risk_cfg_.max_loss_))
-        return RiskCheckResult::LOSS_TOO_LARGE;
+    /// Quantity of all working orders on each side, so the worst case position is position_ + buys or position_ - sells.
+    std::array<int64_t, sideToIndex(Side::MAX) + 1> open_qty_ = {};
 
-      return RiskCheckResult::ALLOWED;
+    /// Worst case notional exposure currently accounted for in the venue and portfolio totals, the price it used and the
+    /// venue it is booked to, which is where it is taken back from even if the ticker's venue has changed since.
+    int64_t worst_case_notional_ = 0;
+    Price mark_price_ = 0;
+    size_t booked_venue_id_ = 0;
+
+    OrderThrottle throttle_;
+
+    /// Largest absolute position if every working order on one side filled, with an extra order of the given size.
+    auto worstCasePosition(int64_t extra_buy_qty = 0, int64_t extra_sell_qty = 0) const noexcept {
+      const int64_t position = position_info_->position_;
+      return std::max(position + open_qty_[sideToIndex(Side::BUY)] + extra_buy_qty,
+                      -(position - open_qty_[sideToIndex(Side::SELL)] - extra_sell_qty));
+    }
+
+    /// Price to value exposure at - the BBO mid when there is one, otherwise the fallback (e.g. the order price).
+    auto markPrice(Price fallback) const noexcept {
+      const auto bbo = position_info_->bbo_;
+      const auto has_mid = (bbo && bbo->bid_price_ != Price_INVALID && bbo->ask_price_ != Price_INVALID);
+      return has_mid ? (bbo->bid_price_ + bbo->ask_price_) / 2 : (fallback != Price_INVALID && fallback ? fallback : mark_price_);
     }
 
     auto toString() const {
       std::stringstream ss;
       ss << "RiskInfo" << "["
          << "pos:" << position_info_->toString() << " "
-         << risk_cfg_.toString()
+         << "open:" << open_qty_[sideToIndex(Side::BUY)] << "X" << open_qty_[sideToIndex(Side::SELL)] << " "
+         << "worst-notional:" << worst_case_notional_ << " "
+         << risk_cfg_.load().toString()
          << "]";
 
       return ss.str();
@@ -72,12 +150,105 @@ namespace Trading {
   typedef std::array<RiskInfo, ME_MAX_TICKERS> TickerRiskInfoHashMap;
 
   /// Top level risk manager class to compute and check risk across all trading instruments.
+  /// Keeps the worst case exposure (position plus all working orders) per ticker, per venue and for the portfolio up
+  /// to date incrementally, so a pre-trade check is a fixed set of comparisons. Limits can be replaced from another
+  /// thread at any time through setRiskCfg() / setPortfolioRiskCfg() without pausing the trading thread.
   class RiskManager {
   public:
     RiskManager(Common::Logger *logger, const PositionKeeper *position_keeper, const TradeEngineCfgHashMap &ticker_cfg);
 
-    auto checkPreTradeRisk(TickerId ticker_id, Side side, Qty qty) const noexcept {
-      return ticker_risk_.at(ticker_id).checkPreTradeRisk(side, qty);
+    /// Check risk to see if we are allowed to send an order of the specified price and quantity on the specified side.
+    /// Every check is evaluated without branching on the result of the previous one, the failures are collected in a
+    /// bit mask and the first one in order of precedence is reported. An allowed order consumes order rate tokens.
+    /// Callers which already have the current time can pass it in to save a clock read.
+    auto checkPreTradeRisk(TickerId ticker_id, Side side, Price price, Qty qty, Nanos now = Common::getCurrentNanos()) noexcept {
+      auto &risk_info = ticker_risk_.at(ticker_id);
+      const auto risk_cfg = risk_info.risk_cfg_.load();
+      const auto portfolio_cfg = portfolio_cfg_.load();
+
+      const auto is_buy = static_cast<int64_t>(side == Side::BUY);
+      const auto worst_case_position = risk_info.worstCasePosition(is_buy * qty, (1 - is_buy) * qty);
+
+      // Exposure after this order, the ticker's previous contribution is swapped out of the venue / portfolio totals.
+      const auto venue_id = risk_cfg.venue_id_ % RISK_MAX_VENUES;
+      const auto notional = worst_case_position * risk_info.markPrice(price);
+      const auto venue_notional = venue_notional_[venue_id] - (risk_info.booked_venue_id_ == venue_id) * risk_info.worst_case_notional_ + notional;
+      const auto gross_notional = gross_notional_ - risk_info.worst_case_notional_ + notional;
+      const auto max_venue_notional = portfolio_cfg.max_venue_notional_[venue_id];
+
+      // Fat finger bands around the BBO mid, compared at twice the price to avoid rounding the mid.
+      const auto bbo = risk_info.position_info_->bbo_;
+      const auto has_mid = (bbo && bbo->bid_price_ != Price_INVALID && bbo->ask_price_ != Price_INVALID);
+      const auto mid2 = has_mid ? bbo->bid_price_ + bbo->ask_price_ : 0;
+      const auto outside_band = risk_cfg.price_band_bps_ && has_mid &&
+                                std::abs(2 * price - mid2) * 10'000 > static_cast<int64_t>(risk_cfg.price_band_bps_) * mid2;
+      const auto outside_limits = (price < risk_cfg.min_price_) | (price > risk_cfg.max_price_);
+
+      const auto ticker_interval = OrderThrottle::interval(risk_cfg.max_orders_per_sec_);
+      const auto portfolio_interval = OrderThrottle::interval(portfolio_cfg.max_orders_per_sec_);
+
+      const uint32_t failures =
+          (static_cast<uint32_t>(qty > risk_cfg.max_order_size_) << 0) |
+          (static_cast<uint32_t>(worst_case_position > static_cast<int64_t>(risk_cfg.max_position_)) << 1) |
+          (static_cast<uint32_t>(risk_info.position_info_->total_pnl_ < risk_cfg.max_loss_) << 2) |
+          (static_cast<uint32_t>(outside_band | outside_limits) << 3) |
+          (static_cast<uint32_t>(risk_info.throttle_.exceeded(now, ticker_interval, risk_cfg.max_order_burst_) |
+                                 throttle_.exceeded(now, portfolio_interval, portfolio_cfg.max_order_burst_)) << 4) |
+          (static_cast<uint32_t>(max_venue_notional && venue_notional > max_venue_notional) << 5) |
+          (static_cast<uint32_t>(portfolio_cfg.max_gross_notional_ && gross_notional > portfolio_cfg.max_gross_notional_) << 6);
+
+      if (UNLIKELY(failures))
+        return static_cast<RiskCheckResult>(std::countr_zero(failures) + 1);
+
+      risk_info.throttle_.consume(now, ticker_interval);
+      throttle_.consume(now, portfolio_interval);
+      return RiskCheckResult::ALLOWED;
+    }
+
+    /// Account for a new working order, call after an order passed checkPreTradeRisk() and was sent.
+    auto onOrderSent(TickerId ticker_id, Side side, Price price, Qty qty) noexcept -> void {
+      auto &risk_info = ticker_risk_.at(ticker_id);
+      risk_info.open_qty_[sideToIndex(side)] += qty;
+      updateExposure(risk_info, price);
+    }
+
+    /// Account for working quantity which is no longer open - filled, cancelled or rejected.
+    /// Fills need to be applied to the PositionKeeper first so the position already includes them.
+    auto onOrderReleased(TickerId ticker_id, Side side, Qty qty) noexcept -> void {
+      auto &risk_info = ticker_risk_.at(ticker_id);
+      auto &open_qty = risk_info.open_qty_[sideToIndex(side)];
+      open_qty -= std::min<int64_t>(qty, open_qty);
+      updateExposure(risk_info, Price_INVALID);
+    }
+
+    /// Replace the limits of one ticker, safe to call from any thread while trading.
+    auto setRiskCfg(TickerId ticker_id, const RiskCfg &risk_cfg) noexcept -> void {
+      ticker_risk_.at(ticker_id).risk_cfg_.store(risk_cfg);
+    }
+
+    /// Replace the portfolio wide limits, safe to call from any thread while trading.
+    auto setPortfolioRiskCfg(const PortfolioRiskCfg &portfolio_cfg) noexcept -> void {
+      portfolio_cfg_.store(portfolio_cfg);
+    }
+
+    auto getRiskCfg(TickerId ticker_id) const noexcept {
+      return ticker_risk_.at(ticker_id).risk_cfg_.load();
+    }
+
+    auto getPortfolioRiskCfg() const noexcept {
+      return portfolio_cfg_.load();
+    }
+
+    auto getRiskInfo(TickerId ticker_id) const noexcept {
+      return &(ticker_risk_.at(ticker_id));
+    }
+
+    auto grossNotional() const noexcept {
+      return gross_notional_;
+    }
+
+    auto venueNotional(size_t venue_id) const noexcept {
+      return venue_notional_.at(venue_id);
     }
 
     /// Deleted default, copy & move constructors and assignment-operators.
@@ -92,10 +263,31 @@ namespace Trading {
     RiskManager &operator=(const RiskManager &&) = delete;
 
   private:
+    /// Re-value the ticker's worst case exposure and move the difference into the venue and portfolio totals.
+    auto updateExposure(RiskInfo &risk_info, Price price) noexcept -> void {
+      risk_info.mark_price_ = risk_info.markPrice(price);
+      const auto notional = risk_info.worstCasePosition() * risk_info.mark_price_;
+      const auto venue_id = risk_info.risk_cfg_.load().venue_id_ % RISK_MAX_VENUES;
+      venue_notional_[risk_info.booked_venue_id_] -= risk_info.worst_case_notional_;
+      venue_notional_[venue_id] += notional;
+      gross_notional_ += notional - risk_info.worst_case_notional_;
+      risk_info.worst_case_notional_ = notional;
+      risk_info.booked_venue_id_ = venue_id;
+    }
+
     std::string time_str_;
     Common::Logger *logger_ = nullptr;
 
     /// Hash map container from TickerId -> RiskInfo.
     TickerRiskInfoHashMap ticker_risk_;
+
+    SeqLock<PortfolioRiskCfg> portfolio_cfg_;
+
+    /// Worst case notional exposure totals per venue and for the portfolio.
+    std::array<int64_t, RISK_MAX_VENUES> venue_notional_ = {};
+    int64_t gross_notional_ = 0;
+
+    /// Portfolio wide order rate throttle.
+    OrderThrottle throttle_;
   };
 }
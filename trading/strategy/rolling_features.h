@@ -0,0 +1,457 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+#include "common/macros.h"
+#include "common/types.h"
+#include "common/time_utils.h"
+
+namespace Trading {
+  /// Sentinel value to represent invalid / uninitialized feature value.
+  constexpr auto Feature_INVALID = std::numeric_limits<double>::quiet_NaN();
+
+  /// Parameters for the per-ticker rolling features. Half lives are expressed in number of updates.
+  struct FeatureCfg {
+    Common::Nanos vwap_time_window_ = 60 * Common::NANOS_TO_SECS;
+    Common::Qty vwap_volume_window_ = 10'000;
+
+    double mid_half_life_ = 50;
+    double volatility_half_life_ = 200;
+    double ofi_half_life_ = 20;
+    double trade_sign_half_life_ = 100;
+    double spread_half_life_ = 100;
+  };
+
+  /// Exponentially weighted moving average, seeded with the first observation.
+  class Ewma {
+  public:
+    Ewma() = default;
+
+    explicit Ewma(double half_life) noexcept {
+      setHalfLife(half_life);
+    }
+
+    auto setHalfLife(double half_life) noexcept -> void {
+      alpha_ = 1.0 - std::exp(-std::numbers::ln2 / std::max(half_life, 1.0));
+    }
+
+    auto update(double x) noexcept -> void {
+      value_ = (std::isnan(value_) ? x : value_ + alpha_ * (x - value_));
+    }
+
+    auto value() const noexcept {
+      return value_;
+    }
+
+  private:
+    double alpha_ = 1.0;
+    double value_ = Feature_INVALID;
+  };
+
+  /// Trade VWAP over a trailing time window. Trades live in a fixed ring of N entries - if the ring fills up before
+  /// the window elapses the oldest trades are dropped early. Sums are kept in integer price * qty units so they never drift.
+  template<size_t N>
+  class TimeWindowVwap {
+  public:
+    auto setWindow(Common::Nanos window) noexcept -> void {
+      window_ = window;
+    }
+
+    auto onTrade(Common::Nanos time, Common::Price price, Common::Qty qty) noexcept -> void {
+      expire(time);
+      if (UNLIKELY(size_ == N))
+        pop();
+
+      ring_[(head_ + size_) % N] = {time, price, qty};
+      ++size_;
+      pq_sum_ += price * static_cast<int64_t>(qty);
+      q_sum_ += qty;
+    }
+
+    /// Drop trades which have fallen out of the window as of time.
+    auto expire(Common::Nanos time) noexcept -> void {
+      while (size_ && ring_[head_].time_ <= time - window_)
+        pop();
+    }
+
+    auto value() const noexcept {
+      return (q_sum_ ? static_cast<double>(pq_sum_) / static_cast<double>(q_sum_) : Feature_INVALID);
+    }
+
+    auto volume() const noexcept {
+      return q_sum_;
+    }
+
+  private:
+    struct Entry {
+      Common::Nanos time_ = 0;
+      Common::Price price_ = 0;
+      Common::Qty qty_ = 0;
+    };
+
+    auto pop() noexcept -> void {
+      const auto &entry = ring_[head_];
+      pq_sum_ -= entry.price_ * static_cast<int64_t>(entry.qty_);
+      q_sum_ -= entry.qty_;
+      head_ = (head_ + 1) % N;
+      --size_;
+    }
+
+    std::array<Entry, N> ring_;
+    size_t head_ = 0, size_ = 0;
+    int64_t pq_sum_ = 0;
+    uint64_t q_sum_ = 0;
+    Common::Nanos window_ = 0;
+  };
+
+  /// Trade VWAP over the most recent window_qty of traded volume, partially consuming the oldest trade when needed.
+  template<size_t N>
+  class VolumeWindowVwap {
+  public:
+    auto setWindow(Common::Qty window_qty) noexcept -> void {
+      window_qty_ = std::max<Common::Qty>(window_qty, 1);
+    }
+
+    auto onTrade(Common::Price price, Common::Qty qty) noexcept -> void {
+      if (UNLIKELY(size_ == N))
+        pop();
+
+      ring_[(head_ + size_) % N] = {price, qty};
+      ++size_;
+      pq_sum_ += price * static_cast<int64_t>(qty);
+      q_sum_ += qty;
+
+      while (q_sum_ > window_qty_) {
+        auto &oldest = ring_[head_];
+        const auto excess = q_sum_ - window_qty_;
+        if (excess >= oldest.qty_) {
+          pop();
+        } else {
+          oldest.qty_ -= static_cast<Common::Qty>(excess);
+          pq_sum_ -= oldest.price_ * static_cast<int64_t>(excess);
+          q_sum_ -= excess;
+        }
+      }
+    }
+
+    auto value() const noexcept {
+      return (q_sum_ ? static_cast<double>(pq_sum_) / static_cast<double>(q_sum_) : Feature_INVALID);
+    }
+
+  private:
+    struct Entry {
+      Common::Price price_ = 0;
+      Common::Qty qty_ = 0;
+    };
+
+    auto pop() noexcept -> void {
+      const auto &entry = ring_[head_];
+      pq_sum_ -= entry.price_ * static_cast<int64_t>(entry.qty_);
+      q_sum_ -= entry.qty_;
+      head_ = (head_ + 1) % N;
+      --size_;
+    }
+
+    std::array<Entry, N> ring_;
+    size_t head_ = 0, size_ = 0;
+    int64_t pq_sum_ = 0;
+    uint64_t q_sum_ = 0;
+    uint64_t window_qty_ = 1;
+  };
+
+  /// Streaming quantile estimate using the P-square algorithm (Jain & Chlamtac) - five markers, O(1) per observation.
+  class P2Quantile {
+  public:
+    explicit P2Quantile(double p = 0.5) noexcept : p_(p) {
+      increments_ = {0.0, p_ / 2, p_, (1 + p_) / 2, 1.0};
+    }
+
+    auto add(double x) noexcept -> void {
+      if (UNLIKELY(count_ < 5)) {
+        heights_[count_++] = x;
+        if (count_ == 5) {
+          std::sort(heights_.begin(), heights_.end());
+          positions_ = {1, 2, 3, 4, 5};
+          desired_ = {1, 1 + 2 * p_, 1 + 4 * p_, 3 + 2 * p_, 5};
+        }
+        return;
+      }
+
+      size_t k;
+      if (x < heights_[0]) {
+        heights_[0] = x;
+        k = 0;
+      } else if (x >= heights_[4]) {
+        heights_[4] = x;
+        k = 3;
+      } else {
+        for (k = 0; k < 3 && x >= heights_[k + 1]; ++k);
+      }
+
+      for (auto i = k + 1; i < 5; ++i)
+        ++positions_[i];
+      for (size_t i = 0; i < 5; ++i)
+        desired_[i] += increments_[i];
+
+      for (size_t i = 1; i < 4; ++i) {
+        const auto d = desired_[i] - positions_[i];
+        if ((d >= 1 && positions_[i + 1] - positions_[i] > 1) || (d <= -1 && positions_[i - 1] - positions_[i] < -1)) {
+          const double ds = (d >= 0 ? 1 : -1);
+          const auto candidate = parabolic(i, ds);
+          heights_[i] = (heights_[i - 1] < candidate && candidate < heights_[i + 1] ? candidate : linear(i, ds));
+          positions_[i] += ds;
+        }
+      }
+      ++count_;
+    }
+
+    auto value() const noexcept -> double {
+      if (UNLIKELY(count_ < 5)) {
+        if (!count_)
+          return Feature_INVALID;
+        auto sorted = heights_;
+        std::sort(sorted.begin(), sorted.begin() + count_);
+        return sorted[static_cast<size_t>(std::lround(p_ * (count_ - 1)))];
+      }
+      return heights_[2];
+    }
+
+    auto quantile() const noexcept {
+      return p_;
+    }
+
+  private:
+    auto parabolic(size_t i, double d) const noexcept -> double {
+      const auto &q = heights_;
+      const auto &n = positions_;
+      return q[i] + d / (n[i + 1] - n[i - 1]) *
+                    ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+                     (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+    }
+
+    auto linear(size_t i, double d) const noexcept -> double {
+      const auto j = static_cast<size_t>(static_cast<double>(i) + d);
+      return heights_[i] + d * (heights_[j] - heights_[i]) / (positions_[j] - positions_[i]);
+    }
+
+    double p_;
+    size_t count_ = 0;
+    std::array<double, 5> heights_ = {};
+    std::array<double, 5> positions_ = {};
+    std::array<double, 5> desired_ = {};
+    std::array<double, 5> increments_ = {};
+  };
+
+  /// A fixed set of P-square sketches over trade sizes, used to map a quantity to its approximate percentile.
+  class VolumeQuantiles {
+  public:
+    static constexpr std::array<double, 6> QUANTILES = {0.10, 0.25, 0.50, 0.75, 0.90, 0.99};
+
+    VolumeQuantiles() noexcept {
+      for (size_t i = 0; i < QUANTILES.size(); ++i)
+        sketches_[i] = P2Quantile(QUANTILES[i]);
+    }
+
+    auto add(Common::Qty qty) noexcept -> void {
+      for (auto &sketch: sketches_)
+        sketch.add(qty);
+    }
+
+    /// Estimated trade size at quantile QUANTILES[index].
+    auto quantile(size_t index) const noexcept {
+      return sketches_[index].value();
+    }
+
+    /// Approximate percentile [0, 100] of qty against the observed trade size distribution.
+    auto percentileOf(double qty) const noexcept -> double {
+      if (std::isnan(sketches_[0].value()))
+        return Feature_INVALID;
+
+      double prev_q = 0, prev_p = 0;
+      for (size_t i = 0; i < QUANTILES.size(); ++i) {
+        const auto q = sketches_[i].value();
+        if (qty <= q)
+          return 100.0 * (q > prev_q ? prev_p + (QUANTILES[i] - prev_p) * (qty - prev_q) / (q - prev_q) : QUANTILES[i]);
+        prev_q = q;
+        prev_p = QUANTILES[i];
+      }
+      return 100.0;
+    }
+
+  private:
+    std::array<P2Quantile, QUANTILES.size()> sketches_;
+  };
+
+  /// All the rolling features for a single ticker, updated incrementally from top of book and trade events.
+  /// Every update is O(1) (amortised for the windowed VWAPs) and the memory footprint is fixed at construction.
+  class TickerFeatures {
+  public:
+    static constexpr size_t MAX_WINDOW_TRADES = 4096;
+    static constexpr size_t OFI_WINDOW = 256;
+
+    TickerFeatures() noexcept {
+      configure(FeatureCfg());
+    }
+
+    auto configure(const FeatureCfg &cfg) noexcept -> void {
+      time_vwap_.setWindow(cfg.vwap_time_window_);
+      volume_vwap_.setWindow(cfg.vwap_volume_window_);
+      mid_.setHalfLife(cfg.mid_half_life_);
+      return_variance_.setHalfLife(cfg.volatility_half_life_);
+      ofi_ewma_.setHalfLife(cfg.ofi_half_life_);
+      sign_mean_.setHalfLife(cfg.trade_sign_half_life_);
+      sign_lag_product_.setHalfLife(cfg.trade_sign_half_life_);
+      spread_mean_.setHalfLife(cfg.spread_half_life_);
+      spread_square_mean_.setHalfLife(cfg.spread_half_life_);
+    }
+
+    /// Top of book changed - both sides need to be valid.
+    auto onQuote(Common::Nanos time, Common::Price bid_price, Common::Qty bid_qty, Common::Price ask_price, Common::Qty ask_qty) noexcept -> void {
+      mkt_price_ = (bid_price * ask_qty + ask_price * bid_qty) / static_cast<double>(bid_qty + ask_qty);
+
+      const auto mid = (bid_price + ask_price) / 2.0;
+      mid_.update(mid);
+      if (!std::isnan(last_mid_) && mid != last_mid_) {
+        const auto ret = std::log(mid / last_mid_);
+        return_variance_.update(ret * ret);
+      }
+      last_mid_ = mid;
+
+      const auto spread = static_cast<double>(ask_price - bid_price);
+      spread_ = spread;
+      spread_mean_.update(spread);
+      spread_square_mean_.update(spread * spread);
+
+      if (LIKELY(last_bid_price_ != Common::Price_INVALID)) {
+        // Order flow imbalance contribution of this top of book change (Cont, Kukanov & Stoikov).
+        int64_t e = 0;
+        e += (bid_price >= last_bid_price_ ? static_cast<int64_t>(bid_qty) : 0);
+        e -= (bid_price <= last_bid_price_ ? static_cast<int64_t>(last_bid_qty_) : 0);
+        e -= (ask_price <= last_ask_price_ ? static_cast<int64_t>(ask_qty) : 0);
+        e += (ask_price >= last_ask_price_ ? static_cast<int64_t>(last_ask_qty_) : 0);
+
+        ofi_sum_ += e - ofi_ring_[ofi_head_];
+        ofi_ring_[ofi_head_] = e;
+        ofi_head_ = (ofi_head_ + 1) % OFI_WINDOW;
+        ofi_ewma_.update(static_cast<double>(e));
+      }
+      last_bid_price_ = bid_price;
+      last_bid_qty_ = bid_qty;
+      last_ask_price_ = ask_price;
+      last_ask_qty_ = ask_qty;
+
+      time_vwap_.expire(time);
+    }
+
+    /// Trade printed - side is the aggressor side.
+    auto onTrade(Common::Nanos time, Common::Side side, Common::Price price, Common::Qty qty) noexcept -> void {
+      if (last_bid_price_ != Common::Price_INVALID) {
+        const auto bbo_qty = (side == Common::Side::BUY ? last_ask_qty_ : last_bid_qty_);
+        agg_trade_qty_ratio_ = (bbo_qty ? static_cast<double>(qty) / bbo_qty : Feature_INVALID);
+      }
+
+      time_vwap_.onTrade(time, price, qty);
+      volume_vwap_.onTrade(price, qty);
+      volume_quantiles_.add(qty);
+
+      const auto sign = static_cast<double>(Common::sideToValue(side));
+      if (last_sign_ != 0)
+        sign_lag_product_.update(sign * last_sign_);
+      sign_mean_.update(sign);
+      last_sign_ = sign;
+    }
+
+    /// Size weighted mid price - the original fair market price feature.
+    auto mktPrice() const noexcept {
+      return mkt_price_;
+    }
+
+    /// Aggressive trade quantity relative to the BBO quantity it traded against, invalid if that side showed none.
+    auto aggTradeQtyRatio() const noexcept {
+      return agg_trade_qty_ratio_;
+    }
+
+    auto timeVwap() const noexcept {
+      return time_vwap_.value();
+    }
+
+    auto volumeVwap() const noexcept {
+      return volume_vwap_.value();
+    }
+
+    auto ewmaMid() const noexcept {
+      return mid_.value();
+    }
+
+    /// EWMA of squared log returns of the mid price, per mid change.
+    auto volatility() const noexcept {
+      return std::sqrt(return_variance_.value());
+    }
+
+    /// Order flow imbalance summed over the last OFI_WINDOW top of book changes.
+    auto ofi() const noexcept {
+      return ofi_sum_;
+    }
+
+    auto ewmaOfi() const noexcept {
+      return ofi_ewma_.value();
+    }
+
+    /// Lag-1 autocorrelation of aggressor trade signs.
+    auto tradeSignAutocorrelation() const noexcept -> double {
+      const auto m = sign_mean_.value();
+      const auto denominator = 1.0 - m * m;
+      return (denominator > 1e-9 ? (sign_lag_product_.value() - m * m) / denominator : Feature_INVALID);
+    }
+
+    auto spread() const noexcept {
+      return spread_;
+    }
+
+    auto spreadMean() const noexcept {
+      return spread_mean_.value();
+    }
+
+    auto spreadStdDev() const noexcept {
+      const auto mean = spread_mean_.value();
+      return std::sqrt(std::max(spread_square_mean_.value() - mean * mean, 0.0));
+    }
+
+    /// Approximate percentile [0, 100] of qty in the trade size distribution seen so far.
+    auto volumePercentile(double qty) const noexcept {
+      return volume_quantiles_.percentileOf(qty);
+    }
+
+    auto volumeQuantiles() const noexcept -> const VolumeQuantiles & {
+      return volume_quantiles_;
+    }
+
+  private:
+    double mkt_price_ = Feature_INVALID, agg_trade_qty_ratio_ = Feature_INVALID;
+
+    TimeWindowVwap<MAX_WINDOW_TRADES> time_vwap_;
+    VolumeWindowVwap<MAX_WINDOW_TRADES> volume_vwap_;
+
+    Ewma mid_, return_variance_;
+    double last_mid_ = Feature_INVALID;
+
+    double spread_ = Feature_INVALID;
+    Ewma spread_mean_, spread_square_mean_;
+
+    Common::Price last_bid_price_ = Common::Price_INVALID, last_ask_price_ = Common::Price_INVALID;
+    Common::Qty last_bid_qty_ = 0, last_ask_qty_ = 0;
+    std::array<int64_t, OFI_WINDOW> ofi_ring_ = {};
+    size_t ofi_head_ = 0;
+    int64_t ofi_sum_ = 0;
+    Ewma ofi_ewma_;
+
+    Ewma sign_mean_, sign_lag_product_;
+    double last_sign_ = 0;
+
+    VolumeQuantiles volume_quantiles_;
+  };
+}
@@ -28,7 +28,7 @@ namespace Trading {
     // Create the trading algorithm instance based on the AlgoType provided.
     // The constructor will override the callbacks above for order book changes, trade events and client responses.
     if (algo_type == AlgoType::MAKER) {
-      mm_algo_ = new MarketMaker(&logger_, this, &feature_engine_, &order_manager_, ticker_cfg);
+      mm_algo_ = new MarketMaker(&logger_, this, &feature_engine_, &position_keeper_, &order_manager_, ticker_cfg);
     } else if (algo_type == AlgoType::TAKER) {
       taker_algo_ = new LiquidityTaker(&logger_, this, &feature_engine_, &order_manager_, ticker_cfg);
     }
@@ -58,6 +58,7 @@ namespace Trading {
     outgoing_ogw_requests_ = nullptr;
     incoming_ogw_responses_ = nullptr;
     incoming_md_updates_ = nullptr;
+    md_conflator_ = nullptr;
   }
 
   /// Write a client request to the lock free queue for the order server to consume and send to the exchange.
@@ -72,25 +73,41 @@ namespace Trading {
   /// Main loop for this thread - processes incoming client responses and market data updates which in turn may generate client requests.
   auto TradeEngine::run() noexcept -> void {
     logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_));
-    while (run_) {
-      for (auto client_response = incoming_ogw_responses_->getNextToRead(); client_response; client_response = incoming_ogw_responses_->getNextToRead()) {
-        logger_.log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
-                    client_response->toString().c_str());
-        onOrderUpdate(client_response);
-        incoming_ogw_responses_->updateReadIndex();
-        last_event_time_ = Common::getCurrentNanos();
-      }
+    while (run_)
+      poll();
+  }
+
+  /// One pass of the main loop - drains the client responses, market data updates and conflator and recomputes the batched features.
+  auto TradeEngine::poll() noexcept -> void {
+    for (auto client_response = incoming_ogw_responses_->getNextToRead(); client_response; client_response = incoming_ogw_responses_->getNextToRead()) {
+      logger_.log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  client_response->toString().c_str());
+      onOrderUpdate(client_response);
+      incoming_ogw_responses_->updateReadIndex();
+      last_event_time_ = Common::getCurrentNanos();
+    }
 
-      for (auto market_update = incoming_md_updates_->getNextToRead(); market_update; market_update = incoming_md_updates_->getNextToRead()) {
-        logger_.log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+    for (auto market_update = incoming_md_updates_->getNextToRead(); market_update; market_update = incoming_md_updates_->getNextToRead()) {
+      logger_.log("%:% %() % Processing %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
+                  market_update->toString().c_str());
+      ASSERT(market_update->ticker_id_ < ticker_order_book_.size(),
+             "Unknown ticker-id on update:" + market_update->toString());
+      ticker_order_book_[market_update->ticker_id_]->onMarketUpdate(market_update);
+      incoming_md_updates_->updateReadIndex();
+      last_event_time_ = Common::getCurrentNanos();
+    }
+
+    if (md_conflator_) {
+      const auto published = md_conflator_->drain([this](const Exchange::MEMarketUpdate *market_update) {
+        logger_.log("%:% %() % Processing conflated %\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str_),
                     market_update->toString().c_str());
-        ASSERT(market_update->ticker_id_ < ticker_order_book_.size(),
-               "Unknown ticker-id on update:" + market_update->toString());
         ticker_order_book_[market_update->ticker_id_]->onMarketUpdate(market_update);
-        incoming_md_updates_->updateReadIndex();
+      });
+      if (published)
         last_event_time_ = Common::getCurrentNanos();
-      }
     }
+
+    feature_engine_.computeBatchFeatures();
   }
 
   /// Process changes to the order book - updates the position keeper, feature engine and informs the trading algorithm about the update.
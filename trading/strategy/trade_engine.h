@@ -12,6 +12,8 @@
 #include "exchange/order_server/client_response.h"
 #include "exchange/market_data/market_update.h"
 
+#include "trading/market_data/market_update_conflator.h"
+
 #include "market_order_book.h"
 
 #include "feature_engine.h"
@@ -41,7 +43,7 @@ namespace Trading {
     }
 
     auto stop() -> void {
-      while(incoming_ogw_responses_->size() || incoming_md_updates_->size()) {
+      while(incoming_ogw_responses_->size() || incoming_md_updates_->size() || (md_conflator_ && md_conflator_->hasPending())) {
         logger_.log("%:% %() % Sleeping till all updates are consumed ogw-size:% md-size:%\n", __FILE__, __LINE__, __FUNCTION__,
                     Common::getCurrentTimeStr(&time_str_), incoming_ogw_responses_->size(), incoming_md_updates_->size());
 
@@ -55,9 +57,24 @@ namespace Trading {
       run_ = false;
     }
 
+    /// Optionally consume market data from a conflation stage in addition to the market data queue.
+    /// Must be set before start() - the market data adapter then publishes into the conflator instead of the queue.
+    auto setMarketUpdateConflator(MarketUpdateConflator *md_conflator) noexcept -> void {
+      md_conflator_ = md_conflator;
+    }
+
+    /// Price and quantity scale of the instrument, which the trading algorithms round their prices to.
+    /// Must be set before start(), defaults to InstrumentScale{}.
+    auto setInstrumentScale(TickerId ticker_id, const InstrumentScale &scale) noexcept -> void {
+      position_keeper_.setInstrumentScale(ticker_id, scale);
+    }
+
     /// Main loop for this thread - processes incoming client responses and market data updates which in turn may generate client requests.
     auto run() noexcept -> void;
 
+    /// One pass of the main loop, for callers which drive the trade engine from their own thread (e.g. the backtester).
+    auto poll() noexcept -> void;
+
     /// Write a client request to the lock free queue for the order server to consume and send to the exchange.
     auto sendClientRequest(const Exchange::MEClientRequest *client_request) noexcept -> void;
 
@@ -113,6 +130,9 @@ namespace Trading {
     Exchange::ClientResponseLFQueue *incoming_ogw_responses_ = nullptr;
     Exchange::MEMarketUpdateLFQueue *incoming_md_updates_ = nullptr;
 
+    /// Optional conflation stage, drained after the market data queue on every pass of the main loop.
+    MarketUpdateConflator *md_conflator_ = nullptr;
+
     Nanos last_event_time_ = 0;
     volatile bool run_ = false;
 
@@ -103,7 +103,7 @@ int main(int argc, char **argv) {
         ticker_cfg.at(next_ticker_id) = {static_cast<Common::Qty>(std::atoi(argv[i])), std::atof(argv[i + 1]),
                                       {static_cast<Common::Qty>(std::atoi(argv[i + 2])),
                                        static_cast<Common::Qty>(std::atoi(argv[i + 3])),
-                                       std::atof(argv[i + 4])}};
+                                       std::atof(argv[i + 4])}, {}};
     }
 
     logger->log("%:% %() % Starting Trade Engine...\n", __FILE__, __LINE__, __FUNCTION__, Common::getCurrentTimeStr(&time_str));